@@ -0,0 +1,63 @@
+#version 450
+
+layout(std140) uniform per_frame_uniforms {
+    mat4 gbufferModelView;
+    mat4 gbufferModelViewInverse;
+    mat4 gbufferPreviousModelView;
+    mat4 gbufferProjection;
+    mat4 gbufferProjectionInverse;
+    mat4 gbufferPreviousProjection;
+    mat4 shadowProjection;
+    mat4 shadowProjectionInverse;
+    mat4 shadowModelView;
+    mat4 shadowModelViewInverse;
+    vec4 entityColor;
+    vec3 fogColor;
+    float frameTimeCounter;
+    vec3 skyColor;
+    float sunAngle;
+    vec3 sunPosition;
+    float shadowAngle;
+    vec3 moonPosition;
+    float rainStrength;
+    vec3 shadowLightPosition;
+    float aspectRatio;
+    vec3 upPosition;
+    float viewWidth;
+    vec3 cameraPosition;
+    float viewHeight;
+    vec3 previousCameraPosition;
+    float near;
+    ivec2 eyeBrightness;
+    ivec2 eyeBrightnessSmooth;
+    ivec2 terrainTextureSize;
+    ivec2 atlasSize;
+    int heldItemId;
+    int heldBlockLightValue;
+    int heldItemId2;
+    int heldBlockLightValue2;
+    int fogMode;
+    int worldTime;
+    int moonPhase;
+    int terrainIconSize;
+    int isEyeInWater;
+    int hideGUI;
+    int entityId;
+    int blockEntityId;
+    float far;
+    float wetness;
+    float eyeAltitude;
+    float centerDepthSmooth;
+};
+
+in vec2 cell_uv;
+in float cloud_alpha;
+
+layout(location = 0) out vec4 color_out;
+
+void main() {
+    // Daylight on top of the clouds, and storm clouds are darker
+    float daylight = clamp(normalize(sunPosition).y * 0.5 + 0.5, 0.15, 1.0);
+    vec3 color = vec3(daylight) * mix(1.0, 0.5, rainStrength);
+    color_out = vec4(color, cloud_alpha);
+}
\ No newline at end of file
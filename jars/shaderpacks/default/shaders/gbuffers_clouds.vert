@@ -0,0 +1,112 @@
+#version 450
+
+invariant gl_Position;
+
+layout(std140) uniform per_frame_uniforms {
+    mat4 gbufferModelView;
+    mat4 gbufferModelViewInverse;
+    mat4 gbufferPreviousModelView;
+    mat4 gbufferProjection;
+    mat4 gbufferProjectionInverse;
+    mat4 gbufferPreviousProjection;
+    mat4 shadowProjection;
+    mat4 shadowProjectionInverse;
+    mat4 shadowModelView;
+    mat4 shadowModelViewInverse;
+    vec4 entityColor;
+    vec3 fogColor;
+    float frameTimeCounter;
+    vec3 skyColor;
+    float sunAngle;
+    vec3 sunPosition;
+    float shadowAngle;
+    vec3 moonPosition;
+    float rainStrength;
+    vec3 shadowLightPosition;
+    float aspectRatio;
+    vec3 upPosition;
+    float viewWidth;
+    vec3 cameraPosition;
+    float viewHeight;
+    vec3 previousCameraPosition;
+    float near;
+    ivec2 eyeBrightness;
+    ivec2 eyeBrightnessSmooth;
+    ivec2 terrainTextureSize;
+    ivec2 atlasSize;
+    int heldItemId;
+    int heldBlockLightValue;
+    int heldItemId2;
+    int heldBlockLightValue2;
+    int fogMode;
+    int worldTime;
+    int moonPhase;
+    int terrainIconSize;
+    int isEyeInWater;
+    int hideGUI;
+    int entityId;
+    int blockEntityId;
+    float far;
+    float wetness;
+    float eyeAltitude;
+    float centerDepthSmooth;
+};
+
+layout(std140) uniform sky_parameters {
+    vec2 cloudOffset;
+    float cloudHeight;
+    float cloudCellSize;
+    float skyTime;
+    float weatherStrength;
+    float snowStrength;
+    float weatherRadius;
+    float cloudCoverage;
+    int cloudGridSize;
+    int cloudPatternCells;
+    int weatherParticleCount;
+};
+
+out vec2 cell_uv;
+out float cloud_alpha;
+
+uint hash(uvec2 cell) {
+    uint h = cell.x * 0x8da6b343u ^ cell.y * 0xd8163841u;
+    h ^= h >> 15;
+    h *= 0x2c1b3c6du;
+    h ^= h >> 12;
+    return h;
+}
+
+void main() {
+    // Six vertices for each cell of a square grid around the camera. The grid follows the camera one cell at a time,
+    // and the pattern under it moves with cloudOffset
+    const vec2 corners[6] = vec2[](vec2(0, 0), vec2(1, 0), vec2(1, 1), vec2(1, 1), vec2(0, 1), vec2(0, 0));
+    int cell_index = gl_VertexID / 6;
+    ivec2 grid_position = ivec2(cell_index % cloudGridSize, cell_index / cloudGridSize) - cloudGridSize / 2;
+
+    ivec2 camera_cell = ivec2(floor((cameraPosition.xz + cloudOffset) / cloudCellSize));
+    ivec2 pattern_cell = camera_cell + grid_position;
+    // cloudPatternCells is a power of two, so masking wraps negative cells too
+    uvec2 wrapped_cell = uvec2(pattern_cell & (cloudPatternCells - 1));
+
+    // Neighboring cells clump together, so the clouds come in patches instead of noise
+    float coverage = float(hash(wrapped_cell / 4u) & 0xFFFFu) / 65535.0 * 0.6
+                   + float(hash(wrapped_cell) & 0xFFFFu) / 65535.0 * 0.4;
+    if(coverage > cloudCoverage) {
+        // No cloud here, so the whole cell collapses to a point outside the screen
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        cell_uv = vec2(0);
+        cloud_alpha = 0;
+        return;
+    }
+
+    vec2 corner = corners[gl_VertexID % 6];
+    vec2 world_xz = (vec2(pattern_cell) + corner) * cloudCellSize - cloudOffset;
+    vec3 world_position = vec3(world_xz.x, cloudHeight, world_xz.y);
+    gl_Position = gbufferProjection * gbufferModelView * vec4(world_position, 1.0);
+
+    // Clouds thin out towards the edge of the grid so it doesn't end in a hard line
+    float edge = length(vec2(grid_position) + corner - 0.5) / (cloudGridSize * 0.5);
+    cell_uv = corner;
+    cloud_alpha = 0.8 * clamp((1.0 - edge) * 4.0, 0.0, 1.0);
+}
\ No newline at end of file
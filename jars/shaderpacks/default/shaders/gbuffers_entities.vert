@@ -0,0 +1,90 @@
+#version 450
+#extension GL_ARB_shader_draw_parameters : require
+
+invariant gl_Position;
+
+layout(location = 0) in vec3 position_in;
+layout(location = 1) in vec2 uv_in;
+layout(location = 3) in vec3 normal_in;
+layout(location = 5) in vec4 color_in;
+
+layout(std140) uniform per_frame_uniforms {
+    mat4 gbufferModelView;
+    mat4 gbufferModelViewInverse;
+    mat4 gbufferPreviousModelView;
+    mat4 gbufferProjection;
+    mat4 gbufferProjectionInverse;
+    mat4 gbufferPreviousProjection;
+    mat4 shadowProjection;
+    mat4 shadowProjectionInverse;
+    mat4 shadowModelView;
+    mat4 shadowModelViewInverse;
+    vec4 entityColor;
+    vec3 fogColor;
+    float frameTimeCounter;
+    vec3 skyColor;
+    float sunAngle;
+    vec3 sunPosition;
+    float shadowAngle;
+    vec3 moonPosition;
+    float rainStrength;
+    vec3 shadowLightPosition;
+    float aspectRatio;
+    vec3 upPosition;
+    float viewWidth;
+    vec3 cameraPosition;
+    float viewHeight;
+    vec3 previousCameraPosition;
+    float near;
+    ivec2 eyeBrightness;
+    ivec2 eyeBrightnessSmooth;
+    ivec2 terrainTextureSize;
+    ivec2 atlasSize;
+    int heldItemId;
+    int heldBlockLightValue;
+    int heldItemId2;
+    int heldBlockLightValue2;
+    int fogMode;
+    int worldTime;
+    int moonPhase;
+    int terrainIconSize;
+    int isEyeInWater;
+    int hideGUI;
+    int entityId;
+    int blockEntityId;
+    float far;
+    float wetness;
+    float eyeAltitude;
+    float centerDepthSmooth;
+};
+
+struct entity_instance {
+    mat4 transform;     // From the model's space to world space
+    vec4 tint;
+    ivec4 info;         // x is the entity's ID, y its animation frame, z its packed lightmap coordinate
+};
+
+// Every visible instance of every model this frame. Each model's instances are drawn with one instanced draw, and its
+// first instance is the draw's base instance
+layout(std430, binding = 2) readonly buffer entity_instances {
+    entity_instance instances[];
+};
+
+out vec2 uv;
+out vec4 color;
+out vec2 lightmap_uv;
+out vec3 normal;
+
+void main() {
+	entity_instance instance = instances[gl_BaseInstanceARB + gl_InstanceID];
+
+	gl_Position = gbufferProjection * gbufferModelView * instance.transform * vec4(position_in, 1.0f);
+
+	uv = uv_in;
+	color = color_in / 255.0f * instance.tint;
+
+	// Block light is in the low 16 bits and sky light in the high 16, both already scaled to the lightmap's texels
+	vec2 lightmap_coord = vec2(instance.info.z & 0xFFFF, (instance.info.z >> 16) & 0xFFFF);
+	lightmap_uv = (lightmap_coord + 0.5) / 256;
+	normal = normalize(mat3(instance.transform) * normal_in);
+}
@@ -0,0 +1,76 @@
+#version 450
+
+layout(std140) uniform per_frame_uniforms {
+    mat4 gbufferModelView;
+    mat4 gbufferModelViewInverse;
+    mat4 gbufferPreviousModelView;
+    mat4 gbufferProjection;
+    mat4 gbufferProjectionInverse;
+    mat4 gbufferPreviousProjection;
+    mat4 shadowProjection;
+    mat4 shadowProjectionInverse;
+    mat4 shadowModelView;
+    mat4 shadowModelViewInverse;
+    vec4 entityColor;
+    vec3 fogColor;
+    float frameTimeCounter;
+    vec3 skyColor;
+    float sunAngle;
+    vec3 sunPosition;
+    float shadowAngle;
+    vec3 moonPosition;
+    float rainStrength;
+    vec3 shadowLightPosition;
+    float aspectRatio;
+    vec3 upPosition;
+    float viewWidth;
+    vec3 cameraPosition;
+    float viewHeight;
+    vec3 previousCameraPosition;
+    float near;
+    ivec2 eyeBrightness;
+    ivec2 eyeBrightnessSmooth;
+    ivec2 terrainTextureSize;
+    ivec2 atlasSize;
+    int heldItemId;
+    int heldBlockLightValue;
+    int heldItemId2;
+    int heldBlockLightValue2;
+    int fogMode;
+    int worldTime;
+    int moonPhase;
+    int terrainIconSize;
+    int isEyeInWater;
+    int hideGUI;
+    int entityId;
+    int blockEntityId;
+    float far;
+    float wetness;
+    float eyeAltitude;
+    float centerDepthSmooth;
+};
+
+in vec2 screen_position;
+
+layout(location = 0) out vec4 color_out;
+
+void main() {
+    vec4 view_position = gbufferProjectionInverse * vec4(screen_position, 1.0, 1.0);
+    vec3 view_direction = normalize(view_position.xyz / view_position.w);
+    vec3 up = normalize(upPosition);
+    vec3 sun = normalize(sunPosition);
+
+    // Fade from night to day as the sun comes up over the horizon
+    float daylight = clamp(dot(sun, up) * 4.0 + 0.5, 0.0, 1.0);
+    vec3 zenith = mix(vec3(0.01, 0.01, 0.04), vec3(0.47, 0.65, 1.0), daylight);
+    vec3 horizon = mix(vec3(0.04, 0.04, 0.08), vec3(0.75, 0.85, 1.0), daylight);
+    vec3 color = mix(horizon, zenith, clamp(dot(view_direction, up), 0.0, 1.0));
+
+    // Storms wash the sky out to grey and hide the sun
+    float grey = dot(color, vec3(0.3, 0.59, 0.11)) * 0.6;
+    color = mix(color, vec3(grey), rainStrength);
+    float sun_disk = smoothstep(0.9995, 0.9998, dot(view_direction, sun)) * (1.0 - rainStrength);
+    color += vec3(1.0, 0.95, 0.8) * sun_disk;
+
+    color_out = vec4(color, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,12 @@
+#version 450
+
+invariant gl_Position;
+
+out vec2 screen_position;
+
+void main() {
+    // One triangle that covers the whole screen, made from gl_VertexID
+    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+    screen_position = position;
+    gl_Position = vec4(position, 1.0, 1.0);
+}
\ No newline at end of file
@@ -16,13 +16,21 @@ layout(std140) uniform per_frame_uniforms {
     mat4 shadowModelViewInverse;
     vec4 entityColor;
     vec3 fogColor;
+    float frameTimeCounter;
     vec3 skyColor;
+    float sunAngle;
     vec3 sunPosition;
+    float shadowAngle;
     vec3 moonPosition;
+    float rainStrength;
     vec3 shadowLightPosition;
+    float aspectRatio;
     vec3 upPosition;
+    float viewWidth;
     vec3 cameraPosition;
+    float viewHeight;
     vec3 previousCameraPosition;
+    float near;
     ivec2 eyeBrightness;
     ivec2 eyeBrightnessSmooth;
     ivec2 terrainTextureSize;
@@ -39,29 +47,76 @@ layout(std140) uniform per_frame_uniforms {
     int hideGUI;
     int entityId;
     int blockEntityId;
-    float frameTimeCounter;
-    float sunAngle;
-    float shadowAngle;
-    float rainStrength;
-    float aspectRatio;
-    float viewWidth;
-    float viewHeight;
-    float near;
     float far;
     float wetness;
     float eyeAltitude;
     float centerDepthSmooth;
+    float renderScale;
+};
+
+// The lights from emissive blocks near the camera, sorted into clusters. See clustered_lights.h
+struct block_light {
+    vec4 viewPositionRadius;
+    uvec4 info;
+};
+
+layout(std430, binding = 3) readonly buffer block_lights {
+    uvec4 lightGridSize;
+    vec4 lightGridDepth;
+    block_light lights[];
+};
+
+layout(std430, binding = 4) readonly buffer light_clusters {
+    uint lightClusterData[];
 };
 
 in vec2 uv;
 in vec4 color;
+flat in vec4 tile;
 in vec2 lightmap_uv;
+in vec3 view_position;
 
 layout(location = 0) out vec4 color_out;
 
+vec4 sample_terrain(vec2 uv, vec4 tile) {
+    if(tile.z > 0) {
+        // Wrap within the block's texture. The gradients come from the unwrapped UVs so the mip level doesn't jump
+        // at the edge of every block
+        vec2 tile_uv = tile.xy + fract(uv) * tile.zw;
+        return textureGrad(colortex, tile_uv, dFdx(uv) * tile.zw, dFdy(uv) * tile.zw);
+    }
+
+    return texture(colortex, uv);
+}
+
+// How much light the emissive blocks near this pixel give it, from 0 to 15 like Minecraft's block light. It falls off
+// by one every block, like Minecraft's, but it's worked out for each pixel instead of each block
+float get_block_light(vec3 view_position) {
+    float view_depth = -view_position.z;
+    if(lightGridSize.w == 0 || view_depth <= 0 || view_depth > lightGridDepth.y) {
+        return 0;
+    }
+
+    uvec3 cell = uvec3(gl_FragCoord.xy / (vec2(viewWidth, viewHeight) * renderScale) * lightGridSize.xy,
+                       max(log(view_depth) * lightGridDepth.z + lightGridDepth.w, 0));
+    cell = min(cell, lightGridSize.xyz - 1);
+    uint cluster = (cell.z * lightGridSize.y + cell.y) * lightGridSize.x + cell.x;
+
+    uint first = lightClusterData[cluster * 2];
+    uint count = lightClusterData[cluster * 2 + 1];
+    float brightest = 0;
+    for(uint i = 0; i < count; i++) {
+        block_light light = lights[lightClusterData[first + i]];
+        float distance = length(light.viewPositionRadius.xyz - view_position);
+        brightest = max(brightest, float(light.info.y) - distance);
+    }
+
+    return brightest;
+}
+
 void main() {
     if(textureSize(colortex, 0).x > 0) {
-        vec4 tex_sample = texture(colortex, uv);
+        vec4 tex_sample = sample_terrain(uv, tile);
         if(tex_sample.a < 0.5) {
             discard;
         }
@@ -70,7 +125,12 @@ void main() {
         color_out = vec4(1, 0, 1, 1);
     }
 
-    color_out.rgb *= texture(lightmap, lightmap_uv).rgb * color.rgb / 255.0f;
+    // Minecraft's block light is only known at the corners of each block, so the per-pixel light from the clusters
+    // takes over wherever it's brighter. x is the block light coordinate in the lightmap
+    vec2 pixel_lightmap_uv = lightmap_uv;
+    pixel_lightmap_uv.x = max(pixel_lightmap_uv.x, (get_block_light(view_position) * 16 + 0.5) / 256);
+
+    color_out.rgb *= texture(lightmap, pixel_lightmap_uv).rgb * color.rgb / 255.0f;
 
     // color_out = vec4(1, 0, 1, 1); // color;
 }
\ No newline at end of file
@@ -1,10 +1,17 @@
 #version 450
+#extension GL_ARB_shader_draw_parameters : require
+
+// The depth pre-pass draws terrain with this shader too, and its depths have to match these exactly
+invariant gl_Position;
 
 layout(location = 0) in vec3 position_in;
 layout(location = 1) in vec2 uv_in;
 layout(location = 2) in vec2 lightmap_uv_in;
 layout(location = 3) in vec3 normal_in;
 layout(location = 5) in vec4 color_in;
+// Where the block's texture is in the atlas, as min u, min v, width, height. Only merged faces from the native
+// mesher have one, and their UVs count blocks so the texture repeats across the face
+layout(location = 6) in vec4 tile_in;
 
 layout(std140) uniform per_frame_uniforms {
     mat4 gbufferModelView;
@@ -19,13 +26,21 @@ layout(std140) uniform per_frame_uniforms {
     mat4 shadowModelViewInverse;
     vec4 entityColor;
     vec3 fogColor;
+    float frameTimeCounter;
     vec3 skyColor;
+    float sunAngle;
     vec3 sunPosition;
+    float shadowAngle;
     vec3 moonPosition;
+    float rainStrength;
     vec3 shadowLightPosition;
+    float aspectRatio;
     vec3 upPosition;
+    float viewWidth;
     vec3 cameraPosition;
+    float viewHeight;
     vec3 previousCameraPosition;
+    float near;
     ivec2 eyeBrightness;
     ivec2 eyeBrightnessSmooth;
     ivec2 terrainTextureSize;
@@ -42,32 +57,48 @@ layout(std140) uniform per_frame_uniforms {
     int hideGUI;
     int entityId;
     int blockEntityId;
-    float frameTimeCounter;
-    float sunAngle;
-    float shadowAngle;
-    float rainStrength;
-    float aspectRatio;
-    float viewWidth;
-    float viewHeight;
-    float near;
     float far;
     float wetness;
     float eyeAltitude;
     float centerDepthSmooth;
 };
 
-uniform mat4 gbufferModel;
+// One entry per chunk, written when the chunk is uploaded. Each draw's base instance is its chunk's index
+layout(std430, binding = 1) readonly buffer object_data {
+    vec4 object_position[];
+};
+
+// Packed chunk vertices store their position in fixed point, 512 steps per block
+const float PACKED_POSITION_SCALE = 1.0 / 512.0;
+
+vec3 octahedral_decode(vec2 encoded) {
+    vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    if(n.z < 0) {
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0 ? 1.0 : -1.0, n.y >= 0 ? 1.0 : -1.0);
+    }
+    return normalize(n);
+}
 
 out vec2 uv;
 out vec4 color;
+flat out vec4 tile;
 out vec2 lightmap_uv;
 out vec3 normal;
+out vec3 view_position;
 
 void main() {
-	gl_Position = gbufferProjection * gbufferModelView * gbufferModel * vec4(position_in, 1.0f);
+	vec4 offset = object_position[gl_BaseInstanceARB];
+	bool is_packed = offset.w > 0.5;
+
+	vec3 local_position = is_packed ? position_in * PACKED_POSITION_SCALE : position_in;
+	vec3 world_position = local_position + offset.xyz;
+	vec4 view_position_4 = gbufferModelView * vec4(world_position, 1.0f);
+	gl_Position = gbufferProjection * view_position_4;
+	view_position = view_position_4.xyz;
 
 	uv = uv_in;
+	tile = tile_in;
 	color = color_in;
 	lightmap_uv = (lightmap_uv_in + 0.5) / 256;
-	normal = normal_in;
+	normal = is_packed ? octahedral_decode(normal_in.xy) : normal_in;
 }
\ No newline at end of file
@@ -0,0 +1,19 @@
+#version 450
+
+layout(binding = 0) uniform sampler2D colortex;
+
+in vec2 uv;
+in vec4 color;
+
+layout(location = 0) out vec4 color_out;
+
+void main() {
+    if(textureSize(colortex, 0).x > 0) {
+        color_out = texture(colortex, uv) * color;
+        if(color_out.a < 0.1) {
+            discard;
+        }
+    } else {
+        color_out = vec4(1, 0, 1, 1);
+    }
+}
\ No newline at end of file
@@ -15,13 +15,21 @@ layout(std140) uniform per_frame_uniforms {
     mat4 shadowModelViewInverse;
     vec4 entityColor;
     vec3 fogColor;
+    float frameTimeCounter;
     vec3 skyColor;
+    float sunAngle;
     vec3 sunPosition;
+    float shadowAngle;
     vec3 moonPosition;
+    float rainStrength;
     vec3 shadowLightPosition;
+    float aspectRatio;
     vec3 upPosition;
+    float viewWidth;
     vec3 cameraPosition;
+    float viewHeight;
     vec3 previousCameraPosition;
+    float near;
     ivec2 eyeBrightness;
     ivec2 eyeBrightnessSmooth;
     ivec2 terrainTextureSize;
@@ -38,14 +46,6 @@ layout(std140) uniform per_frame_uniforms {
     int hideGUI;
     int entityId;
     int blockEntityId;
-    float frameTimeCounter;
-    float sunAngle;
-    float shadowAngle;
-    float rainStrength;
-    float aspectRatio;
-    float viewWidth;
-    float viewHeight;
-    float near;
     float far;
     float wetness;
     float eyeAltitude;
@@ -54,12 +54,24 @@ layout(std140) uniform per_frame_uniforms {
 
 in vec2 uv;
 in vec4 color;
+flat in vec4 tile;
 
 out vec4 color_out;
 
+vec4 sample_terrain(vec2 uv, vec4 tile) {
+    if(tile.z > 0) {
+        // Wrap within the block's texture. The gradients come from the unwrapped UVs so the mip level doesn't jump
+        // at the edge of every block
+        vec2 tile_uv = tile.xy + fract(uv) * tile.zw;
+        return textureGrad(colortex, tile_uv, dFdx(uv) * tile.zw, dFdy(uv) * tile.zw);
+    }
+
+    return texture(colortex, uv);
+}
+
 void main() {
     if(textureSize(colortex, 0).x > 0) {
-        vec4 tex_sample = texture(colortex, uv);
+        vec4 tex_sample = sample_terrain(uv, tile);
         color_out = tex_sample;// * color;
         
     } else {
@@ -1,9 +1,13 @@
 #version 450
+#extension GL_ARB_shader_draw_parameters : require
+
+invariant gl_Position;
 
 layout(location = 0) in vec3 position_in;
 layout(location = 1) in vec2 uv_in;
 layout(location = 2) in vec2 lightmap_uv_in;
 layout(location = 3) in vec3 normal_in;
+layout(location = 6) in vec4 tile_in;
 
 layout(std140) uniform per_frame_uniforms {
     mat4 gbufferModelView;
@@ -18,13 +22,21 @@ layout(std140) uniform per_frame_uniforms {
     mat4 shadowModelViewInverse;
     vec4 entityColor;
     vec3 fogColor;
+    float frameTimeCounter;
     vec3 skyColor;
+    float sunAngle;
     vec3 sunPosition;
+    float shadowAngle;
     vec3 moonPosition;
+    float rainStrength;
     vec3 shadowLightPosition;
+    float aspectRatio;
     vec3 upPosition;
+    float viewWidth;
     vec3 cameraPosition;
+    float viewHeight;
     vec3 previousCameraPosition;
+    float near;
     ivec2 eyeBrightness;
     ivec2 eyeBrightnessSmooth;
     ivec2 terrainTextureSize;
@@ -41,28 +53,41 @@ layout(std140) uniform per_frame_uniforms {
     int hideGUI;
     int entityId;
     int blockEntityId;
-    float frameTimeCounter;
-    float sunAngle;
-    float shadowAngle;
-    float rainStrength;
-    float aspectRatio;
-    float viewWidth;
-    float viewHeight;
-    float near;
     float far;
     float wetness;
     float eyeAltitude;
     float centerDepthSmooth;
 };
 
-uniform mat4 gbufferModel;
+// One entry per chunk, written when the chunk is uploaded. Each draw's base instance is its chunk's index
+layout(std430, binding = 1) readonly buffer object_data {
+    vec4 object_position[];
+};
+
+// Packed chunk vertices store their position in fixed point, 512 steps per block
+const float PACKED_POSITION_SCALE = 1.0 / 512.0;
+
+vec3 octahedral_decode(vec2 encoded) {
+    vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    if(n.z < 0) {
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0 ? 1.0 : -1.0, n.y >= 0 ? 1.0 : -1.0);
+    }
+    return normalize(n);
+}
 
 out vec2 uv;
 out vec4 color;
+flat out vec4 tile;
 
 void main() {
-	gl_Position = gbufferProjection * gbufferModelView * gbufferModel * vec4(position_in, 1.0f);
+	vec4 offset = object_position[gl_BaseInstanceARB];
+	bool is_packed = offset.w > 0.5;
+
+	vec3 local_position = is_packed ? position_in * PACKED_POSITION_SCALE : position_in;
+	vec3 world_position = local_position + offset.xyz;
+	gl_Position = gbufferProjection * gbufferModelView * vec4(world_position, 1.0f);
 
 	uv = uv_in;
+	tile = tile_in;
 	color = vec4(1);
 }
\ No newline at end of file
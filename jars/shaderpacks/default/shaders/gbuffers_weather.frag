@@ -0,0 +1,28 @@
+#version 450
+
+layout(std140) uniform sky_parameters {
+    vec2 cloudOffset;
+    float cloudHeight;
+    float cloudCellSize;
+    float skyTime;
+    float weatherStrength;
+    float snowStrength;
+    float weatherRadius;
+    float cloudCoverage;
+    int cloudGridSize;
+    int cloudPatternCells;
+    int weatherParticleCount;
+};
+
+in vec2 uv;
+in float particle_alpha;
+
+layout(location = 0) out vec4 color_out;
+
+void main() {
+    // Rain streaks are blue-grey, and snowflakes are round and white
+    float round_edge = 1.0 - smoothstep(0.3, 0.5, length(uv - 0.5));
+    float shape = mix(1.0 - abs(uv.x - 0.5) * 2.0, round_edge, snowStrength);
+    vec3 color = mix(vec3(0.6, 0.65, 0.8), vec3(1.0), snowStrength);
+    color_out = vec4(color, shape * particle_alpha * mix(0.5, 0.9, snowStrength));
+}
\ No newline at end of file
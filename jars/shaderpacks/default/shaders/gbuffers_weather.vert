@@ -0,0 +1,114 @@
+#version 450
+
+invariant gl_Position;
+
+layout(std140) uniform per_frame_uniforms {
+    mat4 gbufferModelView;
+    mat4 gbufferModelViewInverse;
+    mat4 gbufferPreviousModelView;
+    mat4 gbufferProjection;
+    mat4 gbufferProjectionInverse;
+    mat4 gbufferPreviousProjection;
+    mat4 shadowProjection;
+    mat4 shadowProjectionInverse;
+    mat4 shadowModelView;
+    mat4 shadowModelViewInverse;
+    vec4 entityColor;
+    vec3 fogColor;
+    float frameTimeCounter;
+    vec3 skyColor;
+    float sunAngle;
+    vec3 sunPosition;
+    float shadowAngle;
+    vec3 moonPosition;
+    float rainStrength;
+    vec3 shadowLightPosition;
+    float aspectRatio;
+    vec3 upPosition;
+    float viewWidth;
+    vec3 cameraPosition;
+    float viewHeight;
+    vec3 previousCameraPosition;
+    float near;
+    ivec2 eyeBrightness;
+    ivec2 eyeBrightnessSmooth;
+    ivec2 terrainTextureSize;
+    ivec2 atlasSize;
+    int heldItemId;
+    int heldBlockLightValue;
+    int heldItemId2;
+    int heldBlockLightValue2;
+    int fogMode;
+    int worldTime;
+    int moonPhase;
+    int terrainIconSize;
+    int isEyeInWater;
+    int hideGUI;
+    int entityId;
+    int blockEntityId;
+    float far;
+    float wetness;
+    float eyeAltitude;
+    float centerDepthSmooth;
+};
+
+layout(std140) uniform sky_parameters {
+    vec2 cloudOffset;
+    float cloudHeight;
+    float cloudCellSize;
+    float skyTime;
+    float weatherStrength;
+    float snowStrength;
+    float weatherRadius;
+    float cloudCoverage;
+    int cloudGridSize;
+    int cloudPatternCells;
+    int weatherParticleCount;
+};
+
+out vec2 uv;
+out float particle_alpha;
+
+uint hash(uint value) {
+    value ^= value >> 16;
+    value *= 0x7feb352du;
+    value ^= value >> 15;
+    value *= 0x846ca68bu;
+    value ^= value >> 16;
+    return value;
+}
+
+float random(uint seed) {
+    return float(hash(seed) & 0xFFFFFFu) / 16777215.0;
+}
+
+void main() {
+    // Each instance is one raindrop or snowflake, scattered over a box around the camera from its instance ID
+    const vec2 corners[6] = vec2[](vec2(-1, 0), vec2(1, 0), vec2(1, 1), vec2(1, 1), vec2(-1, 1), vec2(-1, 0));
+    uint particle = uint(gl_InstanceID);
+    float box_size = weatherRadius * 2.0;
+
+    // The particles are placed in a box that's fixed in the world and wraps around the camera, so they don't slide
+    // along with it
+    vec3 box_position = vec3(random(particle * 3u), random(particle * 3u + 1u), random(particle * 3u + 2u)) * box_size;
+    vec3 box_origin = cameraPosition - weatherRadius;
+
+    // Rain falls fast and straight, snow falls slowly and drifts from side to side
+    float fall_speed = mix(0.75, 0.08, snowStrength);
+    box_position.y -= skyTime * fall_speed;
+    box_position.x += sin(skyTime * 0.05 + float(particle)) * snowStrength;
+    vec3 world_position = box_origin + mod(box_position - box_origin, box_size);
+
+    // Turn the quad to face the camera around the y axis
+    vec3 camera_right = normalize(vec3(gbufferModelView[0][0], 0.0, gbufferModelView[2][0]) + vec3(1e-5, 0.0, 0.0));
+    vec2 corner = corners[gl_VertexID];
+    vec2 size = mix(vec2(0.02, 0.6), vec2(0.06, 0.12), snowStrength);
+    world_position += camera_right * corner.x * size.x + vec3(0.0, corner.y * size.y, 0.0);
+
+    gl_Position = gbufferProjection * gbufferModelView * vec4(world_position, 1.0);
+
+    // Particles fade out at the edge of the box so it doesn't end in a hard line
+    float distance_to_camera = length(world_position.xz - cameraPosition.xz);
+    uv = corner * 0.5 + 0.5;
+    particle_alpha = weatherStrength * clamp((weatherRadius - distance_to_camera) / 4.0, 0.0, 1.0);
+}
\ No newline at end of file
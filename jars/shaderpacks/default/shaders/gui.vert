@@ -3,6 +3,12 @@
 layout(location = 0) in vec3 position_in;
 layout(location = 1) in vec2 uv_in;
 layout(location = 2) in vec4 color_in;
+layout(location = 3) in uint sprite_in;
+
+// Each sprite's min and max UV in its atlas, so the GUI's UVs can go across just the sprite
+layout(std430, binding = 8) readonly buffer sprite_locations {
+    vec4 sprite_location[];
+};
 
 layout(std140) uniform per_frame_uniforms {
     mat4 gbufferModelView;
@@ -17,13 +23,21 @@ layout(std140) uniform per_frame_uniforms {
     mat4 shadowModelViewInverse;
     vec4 entityColor;
     vec3 fogColor;
+    float frameTimeCounter;
     vec3 skyColor;
+    float sunAngle;
     vec3 sunPosition;
+    float shadowAngle;
     vec3 moonPosition;
+    float rainStrength;
     vec3 shadowLightPosition;
+    float aspectRatio;
     vec3 upPosition;
+    float viewWidth;
     vec3 cameraPosition;
+    float viewHeight;
     vec3 previousCameraPosition;
+    float near;
     ivec2 eyeBrightness;
     ivec2 eyeBrightnessSmooth;
     ivec2 terrainTextureSize;
@@ -40,14 +54,6 @@ layout(std140) uniform per_frame_uniforms {
     int hideGUI;
     int entityId;
     int blockEntityId;
-    float frameTimeCounter;
-    float sunAngle;
-    float shadowAngle;
-    float rainStrength;
-    float aspectRatio;
-    float viewWidth;
-    float viewHeight;
-    float near;
     float far;
     float wetness;
     float eyeAltitude;
@@ -62,6 +68,7 @@ out vec4 color;
 void main() {
     gl_Position = gbufferModel * vec4(position_in, 1.0f);
 
-    uv = uv_in;
+    vec4 location = sprite_location[sprite_in];
+    uv = mix(location.xy, location.zw, uv_in);
     color = color_in;
 }
\ No newline at end of file
@@ -12,6 +12,11 @@
 namespace nova {
     bool is_zip_file(const std::string &filename) {
         mz_zip_archive dummy_zip_archive = {};
-        return (bool) mz_zip_reader_init_file(&dummy_zip_archive, filename.c_str(), 0);
+        if(!mz_zip_reader_init_file(&dummy_zip_archive, filename.c_str(), 0)) {
+            return false;
+        }
+
+        mz_zip_reader_end(&dummy_zip_archive);
+        return true;
     }
 }
\ No newline at end of file
@@ -18,10 +18,32 @@ namespace nova {
     /*!
      * \brief Loads the shaderpack with the given name
      *
+     * The shaderpack's shaders may still be compiling when this returns. Call shaderpack#finish_loading before using
+     * them
+     *
      * \param shaderpack_name The name of the shaderpack to load
+     * \param define_values The value of each of the shaderpack's defines, like the shaderpackDefines setting
      * \return The loaded shaderpack
      */
-    shaderpack load_shaderpack(const std::string &shaderpack_name);
+    shaderpack load_shaderpack(const std::string &shaderpack_name,
+                               const nlohmann::json &define_values = nlohmann::json::object());
+
+    /*!
+     * \brief Starts compiling the shaders in a shaderpack that's already been read
+     *
+     * Must be called from the thread that owns the OpenGL context
+     */
+    shaderpack load_shaderpack(shaderpack_sources &sources, const nlohmann::json &define_values = nlohmann::json::object());
+
+    /*!
+     * \brief Reads the shaderpack with the given name and pastes in its includes
+     *
+     * Only touches the disk, never OpenGL, so it can run on any thread
+     *
+     * \param shaderpack_name The name of the shaderpack to read
+     * \return Everything load_shaderpack needs to start compiling the shaderpack
+     */
+    shaderpack_sources read_shaderpack_sources(const std::string &shaderpack_name);
 }
 
 #endif //RENDERER_LOADERS_H
@@ -5,6 +5,12 @@
  * \date 03-Sep-16.
  */
 
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
 #include <easylogging++.h>
 
 #include "loaders.h"
@@ -35,16 +41,43 @@ namespace nova {
             ".vert.spv"
     };
 
-    shaderpack load_shaderpack(const std::string &shaderpack_name) {
+    std::vector<std::string> compute_extensions = {
+            ".csh",
+            ".comp",
+            ".comp.spv"
+    };
+
+    /*!
+     * \brief The first word of every SPIR-V module
+     */
+    static const uint32_t SPIRV_MAGIC_NUMBER = 0x07230203;
+
+    /*!
+     * \brief Checks if the file at the path is SPIR-V, rather than GLSL
+     */
+    static bool is_spirv_path(const std::string &path) {
+        return path.size() >= 4 && path.compare(path.size() - 4, 4, ".spv") == 0;
+    }
+
+    shaderpack load_shaderpack(const std::string &shaderpack_name, const nlohmann::json &define_values) {
+        auto sources = read_shaderpack_sources(shaderpack_name);
+        return load_shaderpack(sources, define_values);
+    }
+
+    shaderpack load_shaderpack(shaderpack_sources &sources, const nlohmann::json &define_values) {
+        return shaderpack(sources.name, sources.shaders_json, sources.shaders, sources.program_cache_directory,
+                          define_values);
+    }
+
+    shaderpack_sources read_shaderpack_sources(const std::string &shaderpack_name) {
         LOG(DEBUG) << "Loading shaderpack " << shaderpack_name;
-        auto shader_sources = std::unordered_map<std::string, shader_definition>{};
-        if(is_zip_file(shaderpack_name)) {
+        if(is_zip_file("shaderpacks/" + shaderpack_name)) {
             LOG(TRACE) << "Loading shaderpack " << shaderpack_name << " from a zip file";
-            return load_sources_from_zip_file(shaderpack_name, shader_names);
+            return read_sources_from_zip_file(shaderpack_name);
 
         } else {
             LOG(TRACE) << "Loading shaderpack " << shaderpack_name << " from a regular folder";
-            return load_sources_from_folder(shaderpack_name, shader_names);
+            return read_sources_from_folder(shaderpack_name);
         }
     }
 
@@ -55,20 +88,199 @@ namespace nova {
         // called 'shaders' which should be an array. Load the definitions
         // from there.
 
-        nlohmann::json &definitions_array = shaders_json;
+        nlohmann::json* definitions_array = &shaders_json;
         if(shaders_json.is_object()) {
-            definitions_array = shaders_json["shaders"];
+            definitions_array = &shaders_json["shaders"];
         }
 
+        const auto specialization_constants = get_specialization_constants(shaders_json);
+
         std::vector<shader_definition> definitions;
-        for(auto& definition : definitions_array) {
+        for(auto& definition : *definitions_array) {
             definitions.push_back(shader_definition(definition));
+            definitions.back().specialization_constants = specialization_constants;
         }
 
         return definitions;
     }
 
+    std::vector<specialization_constant> get_specialization_constants(const nlohmann::json &shaders_json) {
+        std::vector<specialization_constant> constants;
+        if(!shaders_json.is_object()) {
+            return constants;
+        }
+
+        auto options = shaders_json.find("options");
+        if(options == shaders_json.end() || !options->is_object()) {
+            return constants;
+        }
+
+        for(auto option = options->begin(); option != options->end(); ++option) {
+            auto constant_id = option->find("constant_id");
+            auto value = option->find("value");
+            if(constant_id == option->end() || !constant_id->is_number_unsigned() || value == option->end()) {
+                LOG(WARNING) << "Shaderpack option " << option.key() << " needs a constant_id and a value";
+                continue;
+            }
+
+            specialization_constant constant = {constant_id->get<uint32_t>(), 0};
+            if(value->is_boolean()) {
+                constant.value = value->get<bool>() ? 1 : 0;
+
+            } else if(value->is_number_integer()) {
+                // Negative ints keep their two's complement bits, which is what an int constant expects
+                constant.value = static_cast<uint32_t>(value->get<int64_t>());
+
+            } else if(value->is_number_float()) {
+                const float float_value = value->get<float>();
+                std::memcpy(&constant.value, &float_value, sizeof(float));
+
+            } else {
+                LOG(WARNING) << "Shaderpack option " << option.key() << " has to be a bool, an integer, or a float";
+                continue;
+            }
+
+            constants.push_back(constant);
+        }
+
+        return constants;
+    }
+
+    /*!
+     * \brief Checks if the name can be used as a GLSL identifier, so it's safe to paste into a #define
+     */
+    static bool is_identifier(const std::string &name) {
+        if(name.empty() || std::isdigit(static_cast<unsigned char>(name[0]))) {
+            return false;
+        }
+
+        return std::all_of(name.begin(), name.end(), [](char c) {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+        });
+    }
+
+    std::vector<shader_define> get_shader_defines(const nlohmann::json &shaders_json) {
+        std::vector<shader_define> defines;
+        if(!shaders_json.is_object()) {
+            return defines;
+        }
+
+        auto defines_json = shaders_json.find("defines");
+        if(defines_json == shaders_json.end() || !defines_json->is_object()) {
+            return defines;
+        }
+
+        for(auto define_json = defines_json->begin(); define_json != defines_json->end(); ++define_json) {
+            shader_define define;
+            define.name = define_json.key();
+            if(!is_identifier(define.name) || !define_json->is_object()) {
+                LOG(WARNING) << "Shaderpack define " << define.name
+                             << " needs a name that's a GLSL identifier, and an object describing it";
+                continue;
+            }
+
+            auto values = define_json->find("values");
+            if(values != define_json->end()) {
+                if(!values->is_array() || values->empty() ||
+                   !std::all_of(values->begin(), values->end(), [](const nlohmann::json &value) {
+                       return value.is_string() && is_identifier(value.get<std::string>());
+                   })) {
+                    LOG(WARNING) << "Shaderpack define " << define.name
+                                 << " needs its values to be a list of GLSL identifiers";
+                    continue;
+                }
+
+                define.values = values->get<std::vector<std::string>>();
+            }
+
+            auto default_value = define_json->find("default");
+            if(define.is_bool()) {
+                define.default_value = default_value != define_json->end() && default_value->is_boolean() &&
+                                       default_value->get<bool>() ? "true" : "false";
+
+            } else if(default_value != define_json->end() && default_value->is_string() &&
+                      define.has_value(default_value->get<std::string>())) {
+                define.default_value = default_value->get<std::string>();
+
+            } else {
+                define.default_value = define.values[0];
+            }
+
+            defines.push_back(define);
+        }
+
+        std::sort(defines.begin(), defines.end(), [](const shader_define &a, const shader_define &b) {
+            return a.name < b.name;
+        });
+
+        return defines;
+    }
+
+    std::vector<std::string> get_define_lines(const shader_definition &shader, const std::vector<shader_define> &defines,
+                                              const nlohmann::json &define_values) {
+        std::vector<std::string> lines;
+        for(const auto &define : defines) {
+            if(!define.is_used_by(shader.vertex_source) && !define.is_used_by(shader.fragment_source) &&
+               !define.is_used_by(shader.compute_source)) {
+                continue;
+            }
+
+            std::string value = define.default_value;
+            auto value_json = define_values.is_object() ? define_values.find(define.name) : define_values.end();
+            if(value_json != define_values.end()) {
+                std::string chosen_value;
+                if(value_json->is_boolean()) {
+                    chosen_value = value_json->get<bool>() ? "true" : "false";
+                } else if(value_json->is_string()) {
+                    chosen_value = value_json->get<std::string>();
+                }
+
+                if(define.has_value(chosen_value)) {
+                    value = chosen_value;
+                } else {
+                    LOG(WARNING) << "Shaderpack define " << define.name << " can't be " << *value_json
+                                 << ", so it's " << define.default_value;
+                }
+            }
+
+            define.append_lines(value, lines);
+        }
+
+        return lines;
+    }
+
+    bool read_spirv(const std::string &bytes, std::vector<uint32_t> &words) {
+        if(bytes.size() < sizeof(uint32_t) || bytes.size() % sizeof(uint32_t) != 0) {
+            return false;
+        }
+
+        words.resize(bytes.size() / sizeof(uint32_t));
+        std::memcpy(words.data(), bytes.data(), bytes.size());
+
+        if(words[0] == SPIRV_MAGIC_NUMBER) {
+            return true;
+        }
+
+        auto swap_bytes = [](uint32_t word) {
+            return (word >> 24) | ((word >> 8) & 0xFF00) | ((word << 8) & 0xFF0000) | (word << 24);
+        };
+        if(swap_bytes(words[0]) != SPIRV_MAGIC_NUMBER) {
+            words.clear();
+            return false;
+        }
+
+        for(auto& word : words) {
+            word = swap_bytes(word);
+        }
+        return true;
+    }
+
     shaderpack load_sources_from_folder(const std::string &shaderpack_name, const std::vector<std::string> &shader_names) {
+        auto sources = read_sources_from_folder(shaderpack_name);
+        return load_shaderpack(sources);
+    }
+
+    shaderpack_sources read_sources_from_folder(const std::string &shaderpack_name) {
         std::vector<shader_definition> sources;
 
         // First, load in the shaders.json file so we can see what we're
@@ -88,14 +300,10 @@ namespace nova {
         // Figure out all the shader files that we need to load
         auto shaders = get_shader_definitions(shaders_json);
 
+        shader_include_resolver includes;
         for(auto &shader : shaders) {
             try {
-                // All shaderpacks are in the shaderpacks folder
-                auto shader_path = "shaderpacks/" + shaderpack_name + "/shaders/" + shader.name;
-
-                shader.vertex_source = load_shader_file(shader_path, vertex_extensions);
-                shader.fragment_source = load_shader_file(shader_path, fragment_extensions);
-
+                load_shader_sources(shaderpack_name, shader, includes);
                 sources.push_back(shader);
             } catch(std::exception& e) {
                 LOG(ERROR) << "Could not load shader " << shader.name << ". Reason: " << e.what();
@@ -104,7 +312,23 @@ namespace nova {
 
         warn_for_missing_fallbacks(sources);
 
-        return shaderpack(shaderpack_name, shaders_json, sources);
+        return {shaderpack_name, shaders_json, sources, "shaderpacks/" + shaderpack_name + "/program_cache"};
+    }
+
+    void load_shader_sources(const std::string &shaderpack_name, shader_definition &shader, shader_include_resolver &includes) {
+        // All shaderpacks are in the shaderpacks folder
+        auto shader_path = "shaderpacks/" + shaderpack_name + "/shaders/" + shader.name;
+
+        if(includes.has_shader_file(shader_path, compute_extensions)) {
+            shader.compute_source = includes.load_shader_file(shader_path, compute_extensions);
+            shader.vertex_source = {};
+            shader.fragment_source = {};
+
+        } else {
+            shader.vertex_source = includes.load_shader_file(shader_path, vertex_extensions);
+            shader.fragment_source = includes.load_shader_file(shader_path, fragment_extensions);
+            shader.compute_source = {};
+        }
     }
 
     void warn_for_missing_fallbacks(std::vector<shader_definition> sources) {
@@ -159,7 +383,7 @@ namespace nova {
         return include_line.substr(quote_pos + 1, include_line.size() - quote_pos - 2);
     }
 
-    auto get_included_file_path(const std::string &shader_path, const std::string &included_file_name) {
+    std::string get_included_file_path(const std::string &shader_path, const std::string &included_file_name) {
         if(included_file_name[0] == '/') {
             
             // This is an absolute include and it should be relative to the root directory
@@ -177,15 +401,61 @@ namespace nova {
         }
     }
 
-    std::vector<shader_line> load_shader_file(const std::string &shader_path, const std::vector<std::string> &extensions) {
+    shader_source load_shader_file(const std::string &shader_path, const std::vector<std::string> &extensions) {
+        shader_include_resolver includes;
+        return includes.load_shader_file(shader_path, extensions);
+    }
+
+    shader_source read_shader_stream(std::istream &stream, const std::string &shader_path) {
+        shader_include_resolver includes;
+        return includes.read_shader_stream(stream, shader_path);
+    }
+
+    shader_source load_included_file(const std::string &shader_path, const std::string &line) {
+        shader_include_resolver includes;
+        return includes.load_included_file(shader_path, line);
+    }
+
+    /*!
+     * \brief Reads all the lines from the stream
+     */
+    static std::vector<std::string> read_lines(std::istream &stream) {
+        std::vector<std::string> lines;
+        std::string line;
+        while(std::getline(stream, line, '\n')) {
+            lines.push_back(std::move(line));
+        }
+
+        return lines;
+    }
+
+    shader_source shader_include_resolver::load_shader_file(const std::string &shader_path, const std::vector<std::string> &extensions) {
         for(auto &extension : extensions) {
             auto full_shader_path = shader_path + extension;
             LOG(TRACE) << "Trying to load shader file " << full_shader_path;
 
-            std::ifstream stream(full_shader_path, std::ios::in);
-            if(stream.good()) {
+            if(is_spirv_path(full_shader_path)) {
+                auto words = get_spirv_words(full_shader_path);
+                if(words != nullptr) {
+                    LOG(INFO) << "Loading SPIR-V shader file " << full_shader_path;
+                    shader_source source;
+                    source.get_file_index(full_shader_path);
+                    source.spirv = *words;
+                    return source;
+                }
+
+                LOG(WARNING) << "Could not read file " << full_shader_path;
+                continue;
+            }
+
+            auto lines = get_file_lines(full_shader_path);
+            if(lines != nullptr) {
                 LOG(INFO) << "Loading shader file " << full_shader_path;
-                return read_shader_stream(stream, full_shader_path);
+                shader_source source;
+                std::vector<std::string> include_stack;
+                append_file(full_shader_path, *lines, source, include_stack);
+                return source;
+
             } else {
                 LOG(WARNING) << "Could not read file " << full_shader_path;
             }
@@ -194,26 +464,26 @@ namespace nova {
         throw resource_not_found(shader_path);
     }
 
-    std::vector<shader_line> read_shader_stream(std::istream &stream, const std::string &shader_path) {
-        std::vector<shader_line> file_source;
-        std::string line;
-        auto line_counter = 1;
-        while(std::getline(stream, line, '\n')) {
-            if(line.find("#include") == 0) { 
-                auto included_file = load_included_file(shader_path, line);
-                file_source.insert(file_source.end(), std::begin(included_file), std::end(included_file));
-
-            } else {
-                file_source.push_back({line_counter, shader_path, line});
+    bool shader_include_resolver::has_shader_file(const std::string &shader_path, const std::vector<std::string> &extensions) {
+        for(auto &extension : extensions) {
+            const auto full_shader_path = shader_path + extension;
+            if(is_spirv_path(full_shader_path) ? get_spirv_words(full_shader_path) != nullptr
+                                               : get_file_lines(full_shader_path) != nullptr) {
+                return true;
             }
-
-            line_counter++;
         }
 
-        return file_source;
+        return false;
     }
 
-    std::vector<shader_line> load_included_file(const std::string &shader_path, const std::string &line) {
+    shader_source shader_include_resolver::read_shader_stream(std::istream &stream, const std::string &shader_path) {
+        shader_source source;
+        std::vector<std::string> include_stack;
+        append_file(shader_path, read_lines(stream), source, include_stack);
+        return source;
+    }
+
+    shader_source shader_include_resolver::load_included_file(const std::string &shader_path, const std::string &line) {
         auto included_file_name = get_filename_from_include(line);
         auto file_to_include = get_included_file_path(shader_path, included_file_name);
         LOG(TRACE) << "Dealing with included file " << file_to_include;
@@ -225,9 +495,162 @@ namespace nova {
         }
     }
 
+    shader_include_resolver::shader_include_resolver(shaderpack_archive* archive) : archive(archive) {}
+
+    /*!
+     * \brief Turns the contents of a .spv file into SPIR-V words, logging why if it can't
+     */
+    static std::unique_ptr<std::vector<uint32_t>> make_spirv_words(const std::string &path, const std::string &bytes) {
+        auto words = std::make_unique<std::vector<uint32_t>>();
+        if(!read_spirv(bytes, *words)) {
+            LOG(ERROR) << path << " isn't a SPIR-V file";
+            return nullptr;
+        }
+
+        return words;
+    }
+
+    void shader_include_resolver::add_file(const std::string &path, const std::string &contents) {
+        const std::string key = archive != nullptr ? shaderpack_archive::normalize_path(path) : path;
+        if(is_spirv_path(key)) {
+            spirv_files[key] = make_spirv_words(key, contents);
+            return;
+        }
+
+        std::istringstream stream(contents);
+        file_lines[key] = std::make_unique<std::vector<std::string>>(read_lines(stream));
+    }
+
+    const std::vector<uint32_t>* shader_include_resolver::get_spirv_words(const std::string &path) {
+        const std::string key = archive != nullptr ? shaderpack_archive::normalize_path(path) : path;
+
+        auto file = spirv_files.find(key);
+        if(file == spirv_files.end()) {
+            std::unique_ptr<std::vector<uint32_t>> words;
+            std::string bytes;
+            if(archive != nullptr) {
+                if(archive->read_file(key, bytes)) {
+                    words = make_spirv_words(key, bytes);
+                }
+
+            } else {
+                std::ifstream stream(path, std::ios::in | std::ios::binary);
+                if(stream.good()) {
+                    bytes.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+                    words = make_spirv_words(path, bytes);
+                }
+            }
+
+            file = spirv_files.emplace(key, std::move(words)).first;
+        }
+
+        return file->second.get();
+    }
+
+    const std::vector<std::string>* shader_include_resolver::get_file_lines(const std::string &path) {
+        // Paths like lib/../common.glsl have to be cleaned up to be found in a zip
+        const std::string key = archive != nullptr ? shaderpack_archive::normalize_path(path) : path;
+
+        auto file = file_lines.find(key);
+        if(file == file_lines.end()) {
+            std::unique_ptr<std::vector<std::string>> lines;
+            if(archive != nullptr) {
+                std::string contents;
+                if(archive->read_file(key, contents)) {
+                    std::istringstream stream(contents);
+                    lines = std::make_unique<std::vector<std::string>>(read_lines(stream));
+                }
+
+            } else {
+                std::ifstream stream(path, std::ios::in);
+                if(stream.good()) {
+                    lines = std::make_unique<std::vector<std::string>>(read_lines(stream));
+                }
+            }
+
+            file = file_lines.emplace(key, std::move(lines)).first;
+        }
+
+        return file->second.get();
+    }
+
+    void shader_include_resolver::append_file(const std::string &path, const std::vector<std::string> &lines,
+                                              shader_source &source, std::vector<std::string> &include_stack) {
+        if(std::find(include_stack.begin(), include_stack.end(), path) != include_stack.end()) {
+            throw std::runtime_error("Shader file " + path + " includes itself");
+        }
+        include_stack.push_back(path);
+
+        const uint32_t file_index = source.get_file_index(path);
+        auto line_counter = 1;
+        for(const auto &line : lines) {
+            if(line.find("#include") == 0) {
+                auto file_to_include = get_included_file_path(path, get_filename_from_include(line));
+                LOG(TRACE) << "Dealing with included file " << file_to_include;
+
+                auto included_lines = get_file_lines(file_to_include);
+                if(included_lines == nullptr) {
+                    throw std::runtime_error("Could not load included file " + file_to_include);
+                }
+
+                append_file(file_to_include, *included_lines, source, include_stack);
+
+            } else {
+                source.lines.push_back({line_counter, file_index, line});
+            }
+
+            line_counter++;
+        }
+
+        include_stack.pop_back();
+    }
+
     shaderpack load_sources_from_zip_file(const std::string &shaderpack_name, const std::vector<std::string> &shader_names) {
-        LOG(FATAL) << "Cannot load zipped shaderpack " << shaderpack_name;
-        throw std::runtime_error("Zipped shaderpacks not yet supported");
+        auto sources = read_sources_from_zip_file(shaderpack_name);
+        return load_shaderpack(sources);
+    }
+
+    shaderpack_sources read_sources_from_zip_file(const std::string &shaderpack_name) {
+        // The zip's files are found at the paths they'd have if it was unzipped in place, so shader paths and
+        // includes work just like they do for a folder
+        const std::string root_path = "shaderpacks/" + shaderpack_name + "/";
+        shaderpack_archive archive("shaderpacks/" + shaderpack_name, root_path);
+        if(!archive.is_open()) {
+            throw resource_not_found("shaderpacks/" + shaderpack_name);
+        }
+
+        nlohmann::json shaders_json;
+        std::string shaders_json_text;
+        if(archive.read_file(root_path + "shaders.json", shaders_json_text)) {
+            shaders_json = nlohmann::json::parse(shaders_json_text);
+
+        } else {
+            shaders_json = get_default_shaders_json();
+        }
+
+        auto shaders = get_shader_definitions(shaders_json);
+
+        // Nearly everything in the shaders folder is a shader or something they include, so it's all decompressed at
+        // once on a few threads instead of one file at a time as the shaders ask for them
+        shader_include_resolver includes(&archive);
+        for(const auto& file : archive.read_files(root_path + "shaders/")) {
+            includes.add_file(file.first, file.second);
+        }
+
+        std::vector<shader_definition> sources;
+        for(auto &shader : shaders) {
+            try {
+                load_shader_sources(shaderpack_name, shader, includes);
+                sources.push_back(shader);
+            } catch(std::exception& e) {
+                LOG(ERROR) << "Could not load shader " << shader.name << ". Reason: " << e.what();
+            }
+        }
+
+        warn_for_missing_fallbacks(sources);
+
+        // There's no folder to put the program cache in, so it goes next to the zip
+        return {shaderpack_name, shaders_json, sources, "shaderpacks/" + shaderpack_name + ".program_cache"};
     }
 
     nlohmann::json& get_default_shaders_json() {
@@ -8,25 +8,38 @@
 #ifndef RENDERER_SHADER_LOADING_H_H
 #define RENDERER_SHADER_LOADING_H_H
 
+#include <istream>
+#include <memory>
 #include <string>
 #include <vector>
 #include <unordered_map>
 
 #include "shader_source_structs.h"
+#include "shaderpack_archive.h"
 
 namespace nova {
+    class shaderpack;
+
     /*!
      * \brief Loads the source file of all the shaders with the provided names
      *
      * This will only work if the shaderpack is a zip file. If the shaderpack is just a folder, this will probably
      * fail in strange ways
      *
+     * The zip is never unzipped to disk. Every file in its shaders folder is decompressed across a few threads up
+     * front, and anything else a shader includes is decompressed when it's asked for
+     *
      * \param shaderpack_name The name of the shaderpack to load the shaders from
      * \param shader_names The list of names of shaders to load
      * \return A map from shader name to shader source
      */
     shaderpack load_sources_from_zip_file(const std::string &shaderpack_name, const std::vector<std::string> &shader_names);
 
+    /*!
+     * \brief Does the file reading part of load_sources_from_zip_file, without sending anything to the GPU
+     */
+    shaderpack_sources read_sources_from_zip_file(const std::string &shaderpack_name);
+
     /*!
      * \brief Loads the source file of all the shaders with the provided names
      *
@@ -39,6 +52,11 @@ namespace nova {
      */
     shaderpack load_sources_from_folder(const std::string &shaderpack_name, const std::vector<std::string> &shader_names);
 
+    /*!
+     * \brief Does the file reading part of load_sources_from_folder, without sending anything to the GPU
+     */
+    shaderpack_sources read_sources_from_folder(const std::string &shaderpack_name);
+
     /*!
      * \brief Tries to load a single shader file from a folder
      *
@@ -50,7 +68,7 @@ namespace nova {
      * \param extensions A list of extensions to try
      * \return The full source of the shader file
      */
-    std::vector<shader_line> load_shader_file(const std::string &shader_path, const std::vector<std::string> &extensions);
+    shader_source load_shader_file(const std::string &shader_path, const std::vector<std::string> &extensions);
 
     /*!
      * \brief Loads the shader file from the provided istream
@@ -59,19 +77,173 @@ namespace nova {
      * \param shader_path The path to the shader file (useful mostly for includes)
      * \return A list of shader_line objects
      */
-    std::vector<shader_line> read_shader_stream(std::istream &stream, const std::string &shader_path);
+    shader_source read_shader_stream(std::istream &stream, const std::string &shader_path);
 
     /*!
      * \brief Loads a file that was requested through a #include statement
      *
-     * This function will recursively include files. There's nothing to check for an infinite include loop, so try to
-     * not have any
+     * This function will recursively include files. A file that ends up including itself throws a runtime_error
      *
      * \param shader_path The path to the shader that includes the file
      * \param line The line in the shader that contains the #include statement
      * \return The full source of the included file
      */
-    std::vector<shader_line> load_included_file(const std::string &shader_path, const std::string &line);
+    shader_source load_included_file(const std::string &shader_path, const std::string &line);
+
+    /*!
+     * \brief Does the work of load_shader_file, read_shader_stream, and load_included_file, but remembers every file
+     * it reads
+     *
+     * Shaderpacks tend to include the same few files, like the headers in lib, from most of their shaders. Each of
+     * those files is only read and split into lines the first time it's needed. Every time after that, its lines come
+     * from memory. Use one resolver for every shader in a shaderpack, and throw it away when the shaderpack is loaded
+     * so edited files get read again next time
+     *
+     * A resolver made with a shaderpack_archive reads files out of the zip instead of from disk
+     *
+     * Files that end in .spv are read as SPIR-V instead of as lines. They can't include anything
+     */
+    class shader_include_resolver {
+    public:
+        shader_include_resolver() = default;
+
+        /*!
+         * \brief Makes a resolver that reads files from a zipped shaderpack. The archive must outlive the resolver
+         */
+        explicit shader_include_resolver(shaderpack_archive* archive);
+
+        /*!
+         * \brief Gives the resolver the contents of a file, so it doesn't have to read it
+         */
+        void add_file(const std::string &path, const std::string &contents);
+
+        shader_source load_shader_file(const std::string &shader_path, const std::vector<std::string> &extensions);
+
+        /*!
+         * \brief Checks if the shader exists with any of the extensions, without warning about the ones it doesn't
+         * have
+         */
+        bool has_shader_file(const std::string &shader_path, const std::vector<std::string> &extensions);
+
+        /*!
+         * \brief Reads the shader from the stream. Only the files it includes are remembered, since the stream might
+         * not be the same as the file on disk
+         */
+        shader_source read_shader_stream(std::istream &stream, const std::string &shader_path);
+
+        shader_source load_included_file(const std::string &shader_path, const std::string &line);
+
+    private:
+        shaderpack_archive* archive = nullptr;
+
+        /*!
+         * \brief The lines of every file that's been asked for, or nullptr for the ones that couldn't be opened
+         */
+        std::unordered_map<std::string, std::unique_ptr<std::vector<std::string>>> file_lines;
+
+        /*!
+         * \brief The words of every SPIR-V file that's been asked for, or nullptr for the ones that couldn't be
+         * opened or aren't SPIR-V
+         */
+        std::unordered_map<std::string, std::unique_ptr<std::vector<uint32_t>>> spirv_files;
+
+        /*!
+         * \brief Gets the lines of the file at the given path, reading it if it hasn't been read yet
+         *
+         * \return The lines of the file, or nullptr if it couldn't be opened
+         */
+        const std::vector<std::string>* get_file_lines(const std::string &path);
+
+        /*!
+         * \brief Gets the SPIR-V words of the file at the given path, reading it if it hasn't been read yet
+         *
+         * \return The file's words, or nullptr if it couldn't be opened or isn't SPIR-V
+         */
+        const std::vector<uint32_t>* get_spirv_words(const std::string &path);
+
+        /*!
+         * \brief Adds the file's lines to the source, pasting the files it includes in place of their #include lines
+         *
+         * \param path The path of the file
+         * \param lines The lines of the file
+         * \param source The source to add the lines to
+         * \param include_stack The files that are being included right now, to catch files that include themselves
+         */
+        void append_file(const std::string &path, const std::vector<std::string> &lines, shader_source &source,
+                         std::vector<std::string> &include_stack);
+    };
+
+    /*!
+     * \brief Checks that the bytes of a .spv file are SPIR-V, and turns them into SPIR-V words
+     *
+     * SPIR-V written on a machine with the other byte order is swapped around, which the SPIR-V spec allows for
+     *
+     * \param bytes The contents of the file
+     * \param words Where to put the words
+     * \return False if the bytes aren't SPIR-V
+     */
+    bool read_spirv(const std::string &bytes, std::vector<uint32_t> &words);
+
+    /*!
+     * \brief Reads the shaderpack's options from shaders.json, as the specialization constants for its SPIR-V shaders
+     *
+     * Options are in an object called options at the top of shaders.json, like
+     *
+     * "options": { "shadowQuality": { "constant_id": 0, "value": 2 } }
+     *
+     * The value can be a bool, an integer, or a float. Whatever type it is, the shaders have to declare the constant
+     * with the same type
+     *
+     * \param shaders_json The shaderpack's shaders.json
+     * \return The specialization constant for each option that could be read
+     */
+    std::vector<specialization_constant> get_specialization_constants(const nlohmann::json &shaders_json);
+
+    /*!
+     * \brief Reads the preprocessor defines the shaderpack declares in shaders.json
+     *
+     * Defines are in an object called defines at the top of shaders.json, like
+     *
+     * "defines": {
+     *     "WAVING_PLANTS": { "default": true },
+     *     "SHADOW_QUALITY": { "values": ["LOW", "MEDIUM", "HIGH"], "default": "HIGH" }
+     * }
+     *
+     * A define without values is a bool, which defaults to false. An enum define defaults to its first value. Names
+     * and values have to be GLSL identifiers
+     *
+     * \param shaders_json The shaderpack's shaders.json
+     * \return Every define that could be read, sorted by name
+     */
+    std::vector<shader_define> get_shader_defines(const nlohmann::json &shaders_json);
+
+    /*!
+     * \brief Works out the #define lines for the variant of a shader with the given define values
+     *
+     * Only the defines that the shader's sources use are in the lines, so changing a define only makes new variants
+     * of the shaders that use it
+     *
+     * \param shader The shader, with its sources loaded
+     * \param defines The shaderpack's defines
+     * \param define_values The value of each define, by name, like the shaderpackDefines setting. Bool defines take
+     * true or false, and enum defines take the name of one of their values. Defines that aren't in here, or have a
+     * value they can't take, get their default value
+     * \return The lines that go after the shader's version line
+     */
+    std::vector<std::string> get_define_lines(const shader_definition &shader, const std::vector<shader_define> &defines,
+                                              const nlohmann::json &define_values);
+
+    /*!
+     * \brief Loads the vertex and fragment sources of a shader in a shaderpack folder
+     *
+     * If the shader has a compute shader file, like composite1.comp, that's loaded instead, and the shader becomes a
+     * compute shader
+     *
+     * \param shaderpack_name The name of the shaderpack the shader is in
+     * \param shader The shader to load. Its vertex_source, fragment_source, and compute_source are replaced
+     * \param includes The resolver to read the shader's files with
+     */
+    void load_shader_sources(const std::string &shaderpack_name, shader_definition &shader, shader_include_resolver &includes);
 
     /*!
      * \brief Determines the full file path of an included file
@@ -80,7 +252,7 @@ namespace nova {
      * \param included_file_name The name of the file to include
      * \return The path to the included file
      */
-    auto get_included_file_path(const std::string &shader_path, const std::string &included_file_name);
+    std::string get_included_file_path(const std::string &shader_path, const std::string &included_file_name);
 
     /*!
      * \brief Extracts the filename from the #include line
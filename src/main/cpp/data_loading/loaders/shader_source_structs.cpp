@@ -3,6 +3,8 @@
  * \date 13-Jun-17.
  */
 
+#include <algorithm>
+#include <cctype>
 #include "shader_source_structs.h"
 #include <easylogging++.h>
 
@@ -18,18 +20,138 @@ namespace nova {
             std::string fallback_name_str = json["fallback"];
             fallback_name = optional<std::string>(fallback_name_str);
         }
+
+        if(json.find("drawbuffers") != json.end()) {
+            drawbuffers = json["drawbuffers"].get<std::vector<unsigned int>>();
+        } else {
+            drawbuffers = {0};
+        }
+
+        if(json.find("reads") != json.end()) {
+            reads = json["reads"].get<std::vector<std::string>>();
+        }
+    }
+
+    bool shader_definition::is_compute() const {
+        return !compute_source.empty();
+    }
+
+    size_t shader_source::size() const {
+        return lines.size();
+    }
+
+    bool shader_source::empty() const {
+        return lines.empty() && spirv.empty();
+    }
+
+    bool shader_source::is_spirv() const {
+        return !spirv.empty();
     }
 
-    el::base::Writer& operator<<(el::base::Writer& out, const std::vector<shader_line>& lines) {
+    const shader_line& shader_source::operator[](size_t idx) const {
+        return lines[idx];
+    }
+
+    const std::string& shader_source::get_file_name(const shader_line& line) const {
+        return files[line.file_index];
+    }
+
+    uint32_t shader_source::get_file_index(const std::string& file_name) {
+        // Shaders only include a handful of files, so a linear search is plenty
+        for(uint32_t i = 0; i < files.size(); i++) {
+            if(files[i] == file_name) {
+                return i;
+            }
+        }
+
+        files.push_back(file_name);
+        return static_cast<uint32_t>(files.size() - 1);
+    }
+
+    /*!
+     * \brief Checks if the character can be part of a GLSL identifier
+     */
+    static bool is_identifier_char(char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+    }
+
+    bool shader_source::uses_identifier(const std::string& identifier) const {
+        if(identifier.empty()) {
+            return false;
+        }
+
         for(const auto& line : lines) {
-            out << line;
+            size_t pos = line.line.find(identifier);
+            while(pos != std::string::npos) {
+                const size_t end = pos + identifier.size();
+                const bool starts_word = pos == 0 || !is_identifier_char(line.line[pos - 1]);
+                const bool ends_word = end == line.line.size() || !is_identifier_char(line.line[end]);
+                if(starts_word && ends_word) {
+                    return true;
+                }
+
+                pos = line.line.find(identifier, pos + 1);
+            }
+        }
+
+        return false;
+    }
+
+    bool shader_define::is_bool() const {
+        return values.empty();
+    }
+
+    bool shader_define::has_value(const std::string& value) const {
+        if(is_bool()) {
+            return value == "true" || value == "false";
+        }
+
+        return std::find(values.begin(), values.end(), value) != values.end();
+    }
+
+    bool shader_define::is_used_by(const shader_source& source) const {
+        if(source.uses_identifier(name)) {
+            return true;
+        }
+
+        for(const auto& value : values) {
+            if(source.uses_identifier(name + "_" + value)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void shader_define::append_lines(const std::string& value, std::vector<std::string>& lines) const {
+        if(is_bool()) {
+            if(value == "true") {
+                lines.push_back("#define " + name);
+            }
+            return;
+        }
+
+        for(size_t i = 0; i < values.size(); i++) {
+            lines.push_back("#define " + name + "_" + values[i] + " " + std::to_string(i));
+        }
+        lines.push_back("#define " + name + " " + name + "_" + value);
+    }
+
+    el::base::Writer& operator<<(el::base::Writer& out, const shader_source& source) {
+        if(source.is_spirv()) {
+            out << "\t" << source.spirv.size() << " SPIR-V words from " << source.files[0] << "\n";
+            return out;
+        }
+
+        for(const auto& line : source.lines) {
+            out << "\t" << line.line_num << "(" << source.get_file_name(line) << ") " << line.line << "\n";
         }
 
         return out;
     }
 
     el::base::Writer& operator<<(el::base::Writer& out, const shader_line& line) {
-        out << "\t" << line.line_num << "(" << line.shader_name << ") " << line.line << "\n";
+        out << "\t" << line.line_num << "(file " << line.file_index << ") " << line.line << "\n";
         return out;
     }
-}
\ No newline at end of file
+}
@@ -8,6 +8,7 @@
 #ifndef RENDERER_SHADER_SOURCE_STRUCTS_H
 #define RENDERER_SHADER_SOURCE_STRUCTS_H
 
+#include <cstdint>
 #include <string>
 #include <memory>
 #include <vector>
@@ -22,17 +23,111 @@ using namespace std::experimental;
 
 namespace nova {
     /*!
-     * \brief Holds a line number and file name
+     * \brief Holds a line number and which file it's from
      *
      * This struct is used to create a map from the line of code in the shader sent to the driver and the line of
-     * code on disk
+     * code on disk. Line i of the shader sent to the driver is the shader_source's line i - 1
      */
     struct shader_line {
         int line_num;               //!< The line number in the original source file
-        std::string shader_name;    //!< The name of the original source file
+        uint32_t file_index;        //!< The index of the original source file in its shader_source's list of files
         std::string line;           //!< The actual line
     };
 
+    /*!
+     * \brief All the lines in a shader, with its includes pasted in, and the names of the files they came from
+     *
+     * Every file is named once, no matter how many lines come from it
+     *
+     * A shader read from a .spv file is already compiled to SPIR-V. It has no lines, just its SPIR-V words and the
+     * name of the file they came from
+     */
+    struct shader_source {
+        std::vector<std::string> files;
+        std::vector<shader_line> lines;
+
+        std::vector<uint32_t> spirv;
+
+        size_t size() const;
+
+        bool empty() const;
+
+        bool is_spirv() const;
+
+        const shader_line& operator[](size_t idx) const;
+
+        /*!
+         * \brief The name of the file the given line came from
+         */
+        const std::string& get_file_name(const shader_line& line) const;
+
+        /*!
+         * \brief Finds the index of the file with the given name, adding it to the list of files if it's not there
+         */
+        uint32_t get_file_index(const std::string& file_name);
+
+        /*!
+         * \brief Checks if any line has the identifier as a whole word, like a macro name in an #ifdef or an #if
+         *
+         * Comments aren't skipped, so a shader that mentions the identifier in one looks like it uses it
+         */
+        bool uses_identifier(const std::string& identifier) const;
+    };
+
+    /*!
+     * \brief A shaderpack option that's baked into its SPIR-V shaders when they're specialized
+     */
+    struct specialization_constant {
+        uint32_t id;        //!< The constant_id the shaders declare the constant with
+        uint32_t value;     //!< The bits of the constant's value. Floats are stored as their bits, bools as 0 or 1
+    };
+
+    /*!
+     * \brief A preprocessor define that a shaderpack declares in shaders.json, so each of its values can be compiled
+     * into its own variant of the shaders that use it
+     *
+     * A bool define is #defined when it's true and left out when it's false, so shaders test it with #ifdef. An enum
+     * define has a list of values. Each value becomes a macro with the define's name, an underscore, and the value's
+     * name, numbered in the order they're listed, and the define is set to the chosen one. SHADOW_QUALITY with the
+     * values LOW and HIGH set to HIGH becomes
+     *
+     * #define SHADOW_QUALITY_LOW 0
+     * #define SHADOW_QUALITY_HIGH 1
+     * #define SHADOW_QUALITY SHADOW_QUALITY_HIGH
+     *
+     * so shaders can write #if SHADOW_QUALITY == SHADOW_QUALITY_HIGH
+     */
+    struct shader_define {
+        std::string name;
+
+        /*!
+         * \brief The values an enum define can have. Empty for a bool define
+         */
+        std::vector<std::string> values;
+
+        /*!
+         * \brief The value the define has when the settings don't pick one. "true" or "false" for a bool define
+         */
+        std::string default_value;
+
+        bool is_bool() const;
+
+        /*!
+         * \brief Checks if the value is one this define can have
+         */
+        bool has_value(const std::string& value) const;
+
+        /*!
+         * \brief Checks if any of the define's macros are used in the source
+         */
+        bool is_used_by(const shader_source& source) const;
+
+        /*!
+         * \brief Adds the #define lines for the given value, which has to be one of the define's values
+         */
+        void append_lines(const std::string& value, std::vector<std::string>& lines) const;
+    };
+
     /*!
      * \brief Represents a shader before it goes to the GPU
      */
@@ -43,19 +138,63 @@ namespace nova {
 
         optional<std::shared_ptr<shader_definition>> fallback_def;
 
-        std::vector<shader_line> vertex_source;
-        std::vector<shader_line> fragment_source;
+        shader_source vertex_source;
+        shader_source fragment_source;
         // TODO: Figure out how to handle geometry and tessellation shaders
 
         /*!
-         * \brief The framebuffer attachments that this shader writes to
+         * \brief The compute shader, for fullscreen passes that write their outputs with image stores. A shader with a
+         * compute source has no vertex or fragment source
+         */
+        shader_source compute_source;
+
+        /*!
+         * \brief The framebuffer attachments that this shader writes to. Fragment output i goes to attachment
+         * drawbuffers[i]. Defaults to just attachment 0
          */
         std::vector<unsigned int> drawbuffers;
 
+        /*!
+         * \brief The names of the attachments that this shader samples from, like "colortex0" or "depthtex0"
+         *
+         * A composite shader that doesn't list any is taken to read every colortex drawn before it, since it would
+         * otherwise have every pass before it culled
+         */
+        std::vector<std::string> reads;
+
+        /*!
+         * \brief The values of the shaderpack's options, for the SPIR-V shaders to be specialized with. GLSL shaders
+         * don't use these
+         */
+        std::vector<specialization_constant> specialization_constants;
+
+        /*!
+         * \brief The #define lines that go right after the version line of each GLSL shader, for the shaderpack's
+         * defines that this shader uses. Every different set of lines is its own variant of the shader
+         */
+        std::vector<std::string> define_lines;
+
         shader_definition(nlohmann::json &json);
+
+        bool is_compute() const;
+    };
+
+    /*!
+     * \brief Everything read from a shaderpack's files, before anything is sent to the GPU
+     */
+    struct shaderpack_sources {
+        std::string name;
+        nlohmann::json shaders_json;
+
+        /*!
+         * \brief The shaders that could be read, with their includes already pasted in
+         */
+        std::vector<shader_definition> shaders;
+
+        std::string program_cache_directory;
     };
 
-    el::base::Writer& operator<<(el::base::Writer& out, const std::vector<shader_line>& lines);
+    el::base::Writer& operator<<(el::base::Writer& out, const shader_source& source);
 
     el::base::Writer& operator<<(el::base::Writer& out, const shader_line& line);
 }
@@ -0,0 +1,203 @@
+/*!
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include <algorithm>
+#include <thread>
+#include <easylogging++.h>
+
+#define MINIZ_HEADER_FILE_ONLY
+#include "miniz.c"
+
+#include "shaderpack_archive.h"
+#include "../../utils/thread_pool.h"
+#include "../../utils/utils.h"
+
+namespace nova {
+    /*!
+     * \brief Decompresses one file from the zip
+     *
+     * \return False if the file couldn't be decompressed
+     */
+    static bool extract_file(mz_zip_archive* zip, uint32_t file_index, std::string& contents) {
+        size_t size = 0;
+        void* data = mz_zip_reader_extract_to_heap(zip, file_index, &size, 0);
+        if(data == nullptr) {
+            return false;
+        }
+
+        contents.assign(static_cast<const char*>(data), size);
+        mz_free(data);
+        return true;
+    }
+
+    shaderpack_archive::shaderpack_archive(const std::string& zip_path, const std::string& root_path) :
+            file(zip_path), root_path(root_path), zip(std::make_unique<mz_zip_archive>()) {
+        if(!file.is_open() || file.get_size() == 0) {
+            LOG(ERROR) << "Could not open zip file " << zip_path;
+            return;
+        }
+
+        if(!mz_zip_reader_init_mem(zip.get(), file.get_data(), file.get_size(), 0)) {
+            LOG(ERROR) << zip_path << " isn't a zip file, or it's damaged";
+            return;
+        }
+        open = true;
+
+        const uint32_t num_entries = mz_zip_reader_get_num_files(zip.get());
+        std::vector<std::string> entry_names(num_entries);
+        for(uint32_t i = 0; i < num_entries; i++) {
+            mz_zip_archive_file_stat stat;
+            if(mz_zip_reader_file_stat(zip.get(), i, &stat) && !mz_zip_reader_is_file_a_directory(zip.get(), i)) {
+                entry_names[i] = stat.m_filename;
+            }
+        }
+
+        const std::string pack_folder = find_pack_folder(entry_names);
+        for(uint32_t i = 0; i < num_entries; i++) {
+            const std::string& name = entry_names[i];
+            if(!name.empty() && name.compare(0, pack_folder.size(), pack_folder) == 0) {
+                files.emplace(root_path + name.substr(pack_folder.size()), i);
+            }
+        }
+
+        LOG(INFO) << "Opened zip file " << zip_path << " with " << files.size() << " files";
+    }
+
+    shaderpack_archive::~shaderpack_archive() {
+        if(open) {
+            mz_zip_reader_end(zip.get());
+        }
+    }
+
+    bool shaderpack_archive::is_open() const {
+        return open;
+    }
+
+    bool shaderpack_archive::has_file(const std::string& path) const {
+        return files.find(normalize_path(path)) != files.end();
+    }
+
+    bool shaderpack_archive::read_file(const std::string& path, std::string& contents) {
+        auto entry = files.find(normalize_path(path));
+        if(entry == files.end()) {
+            return false;
+        }
+
+        if(!extract_file(zip.get(), entry->second, contents)) {
+            LOG(ERROR) << "Could not decompress " << path;
+            return false;
+        }
+
+        return true;
+    }
+
+    std::unordered_map<std::string, std::string> shaderpack_archive::read_files(const std::string& prefix) const {
+        std::vector<std::pair<std::string, uint32_t>> entries;
+        for(const auto& entry : files) {
+            if(entry.first.compare(0, prefix.size(), prefix) == 0) {
+                entries.push_back(entry);
+            }
+        }
+
+        std::vector<std::string> contents(entries.size());
+        std::vector<uint8_t> extracted(entries.size(), 0);
+        if(!entries.empty()) {
+            const auto num_threads = static_cast<unsigned int>(std::min<size_t>(
+                    std::max(1u, std::thread::hardware_concurrency()), entries.size()));
+
+            // The pool's destructor waits for every task to finish. Each thread gets its own zip reader over the
+            // mapped file, since a reader can't be shared between threads
+            thread_pool workers(num_threads, "shaderpack_unzip");
+            for(unsigned int thread = 0; thread < num_threads; thread++) {
+                workers.add_task([&, thread]() {
+                    mz_zip_archive thread_zip = {};
+                    if(!mz_zip_reader_init_mem(&thread_zip, file.get_data(), file.get_size(), 0)) {
+                        return;
+                    }
+
+                    for(size_t i = thread; i < entries.size(); i += num_threads) {
+                        std::string file_contents;
+                        if(extract_file(&thread_zip, entries[i].second, file_contents)) {
+                            contents[i] = std::move(file_contents);
+                            extracted[i] = 1;
+                        }
+                    }
+
+                    mz_zip_reader_end(&thread_zip);
+                });
+            }
+        }
+
+        std::unordered_map<std::string, std::string> files_read;
+        for(size_t i = 0; i < entries.size(); i++) {
+            if(extracted[i]) {
+                files_read.emplace(entries[i].first, std::move(contents[i]));
+            } else {
+                LOG(ERROR) << "Could not decompress " << entries[i].first;
+            }
+        }
+
+        return files_read;
+    }
+
+    std::string shaderpack_archive::find_pack_folder(const std::vector<std::string>& entry_names) {
+        bool found_pack = false;
+        std::string pack_folder;
+        for(const auto& name : entry_names) {
+            size_t folder_end = std::string::npos;
+            if(name.size() >= 12 && name.compare(name.size() - 12, 12, "shaders.json") == 0) {
+                folder_end = name.size() - 12;
+
+            } else {
+                const size_t shaders_pos = name.find("shaders/");
+                if(shaders_pos != std::string::npos) {
+                    folder_end = shaders_pos;
+                }
+            }
+
+            // Only count whole folder names, so something like myshaders/ isn't mistaken for the shaders folder
+            if(folder_end == std::string::npos || (folder_end != 0 && name[folder_end - 1] != '/')) {
+                continue;
+            }
+
+            // The shallowest folder wins, in case the pack has a folder named shaders deeper inside it
+            if(!found_pack || folder_end < pack_folder.size()) {
+                pack_folder = name.substr(0, folder_end);
+                found_pack = true;
+            }
+        }
+
+        return pack_folder;
+    }
+
+    std::string shaderpack_archive::normalize_path(const std::string& path) {
+        std::vector<std::string> parts;
+        for(const auto& part : split(path, '/')) {
+            if(part.empty() || part == ".") {
+                continue;
+
+            } else if(part == ".." && !parts.empty() && parts.back() != "..") {
+                parts.pop_back();
+
+            } else {
+                parts.push_back(part);
+            }
+        }
+
+        std::string normalized;
+        for(const auto& part : parts) {
+            if(!normalized.empty()) {
+                normalized += '/';
+            }
+            normalized += part;
+        }
+
+        if(!path.empty() && path.back() == '/') {
+            normalized += '/';
+        }
+
+        return normalized;
+    }
+}
@@ -0,0 +1,98 @@
+/*!
+ * \brief Reads the files in a zipped shaderpack without unzipping it to disk
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#ifndef RENDERER_SHADERPACK_ARCHIVE_H
+#define RENDERER_SHADERPACK_ARCHIVE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../../utils/mapped_file.h"
+
+struct mz_zip_archive_tag;
+
+namespace nova {
+    /*!
+     * \brief A zipped shaderpack, with its files found by the paths they'd have if the zip was unzipped in place
+     *
+     * The zip is memory mapped, so only the parts of it that are read come off the disk, and a file is only
+     * decompressed when it's asked for. Files are looked up by paths like shaderpacks/pack.zip/shaders/final.fsh, the
+     * same paths the shader loader uses for a shaderpack folder, so shader sources and #include paths work the same
+     * for both. Lots of zips have everything inside a folder named after the pack. That folder is skipped, so
+     * pack.zip/PackName/shaders/final.fsh is found at shaderpacks/pack.zip/shaders/final.fsh
+     *
+     * #has_file and #read_file share one zip reader, so they must only be called from one thread at a time.
+     * #read_files makes a reader for each of its threads
+     */
+    class shaderpack_archive {
+    public:
+        /*!
+         * \brief Maps the zip file and reads its list of files. If that fails, #is_open returns false
+         *
+         * \param zip_path The path of the zip file
+         * \param root_path The path the zip's files are found under, like shaderpacks/pack.zip/
+         */
+        shaderpack_archive(const std::string& zip_path, const std::string& root_path);
+
+        shaderpack_archive(const shaderpack_archive&) = delete;
+        shaderpack_archive& operator=(const shaderpack_archive&) = delete;
+
+        ~shaderpack_archive();
+
+        bool is_open() const;
+
+        bool has_file(const std::string& path) const;
+
+        /*!
+         * \brief Decompresses a single file
+         *
+         * \param path The path of the file, under the root path
+         * \param contents Where to put the file's contents
+         * \return False if the zip doesn't have the file or it couldn't be decompressed
+         */
+        bool read_file(const std::string& path, std::string& contents);
+
+        /*!
+         * \brief Decompresses every file whose path starts with the given prefix, spread across a few threads
+         *
+         * \param prefix The start of the paths to read, like shaderpacks/pack.zip/shaders/
+         * \return The contents of each file that was decompressed, by path
+         */
+        std::unordered_map<std::string, std::string> read_files(const std::string& prefix) const;
+
+        /*!
+         * \brief Finds where the shaderpack starts inside the zip's list of file names
+         *
+         * \param entry_names The names of every file in the zip
+         * \return The folder the shaderpack's shaders folder or shaders.json is in, with a trailing slash, or an empty
+         * string if they're at the top of the zip
+         */
+        static std::string find_pack_folder(const std::vector<std::string>& entry_names);
+
+        /*!
+         * \brief Takes out the . and .. parts of a path, so included files can be looked up in the zip
+         */
+        static std::string normalize_path(const std::string& path);
+
+    private:
+        mapped_file file;
+        std::string root_path;
+
+        std::unique_ptr<mz_zip_archive_tag> zip;
+
+        /*!
+         * \brief The zip's file index for each file, by the path it's found at
+         */
+        std::unordered_map<std::string, uint32_t> files;
+
+        bool open = false;
+    };
+}
+
+#endif //RENDERER_SHADERPACK_ARCHIVE_H
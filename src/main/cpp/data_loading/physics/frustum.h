@@ -0,0 +1,24 @@
+/*!
+ * \brief
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_FRUSTUM_H
+#define RENDERER_FRUSTUM_H
+
+namespace nova {
+    /*!
+     * \brief The six planes of a view frustum
+     *
+     * Each plane is stored as (a, b, c, d), with the normal (a, b, c) normalized and pointing into the frustum, so a
+     * point p is on the inside of a plane when dot(normal, p) + d > 0. The planes are in the order right, left,
+     * bottom, top, far, near
+     */
+    struct frustum {
+        float planes[6][4];
+    };
+}
+
+#endif //RENDERER_FRUSTUM_H
@@ -6,6 +6,7 @@
 #include "settings.h"
 #include "../utils/utils.h"
 
+#include <unordered_set>
 #include <easylogging++.h>
 
 namespace nova {
@@ -16,26 +17,92 @@ namespace nova {
 		if(config_file.is_open()) {
 			options = load_json_from_stream(config_file);
 		}
+        rebuild_snapshot();
     }
 
-    void settings::register_change_listener(iconfig_listener *new_listener) {
-        config_change_listeners.push_back(new_listener);
+    void settings::register_change_listener(iconfig_listener *new_listener, std::vector<std::string> keys) {
+        config_change_listeners.push_back({new_listener, std::move(keys)});
     }
 
     nlohmann::json &settings::get_options() {
         return options;
     }
 
+    const settings_snapshot& settings::get_snapshot() const {
+        return snapshot;
+    }
+
+    /*!
+     * \brief Finds the names of the settings that are different between the old and new settings, including ones that
+     * were added or removed
+     */
+    static std::unordered_set<std::string> get_changed_keys(const nlohmann::json& old_settings, const nlohmann::json& new_settings) {
+        std::unordered_set<std::string> changed_keys;
+        for(auto itr = new_settings.begin(); itr != new_settings.end(); ++itr) {
+            auto old_value = old_settings.find(itr.key());
+            if(old_value == old_settings.end() || *old_value != itr.value()) {
+                changed_keys.insert(itr.key());
+            }
+        }
+
+        for(auto itr = old_settings.begin(); itr != old_settings.end(); ++itr) {
+            if(new_settings.find(itr.key()) == new_settings.end()) {
+                changed_keys.insert(itr.key());
+            }
+        }
+
+        return changed_keys;
+    }
+
     void settings::update_config_changed() {
-        for(iconfig_listener *l : config_change_listeners) {
-            l->on_config_change(options["settings"]);
+        nlohmann::json& current_settings = options["settings"];
+        if(!current_settings.is_object()) {
+            LOG(WARNING) << "The settings aren't a JSON object, so nobody can be told about them";
+            return;
+        }
+
+        const nlohmann::json old_settings = last_sent_settings.is_object() ? last_sent_settings : nlohmann::json::object();
+        auto changed_keys = get_changed_keys(old_settings, current_settings);
+        if(changed_keys.empty()) {
+            return;
+        }
+
+        last_sent_settings = current_settings;
+        rebuild_snapshot();
+
+        for(auto& registration : config_change_listeners) {
+            bool cares_about_change = registration.keys.empty();
+            for(const auto& key : registration.keys) {
+                if(changed_keys.find(key) != changed_keys.end()) {
+                    cares_about_change = true;
+                    break;
+                }
+            }
+
+            if(cares_about_change) {
+                registration.listener->on_config_change(current_settings);
+            }
         }
-        LOG(DEBUG) << "Finished updating listeners";
+        LOG(DEBUG) << "Finished updating listeners about " << changed_keys.size() << " changed settings";
+    }
+
+    void settings::rebuild_snapshot() {
+        const nlohmann::json& current_settings = options["settings"];
+        if(!current_settings.is_object()) {
+            return;
+        }
+
+        snapshot.loaded_shaderpack = current_settings.value("loadedShaderpack", snapshot.loaded_shaderpack);
+        snapshot.view_width = current_settings.value("viewWidth", snapshot.view_width);
+        snapshot.view_height = current_settings.value("viewHeight", snapshot.view_height);
+        snapshot.scalefactor = current_settings.value("scalefactor", snapshot.scalefactor);
+        snapshot.shadow_map_resolution = current_settings.value("shadowMapResolution", snapshot.shadow_map_resolution);
+        snapshot.shadow_distance = current_settings.value("shadowDistance", snapshot.shadow_distance);
     }
 
     void settings::update_config_loaded() {
-        for(iconfig_listener *l : config_change_listeners) {
-            l->on_config_loaded(options["readOnly"]);
+        for(auto& registration : config_change_listeners) {
+            registration.listener->on_config_loaded(options["readOnly"]);
         }
     }
 }
@@ -46,6 +46,20 @@ namespace nova {
         virtual void on_config_loaded(nlohmann::json &config) = 0;
     };
 
+    /*!
+     * \brief The settings that are read while rendering, pulled out of the JSON so reading them is just a field access
+     *
+     * Rebuilt whenever the settings change
+     */
+    struct settings_snapshot {
+        std::string loaded_shaderpack;
+        unsigned int view_width = 0;
+        unsigned int view_height = 0;
+        float scalefactor = 1;
+        unsigned int shadow_map_resolution = 1024;
+        float shadow_distance = 128;
+    };
+
     /*!
      * \brief Holds the configuration of Nova
      *
@@ -63,11 +77,20 @@ namespace nova {
 
         /*!
          * \brief Registers the given iconfig_change_listener as an Observer
+         *
+         * \param new_listener The listener to tell about changes
+         * \param keys The settings the listener cares about. It's only told about changes to one of these. If this is
+         * empty, the listener is told about every change
          */
-        void register_change_listener(iconfig_listener *new_listener);
+        void register_change_listener(iconfig_listener *new_listener, std::vector<std::string> keys = {});
 
         nlohmann::json &get_options();
 
+        /*!
+         * \brief The hot settings as of the last call to #update_config_changed
+         */
+        const settings_snapshot& get_snapshot() const;
+
         /*!
          * \brief Updates all the change listeners with the current state of the settings
          *
@@ -75,6 +98,9 @@ namespace nova {
          * are pretty computationally intensive to change, the update listeners after all the values are changed
          *
          * Note that this method only send the read-write config values (children of the node 'settings') to the listeners
+         *
+         * Only the listeners that care about one of the settings that changed since last time are updated, so this does
+         * nothing if nothing changed
          */
         void update_config_changed();
 
@@ -84,8 +110,22 @@ namespace nova {
         void update_config_loaded();
 
     private:
+        struct listener_registration {
+            iconfig_listener *listener;
+            std::vector<std::string> keys;
+        };
+
         nlohmann::json options;
-        std::vector<iconfig_listener *> config_change_listeners;
+        std::vector<listener_registration> config_change_listeners;
+
+        /*!
+         * \brief The settings as they were the last time listeners were updated, so we know what changed
+         */
+        nlohmann::json last_sent_settings;
+
+        settings_snapshot snapshot;
+
+        void rebuild_snapshot();
     };
 }
 
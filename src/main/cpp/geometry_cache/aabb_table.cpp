@@ -0,0 +1,180 @@
+/*!
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <cmath>
+#include "aabb_table.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define NOVA_CULL_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <xmmintrin.h>
+#define NOVA_CULL_SSE
+#endif
+
+namespace nova {
+    void aabb_table::push_back(const aabb& box) {
+        center_x.push_back(box.center.x);
+        center_y.push_back(box.center.y);
+        center_z.push_back(box.center.z);
+
+        extent_x.push_back(box.extents.x);
+        extent_y.push_back(box.extents.y);
+        extent_z.push_back(box.extents.z);
+    }
+
+    void aabb_table::set(size_t index, const aabb& box) {
+        center_x[index] = box.center.x;
+        center_y[index] = box.center.y;
+        center_z[index] = box.center.z;
+
+        extent_x[index] = box.extents.x;
+        extent_y[index] = box.extents.y;
+        extent_z[index] = box.extents.z;
+    }
+
+    void aabb_table::copy(size_t from, size_t to) {
+        center_x[to] = center_x[from];
+        center_y[to] = center_y[from];
+        center_z[to] = center_z[from];
+
+        extent_x[to] = extent_x[from];
+        extent_y[to] = extent_y[from];
+        extent_z[to] = extent_z[from];
+    }
+
+    void aabb_table::resize(size_t new_size) {
+        center_x.resize(new_size, 0);
+        center_y.resize(new_size, 0);
+        center_z.resize(new_size, 0);
+
+        extent_x.resize(new_size, 0);
+        extent_y.resize(new_size, 0);
+        extent_z.resize(new_size, 0);
+    }
+
+    size_t aabb_table::size() const {
+        return center_x.size();
+    }
+
+    void aabb_table::cull(const frustum& view_frustum, std::vector<uint32_t>& visible_indices) const {
+        visible_indices.clear();
+        const size_t count = size();
+        size_t i = 0;
+
+#if defined(NOVA_CULL_AVX)
+        __m256 plane_broadcasts[6][7];
+        for(int p = 0; p < 6; p++) {
+            const float* plane = view_frustum.planes[p];
+            plane_broadcasts[p][0] = _mm256_set1_ps(plane[0]);
+            plane_broadcasts[p][1] = _mm256_set1_ps(plane[1]);
+            plane_broadcasts[p][2] = _mm256_set1_ps(plane[2]);
+            plane_broadcasts[p][3] = _mm256_set1_ps(plane[3]);
+            plane_broadcasts[p][4] = _mm256_set1_ps(std::fabs(plane[0]));
+            plane_broadcasts[p][5] = _mm256_set1_ps(std::fabs(plane[1]));
+            plane_broadcasts[p][6] = _mm256_set1_ps(std::fabs(plane[2]));
+        }
+
+        const __m256 zero = _mm256_setzero_ps();
+        for(; i + 8 <= count; i += 8) {
+            const __m256 cx = _mm256_loadu_ps(&center_x[i]);
+            const __m256 cy = _mm256_loadu_ps(&center_y[i]);
+            const __m256 cz = _mm256_loadu_ps(&center_z[i]);
+            const __m256 ex = _mm256_loadu_ps(&extent_x[i]);
+            const __m256 ey = _mm256_loadu_ps(&extent_y[i]);
+            const __m256 ez = _mm256_loadu_ps(&extent_z[i]);
+
+            int visible_mask = 0xFF;
+            for(int p = 0; p < 6 && visible_mask != 0; p++) {
+                const __m256* plane = plane_broadcasts[p];
+
+                // Signed distance of the p-vertex: dot(normal, center) + d + dot(abs(normal), extents)
+                __m256 dist = _mm256_add_ps(_mm256_mul_ps(plane[0], cx), _mm256_mul_ps(plane[1], cy));
+                dist = _mm256_add_ps(dist, _mm256_mul_ps(plane[2], cz));
+                dist = _mm256_add_ps(dist, plane[3]);
+                dist = _mm256_add_ps(dist, _mm256_mul_ps(plane[4], ex));
+                dist = _mm256_add_ps(dist, _mm256_mul_ps(plane[5], ey));
+                dist = _mm256_add_ps(dist, _mm256_mul_ps(plane[6], ez));
+
+                visible_mask &= _mm256_movemask_ps(_mm256_cmp_ps(dist, zero, _CMP_GT_OQ));
+            }
+
+            for(int bit = 0; bit < 8; bit++) {
+                if(visible_mask & (1 << bit)) {
+                    visible_indices.push_back(static_cast<uint32_t>(i + bit));
+                }
+            }
+        }
+
+#elif defined(NOVA_CULL_SSE)
+        __m128 plane_broadcasts[6][7];
+        for(int p = 0; p < 6; p++) {
+            const float* plane = view_frustum.planes[p];
+            plane_broadcasts[p][0] = _mm_set1_ps(plane[0]);
+            plane_broadcasts[p][1] = _mm_set1_ps(plane[1]);
+            plane_broadcasts[p][2] = _mm_set1_ps(plane[2]);
+            plane_broadcasts[p][3] = _mm_set1_ps(plane[3]);
+            plane_broadcasts[p][4] = _mm_set1_ps(std::fabs(plane[0]));
+            plane_broadcasts[p][5] = _mm_set1_ps(std::fabs(plane[1]));
+            plane_broadcasts[p][6] = _mm_set1_ps(std::fabs(plane[2]));
+        }
+
+        const __m128 zero = _mm_setzero_ps();
+        for(; i + 4 <= count; i += 4) {
+            const __m128 cx = _mm_loadu_ps(&center_x[i]);
+            const __m128 cy = _mm_loadu_ps(&center_y[i]);
+            const __m128 cz = _mm_loadu_ps(&center_z[i]);
+            const __m128 ex = _mm_loadu_ps(&extent_x[i]);
+            const __m128 ey = _mm_loadu_ps(&extent_y[i]);
+            const __m128 ez = _mm_loadu_ps(&extent_z[i]);
+
+            int visible_mask = 0xF;
+            for(int p = 0; p < 6 && visible_mask != 0; p++) {
+                const __m128* plane = plane_broadcasts[p];
+
+                // Signed distance of the p-vertex: dot(normal, center) + d + dot(abs(normal), extents)
+                __m128 dist = _mm_add_ps(_mm_mul_ps(plane[0], cx), _mm_mul_ps(plane[1], cy));
+                dist = _mm_add_ps(dist, _mm_mul_ps(plane[2], cz));
+                dist = _mm_add_ps(dist, plane[3]);
+                dist = _mm_add_ps(dist, _mm_mul_ps(plane[4], ex));
+                dist = _mm_add_ps(dist, _mm_mul_ps(plane[5], ey));
+                dist = _mm_add_ps(dist, _mm_mul_ps(plane[6], ez));
+
+                visible_mask &= _mm_movemask_ps(_mm_cmpgt_ps(dist, zero));
+            }
+
+            for(int bit = 0; bit < 4; bit++) {
+                if(visible_mask & (1 << bit)) {
+                    visible_indices.push_back(static_cast<uint32_t>(i + bit));
+                }
+            }
+        }
+#endif
+
+        // Whatever didn't fill a whole register
+        cull_scalar_range(view_frustum, i, visible_indices);
+    }
+
+    void aabb_table::cull_scalar(const frustum& view_frustum, std::vector<uint32_t>& visible_indices) const {
+        visible_indices.clear();
+        cull_scalar_range(view_frustum, 0, visible_indices);
+    }
+
+    void aabb_table::cull_scalar_range(const frustum& view_frustum, size_t first, std::vector<uint32_t>& visible_indices) const {
+        for(size_t i = first; i < size(); i++) {
+            bool visible = true;
+            for(int p = 0; p < 6 && visible; p++) {
+                const float* plane = view_frustum.planes[p];
+                float dist = plane[0] * center_x[i] + plane[1] * center_y[i] + plane[2] * center_z[i] + plane[3]
+                           + std::fabs(plane[0]) * extent_x[i] + std::fabs(plane[1]) * extent_y[i] + std::fabs(plane[2]) * extent_z[i];
+                visible = dist > 0;
+            }
+
+            if(visible) {
+                visible_indices.push_back(static_cast<uint32_t>(i));
+            }
+        }
+    }
+}
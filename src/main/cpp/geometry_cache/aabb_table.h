@@ -0,0 +1,80 @@
+/*!
+ * \brief A structure-of-arrays table of bounding boxes that can be culled against a frustum several boxes at a time
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_AABB_TABLE_H
+#define RENDERER_AABB_TABLE_H
+
+#include <cstdint>
+#include <vector>
+#include "../data_loading/physics/aabb.h"
+#include "../data_loading/physics/frustum.h"
+
+namespace nova {
+    /*!
+     * \brief Holds the bounding boxes for a list of render objects, with each component in its own array
+     *
+     * Keeping the components apart lets the culling code load the same component of eight (AVX) or four (SSE) boxes
+     * into one register. Boxes are tested in center/extents form: a box is outside a plane when even its corner
+     * farthest along the plane normal (the "p-vertex") is behind the plane. That gives the same answer as testing all
+     * eight corners, which is what camera::has_object_in_frustum does, in one evaluation per plane
+     *
+     * Entry i of the table is the bounding box of entry i of whatever list it belongs to, so callers must keep the two
+     * in sync
+     */
+    class aabb_table {
+    public:
+        void push_back(const aabb& box);
+
+        /*!
+         * \brief Overwrites the box at the given index
+         */
+        void set(size_t index, const aabb& box);
+
+        /*!
+         * \brief Copies the box at index `from` over the box at index `to`
+         */
+        void copy(size_t from, size_t to);
+
+        /*!
+         * \brief Shrinks or grows the table to the given size. New boxes are zero-sized boxes at the origin
+         */
+        void resize(size_t new_size);
+
+        size_t size() const;
+
+        /*!
+         * \brief Finds the boxes that are at least partially inside the given frustum
+         *
+         * Uses AVX or SSE when the compiler has them available, falling back to cull_scalar otherwise
+         *
+         * \param view_frustum The frustum to test against
+         * \param visible_indices Cleared, then filled with the indices of all visible boxes in ascending order
+         */
+        void cull(const frustum& view_frustum, std::vector<uint32_t>& visible_indices) const;
+
+        /*!
+         * \brief Does the same thing as cull, one box at a time
+         */
+        void cull_scalar(const frustum& view_frustum, std::vector<uint32_t>& visible_indices) const;
+
+    private:
+        std::vector<float> center_x;
+        std::vector<float> center_y;
+        std::vector<float> center_z;
+
+        std::vector<float> extent_x;
+        std::vector<float> extent_y;
+        std::vector<float> extent_z;
+
+        /*!
+         * \brief Tests the boxes in [first, size()) one at a time and adds the visible ones to visible_indices
+         */
+        void cull_scalar_range(const frustum& view_frustum, size_t first, std::vector<uint32_t>& visible_indices) const;
+    };
+}
+
+#endif //RENDERER_AABB_TABLE_H
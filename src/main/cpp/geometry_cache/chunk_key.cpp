@@ -0,0 +1,28 @@
+/*!
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <cmath>
+#include <functional>
+#include "chunk_key.h"
+
+namespace nova {
+    chunk_key::chunk_key(const glm::vec3& position, int id) : id(id) {
+        auto section_x = static_cast<int64_t>(std::floor(position.x / 16.0f));
+        auto section_y = static_cast<int64_t>(std::floor(position.y / 16.0f));
+        auto section_z = static_cast<int64_t>(std::floor(position.z / 16.0f));
+
+        packed_section = (static_cast<uint64_t>(section_x & 0x3FFFFF) << 42) |
+                         (static_cast<uint64_t>(section_z & 0x3FFFFF) << 20) |
+                          static_cast<uint64_t>(section_y & 0xFFFFF);
+    }
+
+    bool chunk_key::operator==(const chunk_key& other) const {
+        return packed_section == other.packed_section && id == other.id;
+    }
+
+    size_t chunk_key_hash::operator()(const chunk_key& key) const {
+        return std::hash<uint64_t>()(key.packed_section) ^ (std::hash<int>()(key.id) * 31);
+    }
+}
@@ -0,0 +1,36 @@
+/*!
+ * \brief A key for finding a chunk section's geometry
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_CHUNK_KEY_H
+#define RENDERER_CHUNK_KEY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+namespace nova {
+    /*!
+     * \brief Identifies a chunk section's geometry within a filter
+     *
+     * The section's coordinates (its position divided by 16) are packed into one integer, with 22 bits each for x and
+     * z and 20 bits for y
+     */
+    struct chunk_key {
+        uint64_t packed_section;
+        int id;
+
+        chunk_key(const glm::vec3& position, int id);
+
+        bool operator==(const chunk_key& other) const;
+    };
+
+    struct chunk_key_hash {
+        size_t operator()(const chunk_key& key) const;
+    };
+}
+
+#endif //RENDERER_CHUNK_KEY_H
@@ -0,0 +1,121 @@
+/*!
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+#include "chunk_lod.h"
+
+namespace nova {
+    /*!
+     * \brief Packs a grid point into one integer, with 21 bits for each axis
+     */
+    static uint64_t pack_grid_point(const glm::ivec3& point) {
+        const uint64_t mask = (1 << 21) - 1;
+        return ((static_cast<uint64_t>(point.x) & mask) << 42) |
+               ((static_cast<uint64_t>(point.y) & mask) << 21) |
+               (static_cast<uint64_t>(point.z) & mask);
+    }
+
+    /*!
+     * \brief Packs a triangle's indices into one integer, smallest first so that the winding doesn't matter
+     */
+    static uint64_t pack_triangle(int a, int b, int c) {
+        int sorted[3] = {a, b, c};
+        std::sort(sorted, sorted + 3);
+        const uint64_t mask = (1 << 21) - 1;
+        return ((static_cast<uint64_t>(sorted[0]) & mask) << 42) |
+               ((static_cast<uint64_t>(sorted[1]) & mask) << 21) |
+               (static_cast<uint64_t>(sorted[2]) & mask);
+    }
+
+    void simplify_chunk_mesh(const std::vector<int>& mc_vertex_data, const std::vector<int>& indices, float cell_size,
+                             std::vector<int>& lod_vertex_data, std::vector<int>& lod_indices) {
+        const size_t num_vertices = mc_vertex_data.size() / 7;
+        lod_vertex_data.clear();
+        lod_indices.clear();
+
+        // Which new vertex each old vertex turned into
+        std::vector<int> remapped_vertices(num_vertices);
+        std::unordered_map<uint64_t, int> vertex_for_grid_point;
+
+        for(size_t i = 0; i < num_vertices; i++) {
+            const int* mc_vertex = &mc_vertex_data[i * 7];
+
+            float position[3];
+            std::memcpy(position, mc_vertex, sizeof(position));
+
+            const glm::ivec3 grid_point(std::lround(position[0] / cell_size), std::lround(position[1] / cell_size),
+                                        std::lround(position[2] / cell_size));
+
+            auto new_vertex = vertex_for_grid_point.emplace(pack_grid_point(grid_point), 0);
+            if(new_vertex.second) {
+                new_vertex.first->second = static_cast<int>(lod_vertex_data.size() / 7);
+
+                const float snapped_position[3] = {grid_point.x * cell_size, grid_point.y * cell_size, grid_point.z * cell_size};
+                const size_t first_int = lod_vertex_data.size();
+                lod_vertex_data.insert(lod_vertex_data.end(), mc_vertex, mc_vertex + 7);
+                std::memcpy(&lod_vertex_data[first_int], snapped_position, sizeof(snapped_position));
+            }
+
+            remapped_vertices[i] = new_vertex.first->second;
+        }
+
+        std::unordered_set<uint64_t> kept_triangles;
+        for(size_t i = 0; i + 2 < indices.size(); i += 3) {
+            if(indices[i] < 0 || indices[i + 1] < 0 || indices[i + 2] < 0 ||
+               static_cast<size_t>(std::max({indices[i], indices[i + 1], indices[i + 2]})) >= num_vertices) {
+                continue;
+            }
+
+            const int a = remapped_vertices[indices[i]];
+            const int b = remapped_vertices[indices[i + 1]];
+            const int c = remapped_vertices[indices[i + 2]];
+            if(a == b || b == c || a == c) {
+                continue;
+            }
+
+            if(kept_triangles.insert(pack_triangle(a, b, c)).second) {
+                lod_indices.push_back(a);
+                lod_indices.push_back(b);
+                lod_indices.push_back(c);
+            }
+        }
+    }
+
+    float get_screen_size(const aabb& bounding_box, const glm::vec3& camera_position, float fov) {
+        const float radius = glm::length(bounding_box.extents);
+        const float distance = glm::length(bounding_box.center - camera_position);
+        if(distance <= radius) {
+            return 2;
+        }
+
+        const float half_fov_tangent = std::tan(glm::radians(fov) * 0.5f);
+        return radius / (distance * half_fov_tangent);
+    }
+
+    uint32_t select_chunk_lod(float screen_size, uint32_t current_lod, uint32_t num_lods, const chunk_lod_settings& settings) {
+        if(num_lods <= 1) {
+            return 0;
+        }
+
+        // Level n switches to level n + 1 at threshold / 2^n
+        auto threshold_after = [&](uint32_t lod) {
+            return settings.screen_size_threshold / static_cast<float>(1 << lod);
+        };
+
+        uint32_t lod = std::min(current_lod, num_lods - 1);
+        while(lod + 1 < num_lods && screen_size < threshold_after(lod) * (1 - settings.hysteresis)) {
+            lod++;
+        }
+        while(lod > 0 && screen_size > threshold_after(lod - 1) * (1 + settings.hysteresis)) {
+            lod--;
+        }
+
+        return lod;
+    }
+}
@@ -0,0 +1,84 @@
+/*!
+ * \brief Builds simplified meshes for far away chunk sections, and decides which level of detail to draw
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_CHUNK_LOD_H
+#define RENDERER_CHUNK_LOD_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "../data_loading/physics/aabb.h"
+
+namespace nova {
+    /*!
+     * \brief How many levels of detail a chunk section can have, including the full detail mesh
+     */
+    const uint32_t NUM_CHUNK_LODS = 3;
+
+    /*!
+     * \brief The size, in blocks, of the grid that each simplified level's vertices are snapped to. Level 0 is the mesh
+     * Minecraft gave us, so it has no entry
+     */
+    const float CHUNK_LOD_CELL_SIZES[NUM_CHUNK_LODS - 1] = {2.0f, 4.0f};
+
+    /*!
+     * \brief Controls when chunk sections switch between levels of detail
+     */
+    struct chunk_lod_settings {
+        /*!
+         * \brief Sections that are smaller than this, as a fraction of the screen's height, are drawn with level 1.
+         * Each level after that kicks in at half the size of the one before it
+         */
+        float screen_size_threshold = 0.15f;
+
+        /*!
+         * \brief How far, as a fraction of the threshold, a section has to go past a threshold before it switches
+         * levels. Keeps sections that sit right at a threshold from flickering between levels
+         */
+        float hysteresis = 0.2f;
+    };
+
+    /*!
+     * \brief Simplifies a chunk section's mesh by snapping its vertices to a grid and merging the ones that land on the
+     * same grid point
+     *
+     * Triangles that collapse, and triangles that end up the same as one we've already kept, are dropped. Each merged
+     * vertex keeps the color, UV, and lightmap of the first vertex that landed on its grid point, which is hard to
+     * notice once the section is only a few pixels tall
+     *
+     * \param mc_vertex_data The section's vertices in Minecraft's 7-int block format
+     * \param indices The section's triangle list
+     * \param cell_size The size of the grid, in blocks
+     * \param lod_vertex_data The simplified vertices are written here, in Minecraft's 7-int block format
+     * \param lod_indices The simplified triangle list is written here
+     */
+    void simplify_chunk_mesh(const std::vector<int>& mc_vertex_data, const std::vector<int>& indices, float cell_size,
+                             std::vector<int>& lod_vertex_data, std::vector<int>& lod_indices);
+
+    /*!
+     * \brief Guesses how much of the screen's height the given box covers
+     *
+     * \param bounding_box The box to measure
+     * \param camera_position Where the camera is
+     * \param fov The camera's vertical field of view, in degrees
+     * \return The box's size as a fraction of the screen's height. Larger than 1 if the camera is inside the box
+     */
+    float get_screen_size(const aabb& bounding_box, const glm::vec3& camera_position, float fov);
+
+    /*!
+     * \brief Picks the level of detail for a section, starting from the level it used last frame
+     *
+     * \param screen_size The section's size, from get_screen_size
+     * \param current_lod The level the section was drawn with last frame
+     * \param num_lods How many levels of detail the section has
+     * \param settings The thresholds to use
+     * \return The level to draw the section with
+     */
+    uint32_t select_chunk_lod(float screen_size, uint32_t current_lod, uint32_t num_lods, const chunk_lod_settings& settings);
+}
+
+#endif //RENDERER_CHUNK_LOD_H
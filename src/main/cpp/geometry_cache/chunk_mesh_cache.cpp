@@ -0,0 +1,404 @@
+/*!
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <easylogging++.h>
+#define MINIZ_HEADER_FILE_ONLY
+#include "miniz.c"
+#include "chunk_mesh_cache.h"
+
+namespace nova {
+    /*!
+     * \brief Marks a file as one of ours. Bump the version whenever the layout of an entry changes
+     */
+    static const uint32_t CACHE_FILE_MAGIC = 0x434d564e;  // "NVMC"
+    static const uint32_t CACHE_FILE_VERSION = 2;
+    static const uint64_t FILE_HEADER_SIZE = sizeof(uint32_t) * 2;
+
+    /*!
+     * \brief Starts every entry, so that garbage at the end of a file that was cut short isn't read as an entry
+     */
+    static const uint32_t ENTRY_MAGIC = 0x4d434e45;  // "ENCM"
+
+    /*!
+     * \brief Files smaller than this are never compacted, since there's hardly anything to win
+     */
+    static const uint64_t MIN_COMPACT_SIZE = 4 * 1024 * 1024;
+
+    /*!
+     * \brief The largest entry we'll believe, so a broken header can't make us allocate gigabytes
+     */
+    static const uint32_t MAX_ENTRY_SIZE = 64 * 1024 * 1024;
+
+    struct entry_header {
+        uint64_t content_hash;
+        uint64_t resource_hash;
+        int32_t dimension;
+        int32_t x;
+        int32_t y;
+        int32_t z;
+        uint32_t compressed_size;
+        uint32_t uncompressed_size;
+        uint32_t checksum;  //!< The CRC-32 of the compressed data
+        uint32_t magic;
+    };
+
+    static_assert(sizeof(entry_header) == 48, "entry_header has to match the file layout");
+
+    /*!
+     * \brief Reads plain values out of a decompressed entry, failing once anything would go past its end
+     */
+    class entry_reader {
+    public:
+        entry_reader(const uint8_t* data, size_t size) : cur(data), end(data + size) {}
+
+        bool read(void* value, size_t num_bytes) {
+            if(static_cast<size_t>(end - cur) < num_bytes) {
+                return false;
+            }
+            std::memcpy(value, cur, num_bytes);
+            cur += num_bytes;
+            return true;
+        }
+
+        bool read_ints(std::vector<int>& values, uint32_t count) {
+            if(static_cast<size_t>(end - cur) / sizeof(int) < count) {
+                return false;
+            }
+            values.resize(count);
+            return read(values.data(), count * sizeof(int));
+        }
+
+    private:
+        const uint8_t* cur;
+        const uint8_t* end;
+    };
+
+    template <typename T>
+    static void append(std::vector<uint8_t>& bytes, const T& value) {
+        const auto* value_bytes = reinterpret_cast<const uint8_t*>(&value);
+        bytes.insert(bytes.end(), value_bytes, value_bytes + sizeof(T));
+    }
+
+    static void append_ints(std::vector<uint8_t>& bytes, const std::vector<int>& values) {
+        const auto* value_bytes = reinterpret_cast<const uint8_t*>(values.data());
+        bytes.insert(bytes.end(), value_bytes, value_bytes + values.size() * sizeof(int));
+    }
+
+    bool chunk_mesh_cache::section_position::operator==(const section_position& other) const {
+        return dimension == other.dimension && x == other.x && y == other.y && z == other.z;
+    }
+
+    size_t chunk_mesh_cache::section_position_hash::operator()(const section_position& position) const {
+        uint64_t hash = add_to_hash(FNV_OFFSET_BASIS, &position.dimension, sizeof(int));
+        hash = add_to_hash(hash, &position.x, sizeof(int));
+        hash = add_to_hash(hash, &position.y, sizeof(int));
+        return static_cast<size_t>(add_to_hash(hash, &position.z, sizeof(int)));
+    }
+
+    chunk_mesh_cache::chunk_mesh_cache(std::string path, uint64_t max_size_bytes) : path(std::move(path)), max_size_bytes(max_size_bytes) {
+        mapping = std::make_shared<mapped_file>(this->path);
+        const uint64_t valid_size = read_entries();
+
+        // A file that was cut short or is from another version has to be rewritten before we can append to it
+        const bool is_broken = mapping->is_open() && valid_size < mapping->get_size();
+        const bool is_mostly_dead = file_size > MIN_COMPACT_SIZE && live_bytes < (file_size - FILE_HEADER_SIZE) / 2;
+        if((is_broken || is_mostly_dead) && !compact() && is_broken) {
+            // Appending to a broken file would put our entries where nothing can find them
+            LOG(WARNING) << "Nothing will be saved to the chunk mesh cache " << this->path << " since it can't be rewritten";
+            return;
+        }
+
+        open_writer();
+        LOG(INFO) << "Opened the chunk mesh cache " << this->path << " with " << entries.size() << " sections in "
+                  << file_size / 1024 << " KB";
+    }
+
+    chunk_mesh_cache::~chunk_mesh_cache() {
+        LOG(INFO) << "Closing the chunk mesh cache " << path << ". It had " << num_hits << " hits and " << num_misses
+                  << " misses";
+    }
+
+    uint64_t chunk_mesh_cache::add_to_hash(uint64_t hash, const void* data, size_t num_bytes) {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        for(size_t i = 0; i < num_bytes; i++) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    uint64_t chunk_mesh_cache::hash_section(const uint16_t* block_ids, const uint8_t* light, size_t num_blocks) {
+        const uint64_t hash = add_to_hash(FNV_OFFSET_BASIS, block_ids, num_blocks * sizeof(uint16_t));
+        return add_to_hash(hash, light, num_blocks);
+    }
+
+    bool chunk_mesh_cache::load(const chunk_mesh_cache_key& key, std::vector<cached_section_mesh>& meshes) {
+        entry found = {};
+        std::shared_ptr<const mapped_file> file;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            auto itr = entries.find({key.dimension, key.x, key.y, key.z});
+            if(itr == entries.end() || itr->second.content_hash != key.content_hash || itr->second.resource_hash != key.resource_hash) {
+                num_misses++;
+                return false;
+            }
+            found = itr->second;
+
+            if(found.offset + found.num_bytes > mapping->get_size()) {
+                // Saved since we last mapped the file
+                writer.flush();
+                mapping = std::make_shared<mapped_file>(path);
+            }
+            file = mapping;
+        }
+
+        if(found.offset + found.num_bytes > file->get_size()) {
+            num_misses++;
+            return false;
+        }
+
+        entry_header header = {};
+        const uint8_t* entry_data = file->get_data() + found.offset;
+        std::memcpy(&header, entry_data, sizeof(header));
+        const uint8_t* compressed = entry_data + sizeof(header);
+        if(mz_crc32(MZ_CRC32_INIT, compressed, header.compressed_size) != header.checksum) {
+            LOG(WARNING) << "The chunk mesh cache entry for the section at (" << key.x << ", " << key.y << ", " << key.z
+                         << ") is corrupt, so it'll be meshed again";
+            num_misses++;
+            return false;
+        }
+
+        std::vector<uint8_t> bytes(header.uncompressed_size);
+        auto uncompressed_size = static_cast<mz_ulong>(bytes.size());
+        if(mz_uncompress(bytes.data(), &uncompressed_size, compressed, header.compressed_size) != MZ_OK ||
+                uncompressed_size != bytes.size()) {
+            num_misses++;
+            return false;
+        }
+
+        entry_reader reader(bytes.data(), bytes.size());
+        uint32_t num_meshes = 0;
+        if(!reader.read(&num_meshes, sizeof(num_meshes))) {
+            num_misses++;
+            return false;
+        }
+
+        meshes.clear();
+        for(uint32_t i = 0; i < num_meshes; i++) {
+            uint32_t name_length = 0;
+            uint32_t vertex_format = 0;
+            uint32_t num_vertex_ints = 0;
+            uint32_t num_indices = 0;
+            cached_section_mesh mesh;
+            bool is_valid = reader.read(&name_length, sizeof(name_length)) &&
+                            reader.read(&vertex_format, sizeof(vertex_format)) &&
+                            reader.read(&num_vertex_ints, sizeof(num_vertex_ints)) &&
+                            reader.read(&num_indices, sizeof(num_indices)) &&
+                            name_length <= 1024 && vertex_format < format::all_values().size();
+            if(is_valid) {
+                mesh.shader_name.resize(name_length);
+                is_valid = reader.read(&mesh.shader_name[0], name_length) &&
+                           reader.read_ints(mesh.definition.vertex_data, num_vertex_ints) &&
+                           reader.read_ints(mesh.definition.indices, num_indices);
+            }
+            if(!is_valid) {
+                LOG(WARNING) << "Could not read the chunk mesh cache entry for the section at (" << key.x << ", "
+                             << key.y << ", " << key.z << ")";
+                meshes.clear();
+                num_misses++;
+                return false;
+            }
+
+            mesh.definition.vertex_format = format::all_values()[vertex_format];
+            mesh.definition.position = glm::vec3(key.x, key.y, key.z);
+            mesh.definition.id = 0;
+            meshes.push_back(std::move(mesh));
+        }
+
+        num_hits++;
+        return true;
+    }
+
+    void chunk_mesh_cache::save(const chunk_mesh_cache_key& key, const std::vector<cached_section_mesh>& meshes) {
+        // Everything but the write happens before taking the lock
+        std::vector<uint8_t> bytes;
+        append(bytes, static_cast<uint32_t>(meshes.size()));
+        for(const auto& mesh : meshes) {
+            append(bytes, static_cast<uint32_t>(mesh.shader_name.size()));
+            append(bytes, static_cast<uint32_t>(mesh.definition.vertex_format.get_value()));
+            append(bytes, static_cast<uint32_t>(mesh.definition.vertex_data.size()));
+            append(bytes, static_cast<uint32_t>(mesh.definition.indices.size()));
+            bytes.insert(bytes.end(), mesh.shader_name.begin(), mesh.shader_name.end());
+            append_ints(bytes, mesh.definition.vertex_data);
+            append_ints(bytes, mesh.definition.indices);
+        }
+        if(bytes.size() > MAX_ENTRY_SIZE) {
+            return;
+        }
+
+        auto compressed_size = mz_compressBound(static_cast<mz_ulong>(bytes.size()));
+        std::vector<uint8_t> compressed(compressed_size);
+        if(mz_compress2(compressed.data(), &compressed_size, bytes.data(), static_cast<mz_ulong>(bytes.size()), MZ_BEST_SPEED) != MZ_OK) {
+            LOG(WARNING) << "Could not compress the meshes for the section at (" << key.x << ", " << key.y << ", "
+                         << key.z << ")";
+            return;
+        }
+
+        entry_header header = {};
+        header.content_hash = key.content_hash;
+        header.resource_hash = key.resource_hash;
+        header.dimension = key.dimension;
+        header.x = key.x;
+        header.y = key.y;
+        header.z = key.z;
+        header.compressed_size = static_cast<uint32_t>(compressed_size);
+        header.uncompressed_size = static_cast<uint32_t>(bytes.size());
+        header.checksum = static_cast<uint32_t>(mz_crc32(MZ_CRC32_INIT, compressed.data(), compressed_size));
+        header.magic = ENTRY_MAGIC;
+        const auto entry_size = static_cast<uint32_t>(sizeof(header) + compressed_size);
+
+        std::lock_guard<std::mutex> guard(lock);
+        if(!writer.is_open()) {
+            return;
+        }
+        if(file_size + entry_size > max_size_bytes) {
+            if(!warned_about_size) {
+                LOG(WARNING) << "The chunk mesh cache " << path << " is full, so new sections won't be saved to it. It "
+                             << "will be compacted the next time it's opened";
+                warned_about_size = true;
+            }
+            return;
+        }
+
+        writer.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        writer.write(reinterpret_cast<const char*>(compressed.data()), static_cast<std::streamsize>(compressed_size));
+        if(!writer) {
+            LOG(WARNING) << "Could not write to the chunk mesh cache " << path << ", so nothing else will be saved to it";
+            writer.close();
+            return;
+        }
+
+        auto& saved = entries[{key.dimension, key.x, key.y, key.z}];
+        live_bytes -= saved.num_bytes;
+        saved = {file_size, key.content_hash, key.resource_hash, entry_size};
+        live_bytes += entry_size;
+        file_size += entry_size;
+    }
+
+    size_t chunk_mesh_cache::get_num_sections() {
+        std::lock_guard<std::mutex> guard(lock);
+        return entries.size();
+    }
+
+    const std::string& chunk_mesh_cache::get_path() const {
+        return path;
+    }
+
+    uint64_t chunk_mesh_cache::read_entries() {
+        entries.clear();
+        live_bytes = 0;
+        file_size = 0;
+
+        const uint8_t* data = mapping->get_data();
+        const uint64_t size = mapping->get_size();
+        if(size < FILE_HEADER_SIZE) {
+            return 0;
+        }
+
+        uint32_t magic = 0;
+        uint32_t version = 0;
+        std::memcpy(&magic, data, sizeof(magic));
+        std::memcpy(&version, data + sizeof(magic), sizeof(version));
+        if(magic != CACHE_FILE_MAGIC || version != CACHE_FILE_VERSION) {
+            LOG(INFO) << "Starting the chunk mesh cache " << path << " over because it's from another version of Nova";
+            return 0;
+        }
+
+        uint64_t offset = FILE_HEADER_SIZE;
+        while(offset + sizeof(entry_header) <= size) {
+            entry_header header = {};
+            std::memcpy(&header, data + offset, sizeof(header));
+            if(header.magic != ENTRY_MAGIC || header.compressed_size > MAX_ENTRY_SIZE ||
+                    header.uncompressed_size > MAX_ENTRY_SIZE || offset + sizeof(header) + header.compressed_size > size) {
+                LOG(WARNING) << "The chunk mesh cache " << path << " was cut short, so it will be rewritten without "
+                             << "its last " << size - offset << " bytes";
+                break;
+            }
+
+            const auto entry_size = static_cast<uint32_t>(sizeof(header) + header.compressed_size);
+            auto& saved = entries[{header.dimension, header.x, header.y, header.z}];
+            live_bytes -= saved.num_bytes;
+            saved = {offset, header.content_hash, header.resource_hash, entry_size};
+            live_bytes += entry_size;
+            offset += entry_size;
+        }
+
+        file_size = offset;
+        return offset;
+    }
+
+    bool chunk_mesh_cache::compact() {
+        std::vector<entry> live_entries;
+        live_entries.reserve(entries.size());
+        for(const auto& saved : entries) {
+            live_entries.push_back(saved.second);
+        }
+        std::sort(live_entries.begin(), live_entries.end(), [](const entry& a, const entry& b) {
+            return a.offset < b.offset;
+        });
+
+        // Write to a temporary file first so a crash halfway through never loses the whole cache
+        const std::string temp_path = path + ".tmp";
+        {
+            std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+            if(!file.is_open()) {
+                LOG(WARNING) << "Could not write the chunk mesh cache file " << temp_path;
+                return false;
+            }
+
+            file.write(reinterpret_cast<const char*>(&CACHE_FILE_MAGIC), sizeof(CACHE_FILE_MAGIC));
+            file.write(reinterpret_cast<const char*>(&CACHE_FILE_VERSION), sizeof(CACHE_FILE_VERSION));
+            for(const auto& saved : live_entries) {
+                file.write(reinterpret_cast<const char*>(mapping->get_data() + saved.offset), saved.num_bytes);
+            }
+        }
+
+        const uint64_t old_size = mapping->get_size();
+
+        // Windows won't replace a file that's mapped
+        mapping = std::make_shared<mapped_file>();
+        std::remove(path.c_str());
+        const bool was_moved = std::rename(temp_path.c_str(), path.c_str()) == 0;
+        if(!was_moved) {
+            LOG(WARNING) << "Could not move the chunk mesh cache file " << temp_path << " to " << path;
+        }
+
+        mapping = std::make_shared<mapped_file>(path);
+        const uint64_t valid_size = read_entries();
+        if(!was_moved || valid_size < mapping->get_size()) {
+            return false;
+        }
+
+        LOG(INFO) << "Compacted the chunk mesh cache " << path << " from " << old_size / 1024 << " KB to "
+                  << file_size / 1024 << " KB";
+        return true;
+    }
+
+    void chunk_mesh_cache::open_writer() {
+        writer.open(path, std::ios::binary | std::ios::app);
+        if(!writer.is_open()) {
+            LOG(WARNING) << "Could not open the chunk mesh cache " << path << " for writing, so nothing will be saved to it";
+            return;
+        }
+
+        if(file_size == 0) {
+            writer.write(reinterpret_cast<const char*>(&CACHE_FILE_MAGIC), sizeof(CACHE_FILE_MAGIC));
+            writer.write(reinterpret_cast<const char*>(&CACHE_FILE_VERSION), sizeof(CACHE_FILE_VERSION));
+            file_size = FILE_HEADER_SIZE;
+        }
+    }
+}
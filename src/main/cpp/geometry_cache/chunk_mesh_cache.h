@@ -0,0 +1,189 @@
+/*!
+ * \brief Keeps the native mesher's chunk section meshes on disk so a world that's loaded again doesn't have to be
+ * meshed again
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_CHUNK_MESH_CACHE_H
+#define RENDERER_CHUNK_MESH_CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "mesh_definition.h"
+#include "../utils/mapped_file.h"
+
+namespace nova {
+    /*!
+     * \brief Everything that decides what a section's meshes look like
+     */
+    struct chunk_mesh_cache_key {
+        int dimension;
+
+        /*!
+         * \brief The section's position in blocks
+         */
+        int x;
+        int y;
+        int z;
+
+        /*!
+         * \brief A hash of the section's blocks and light, from chunk_mesh_cache::hash_section
+         */
+        uint64_t content_hash;
+
+        /*!
+         * \brief A hash of the mesher's block types and settings. When the resource packs change, so does this
+         */
+        uint64_t resource_hash;
+    };
+
+    /*!
+     * \brief One shader's mesh for a section
+     *
+     * Shaders are saved by name because shader IDs are handed out in whatever order Minecraft asks for them
+     */
+    struct cached_section_mesh {
+        std::string shader_name;
+        mesh_definition definition;
+    };
+
+    /*!
+     * \brief An append-only file of compressed section meshes, one file per world
+     *
+     * Opening the cache reads through the file once to find the newest entry for each section, and after that entries
+     * are read straight out of a mapping of the file. Saving a section that's already in the cache appends a new entry
+     * and leaves the old one behind as dead space. When more than half of the file is dead it's rewritten the next
+     * time it's opened, and once it reaches its size limit new sections just aren't saved.
+     *
+     * All the functions are safe to call from any thread
+     */
+    class chunk_mesh_cache {
+    public:
+        static const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+
+        /*!
+         * \brief Opens the cache file at the given path, making it if it isn't there
+         *
+         * \param path The path of the cache file. Its directory has to exist
+         * \param max_size_bytes How big the file is allowed to get
+         */
+        chunk_mesh_cache(std::string path, uint64_t max_size_bytes);
+
+        chunk_mesh_cache(const chunk_mesh_cache&) = delete;
+        chunk_mesh_cache& operator=(const chunk_mesh_cache&) = delete;
+
+        ~chunk_mesh_cache();
+
+        /*!
+         * \brief Adds some bytes to a 64-bit FNV-1a hash
+         *
+         * \param hash The hash so far. Start with FNV_OFFSET_BASIS
+         */
+        static uint64_t add_to_hash(uint64_t hash, const void* data, size_t num_bytes);
+
+        /*!
+         * \brief Hashes a section's padded block IDs and light, in the layout from mc_chunk_section_blocks
+         */
+        static uint64_t hash_section(const uint16_t* block_ids, const uint8_t* light, size_t num_blocks);
+
+        /*!
+         * \brief Reads the meshes that were saved for the key's section
+         *
+         * \return True if the newest entry for the section has exactly the key's hashes and could be read
+         */
+        bool load(const chunk_mesh_cache_key& key, std::vector<cached_section_mesh>& meshes);
+
+        /*!
+         * \brief Saves the meshes for the key's section, replacing whatever was saved for it before
+         *
+         * Shaders that the section has no geometry for shouldn't be in the list. Loading the section gives back
+         * exactly the meshes in the list
+         */
+        void save(const chunk_mesh_cache_key& key, const std::vector<cached_section_mesh>& meshes);
+
+        size_t get_num_sections();
+
+        const std::string& get_path() const;
+
+    private:
+        /*!
+         * \brief Where a section's newest entry is in the file
+         */
+        struct entry {
+            uint64_t offset;
+            uint64_t content_hash;
+            uint64_t resource_hash;
+            uint32_t num_bytes;     //!< The size of the entry, with its header
+        };
+
+        struct section_position {
+            int dimension;
+            int x;
+            int y;
+            int z;
+
+            bool operator==(const section_position& other) const;
+        };
+
+        struct section_position_hash {
+            size_t operator()(const section_position& position) const;
+        };
+
+        std::string path;
+        uint64_t max_size_bytes;
+
+        std::mutex lock;
+        std::unordered_map<section_position, entry, section_position_hash> entries;
+
+        /*!
+         * \brief The part of the file that existed the last time it was mapped
+         *
+         * Entries that were saved after that are past the end of the mapping, so reading one of them maps the file
+         * again. Loads hold on to the mapping they read from, so they can decompress without holding the lock
+         */
+        std::shared_ptr<const mapped_file> mapping;
+
+        std::ofstream writer;
+
+        uint64_t file_size = 0;
+
+        /*!
+         * \brief The bytes of the file that are taken up by each section's newest entry
+         */
+        uint64_t live_bytes = 0;
+
+        bool warned_about_size = false;
+
+        std::atomic<uint64_t> num_hits{0};
+        std::atomic<uint64_t> num_misses{0};
+
+        /*!
+         * \brief Finds the newest entry for each section in the mapped file
+         *
+         * \return The number of bytes at the start of the file that hold whole, valid entries
+         */
+        uint64_t read_entries();
+
+        /*!
+         * \brief Rewrites the file with only each section's newest entry
+         *
+         * \return False if the file couldn't be replaced
+         */
+        bool compact();
+
+        /*!
+         * \brief Starts appending to the end of the file, writing the file header first if it's new
+         */
+        void open_writer();
+    };
+}
+
+#endif //RENDERER_CHUNK_MESH_CACHE_H
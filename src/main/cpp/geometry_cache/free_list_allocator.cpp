@@ -0,0 +1,88 @@
+/*!
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <iterator>
+#include "free_list_allocator.h"
+
+namespace nova {
+    free_list_allocator::free_list_allocator(uint32_t capacity) : capacity(capacity), bytes_free(capacity) {
+        free_blocks[0] = capacity;
+    }
+
+    std::experimental::optional<allocation> free_list_allocator::allocate(uint32_t size, uint32_t alignment) {
+        if(size == 0) {
+            return {};
+        }
+
+        if(alignment == 0) {
+            alignment = 1;
+        }
+
+        for(auto block_itr = free_blocks.begin(); block_itr != free_blocks.end(); ++block_itr) {
+            const uint32_t block_start = block_itr->first;
+            const uint32_t block_size = block_itr->second;
+
+            const uint32_t aligned_start = ((block_start + alignment - 1) / alignment) * alignment;
+            const uint32_t padding = aligned_start - block_start;
+            if(padding + size > block_size) {
+                continue;
+            }
+
+            free_blocks.erase(block_itr);
+
+            // Whatever is left on either side of the allocation stays free
+            if(padding > 0) {
+                free_blocks[block_start] = padding;
+            }
+
+            const uint32_t remaining = block_size - padding - size;
+            if(remaining > 0) {
+                free_blocks[aligned_start + size] = remaining;
+            }
+
+            bytes_free -= size;
+            return allocation{aligned_start, size};
+        }
+
+        return {};
+    }
+
+    void free_list_allocator::free(const allocation& alloc) {
+        if(alloc.size == 0) {
+            return;
+        }
+
+        uint32_t start = alloc.offset;
+        uint32_t size = alloc.size;
+
+        // Merge with the block after us, if it starts right where we end
+        auto next_itr = free_blocks.lower_bound(start);
+        if(next_itr != free_blocks.end() && next_itr->first == start + size) {
+            size += next_itr->second;
+            next_itr = free_blocks.erase(next_itr);
+        }
+
+        // Merge with the block before us, if it ends right where we start
+        if(next_itr != free_blocks.begin()) {
+            auto prev_itr = std::prev(next_itr);
+            if(prev_itr->first + prev_itr->second == start) {
+                start = prev_itr->first;
+                size += prev_itr->second;
+                free_blocks.erase(prev_itr);
+            }
+        }
+
+        free_blocks[start] = size;
+        bytes_free += alloc.size;
+    }
+
+    uint32_t free_list_allocator::get_capacity() const {
+        return capacity;
+    }
+
+    uint32_t free_list_allocator::get_bytes_free() const {
+        return bytes_free;
+    }
+}
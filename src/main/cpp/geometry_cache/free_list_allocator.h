@@ -0,0 +1,72 @@
+/*!
+ * \brief A simple first-fit free list allocator for carving up large GPU buffers
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_FREE_LIST_ALLOCATOR_H
+#define RENDERER_FREE_LIST_ALLOCATOR_H
+
+#include <cstdint>
+#include <map>
+#include <optional.hpp>
+
+namespace nova {
+    /*!
+     * \brief A range of bytes handed out by a free_list_allocator
+     */
+    struct allocation {
+        uint32_t offset = 0;    //!< The offset, in bytes, from the start of the managed range
+        uint32_t size = 0;      //!< The size, in bytes, of the allocated range
+    };
+
+    /*!
+     * \brief Hands out ranges from a fixed-size block of memory
+     *
+     * The allocator doesn't own any memory itself - it just keeps track of which parts of some range (usually a GL
+     * buffer) are in use. Free blocks are kept sorted by offset so that freeing a range can merge it with its
+     * neighbours, which keeps fragmentation down when chunks are constantly replaced
+     */
+    class free_list_allocator {
+    public:
+        /*!
+         * \brief Creates an allocator that manages the range [0, capacity)
+         *
+         * \param capacity The number of bytes to manage
+         */
+        explicit free_list_allocator(uint32_t capacity);
+
+        /*!
+         * \brief Finds the first free range that fits the requested size
+         *
+         * \param size The number of bytes to allocate
+         * \param alignment The allocation's offset will be a multiple of this. It does not need to be a power of two,
+         * which is important for vertex data since the base vertex is the offset divided by the vertex stride
+         * \return The allocated range, or nothing if there's no free range big enough
+         */
+        std::experimental::optional<allocation> allocate(uint32_t size, uint32_t alignment);
+
+        /*!
+         * \brief Returns the given range to the allocator, merging it with any adjacent free ranges
+         *
+         * \param alloc The range to free. Must have come from this allocator
+         */
+        void free(const allocation& alloc);
+
+        uint32_t get_capacity() const;
+
+        uint32_t get_bytes_free() const;
+
+    private:
+        uint32_t capacity;
+        uint32_t bytes_free;
+
+        /*!
+         * \brief A map from the offset of a free block to its size
+         */
+        std::map<uint32_t, uint32_t> free_blocks;
+    };
+}
+
+#endif //RENDERER_FREE_LIST_ALLOCATOR_H
@@ -0,0 +1,293 @@
+/*!
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include "greedy_mesher.h"
+
+namespace nova {
+    /*!
+     * \brief One vertex in the TILED_POS_COLOR_UV_LIGHTMAPUV_NORMAL_TILE format
+     */
+    struct tiled_vertex {
+        float position[3];
+        uint8_t color[4];
+        float uv[2];
+        int16_t lightmap[2];
+        float normal[3];
+        float tile[4];
+    };
+
+    static_assert(sizeof(tiled_vertex) == TILED_VERTEX_SIZE * sizeof(int), "tiled_vertex must be TILED_VERTEX_SIZE ints");
+
+    /*!
+     * \brief How bright a corner is for each ambient occlusion level
+     */
+    static const float AO_BRIGHTNESS[4] = {0.5f, 0.65f, 0.8f, 1.0f};
+
+    /*!
+     * \brief The bits of a column that belong to the section's own blocks
+     */
+    static const uint64_t SECTION_BITS = ((1ull << SECTION_SIZE) - 1) << 1;
+
+    static const uint64_t FACE_PRESENT_BIT = 1ull << 32;
+
+    static const mesher_block_type AIR = {};
+
+    /*!
+     * \brief Packs everything that decides whether two faces can be merged into one number
+     */
+    static uint64_t make_face_key(uint16_t block_id, uint8_t light, uint32_t ao) {
+        return FACE_PRESENT_BIT | (static_cast<uint64_t>(ao) << 24) | (static_cast<uint64_t>(light) << 16) | block_id;
+    }
+
+    /*!
+     * \brief Checks if all four corners of a face have the same ambient occlusion
+     */
+    static bool has_even_ao(uint64_t face_key) {
+        const uint32_t ao = static_cast<uint32_t>(face_key >> 24) & 0xFF;
+        return ao == 0x00 || ao == 0x55 || ao == 0xAA || ao == 0xFF;
+    }
+
+    const mesher_block_type& greedy_mesher::get_type(int x, int y, int z) const {
+        const uint16_t id = block_ids[padded_block_index(x, y, z)];
+        return id < block_types->size() ? (*block_types)[id] : AIR;
+    }
+
+    bool greedy_mesher::is_opaque(const glm::ivec3& pos) const {
+        return ((opaque_columns[0][pos.y][pos.z] >> pos.x) & 1) != 0;
+    }
+
+    void greedy_mesher::load_section(const uint16_t* block_ids, const uint8_t* light, const std::vector<mesher_block_type>& block_types) {
+        this->block_ids = block_ids;
+        this->light = light;
+        this->block_types = &block_types;
+
+        std::memset(opaque_columns, 0, sizeof(opaque_columns));
+        std::memset(visible_columns, 0, sizeof(visible_columns));
+        shaders.clear();
+
+        // Columns along x are indexed by (y, z), along y by (z, x), and along z by (x, y)
+        for(int y = 0; y < PADDED_SECTION_SIZE; y++) {
+            for(int z = 0; z < PADDED_SECTION_SIZE; z++) {
+                for(int x = 0; x < PADDED_SECTION_SIZE; x++) {
+                    const auto& type = get_type(x, y, z);
+                    if(type.is_opaque) {
+                        opaque_columns[0][y][z] |= 1ull << x;
+                        opaque_columns[1][z][x] |= 1ull << y;
+                        opaque_columns[2][x][y] |= 1ull << z;
+                    }
+                    if(type.is_visible) {
+                        visible_columns[0][y][z] |= 1ull << x;
+                        visible_columns[1][z][x] |= 1ull << y;
+                        visible_columns[2][x][y] |= 1ull << z;
+
+                        const bool in_section = x > 0 && x <= SECTION_SIZE && y > 0 && y <= SECTION_SIZE && z > 0 && z <= SECTION_SIZE;
+                        if(in_section && std::find(shaders.begin(), shaders.end(), type.shader) == shaders.end()) {
+                            shaders.push_back(type.shader);
+                        }
+                    }
+                }
+            }
+        }
+
+        // A face shows if its block is visible and the block in front of it isn't opaque
+        std::memset(face_columns, 0, sizeof(face_columns));
+        for(int axis = 0; axis < 3; axis++) {
+            for(int a = 1; a <= SECTION_SIZE; a++) {
+                for(int b = 1; b <= SECTION_SIZE; b++) {
+                    const uint64_t visible = visible_columns[axis][a][b] & SECTION_BITS;
+                    const uint64_t opaque = opaque_columns[axis][a][b];
+                    face_columns[axis * 2][a][b] = visible & ~(opaque << 1);
+                    face_columns[axis * 2 + 1][a][b] = visible & ~(opaque >> 1);
+                }
+            }
+        }
+    }
+
+    const std::vector<uint32_t>& greedy_mesher::get_shaders() const {
+        return shaders;
+    }
+
+    uint32_t greedy_mesher::get_face_ao(const glm::ivec3& front, int u, int v) const {
+        static const int corner_signs[4][2] = {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+
+        uint32_t ao = 0;
+        for(int corner = 0; corner < 4; corner++) {
+            glm::ivec3 u_offset(0);
+            glm::ivec3 v_offset(0);
+            u_offset[u] = corner_signs[corner][0];
+            v_offset[v] = corner_signs[corner][1];
+
+            const bool side_u = is_opaque(front + u_offset);
+            const bool side_v = is_opaque(front + v_offset);
+            const bool diagonal = is_opaque(front + u_offset + v_offset);
+
+            const uint32_t corner_ao = (side_u && side_v) ? 0 : 3 - (side_u + side_v + diagonal);
+            ao |= corner_ao << (corner * 2);
+        }
+        return ao;
+    }
+
+    void greedy_mesher::mesh(uint32_t shader, bool merge_faces, std::vector<int>& vertex_data, std::vector<int>& indices) {
+        vertex_data.clear();
+        indices.clear();
+
+        for(int face = 0; face < 6; face++) {
+            const int axis = face / 2;
+            const int direction = (face % 2) == 0 ? -1 : 1;
+            const int u = (axis + 1) % 3;
+            const int v = (axis + 2) % 3;
+
+            for(int slice = 1; slice <= SECTION_SIZE; slice++) {
+                bool any_faces = false;
+                for(int a = 0; a < SECTION_SIZE; a++) {
+                    for(int b = 0; b < SECTION_SIZE; b++) {
+                        uint64_t& key = slice_faces[a][b];
+                        key = 0;
+                        if(((face_columns[face][a + 1][b + 1] >> slice) & 1) == 0) {
+                            continue;
+                        }
+
+                        glm::ivec3 pos;
+                        pos[axis] = slice;
+                        pos[u] = a + 1;
+                        pos[v] = b + 1;
+                        if(get_type(pos.x, pos.y, pos.z).shader != shader) {
+                            continue;
+                        }
+
+                        glm::ivec3 front = pos;
+                        front[axis] += direction;
+                        const int front_idx = padded_block_index(front.x, front.y, front.z);
+                        key = make_face_key(block_ids[padded_block_index(pos.x, pos.y, pos.z)], light[front_idx],
+                                            get_face_ao(front, u, v));
+                        any_faces = true;
+                    }
+                }
+
+                if(!any_faces) {
+                    continue;
+                }
+
+                for(int a = 0; a < SECTION_SIZE; a++) {
+                    for(int b = 0; b < SECTION_SIZE; b++) {
+                        const uint64_t key = slice_faces[a][b];
+                        if(key == 0) {
+                            continue;
+                        }
+
+                        int width = 1;
+                        int height = 1;
+                        if(merge_faces && has_even_ao(key)) {
+                            while(a + width < SECTION_SIZE && slice_faces[a + width][b] == key) {
+                                width++;
+                            }
+
+                            bool row_matches = true;
+                            while(b + height < SECTION_SIZE && row_matches) {
+                                for(int i = 0; i < width; i++) {
+                                    if(slice_faces[a + i][b + height] != key) {
+                                        row_matches = false;
+                                        break;
+                                    }
+                                }
+                                if(row_matches) {
+                                    height++;
+                                }
+                            }
+                        }
+
+                        for(int i = 0; i < width; i++) {
+                            for(int j = 0; j < height; j++) {
+                                slice_faces[a + i][b + j] = 0;
+                            }
+                        }
+
+                        emit_quad(face, slice, a, b, width, height, key, vertex_data, indices);
+                    }
+                }
+            }
+        }
+    }
+
+    void greedy_mesher::emit_quad(int face, int slice, int u_start, int v_start, int width, int height, uint64_t face_key,
+                                  std::vector<int>& vertex_data, std::vector<int>& indices) const {
+        const int axis = face / 2;
+        const int direction = (face % 2) == 0 ? -1 : 1;
+        const int u = (axis + 1) % 3;
+        const int v = (axis + 2) % 3;
+
+        const auto block_id = static_cast<uint16_t>(face_key & 0xFFFF);
+        const auto face_light = static_cast<uint8_t>((face_key >> 16) & 0xFF);
+        const auto ao = static_cast<uint32_t>((face_key >> 24) & 0xFF);
+        const auto& type = (*block_types)[block_id];
+
+        uint8_t tint[4];
+        std::memcpy(tint, &type.tints[face], sizeof(tint));
+
+        const auto first_vertex = static_cast<int>(vertex_data.size() / TILED_VERTEX_SIZE);
+        static const int corner_offsets[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+        uint32_t corner_ao[4];
+        for(int corner = 0; corner < 4; corner++) {
+            corner_ao[corner] = (ao >> (corner * 2)) & 3;
+
+            tiled_vertex vertex = {};
+            glm::vec3 position;
+            position[axis] = static_cast<float>(slice - 1 + (direction > 0 ? 1 : 0));
+            position[u] = static_cast<float>(u_start + corner_offsets[corner][0] * width);
+            position[v] = static_cast<float>(v_start + corner_offsets[corner][1] * height);
+            for(int i = 0; i < 3; i++) {
+                vertex.position[i] = position[i];
+                vertex.normal[i] = i == axis ? static_cast<float>(direction) : 0.0f;
+            }
+
+            for(int i = 0; i < 3; i++) {
+                vertex.color[i] = static_cast<uint8_t>(tint[i] * AO_BRIGHTNESS[corner_ao[corner]]);
+            }
+            vertex.color[3] = tint[3];
+
+            // The texture's v goes down the sides of blocks, and follows z on the top and bottom
+            if(axis == 1) {
+                vertex.uv[0] = position.x;
+                vertex.uv[1] = position.z;
+            } else {
+                vertex.uv[0] = axis == 0 ? position.z : position.x;
+                vertex.uv[1] = SECTION_SIZE - position.y;
+            }
+
+            vertex.lightmap[0] = static_cast<int16_t>((face_light & 0xF) * 16);
+            vertex.lightmap[1] = static_cast<int16_t>((face_light >> 4) * 16);
+
+            const glm::vec4& tile = type.tile_rects[face];
+            for(int i = 0; i < 4; i++) {
+                vertex.tile[i] = tile[i];
+            }
+
+            const size_t first_int = vertex_data.size();
+            vertex_data.resize(first_int + TILED_VERTEX_SIZE);
+            std::memcpy(&vertex_data[first_int], &vertex, sizeof(vertex));
+        }
+
+        // Split the quad along the diagonal with the brighter ends, so the occlusion is interpolated the same way
+        // whichever way the quad faces
+        static const int split_02[6] = {0, 1, 2, 0, 2, 3};
+        static const int split_13[6] = {1, 2, 3, 1, 3, 0};
+        const int* corners = corner_ao[0] + corner_ao[2] >= corner_ao[1] + corner_ao[3] ? split_02 : split_13;
+
+        // The corners go counterclockwise when seen from +axis, so faces that point the other way are wound backwards
+        for(int triangle = 0; triangle < 2; triangle++) {
+            const int* tri = corners + triangle * 3;
+            indices.push_back(first_vertex + tri[0]);
+            if(direction > 0) {
+                indices.push_back(first_vertex + tri[1]);
+                indices.push_back(first_vertex + tri[2]);
+            } else {
+                indices.push_back(first_vertex + tri[2]);
+                indices.push_back(first_vertex + tri[1]);
+            }
+        }
+    }
+}
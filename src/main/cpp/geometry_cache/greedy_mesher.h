@@ -0,0 +1,170 @@
+/*!
+ * \brief Builds chunk section meshes from block IDs, merging neighboring faces that look the same into one quad
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_GREEDY_MESHER_H
+#define RENDERER_GREEDY_MESHER_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace nova {
+    /*!
+     * \brief How many blocks wide, tall, and deep a chunk section is
+     */
+    const int SECTION_SIZE = 16;
+
+    /*!
+     * \brief The size of the block arrays the mesher reads. They have a one block border of the neighboring sections
+     * on every side, so faces on the section's edges can be culled and given ambient occlusion
+     */
+    const int PADDED_SECTION_SIZE = SECTION_SIZE + 2;
+    const int PADDED_SECTION_VOLUME = PADDED_SECTION_SIZE * PADDED_SECTION_SIZE * PADDED_SECTION_SIZE;
+
+    /*!
+     * \brief The number of ints in one vertex of the TILED_POS_COLOR_UV_LIGHTMAPUV_NORMAL_TILE format
+     */
+    const int TILED_VERTEX_SIZE = 14;
+
+    /*!
+     * \brief Finds a block in the padded arrays. x, y, and z go from 0 to PADDED_SECTION_SIZE - 1, and the section's
+     * own blocks are the ones from 1 to SECTION_SIZE
+     */
+    inline int padded_block_index(int x, int y, int z) {
+        return (y * PADDED_SECTION_SIZE + z) * PADDED_SECTION_SIZE + x;
+    }
+
+    /*!
+     * \brief How the mesher draws one kind of block. Only full cubes can be meshed natively
+     *
+     * Faces are indexed -x, +x, -y, +y, -z, +z
+     */
+    struct mesher_block_type {
+        /*!
+         * \brief If false the block isn't drawn by the mesher. Air, and every block that isn't a full cube, leaves
+         * this false
+         */
+        bool is_visible = false;
+
+        /*!
+         * \brief If true the block hides the faces of its neighbors that touch it, and darkens the corners next to it
+         */
+        bool is_opaque = false;
+
+        /*!
+         * \brief The ID of the shader whose filter the block passes
+         */
+        uint32_t shader = 0;
+
+        /*!
+         * \brief Where each face's texture is in the atlas, as (min u, min v, width, height)
+         */
+        glm::vec4 tile_rects[6];
+
+        /*!
+         * \brief Each face's tint, in the same byte order as the colors in Minecraft's vertices
+         */
+        uint32_t tints[6] = {0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF};
+    };
+
+    /*!
+     * \brief Meshes one chunk section at a time
+     *
+     * Culling is done with bitmasks. For each of the three axes there's a 64-bit column of occupancy bits for every
+     * line of blocks along that axis, so a whole line's visible faces come from a couple of shifts and masks instead
+     * of checking every neighbor
+     *
+     * The visible faces of each slice are then merged greedily: a face grows along one axis while the next face looks
+     * the same, then the row grows along the other axis while every face in the next row does too. Faces look the
+     * same if they have the same block, light, and ambient occlusion. Faces whose corners have different ambient
+     * occlusion are never merged, since the gradient would be stretched over the whole quad
+     *
+     * Vertices are in the TILED_POS_COLOR_UV_LIGHTMAPUV_NORMAL_TILE format:
+     * - position: three floats, relative to the section
+     * - color: RGBA8, the face's tint darkened by the vertex's ambient occlusion
+     * - uv: two floats counting texture tiles across the quad, so a quad four blocks wide goes from 0 to 4
+     * - lightmap: two shorts, block light and sky light, like Minecraft's
+     * - normal: three floats
+     * - tile: four floats, the face's tile_rect
+     *
+     * A merged quad repeats its texture, so shaders sample the atlas at tile.xy + fract(uv) * tile.zw
+     *
+     * Not thread safe, but each worker thread can have its own
+     */
+    class greedy_mesher {
+    public:
+        /*!
+         * \brief Reads a section's blocks and works out which faces are visible
+         *
+         * \param block_ids PADDED_SECTION_VOLUME block IDs, laid out like padded_block_index
+         * \param light PADDED_SECTION_VOLUME light values, block light in the low four bits and sky light in the high
+         * four bits
+         * \param block_types The block types, indexed by block ID. IDs past the end are treated as air
+         */
+        void load_section(const uint16_t* block_ids, const uint8_t* light, const std::vector<mesher_block_type>& block_types);
+
+        /*!
+         * \brief The IDs of the shaders that have at least one visible face in the loaded section
+         */
+        const std::vector<uint32_t>& get_shaders() const;
+
+        /*!
+         * \brief Meshes the faces of the loaded section's blocks that pass the given shader's filter
+         *
+         * \param shader The ID of the shader to mesh blocks for
+         * \param merge_faces If false every face gets its own quad, which is only really useful for comparing
+         * \param vertex_data Cleared, then filled with the vertices
+         * \param indices Cleared, then filled with the triangle list
+         */
+        void mesh(uint32_t shader, bool merge_faces, std::vector<int>& vertex_data, std::vector<int>& indices);
+
+    private:
+        const uint16_t* block_ids = nullptr;
+        const uint8_t* light = nullptr;
+        const std::vector<mesher_block_type>* block_types = nullptr;
+
+        /*!
+         * \brief Bit i of opaque_columns[axis][a][b] is set if the block at coordinate i along the axis, and a and b
+         * along the next two axes, is opaque. The same goes for visible_columns
+         */
+        uint64_t opaque_columns[3][PADDED_SECTION_SIZE][PADDED_SECTION_SIZE];
+        uint64_t visible_columns[3][PADDED_SECTION_SIZE][PADDED_SECTION_SIZE];
+
+        /*!
+         * \brief Bit i of face_columns[face][a][b] is set if the section block at i along the face's axis has that face
+         * showing. Only the bits for the section's own blocks are ever set
+         */
+        uint64_t face_columns[6][PADDED_SECTION_SIZE][PADDED_SECTION_SIZE];
+
+        std::vector<uint32_t> shaders;
+
+        /*!
+         * \brief What each face in the slice being merged looks like, or 0 if there isn't a face there
+         */
+        uint64_t slice_faces[SECTION_SIZE][SECTION_SIZE];
+
+        const mesher_block_type& get_type(int x, int y, int z) const;
+
+        bool is_opaque(const glm::ivec3& pos) const;
+
+        /*!
+         * \brief Works out the ambient occlusion of each corner of a face, from 0 (darkest) to 3 (not occluded)
+         *
+         * \param front The block in front of the face
+         * \param u The first axis along the face
+         * \param v The second axis along the face
+         * \return The four corners' ambient occlusion, two bits each, starting at the (-u, -v) corner and going
+         * counterclockwise
+         */
+        uint32_t get_face_ao(const glm::ivec3& front, int u, int v) const;
+
+        void emit_quad(int face, int slice, int u_start, int v_start, int width, int height, uint64_t face_key,
+                       std::vector<int>& vertex_data, std::vector<int>& indices) const;
+    };
+}
+
+#endif //RENDERER_GREEDY_MESHER_H
@@ -6,3 +6,40 @@
  */
 
 #include "mesh_definition.h"
+
+namespace nova {
+    bool is_quad_format(format vertex_format) {
+        switch(vertex_format) {
+            case format::POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT:
+            case format::PACKED_POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT:
+            case format::TILED_POS_COLOR_UV_LIGHTMAPUV_NORMAL_TILE:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    void append_quad_indices(uint32_t first_vertex, uint32_t num_vertices, std::vector<int>& indices) {
+        const uint32_t num_quads = num_vertices / 4;
+        indices.reserve(indices.size() + num_quads * 6);
+        for(uint32_t quad = 0; quad < num_quads; quad++) {
+            const int quad_start = static_cast<int>(first_vertex + quad * 4);
+            for(int index : QUAD_INDEX_PATTERN) {
+                indices.push_back(quad_start + index);
+            }
+        }
+    }
+
+    bool is_quad_index_list(const int* indices, size_t num_indices) {
+        if(num_indices == 0 || num_indices % 6 != 0) {
+            return false;
+        }
+
+        for(size_t i = 0; i < num_indices; i++) {
+            if(indices[i] != static_cast<int>(i / 6 * 4) + QUAD_INDEX_PATTERN[i % 6]) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
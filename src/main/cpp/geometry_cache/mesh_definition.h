@@ -8,6 +8,8 @@
 #ifndef RENDERER_MESH_DEFINITION_H
 #define RENDERER_MESH_DEFINITION_H
 
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 #include <glm/glm.hpp>
 #include "../utils/smart_enum.h"
@@ -15,12 +17,20 @@
 namespace nova {
     /*!
      * \brief Specifies the format of vertex buffer data
+     *
+     * PACKED_POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT is the 24-byte chunk format made by pack_chunk_vertices. See
+     * vertex_packing.h for its layout
+     *
+     * TILED_POS_COLOR_UV_LIGHTMAPUV_NORMAL_TILE is the 14-int format made by the native chunk mesher, where UVs count
+     * texture tiles and each vertex carries its tile's spot in the atlas. See greedy_mesher.h for its layout
      */
     SMART_ENUM(format, \
         POS, \
         POS_UV, \
         POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT, \
-        POS_UV_COLOR);
+        POS_UV_COLOR, \
+        PACKED_POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT, \
+        TILED_POS_COLOR_UV_LIGHTMAPUV_NORMAL_TILE);
 
     /*!
      * \brief Defines the geometry in a mesh so that you can just throw the mesh onto the GPU and not care
@@ -32,6 +42,35 @@ namespace nova {
         glm::vec3 position;
         int id;
     };
+
+    /*!
+     * \brief The indices of the two triangles in each quad, relative to the quad's first vertex. It's the same split
+     * that Minecraft's chunk geometry uses
+     */
+    const int QUAD_INDEX_PATTERN[6] = {0, 1, 2, 0, 2, 3};
+
+    /*!
+     * \brief Checks if the given format is only ever used for quads, four vertices at a time
+     *
+     * Meshes in these formats can leave their indices empty, and they're drawn as if they had #QUAD_INDEX_PATTERN
+     * repeated for every four vertices
+     */
+    bool is_quad_format(format vertex_format);
+
+    /*!
+     * \brief Adds #QUAD_INDEX_PATTERN for each quad in the given range of vertices to the end of the index list
+     *
+     * \param first_vertex The first vertex of the first quad
+     * \param num_vertices How many vertices the quads have. Vertices past the last whole quad are left out
+     * \param indices The list to add to
+     */
+    void append_quad_indices(uint32_t first_vertex, uint32_t num_vertices, std::vector<int>& indices);
+
+    /*!
+     * \brief Checks if the given indices are exactly #QUAD_INDEX_PATTERN repeated from vertex 0, so they can be
+     * replaced with a shared copy of the pattern
+     */
+    bool is_quad_index_list(const int* indices, size_t num_indices);
 }
 
 #endif //RENDERER_MESH_DEFINITION_H
@@ -6,144 +6,1542 @@
 */
 
 #include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cmath>
 #include <easylogging++.h>
-#include <regex>
 #include <iomanip>
+#include <limits>
 #include "mesh_store.h"
+#include "vertex_packing.h"
+#include "../render/objects/vertex_formats.h"
+#include "../render/windowing/upload_context.h"
+#include "../render/objects/gpu_memory.h"
+#include "../utils/utils.h"
+#include "../utils/logging.h"
 #include "../../../render/nova_renderer.h"
 
 namespace nova {
-    std::vector<render_object>& mesh_store::get_meshes_for_shader(std::string shader_name) {
-        return renderables_grouped_by_shader[shader_name];
+    /*!
+     * \brief Goes into every section's key in the mesh cache. Bump it whenever greedy_mesher's output changes, so
+     * that sections meshed by an older version are meshed again
+     */
+    static const uint32_t MESHER_VERSION = 1;
+
+    mesh_store::mesh_store() {
+        // Leave most of the cores for Minecraft's own chunk builders
+        unsigned int num_workers = std::max(1u, std::min(4u, std::thread::hardware_concurrency() / 2));
+        conversion_workers = std::make_unique<thread_pool>(num_workers, "chunk_conversion");
+
+        chunk_name = names.intern("chunk");
+        chunk_region_name = names.intern("chunk_region");
+    }
+
+    mesh_store::~mesh_store() {
+        // The upload thread is writing into the arena, which goes away with us
+        if(!chunks_being_written.empty()) {
+            uploads->wait_for(chunks_being_written.back().ticket);
+        }
+    }
+
+    void mesh_store::set_upload_context(upload_context* uploads) {
+        this->uploads = uploads;
+    }
+
+    shader_id mesh_store::get_shader_id(const std::string& shader_name) {
+        std::lock_guard<std::mutex> lock(shader_ids_lock);
+        auto id = shader_ids.find(shader_name);
+        if(id != shader_ids.end()) {
+            return id->second;
+        }
+
+        auto new_id = static_cast<shader_id>(shader_ids.size());
+        shader_ids[shader_name] = new_id;
+        LOG(DEBUG) << "Shader " << shader_name << " has ID " << new_id;
+        return new_id;
+    }
+
+    bool mesh_store::has_shader_id(int shader) {
+        std::lock_guard<std::mutex> lock(shader_ids_lock);
+        return shader >= 0 && static_cast<size_t>(shader) < shader_ids.size();
+    }
+
+    bool mesh_store::is_chunk_format_valid(int vertex_format) {
+        return vertex_format >= 0 && static_cast<size_t>(vertex_format) < format::all_values().size();
+    }
+
+    bool mesh_store::is_chunk_valid(int shader, int vertex_format, int chunk_id, bool is_removal) {
+        if(!has_shader_id(shader)) {
+            LOG(WARNING) << "Chunk " << chunk_id << " was sent with unknown shader ID " << shader << ", skipping it";
+            return false;
+        }
+        if(!is_removal && !is_chunk_format_valid(vertex_format)) {
+            LOG(WARNING) << "Chunk " << chunk_id << " was sent with unknown format " << vertex_format << ", skipping it";
+            return false;
+        }
+        return true;
+    }
+
+    std::string mesh_store::get_shader_name(shader_id shader) {
+        std::lock_guard<std::mutex> lock(shader_ids_lock);
+        for(const auto& shader_name : shader_ids) {
+            if(shader_name.second == shader) {
+                return shader_name.first;
+            }
+        }
+        return "";
+    }
+
+    mesh_store::shader_geometry& mesh_store::get_geometry(shader_id shader) {
+        if(shader >= geometry_by_shader.size()) {
+            geometry_by_shader.resize(shader + 1);
+        }
+        return geometry_by_shader[shader];
+    }
+
+    std::vector<render_object>& mesh_store::get_meshes_for_shader(shader_id shader) {
+        return get_geometry(shader).objects;
+    }
+
+    void mesh_store::cull_meshes_for_shader(shader_id shader, const frustum& view_frustum, std::vector<uint32_t>& visible_indices) {
+        get_geometry(shader).bounding_boxes.cull(view_frustum, visible_indices);
+    }
+
+    void mesh_store::mark_visible(shader_id shader, const std::vector<uint32_t>& visible_indices) {
+        auto& objects = get_geometry(shader).objects;
+        for(uint32_t idx : visible_indices) {
+            objects[idx].last_visible_frame = frame_count;
+        }
+    }
+
+    void mesh_store::sort_back_to_front(shader_id shader, const glm::vec3& camera_position) {
+        auto& geometry = get_geometry(shader);
+        geometry.is_sorted = true;
+
+        auto& objects = geometry.objects;
+        if(objects.size() < 2) {
+            return;
+        }
+
+        sort_distances.resize(objects.size());
+        size_t num_out_of_order = 0;
+        for(size_t i = 0; i < objects.size(); i++) {
+            const glm::vec3 to_object = objects[i].bounding_box.center - camera_position;
+            sort_distances[i] = to_object.x * to_object.x + to_object.y * to_object.y + to_object.z * to_object.z;
+            if(i > 0 && sort_distances[i - 1] < sort_distances[i]) {
+                num_out_of_order++;
+            }
+        }
+
+        if(num_out_of_order == 0) {
+            return;
+        }
+
+        // Insertion sort is quadratic if things are far out of place, like after the player teleports
+        if(num_out_of_order > objects.size() / 8 + 8) {
+            sort_order.resize(objects.size());
+            for(uint32_t i = 0; i < sort_order.size(); i++) {
+                sort_order[i] = i;
+            }
+            std::stable_sort(sort_order.begin(), sort_order.end(), [&](uint32_t a, uint32_t b) {
+                return sort_distances[a] > sort_distances[b];
+            });
+
+            sorted_objects.clear();
+            sorted_objects.reserve(objects.size());
+            for(uint32_t idx : sort_order) {
+                sorted_objects.push_back(std::move(objects[idx]));
+            }
+            objects.swap(sorted_objects);
+            sorted_objects.clear();
+
+            update_moved_objects(geometry, 0, objects.size() - 1);
+            return;
+        }
+
+        size_t first_moved = objects.size();
+        size_t last_moved = 0;
+        for(size_t i = 1; i < objects.size(); i++) {
+            const float distance = sort_distances[i];
+            if(sort_distances[i - 1] >= distance) {
+                continue;
+            }
+
+            render_object obj = std::move(objects[i]);
+            size_t j = i;
+            while(j > 0 && sort_distances[j - 1] < distance) {
+                sort_distances[j] = sort_distances[j - 1];
+                objects[j] = std::move(objects[j - 1]);
+                j--;
+            }
+            sort_distances[j] = distance;
+            objects[j] = std::move(obj);
+
+            first_moved = std::min(first_moved, j);
+            last_moved = std::max(last_moved, i);
+        }
+
+        update_moved_objects(geometry, first_moved, last_moved);
+    }
+
+    void mesh_store::sort_front_to_back(shader_id shader, const glm::vec3& camera_position,
+                                        std::vector<uint32_t>& visible_indices) {
+        if(visible_indices.size() < 2) {
+            return;
+        }
+
+        const auto& objects = get_geometry(shader).objects;
+        sort_distances.resize(objects.size());
+        for(uint32_t idx : visible_indices) {
+            const glm::vec3 to_object = objects[idx].bounding_box.center - camera_position;
+            sort_distances[idx] = to_object.x * to_object.x + to_object.y * to_object.y + to_object.z * to_object.z;
+        }
+
+        std::sort(visible_indices.begin(), visible_indices.end(), [&](uint32_t a, uint32_t b) {
+            return sort_distances[a] < sort_distances[b];
+        });
+    }
+
+    void mesh_store::update_moved_objects(shader_geometry& geometry, size_t first, size_t last) {
+        for(size_t i = first; i <= last; i++) {
+            const auto& obj = geometry.objects[i];
+            geometry.bounding_boxes.set(i, obj.bounding_box);
+            if(obj.type == geometry_type::block) {
+                geometry.chunk_slots[chunk_key(obj.position, obj.parent_id)] = i;
+            }
+        }
+    }
+
+    void mesh_store::add_render_object(shader_geometry& geometry, render_object&& obj) {
+        geometry.bounding_boxes.push_back(obj.bounding_box);
+        geometry.objects.push_back(std::move(obj));
     }
 
     void mesh_store::add_gui_buffers(mc_gui_geometry* command) {
-        std::string texture_name(command->texture_name);
-        texture_name = std::regex_replace(texture_name, std::regex("^textures/"), "");
-        texture_name = std::regex_replace(texture_name, std::regex(".png$"), "");
-        texture_name = "minecraft:" + texture_name;
-        const texture_manager::texture_location tex_location = nova_renderer::instance->get_texture_manager().get_texture_location(texture_name);
-        glm::vec2 tex_size = tex_location.max - tex_location.min;
-
-        mesh_definition cur_screen_buffer = {};
-        cur_screen_buffer.vertex_data.resize(static_cast<unsigned long>(command->vertex_buffer_size), 0);
-        for (int i = 0; i + 8 < command->vertex_buffer_size; i += 9) {
-            cur_screen_buffer.vertex_data[i]   = *reinterpret_cast<int*>(&command->vertex_buffer[i]);
-            cur_screen_buffer.vertex_data[i+1] = *reinterpret_cast<int*>(&command->vertex_buffer[i+1]);
-            cur_screen_buffer.vertex_data[i+2] = *reinterpret_cast<int*>(&command->vertex_buffer[i+2]);
-            float u = command->vertex_buffer[i+3] * tex_size.x + tex_location.min.x;
-            cur_screen_buffer.vertex_data[i+3] = *reinterpret_cast<int*>(&u);
-            float v = command->vertex_buffer[i+4] * tex_size.y + tex_location.min.y;
-            cur_screen_buffer.vertex_data[i+4] = *reinterpret_cast<int*>(&v);
-            cur_screen_buffer.vertex_data[i+5] = *reinterpret_cast<int*>(&command->vertex_buffer[i+5]);
-            cur_screen_buffer.vertex_data[i+6] = *reinterpret_cast<int*>(&command->vertex_buffer[i+6]);
-            cur_screen_buffer.vertex_data[i+7] = *reinterpret_cast<int*>(&command->vertex_buffer[i+7]);
-            cur_screen_buffer.vertex_data[i+8] = *reinterpret_cast<int*>(&command->vertex_buffer[i+8]);
-        }
-        cur_screen_buffer.indices.resize(static_cast<unsigned long>(command->index_buffer_size), 0);
-        for(int i = 0; i < command->index_buffer_size; i++) {
-            cur_screen_buffer.indices[i] = (unsigned int)command->index_buffer[i];
-        }
-
-        cur_screen_buffer.vertex_format = format::POS_UV_COLOR;
-
-        render_object gui = {};
-        gui.geometry = std::make_unique<gl_mesh>(cur_screen_buffer);
-        gui.type = geometry_type::gui;
-        gui.name = "gui";
-        gui.color_texture = command->atlas_name;
-
-        // TODO: Something more intelligent
-        renderables_grouped_by_shader["gui"].push_back(std::move(gui));
+        gui_geometry.add_geometry(*command, nova_renderer::instance->get_texture_manager());
     }
 
     void mesh_store::remove_gui_render_objects() {
-        remove_render_objects([](auto& render_obj) {return render_obj.type == geometry_type::gui;});
+        gui_geometry.clear();
     }
 
     void mesh_store::remove_render_objects(std::function<bool(render_object&)> filter) {
-        for(auto& group : renderables_grouped_by_shader) {
-            auto removed_elements = std::remove_if(group.second.begin(), group.second.end(), filter);
-            group.second.erase(removed_elements, group.second.end());
+        for(auto& geometry : geometry_by_shader) {
+            // The filter should see the sections, not the regions they've been merged into
+            split_all_regions(geometry);
+
+            auto& objects = geometry.objects;
+            auto& bounding_boxes = geometry.bounding_boxes;
+            auto& chunk_slots = geometry.chunk_slots;
+
+            // Compact the objects and their bounding boxes together so they stay in the same order
+            size_t write_idx = 0;
+            for(size_t read_idx = 0; read_idx < objects.size(); read_idx++) {
+                auto& obj = objects[read_idx];
+                if(filter(obj)) {
+                    free_object_geometry(obj);
+                    if(obj.type == geometry_type::block) {
+                        chunk_key key(obj.position, obj.parent_id);
+                        chunk_slots.erase(key);
+                        geometry.evicted_chunks.erase(key);
+                        forget_region_section(geometry, key, obj.position);
+                    }
+                    continue;
+                }
+
+                if(write_idx != read_idx) {
+                    objects[write_idx] = std::move(obj);
+                    bounding_boxes.copy(read_idx, write_idx);
+
+                    if(objects[write_idx].type == geometry_type::block) {
+                        chunk_slots[chunk_key(objects[write_idx].position, objects[write_idx].parent_id)] = write_idx;
+                    }
+                }
+                write_idx++;
+            }
+
+            objects.erase(objects.begin() + write_idx, objects.end());
+            bounding_boxes.resize(write_idx);
+        }
+    }
+
+    chunk_arena& mesh_store::get_chunk_arena() {
+        return chunk_geometry;
+    }
+
+    upload_prioritizer& mesh_store::get_upload_prioritizer() {
+        return prioritizer;
+    }
+
+    gui_batcher& mesh_store::get_gui_batcher() {
+        return gui_geometry;
+    }
+
+    object_data_buffer& mesh_store::get_object_data() {
+        return object_data;
+    }
+
+    void mesh_store::upload_new_geometry(const glm::vec3& camera_position) {
+        chunk_geometry.begin_frame(uploads != nullptr ? uploads->get_completed_ticket() : 0);
+        object_data.begin_frame();
+        place_written_chunks();
+
+        // If nothing is being converted right now, every update that's older than the ones we're about to apply is
+        // already in the queue, so once the queue is drained there are no stale updates left to guard against
+        const bool no_conversions_in_flight = chunks_being_converted.load() == 0;
+
+        // Removals are cheap so they happen right away. Additions wait their turn, since we only upload so many per
+        // frame, and a section that's sent again while it waits only keeps its newest version
+        chunk_update update;
+        while(chunk_parts_to_upload.try_pop(update)) {
+            queue_chunk_update(std::move(update));
+        }
+
+        if(!chunks_waiting_for_upload.empty()) {
+            upload_most_needed_chunks(camera_position);
+        }
+
+        // A chunk that's still being written checks its update ID when it's placed, so the IDs have to last until then
+        if(no_conversions_in_flight && chunks_waiting_for_upload.empty() && chunks_being_written.empty()) {
+            for(auto& geometry : geometry_by_shader) {
+                geometry.last_update_ids.clear();
+            }
+        }
+
+        merge_stable_regions(camera_position);
+        enforce_memory_budget(camera_position);
+        frame_count++;
+    }
+
+    void mesh_store::queue_chunk_update(chunk_update&& update) {
+        auto& geometry = get_geometry(update.shader);
+        const chunk_key key = update.get_key();
+
+        auto slot_itr = geometry.waiting_upload_slots.find(key);
+        if(slot_itr != geometry.waiting_upload_slots.end()) {
+            const size_t slot = slot_itr->second;
+            auto& waiting = chunks_waiting_for_upload[slot];
+            if(waiting.update_id > update.update_id) {
+                // Workers finish out of order, so the update that's waiting can be newer than this one
+                skip_superseded_update(update);
+                return;
+            }
+
+            skip_superseded_update(waiting);
+            if(!update.is_removal) {
+                waiting = std::move(update);
+                return;
+            }
+
+            // Nothing's left to upload for the section, so its slot goes to the last update in the list
+            if(slot != chunks_waiting_for_upload.size() - 1) {
+                auto& last = chunks_waiting_for_upload.back();
+                waiting = std::move(last);
+                get_geometry(waiting.shader).waiting_upload_slots[waiting.get_key()] = slot;
+            }
+            chunks_waiting_for_upload.pop_back();
+            geometry.waiting_upload_slots.erase(key);
+        }
+
+        if(update.is_removal) {
+            apply_chunk_update_and_complete_ticket(update);
+        } else {
+            geometry.waiting_upload_slots[key] = chunks_waiting_for_upload.size();
+            chunks_waiting_for_upload.push_back(std::move(update));
+        }
+    }
+
+    void mesh_store::skip_superseded_update(chunk_update& update) {
+        recycle_chunk_update(update);
+        complete_direct_upload_ticket(update);
+        superseded_uploads++;
+    }
+
+    uint64_t mesh_store::get_num_superseded_uploads() const {
+        return superseded_uploads;
+    }
+
+    void mesh_store::upload_most_needed_chunks(const glm::vec3& camera_position) {
+        for(auto& waiting : chunks_waiting_for_upload) {
+            waiting.upload_priority = prioritizer.get_priority(waiting.definition.position, camera_position);
+        }
+
+        // Least needed first, so the most needed chunk is always at the back and can be popped off cheaply
+        std::sort(chunks_waiting_for_upload.begin(), chunks_waiting_for_upload.end(), [&](const auto& a, const auto& b) {
+            return a.upload_priority > b.upload_priority;
+        });
+        for(size_t i = 0; i < chunks_waiting_for_upload.size(); i++) {
+            const auto& waiting = chunks_waiting_for_upload[i];
+            get_geometry(waiting.shader).waiting_upload_slots[waiting.get_key()] = i;
+        }
+
+        const auto start_time = std::chrono::steady_clock::now();
+        uint64_t bytes_uploaded = 0;
+        uint32_t chunks_uploaded = 0;
+
+        while(!chunks_waiting_for_upload.empty()) {
+            auto& next_chunk = chunks_waiting_for_upload.back();
+            const uint64_t chunk_size = next_chunk.get_upload_size();
+
+            // Always upload at least one chunk a frame, no matter how small the budget is, so we keep making progress
+            if(chunks_uploaded > 0) {
+                if(upload_budget_bytes > 0 && bytes_uploaded + chunk_size > upload_budget_bytes) {
+                    break;
+                }
+
+                if(upload_budget_microseconds > 0) {
+                    auto time_spent = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time);
+                    if(time_spent.count() >= upload_budget_microseconds) {
+                        break;
+                    }
+                }
+            }
+
+            get_geometry(next_chunk.shader).waiting_upload_slots.erase(next_chunk.get_key());
+            apply_chunk_update_and_complete_ticket(next_chunk);
+            chunks_waiting_for_upload.pop_back();
+
+            bytes_uploaded += chunk_size;
+            chunks_uploaded++;
+        }
+
+        if(!chunks_waiting_for_upload.empty()) {
+            NOVA_LOG_HOT(TRACE) << "Uploaded " << chunks_uploaded << " chunks (" << bytes_uploaded
+                                << " bytes) this frame, " << chunks_waiting_for_upload.size()
+                                << " chunks are waiting for next frame";
+        }
+    }
+
+    bool mesh_store::has_pending_chunks() const {
+        return chunks_being_converted > 0 || !chunk_parts_to_upload.is_empty() || !chunks_waiting_for_upload.empty() ||
+               !chunks_being_written.empty();
+    }
+
+    bool mesh_store::has_chunks_being_converted() const {
+        return chunks_being_converted.load() > 0;
+    }
+
+    void mesh_store::on_config_change(nlohmann::json& new_config) {
+        upload_budget_bytes = new_config.value("chunkUploadBudgetBytes", upload_budget_bytes);
+        upload_budget_microseconds = new_config.value("chunkUploadBudgetMicroseconds", upload_budget_microseconds);
+        prioritizer.set_lookahead(new_config.value("chunkUploadLookaheadSeconds", 1.0f));
+
+        generate_lods = new_config.value("chunkLods", generate_lods.load());
+        merge_section_faces = new_config.value("greedyMeshing", merge_section_faces.load());
+        lod_settings.screen_size_threshold = new_config.value("chunkLodScreenSize", lod_settings.screen_size_threshold);
+        lod_settings.hysteresis = new_config.value("chunkLodHysteresis", lod_settings.hysteresis);
+
+        region_merging = new_config.value("regionMerging", region_merging);
+        region_merge_frames = new_config.value("regionMergeFrames", region_merge_frames);
+        region_merge_distance = new_config.value("regionMergeDistance", region_merge_distance);
+
+        const uint64_t budget_megabytes = new_config.value("vramBudgetMegabytes", memory_budget_bytes / (1024 * 1024));
+        memory_budget_bytes = budget_megabytes * 1024 * 1024;
+        warned_about_memory_budget = false;
+
+        std::lock_guard<std::mutex> lock(mesh_cache_lock);
+        use_mesh_cache = new_config.value("chunkMeshCache", use_mesh_cache);
+        mesh_cache_directory = new_config.value("chunkMeshCacheDirectory", mesh_cache_directory);
+        const uint64_t cache_megabytes = new_config.value("chunkMeshCacheMegabytes", mesh_cache_max_bytes / (1024 * 1024));
+        mesh_cache_max_bytes = cache_megabytes * 1024 * 1024;
+        if(!use_mesh_cache) {
+            mesh_cache.reset();
+        }
+    }
+
+    void mesh_store::on_config_loaded(nlohmann::json& config) {}
+
+    chunk_key mesh_store::chunk_update::get_key() const {
+        return chunk_key(definition.position, definition.id);
+    }
+
+    uint64_t mesh_store::chunk_update::get_upload_size() const {
+        if(direct_vertex_data != nullptr) {
+            return (direct_vertex_data_size + direct_index_count) * sizeof(int);
+        }
+        uint64_t size = definition.vertex_data.size() + definition.indices.size();
+        for(const auto& lod : lods) {
+            size += lod.vertex_data.size() + lod.indices.size();
+        }
+        return size * sizeof(int);
+    }
+
+    void mesh_store::apply_chunk_update_and_complete_ticket(chunk_update& update) {
+        apply_chunk_update(update);
+        recycle_chunk_update(update);
+
+        // Stale updates are dropped by apply_chunk_update, but their tickets still need to complete since we'll never
+        // read their data
+        complete_direct_upload_ticket(update);
+    }
+
+    void mesh_store::complete_direct_upload_ticket(const chunk_update& update) {
+        if(update.direct_upload_ticket != 0) {
+            std::lock_guard<std::mutex> lock(pending_direct_upload_tickets_lock);
+            pending_direct_upload_tickets.erase(update.direct_upload_ticket);
+        }
+    }
+
+    void mesh_store::apply_chunk_update(chunk_update& update) {
+        const auto& def = update.definition;
+        auto& geometry = get_geometry(update.shader);
+        auto& chunk_slots = geometry.chunk_slots;
+        chunk_key key(def.position, def.id);
+
+        auto& last_update_ids = geometry.last_update_ids;
+        auto last_update_itr = last_update_ids.find(key);
+        if(last_update_itr != last_update_ids.end() && last_update_itr->second > update.update_id) {
+            // A newer update for this chunk has already been applied
+            return;
+        }
+        last_update_ids[key] = update.update_id;
+
+        // Whatever happens to the chunk, it's no longer waiting to be evicted or rebuilt
+        geometry.evicted_chunks.erase(key);
+        rebuilds_requested.erase(key);
+
+        // The chunk has to be back in the list of render objects before we can change it
+        auto region_itr = geometry.regions.find(chunk_key(get_region_position(def.position), MERGED_REGION_ID));
+        if(region_itr != geometry.regions.end() && region_itr->second.is_merged) {
+            split_region(geometry, region_itr->first, region_itr->second);
+        }
+
+        if(update.is_removal) {
+            auto slot_itr = chunk_slots.find(key);
+            if(slot_itr != chunk_slots.end()) {
+                swap_remove_render_object(geometry, slot_itr->second);
+            }
+            forget_region_section(geometry, key, def.position);
+            return;
+        }
+
+        render_object obj = {};
+        if(update.direct_vertex_data != nullptr) {
+            // The owner gets its memory back as soon as this returns, so direct uploads are always copied here
+            obj.arena_handle = chunk_geometry.add_mesh(update.direct_vertex_data, update.direct_vertex_data_size,
+                                                       update.direct_indices, update.direct_index_count,
+                                                       def.vertex_format, def.id);
+        } else if(uploads != nullptr && uploads->is_running()) {
+            write_chunk_on_upload_thread(update);
+            return;
+        } else {
+            add_chunk_meshes(def, update.lods.data(), update.lods.size(), obj);
+        }
+        fill_chunk_object(def, obj);
+
+        place_chunk_object(geometry, key, std::move(obj));
+        remember_region_section(geometry, key, update);
+    }
+
+    void mesh_store::recycle_chunk_update(chunk_update& update) {
+        chunk_buffers.release(std::move(update.mc_vertex_data));
+        recycle_mesh(update.definition);
+        for(auto& lod : update.lods) {
+            recycle_mesh(lod);
+        }
+        update.lods.clear();
+    }
+
+    void mesh_store::recycle_mesh(mesh_definition& mesh) {
+        chunk_buffers.release(std::move(mesh.vertex_data));
+        chunk_buffers.release(std::move(mesh.indices));
+    }
+
+    void mesh_store::add_chunk_meshes(const mesh_definition& def, const mesh_definition* lods, size_t num_lods, render_object& obj,
+                                      std::vector<arena_write>* deferred_writes) {
+        auto add_mesh = [&](const mesh_definition& mesh) {
+            if(deferred_writes == nullptr) {
+                return chunk_geometry.add_mesh(mesh.vertex_data.data(), mesh.vertex_data.size(), mesh.indices.data(),
+                                               mesh.indices.size(), def.vertex_format, def.id);
+            }
+
+            auto handle = chunk_geometry.allocate_mesh(mesh.vertex_data.size(), mesh.indices.data(), mesh.indices.size(),
+                                                       def.vertex_format, def.id);
+            if(handle.page >= 0) {
+                deferred_writes->push_back({chunk_geometry.get_page_data(handle.page), handle, mesh.vertex_data.data(),
+                                            mesh.indices.empty() ? nullptr : mesh.indices.data()});
+            }
+            return handle;
+        };
+
+        obj.arena_handle = add_mesh(def);
+
+        for(size_t i = 0; i < num_lods; i++) {
+            auto& lod_handle = obj.lod_arena_handles[obj.num_lods - 1];
+            lod_handle = add_mesh(lods[i]);
+            if(!lod_handle.is_valid()) {
+                break;
+            }
+            obj.num_lods++;
+        }
+    }
+
+    void mesh_store::write_chunk_on_upload_thread(chunk_update& update) {
+        auto written = std::make_shared<chunk_update>(std::move(update));
+        render_object obj = {};
+        std::vector<arena_write> writes;
+        add_chunk_meshes(written->definition, written->lods.data(), written->lods.size(), obj, &writes);
+
+        // The task keeps the update alive, and nothing else touches its meshes until the ticket is complete
+        const uint64_t ticket = uploads->submit([written, writes]() {
+            for(const auto& write : writes) {
+                chunk_arena::write_mesh(write.page_data, write.handle, write.vertex_data, write.indices);
+            }
+        });
+        chunk_geometry.set_newest_write(ticket);
+
+        chunks_being_written.push_back({std::move(written), std::move(obj), ticket});
+    }
+
+    void mesh_store::place_written_chunks() {
+        if(chunks_being_written.empty()) {
+            return;
+        }
+
+        bool placed_any = false;
+        auto written_itr = chunks_being_written.begin();
+        for(; written_itr != chunks_being_written.end() && uploads->is_complete(written_itr->ticket); ++written_itr) {
+            auto& update = *written_itr->update;
+            auto& obj = written_itr->obj;
+            auto& geometry = get_geometry(update.shader);
+            const chunk_key key = update.get_key();
+
+            const auto last_update_itr = geometry.last_update_ids.find(key);
+            if(last_update_itr != geometry.last_update_ids.end() && last_update_itr->second != update.update_id) {
+                // The section was changed or removed again while this was being written
+                chunk_geometry.free_mesh(obj.arena_handle);
+                for(uint32_t lod = 1; lod < obj.num_lods; lod++) {
+                    chunk_geometry.free_mesh(obj.lod_arena_handles[lod - 1]);
+                }
+
+            } else {
+                // The region may have been merged again while this was being written
+                auto region_itr = geometry.regions.find(chunk_key(get_region_position(update.definition.position), MERGED_REGION_ID));
+                if(region_itr != geometry.regions.end() && region_itr->second.is_merged) {
+                    split_region(geometry, region_itr->first, region_itr->second);
+                }
+
+                fill_chunk_object(update.definition, obj);
+                place_chunk_object(geometry, key, std::move(obj));
+                remember_region_section(geometry, key, update);
+                placed_any = true;
+            }
+
+            recycle_chunk_update(update);
+        }
+        chunks_being_written.erase(chunks_being_written.begin(), written_itr);
+
+        if(placed_any) {
+            uploads->wait_on_gpu();
+        }
+    }
+
+    void mesh_store::fill_chunk_object(const mesh_definition& def, render_object& obj) {
+        obj.type = geometry_type::block;
+        obj.name = chunk_name;
+        obj.parent_id = def.id;
+        if(chunk_material == NO_MATERIAL) {
+            render_material material;
+            material.color_texture = "block_color";
+            auto& textures = nova_renderer::instance->get_texture_manager();
+            material.color_texture_handle = textures.get_texture_handle(material.color_texture);
+            chunk_material = materials.add(material);
+        }
+        obj.material = chunk_material;
+        obj.position = def.position;
+        obj.bounding_box.center = {def.position.x+8,def.position.y+8,def.position.z+8};
+        obj.bounding_box.extents = {16, 16, 16};   // TODO: Make these values come from Minecraft
+        obj.last_visible_frame = frame_count;
+        changed_bounds.push_back(obj.bounding_box);
+
+        // The w component tells the shader whether it needs to unpack the vertices
+        if(obj.arena_handle.is_valid()) {
+            const bool is_packed = def.vertex_format == format::PACKED_POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT;
+            obj.object_slot = object_data.add({glm::vec4(def.position, is_packed ? 1.0f : 0.0f)});
+        }
+    }
+
+    void mesh_store::place_chunk_object(shader_geometry& geometry, const chunk_key& key, render_object&& obj) {
+        auto slot_itr = geometry.chunk_slots.find(key);
+        if(slot_itr != geometry.chunk_slots.end()) {
+            // Replace the old geometry in place
+            const size_t slot = slot_itr->second;
+            auto& old_obj = geometry.objects[slot];
+            free_object_geometry(old_obj);
+
+            geometry.bounding_boxes.set(slot, obj.bounding_box);
+            old_obj = std::move(obj);
+
+        } else {
+            add_render_object(geometry, std::move(obj));
+            geometry.chunk_slots[key] = geometry.objects.size() - 1;
+        }
+    }
+
+    void mesh_store::remember_region_section(shader_geometry& geometry, const chunk_key& key, chunk_update& update) {
+        // Direct uploads are in memory that isn't ours, so there's nothing to keep a copy of. Leaving the section out
+        // of its region just means it's still drawn on its own if the rest of the region is merged
+        if(!keeps_chunk_copies() || update.direct_vertex_data != nullptr) {
+            forget_region_section(geometry, key, update.definition.position);
+            return;
+        }
+
+        const glm::vec3 region_position = get_region_position(update.definition.position);
+        auto& region = geometry.regions[chunk_key(region_position, MERGED_REGION_ID)];
+        region.position = region_position;
+        region.last_changed_frame = frame_count;
+
+        auto section_itr = std::find_if(region.sections.begin(), region.sections.end(), [&](const region_section& section) {
+            return section.key == key;
+        });
+        if(section_itr == region.sections.end()) {
+            region.sections.push_back({key, {}});
+            section_itr = region.sections.end() - 1;
+        }
+
+        auto& meshes = section_itr->meshes;
+        for(auto& mesh : meshes) {
+            recycle_mesh(mesh);
+        }
+        meshes.clear();
+        meshes.reserve(1 + update.lods.size());
+        meshes.push_back(std::move(update.definition));
+        for(auto& lod : update.lods) {
+            meshes.push_back(std::move(lod));
+        }
+    }
+
+    void mesh_store::forget_region_section(shader_geometry& geometry, const chunk_key& key, const glm::vec3& position) {
+        auto region_itr = geometry.regions.find(chunk_key(get_region_position(position), MERGED_REGION_ID));
+        if(region_itr == geometry.regions.end()) {
+            return;
+        }
+
+        auto& region = region_itr->second;
+        region.last_changed_frame = frame_count;
+        auto removed = std::remove_if(region.sections.begin(), region.sections.end(), [&](const region_section& section) {
+            return section.key == key;
+        });
+        for(auto section = removed; section != region.sections.end(); ++section) {
+            for(auto& mesh : section->meshes) {
+                recycle_mesh(mesh);
+            }
+        }
+        region.sections.erase(removed, region.sections.end());
+
+        if(region.sections.empty()) {
+            geometry.regions.erase(region_itr);
+        }
+    }
+
+    void mesh_store::merge_stable_regions(const glm::vec3& camera_position) {
+        // Merging copies a lot of geometry, so it's spread out over several frames
+        const uint32_t max_merges_per_frame = 2;
+        uint32_t num_merges = 0;
+
+        // Regions that the camera comes close to are split, with some slack so they don't flip back and forth
+        const float split_distance = region_merge_distance * 0.75f;
+
+        for(auto& geometry : geometry_by_shader) {
+            if(!region_merging || geometry.is_sorted) {
+                split_all_regions(geometry);
+                if(!keeps_chunk_copies()) {
+                    geometry.regions.clear();
+                }
+                continue;
+            }
+
+            for(auto& region_entry : geometry.regions) {
+                auto& region = region_entry.second;
+                const float distance = glm::length(region.position - camera_position);
+
+                if(region.is_merged) {
+                    if(distance < split_distance) {
+                        split_region(geometry, region_entry.first, region);
+                    }
+                    continue;
+                }
+
+                // Merging needs room for the region's mesh before the sections' meshes can be freed
+                if(memory_budget_bytes > 0 && get_memory_usage() > memory_budget_bytes - memory_budget_bytes / 10) {
+                    continue;
+                }
+
+                const bool is_stable = frame_count - region.last_changed_frame >= region_merge_frames;
+                if(num_merges < max_merges_per_frame && is_stable && distance >= region_merge_distance &&
+                   can_merge_region(region)) {
+                    if(merge_region(geometry, region_entry.first, region)) {
+                        num_merges++;
+                    } else {
+                        // Don't try again every frame
+                        region.last_changed_frame = frame_count;
+                    }
+                }
+            }
+        }
+    }
+
+    bool mesh_store::can_merge_region(const chunk_region& region) {
+        // A region with one section would make the same draw it already does
+        if(region.sections.size() < 2) {
+            return false;
+        }
+
+        const format vertex_format = region.sections.front().meshes.empty()
+                                     ? format::POS : region.sections.front().meshes[0].vertex_format;
+        if(!can_merge_format(vertex_format)) {
+            return false;
+        }
+
+        for(const auto& section : region.sections) {
+            if(section.meshes.empty() || section.meshes[0].vertex_format != vertex_format) {
+                return false;
+            }
         }
+        return true;
     }
 
-    void mesh_store::upload_new_geometry() {
-        chunk_parts_to_upload_lock.lock();
-        while(!chunk_parts_to_upload.empty()) {
-            const auto& entry = chunk_parts_to_upload.front();
-            const auto& def = std::get<1>(entry);
+    bool mesh_store::merge_region(shader_geometry& geometry, const chunk_key& region_key, chunk_region& region) {
+        const format vertex_format = region.sections.front().meshes[0].vertex_format;
+
+        size_t num_levels = 0;
+        for(const auto& section : region.sections) {
+            num_levels = std::max(num_levels, section.meshes.size());
+        }
+
+        // Sections with fewer levels use their coarsest level for the region's coarser levels
+        std::vector<mesh_definition> levels(num_levels);
+        for(size_t level = 0; level < num_levels; level++) {
+            auto& merged = levels[level];
+            merged.vertex_format = vertex_format;
+            merged.position = region.position;
+            merged.id = MERGED_REGION_ID;
+
+            for(const auto& section : region.sections) {
+                const auto& mesh = section.meshes[std::min(level, section.meshes.size() - 1)];
+                append_section_to_region(mesh, section.meshes[0].position - region.position, merged);
+            }
+        }
+
+        render_object obj = {};
+        add_chunk_meshes(levels[0], levels.data() + 1, levels.size() - 1, obj);
+        if(!obj.arena_handle.is_valid()) {
+            free_object_geometry(obj);
+            return false;
+        }
+        fill_chunk_object(levels[0], obj);
+        obj.name = chunk_region_name;
+
+        // Sections only take up part of the region, so it's culled with the box around all of them
+        glm::vec3 bounds_min(std::numeric_limits<float>::max());
+        glm::vec3 bounds_max(std::numeric_limits<float>::lowest());
+        for(const auto& section : region.sections) {
+            auto slot_itr = geometry.chunk_slots.find(section.key);
+            if(slot_itr != geometry.chunk_slots.end()) {
+                const auto& section_bounds = geometry.objects[slot_itr->second].bounding_box;
+                bounds_min = glm::min(bounds_min, section_bounds.center - section_bounds.extents);
+                bounds_max = glm::max(bounds_max, section_bounds.center + section_bounds.extents);
+                swap_remove_render_object(geometry, slot_itr->second);
+            }
+
+            // The copy the region was merged from brings evicted sections back too
+            geometry.evicted_chunks.erase(section.key);
+        }
+        if(bounds_min.x <= bounds_max.x) {
+            obj.bounding_box.center = (bounds_min + bounds_max) * 0.5f;
+            obj.bounding_box.extents = (bounds_max - bounds_min) * 0.5f;
+        }
+
+        place_chunk_object(geometry, region_key, std::move(obj));
+        region.is_merged = true;
+        geometry.num_merged_regions++;
+
+        NOVA_LOG_HOT(TRACE) << "Merged the " << region.sections.size() << " sections in the region at "
+                            << region.position.x << ", " << region.position.y << ", " << region.position.z;
+        return true;
+    }
+
+    void mesh_store::split_region(shader_geometry& geometry, const chunk_key& region_key, chunk_region& region,
+                                  bool upload_sections) {
+        auto slot_itr = geometry.chunk_slots.find(region_key);
+        if(slot_itr != geometry.chunk_slots.end()) {
+            swap_remove_render_object(geometry, slot_itr->second);
+        }
+
+        for(const auto& section : region.sections) {
+            const auto& def = section.meshes[0];
 
             render_object obj = {};
-            obj.geometry = std::make_unique<gl_mesh>(def);
-            obj.type = geometry_type::block;
-            obj.name = "chunk";
-            obj.parent_id = def.id;
-            obj.color_texture = "block_color";
-            obj.position = def.position;
-            obj.bounding_box.center = {def.position.x+8,def.position.y+8,def.position.z+8};
-            obj.bounding_box.extents = {16, 16, 16};   // TODO: Make these values come from Minecraft
-            obj.needs_deletion=false;
-            const std::string& shader_name = std::get<0>(entry);
-            renderables_grouped_by_shader[shader_name].push_back(std::move(obj));
-
-            chunk_parts_to_upload.pop();
-        }
-        chunk_parts_to_upload_lock.unlock();
-    }
-
-    void mesh_store::remove_chunk_render_object(std::string filter_name, mc_chunk_render_object &chunk) {
-        mesh_definition def = {};
-
-        def.position = {chunk.x, chunk.y, chunk.z};
-        def.id = chunk.id;
-
-        try {
-            if(renderables_grouped_by_shader.find(filter_name) != renderables_grouped_by_shader.end()) {
-                auto& group = renderables_grouped_by_shader.at(filter_name);
-                for(int i=0;i<group.size();i++) {
-                    bool t=(static_cast<int>(group[i].position.x) == static_cast<int>(def.position.x)) &&
-                           (static_cast<int>(group[i].position.y) == static_cast<int>(def.position.y)) &&
-                           (static_cast<int>(group[i].position.z) == static_cast<int>(def.position.z));
-                    if(t){
-                        group[i].needs_deletion=true;
+            if(upload_sections) {
+                add_chunk_meshes(def, section.meshes.data() + 1, section.meshes.size() - 1, obj);
+            } else {
+                geometry.evicted_chunks.insert(section.key);
+            }
+            fill_chunk_object(def, obj);
+            place_chunk_object(geometry, section.key, std::move(obj));
+        }
+
+        region.is_merged = false;
+        region.last_changed_frame = frame_count;
+        geometry.num_merged_regions--;
+    }
+
+    void mesh_store::split_all_regions(shader_geometry& geometry) {
+        if(geometry.num_merged_regions == 0) {
+            return;
+        }
+
+        for(auto& region_entry : geometry.regions) {
+            if(region_entry.second.is_merged) {
+                split_region(geometry, region_entry.first, region_entry.second);
+            }
+        }
+    }
+
+    bool mesh_store::keeps_chunk_copies() const {
+        return region_merging || memory_budget_bytes > 0;
+    }
+
+    uint64_t mesh_store::get_memory_usage() const {
+        const auto& usage = gpu_memory::get_usage();
+        return usage.get_total() - usage.get(gpu_memory_category::chunk_arena) + chunk_geometry.get_bytes_in_use();
+    }
+
+    uint64_t mesh_store::get_memory_budget() const {
+        return memory_budget_bytes;
+    }
+
+    size_t mesh_store::take_chunks_to_rebuild(mc_chunk_position* chunks, size_t max_chunks) {
+        const size_t num_chunks = std::min(max_chunks, chunks_to_rebuild.size());
+        std::copy(chunks_to_rebuild.begin(), chunks_to_rebuild.begin() + num_chunks, chunks);
+        chunks_to_rebuild.erase(chunks_to_rebuild.begin(), chunks_to_rebuild.begin() + num_chunks);
+        return num_chunks;
+    }
+
+    void mesh_store::enforce_memory_budget(const glm::vec3& camera_position) {
+        if(memory_budget_bytes == 0) {
+            return;
+        }
+
+        restore_visible_chunks();
+
+        uint64_t usage = get_memory_usage();
+        if(usage <= memory_budget_bytes) {
+            return;
+        }
+
+        // Chunks that were just seen would only be brought right back
+        const uint64_t recently_visible_frames = 2;
+
+        eviction_candidates.clear();
+        for(shader_id shader = 0; shader < geometry_by_shader.size(); shader++) {
+            for(const auto& obj : geometry_by_shader[shader].objects) {
+                if(obj.type != geometry_type::block || !obj.arena_handle.is_valid() ||
+                   obj.last_visible_frame + recently_visible_frames >= frame_count) {
+                    continue;
+                }
+
+                const glm::vec3 to_object = obj.bounding_box.center - camera_position;
+                const float distance_squared = to_object.x * to_object.x + to_object.y * to_object.y + to_object.z * to_object.z;
+                eviction_candidates.push_back({shader, chunk_key(obj.position, obj.parent_id), obj.last_visible_frame, distance_squared});
+            }
+        }
+
+        std::sort(eviction_candidates.begin(), eviction_candidates.end(), [](const auto& a, const auto& b) {
+            if(a.last_visible_frame != b.last_visible_frame) {
+                return a.last_visible_frame < b.last_visible_frame;
+            }
+            return a.distance_squared > b.distance_squared;
+        });
+
+        const uint64_t target_usage = memory_budget_bytes - memory_budget_bytes / 10;
+        uint64_t bytes_evicted = 0;
+        size_t num_evicted = 0;
+        for(const auto& candidate : eviction_candidates) {
+            if(usage - bytes_evicted <= target_usage) {
+                break;
+            }
+            bytes_evicted += evict_chunk(geometry_by_shader[candidate.shader], candidate.key);
+            num_evicted++;
+        }
+
+        chunk_geometry.release_empty_pages();
+
+        LOG(DEBUG) << "Evicted " << num_evicted << " chunks (" << bytes_evicted << " bytes) to stay under the "
+                   << memory_budget_bytes << " byte memory budget";
+
+        if(usage - bytes_evicted > memory_budget_bytes && !warned_about_memory_budget) {
+            LOG(WARNING) << "Nova is using " << usage - bytes_evicted << " bytes of GPU memory, which is over the "
+                         << memory_budget_bytes << " byte budget even with every chunk that's out of sight evicted";
+            warned_about_memory_budget = true;
+        }
+    }
+
+    uint64_t mesh_store::evict_chunk(shader_geometry& geometry, const chunk_key& key) {
+        auto slot_itr = geometry.chunk_slots.find(key);
+        if(slot_itr == geometry.chunk_slots.end()) {
+            return 0;
+        }
+
+        auto& obj = geometry.objects[slot_itr->second];
+        uint64_t num_bytes = chunk_arena::get_size(obj.arena_handle);
+        for(uint32_t lod = 1; lod < obj.num_lods; lod++) {
+            num_bytes += chunk_arena::get_size(obj.lod_arena_handles[lod - 1]);
+        }
+
+        if(key.id == MERGED_REGION_ID) {
+            auto region_itr = geometry.regions.find(key);
+            if(region_itr != geometry.regions.end()) {
+                split_region(geometry, key, region_itr->second, false);
+                return num_bytes;
+            }
+        }
+
+        free_object_geometry(obj);
+        geometry.evicted_chunks.insert(key);
+        return num_bytes;
+    }
+
+    void mesh_store::restore_visible_chunks() {
+        for(auto& geometry : geometry_by_shader) {
+            for(auto itr = geometry.evicted_chunks.begin(); itr != geometry.evicted_chunks.end();) {
+                const chunk_key key = *itr;
+                auto slot_itr = geometry.chunk_slots.find(key);
+                if(slot_itr == geometry.chunk_slots.end()) {
+                    itr = geometry.evicted_chunks.erase(itr);
+                    continue;
+                }
+
+                const auto& obj = geometry.objects[slot_itr->second];
+                if(obj.last_visible_frame + 1 < frame_count) {
+                    ++itr;
+                    continue;
+                }
+
+                const auto* section = find_region_section(geometry, key, obj.position);
+                if(section == nullptr) {
+                    // Without a copy, all we can do is ask Minecraft to send the chunk again
+                    if(rebuilds_requested.insert(key).second) {
+                        chunks_to_rebuild.push_back({static_cast<int>(obj.position.x), static_cast<int>(obj.position.y),
+                                                     static_cast<int>(obj.position.z), obj.parent_id});
+                    }
+                    ++itr;
+                    continue;
+                }
+
+                const auto& def = section->meshes[0];
+                render_object restored = {};
+                add_chunk_meshes(def, section->meshes.data() + 1, section->meshes.size() - 1, restored);
+                fill_chunk_object(def, restored);
+                place_chunk_object(geometry, key, std::move(restored));
+
+                itr = geometry.evicted_chunks.erase(itr);
+            }
+        }
+    }
+
+    const mesh_store::region_section* mesh_store::find_region_section(const shader_geometry& geometry, const chunk_key& key,
+                                                                      const glm::vec3& position) const {
+        auto region_itr = geometry.regions.find(chunk_key(get_region_position(position), MERGED_REGION_ID));
+        if(region_itr == geometry.regions.end()) {
+            return nullptr;
+        }
+
+        for(const auto& section : region_itr->second.sections) {
+            if(section.key == key) {
+                return section.meshes.empty() ? nullptr : &section;
+            }
+        }
+        return nullptr;
+    }
+
+    void mesh_store::swap_remove_render_object(shader_geometry& geometry, size_t index) {
+        auto& objects = geometry.objects;
+        auto& bounding_boxes = geometry.bounding_boxes;
+        auto& chunk_slots = geometry.chunk_slots;
+
+        auto& removed = objects[index];
+        free_object_geometry(removed);
+        if(removed.type == geometry_type::block) {
+            chunk_slots.erase(chunk_key(removed.position, removed.parent_id));
+        }
+
+        const size_t last_index = objects.size() - 1;
+        if(index != last_index) {
+            objects[index] = std::move(objects[last_index]);
+            bounding_boxes.copy(last_index, index);
+
+            auto& moved = objects[index];
+            if(moved.type == geometry_type::block) {
+                chunk_slots[chunk_key(moved.position, moved.parent_id)] = index;
+            }
+        }
+
+        objects.pop_back();
+        bounding_boxes.resize(last_index);
+    }
+
+    void mesh_store::remove_chunk_render_object(shader_id shader, mc_chunk_render_object &chunk) {
+        chunk_update update = {};
+        update.shader = shader;
+        update.definition.position = {chunk.x, chunk.y, chunk.z};
+        update.definition.id = chunk.id;
+        update.is_removal = true;
+        update.update_id = next_update_id++;
+
+        chunk_parts_to_upload.push(std::move(update));
+    }
+
+    void mesh_store::add_chunk_render_object(shader_id shader, mc_chunk_render_object &chunk) {
+        auto update = copy_chunk_for_conversion(shader, chunk);
+        const float priority = prioritizer.get_priority(update->definition.position);
+        conversion_workers->add_task(make_conversion_task(std::move(update)), priority);
+    }
+
+    void mesh_store::add_chunk_render_objects(const mc_chunk_batch_entry* entries, size_t num_entries, const int* payload, size_t payload_size,
+                                              const std::function<void(const mc_chunk_batch_entry&)>& on_entry_applied) {
+        std::vector<std::pair<std::function<void()>, float>> conversions;
+        conversions.reserve(num_entries);
+
+        for(size_t i = 0; i < num_entries; i++) {
+            const auto& entry = entries[i];
+            if(!is_batch_entry_in_payload(entry, payload_size)) {
+                LOG(WARNING) << "Chunk " << entry.id << " in a batch has data outside the batch's payload, skipping it";
+                continue;
+            }
+            if(!is_chunk_valid(entry.shader_id, entry.format, entry.id, entry.vertex_buffer_size == 0)) {
+                continue;
+            }
+            if(on_entry_applied) {
+                on_entry_applied(entry);
+            }
+
+            mc_chunk_render_object chunk = {};
+            chunk.format = entry.format;
+            chunk.x = entry.x;
+            chunk.y = entry.y;
+            chunk.z = entry.z;
+            chunk.id = entry.id;
+            const auto shader = static_cast<shader_id>(entry.shader_id);
+
+            if(entry.vertex_buffer_size == 0) {
+                remove_chunk_render_object(shader, chunk);
+                continue;
+            }
+
+            // The chunk only points into the payload, and copy_chunk_for_conversion copies it out
+            chunk.vertex_data = const_cast<int*>(payload + entry.vertex_offset);
+            chunk.vertex_buffer_size = entry.vertex_buffer_size;
+            chunk.indices = const_cast<int*>(payload + entry.index_offset);
+            chunk.index_buffer_size = entry.index_buffer_size;
+
+            auto update = copy_chunk_for_conversion(shader, chunk);
+            const float priority = prioritizer.get_priority(update->definition.position);
+            conversions.emplace_back(make_conversion_task(std::move(update)), priority);
+        }
+
+        conversion_workers->add_tasks(std::move(conversions));
+    }
+
+    bool mesh_store::is_batch_entry_in_payload(const mc_chunk_batch_entry& entry, size_t payload_size) {
+        if(entry.vertex_offset < 0 || entry.vertex_buffer_size < 0 || entry.index_offset < 0 || entry.index_buffer_size < 0) {
+            return false;
+        }
+
+        const auto vertex_end = static_cast<uint64_t>(entry.vertex_offset) + static_cast<uint64_t>(entry.vertex_buffer_size);
+        const auto index_end = static_cast<uint64_t>(entry.index_offset) + static_cast<uint64_t>(entry.index_buffer_size);
+        return vertex_end <= payload_size && index_end <= payload_size;
+    }
+
+    std::shared_ptr<mesh_store::chunk_update> mesh_store::copy_chunk_for_conversion(shader_id shader, const mc_chunk_render_object& chunk) {
+        // Minecraft frees the chunk's buffers once we return, so we need our own copy. A straight copy is all we do on
+        // this thread, the workers do the rest
+        chunk_update update = {};
+        update.shader = shader;
+        update.mc_vertex_data = chunk_buffers.acquire(static_cast<size_t>(chunk.vertex_buffer_size));
+        update.mc_vertex_data.assign(chunk.vertex_data, chunk.vertex_data + chunk.vertex_buffer_size);
+        update.definition.indices = chunk_buffers.acquire(static_cast<size_t>(chunk.index_buffer_size));
+        update.definition.indices.assign(chunk.indices, chunk.indices + chunk.index_buffer_size);
+        update.definition.vertex_format = format::all_values()[chunk.format];
+        update.definition.position = {chunk.x, chunk.y, chunk.z};
+        update.definition.id = chunk.id;
+        update.is_removal = false;
+
+        // Count the chunk as in flight before it gets its ID. See upload_new_geometry for why
+        chunks_being_converted++;
+        update.update_id = next_update_id++;
+
+        return std::make_shared<chunk_update>(std::move(update));
+    }
+
+    std::function<void()> mesh_store::make_conversion_task(std::shared_ptr<chunk_update> update) {
+        return [this, shared_update = std::move(update)]() {
+            auto& def = shared_update->definition;
+            const auto& mc_vertex_data = shared_update->mc_vertex_data;
+            const size_t num_vertices = mc_vertex_data.size() / mc_block_layout::ints_per_vertex;
+            const bool is_block_geometry = def.vertex_format == format::POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT;
+            const bool pack_vertices = is_block_geometry && takes_packed_vertices(shared_update->shader);
+            if(is_block_geometry && generate_lods) {
+                build_chunk_lods(mc_vertex_data, pack_vertices, *shared_update);
+            }
+
+            if(pack_vertices) {
+                // Block geometry gets the packed format, which is less than half the size
+                def.vertex_data = chunk_buffers.acquire(num_vertices * packed_block_layout::ints_per_vertex);
+                pack_chunk_vertices(mc_vertex_data, def.indices, def.vertex_data);
+                def.vertex_format = format::PACKED_POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT;
+            } else {
+                def.vertex_data = chunk_buffers.acquire(num_vertices * block_layout::ints_per_vertex + mc_vertex_data.size() % mc_block_layout::ints_per_vertex);
+                convert_chunk_vertices(mc_vertex_data, def.vertex_data);
+            }
+            chunk_buffers.release(std::move(shared_update->mc_vertex_data));
+
+            // Adding a chunk that's already there replaces it, so there's no need to remove it first
+            chunk_parts_to_upload.push(std::move(*shared_update));
+            chunks_being_converted--;
+        };
+    }
+
+    uint64_t mesh_store::add_chunk_render_object_direct(shader_id shader, mc_chunk_render_object &chunk) {
+        chunk_update update = {};
+        update.shader = shader;
+        update.definition.vertex_format = format::all_values()[chunk.format];
+        update.definition.position = {chunk.x, chunk.y, chunk.z};
+        update.definition.id = chunk.id;
+        update.is_removal = false;
+        update.update_id = next_update_id++;
+
+        update.direct_vertex_data = chunk.vertex_data;
+        update.direct_vertex_data_size = static_cast<size_t>(chunk.vertex_buffer_size);
+        update.direct_indices = chunk.indices;
+        update.direct_index_count = static_cast<size_t>(chunk.index_buffer_size);
+        update.direct_upload_ticket = next_direct_upload_ticket++;
+
+        const uint64_t ticket = update.direct_upload_ticket;
+        {
+            std::lock_guard<std::mutex> lock(pending_direct_upload_tickets_lock);
+            pending_direct_upload_tickets.insert(ticket);
+        }
+
+        chunk_parts_to_upload.push(std::move(update));
+        return ticket;
+    }
+
+    void mesh_store::set_shader_takes_packed_vertices(shader_id shader, bool takes_packed_vertices) {
+        {
+            std::lock_guard<std::mutex> lock(packed_vertex_shaders_lock);
+            const bool took_packed_vertices = packed_vertex_shaders.count(shader) != 0;
+            if(took_packed_vertices == takes_packed_vertices) {
+                return;
+            }
+
+            if(takes_packed_vertices) {
+                packed_vertex_shaders.insert(shader);
+            } else {
+                packed_vertex_shaders.erase(shader);
+            }
+        }
+
+        // Chunks that are still being converted may have been packed the old way, so they're asked for again too
+        request_rebuild_of_shader(shader);
+    }
+
+    bool mesh_store::takes_packed_vertices(shader_id shader) const {
+        std::lock_guard<std::mutex> lock(packed_vertex_shaders_lock);
+        return packed_vertex_shaders.count(shader) != 0;
+    }
+
+    void mesh_store::request_rebuild_of_shader(shader_id shader) {
+        if(shader >= geometry_by_shader.size()) {
+            return;
+        }
+
+        auto request_rebuild = [&](const chunk_key& key, const glm::vec3& position) {
+            if(rebuilds_requested.insert(key).second) {
+                chunks_to_rebuild.push_back({static_cast<int>(position.x), static_cast<int>(position.y),
+                                             static_cast<int>(position.z), key.id});
+            }
+        };
+
+        const auto& geometry = geometry_by_shader[shader];
+        for(const auto& obj : geometry.objects) {
+            if(obj.type == geometry_type::block && obj.parent_id != MERGED_REGION_ID) {
+                request_rebuild(chunk_key(obj.position, obj.parent_id), obj.position);
+            }
+        }
+
+        // A merged region's sections aren't in the list of objects, but each one has a copy that knows where it is
+        for(const auto& region : geometry.regions) {
+            if(!region.second.is_merged) {
+                continue;
+            }
+            for(const auto& section : region.second.sections) {
+                if(!section.meshes.empty()) {
+                    request_rebuild(section.key, section.meshes[0].position);
+                }
+            }
+        }
+    }
+
+    void mesh_store::set_mesher_block_type(const mc_mesher_block_type& block_type) {
+        if(block_type.block_id < 0 || block_type.block_id > UINT16_MAX) {
+            LOG(WARNING) << "Block ID " << block_type.block_id << " is out of range for the native mesher, ignoring it";
+            return;
+        }
+
+        mesher_block_type type;
+        type.is_visible = block_type.is_visible != 0;
+        type.is_opaque = block_type.is_opaque != 0;
+        type.shader = static_cast<shader_id>(block_type.shader_id);
+        for(int face = 0; face < 6; face++) {
+            const float* uvs = &block_type.face_uvs[face * 4];
+            type.tile_rects[face] = glm::vec4(uvs[0], uvs[2], uvs[1] - uvs[0], uvs[3] - uvs[2]);
+            type.tints[face] = static_cast<uint32_t>(block_type.face_tints[face]);
+        }
+
+        std::lock_guard<std::mutex> lock(mesher_block_types_lock);
+        if(mesher_block_types.use_count() > 1) {
+            mesher_block_types = std::make_shared<mesher_blocks>(*mesher_block_types);
+        }
+
+        auto& types = mesher_block_types->types;
+        const auto id = static_cast<size_t>(block_type.block_id);
+        if(id >= types.size()) {
+            types.resize(id + 1);
+        }
+        types[id] = type;
+
+        auto& shaders = mesher_block_types->shaders;
+        if(type.is_visible && std::find(shaders.begin(), shaders.end(), type.shader) == shaders.end()) {
+            shaders.push_back(type.shader);
+            mesher_block_types->shader_names.push_back(get_shader_name(type.shader));
+        }
+        mesher_block_types->has_resource_hash = false;
+    }
+
+    uint64_t mesh_store::hash_mesher_blocks(const mesher_blocks& blocks) {
+        uint64_t hash = chunk_mesh_cache::add_to_hash(chunk_mesh_cache::FNV_OFFSET_BASIS, &MESHER_VERSION, sizeof(MESHER_VERSION));
+
+        // Field by field, so the padding in mesher_block_type doesn't end up in the hash
+        for(const auto& type : blocks.types) {
+            const uint8_t flags = static_cast<uint8_t>((type.is_visible ? 1 : 0) | (type.is_opaque ? 2 : 0));
+            hash = chunk_mesh_cache::add_to_hash(hash, &flags, sizeof(flags));
+            hash = chunk_mesh_cache::add_to_hash(hash, &type.shader, sizeof(type.shader));
+            hash = chunk_mesh_cache::add_to_hash(hash, type.tile_rects, sizeof(type.tile_rects));
+            hash = chunk_mesh_cache::add_to_hash(hash, type.tints, sizeof(type.tints));
+        }
+
+        // Shader IDs only mean something next to their names
+        for(size_t i = 0; i < blocks.shaders.size(); i++) {
+            hash = chunk_mesh_cache::add_to_hash(hash, &blocks.shaders[i], sizeof(shader_id));
+            hash = chunk_mesh_cache::add_to_hash(hash, blocks.shader_names[i].data(), blocks.shader_names[i].size() + 1);
+        }
+        return hash;
+    }
+
+    void mesh_store::add_chunk_section_blocks(const mc_chunk_section_blocks& section) {
+        auto block_ids = std::make_shared<std::vector<uint16_t>>(section.block_ids, section.block_ids + PADDED_SECTION_VOLUME);
+        auto light = std::make_shared<std::vector<uint8_t>>(section.light, section.light + PADDED_SECTION_VOLUME);
+
+        std::shared_ptr<const mesher_blocks> blocks;
+        chunk_mesh_cache_key cache_key = {};
+        {
+            std::lock_guard<std::mutex> lock(mesher_block_types_lock);
+            if(!mesher_block_types->has_resource_hash) {
+                mesher_block_types->resource_hash = hash_mesher_blocks(*mesher_block_types);
+                mesher_block_types->has_resource_hash = true;
+            }
+            blocks = mesher_block_types;
+            cache_key.resource_hash = blocks->resource_hash;
+        }
+
+        std::shared_ptr<chunk_mesh_cache> cache;
+        {
+            std::lock_guard<std::mutex> lock(mesh_cache_lock);
+            cache = mesh_cache;
+            cache_key.dimension = mesh_cache_dimension;
+        }
+
+        const glm::vec3 position(section.x, section.y, section.z);
+        const int id = section.id;
+        cache_key.x = static_cast<int>(std::floor(section.x));
+        cache_key.y = static_cast<int>(std::floor(section.y));
+        cache_key.z = static_cast<int>(std::floor(section.z));
+
+        // Every shader's part of the section shares one update ID, since they're all from the same blocks
+        chunks_being_converted++;
+        const uint64_t update_id = next_update_id++;
+
+        conversion_workers->add_task([this, block_ids, light, blocks, cache, cache_key, position, id, update_id]() mutable {
+            const bool merge_faces = merge_section_faces;
+
+            std::vector<cached_section_mesh> meshes;
+            bool was_cached = false;
+            if(cache) {
+                cache_key.content_hash = chunk_mesh_cache::hash_section(block_ids->data(), light->data(), PADDED_SECTION_VOLUME);
+                const uint8_t merge_flag = merge_faces ? 1 : 0;
+                cache_key.resource_hash = chunk_mesh_cache::add_to_hash(cache_key.resource_hash, &merge_flag, sizeof(merge_flag));
+                was_cached = cache->load(cache_key, meshes);
+            }
+
+            if(!was_cached) {
+                thread_local greedy_mesher mesher;
+                thread_local std::vector<int> mesher_vertex_data;
+                thread_local std::vector<int> mesher_indices;
+                mesher.load_section(block_ids->data(), light->data(), blocks->types);
+                const auto& shaders_with_faces = mesher.get_shaders();
+
+                for(size_t i = 0; i < blocks->shaders.size(); i++) {
+                    const shader_id shader = blocks->shaders[i];
+                    if(std::find(shaders_with_faces.begin(), shaders_with_faces.end(), shader) == shaders_with_faces.end()) {
+                        continue;
                     }
+
+                    cached_section_mesh mesh;
+                    mesh.shader_name = blocks->shader_names[i];
+                    // The mesher doesn't know how big the mesh is until it's done, so it works in scratch vectors
+                    // and the mesh gets pooled ones of the right size
+                    mesher.mesh(shader, merge_faces, mesher_vertex_data, mesher_indices);
+                    mesh.definition.vertex_data = chunk_buffers.acquire(mesher_vertex_data.size());
+                    mesh.definition.vertex_data.assign(mesher_vertex_data.begin(), mesher_vertex_data.end());
+                    mesh.definition.indices = chunk_buffers.acquire(mesher_indices.size());
+                    mesh.definition.indices.assign(mesher_indices.begin(), mesher_indices.end());
+                    mesh.definition.vertex_format = format::TILED_POS_COLOR_UV_LIGHTMAPUV_NORMAL_TILE;
+                    meshes.push_back(std::move(mesh));
+                }
+
+                if(cache) {
+                    cache->save(cache_key, meshes);
+                }
+            }
+
+            for(size_t i = 0; i < blocks->shaders.size(); i++) {
+                chunk_update update = {};
+                update.shader = blocks->shaders[i];
+                update.update_id = update_id;
+
+                auto mesh = std::find_if(meshes.begin(), meshes.end(), [&](const cached_section_mesh& candidate) {
+                    return candidate.shader_name == blocks->shader_names[i];
+                });
+                if(mesh != meshes.end()) {
+                    update.definition = std::move(mesh->definition);
+                } else {
+                    // The section might have had blocks for this shader before
+                    update.is_removal = true;
                 }
+                update.definition.position = position;
+                update.definition.id = id;
+
+                chunk_parts_to_upload.push(std::move(update));
             }
-        } catch(std::exception& e) {
-            LOG(ERROR)<<"REMOVING CHUNK ERROR: " << e.what();
+            chunks_being_converted--;
+        }, prioritizer.get_priority(position));
+    }
+
+    void mesh_store::set_mesh_cache_world(const std::string& world_name, int dimension) {
+        std::lock_guard<std::mutex> lock(mesh_cache_lock);
+        mesh_cache_dimension = dimension;
+        if(world_name == mesh_cache_world && (mesh_cache || !use_mesh_cache)) {
+            return;
+        }
+
+        mesh_cache_world = world_name;
+        mesh_cache.reset();
+        if(world_name.empty() || !use_mesh_cache) {
+            return;
         }
+
+        // World names can have anything in them, but file names can't
+        std::string file_name = world_name;
+        for(char& c : file_name) {
+            if(!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_') {
+                c = '_';
+            }
+        }
+
+        make_directory(mesh_cache_directory);
+        mesh_cache = std::make_shared<chunk_mesh_cache>(mesh_cache_directory + "/" + file_name + ".nmc", mesh_cache_max_bytes);
     }
 
-    void mesh_store::add_chunk_render_object(std::string filter_name, mc_chunk_render_object &chunk) {
-        mesh_definition def = {};
-        auto& vertex_data = def.vertex_data;
+    bool mesh_store::is_direct_upload_complete(uint64_t ticket) {
+        std::lock_guard<std::mutex> lock(pending_direct_upload_tickets_lock);
+        return pending_direct_upload_tickets.find(ticket) == pending_direct_upload_tickets.end();
+    }
+
+    void mesh_store::convert_chunk_vertices(const std::vector<int>& mc_vertex_data, std::vector<int>& vertex_data) {
+        // The normals and tangents are left 0, since we don't compute those yet
+        widen_vertices<mc_block_layout, block_layout>(mc_vertex_data, vertex_data);
+    }
 
-        for(int i = 0; i < chunk.vertex_buffer_size; i++) {
-            vertex_data.push_back(chunk.vertex_data[i]);
+    void mesh_store::build_chunk_lods(const std::vector<int>& mc_vertex_data, bool pack_vertices, chunk_update& update) {
+        // Each level has to drop at least a quarter of the triangles in the level before it to be worth drawing
+        const float max_kept_fraction = 0.75f;
 
-            if(i % 7 == 6) {
-                // Add 0s for the normals and tangets since we don't compute those yet
-                vertex_data.push_back(0);
-                vertex_data.push_back(0);
-                vertex_data.push_back(0);
-                vertex_data.push_back(0);
-                vertex_data.push_back(0);
-                vertex_data.push_back(0);
+        // A chunk that came without indices is quads, but the simplifier needs to see its triangles
+        std::vector<int> quad_indices;
+        if(update.definition.indices.empty()) {
+            const auto num_vertices = static_cast<uint32_t>(mc_vertex_data.size() / mc_block_layout::ints_per_vertex);
+            quad_indices = chunk_buffers.acquire(num_vertices / 4 * 6);
+            append_quad_indices(0, num_vertices, quad_indices);
+        }
+        const auto& indices = update.definition.indices.empty() ? quad_indices : update.definition.indices;
+
+        std::vector<int> lod_vertex_data = chunk_buffers.acquire(mc_vertex_data.size());
+        std::vector<int> lod_indices = chunk_buffers.acquire(indices.size());
+        size_t previous_index_count = indices.size();
+
+        for(float cell_size : CHUNK_LOD_CELL_SIZES) {
+            simplify_chunk_mesh(mc_vertex_data, indices, cell_size, lod_vertex_data, lod_indices);
+            if(lod_indices.empty() || lod_indices.size() > previous_index_count * max_kept_fraction) {
+                break;
             }
+            previous_index_count = lod_indices.size();
+
+            mesh_definition lod = {};
+            const size_t num_lod_vertices = lod_vertex_data.size() / mc_block_layout::ints_per_vertex;
+            if(pack_vertices) {
+                lod.vertex_data = chunk_buffers.acquire(num_lod_vertices * packed_block_layout::ints_per_vertex);
+                pack_chunk_vertices(lod_vertex_data, lod_indices, lod.vertex_data);
+            } else {
+                lod.vertex_data = chunk_buffers.acquire(num_lod_vertices * block_layout::ints_per_vertex);
+                convert_chunk_vertices(lod_vertex_data, lod.vertex_data);
+            }
+            lod.indices = chunk_buffers.acquire(lod_indices.size());
+            lod.indices.assign(lod_indices.begin(), lod_indices.end());
+            update.lods.push_back(std::move(lod));
         }
 
-        for(int i = 0; i < chunk.index_buffer_size; i++) {
-            def.indices.push_back(chunk.indices[i]);
+        chunk_buffers.release(std::move(lod_vertex_data));
+        chunk_buffers.release(std::move(lod_indices));
+        chunk_buffers.release(std::move(quad_indices));
+    }
+
+    void mesh_store::free_object_geometry(render_object& obj) {
+        changed_bounds.push_back(obj.bounding_box);
+        chunk_geometry.free_mesh(obj.arena_handle);
+        for(uint32_t lod = 1; lod < obj.num_lods; lod++) {
+            chunk_geometry.free_mesh(obj.lod_arena_handles[lod - 1]);
         }
+        obj.num_lods = 1;
+        obj.current_lod = 0;
+        object_data.remove(obj.object_slot);
+    }
+
+    const chunk_lod_settings& mesh_store::get_lod_settings() const {
+        return lod_settings;
+    }
+
+    const render_material& mesh_store::get_material(material_id id) const {
+        return materials.get(id);
+    }
+
+    const std::string& mesh_store::get_name(name_id id) const {
+        return names.get(id);
+    }
 
-        def.vertex_format = format::all_values()[chunk.format];
-        def.position = {chunk.x, chunk.y, chunk.z};
-        def.id = chunk.id;
-        remove_chunk_render_object(filter_name,chunk);
-        chunk_parts_to_upload_lock.lock();
-        chunk_parts_to_upload.emplace(filter_name, def);
-        chunk_parts_to_upload_lock.unlock();
+    void mesh_store::take_changed_bounds(std::vector<aabb>& bounds) {
+        bounds.clear();
+        std::swap(bounds, changed_bounds);
     }
 
     void mesh_store::remove_render_objects_with_parent(long parent_id) {
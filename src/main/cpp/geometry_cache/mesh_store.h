@@ -13,51 +13,359 @@
 #include <functional>
 #include <unordered_map>
 #include <queue>
+#include <atomic>
+#include <memory>
+#include <unordered_set>
 #include "../render/objects/render_object.h"
+#include "../render/objects/chunk_arena.h"
+#include "../render/objects/object_data_buffer.h"
+#include "../render/objects/gui_batcher.h"
+#include "aabb_table.h"
+#include "chunk_key.h"
+#include "chunk_lod.h"
+#include "greedy_mesher.h"
+#include "chunk_mesh_cache.h"
+#include "region_merger.h"
+#include "upload_prioritizer.h"
+#include "../utils/buffer_pool.h"
+#include "../utils/mpsc_queue.h"
+#include "../utils/thread_pool.h"
 #include "../render/objects/shaders/shaderpack.h"
 #include "../mc_interface/mc_gui_objects.h"
 #include "../mc_interface/mc_objects.h"
+#include "../data_loading/settings.h"
 
 namespace nova {
+    /*!
+     * \brief Names a shader's geometry without needing its string name. See mesh_store#get_shader_id
+     */
+    typedef uint32_t shader_id;
+
+    class upload_context;
+
     /*!
          * \brief Provides access to the meshes that Nova will want to deal with
          *
          * The primary way it does this is by allowing the user to specify
          */
-    class mesh_store {
+    class mesh_store : public iconfig_listener {
     public:
+        /*!
+         * \brief Starts the worker threads that convert chunk geometry
+         */
+        mesh_store();
+
+        /*!
+         * \brief Waits for any chunks that are still being written on the upload thread
+         */
+        ~mesh_store();
+
+        /*!
+         * \brief Moves copying chunks into the arena onto the given upload context's thread. Chunks are drawn once
+         * they've been written. Without an upload context, or if its thread isn't running, chunks are copied on the
+         * render thread
+         */
+        void set_upload_context(upload_context* uploads);
+
+        /*!
+         * \brief Adds the given GUI geometry to the GUI batcher
+         *
+         * The command's memory can be freed as soon as this returns
+         */
         void add_gui_buffers(mc_gui_geometry* command);
 
+        /*!
+         * \brief Gets the ID for the shader with the given name, giving it a new one if it doesn't have one yet
+         *
+         * IDs start at 0 and count up, and a shader keeps its ID for as long as the mesh store is around, even if a
+         * new shaderpack is loaded. Minecraft asks for every shader's ID once and uses them from then on, so adding
+         * chunks never has to look a name up. Can be called from any thread
+         */
+        shader_id get_shader_id(const std::string& shader_name);
+
+        /*!
+         * \brief Checks if get_shader_id has given out the given ID. Can be called from any thread
+         */
+        bool has_shader_id(int shader);
+
+        /*!
+         * \brief Checks if the given number is one of the vertex formats a chunk can be in
+         */
+        static bool is_chunk_format_valid(int vertex_format);
+
+        /*!
+         * \brief Checks that a chunk from Minecraft has an ID from get_shader_id, and a format Nova knows if it has
+         * vertices. Logs a warning saying what's wrong if it doesn't. Can be called from any thread
+         *
+         * \param is_removal Removals have no vertices, so their format doesn't matter
+         */
+        bool is_chunk_valid(int shader, int vertex_format, int chunk_id, bool is_removal);
+
         /*!
          * \brief Adds a chunk to the mesh store if the chunk doesn't exist, or replaces the chunks if it does exist
          *
+         * This copies the chunk's data and hands it to a worker thread to be converted into a mesh_definition, so it
+         * returns right away. The chunk shows up the first time upload_new_geometry is called after the worker is done
+         *
+         * \param shader The ID of the shader whose filter the chunk passed
          * \param chunk The chunk to add or update
          */
-        void add_chunk_render_object(std::string filter_name, mc_chunk_render_object &chunk);
+        void add_chunk_render_object(shader_id shader, mc_chunk_render_object &chunk);
+
+        /*!
+         * \brief Adds or replaces a chunk without copying its data
+         *
+         * The chunk's vertex_data must already be in the 13-int POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT layout (or
+         * whatever layout its format says), and it and the chunk's indices must stay alive and unchanged until
+         * is_direct_upload_complete returns true for the returned ticket. The render thread copies the data straight
+         * into the chunk arena
+         *
+         * \param shader The ID of the shader whose filter the chunk passed
+         * \param chunk The chunk to add. Its data pointers usually point into Java direct ByteBuffers
+         * \return A ticket to pass to is_direct_upload_complete
+         */
+        uint64_t add_chunk_render_object_direct(shader_id shader, mc_chunk_render_object &chunk);
+
+        /*!
+         * \brief Adds or removes many chunks at once, like calling add_chunk_render_object or
+         * remove_chunk_render_object for each of them
+         *
+         * A rebuilt chunk column has geometry for several filters in each of its sections, so Minecraft sends them all
+         * together instead of one call each. The chunks are copied out of the payload in order, so the payload can be
+         * freed as soon as this returns, and their conversions are queued all at once. Entries whose data isn't inside
+         * the payload, or whose shader ID or format isn't valid, are skipped
+         *
+         * \param entries The chunks to add, or to remove if they have no vertices
+         * \param num_entries How many entries there are
+         * \param payload The vertices and indices of every chunk in the batch
+         * \param payload_size How many ints are in the payload
+         * \param on_entry_applied Called with each entry that wasn't skipped, before its conversion is queued
+         */
+        void add_chunk_render_objects(const mc_chunk_batch_entry* entries, size_t num_entries, const int* payload, size_t payload_size,
+                                      const std::function<void(const mc_chunk_batch_entry&)>& on_entry_applied = nullptr);
+
+        /*!
+         * \brief Checks that all of a batch entry's vertices and indices are inside a payload of the given size
+         */
+        static bool is_batch_entry_in_payload(const mc_chunk_batch_entry& entry, size_t payload_size);
+
+        /*!
+         * \brief Checks if the Nova is done reading the data for the given direct upload ticket
+         *
+         * Can be called from any thread
+         */
+        bool is_direct_upload_complete(uint64_t ticket);
+
+        /*!
+         * \brief Says whether the shader with the given ID can draw block chunks in the packed vertex format
+         *
+         * Only shaders that read the object_data block can tell packed chunks from unpacked ones, so every other
+         * shader gets its block chunks in the 13-int layout. Chunks that were converted for the other choice are
+         * asked for again through take_chunks_to_rebuild. Must be called from the render thread
+         */
+        void set_shader_takes_packed_vertices(shader_id shader, bool takes_packed_vertices);
+
+        /*!
+         * \brief Tells the native mesher how to draw a kind of block. Can be called from any thread
+         *
+         * Sections that are already being meshed keep using the block types they started with
+         */
+        void set_mesher_block_type(const mc_mesher_block_type& block_type);
+
+        /*!
+         * \brief Meshes a chunk section from its blocks on the worker threads, and then adds it like
+         * add_chunk_render_object would
+         *
+         * The section gets a mesh for every shader that its blocks pass, and is removed from every other shader that
+         * the block types use. The block arrays are copied, so they can be freed as soon as this returns
+         */
+        void add_chunk_section_blocks(const mc_chunk_section_blocks& section);
+
+        /*!
+         * \brief Starts keeping the native mesher's sections in the on-disk cache for the given world. Can be called
+         * from any thread
+         *
+         * Every world gets its own cache file, which holds all of its dimensions. Sections that are sent to
+         * add_chunk_section_blocks after this are looked up in the cache by their position and a hash of their blocks,
+         * and only sections that aren't there are meshed. Sections that are already being meshed use whichever cache
+         * was open when they were sent
+         *
+         * \param world_name The name of the world, or an empty string to stop using the cache
+         * \param dimension The dimension that sections will be sent from
+         */
+        void set_mesh_cache_world(const std::string& world_name, int dimension);
 
         /*!
          * \brief Removes a chunk's geometry for the specified filter
          *
-         * \param filter_name The name of the filter to remove the chunk geometry from
+         * The removal happens the next time upload_new_geometry is called
+         *
+         * \param shader The ID of the shader to remove the chunk geometry from
          * \param chunk The chunk to remove
          */
-        void remove_chunk_render_object(std::string filter_name, mc_chunk_render_object &chunk);
+        void remove_chunk_render_object(shader_id shader, mc_chunk_render_object &chunk);
         
         /*!
-         * \brief Retrieves the list of meshes that the shader with the provided name should render
+         * \brief Retrieves the list of meshes that the shader with the provided ID should render
+         *
+         * \param shader The ID of the shader to get meshes for
+         * \return All the meshes that should be rendered with the given shader
+         */
+        std::vector<render_object>& get_meshes_for_shader(shader_id shader);
+
+        /*!
+         * \brief Finds which of the meshes for the given shader are inside the given frustum
+         *
+         * \param shader The ID of the shader to cull meshes for
+         * \param view_frustum The frustum to cull against
+         * \param visible_indices Filled with the indices, into the list returned by get_meshes_for_shader, of the
+         * visible meshes
+         */
+        void cull_meshes_for_shader(shader_id shader, const frustum& view_frustum, std::vector<uint32_t>& visible_indices);
+
+        /*!
+         * \brief Notes that the shader's meshes at the given indices passed culling this frame
+         *
+         * Meshes that have been seen recently aren't evicted when the mesh store is over its memory budget, and
+         * evicted meshes that are seen again are brought back
+         *
+         * \param shader The ID of the shader whose meshes were culled
+         * \param visible_indices The indices from cull_meshes_for_shader
+         */
+        void mark_visible(shader_id shader, const std::vector<uint32_t>& visible_indices);
+
+        /*!
+         * \brief Reorders the shader's meshes so the farthest from the camera comes first, for drawing transparent
+         * geometry back to front
+         *
+         * The camera barely moves between frames, so last frame's order is almost right. It's fixed up with an
+         * insertion sort, which only moves the meshes that are out of place, unless so much has changed that a full
+         * sort is quicker. Culling keeps the order, so the visible meshes come out sorted too
+         *
+         * \param shader The ID of the shader whose meshes should be sorted
+         * \param camera_position Where the camera is
+         */
+        void sort_back_to_front(shader_id shader, const glm::vec3& camera_position);
+
+        /*!
+         * \brief Reorders the visible indices from cull_meshes_for_shader so the closest mesh comes first
+         *
+         * Drawing opaque geometry front to back lets the depth test throw out hidden fragments before they're shaded.
+         * Only the visible indices are sorted. The meshes stay where they are, since sort_back_to_front might want
+         * them the other way around
+         *
+         * \param shader The ID of the shader whose meshes were culled
+         * \param camera_position Where the camera is
+         * \param visible_indices The indices to sort
+         */
+        void sort_front_to_back(shader_id shader, const glm::vec3& camera_position, std::vector<uint32_t>& visible_indices);
+
+        /*!
+         * \brief Takes geometry that's been added since the last frame and sends it to the GPU
+         *
+         * Chunk removals are applied right away. New chunks are uploaded closest-first until the per-frame upload
+         * budget (chunkUploadBudgetBytes and chunkUploadBudgetMicroseconds in the settings) runs out, and the rest wait
+         * for the next frame. A budget of 0 means no limit. At least one chunk is uploaded each frame
+         *
+         * Afterwards, far away regions whose sections haven't changed in a while are merged, and chunk geometry is
+         * evicted if we're over the memory budget. See merge_stable_regions and enforce_memory_budget
+         *
+         * \param camera_position Where the player's camera is, used to decide which chunks to upload first
+         */
+        void upload_new_geometry(const glm::vec3& camera_position);
+
+        /*!
+         * \brief Checks if any chunks are still being converted or are waiting to be uploaded. Must be called from the
+         * render thread
+         */
+        bool has_pending_chunks() const;
+
+        /*!
+         * \brief Checks if any chunks are still being converted on the worker threads. Can be called from any thread
+         */
+        bool has_chunks_being_converted() const;
+
+        void on_config_change(nlohmann::json& new_config) override;
+
+        void on_config_loaded(nlohmann::json& config) override;
+
+        /*!
+         * \brief Returns the arena that holds all the chunk geometry, so the renderer can draw from it
+         */
+        chunk_arena& get_chunk_arena();
+
+        /*!
+         * \brief Returns the batcher that holds all the GUI geometry, so the renderer can draw it
+         */
+        gui_batcher& get_gui_batcher();
+
+        /*!
+         * \brief Returns what decides which chunks are converted and uploaded first. The renderer gives it the camera
+         * every frame
+         */
+        upload_prioritizer& get_upload_prioritizer();
+
+        /*!
+         * \brief Returns the buffer with every chunk's position, so the renderer can bind it for shaders that read it
+         */
+        object_data_buffer& get_object_data();
+
+        /*!
+         * \brief Returns the thresholds the renderer should use to pick each chunk section's level of detail
+         */
+        const chunk_lod_settings& get_lod_settings() const;
+
+        /*!
+         * \brief Gets the textures that render objects with the given material are drawn with
+         */
+        const render_material& get_material(material_id id) const;
+
+        /*!
+         * \brief Gets the name of a render object, for debugging
+         */
+        const std::string& get_name(name_id id) const;
+
+        /*!
+         * \brief How much GPU memory is counted against the vramBudgetMegabytes setting
+         *
+         * That's everything gpu_memory tracks, except the chunk arena counts the bytes meshes are using instead of
+         * the size of its pages. Must be called from the render thread
+         */
+        uint64_t get_memory_usage() const;
+
+        /*!
+         * \brief The memory budget in bytes, or 0 if there isn't one
+         */
+        uint64_t get_memory_budget() const;
+
+        /*!
+         * \brief How many chunk updates were skipped because the same section was sent again before they were
+         * uploaded. Must be called from the render thread
+         */
+        uint64_t get_num_superseded_uploads() const;
+
+        /*!
+         * \brief Hands over chunks that were evicted without a copy to restore them from, and have been seen again
+         *
+         * Minecraft should send these chunks again with add_chunk_render_object. Until it does they aren't drawn.
+         * Must be called from the render thread
          *
-         * \param shader_name The name of the shader to get meshes for
-         * \return All the meshes that should be rendered with the given name
+         * \param chunks Filled with up to max_chunks chunks. Each one is only handed over once
+         * \param max_chunks The most chunks to hand over
+         * \return How many chunks were written to chunks
          */
-        std::vector<render_object>& get_meshes_for_shader(std::string shader_name);
+        size_t take_chunks_to_rebuild(mc_chunk_position* chunks, size_t max_chunks);
 
         /*!
-         * \brief Takes geometry that's been added in the last frame and sends it to the GPU
+         * \brief Hands over the bounding boxes of every chunk that's been added, replaced, or removed since the last
+         * call, so views of the world that are kept between frames know what to redraw
+         *
+         * \param bounds Cleared, then filled with the bounding boxes
          */
-        void upload_new_geometry();
+        void take_changed_bounds(std::vector<aabb>& bounds);
 
         /*!
-        * \brief Removes all gui render objects and thereby deletes all the buffers
+        * \brief Removes all the GUI geometry
         */
         void remove_gui_render_objects();
 
@@ -71,13 +379,394 @@ namespace nova {
         void remove_render_objects_with_parent(long parent_id);
 
     private:
-        std::unordered_map<std::string, std::vector<render_object>> renderables_grouped_by_shader;
+        /*!
+         * \brief A section that's in a region, along with the copy of its meshes that the region is merged from
+         */
+        struct region_section {
+            chunk_key key;
+
+            /*!
+             * \brief The section's mesh at every level of detail, full detail first. Only the first one has its format
+             * and position filled in. Empty if we don't have a copy, which keeps the region from being merged
+             */
+            std::vector<mesh_definition> meshes;
+        };
+
+        /*!
+         * \brief REGION_SIZE_IN_SECTIONS sections in each direction, which are drawn as one mesh when they're stable
+         * and far away
+         *
+         * While a region is merged its sections aren't in the shader's list of render objects. The region's render
+         * object is there instead, and the sections are put back from their copies when the region is split
+         */
+        struct chunk_region {
+            std::vector<region_section> sections;
+
+            /*!
+             * \brief The center of the region. See get_region_position
+             */
+            glm::vec3 position;
+
+            /*!
+             * \brief The frame that a section in this region was last added, replaced, or removed
+             */
+            uint64_t last_changed_frame = 0;
+            bool is_merged = false;
+        };
 
-        std::mutex chunk_parts_to_upload_lock;
         /*!
-         * \brief A list of chunk renderable things that are ready to upload to the GPU
+         * \brief Everything that one shader draws
          */
-        std::queue<std::tuple<std::string, mesh_definition>> chunk_parts_to_upload;
+        struct shader_geometry {
+            std::vector<render_object> objects;
+
+            /*!
+             * \brief The bounding boxes of everything in objects, in the same order
+             */
+            aabb_table bounding_boxes;
+
+            /*!
+             * \brief Where in objects each chunk's render_object lives
+             */
+            std::unordered_map<chunk_key, size_t, chunk_key_hash> chunk_slots;
+
+            /*!
+             * \brief The ID of the last update that was applied to each chunk
+             */
+            std::unordered_map<chunk_key, uint64_t, chunk_key_hash> last_update_ids;
+
+            /*!
+             * \brief Where in chunks_waiting_for_upload each of this shader's waiting sections is, so a section that's
+             * sent again replaces its waiting update instead of being uploaded twice
+             */
+            std::unordered_map<chunk_key, size_t, chunk_key_hash> waiting_upload_slots;
+
+            /*!
+             * \brief The region each of this shader's sections is in, keyed like a merged region's render object is
+             */
+            std::unordered_map<chunk_key, chunk_region, chunk_key_hash> regions;
+
+            /*!
+             * \brief Chunks whose render objects are in objects but whose geometry was evicted to stay under the
+             * memory budget
+             */
+            std::unordered_set<chunk_key, chunk_key_hash> evicted_chunks;
+
+            /*!
+             * \brief True once this shader's meshes have been sorted back to front. Sorted shaders are never merged,
+             * since a region can only be sorted as a whole
+             */
+            bool is_sorted = false;
+
+            size_t num_merged_regions = 0;
+        };
+
+        /*!
+         * \brief The geometry for each shader, indexed by shader ID. Only the render thread touches this
+         */
+        std::vector<shader_geometry> geometry_by_shader;
+
+        /*!
+         * \brief The squared distance from the camera to each mesh, kept around so sorting doesn't allocate
+         */
+        std::vector<float> sort_distances;
+        std::vector<uint32_t> sort_order;
+        std::vector<render_object> sorted_objects;
+
+        std::unordered_map<std::string, shader_id> shader_ids;
+        std::mutex shader_ids_lock;
+
+        chunk_arena chunk_geometry;
+
+        /*!
+         * \brief The position of every chunk, written once when the chunk is uploaded
+         */
+        object_data_buffer object_data;
+
+        gui_batcher gui_geometry;
+
+        /*!
+         * \brief The names and materials of every render object, so the render objects only need their IDs
+         */
+        material_table materials;
+        name_table names;
+
+        /*!
+         * \brief The material every chunk uses. It's made when the first chunk is, since that's the first time the
+         * texture manager is sure to be around
+         */
+        material_id chunk_material = NO_MATERIAL;
+        name_id chunk_name;
+        name_id chunk_region_name;
+
+        /*!
+         * \brief A change to a chunk's geometry that Minecraft has sent us
+         *
+         * Updates are only ever moved from thread to thread, never copied, and their vectors come from chunk_buffers
+         * and go back there once the update is applied
+         */
+        struct chunk_update {
+            chunk_update() = default;
+            chunk_update(chunk_update&&) = default;
+            chunk_update& operator=(chunk_update&&) = default;
+            chunk_update(const chunk_update&) = delete;
+            chunk_update& operator=(const chunk_update&) = delete;
+
+            shader_id shader = 0;
+            mesh_definition definition;
+
+            /*!
+             * \brief Minecraft's copy of the vertices, from before the workers convert them into definition
+             */
+            std::vector<int> mc_vertex_data;
+
+            /*!
+             * \brief Simplified versions of definition, coarsest last. Only the vertices and indices are filled in
+             */
+            std::vector<mesh_definition> lods;
+
+            bool is_removal = false;    //!< If true, the chunk should be removed instead of added or replaced
+
+            /*!
+             * \brief Increases with every call to add_chunk_render_object or remove_chunk_render_object
+             *
+             * Workers can finish chunks in any order, so this is how we make sure an older update never overwrites a
+             * newer one
+             */
+            uint64_t update_id = 0;
+
+            /*!
+             * \brief Vertex data that's already in its final layout and lives in memory we don't own
+             *
+             * When this is set it's used instead of definition.vertex_data and definition.indices, and the owner
+             * won't touch the memory until direct_upload_ticket is complete
+             */
+            const int* direct_vertex_data = nullptr;
+            size_t direct_vertex_data_size = 0;
+            const int* direct_indices = nullptr;
+            size_t direct_index_count = 0;
+            uint64_t direct_upload_ticket = 0;
+
+            /*!
+             * \brief How soon the section is needed, from upload_prioritizer. Only kept up to date while it waits for
+             * an upload
+             */
+            float upload_priority = 0;
+
+            /*!
+             * \brief The key of the section this update changes
+             */
+            chunk_key get_key() const;
+
+            /*!
+             * \brief The number of bytes this update will copy to the GPU
+             */
+            uint64_t get_upload_size() const;
+        };
+
+        /*!
+         * \brief Chunk additions and removals that are ready to be applied
+         *
+         * Minecraft's threads and the conversion workers push to this, and the render thread applies the updates in
+         * upload_new_geometry. That way only the render thread ever touches the lists of render objects
+         */
+        mpsc_queue<chunk_update> chunk_parts_to_upload;
+
+        std::atomic<uint64_t> next_update_id{0};
+
+        /*!
+         * \brief Tickets for direct buffer uploads that haven't been copied into the arena yet
+         */
+        std::unordered_set<uint64_t> pending_direct_upload_tickets;
+        std::mutex pending_direct_upload_tickets_lock;
+        std::atomic<uint64_t> next_direct_upload_ticket{1};
+
+        /*!
+         * \brief The number of chunks that have been given to the workers but haven't been pushed to
+         * chunk_parts_to_upload yet
+         */
+        std::atomic<uint32_t> chunks_being_converted{0};
+
+        /*!
+         * \brief Chunks that have been converted but haven't fit into a frame's upload budget yet. There's at most one
+         * update for each section, found through shader_geometry::waiting_upload_slots
+         */
+        std::vector<chunk_update> chunks_waiting_for_upload;
+
+        upload_context* uploads = nullptr;
+
+        /*!
+         * \brief A copy into the chunk arena that runs on the upload thread
+         */
+        struct arena_write {
+            uint8_t* page_data;
+            chunk_arena_handle handle;
+            const int* vertex_data;
+            const int* indices;     //!< nullptr if the mesh gets the quad pattern
+        };
+
+        /*!
+         * \brief A chunk whose meshes are being written on the upload thread. It's placed once its ticket is complete
+         */
+        struct chunk_being_written {
+            std::shared_ptr<chunk_update> update;   //!< Shared with the upload task, which reads its meshes
+            render_object obj;                      //!< Has the arena handles, but isn't filled in or placed yet
+            uint64_t ticket;
+        };
+
+        /*!
+         * \brief Oldest first, so in the order their tickets complete
+         */
+        std::vector<chunk_being_written> chunks_being_written;
+
+        /*!
+         * \brief How many updates were thrown away because a newer update for the same section came in before they
+         * were uploaded
+         */
+        uint64_t superseded_uploads = 0;
+
+        /*!
+         * \brief The vertex and index vectors of chunk updates, and the copies of them that regions keep. Chunks come
+         * in from Minecraft's threads, are converted on the workers, and are applied on the render thread, and every
+         * one of those borrows or gives back vectors here, so updating a chunk reuses the memory of the updates
+         * before it
+         */
+        buffer_pool<int> chunk_buffers;
+
+        uint64_t upload_budget_bytes = 8 * 1024 * 1024;
+        int64_t upload_budget_microseconds = 2000;
+
+        /*!
+         * \brief Orders both the conversion workers' tasks and the uploads, from where the camera is going
+         */
+        upload_prioritizer prioritizer;
+
+        /*!
+         * \brief If false, the workers don't make simplified meshes and every section is drawn at full detail
+         */
+        std::atomic<bool> generate_lods{true};
+        chunk_lod_settings lod_settings;
+
+        /*!
+         * \brief Everything the native mesher knows about blocks
+         */
+        struct mesher_blocks {
+            /*!
+             * \brief Indexed by block ID
+             */
+            std::vector<mesher_block_type> types;
+
+            /*!
+             * \brief Every shader that at least one block type uses
+             */
+            std::vector<shader_id> shaders;
+
+            /*!
+             * \brief The name of each shader in #shaders, which is how the mesh cache knows them
+             */
+            std::vector<std::string> shader_names;
+
+            /*!
+             * \brief A hash of the block types, for the mesh cache. Worked out the first time a section needs it
+             */
+            uint64_t resource_hash = 0;
+            bool has_resource_hash = false;
+        };
+
+        /*!
+         * \brief The block types that new sections are meshed with
+         *
+         * Each section being meshed holds on to the block types it started with. If nothing else is holding on to
+         * them they're changed in place, otherwise they're copied first
+         */
+        std::shared_ptr<mesher_blocks> mesher_block_types = std::make_shared<mesher_blocks>();
+        std::mutex mesher_block_types_lock;
+
+        /*!
+         * \brief The shaders whose block chunks are packed. Read by the conversion workers
+         */
+        std::unordered_set<shader_id> packed_vertex_shaders;
+        mutable std::mutex packed_vertex_shaders_lock;
+
+        bool takes_packed_vertices(shader_id shader) const;
+
+        /*!
+         * \brief Asks Minecraft for every chunk the shader draws again, including the ones in merged regions
+         */
+        void request_rebuild_of_shader(shader_id shader);
+
+        /*!
+         * \brief If false, the native mesher gives every block face its own quad
+         */
+        std::atomic<bool> merge_section_faces{true};
+
+        /*!
+         * \brief The on-disk cache of native mesher sections for the world that's being played, if there is one
+         *
+         * Sections that are being meshed hold on to the cache they started with, so it's only closed once they're
+         * done
+         */
+        std::shared_ptr<chunk_mesh_cache> mesh_cache;
+        int mesh_cache_dimension = 0;
+        std::string mesh_cache_world;
+        std::mutex mesh_cache_lock;
+
+        bool use_mesh_cache = true;
+        std::string mesh_cache_directory = "chunk_mesh_cache";
+        uint64_t mesh_cache_max_bytes = 512ull * 1024 * 1024;
+
+        /*!
+         * \brief Finds the name that was given to get_shader_id for a shader
+         */
+        std::string get_shader_name(shader_id shader);
+
+        /*!
+         * \brief Hashes everything about the block types that changes how the mesher draws them
+         */
+        static uint64_t hash_mesher_blocks(const mesher_blocks& blocks);
+
+        /*!
+         * \brief The bounding boxes of chunks that have changed since the last call to take_changed_bounds
+         */
+        std::vector<aabb> changed_bounds;
+
+        /*!
+         * \brief Settings for merging regions. A region is merged once none of its sections have changed for
+         * region_merge_frames frames and its center is at least region_merge_distance blocks from the camera
+         */
+        bool region_merging = true;
+        uint64_t region_merge_frames = 300;
+        float region_merge_distance = 256;
+
+        /*!
+         * \brief How many bytes of GPU memory we try to stay under, or 0 for no limit. See enforce_memory_budget
+         */
+        uint64_t memory_budget_bytes = 0;
+        bool warned_about_memory_budget = false;
+
+        /*!
+         * \brief A chunk that could be evicted, kept around so enforce_memory_budget doesn't allocate
+         */
+        struct eviction_candidate {
+            shader_id shader;
+            chunk_key key;
+            uint64_t last_visible_frame;
+            float distance_squared;
+        };
+        std::vector<eviction_candidate> eviction_candidates;
+
+        /*!
+         * \brief Chunks that Minecraft has to send again, and every chunk that's been asked for but hasn't come back
+         * yet, so it isn't asked for twice
+         */
+        std::vector<mc_chunk_position> chunks_to_rebuild;
+        std::unordered_set<chunk_key, chunk_key_hash> rebuilds_requested;
+
+        /*!
+         * \brief How many times upload_new_geometry has been called, which is how regions tell how long they've
+         * been stable
+         */
+        uint64_t frame_count = 0;
 
         float seconds_spent_updating_chunks = 0;
         long total_chunks_updated = 0;
@@ -86,11 +775,230 @@ namespace nova {
          * \brief Removes all the render_objects from the lists of render_objects that match the given filter function
          *
          * The idea here is that when things like the GUI screen change, or when a chunk changes, old geometry will need
-         * to be removed. This should accomplish that.
+         * to be removed. This should accomplish that. Any chunk arena space used by the removed objects is freed
          *
          * \param filter The function to use to decide which (if any) objects to remove
          */
         void remove_render_objects(std::function<bool(render_object&)> fitler);
+
+        /*!
+         * \brief Widens the chunk's vertices from Minecraft's 7-int stride to our 13-int stride
+         *
+         * Run by the conversion workers for chunks that don't get the packed format
+         */
+        static void convert_chunk_vertices(const std::vector<int>& mc_vertex_data, std::vector<int>& vertex_data);
+
+        /*!
+         * \brief Makes the simplified levels of a chunk section from Minecraft's vertices, coarsest last
+         *
+         * A level is only kept if it has noticeably fewer triangles than the level before it, so small or already
+         * simple sections end up with fewer levels. Run by the conversion workers
+         */
+        void build_chunk_lods(const std::vector<int>& mc_vertex_data, bool pack_vertices, chunk_update& update);
+
+        /*!
+         * \brief Frees the object's chunk arena space, for every level of detail, and its object data slot
+         */
+        void free_object_geometry(render_object& obj);
+
+        /*!
+         * \brief Gets the geometry for the given shader, making room for it if it's the first time we've seen the ID
+         */
+        shader_geometry& get_geometry(shader_id shader);
+
+        /*!
+         * \brief Adds the given render object to the list for the given shader, keeping the bounding box table in sync
+         */
+        void add_render_object(shader_geometry& geometry, render_object&& obj);
+
+        /*!
+         * \brief Adds, replaces, or removes a chunk's render object, using the chunk index to find it
+         *
+         * If the chunk is in a merged region, the region is split first. The update's meshes are moved into the
+         * chunk's region when regions are being merged
+         */
+        void apply_chunk_update(chunk_update& update);
+
+        /*!
+         * \brief Applies the update, then marks its direct upload ticket (if any) as complete
+         */
+        void apply_chunk_update_and_complete_ticket(chunk_update& update);
+
+        void complete_direct_upload_ticket(const chunk_update& update);
+
+        /*!
+         * \brief Takes an update from chunk_parts_to_upload. Removals are applied right away and additions wait in
+         * chunks_waiting_for_upload, and either one replaces an addition for the same section that's still waiting
+         */
+        void queue_chunk_update(chunk_update&& update);
+
+        /*!
+         * \brief Throws away an update that a newer one for the same section replaced before it was uploaded
+         */
+        void skip_superseded_update(chunk_update& update);
+
+        /*!
+         * \brief Copies a chunk that's been sent to add_chunk_render_object, and counts it as being converted
+         */
+        std::shared_ptr<chunk_update> copy_chunk_for_conversion(shader_id shader, const mc_chunk_render_object& chunk);
+
+        /*!
+         * \brief Makes the worker task that turns a copied chunk into a mesh_definition and sends it to be uploaded
+         */
+        std::function<void()> make_conversion_task(std::shared_ptr<chunk_update> update);
+
+        /*!
+         * \brief Gives whatever vectors the update still owns back to chunk_buffers
+         */
+        void recycle_chunk_update(chunk_update& update);
+
+        /*!
+         * \brief Gives the mesh's vertices and indices back to chunk_buffers
+         */
+        void recycle_mesh(mesh_definition& mesh);
+
+        /*!
+         * \brief Copies a section's meshes into the chunk arena, pointing the render object's handles at them
+         *
+         * \param def The full detail mesh. Its format and ID are used for every level
+         * \param lods The simplified meshes, coarsest last
+         * \param num_lods How many simplified meshes there are
+         * \param obj The render object to fill in the arena handles and number of levels of
+         * \param deferred_writes If not nullptr, the space is only allocated, and the copies are added to this list
+         */
+        void add_chunk_meshes(const mesh_definition& def, const mesh_definition* lods, size_t num_lods, render_object& obj,
+                              std::vector<arena_write>* deferred_writes = nullptr);
+
+        /*!
+         * \brief Finds arena space for the update's meshes and has the upload thread copy them in. The update is
+         * moved into chunks_being_written
+         */
+        void write_chunk_on_upload_thread(chunk_update& update);
+
+        /*!
+         * \brief Places the chunks the upload thread has finished writing, unless a newer update for their section
+         * has been applied since, then makes the GPU wait for the writes before anything is drawn
+         */
+        void place_written_chunks();
+
+        /*!
+         * \brief Fills in everything about a chunk's render object besides its geometry, and gives it an object data
+         * slot if it has geometry. New objects count as visible this frame
+         */
+        void fill_chunk_object(const mesh_definition& def, render_object& obj);
+
+        /*!
+         * \brief Puts the render object in the chunk's slot, replacing whatever was there, or adds it to the end
+         */
+        void place_chunk_object(shader_geometry& geometry, const chunk_key& key, render_object&& obj);
+
+        /*!
+         * \brief Records that the chunk in the update has changed, keeping a copy of its meshes if regions are being
+         * merged and the update has meshes we own
+         */
+        void remember_region_section(shader_geometry& geometry, const chunk_key& key, chunk_update& update);
+
+        /*!
+         * \brief Checks if we need copies of the chunks' meshes, for merging regions or bringing back evicted chunks
+         */
+        bool keeps_chunk_copies() const;
+
+        /*!
+         * \brief Takes the chunk out of its region, if it's in one
+         */
+        void forget_region_section(shader_geometry& geometry, const chunk_key& key, const glm::vec3& position);
+
+        /*!
+         * \brief Merges up to a few stable, far away regions a frame, and splits merged regions that the camera has
+         * come close to
+         *
+         * Merged regions make far less draws, and are culled as a whole
+         */
+        void merge_stable_regions(const glm::vec3& camera_position);
+
+        /*!
+         * \brief Checks if every section in the region has a copy of its meshes, and they all use the same mergeable
+         * vertex format
+         */
+        static bool can_merge_region(const chunk_region& region);
+
+        /*!
+         * \brief Joins the region's sections into one render object, which replaces them in the shader's list of
+         * render objects
+         *
+         * \return False if the merged mesh didn't fit in the chunk arena, in which case the sections are left alone
+         */
+        bool merge_region(shader_geometry& geometry, const chunk_key& region_key, chunk_region& region);
+
+        /*!
+         * \brief Replaces a merged region's render object with render objects for each of its sections
+         *
+         * \param upload_sections If false, the sections are put back already evicted, and they're uploaded once
+         * they're seen again
+         */
+        void split_region(shader_geometry& geometry, const chunk_key& region_key, chunk_region& region,
+                          bool upload_sections = true);
+
+        /*!
+         * \brief Splits every merged region in the given shader's geometry
+         */
+        void split_all_regions(shader_geometry& geometry);
+
+        /*!
+         * \brief Brings back evicted chunks that were seen again, then evicts chunk geometry if we're over the
+         * memory budget
+         *
+         * Chunks that haven't been seen for the longest go first, and the farthest of those go before the closer
+         * ones. Chunks seen in the last couple of frames are never evicted. Eviction goes a tenth of the budget
+         * further than it needs to, so it doesn't happen every frame
+         */
+        void enforce_memory_budget(const glm::vec3& camera_position);
+
+        /*!
+         * \brief Frees the chunk's geometry but leaves its render object in place, so culling can tell us when it's
+         * needed again. An evicted merged region is split into evicted sections
+         *
+         * \return How many bytes of the chunk arena were freed
+         */
+        uint64_t evict_chunk(shader_geometry& geometry, const chunk_key& key);
+
+        /*!
+         * \brief Uploads evicted chunks that were seen last frame from their copies, or asks Minecraft for the ones
+         * that don't have copies
+         */
+        void restore_visible_chunks();
+
+        /*!
+         * \brief Finds the copy of a chunk's meshes that its region keeps, or nullptr if there isn't one
+         */
+        const region_section* find_region_section(const shader_geometry& geometry, const chunk_key& key,
+                                                  const glm::vec3& position) const;
+
+        /*!
+         * \brief Uploads chunks from chunks_waiting_for_upload, the ones prioritizer says are needed soonest first,
+         * until the budget runs out
+         */
+        void upload_most_needed_chunks(const glm::vec3& camera_position);
+
+        /*!
+         * \brief Removes the render object at the given index by moving the last render object into its place
+         *
+         * Frees the removed object's arena space and updates the chunk index for the object that was moved
+         */
+        void swap_remove_render_object(shader_geometry& geometry, size_t index);
+
+        /*!
+         * \brief Updates the bounding boxes and chunk index for the objects in [first, last] after they've been moved
+         */
+        static void update_moved_objects(shader_geometry& geometry, size_t first, size_t last);
+
+        /*!
+         * \brief The threads that convert chunks from Minecraft's format
+         *
+         * This is the last member so that it's destroyed first, which joins the workers before the queue they push to
+         * goes away
+         */
+        std::unique_ptr<thread_pool> conversion_workers;
     };
 
 };
@@ -0,0 +1,96 @@
+/*!
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <easylogging++.h>
+#include "region_merger.h"
+#include "vertex_packing.h"
+
+namespace nova {
+    /*!
+     * \brief How many ints each vertex takes up in the given format, or 0 if the format can't be merged
+     */
+    static size_t get_ints_per_vertex(format vertex_format) {
+        switch(vertex_format) {
+            case format::POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT:
+                return 13;
+            case format::TILED_POS_COLOR_UV_LIGHTMAPUV_NORMAL_TILE:
+                return 14;
+            case format::PACKED_POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT:
+                return sizeof(packed_chunk_vertex) / sizeof(int);
+            default:
+                return 0;
+        }
+    }
+
+    glm::vec3 get_region_position(const glm::vec3& section_position) {
+        const glm::vec3 region_corner = glm::floor(section_position / REGION_SIZE) * REGION_SIZE;
+        return region_corner + glm::vec3(REGION_SIZE / 2);
+    }
+
+    bool can_merge_format(format vertex_format) {
+        return get_ints_per_vertex(vertex_format) != 0;
+    }
+
+    void append_section_to_region(const mesh_definition& section, const glm::vec3& offset, mesh_definition& region) {
+        const size_t ints_per_vertex = get_ints_per_vertex(region.vertex_format);
+        const size_t first_vertex = region.vertex_data.size() / ints_per_vertex;
+        const size_t num_vertices = section.vertex_data.size() / ints_per_vertex;
+
+        const size_t first_new_int = region.vertex_data.size();
+        size_t num_clamped = 0;
+        region.vertex_data.insert(region.vertex_data.end(), section.vertex_data.begin(),
+                                  section.vertex_data.begin() + num_vertices * ints_per_vertex);
+
+        for(size_t i = 0; i < num_vertices; i++) {
+            int* vertex = &region.vertex_data[first_new_int + i * ints_per_vertex];
+
+            if(region.vertex_format == format::PACKED_POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT) {
+                // Sections are a whole number of blocks apart, so moving a packed position is exact
+                int16_t position[3];
+                std::memcpy(position, vertex, sizeof(position));
+                for(int c = 0; c < 3; c++) {
+                    const float moved = position[c] + offset[c] * POSITION_SCALE;
+                    const float clamped = std::max(-32768.0f, std::min(32767.0f, moved));
+                    num_clamped += clamped != moved;
+                    position[c] = static_cast<int16_t>(clamped);
+                }
+                std::memcpy(vertex, position, sizeof(position));
+
+            } else {
+                float position[3];
+                std::memcpy(position, vertex, sizeof(position));
+                for(int c = 0; c < 3; c++) {
+                    position[c] += offset[c];
+                }
+                std::memcpy(vertex, position, sizeof(position));
+            }
+        }
+
+        if(num_clamped > 0) {
+            LOG(WARNING) << num_clamped << " packed vertex positions were too far from their region to fit, so they "
+                         << "were clamped and the region may have cracks";
+        }
+
+        // Sections with no indices are plain quads. The region only needs its own indices once a section has some
+        if(section.indices.empty() && region.indices.empty()) {
+            return;
+        }
+        if(region.indices.empty()) {
+            append_quad_indices(0, static_cast<uint32_t>(first_vertex), region.indices);
+        }
+
+        if(section.indices.empty()) {
+            append_quad_indices(static_cast<uint32_t>(first_vertex), static_cast<uint32_t>(num_vertices), region.indices);
+        } else {
+            region.indices.reserve(region.indices.size() + section.indices.size());
+            for(int index : section.indices) {
+                region.indices.push_back(index + static_cast<int>(first_vertex));
+            }
+        }
+    }
+}
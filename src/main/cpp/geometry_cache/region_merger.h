@@ -0,0 +1,63 @@
+/*!
+ * \brief Joins the meshes of neighboring chunk sections into one mesh for a whole region
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_REGION_MERGER_H
+#define RENDERER_REGION_MERGER_H
+
+#include <climits>
+#include <glm/glm.hpp>
+#include "mesh_definition.h"
+
+namespace nova {
+    /*!
+     * \brief How many sections wide, tall, and deep a region is
+     */
+    const int REGION_SIZE_IN_SECTIONS = 4;
+
+    /*!
+     * \brief How many blocks wide, tall, and deep a region is
+     */
+    const float REGION_SIZE = 16.0f * REGION_SIZE_IN_SECTIONS;
+
+    /*!
+     * \brief The parent ID of every merged region's render object
+     *
+     * Regions are keyed the same way sections are, with a chunk_key made from the region's position and this ID, so
+     * they can share the section lookup tables
+     */
+    const int MERGED_REGION_ID = INT_MIN;
+
+    /*!
+     * \brief Finds the position of the region that the section at the given position is in
+     *
+     * A region's position is its center rather than its corner. That way every vertex in the region is within 32
+     * blocks of it, which the packed vertex format reaches with room to spare
+     */
+    glm::vec3 get_region_position(const glm::vec3& section_position);
+
+    /*!
+     * \brief Checks if append_section_to_region knows where the positions are in the given vertex format
+     */
+    bool can_merge_format(format vertex_format);
+
+    /*!
+     * \brief Adds a section's mesh to the end of a region's mesh
+     *
+     * The section's vertices are moved from being relative to the section to being relative to the region, and its
+     * indices are offset past the vertices that were already in the region. A section with no indices is taken to be
+     * quads, and the region keeps no indices either until a section that has some is added
+     *
+     * Packed positions that land outside what the packed format can hold are clamped, and a warning is logged
+     *
+     * \param section The section's vertices and indices. Its vertex format must be the same as the region's
+     * \param offset The section's position minus the region's position
+     * \param region The region's mesh, which the section is appended to
+     */
+    void append_section_to_region(const mesh_definition& section, const glm::vec3& offset, mesh_definition& region);
+}
+
+#endif //RENDERER_REGION_MERGER_H
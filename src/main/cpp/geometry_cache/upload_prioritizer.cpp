@@ -0,0 +1,127 @@
+/*!
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include "upload_prioritizer.h"
+
+namespace nova {
+    /*!
+     * \brief How much of the camera's history its velocity is measured over, in seconds
+     */
+    static const double VELOCITY_WINDOW_SECONDS = 0.25;
+
+    /*!
+     * \brief The camera has to move at least this fast, in blocks per second, before it's heading the way it moves
+     * instead of the way it looks
+     */
+    static const float MIN_HEADING_SPEED = 2.0f;
+
+    /*!
+     * \brief How much further away a section directly behind the camera's heading seems
+     */
+    static const float BEHIND_SCALE = 3.0f;
+
+    /*!
+     * \brief Sections this close to the camera, in blocks, are only scored by their distance
+     */
+    static const float NEARBY_DISTANCE = 32.0f;
+
+    /*!
+     * \brief The camera can't move this far between two samples, so it must have been teleported
+     */
+    static const float TELEPORT_DISTANCE = 64.0f;
+
+    void upload_prioritizer::add_camera_sample(const glm::vec3& position, const glm::vec3& view_direction, double time_seconds) {
+        if(!samples.empty() && (time_seconds < samples.back().time_seconds ||
+                                glm::length(position - samples.back().position) > TELEPORT_DISTANCE)) {
+            // Moving from where the camera was teleported from to where it ended up isn't a velocity
+            samples.clear();
+        }
+
+        samples.push_back({position, time_seconds});
+        while(samples.size() > 2 && samples[1].time_seconds <= time_seconds - VELOCITY_WINDOW_SECONDS) {
+            samples.pop_front();
+        }
+
+        glm::vec3 velocity(0);
+        const double elapsed_seconds = time_seconds - samples.front().time_seconds;
+        if(elapsed_seconds > 0) {
+            velocity = (position - samples.front().position) / static_cast<float>(elapsed_seconds);
+        }
+
+        glm::vec3 heading(0);
+        const float speed = glm::length(velocity);
+        if(speed >= MIN_HEADING_SPEED) {
+            heading = velocity / speed;
+        } else if(glm::length(view_direction) > 0) {
+            heading = glm::normalize(view_direction);
+        }
+
+        std::lock_guard<std::mutex> lock(prediction_lock);
+        current.position = position;
+        current.velocity = velocity;
+        current.heading = heading;
+        current.has_samples = true;
+    }
+
+    void upload_prioritizer::reset() {
+        samples.clear();
+
+        std::lock_guard<std::mutex> lock(prediction_lock);
+        const float lookahead = current.lookahead;
+        current = prediction();
+        current.lookahead = lookahead;
+    }
+
+    void upload_prioritizer::set_lookahead(float seconds) {
+        std::lock_guard<std::mutex> lock(prediction_lock);
+        current.lookahead = glm::max(seconds, 0.0f);
+    }
+
+    float upload_prioritizer::get_priority(const glm::vec3& section_position) const {
+        std::lock_guard<std::mutex> lock(prediction_lock);
+        if(!current.has_samples) {
+            return 0;
+        }
+        return score(section_position, current.position, current);
+    }
+
+    float upload_prioritizer::get_priority(const glm::vec3& section_position, const glm::vec3& camera_position) const {
+        std::lock_guard<std::mutex> lock(prediction_lock);
+        return score(section_position, camera_position, current);
+    }
+
+    glm::vec3 upload_prioritizer::get_velocity() const {
+        std::lock_guard<std::mutex> lock(prediction_lock);
+        return current.velocity;
+    }
+
+    glm::vec3 upload_prioritizer::get_predicted_position() const {
+        std::lock_guard<std::mutex> lock(prediction_lock);
+        return current.position + current.velocity * current.lookahead;
+    }
+
+    float upload_prioritizer::score(const glm::vec3& section_position, const glm::vec3& camera_position, const prediction& predicted) {
+        const glm::vec3 center = section_position + glm::vec3(8);
+        const glm::vec3 to_center = center - camera_position;
+
+        // The closest point to the section on the path from here to where the camera will be
+        const glm::vec3 path = predicted.velocity * predicted.lookahead;
+        const float path_length_squared = glm::dot(path, path);
+        float along_path = 0;
+        if(path_length_squared > 0) {
+            along_path = glm::clamp(glm::dot(to_center, path) / path_length_squared, 0.0f, 1.0f);
+        }
+        const float distance_to_path = glm::length(to_center - path * along_path);
+
+        const float distance_to_camera = glm::length(to_center);
+        if(distance_to_camera <= NEARBY_DISTANCE || predicted.heading == glm::vec3(0)) {
+            return distance_to_path;
+        }
+
+        // 1 for a section straight ahead, up to BEHIND_SCALE for one straight behind
+        const float facing = glm::dot(to_center / distance_to_camera, predicted.heading);
+        return distance_to_path * (1 + (BEHIND_SCALE - 1) * (1 - facing) * 0.5f);
+    }
+}
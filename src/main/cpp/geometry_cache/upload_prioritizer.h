@@ -0,0 +1,111 @@
+/*!
+ * \brief Decides which chunk sections are needed soonest, from where the camera is going
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#ifndef RENDERER_UPLOAD_PRIORITIZER_H
+#define RENDERER_UPLOAD_PRIORITIZER_H
+
+#include <deque>
+#include <mutex>
+#include <glm/glm.hpp>
+
+namespace nova {
+    /*!
+     * \brief Guesses where the camera will be in a little while, and scores chunk sections by how soon they'll be seen
+     *
+     * Sections used to be uploaded closest first, which works when the player walks. When they fly with elytra,
+     * they cover a few sections every second, and the sections in front of them are far away when they arrive, so
+     * they wait behind closer sections that are already behind the player and pop in late.
+     *
+     * The render thread gives this the camera every frame. The camera's velocity comes from how far it moved over
+     * the last quarter of a second, and the camera is expected to be lookahead seconds further along that line. A
+     * section's priority is its distance to the closest point on the path between where the camera is and where
+     * it's expected to be. Sections behind the direction the camera is heading have their distance multiplied by up
+     * to 3, since the view frustum is going away from them. When the camera barely moves, it's heading the way it
+     * looks. Sections within two sections of the camera are never pushed back, because the player can turn around
+     * faster than they can load.
+     *
+     * Lower priorities are needed sooner. Until there's a camera sample, #get_priority gives every section 0, so
+     * the sections are converted in the order they came in.
+     *
+     * #get_priority can be called from any thread. Minecraft's threads use it to order the conversion workers' tasks
+     */
+    class upload_prioritizer {
+    public:
+        /*!
+         * \brief Adds where the camera is right now
+         *
+         * \param position Where the camera is
+         * \param view_direction Which way the camera looks
+         * \param time_seconds When the camera was there, from any clock that only goes forward
+         */
+        void add_camera_sample(const glm::vec3& position, const glm::vec3& view_direction, double time_seconds);
+
+        /*!
+         * \brief Forgets the camera's history, for when it teleports to a new world
+         */
+        void reset();
+
+        /*!
+         * \brief Sets how many seconds ahead the camera's position is predicted. 0 turns prediction off
+         */
+        void set_lookahead(float seconds);
+
+        /*!
+         * \brief Scores a chunk section against the newest camera sample. Lower is needed sooner. Every section gets
+         * 0 until there's a camera sample, so they keep the order they came in
+         *
+         * \param section_position The section's lowest corner
+         */
+        float get_priority(const glm::vec3& section_position) const;
+
+        /*!
+         * \brief Scores a chunk section as if the camera were at the given position, but moving and heading like the
+         * newest samples say it is
+         */
+        float get_priority(const glm::vec3& section_position, const glm::vec3& camera_position) const;
+
+        /*!
+         * \brief How fast the camera is moving, in blocks per second
+         */
+        glm::vec3 get_velocity() const;
+
+        /*!
+         * \brief Where the camera is expected to be lookahead seconds from the newest sample
+         */
+        glm::vec3 get_predicted_position() const;
+
+    private:
+        struct camera_sample {
+            glm::vec3 position;
+            double time_seconds;
+        };
+
+        /*!
+         * \brief The samples the velocity is measured over, plus the one just before them. Only touched by the render
+         * thread
+         */
+        std::deque<camera_sample> samples;
+
+        /*!
+         * \brief What the samples add up to. Minecraft's threads read it while the render thread writes it
+         */
+        struct prediction {
+            glm::vec3 position = glm::vec3(0);
+            glm::vec3 velocity = glm::vec3(0);
+            glm::vec3 heading = glm::vec3(0);   //!< A unit vector, or 0 if the camera isn't heading anywhere yet
+            float lookahead = 1.0f;
+            bool has_samples = false;
+        };
+
+        mutable std::mutex prediction_lock;
+        prediction current;
+
+        static float score(const glm::vec3& section_position, const glm::vec3& camera_position, const prediction& predicted);
+    };
+}
+
+#endif //RENDERER_UPLOAD_PRIORITIZER_H
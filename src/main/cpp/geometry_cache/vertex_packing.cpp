@@ -0,0 +1,149 @@
+/*!
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "vertex_packing.h"
+
+namespace nova {
+    template <typename T>
+    T quantize(float value, float scale, float min_value, float max_value) {
+        return static_cast<T>(std::round(std::max(min_value, std::min(max_value, value * scale))));
+    }
+
+    glm::vec2 octahedral_encode(const glm::vec3& n) {
+        const float l1_norm = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+        if(l1_norm == 0) {
+            return {0, 0};
+        }
+
+        glm::vec2 encoded(n.x / l1_norm, n.y / l1_norm);
+        if(n.z < 0) {
+            // Fold the bottom half of the octahedron over the top half
+            const float x = encoded.x;
+            encoded.x = (1 - std::fabs(encoded.y)) * (x >= 0 ? 1.0f : -1.0f);
+            encoded.y = (1 - std::fabs(x)) * (encoded.y >= 0 ? 1.0f : -1.0f);
+        }
+
+        return encoded;
+    }
+
+    glm::vec3 octahedral_decode(const glm::vec2& encoded) {
+        glm::vec3 n(encoded.x, encoded.y, 1 - std::fabs(encoded.x) - std::fabs(encoded.y));
+        if(n.z < 0) {
+            const float x = n.x;
+            n.x = (1 - std::fabs(n.y)) * (x >= 0 ? 1.0f : -1.0f);
+            n.y = (1 - std::fabs(x)) * (n.y >= 0 ? 1.0f : -1.0f);
+        }
+
+        const float length = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+        return {n.x / length, n.y / length, n.z / length};
+    }
+
+    /*!
+     * \brief Adds a triangle's normal and tangent, scaled by its area, to each of its vertices
+     */
+    static void add_triangle_frame(const std::vector<glm::vec3>& positions, const std::vector<glm::vec2>& uvs,
+                                   const size_t corners[3], std::vector<glm::vec3>& normals,
+                                   std::vector<glm::vec3>& tangents) {
+        const glm::vec3 edge1 = positions[corners[1]] - positions[corners[0]];
+        const glm::vec3 edge2 = positions[corners[2]] - positions[corners[0]];
+        const glm::vec2 delta_uv1 = uvs[corners[1]] - uvs[corners[0]];
+        const glm::vec2 delta_uv2 = uvs[corners[2]] - uvs[corners[0]];
+
+        // The cross product is already as long as twice the triangle's area, and the tangent is scaled to match
+        const glm::vec3 normal = glm::cross(edge1, edge2);
+
+        glm::vec3 tangent(0);
+        const float uv_area = delta_uv1.x * delta_uv2.y - delta_uv2.x * delta_uv1.y;
+        if(uv_area != 0) {
+            tangent = (edge1 * delta_uv2.y - edge2 * delta_uv1.y) * (glm::length(normal) / uv_area);
+        }
+
+        for(int i = 0; i < 3; i++) {
+            normals[corners[i]] += normal;
+            tangents[corners[i]] += tangent;
+        }
+    }
+
+    void pack_chunk_vertices(const std::vector<int>& mc_vertex_data, const std::vector<int>& indices,
+                             std::vector<int>& vertex_data) {
+        static_assert(sizeof(packed_chunk_vertex) % sizeof(int) == 0, "packed_chunk_vertex must be a whole number of ints");
+        const size_t ints_per_vertex = sizeof(packed_chunk_vertex) / sizeof(int);
+
+        const size_t num_vertices = mc_vertex_data.size() / 7;
+        const size_t first_new_int = vertex_data.size();
+        vertex_data.resize(first_new_int + num_vertices * ints_per_vertex);
+
+        std::vector<glm::vec3> positions(num_vertices);
+        std::vector<glm::vec2> uvs(num_vertices);
+        for(size_t i = 0; i < num_vertices; i++) {
+            std::memcpy(&positions[i], &mc_vertex_data[i * 7], sizeof(float) * 3);
+            std::memcpy(&uvs[i], &mc_vertex_data[i * 7 + 4], sizeof(float) * 2);
+        }
+
+        std::vector<glm::vec3> normals(num_vertices, glm::vec3(0));
+        std::vector<glm::vec3> tangents(num_vertices, glm::vec3(0));
+        if(indices.empty()) {
+            for(size_t quad = 0; quad + 4 <= num_vertices; quad += 4) {
+                const size_t first_triangle[3] = {quad, quad + 1, quad + 2};
+                const size_t second_triangle[3] = {quad, quad + 2, quad + 3};
+                add_triangle_frame(positions, uvs, first_triangle, normals, tangents);
+                add_triangle_frame(positions, uvs, second_triangle, normals, tangents);
+            }
+        } else {
+            for(size_t i = 0; i + 3 <= indices.size(); i += 3) {
+                const size_t corners[3] = {static_cast<size_t>(indices[i]), static_cast<size_t>(indices[i + 1]),
+                                           static_cast<size_t>(indices[i + 2])};
+                if(corners[0] < num_vertices && corners[1] < num_vertices && corners[2] < num_vertices) {
+                    add_triangle_frame(positions, uvs, corners, normals, tangents);
+                }
+            }
+        }
+
+        for(size_t i = 0; i < num_vertices; i++) {
+            const int* mc_vertex = &mc_vertex_data[i * 7];
+
+            packed_chunk_vertex vertex = {};
+            for(int c = 0; c < 3; c++) {
+                vertex.position[c] = quantize<int16_t>(positions[i][c], POSITION_SCALE, -32768, 32767);
+            }
+
+            std::memcpy(vertex.color, &mc_vertex[3], sizeof(vertex.color));
+
+            vertex.uv[0] = quantize<uint16_t>(uvs[i].x, 65535, 0, 65535);
+            vertex.uv[1] = quantize<uint16_t>(uvs[i].y, 65535, 0, 65535);
+
+            glm::vec3 normal(0, 1, 0);
+            if(glm::dot(normals[i], normals[i]) > 0) {
+                normal = glm::normalize(normals[i]);
+            }
+
+            // The tangent has to lie along the surface, so whatever part of it points along the normal is dropped
+            glm::vec3 tangent = tangents[i] - normal * glm::dot(tangents[i], normal);
+            if(glm::dot(tangent, tangent) > 0) {
+                tangent = glm::normalize(tangent);
+            } else {
+                tangent = std::fabs(normal.x) < 0.9f ? glm::vec3(1, 0, 0) : glm::vec3(0, 0, 1);
+                tangent = glm::normalize(tangent - normal * glm::dot(tangent, normal));
+            }
+
+            const glm::vec2 encoded_normal = octahedral_encode(normal);
+            const glm::vec2 encoded_tangent = octahedral_encode(tangent);
+            vertex.normal[0] = quantize<int8_t>(encoded_normal.x, 127, -127, 127);
+            vertex.normal[1] = quantize<int8_t>(encoded_normal.y, 127, -127, 127);
+            vertex.tangent[0] = quantize<int8_t>(encoded_tangent.x, 127, -127, 127);
+            vertex.tangent[1] = quantize<int8_t>(encoded_tangent.y, 127, -127, 127);
+
+            // The lightmap int is two shorts, low one first, and each coordinate fits in a byte
+            const auto lightmap = static_cast<uint32_t>(mc_vertex[6]);
+            vertex.lightmap[0] = static_cast<uint8_t>(std::min(255u, lightmap & 0xFFFF));
+            vertex.lightmap[1] = static_cast<uint8_t>(std::min(255u, lightmap >> 16));
+
+            std::memcpy(&vertex_data[first_new_int + i * ints_per_vertex], &vertex, sizeof(vertex));
+        }
+    }
+}
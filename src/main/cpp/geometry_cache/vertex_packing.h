@@ -0,0 +1,78 @@
+/*!
+ * \brief Functions to squeeze chunk vertices into the packed chunk vertex format
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_VERTEX_PACKING_H
+#define RENDERER_VERTEX_PACKING_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace nova {
+    /*!
+     * \brief One vertex in the PACKED_POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT format
+     *
+     * 24 bytes, compared to 52 for POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT:
+     * - position: chunk-relative, signed 16-bit fixed point with POSITION_SCALE steps per block. The spare fourth
+     *   component keeps the color aligned
+     * - color: RGBA8, the same bytes Minecraft gives us
+     * - uv: unsigned normalized 16-bit
+     * - normal and tangent: octahedral encoded, two signed normalized bytes each
+     * - lightmap: one byte each for the block light and sky light coordinates, in the same order as Minecraft's shorts
+     */
+    struct packed_chunk_vertex {
+        int16_t position[4];
+        uint8_t color[4];
+        uint16_t uv[2];
+        int8_t normal[2];
+        int8_t tangent[2];
+        uint8_t lightmap[2];
+        uint8_t padding[2];
+    };
+
+    static_assert(sizeof(packed_chunk_vertex) == 24, "packed_chunk_vertex must be 24 bytes");
+
+    /*!
+     * \brief How many fixed-point steps there are per block. Positions can range from -64 to just under 64 blocks
+     *
+     * A merged region's vertices are up to 32 blocks from its center, so this leaves room for blocks that stick out of
+     * their section
+     */
+    const float POSITION_SCALE = 512.0f;
+
+    /*!
+     * \brief Encodes a unit vector as two components in [-1, 1] by projecting it onto an octahedron
+     *
+     * The zero vector encodes to (0, 0), which decodes to +Z, so only encode vectors that have a direction
+     */
+    glm::vec2 octahedral_encode(const glm::vec3& n);
+
+    /*!
+     * \brief Turns the output of octahedral_encode back into a unit vector
+     */
+    glm::vec3 octahedral_decode(const glm::vec2& encoded);
+
+    /*!
+     * \brief Packs vertices in Minecraft's 7-int block format into PACKED_POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT
+     *
+     * Minecraft's vertices are position (3 floats, relative to the chunk), color (RGBA8), UV (2 floats), and the
+     * lightmap coordinate (two shorts). Minecraft doesn't send normals or tangents, so they're worked out from the
+     * triangles each vertex is in: the normal faces the way the triangles wind counterclockwise, and the tangent
+     * points the way U increases along the surface. A vertex that's shared by several triangles gets their
+     * area-weighted average. A vertex that isn't in any triangle with an area gets +Y for its normal and +X for its
+     * tangent
+     *
+     * \param mc_vertex_data The vertices from Minecraft. Any trailing ints that don't make a whole vertex are ignored
+     * \param indices The triangles' indices, or empty if every four vertices are a quad. Indices past the last
+     * vertex are ignored
+     * \param vertex_data The packed vertices are appended to this, six ints per vertex
+     */
+    void pack_chunk_vertices(const std::vector<int>& mc_vertex_data, const std::vector<int>& indices,
+                             std::vector<int>& vertex_data);
+}
+
+#endif //RENDERER_VERTEX_PACKING_H
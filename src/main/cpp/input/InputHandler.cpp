@@ -1,3 +1,5 @@
+#include <cstring>
+#include <easylogging++.h>
 #include "glad/glad.h"
 #include "InputHandler.h"
 #include "../render/nova_renderer.h"
@@ -31,16 +33,25 @@ namespace nova {
 
 	input_handler::~input_handler() {};
 
+	template <typename Event, size_t Capacity>
+	void input_handler::push_event(spsc_ring<Event, Capacity>& ring, const Event& e) {
+		if(!ring.try_push(e)) {
+			if(num_dropped_events == 0) {
+				LOG(WARNING) << "Minecraft isn't taking input events fast enough, so some are being dropped";
+			}
+			num_dropped_events++;
+		}
+	}
+
 	void input_handler::queue_mouse_button_event(struct mouse_button_event e) {
-		std::lock_guard<std::mutex> lock_guard(lock_button);
-		mouse_button_event_queue.push(e);
+		// A click should come after the moves before it
+		end_poll();
+		push_event(mouse_button_events, e);
 	};
 
 	struct mouse_button_event input_handler::dequeue_mouse_button_event() {
-		std::lock_guard<std::mutex> lock_guard(lock_button);
-		if (mouse_button_event_queue.size() != 0) {
-			struct mouse_button_event e = mouse_button_event_queue.front();
-			mouse_button_event_queue.pop();
+		struct mouse_button_event e;
+		if(mouse_button_events.try_pop(e)) {
 			return e;
 		}
 		return { 0,0,0,0 };
@@ -48,30 +59,31 @@ namespace nova {
 
 
 	void input_handler::queue_mouse_position_event(struct mouse_position_event e) {
-		std::lock_guard<std::mutex> lock_guard(lock_position);
-		mouse_position_event_queue.push(e);
+		if(coalesce_mouse_positions) {
+			held_mouse_position = e;
+			return;
+		}
+		// Coalescing may have just been turned off, and the position it was holding is older than this one
+		end_poll();
+		push_event(mouse_position_events, e);
 	};
 
 	struct mouse_position_event input_handler::dequeue_mouse_position_event() {
-		std::lock_guard<std::mutex> lock_guard(lock_position);
-		if (mouse_position_event_queue.size() != 0) {
-			struct mouse_position_event e = mouse_position_event_queue.front();
-			mouse_position_event_queue.pop();
+		struct mouse_position_event e;
+		if(mouse_position_events.try_pop(e)) {
 			return e;
 		}
 		return { 0,0,0 };
 	}
 
     void input_handler::queue_mouse_scroll_event(struct mouse_scroll_event e) {
-        std::lock_guard<std::mutex> lock_guard(lock_scroll);
-        mouse_scroll_event_queue.push(e);
+        end_poll();
+        push_event(mouse_scroll_events, e);
     };
 
     struct mouse_scroll_event input_handler::dequeue_mouse_scroll_event() {
-        std::lock_guard<std::mutex> lock_guard(lock_scroll);
-        if(mouse_scroll_event_queue.size() != 0) {
-            struct mouse_scroll_event e = mouse_scroll_event_queue.front();
-            mouse_scroll_event_queue.pop();
+        struct mouse_scroll_event e;
+        if(mouse_scroll_events.try_pop(e)) {
             return e;
         }
         return { 0,0,0 };
@@ -79,38 +91,99 @@ namespace nova {
 
 	void input_handler::queue_key_press_event(key_press_event e)
 	{
-		std::lock_guard<std::mutex> lock_guard(lock_key_press);
-		key_press_event_queue.push(e);
+		if(e.key == TRACE_HOTKEY && e.action == GLFW_PRESS && (e.mods & GLFW_MOD_CONTROL) != 0) {
+			trace_requested = true;
+		}
+		push_event(key_press_events, e);
+	}
+
+	bool input_handler::take_trace_request() {
+		return trace_requested.exchange(false);
 	}
 
 	key_press_event input_handler::dequeue_key_press_event()
 	{
-		std::lock_guard<std::mutex> lock_guard(lock_key_press);
-		if (key_press_event_queue.size() != 0) {
-			struct key_press_event e = key_press_event_queue.front();
-			key_press_event_queue.pop();
-			e.key =(int) keymap[e.key];
-			return e;
+		struct key_press_event e;
+		if(key_press_events.try_pop(e)) {
+			return translate_key(e);
 		}
 		return {0,0,0,0,0};
 	}
 
 	void input_handler::queue_key_char_event(key_char_event e)
 	{
-		std::lock_guard<std::mutex> lock_guard(lock_key_char);
-		key_char_event_queue.push(e);
+		push_event(key_char_events, e);
 	}
 
 	key_char_event input_handler::dequeue_key_char_event()
 	{
-		std::lock_guard<std::mutex> lock_guard(lock_key_char);
-		if (key_char_event_queue.size() != 0) {
-			struct key_char_event e = key_char_event_queue.front();
-			key_char_event_queue.pop();
+		struct key_char_event e;
+		if(key_char_events.try_pop(e)) {
 			return e;
 		}
 		return {0,0};
 	}
+
+	void input_handler::end_poll() {
+		if(held_mouse_position.filled != 0) {
+			push_event(mouse_position_events, held_mouse_position);
+			held_mouse_position.filled = 0;
+		}
+	}
+
+	/*!
+	 * \brief Pops events off of the ring into the buffer until the ring is empty or the buffer is full
+	 *
+	 * \return How many events were copied
+	 */
+	template <typename Event, size_t Capacity, typename Transform>
+	static int copy_events(spsc_ring<Event, Capacity>& ring, uint8_t* buffer, size_t buffer_size, size_t& write_pos, Transform transform) {
+		int num_events = 0;
+		Event e;
+		while(write_pos + sizeof(Event) <= buffer_size && ring.try_pop(e)) {
+			e = transform(e);
+			std::memcpy(buffer + write_pos, &e, sizeof(Event));
+			write_pos += sizeof(Event);
+			num_events++;
+		}
+		return num_events;
+	}
+
+	size_t input_handler::dequeue_all_events(uint8_t* buffer, size_t buffer_size) {
+		static_assert(sizeof(input_event_batch_header) % alignof(mouse_scroll_event) == 0, "The scroll events have to start aligned");
+		static_assert(sizeof(mouse_scroll_event) % alignof(key_char_event) == 0, "The key char events have to start aligned");
+		static_assert(sizeof(key_char_event) % alignof(mouse_button_event) == 0, "The mouse button events have to start aligned");
+
+		if(buffer_size < sizeof(input_event_batch_header)) {
+			return 0;
+		}
+
+		auto keep = [](auto e) { return e; };
+		auto translate = [this](key_press_event e) { return translate_key(e); };
+
+		input_event_batch_header header = {};
+		size_t write_pos = sizeof(input_event_batch_header);
+		header.num_mouse_scroll_events = copy_events(mouse_scroll_events, buffer, buffer_size, write_pos, keep);
+		header.num_key_char_events = copy_events(key_char_events, buffer, buffer_size, write_pos, keep);
+		header.num_mouse_button_events = copy_events(mouse_button_events, buffer, buffer_size, write_pos, keep);
+		header.num_key_press_events = copy_events(key_press_events, buffer, buffer_size, write_pos, translate);
+		header.num_mouse_position_events = copy_events(mouse_position_events, buffer, buffer_size, write_pos, keep);
+
+		std::memcpy(buffer, &header, sizeof(input_event_batch_header));
+		return write_pos;
+	}
+
+	key_press_event input_handler::translate_key(key_press_event e) const {
+		auto lwjgl_key = keymap.find(e.key);
+		e.key = lwjgl_key != keymap.end() ? (int) lwjgl_key->second : (int) lwjgl_keycodes::KEY_NONE;
+		return e;
+	}
+
+	void input_handler::on_config_change(nlohmann::json& new_config) {
+		coalesce_mouse_positions = new_config.value("coalesceMousePositions", coalesce_mouse_positions.load());
+	}
+
+	void input_handler::on_config_loaded(nlohmann::json& config) {}
 	
 
 	void input_handler::create_keymap() {
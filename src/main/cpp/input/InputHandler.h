@@ -4,10 +4,13 @@
 
 
 #include "GLFW/glfw3.h"
-#include <queue>
-#include <mutex>
+#include <atomic>
+#include <cstdint>
 #include <unordered_map>
+#include <json.hpp>
 #include "../mc_interface/mc_objects.h"
+#include "../data_loading/settings.h"
+#include "../utils/spsc_ring.h"
 
 namespace nova {
 
@@ -159,8 +162,27 @@ namespace nova {
 
     void mouse_scroll_callback(GLFWwindow *window, double xoffset, double yoffset);
 
-    class input_handler {
+    /*!
+     * \brief Holds input events from GLFW until Minecraft asks for them
+     *
+     * Events are queued from GLFW's callbacks while the window is polled, and dequeued by Minecraft. Each kind of
+     * event has its own lock-free ring, so that has to be one thread queueing and one thread dequeueing. If Minecraft
+     * falls so far behind that a ring fills up, new events of that kind are dropped
+     *
+     * With the coalesceMousePositions setting on, all the mouse moves from one poll become a single event
+     */
+    class input_handler : public iconfig_listener {
     public:
+        /*!
+         * \brief How many events of each kind can be waiting for Minecraft
+         */
+        static const size_t EVENT_RING_CAPACITY = 1024;
+
+        /*!
+         * \brief Pressing this key with control held saves the profiler's trace. Minecraft still gets the key press
+         */
+        static const int TRACE_HOTKEY = GLFW_KEY_F12;
+
         input_handler();
         ~input_handler();
         void queue_mouse_button_event(mouse_button_event  e);
@@ -175,19 +197,64 @@ namespace nova {
         void queue_key_char_event(key_char_event  e);
         key_char_event dequeue_key_char_event();
 
+        /*!
+         * \brief Queues the mouse position that's being held back for coalescing. Called after every poll
+         */
+        void end_poll();
+
+        /*!
+         * \brief Copies as many waiting events as fit into the buffer, in the layout described by
+         * input_event_batch_header. Events that don't fit stay queued for next time
+         *
+         * \return The number of bytes written, or 0 if the buffer can't even fit the header
+         */
+        size_t dequeue_all_events(uint8_t* buffer, size_t buffer_size);
+
+        /*!
+         * \brief Checks if the trace hotkey was pressed since the last time this was called
+         */
+        bool take_trace_request();
+
+        void on_config_change(nlohmann::json& new_config) override;
+
+        void on_config_loaded(nlohmann::json& config) override;
+
     private:
         std::unordered_map<int, lwjgl_keycodes> keymap;
-        std::queue< mouse_button_event> mouse_button_event_queue;
-        std::queue< mouse_position_event> mouse_position_event_queue;
-        std::queue< mouse_scroll_event> mouse_scroll_event_queue;
-        std::mutex lock_button;
-        std::mutex lock_position;
-        std::mutex lock_scroll;
-
-        std::queue< key_press_event> key_press_event_queue;
-        std::queue< key_char_event> key_char_event_queue;
-        std::mutex lock_key_press;
-        std::mutex lock_key_char;
+        spsc_ring<mouse_button_event, EVENT_RING_CAPACITY> mouse_button_events;
+        spsc_ring<mouse_position_event, EVENT_RING_CAPACITY> mouse_position_events;
+        spsc_ring<mouse_scroll_event, EVENT_RING_CAPACITY> mouse_scroll_events;
+        spsc_ring<key_press_event, EVENT_RING_CAPACITY> key_press_events;
+        spsc_ring<key_char_event, EVENT_RING_CAPACITY> key_char_events;
+
+        /*!
+         * \brief Set on the render thread, but read on the thread that polls the window
+         */
+        std::atomic<bool> coalesce_mouse_positions{false};
+
+        /*!
+         * \brief Set on the thread that polls the window, and taken on the render thread
+         */
+        std::atomic<bool> trace_requested{false};
+
+        /*!
+         * \brief The newest mouse position from this poll, if mouse positions are being coalesced
+         */
+        mouse_position_event held_mouse_position = {0, 0, 0};
+
+        /*!
+         * \brief How many events were dropped because Minecraft wasn't dequeueing them, so we can say so once
+         */
+        uint64_t num_dropped_events = 0;
+
+        template <typename Event, size_t Capacity>
+        void push_event(spsc_ring<Event, Capacity>& ring, const Event& e);
+
+        /*!
+         * \brief Turns a key press from GLFW's key codes into LWJGL's, which is what Minecraft expects
+         */
+        key_press_event translate_key(key_press_event e) const;
+
         void create_keymap();
     };
 
@@ -0,0 +1,265 @@
+/*!
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <cstdlib>
+#include <easylogging++.h>
+#include "api_capture.h"
+#include "../geometry_cache/greedy_mesher.h"
+
+namespace nova {
+    /*!
+     * \brief The size of a record's command, timestamp, and payload size
+     */
+    static const size_t RECORD_HEADER_SIZE = sizeof(uint8_t) + sizeof(uint64_t) + sizeof(uint32_t);
+
+    std::unique_ptr<api_capture> api_capture::instance;
+
+    capture_payload::capture_payload(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+    void capture_payload::read(void* destination, size_t num_bytes) {
+        if(num_bytes > size - position) {
+            overran = true;
+            position = size;
+            return;
+        }
+        std::memcpy(destination, data + position, num_bytes);
+        position += num_bytes;
+    }
+
+    std::string capture_payload::get_string() {
+        auto chars = get_array<char>();
+        return std::string(chars.begin(), chars.end());
+    }
+
+    capture_reader::capture_reader(const std::vector<uint8_t>& data) : data(data) {
+        const size_t header_size = sizeof(CAPTURE_MAGIC) + sizeof(uint32_t);
+        if(data.size() < header_size || std::memcmp(data.data(), CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC)) != 0) {
+            return;
+        }
+
+        uint32_t version;
+        std::memcpy(&version, &data[sizeof(CAPTURE_MAGIC)], sizeof(version));
+        valid = version == CAPTURE_VERSION;
+        position = header_size;
+    }
+
+    bool capture_reader::is_valid() const {
+        return valid;
+    }
+
+    bool capture_reader::next(capture_record& record) {
+        if(!valid || data.size() - position < RECORD_HEADER_SIZE) {
+            return false;
+        }
+
+        uint32_t payload_size;
+        record.command = static_cast<capture_command>(data[position]);
+        std::memcpy(&record.time_us, &data[position + 1], sizeof(record.time_us));
+        std::memcpy(&payload_size, &data[position + 1 + sizeof(record.time_us)], sizeof(payload_size));
+        position += RECORD_HEADER_SIZE;
+
+        if(data.size() - position < payload_size) {
+            return false;
+        }
+
+        record.payload = capture_payload(&data[position], payload_size);
+        position += payload_size;
+        return true;
+    }
+
+    void api_capture::start_from_environment() {
+        const char* path = std::getenv("NOVA_CAPTURE_FILE");
+        if(path == nullptr || *path == '\0') {
+            return;
+        }
+
+        auto capture = std::make_unique<api_capture>(path);
+        if(!capture->is_open()) {
+            LOG(ERROR) << "Could not open " << path << " to capture to";
+            return;
+        }
+
+        LOG(INFO) << "Capturing calls to " << path;
+        instance = std::move(capture);
+    }
+
+    api_capture* api_capture::get() {
+        return instance.get();
+    }
+
+    api_capture::api_capture(const std::string& path) : file(path, std::ios::binary | std::ios::trunc),
+                                                        start_time(std::chrono::steady_clock::now()) {
+        if(file.is_open()) {
+            file.write(CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC));
+            file.write(reinterpret_cast<const char*>(&CAPTURE_VERSION), sizeof(CAPTURE_VERSION));
+        }
+    }
+
+    bool api_capture::is_open() const {
+        return file.is_open();
+    }
+
+    void api_capture::put_string(const char* str) {
+        put_array(str, str == nullptr ? 0 : std::strlen(str));
+    }
+
+    void api_capture::write_record(capture_command command) {
+        const auto time_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start_time).count());
+        const auto payload_size = static_cast<uint32_t>(payload.size());
+
+        const auto command_byte = static_cast<uint8_t>(command);
+        file.write(reinterpret_cast<const char*>(&command_byte), sizeof(command_byte));
+        file.write(reinterpret_cast<const char*>(&time_us), sizeof(time_us));
+        file.write(reinterpret_cast<const char*>(&payload_size), sizeof(payload_size));
+        file.write(reinterpret_cast<const char*>(payload.data()), payload.size());
+        payload.clear();
+    }
+
+    void api_capture::record_get_shader_id(const char* shader_name) {
+        std::lock_guard<std::mutex> lock(file_lock);
+        put_string(shader_name);
+        write_record(capture_command::get_shader_id);
+    }
+
+    void api_capture::record_add_texture(const mc_atlas_texture& texture, size_t num_bytes) {
+        std::lock_guard<std::mutex> lock(file_lock);
+        put(texture.width);
+        put(texture.height);
+        put(texture.num_components);
+        put_string(texture.name);
+        put_array(texture.texture_data, num_bytes);
+        write_record(capture_command::add_texture);
+    }
+
+    void api_capture::record_add_texture_location(const mc_texture_atlas_location& location) {
+        std::lock_guard<std::mutex> lock(file_lock);
+        put_string(location.name);
+        put(location.min_u);
+        put(location.max_u);
+        put(location.min_v);
+        put(location.max_v);
+        write_record(capture_command::add_texture_location);
+    }
+
+    void api_capture::record_reset_texture_manager() {
+        std::lock_guard<std::mutex> lock(file_lock);
+        write_record(capture_command::reset_texture_manager);
+    }
+
+    void api_capture::record_send_lightmap_texture(const int* data, int count, int width, int height) {
+        std::lock_guard<std::mutex> lock(file_lock);
+        put(width);
+        put(height);
+        put_array(data, static_cast<size_t>(count));
+        write_record(capture_command::send_lightmap_texture);
+    }
+
+    void api_capture::record_add_chunk_geometry(const char* filter_name, int shader_id, const mc_chunk_render_object& chunk, bool is_direct) {
+        std::lock_guard<std::mutex> lock(file_lock);
+        uint8_t flags = is_direct ? CAPTURE_CHUNK_DIRECT : 0;
+        if(filter_name != nullptr) {
+            flags |= CAPTURE_CHUNK_BY_FILTER_NAME;
+        }
+        put(flags);
+        put_string(filter_name);
+        put(shader_id);
+        put(chunk.format);
+        put(chunk.x);
+        put(chunk.y);
+        put(chunk.z);
+        put(chunk.id);
+        put_array(chunk.vertex_data, static_cast<size_t>(chunk.vertex_buffer_size));
+        put_array(chunk.indices, static_cast<size_t>(chunk.index_buffer_size));
+        write_record(capture_command::add_chunk_geometry);
+    }
+
+    void api_capture::record_remove_chunk_geometry(const char* filter_name, int shader_id, const mc_chunk_render_object& chunk) {
+        std::lock_guard<std::mutex> lock(file_lock);
+        put(static_cast<uint8_t>(filter_name != nullptr ? CAPTURE_CHUNK_BY_FILTER_NAME : 0));
+        put_string(filter_name);
+        put(shader_id);
+        put(chunk.x);
+        put(chunk.y);
+        put(chunk.z);
+        put(chunk.id);
+        write_record(capture_command::remove_chunk_geometry);
+    }
+
+    void api_capture::record_set_mesher_block_type(const mc_mesher_block_type& block_type) {
+        std::lock_guard<std::mutex> lock(file_lock);
+        put(block_type);
+        write_record(capture_command::set_mesher_block_type);
+    }
+
+    void api_capture::record_add_chunk_section_blocks(const mc_chunk_section_blocks& section) {
+        std::lock_guard<std::mutex> lock(file_lock);
+        put(section.x);
+        put(section.y);
+        put(section.z);
+        put(section.id);
+        put_array(section.block_ids, PADDED_SECTION_VOLUME);
+        put_array(section.light, PADDED_SECTION_VOLUME);
+        write_record(capture_command::add_chunk_section_blocks);
+    }
+
+    void api_capture::record_add_gui_geometry(const mc_gui_geometry& gui_geometry) {
+        std::lock_guard<std::mutex> lock(file_lock);
+        put_string(gui_geometry.texture_name);
+        put_string(gui_geometry.atlas_name);
+        put_array(gui_geometry.index_buffer, static_cast<size_t>(gui_geometry.index_buffer_size));
+        put_array(gui_geometry.vertex_buffer, static_cast<size_t>(gui_geometry.vertex_buffer_size));
+        write_record(capture_command::add_gui_geometry);
+    }
+
+    void api_capture::record_clear_gui_buffers() {
+        std::lock_guard<std::mutex> lock(file_lock);
+        write_record(capture_command::clear_gui_buffers);
+    }
+
+    void api_capture::record_set_string_setting(const char* setting_name, const char* setting_value) {
+        std::lock_guard<std::mutex> lock(file_lock);
+        put_string(setting_name);
+        put_string(setting_value);
+        write_record(capture_command::set_string_setting);
+    }
+
+    void api_capture::record_set_float_setting(const char* setting_name, float setting_value) {
+        std::lock_guard<std::mutex> lock(file_lock);
+        put_string(setting_name);
+        put(setting_value);
+        write_record(capture_command::set_float_setting);
+    }
+
+    void api_capture::record_set_player_camera_transform(double x, double y, double z, float yaw, float pitch) {
+        std::lock_guard<std::mutex> lock(file_lock);
+        put(x);
+        put(y);
+        put(z);
+        put(yaw);
+        put(pitch);
+        write_record(capture_command::set_player_camera_transform);
+    }
+
+    void api_capture::record_set_celestial_angle(float celestial_angle) {
+        std::lock_guard<std::mutex> lock(file_lock);
+        put(celestial_angle);
+        write_record(capture_command::set_celestial_angle);
+    }
+
+    void api_capture::record_set_sky_state(double world_time, float rain_strength, int is_snowing) {
+        std::lock_guard<std::mutex> lock(file_lock);
+        put(world_time);
+        put(rain_strength);
+        put(is_snowing);
+        write_record(capture_command::set_sky_state);
+    }
+
+    void api_capture::record_execute_frame() {
+        std::lock_guard<std::mutex> lock(file_lock);
+        write_record(capture_command::execute_frame);
+        file.flush();
+    }
+}
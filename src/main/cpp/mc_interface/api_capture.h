@@ -0,0 +1,236 @@
+/*!
+ * \brief Records the calls Minecraft makes into Nova, so they can be replayed later by nova-bench
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_API_CAPTURE_H
+#define RENDERER_API_CAPTURE_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "mc_objects.h"
+
+namespace nova {
+    /*!
+     * \brief The first bytes of every capture file, then a uint32_t version
+     */
+    const char CAPTURE_MAGIC[8] = {'N', 'O', 'V', 'A', 'C', 'A', 'P', 'T'};
+    const uint32_t CAPTURE_VERSION = 1;
+
+    /*!
+     * \brief Which call a capture record holds. The values are written to the file, so don't reorder them
+     */
+    enum class capture_command : uint8_t {
+        get_shader_id = 1,
+        add_texture,
+        add_texture_location,
+        reset_texture_manager,
+        send_lightmap_texture,
+        add_chunk_geometry,
+        remove_chunk_geometry,
+        set_mesher_block_type,
+        add_chunk_section_blocks,
+        add_gui_geometry,
+        clear_gui_buffers,
+        set_string_setting,
+        set_float_setting,
+        set_player_camera_transform,
+        set_celestial_angle,
+        execute_frame,
+        set_sky_state
+    };
+
+    /*!
+     * \brief How add_chunk_geometry and remove_chunk_geometry records name their shader, and whether the chunk was
+     * sent with the direct API
+     */
+    const uint8_t CAPTURE_CHUNK_BY_FILTER_NAME = 1;
+    const uint8_t CAPTURE_CHUNK_DIRECT = 2;
+
+    /*!
+     * \brief Reads the values out of a record's payload, in the order they were written
+     *
+     * Reading past the end gives zeros and sets #overran, so a truncated file can't crash the replay
+     */
+    class capture_payload {
+    public:
+        capture_payload() = default;
+
+        capture_payload(const uint8_t* data, size_t size);
+
+        template <typename T>
+        T get() {
+            T value = {};
+            read(&value, sizeof(T));
+            return value;
+        }
+
+        std::string get_string();
+
+        /*!
+         * \brief Reads an array that was written with api_capture#put_array
+         */
+        template <typename T>
+        std::vector<T> get_array() {
+            const auto count = get<uint32_t>();
+            std::vector<T> values;
+            if(static_cast<uint64_t>(count) * sizeof(T) > size - position) {
+                overran = true;
+                return values;
+            }
+            values.resize(count);
+            read(values.data(), count * sizeof(T));
+            return values;
+        }
+
+        bool overran = false;
+
+    private:
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        size_t position = 0;
+
+        void read(void* destination, size_t num_bytes);
+    };
+
+    /*!
+     * \brief One call from a capture file
+     */
+    struct capture_record {
+        capture_command command = capture_command::execute_frame;
+
+        /*!
+         * \brief When the call was made, in microseconds since the capture started
+         */
+        uint64_t time_us = 0;
+
+        capture_payload payload;
+    };
+
+    /*!
+     * \brief Walks through the records in a capture file that's been read into memory
+     */
+    class capture_reader {
+    public:
+        /*!
+         * \brief Checks the file's header
+         *
+         * \param data The whole capture file. Must stay alive for as long as the reader and its records
+         */
+        explicit capture_reader(const std::vector<uint8_t>& data);
+
+        /*!
+         * \brief Checks if the file started with the magic number and a version we can read
+         */
+        bool is_valid() const;
+
+        /*!
+         * \brief Reads the next record
+         *
+         * \return False at the end of the file, or if the last record was cut off
+         */
+        bool next(capture_record& record);
+
+    private:
+        const std::vector<uint8_t>& data;
+        size_t position = 0;
+        bool valid = false;
+    };
+
+    /*!
+     * \brief Writes calls to a capture file as they're made
+     *
+     * Each record is a one byte capture_command, an eight byte timestamp, a four byte payload size, then the payload.
+     * Strings and arrays are written as a four byte count followed by their contents. Everything is little-endian,
+     * since that's what every platform Nova runs on is
+     *
+     * Minecraft calls Nova from more than one thread, so every record is written under a lock. The file is flushed
+     * after every frame, so a crash loses at most the frame it happened in
+     */
+    class api_capture {
+    public:
+        /*!
+         * \brief Starts recording to the given file, if the NOVA_CAPTURE_FILE environment variable is set. Should be
+         * called once, when Nova starts up
+         */
+        static void start_from_environment();
+
+        /*!
+         * \brief The capture that's recording, or nullptr if nothing is being captured
+         */
+        static api_capture* get();
+
+        explicit api_capture(const std::string& path);
+
+        bool is_open() const;
+
+        void record_get_shader_id(const char* shader_name);
+        void record_add_texture(const mc_atlas_texture& texture, size_t num_bytes);
+        void record_add_texture_location(const mc_texture_atlas_location& location);
+        void record_reset_texture_manager();
+        void record_send_lightmap_texture(const int* data, int count, int width, int height);
+
+        /*!
+         * \param filter_name The filter the chunk was added for, or nullptr if it was added by shader ID
+         */
+        void record_add_chunk_geometry(const char* filter_name, int shader_id, const mc_chunk_render_object& chunk, bool is_direct);
+        void record_remove_chunk_geometry(const char* filter_name, int shader_id, const mc_chunk_render_object& chunk);
+
+        void record_set_mesher_block_type(const mc_mesher_block_type& block_type);
+        void record_add_chunk_section_blocks(const mc_chunk_section_blocks& section);
+        void record_add_gui_geometry(const mc_gui_geometry& gui_geometry);
+        void record_clear_gui_buffers();
+        void record_set_string_setting(const char* setting_name, const char* setting_value);
+        void record_set_float_setting(const char* setting_name, float setting_value);
+        void record_set_player_camera_transform(double x, double y, double z, float yaw, float pitch);
+        void record_set_celestial_angle(float celestial_angle);
+        void record_set_sky_state(double world_time, float rain_strength, int is_snowing);
+        void record_execute_frame();
+
+    private:
+        static std::unique_ptr<api_capture> instance;
+
+        std::ofstream file;
+        std::mutex file_lock;
+        std::chrono::steady_clock::time_point start_time;
+
+        /*!
+         * \brief The payload of the record being written. Only touched while file_lock is held
+         */
+        std::vector<uint8_t> payload;
+
+        template <typename T>
+        void put(const T& value) {
+            const size_t offset = payload.size();
+            payload.resize(offset + sizeof(T));
+            std::memcpy(&payload[offset], &value, sizeof(T));
+        }
+
+        void put_string(const char* str);
+
+        template <typename T>
+        void put_array(const T* values, size_t count) {
+            put(static_cast<uint32_t>(count));
+            const size_t offset = payload.size();
+            payload.resize(offset + count * sizeof(T));
+            if(count > 0) {
+                std::memcpy(&payload[offset], values, count * sizeof(T));
+            }
+        }
+
+        /*!
+         * \brief Writes the record header and payload to the file, then clears the payload
+         */
+        void write_record(capture_command command);
+    };
+}
+
+#endif //RENDERER_API_CAPTURE_H
@@ -37,6 +37,16 @@ struct mc_texture_atlas_location {
     float max_v;
 };
 
+/*!
+ * \brief One sprite for add_texture_atlas to stitch into an atlas
+ */
+struct mc_atlas_sprite {
+    const char * name;
+    int width;
+    int height;
+    unsigned char * texture_data;   //!< RGBA, four bytes per texel, top row first
+};
+
 struct mc_block_definition {
 	const char * name;
 	int light_opacity;
@@ -69,12 +79,58 @@ struct mc_chunk_render_object {
 	float z;
 	int id;
 	int* vertex_data;
-	int* indices;
+	int* indices;           //!< May be null, with an index_buffer_size of 0, if the chunk is all quads. See is_quad_format
 	int vertex_buffer_size;
 	int index_buffer_size;
 
 };
 
+/*!
+ * \brief One chunk in a batch sent with add_chunk_geometry_batch
+ *
+ * The chunk's data is in the batch's payload, which every chunk in the batch shares. Offsets and sizes count ints
+ */
+struct mc_chunk_batch_entry {
+    int shader_id;          //!< From get_shader_id
+    int format;
+    float x;
+    float y;
+    float z;
+    int id;
+    int vertex_offset;
+    int vertex_buffer_size; //!< 0 removes the chunk from the shader instead of adding it
+    int index_offset;
+    int index_buffer_size;  //!< May be 0 if the chunk is all quads, like mc_chunk_render_object's indices
+};
+
+/*!
+ * \brief Tells the native chunk mesher how to draw one kind of block
+ *
+ * Faces are in the order -x, +x, -y, +y, -z, +z
+ */
+struct mc_mesher_block_type {
+    int block_id;
+    int is_visible;     //!< 0 for air and for any block that isn't a full cube, which Minecraft still has to mesh
+    int is_opaque;
+    int shader_id;      //!< From get_shader_id, for the filter that the block passes
+    float face_uvs[24]; //!< min u, max u, min v, max v for each face, like mc_texture_atlas_location
+    int face_tints[6];  //!< In the same byte order as the colors in Minecraft's vertices
+};
+
+/*!
+ * \brief The blocks in one 16x16x16 chunk section, for the native chunk mesher
+ *
+ * The arrays are 18x18x18, with a one block border from the neighboring sections, indexed by (y * 18 + z) * 18 + x
+ */
+struct mc_chunk_section_blocks {
+    float x;
+    float y;
+    float z;
+    int id;
+    unsigned short* block_ids;
+    unsigned char* light;       //!< Block light in the low four bits, sky light in the high four bits
+};
+
 /*!
  * \brief Represents a single quad in Minecraft
  */
@@ -202,8 +258,132 @@ struct key_char_event {
 
 };
 
+/*!
+ * \brief The start of the buffer that get_input_events fills
+ *
+ * The events come right after this, as an array of each kind of event in the same order as the counts here. That
+ * order keeps the arrays with doubles in them 8 byte aligned
+ */
+struct input_event_batch_header {
+    int num_mouse_scroll_events;
+    int num_key_char_events;
+    int num_mouse_button_events;
+    int num_key_press_events;
+    int num_mouse_position_events;
+    int padding;
+};
+
 struct window_size {
     int height;
     int width;
 };
+
+/*!
+ * \brief The most passes get_frame_statistics reports. Later passes are left out
+ */
+const int MAX_MC_PASS_STATISTICS = 16;
+
+/*!
+ * \brief What one pass drew. See nova::pass_statistics
+ */
+struct mc_pass_statistics {
+    char name[32];
+    long long draw_calls;
+    long long draw_commands;
+    long long triangles;
+    long long primitives_submitted;
+    long long vertex_shader_invocations;
+    long long clipping_output_primitives;
+    long long fragment_shader_invocations;
+};
+
+/*!
+ * \brief A snapshot of one frame's counters, filled in by get_frame_statistics. See nova::frame_statistics
+ */
+struct mc_frame_statistics {
+    long long frame;
+    long long draw_calls;
+    long long draw_commands;
+    long long triangles;
+    long long state_changes;
+    long long state_changes_saved;
+    long long texture_binds;
+    long long bytes_uploaded;
+    long long performance_warnings;
+    int has_pipeline_statistics;
+    int num_passes;
+    mc_pass_statistics passes[MAX_MC_PASS_STATISTICS];
+};
+
+/*!
+ * \brief How much GPU memory Nova is using, in bytes, filled in by get_gpu_memory_usage
+ */
+struct mc_gpu_memory_usage {
+    long long chunk_geometry;       //!< The part of the chunk arena that meshes are using
+    long long chunk_arena_reserved; //!< The size of all the chunk arena's pages
+    long long meshes;
+    long long textures;
+    long long framebuffers;
+    long long buffers;
+    long long total;                //!< Everything above but chunk_arena_reserved. This is what the budget is checked against
+    long long budget;               //!< The vramBudgetMegabytes setting in bytes, or 0 if there's no budget
+};
+
+/*!
+ * \brief A chunk that Nova needs Minecraft to send again. See get_chunks_to_rebuild
+ */
+struct mc_chunk_position {
+    int x;
+    int y;
+    int z;
+    int id;
+};
+
+/*!
+ * \brief The geometry of an entity model, or one part of one, for add_entity_model
+ *
+ * The vertices are in the model's own space and already in the layout of their format, so
+ * POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT has 13 ints per vertex
+ */
+struct mc_entity_model {
+    int format;
+    int* vertex_data;
+    int* indices;
+    int vertex_buffer_size;
+    int index_buffer_size;
+    const char* texture_name;   //!< The name the texture manager knows the model's texture by
+};
+
+/*!
+ * \brief One copy of an entity model to draw this frame, for set_entity_instances
+ */
+struct mc_entity_instance {
+    int model_id;           //!< From add_entity_model
+    int entity_id;
+    int animation_frame;
+    int lightmap_coord;     //!< Minecraft's packed brightness: block light in the low 16 bits, sky light in the high 16
+    float transform[16];    //!< Column major, from the model's space to world space
+    float tint[4];
+};
+
+/*!
+ * \brief A burst of particles for spawn_particles. Every particle from the emitter uses the same texture
+ */
+struct mc_particle_emitter {
+    float position[3];
+    float position_spread;      //!< How far from the position, in blocks, each particle can start
+    float velocity[3];          //!< In blocks per second
+    float velocity_spread;      //!< How far off each particle's velocity can be, in blocks per second
+    float color[4];
+    float uv_min[2];            //!< The top left of the first animation frame in the atlas
+    float uv_max[2];            //!< The bottom right of the last animation frame. Frames are laid out left to right
+    float size;                 //!< The width of each particle, in blocks
+    float gravity;              //!< In blocks per second squared
+    float drag;                 //!< The part of its velocity that each particle keeps after a second
+    float lifetime;             //!< In seconds
+    float lifetime_spread;      //!< How far off each particle's lifetime can be, in seconds
+    int num_frames;             //!< How many animation frames the particles play through over their lifetimes
+    int atlas;                  //!< From add_particle_atlas
+    int count;                  //!< How many particles to spawn
+};
 #endif //RENDERER_MC_OBJECTS_H
@@ -47,8 +47,20 @@ NOVA_API void send_lightmap_texture(int* data, int count, int width, int height)
  * The renderer isn't a parameter to this function because it's a static variable of the \class nova_renderer class.
  *
  * \param texture The texture to add to the renderer
+ * \return A ticket to check with is_texture_upload_complete
  */
-NOVA_API void add_texture(mc_atlas_texture & texture);
+NOVA_API long long add_texture(mc_atlas_texture & texture);
+
+/*!
+ * \brief Checks if the GPU has the texture for the given ticket yet
+ *
+ * add_texture returns as soon as the texture's pixels are copied, and the GPU gets them a bit later. The texture can
+ * be used right away, but this lets the Java side know when an atlas is actually ready
+ *
+ * \param ticket The ticket from add_texture
+ * \return True if the texture's upload has finished
+ */
+NOVA_API bool is_texture_upload_complete(long long ticket);
 
 /*!
  * \brief Adds the given location to the list of texture locations
@@ -60,6 +72,26 @@ NOVA_API void add_texture(mc_atlas_texture & texture);
  */
 NOVA_API void add_texture_location(mc_texture_atlas_location location);
 
+/*!
+ * \brief Stitches a batch of sprites into a new atlas and adds it, along with the location of every sprite in it
+ *
+ * All the sprites come over in one call instead of one add_texture_location per sprite. They're packed with a skyline
+ * packer into the smallest power of two atlas they fit in, and copied into it on a few worker threads. Each sprite gets
+ * a gutter of its own edge texels that's wide enough for the textureMipLevels setting, so sprites don't bleed into
+ * each other at a distance. The stitching happens before this returns, but the atlas gets to the GPU later, like
+ * add_texture
+ *
+ * \param atlas_name The name of the new atlas
+ * \param sprites The sprites to stitch
+ * \param num_sprites How many sprites there are
+ * \param locations Filled with where each sprite ended up, in the same order as the sprites. Must have room for
+ * num_sprites locations. The names point at the sprites' names
+ * \return A ticket to check with is_texture_upload_complete, or 0 if the sprites don't fit in the biggest texture the
+ * GPU allows. Nothing is added then
+ */
+NOVA_API long long add_texture_atlas(const char* atlas_name, mc_atlas_sprite* sprites, int num_sprites,
+                                     mc_texture_atlas_location* locations);
+
 /*!
  * \brief Queries OpenGL and returns the maximum texture size that OpenGL allows
  */
@@ -81,6 +113,225 @@ NOVA_API void reset_texture_manager();
  */
 NOVA_API void add_chunk_geometry_for_filter(const char* filter_name, mc_chunk_render_object* chunk);
 
+/*!
+ * \brief Removes a chunk's geometry from the given filter
+ *
+ * \param filter_name The filter to remove the chunk from
+ * \param chunk The chunk to remove. Only its position and ID are used
+ */
+NOVA_API void remove_chunk_geometry_for_filter(const char* filter_name, mc_chunk_render_object* chunk);
+
+/*!
+ * \brief Adds or updates a chunk without copying its geometry on the calling thread
+ *
+ * The chunk's vertex_data must already be in the 13-int layout Nova uses for chunks (position, color, UV, lightmap,
+ * normal, tangent), like what CapturingVertexBuffer produces, and vertex_data and indices usually point at Java direct
+ * ByteBuffers. Nova copies the data straight into its chunk geometry buffers on the render thread, so the buffers must
+ * stay alive and unchanged until is_chunk_geometry_upload_complete returns true for the returned ticket
+ *
+ * \param filter_name The filter to add the chunk to
+ * \param chunk The chunk to add
+ * \return A ticket to check with is_chunk_geometry_upload_complete
+ */
+NOVA_API long long add_chunk_geometry_for_filter_direct(const char* filter_name, mc_chunk_render_object* chunk);
+
+/*!
+ * \brief Checks if Nova is done reading the buffers passed to add_chunk_geometry_for_filter_direct
+ *
+ * \param ticket The ticket returned by add_chunk_geometry_for_filter_direct
+ * \return True if the buffers can be reused or freed
+ */
+NOVA_API bool is_chunk_geometry_upload_complete(long long ticket);
+
+/*!
+ * \brief Gets the ID of the shader with the given name, for use with the *_for_shader chunk functions
+ *
+ * A shader's ID never changes, even when a new shaderpack is loaded, so Minecraft only needs to ask once for each
+ * filter. Passing IDs instead of names means Nova doesn't have to copy and hash the name for every chunk
+ *
+ * \param shader_name The name of the shader whose filter chunks will be sent with the ID
+ * \return The shader's ID
+ */
+NOVA_API int get_shader_id(const char* shader_name);
+
+/*!
+ * \brief Like add_chunk_geometry_for_filter, but takes an ID from get_shader_id
+ */
+NOVA_API void add_chunk_geometry_for_shader(int shader_id, mc_chunk_render_object* chunk);
+
+/*!
+ * \brief Like remove_chunk_geometry_for_filter, but takes an ID from get_shader_id
+ */
+NOVA_API void remove_chunk_geometry_for_shader(int shader_id, mc_chunk_render_object* chunk);
+
+/*!
+ * \brief Like add_chunk_geometry_for_filter_direct, but takes an ID from get_shader_id
+ */
+NOVA_API long long add_chunk_geometry_for_shader_direct(int shader_id, mc_chunk_render_object* chunk);
+
+/*!
+ * \brief Adds or removes many chunks in one call, like add_chunk_geometry_for_shader and
+ * remove_chunk_geometry_for_shader would one at a time
+ *
+ * Rebuilding a chunk column touches every filter in each of its sections, which is dozens of calls that each cross
+ * JNI. Sending them together crosses once. Every chunk's vertices and indices are packed into one payload, and the
+ * entries say where in it each chunk's data is. Nova copies the data out before this returns
+ *
+ * \param entries The chunks, in the order they should be applied
+ * \param num_entries How many entries there are
+ * \param payload Every chunk's vertices and indices
+ * \param payload_size How many ints are in the payload
+ */
+NOVA_API void add_chunk_geometry_batch(mc_chunk_batch_entry* entries, int num_entries, int* payload, int payload_size);
+
+/*!
+ * \brief Tells the native chunk mesher how to draw a kind of block. Should be called for every block before any
+ * sections are sent with add_chunk_section_blocks
+ */
+NOVA_API void set_mesher_block_type(mc_mesher_block_type* block_type);
+
+/*!
+ * \brief Tells Nova how much light a kind of block gives off, so that shaderpacks can light the world with it
+ *
+ * Every block of this kind in the sections sent to add_chunk_section_blocks becomes a light, which shaders get from
+ * the block_lights and light_clusters storage blocks. Like set_mesher_block_type, this should be called before any
+ * sections are sent, since sections that are already loaded keep the lights they had
+ *
+ * \param block_id The block's ID, as it is in mc_chunk_section_blocks::block_ids
+ * \param light_value Minecraft's light value for the block, from 0 for none to 15
+ */
+NOVA_API void set_block_light_value(int block_id, int light_value);
+
+/*!
+ * \brief Meshes a chunk section from its blocks, instead of Minecraft building the geometry
+ *
+ * The full cubes in the section are meshed on Nova's worker threads, with neighboring faces merged into bigger quads
+ * and ambient occlusion baked into the vertex colors. Each shader that the section's blocks pass gets its own mesh,
+ * and shaders that don't have any of the section's blocks have the section removed. Minecraft should still send the
+ * blocks that aren't full cubes with add_chunk_geometry_for_shader, using a different chunk ID
+ *
+ * The section's arrays are copied, so they can be freed as soon as this returns
+ */
+NOVA_API void add_chunk_section_blocks(mc_chunk_section_blocks* section);
+
+/*!
+ * \brief Tells Nova which world and dimension the sections sent to add_chunk_section_blocks are from, so that it can
+ * keep their meshes on disk
+ *
+ * Each world's meshes are kept in their own file in the chunkMeshCacheDirectory. A section whose blocks and light
+ * haven't changed since it was last meshed, with the same block types, is read from the file instead of being meshed
+ * again. Call this when joining a world and whenever the player changes dimension, and pass an empty name when
+ * leaving the world
+ *
+ * \param world_name The name of the world, or the address of the server
+ * \param dimension Minecraft's ID for the dimension
+ */
+NOVA_API void set_chunk_mesh_cache_world(const char* world_name, int dimension);
+
+/*!
+ * \brief Uploads an entity model, so that copies of it can be drawn with set_entity_instances
+ *
+ * The model's vertices should be in the model's own space, not the world's. Every copy of the model that's visible in
+ * a frame is drawn with one instanced draw. The data is copied before this returns
+ *
+ * \param filter_name The name of the filter the model passes, which picks the shader it's drawn with
+ * \param model The model's geometry and texture
+ * \return The ID to refer to the model by
+ */
+NOVA_API int add_entity_model(const char* filter_name, mc_entity_model* model);
+
+/*!
+ * \brief Frees an entity model. Instances of it aren't drawn any more
+ */
+NOVA_API void remove_entity_model(int model_id);
+
+/*!
+ * \brief Replaces the list of entity model instances to draw
+ *
+ * Call this once per frame, before execute_frame, with every entity model instance in the world. Instances that are
+ * outside the view frustum are culled by Nova. The list is drawn every frame until a new one is sent
+ *
+ * \param instances The instances, which are copied before this returns
+ * \param num_instances How many instances there are
+ */
+NOVA_API void set_entity_instances(mc_entity_instance* instances, int num_instances);
+
+/*!
+ * \brief Adds a texture that particles can be drawn with
+ *
+ * Particles are put into one draw per atlas, so there can only be a few atlases
+ *
+ * \param filter_name The name of the filter the particles pass, which picks the shader they're drawn with
+ * \param texture_name The name of the texture
+ * \return The atlas's index for mc_particle_emitter::atlas, or -1 if there are too many atlases
+ */
+NOVA_API int add_particle_atlas(const char* filter_name, const char* texture_name);
+
+/*!
+ * \brief Spawns bursts of particles
+ *
+ * Nova simulates the particles on the GPU until they die, so Minecraft doesn't have to keep track of them. The
+ * emitters are copied before this returns
+ *
+ * \param emitters The emitters to spawn
+ * \param num_emitters How many emitters there are
+ */
+NOVA_API void spawn_particles(mc_particle_emitter* emitters, int num_emitters);
+
+/*!
+ * \brief Kills every particle, like when the player leaves a world
+ */
+NOVA_API void clear_particles();
+
+/*!
+ * \brief Saves what's in the window at the end of the next frame as a PNG
+ *
+ * The pixels are copied into a pixel buffer on the GPU, read back a frame or two later, and encoded on a worker
+ * thread, so this never stalls the render thread
+ *
+ * \param path Where to write the PNG
+ * \return A ticket to check with is_readback_complete
+ */
+NOVA_API long long save_screenshot(const char* path);
+
+/*!
+ * \brief Saves one of the shaderpack's attachments, like colortex0 or depthtex0, as a PNG
+ *
+ * The attachment is read in the next frame, right after the last pass that draws into it. Depth attachments are saved
+ * as grayscale. Attachments that no pass keeps, because nothing reads them, can't be saved
+ *
+ * \param attachment_name The name of the attachment
+ * \param path Where to write the PNG
+ * \return A ticket to check with is_readback_complete
+ */
+NOVA_API long long save_framebuffer_attachment(const char* attachment_name, const char* path);
+
+/*!
+ * \brief Checks if the image for the given ticket has been written, or has failed to be
+ *
+ * \param ticket The ticket from save_screenshot or save_framebuffer_attachment
+ */
+NOVA_API bool is_readback_complete(long long ticket);
+
+/*!
+ * \brief Saves the profiler's trace of the last few hundred frames, in Chrome's trace event format
+ *
+ * chrome://tracing and Perfetto can open the trace. It shows every profiled scope on every thread and on the GPU, so
+ * it's the place to look for why one frame was slow
+ *
+ * \param path Where to write the trace
+ */
+NOVA_API void save_profiler_trace(const char* path);
+
+/*!
+ * \brief Has RenderDoc capture the next frame, with the counters from the frame before it saved as the capture's
+ * comments
+ *
+ * Only does anything if RenderDoc was loaded when the window was made, either because Minecraft was started from
+ * RenderDoc or because the renderdocPath setting points at it. Captures go in the renderdocCaptureDirectory
+ */
+NOVA_API void trigger_renderdoc_capture();
+
 /*!
  * \brief Updates the Nova Renderer and renders the current frame
  */
@@ -155,6 +406,24 @@ NOVA_API void set_float_setting(const char * setting_name, float setting_value);
  */
 NOVA_API void set_player_camera_transform(double x, double y, double z, float yaw, float pitch);
 
+/*!
+ * \brief Sets where the sun and moon are, which decides where the shadows fall
+ *
+ * \param celestial_angle The world's celestial angle, from World#getCelestialAngle. 0 is noon and 0.5 is midnight
+ */
+NOVA_API void set_celestial_angle(float celestial_angle);
+
+/*!
+ * \brief Sets the time and weather that the sky, clouds, and rain or snow are drawn from
+ *
+ * Nova makes the cloud and weather geometry itself, so this is all Minecraft needs to send each frame for them
+ *
+ * \param world_time The world's total time in ticks, from World#getTotalWorldTime, plus the partial tick
+ * \param rain_strength How hard it's raining, from World#getRainStrength
+ * \param is_snowing 1 if the rain falls as snow where the player is, 0 otherwise
+ */
+NOVA_API void set_sky_state(double world_time, float rain_strength, int is_snowing);
+
 NOVA_API void set_mouse_grabbed(int grabbed);
 
 /**
@@ -171,6 +440,66 @@ NOVA_API struct key_press_event  get_next_key_press_event();
 
 NOVA_API struct key_char_event  get_next_key_char_event();
 
+/*!
+ * \brief Copies every waiting input event into the buffer in one call
+ *
+ * The buffer starts with an input_event_batch_header that says how many of each kind of event there are, followed
+ * by the events themselves. Events that don't fit are left for the next call, and for the get_next_*_event
+ * functions. The buffer should be a direct buffer in native byte order
+ *
+ * \param buffer Where to put the events
+ * \param buffer_size How big the buffer is, in bytes
+ * \return How many bytes were written
+ */
+NOVA_API int get_input_events(unsigned char* buffer, int buffer_size);
+
+/*!
+ * \brief Copies the counters from the newest finished frame: draws, triangles, state changes, texture binds, bytes
+ * uploaded, and what each pass drew
+ *
+ * The per-pass pipeline statistics are only filled in when the pipelineStatistics setting is on and the driver has
+ * GL_ARB_pipeline_statistics_query. Those take a few frames to come back from the GPU, so with them on the snapshot
+ * is a few frames old. Waits for the render thread
+ *
+ * \param statistics Where to put the snapshot
+ */
+NOVA_API void get_frame_statistics(mc_frame_statistics* statistics);
+
+/*!
+ * \brief Tells how much GPU memory Nova's buffers and textures are using, so the game can shrink the render distance
+ * before the driver starts paging. Waits for the render thread
+ *
+ * \param usage Where to put the usage
+ */
+NOVA_API void get_gpu_memory_usage(mc_gpu_memory_usage* usage);
+
+/*!
+ * \brief Gets chunks whose geometry was evicted to stay under the vramBudgetMegabytes setting and that have come back
+ * into view, but that Nova doesn't have a copy of
+ *
+ * Each chunk is only given out once. It isn't drawn until it's sent again with add_chunk_render_object. Waits for the
+ * render thread
+ *
+ * \param chunks An array to fill with the chunks
+ * \param max_chunks How many chunks fit in the array
+ * \return How many chunks were put in the array
+ */
+NOVA_API int get_chunks_to_rebuild(mc_chunk_position* chunks, int max_chunks);
+
+/*!
+ * \brief Scores chunks by how soon Nova expects the camera to see them, from where it's been heading. Lower scores
+ * are needed sooner
+ *
+ * Minecraft can build its chunks in this order, so the ones in front of a player flying with elytra are built
+ * before the ones behind them. Nova uses the same scores to order its own conversions and uploads. Doesn't wait for
+ * the render thread
+ *
+ * \param chunks The lowest corner of each chunk, in blocks. The IDs aren't used
+ * \param priorities An array with room for a score for each chunk
+ * \param num_chunks How many chunks there are
+ */
+NOVA_API void get_chunk_build_priorities(const mc_chunk_position* chunks, float* priorities, int num_chunks);
+
 NOVA_API int get_num_loaded_shaders();
 
 NOVA_API char* get_shaders_and_filters();
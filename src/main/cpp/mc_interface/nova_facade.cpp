@@ -9,19 +9,32 @@
  * The function in this file simply set data. Data is copied out of Minecraft objects. This might be a bit slow, but I
  * don't want to save a pointer that gets re-allocated by the JVM. I don't trust it enough (although maybe I should?)
  *
+ * Anything that touches GL, or state that the renderer reads while rendering, becomes a command for the render thread.
+ * Those commands run after the function returns, so they capture their own copies of Minecraft's data. Chunks already
+ * go through the mesh store's own queue, and the window has to be polled and resized from Minecraft's thread, so
+ * those are called directly
+ *
  * \author David
  */
 
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
 #include "glad/glad.h"
 #include "nova.h"
 #include "../utils/export.h"
 #include "../render/nova_renderer.h"
 #include "../render/objects/textures/texture_manager.h"
+#include "../render/objects/frame_stats.h"
+#include "../render/objects/gpu_memory.h"
 #include "../data_loading/settings.h"
 #include "../input/InputHandler.h"
 #include "../render/windowing/glfw_gl_window.h"
 #include "../utils/utils.h"
 #include "../utils/profiler.h"
+#include "api_capture.h"
 
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "../utils/stb_image_write.h"
@@ -32,39 +45,125 @@ using namespace nova;
 #define TEXTURE_MANAGER NOVA_RENDERER->get_texture_manager()
 #define INPUT_HANDLER NOVA_RENDERER->get_input_handler()
 #define MESH_STORE NOVA_RENDERER->get_mesh_store()
+#define RENDER_THREAD (*NOVA_RENDERER->get_render_thread())
+#define BLOCK_LIGHTS NOVA_RENDERER->get_block_lights()
 
 #define PROFILER nova::profiler
+#define CAPTURE nova::api_capture::get()
 // runs in thread 5
 
 NOVA_API void initialize() {
-    PROFILER::start("initialize");
+    PROFILER::start(NOVA_PROFILER_SCOPE("initialize"));
     nova_renderer::init();
-    PROFILER::end("initialize");
+    NOVA_RENDERER->start_render_thread();
+    api_capture::start_from_environment();
+    PROFILER::end(NOVA_PROFILER_SCOPE("initialize"));
+}
+
+NOVA_API long long add_texture(mc_atlas_texture & texture) {
+    PROFILER::start(NOVA_PROFILER_SCOPE("add_texture"));
+    // The texture manager logs textures with the wrong number of components, so don't copy anything for them
+    bool has_valid_components = texture.num_components >= 1 && texture.num_components <= 4;
+    auto num_bytes = has_valid_components ? static_cast<size_t>(texture.width) * texture.height * texture.num_components : 0;
+    if(CAPTURE) {
+        CAPTURE->record_add_texture(texture, num_bytes);
+    }
+    auto pixels = std::make_shared<std::vector<unsigned char>>(texture.texture_data, texture.texture_data + num_bytes);
+    auto name = std::string(texture.name);
+    auto ticket = TEXTURE_MANAGER.reserve_upload_ticket();
+
+    RENDER_THREAD.push([texture, pixels, name, ticket]() mutable {
+        texture.texture_data = pixels->data();
+        texture.name = name.c_str();
+        TEXTURE_MANAGER.add_texture(texture, ticket);
+    });
+    PROFILER::end(NOVA_PROFILER_SCOPE("add_texture"));
+
+    return static_cast<long long>(ticket);
 }
 
-NOVA_API void add_texture(mc_atlas_texture & texture) {
-    PROFILER::start("add_texture");
-    TEXTURE_MANAGER.add_texture(texture);
-    PROFILER::end("add_texture");
+NOVA_API bool is_texture_upload_complete(long long ticket) {
+    return TEXTURE_MANAGER.is_texture_upload_complete(static_cast<uint64_t>(ticket));
 }
 
 NOVA_API void reset_texture_manager() {
-    PROFILER::start("reset_texture_manager");
-    TEXTURE_MANAGER.reset();
-    PROFILER::end("reset_texture_mamager");
+    PROFILER::start(NOVA_PROFILER_SCOPE("reset_texture_manager"));
+    if(CAPTURE) {
+        CAPTURE->record_reset_texture_manager();
+    }
+    RENDER_THREAD.push([]() { TEXTURE_MANAGER.reset(); });
+    PROFILER::end(NOVA_PROFILER_SCOPE("reset_texture_manager"));
 }
 
 NOVA_API void send_lightmap_texture(int* data, int count, int width, int height) {
-    auto size = glm::ivec2{width, height};
-    TEXTURE_MANAGER.update_texture("lightmap", data, size, GL_BGRA, GL_UNSIGNED_BYTE);
-    auto& lightmap = TEXTURE_MANAGER.get_texture("lightmap");
-    lightmap.bind(4);
+    if(CAPTURE) {
+        CAPTURE->record_send_lightmap_texture(data, count, width, height);
+    }
+    auto pixels = std::make_shared<std::vector<int>>(data, data + count);
+    RENDER_THREAD.push([pixels, width, height]() {
+        auto size = glm::ivec2{width, height};
+        TEXTURE_MANAGER.update_texture("lightmap", pixels->data(), size, GL_BGRA, GL_UNSIGNED_BYTE);
+        auto& lightmap = TEXTURE_MANAGER.get_texture("lightmap");
+        lightmap.bind(4);
+    });
 }
 
 NOVA_API void add_texture_location(mc_texture_atlas_location location) {
-    PROFILER::start("add_texture_location");
-    TEXTURE_MANAGER.add_texture_location(location);
-    PROFILER::end("add_texture_location");
+    PROFILER::start(NOVA_PROFILER_SCOPE("add_texture_location"));
+    if(CAPTURE) {
+        CAPTURE->record_add_texture_location(location);
+    }
+    auto name = std::string(location.name);
+    RENDER_THREAD.push([location, name]() mutable {
+        location.name = name.c_str();
+        TEXTURE_MANAGER.add_texture_location(location);
+    });
+    PROFILER::end(NOVA_PROFILER_SCOPE("add_texture_location"));
+}
+
+NOVA_API long long add_texture_atlas(const char* atlas_name, mc_atlas_sprite* sprites, int num_sprites,
+                                     mc_texture_atlas_location* locations) {
+    PROFILER::start(NOVA_PROFILER_SCOPE("add_texture_atlas"));
+    std::vector<nova::atlas_sprite> sprite_list;
+    std::vector<std::string> sprite_names;
+    sprite_list.reserve(static_cast<size_t>(std::max(num_sprites, 0)));
+    for(int i = 0; i < num_sprites; i++) {
+        sprite_list.push_back({glm::ivec2(sprites[i].width, sprites[i].height), sprites[i].texture_data});
+        sprite_names.emplace_back(sprites[i].name);
+    }
+
+    auto atlas = std::make_shared<nova::stitched_atlas>(TEXTURE_MANAGER.stitch_sprites(sprite_list));
+    if(!atlas->is_valid()) {
+        LOG(ERROR) << "Could not stitch the " << num_sprites << " sprites of " << atlas_name
+                   << " into a texture the GPU allows";
+        PROFILER::end(NOVA_PROFILER_SCOPE("add_texture_atlas"));
+        return 0;
+    }
+
+    for(int i = 0; i < num_sprites; i++) {
+        const glm::vec2 min_uv = atlas->get_min_uv(static_cast<size_t>(i));
+        const glm::vec2 max_uv = atlas->get_max_uv(static_cast<size_t>(i));
+        locations[i] = {sprites[i].name, min_uv.x, max_uv.x, min_uv.y, max_uv.y};
+    }
+
+    // A capture replays the stitched atlas like any other texture, so replays don't depend on the packer
+    if(CAPTURE) {
+        mc_atlas_texture texture = {atlas->size.x, atlas->size.y, atlas->num_components, atlas->pixels.data(),
+                                    atlas_name};
+        CAPTURE->record_add_texture(texture, atlas->pixels.size());
+        for(int i = 0; i < num_sprites; i++) {
+            CAPTURE->record_add_texture_location(locations[i]);
+        }
+    }
+
+    auto name = std::string(atlas_name);
+    auto ticket = TEXTURE_MANAGER.reserve_upload_ticket();
+    RENDER_THREAD.push([atlas, name, sprite_names, ticket]() {
+        TEXTURE_MANAGER.add_stitched_atlas(name, *atlas, sprite_names, ticket);
+    });
+    PROFILER::end(NOVA_PROFILER_SCOPE("add_texture_atlas"));
+
+    return static_cast<long long>(ticket);
 }
 
 NOVA_API int get_max_texture_size() {
@@ -72,31 +171,252 @@ NOVA_API int get_max_texture_size() {
 }
 
 NOVA_API void add_chunk_geometry_for_filter(const char* filter_name, mc_chunk_render_object * chunk) {
-    PROFILER::start("add_chunk_geometry_for_filter");
-    MESH_STORE.add_chunk_render_object(std::string(filter_name), *chunk);
-    PROFILER::end("add_chunk_geometry_for_filter");
+    PROFILER::start(NOVA_PROFILER_SCOPE("add_chunk_geometry_for_filter"));
+    if(CAPTURE) {
+        CAPTURE->record_add_chunk_geometry(filter_name, 0, *chunk, false);
+    }
+    MESH_STORE.add_chunk_render_object(MESH_STORE.get_shader_id(filter_name), *chunk);
+    PROFILER::end(NOVA_PROFILER_SCOPE("add_chunk_geometry_for_filter"));
 }
 
 NOVA_API void remove_chunk_geometry_for_filter(const char* filter_name, mc_chunk_render_object * chunk) {
-    PROFILER::start("remove_chunk_geometry_for_filter");
-    MESH_STORE.remove_chunk_render_object(std::string(filter_name), *chunk);
-    PROFILER::end("remove_chunk_geometry_for_filter");
+    PROFILER::start(NOVA_PROFILER_SCOPE("remove_chunk_geometry_for_filter"));
+    if(CAPTURE) {
+        CAPTURE->record_remove_chunk_geometry(filter_name, 0, *chunk);
+    }
+    MESH_STORE.remove_chunk_render_object(MESH_STORE.get_shader_id(filter_name), *chunk);
+    BLOCK_LIGHTS.remove_section(glm::vec3(chunk->x, chunk->y, chunk->z), chunk->id);
+    PROFILER::end(NOVA_PROFILER_SCOPE("remove_chunk_geometry_for_filter"));
+}
+
+NOVA_API long long add_chunk_geometry_for_filter_direct(const char* filter_name, mc_chunk_render_object * chunk) {
+    PROFILER::start(NOVA_PROFILER_SCOPE("add_chunk_geometry_for_filter_direct"));
+    if(CAPTURE) {
+        CAPTURE->record_add_chunk_geometry(filter_name, 0, *chunk, true);
+    }
+    auto ticket = MESH_STORE.add_chunk_render_object_direct(MESH_STORE.get_shader_id(filter_name), *chunk);
+    PROFILER::end(NOVA_PROFILER_SCOPE("add_chunk_geometry_for_filter_direct"));
+    return static_cast<long long>(ticket);
+}
+
+NOVA_API bool is_chunk_geometry_upload_complete(long long ticket) {
+    return MESH_STORE.is_direct_upload_complete(static_cast<uint64_t>(ticket));
+}
+
+NOVA_API int get_shader_id(const char* shader_name) {
+    if(CAPTURE) {
+        CAPTURE->record_get_shader_id(shader_name);
+    }
+    return static_cast<int>(MESH_STORE.get_shader_id(shader_name));
+}
+
+NOVA_API void add_chunk_geometry_for_shader(int shader_id, mc_chunk_render_object * chunk) {
+    PROFILER::start(NOVA_PROFILER_SCOPE("add_chunk_geometry_for_shader"));
+    if(!MESH_STORE.is_chunk_valid(shader_id, chunk->format, chunk->id, false)) {
+        PROFILER::end(NOVA_PROFILER_SCOPE("add_chunk_geometry_for_shader"));
+        return;
+    }
+    if(CAPTURE) {
+        CAPTURE->record_add_chunk_geometry(nullptr, shader_id, *chunk, false);
+    }
+    MESH_STORE.add_chunk_render_object(static_cast<nova::shader_id>(shader_id), *chunk);
+    PROFILER::end(NOVA_PROFILER_SCOPE("add_chunk_geometry_for_shader"));
+}
+
+NOVA_API void remove_chunk_geometry_for_shader(int shader_id, mc_chunk_render_object * chunk) {
+    PROFILER::start(NOVA_PROFILER_SCOPE("remove_chunk_geometry_for_shader"));
+    if(!MESH_STORE.is_chunk_valid(shader_id, chunk->format, chunk->id, true)) {
+        PROFILER::end(NOVA_PROFILER_SCOPE("remove_chunk_geometry_for_shader"));
+        return;
+    }
+    if(CAPTURE) {
+        CAPTURE->record_remove_chunk_geometry(nullptr, shader_id, *chunk);
+    }
+    MESH_STORE.remove_chunk_render_object(static_cast<nova::shader_id>(shader_id), *chunk);
+    BLOCK_LIGHTS.remove_section(glm::vec3(chunk->x, chunk->y, chunk->z), chunk->id);
+    PROFILER::end(NOVA_PROFILER_SCOPE("remove_chunk_geometry_for_shader"));
+}
+
+NOVA_API long long add_chunk_geometry_for_shader_direct(int shader_id, mc_chunk_render_object * chunk) {
+    PROFILER::start(NOVA_PROFILER_SCOPE("add_chunk_geometry_for_shader_direct"));
+    if(!MESH_STORE.is_chunk_valid(shader_id, chunk->format, chunk->id, false)) {
+        // Nothing holds on to the chunk's data, so the ticket is complete straight away
+        PROFILER::end(NOVA_PROFILER_SCOPE("add_chunk_geometry_for_shader_direct"));
+        return 0;
+    }
+    if(CAPTURE) {
+        CAPTURE->record_add_chunk_geometry(nullptr, shader_id, *chunk, true);
+    }
+    auto ticket = MESH_STORE.add_chunk_render_object_direct(static_cast<nova::shader_id>(shader_id), *chunk);
+    PROFILER::end(NOVA_PROFILER_SCOPE("add_chunk_geometry_for_shader_direct"));
+    return static_cast<long long>(ticket);
+}
+
+NOVA_API void add_chunk_geometry_batch(mc_chunk_batch_entry* entries, int num_entries, int* payload, int payload_size) {
+    PROFILER::start(NOVA_PROFILER_SCOPE("add_chunk_geometry_batch"));
+    if(num_entries <= 0 || payload_size < 0) {
+        PROFILER::end(NOVA_PROFILER_SCOPE("add_chunk_geometry_batch"));
+        return;
+    }
+
+    // add_chunk_render_objects checks each entry, and only tells us about the ones it applies
+    MESH_STORE.add_chunk_render_objects(entries, static_cast<size_t>(num_entries), payload, static_cast<size_t>(payload_size),
+                                        [payload](const mc_chunk_batch_entry& entry) {
+        const bool is_removal = entry.vertex_buffer_size == 0;
+        // Captures replay the batch as one call per chunk, which does the same thing
+        mc_chunk_render_object chunk = {entry.format, entry.x, entry.y, entry.z, entry.id,
+                                        payload + entry.vertex_offset, payload + entry.index_offset,
+                                        entry.vertex_buffer_size, entry.index_buffer_size};
+        if(is_removal) {
+            if(CAPTURE) {
+                CAPTURE->record_remove_chunk_geometry(nullptr, entry.shader_id, chunk);
+            }
+            BLOCK_LIGHTS.remove_section(glm::vec3(entry.x, entry.y, entry.z), entry.id);
+        } else if(CAPTURE) {
+            CAPTURE->record_add_chunk_geometry(nullptr, entry.shader_id, chunk, false);
+        }
+    });
+    PROFILER::end(NOVA_PROFILER_SCOPE("add_chunk_geometry_batch"));
+}
+
+NOVA_API void set_mesher_block_type(mc_mesher_block_type* block_type) {
+    if(CAPTURE) {
+        CAPTURE->record_set_mesher_block_type(*block_type);
+    }
+    MESH_STORE.set_mesher_block_type(*block_type);
+}
+
+NOVA_API void set_block_light_value(int block_id, int light_value) {
+    BLOCK_LIGHTS.set_block_light_value(block_id, light_value);
+}
+
+NOVA_API void add_chunk_section_blocks(mc_chunk_section_blocks* section) {
+    PROFILER::start(NOVA_PROFILER_SCOPE("add_chunk_section_blocks"));
+    if(CAPTURE) {
+        CAPTURE->record_add_chunk_section_blocks(*section);
+    }
+    MESH_STORE.add_chunk_section_blocks(*section);
+    BLOCK_LIGHTS.add_section(*section);
+    PROFILER::end(NOVA_PROFILER_SCOPE("add_chunk_section_blocks"));
+}
+
+NOVA_API void set_chunk_mesh_cache_world(const char* world_name, int dimension) {
+    // Opening the cache reads through its file, so it's done here instead of holding up the render thread
+    MESH_STORE.set_mesh_cache_world(world_name == nullptr ? "" : world_name, dimension);
+}
+
+NOVA_API int add_entity_model(const char* filter_name, mc_entity_model* model) {
+    PROFILER::start(NOVA_PROFILER_SCOPE("add_entity_model"));
+    // The ID is handed out here so Minecraft can use it right away, even though the model's uploaded later
+    const auto model_id = NOVA_RENDERER->get_entity_renderer().reserve_model_id();
+
+    if(model->format < 0 || model->format >= static_cast<int>(format::all_values().size())) {
+        LOG(ERROR) << "Entity model " << model_id << " has unknown format " << model->format;
+        PROFILER::end(NOVA_PROFILER_SCOPE("add_entity_model"));
+        return static_cast<int>(model_id);
+    }
+
+    auto definition = std::make_shared<mesh_definition>();
+    definition->vertex_format = format::all_values()[model->format];
+    definition->vertex_data.assign(model->vertex_data, model->vertex_data + model->vertex_buffer_size);
+    definition->indices.assign(model->indices, model->indices + model->index_buffer_size);
+    definition->position = glm::vec3(0);
+    auto shader = MESH_STORE.get_shader_id(filter_name);
+    auto texture_name = std::string(model->texture_name == nullptr ? "" : model->texture_name);
+
+    RENDER_THREAD.push([model_id, shader, definition, texture_name]() {
+        auto texture = TEXTURE_MANAGER.get_texture_handle(texture_name);
+        NOVA_RENDERER->get_entity_renderer().add_model(model_id, shader, *definition, texture);
+    });
+    PROFILER::end(NOVA_PROFILER_SCOPE("add_entity_model"));
+    return static_cast<int>(model_id);
+}
+
+NOVA_API void remove_entity_model(int model_id) {
+    RENDER_THREAD.push([model_id]() { NOVA_RENDERER->get_entity_renderer().remove_model(static_cast<uint32_t>(model_id)); });
+}
+
+NOVA_API void set_entity_instances(mc_entity_instance* instances, int num_instances) {
+    PROFILER::start(NOVA_PROFILER_SCOPE("set_entity_instances"));
+    auto copied_instances = std::make_shared<std::vector<mc_entity_instance>>(instances, instances + num_instances);
+    RENDER_THREAD.push([copied_instances]() {
+        NOVA_RENDERER->get_entity_renderer().set_instances(std::move(*copied_instances));
+    });
+    PROFILER::end(NOVA_PROFILER_SCOPE("set_entity_instances"));
+}
+
+NOVA_API int add_particle_atlas(const char* filter_name, const char* texture_name) {
+    auto shader = MESH_STORE.get_shader_id(filter_name);
+    auto name = std::string(texture_name == nullptr ? "" : texture_name);
+    return RENDER_THREAD.run_and_wait([shader, name]() {
+        return NOVA_RENDERER->get_particle_system().add_atlas(shader, TEXTURE_MANAGER.get_texture_handle(name));
+    });
+}
+
+NOVA_API void spawn_particles(mc_particle_emitter* emitters, int num_emitters) {
+    PROFILER::start(NOVA_PROFILER_SCOPE("spawn_particles"));
+    auto copied_emitters = std::make_shared<std::vector<mc_particle_emitter>>(emitters, emitters + num_emitters);
+    RENDER_THREAD.push([copied_emitters]() { NOVA_RENDERER->get_particle_system().spawn(*copied_emitters); });
+    PROFILER::end(NOVA_PROFILER_SCOPE("spawn_particles"));
+}
+
+NOVA_API void clear_particles() {
+    RENDER_THREAD.push([]() { NOVA_RENDERER->get_particle_system().clear(); });
+}
+
+NOVA_API long long save_screenshot(const char* path) {
+    auto ticket = NOVA_RENDERER->get_readback_queue().reserve_ticket();
+    auto screenshot_path = std::string(path);
+    RENDER_THREAD.push([ticket, screenshot_path]() { NOVA_RENDERER->save_screenshot(ticket, screenshot_path); });
+    return static_cast<long long>(ticket);
+}
+
+NOVA_API long long save_framebuffer_attachment(const char* attachment_name, const char* path) {
+    auto ticket = NOVA_RENDERER->get_readback_queue().reserve_ticket();
+    auto name = std::string(attachment_name);
+    auto attachment_path = std::string(path);
+    RENDER_THREAD.push([ticket, name, attachment_path]() { NOVA_RENDERER->save_attachment(ticket, name, attachment_path); });
+    return static_cast<long long>(ticket);
+}
+
+NOVA_API bool is_readback_complete(long long ticket) {
+    return NOVA_RENDERER->get_readback_queue().is_complete(static_cast<uint64_t>(ticket));
+}
+
+NOVA_API void save_profiler_trace(const char* path) {
+    auto trace_path = std::string(path);
+    RENDER_THREAD.push([trace_path]() { PROFILER::save_trace(trace_path); });
+}
+
+NOVA_API void trigger_renderdoc_capture() {
+    RENDER_THREAD.push([]() { NOVA_RENDERER->get_game_window().get_renderdoc().trigger("Asked for through trigger_renderdoc_capture"); });
 }
 
 NOVA_API void execute_frame() {
-    PROFILER::start("execute_frame");
-    NOVA_RENDERER->render_frame();
-    PROFILER::end("execute_frame");
+    PROFILER::start(NOVA_PROFILER_SCOPE("execute_frame"));
+    if(CAPTURE) {
+        CAPTURE->record_execute_frame();
+    }
+    // GLFW only lets us poll from the thread that made the window. Polling before the frame is queued means the
+    // frame sees this poll's resize
+    auto& window = NOVA_RENDERER->get_game_window();
+    if(window.poll_events()) {
+        auto new_size = glm::ivec2(window.get_size());
+        RENDER_THREAD.push([new_size]() { NOVA_RENDERER->get_game_window().set_framebuffer_size(new_size); });
+    }
+
+    RENDER_THREAD.push_frame([]() { NOVA_RENDERER->render_frame(); });
+    PROFILER::end(NOVA_PROFILER_SCOPE("execute_frame"));
 }
 
 NOVA_API void set_fullscreen(int fullscreen) {
-    PROFILER::start("set_fullscreen");
+    PROFILER::start(NOVA_PROFILER_SCOPE("set_fullscreen"));
     bool temp_bool = false;
     if(fullscreen == 1) {
         temp_bool = true;
     }
     NOVA_RENDERER->get_game_window().set_fullscreen(temp_bool);
-    PROFILER::end("set_fullscreen");
+    PROFILER::end(NOVA_PROFILER_SCOPE("set_fullscreen"));
 }
 
 NOVA_API bool should_close() {
@@ -108,9 +428,26 @@ NOVA_API bool display_is_active() {
 }
 
 NOVA_API void add_gui_geometry(mc_gui_geometry * gui_geometry) {
-    PROFILER::start("add_gui_geometry");
-    NOVA_RENDERER->get_mesh_store().add_gui_buffers(gui_geometry);
-    PROFILER::end("add_gui_geometry");
+    PROFILER::start(NOVA_PROFILER_SCOPE("add_gui_geometry"));
+    if(CAPTURE) {
+        CAPTURE->record_add_gui_geometry(*gui_geometry);
+    }
+    auto indices = std::make_shared<std::vector<int>>(gui_geometry->index_buffer, gui_geometry->index_buffer + gui_geometry->index_buffer_size);
+    auto vertices = std::make_shared<std::vector<float>>(gui_geometry->vertex_buffer, gui_geometry->vertex_buffer + gui_geometry->vertex_buffer_size);
+    auto texture_name = std::string(gui_geometry->texture_name);
+    auto atlas_name = std::string(gui_geometry->atlas_name);
+
+    RENDER_THREAD.push([indices, vertices, texture_name, atlas_name]() {
+        mc_gui_geometry geometry = {};
+        geometry.texture_name = texture_name.c_str();
+        geometry.atlas_name = atlas_name.c_str();
+        geometry.index_buffer = indices->data();
+        geometry.index_buffer_size = static_cast<int>(indices->size());
+        geometry.vertex_buffer = vertices->data();
+        geometry.vertex_buffer_size = static_cast<int>(vertices->size());
+        MESH_STORE.add_gui_buffers(&geometry);
+    });
+    PROFILER::end(NOVA_PROFILER_SCOPE("add_gui_geometry"));
 }
 
 NOVA_API struct window_size get_window_size()
@@ -120,34 +457,73 @@ NOVA_API struct window_size get_window_size()
 }
 
 NOVA_API void clear_gui_buffers() {
-    PROFILER::start("clear_gui_buffers");
-    NOVA_RENDERER->get_mesh_store().remove_gui_render_objects();
-    PROFILER::end("clear_gui_buffers");
+    PROFILER::start(NOVA_PROFILER_SCOPE("clear_gui_buffers"));
+    if(CAPTURE) {
+        CAPTURE->record_clear_gui_buffers();
+    }
+    RENDER_THREAD.push([]() { MESH_STORE.remove_gui_render_objects(); });
+    PROFILER::end(NOVA_PROFILER_SCOPE("clear_gui_buffers"));
 }
 
 NOVA_API void set_string_setting(const char * setting_name, const char * setting_value) {
-    PROFILER::start("set_string_setting");
-    settings& settings = NOVA_RENDERER->get_render_settings();
-    settings.get_options()["settings"][setting_name] = setting_value;
-    settings.update_config_changed();
-    PROFILER::end("set_string_setting");
+    PROFILER::start(NOVA_PROFILER_SCOPE("set_string_setting"));
+    if(CAPTURE) {
+        CAPTURE->record_set_string_setting(setting_name, setting_value);
+    }
+    auto name = std::string(setting_name);
+    auto value = std::string(setting_value);
+    RENDER_THREAD.push([name, value]() {
+        settings& settings = NOVA_RENDERER->get_render_settings();
+        settings.get_options()["settings"][name] = value;
+        settings.update_config_changed();
+    });
+    PROFILER::end(NOVA_PROFILER_SCOPE("set_string_setting"));
 }
 
 NOVA_API void set_float_setting(const char * setting_name, float setting_value) {
-    PROFILER::start("set_float_setting");
-    settings& settings = NOVA_RENDERER->get_render_settings();
-    settings.get_options()["settings"][setting_name] = setting_value;
-    settings.update_config_changed();
-    PROFILER::end("set_float_setting");
+    PROFILER::start(NOVA_PROFILER_SCOPE("set_float_setting"));
+    if(CAPTURE) {
+        CAPTURE->record_set_float_setting(setting_name, setting_value);
+    }
+    auto name = std::string(setting_name);
+    RENDER_THREAD.push([name, setting_value]() {
+        settings& settings = NOVA_RENDERER->get_render_settings();
+        settings.get_options()["settings"][name] = setting_value;
+        settings.update_config_changed();
+    });
+    PROFILER::end(NOVA_PROFILER_SCOPE("set_float_setting"));
 }
 
 NOVA_API void set_player_camera_transform(double x, double y, double z, float yaw, float pitch) {
-    PROFILER::start("set_player_camera_transform");
-    auto& player_camera = NOVA_RENDERER->get_player_camera();
+    PROFILER::start(NOVA_PROFILER_SCOPE("set_player_camera_transform"));
+    if(CAPTURE) {
+        CAPTURE->record_set_player_camera_transform(x, y, z, yaw, pitch);
+    }
+    RENDER_THREAD.push([x, y, z, yaw, pitch]() {
+        auto& player_camera = NOVA_RENDERER->get_player_camera();
 
-    player_camera.position = {x, y, z};
-    player_camera.rotation = {yaw, pitch};
-    PROFILER::end("set_player_camera_transform");
+        player_camera.position = {x, y, z};
+        player_camera.rotation = {yaw, pitch};
+    });
+    PROFILER::end(NOVA_PROFILER_SCOPE("set_player_camera_transform"));
+}
+
+NOVA_API void set_celestial_angle(float celestial_angle) {
+    if(CAPTURE) {
+        CAPTURE->record_set_celestial_angle(celestial_angle);
+    }
+    RENDER_THREAD.push([celestial_angle]() {
+        NOVA_RENDERER->set_celestial_angle(celestial_angle);
+    });
+}
+
+NOVA_API void set_sky_state(double world_time, float rain_strength, int is_snowing) {
+    if(CAPTURE) {
+        CAPTURE->record_set_sky_state(world_time, rain_strength, is_snowing);
+    }
+    RENDER_THREAD.push([world_time, rain_strength, is_snowing]() {
+        NOVA_RENDERER->get_sky().set_state(world_time, rain_strength, is_snowing != 0);
+    });
 }
 
 NOVA_API struct mouse_button_event  get_next_mouse_button_event() {
@@ -172,16 +548,92 @@ NOVA_API struct key_char_event get_next_key_char_event()
 	return  INPUT_HANDLER.dequeue_key_char_event();
 }
 
+NOVA_API int get_input_events(unsigned char* buffer, int buffer_size) {
+    if(buffer == nullptr || buffer_size <= 0) {
+        return 0;
+    }
+    return static_cast<int>(INPUT_HANDLER.dequeue_all_events(buffer, static_cast<size_t>(buffer_size)));
+}
+
 NOVA_API void set_mouse_grabbed(int grabbed) {
     NOVA_RENDERER->get_game_window().set_mouse_grabbed(grabbed != 0);
 }
 
+NOVA_API void get_frame_statistics(mc_frame_statistics* statistics) {
+    const auto stats = RENDER_THREAD.run_and_wait([]() { return frame_stats::get_last_frame(); });
+
+    *statistics = {};
+    statistics->frame = static_cast<long long>(stats.frame);
+    statistics->draw_calls = static_cast<long long>(stats.draw_calls);
+    statistics->draw_commands = static_cast<long long>(stats.draw_commands);
+    statistics->triangles = static_cast<long long>(stats.triangles);
+    statistics->state_changes = static_cast<long long>(stats.state_changes);
+    statistics->state_changes_saved = static_cast<long long>(stats.state_changes_saved);
+    statistics->texture_binds = static_cast<long long>(stats.texture_binds);
+    statistics->bytes_uploaded = static_cast<long long>(stats.bytes_uploaded);
+    statistics->performance_warnings = static_cast<long long>(stats.performance_warnings);
+    statistics->has_pipeline_statistics = stats.has_pipeline_statistics ? 1 : 0;
+
+    const auto num_passes = std::min(stats.passes.size(), static_cast<size_t>(MAX_MC_PASS_STATISTICS));
+    statistics->num_passes = static_cast<int>(num_passes);
+    for(size_t i = 0; i < num_passes; i++) {
+        const auto& pass = stats.passes[i];
+        auto& mc_pass = statistics->passes[i];
+        std::strncpy(mc_pass.name, pass.name.c_str(), sizeof(mc_pass.name) - 1);
+        mc_pass.draw_calls = static_cast<long long>(pass.draw_calls);
+        mc_pass.draw_commands = static_cast<long long>(pass.draw_commands);
+        mc_pass.triangles = static_cast<long long>(pass.triangles);
+        mc_pass.primitives_submitted = static_cast<long long>(pass.primitives_submitted);
+        mc_pass.vertex_shader_invocations = static_cast<long long>(pass.vertex_shader_invocations);
+        mc_pass.clipping_output_primitives = static_cast<long long>(pass.clipping_output_primitives);
+        mc_pass.fragment_shader_invocations = static_cast<long long>(pass.fragment_shader_invocations);
+    }
+}
+
+NOVA_API void get_gpu_memory_usage(mc_gpu_memory_usage* usage) {
+    RENDER_THREAD.run_and_wait([usage]() {
+        const auto& gpu_usage = gpu_memory::get_usage();
+        auto& meshes = NOVA_RENDERER->get_mesh_store();
+
+        usage->chunk_geometry = static_cast<long long>(meshes.get_chunk_arena().get_bytes_in_use());
+        usage->chunk_arena_reserved = static_cast<long long>(gpu_usage.get(gpu_memory_category::chunk_arena));
+        usage->meshes = static_cast<long long>(gpu_usage.get(gpu_memory_category::meshes));
+        usage->textures = static_cast<long long>(gpu_usage.get(gpu_memory_category::textures));
+        usage->framebuffers = static_cast<long long>(gpu_usage.get(gpu_memory_category::framebuffers));
+        usage->buffers = static_cast<long long>(gpu_usage.get(gpu_memory_category::buffers));
+        usage->total = static_cast<long long>(meshes.get_memory_usage());
+        usage->budget = static_cast<long long>(meshes.get_memory_budget());
+    });
+}
+
+NOVA_API int get_chunks_to_rebuild(mc_chunk_position* chunks, int max_chunks) {
+    if(max_chunks <= 0) {
+        return 0;
+    }
+
+    return RENDER_THREAD.run_and_wait([chunks, max_chunks]() {
+        return static_cast<int>(NOVA_RENDERER->get_mesh_store().take_chunks_to_rebuild(chunks, static_cast<size_t>(max_chunks)));
+    });
+}
+
+NOVA_API void get_chunk_build_priorities(const mc_chunk_position* chunks, float* priorities, int num_chunks) {
+    const auto& prioritizer = MESH_STORE.get_upload_prioritizer();
+    for(int i = 0; i < num_chunks; i++) {
+        priorities[i] = prioritizer.get_priority(glm::vec3(chunks[i].x, chunks[i].y, chunks[i].z));
+    }
+}
+
 NOVA_API int get_num_loaded_shaders() {
-    return static_cast<int>(NOVA_RENDERER->get_shaders()->get_loaded_shaders().size());
+    return RENDER_THREAD.run_and_wait([]() {
+        return static_cast<int>(NOVA_RENDERER->get_shaders()->get_loaded_shaders().size());
+    });
 }
 
-NOVA_API char* get_shaders_and_filters() {
-    PROFILER::start("set_shaders_and_filters");
+/*!
+ * \brief Writes the name and filter of every loaded shader, one per line. Must be called on the render thread,
+ * since shaders can be swapped out between frames
+ */
+static char* write_shaders_and_filters() {
     auto& shaders = NOVA_RENDERER->get_shaders()->get_loaded_shaders();
 
     int num_chars = 0;
@@ -208,6 +660,12 @@ NOVA_API char* get_shaders_and_filters() {
     }
 
     filters[num_chars - 1] = '\0';
-    PROFILER::end("set_shaders_and_filters");
+    return filters;
+}
+
+NOVA_API char* get_shaders_and_filters() {
+    PROFILER::start(NOVA_PROFILER_SCOPE("set_shaders_and_filters"));
+    char* filters = RENDER_THREAD.run_and_wait(write_shaders_and_filters);
+    PROFILER::end(NOVA_PROFILER_SCOPE("set_shaders_and_filters"));
     return filters;
 }
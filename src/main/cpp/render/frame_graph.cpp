@@ -0,0 +1,575 @@
+/*!
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_set>
+#include <easylogging++.h>
+#include "frame_graph.h"
+#include "objects/frame_stats.h"
+#include "objects/gl_state.h"
+#include "objects/gpu_memory.h"
+#include "windowing/glfw_gl_window.h"
+
+namespace nova {
+    bool is_depth_format(GLenum internal_format) {
+        switch(internal_format) {
+            case GL_DEPTH_COMPONENT:
+            case GL_DEPTH_COMPONENT16:
+            case GL_DEPTH_COMPONENT24:
+            case GL_DEPTH_COMPONENT32:
+            case GL_DEPTH_COMPONENT32F:
+            case GL_DEPTH24_STENCIL8:
+            case GL_DEPTH32F_STENCIL8:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    bool has_stencil(GLenum internal_format) {
+        return internal_format == GL_DEPTH24_STENCIL8 || internal_format == GL_DEPTH32F_STENCIL8;
+    }
+
+    glm::uvec2 get_scaled_size(const glm::uvec2& size, float scale) {
+        return glm::max(glm::uvec2(glm::ceil(glm::vec2(size) * scale)), glm::uvec2(1));
+    }
+
+    frame_graph::~frame_graph() {
+        if(glfwGetCurrentContext() != nullptr) {
+            destroy_gl_objects();
+        }
+    }
+
+    void frame_graph::add_attachment(const attachment_description& attachment) {
+        attachment_indices[attachment.name] = attachments.size();
+        attachments.push_back(attachment);
+    }
+
+    void frame_graph::add_pass(const render_pass_description& pass) {
+        passes.push_back(pass);
+    }
+
+    int frame_graph::find_attachment(const std::string& name) const {
+        auto itr = attachment_indices.find(name);
+        if(itr == attachment_indices.end()) {
+            return -1;
+        }
+
+        return static_cast<int>(itr->second);
+    }
+
+    void frame_graph::compile() {
+        destroy_gl_objects();
+        build_plan();
+        create_gl_objects();
+
+        LOG(INFO) << "Compiled frame graph: " << live_passes.size() << " of " << passes.size() << " passes are used, "
+                  << textures.size() << " textures back " << attachments.size() << " attachments";
+    }
+
+    void frame_graph::build_plan() {
+        live_passes.clear();
+        textures.clear();
+        attachment_textures.assign(attachments.size(), -1);
+
+        // Walk back from the passes that write to the backbuffer. A pass is only needed if something after it reads
+        // one of its outputs
+        std::vector<bool> is_live(passes.size(), false);
+        std::vector<std::vector<bool>> output_is_used(passes.size());
+        std::unordered_set<int> needed_attachments;
+
+        for(size_t i = passes.size(); i-- > 0;) {
+            const auto& pass = passes[i];
+            auto& used_outputs = output_is_used[i];
+            used_outputs.assign(pass.color_writes.size(), false);
+
+            bool live = pass.writes_to_backbuffer;
+            if(!pass.writes_to_backbuffer) {
+                for(size_t output = 0; output < pass.color_writes.size(); output++) {
+                    if(needed_attachments.count(find_attachment(pass.color_writes[output])) > 0) {
+                        used_outputs[output] = true;
+                        live = true;
+                    }
+                }
+
+                if(!pass.depth_write.empty() && needed_attachments.count(find_attachment(pass.depth_write)) > 0) {
+                    live = true;
+                }
+            }
+
+            if(!live) {
+                LOG(DEBUG) << "Culling pass " << pass.name << " since nothing reads its output";
+                continue;
+            }
+            is_live[i] = true;
+
+            // If this pass overwrites its targets completely, whatever was in them before doesn't matter
+            if(pass.covers_whole_target && !pass.writes_to_backbuffer) {
+                for(size_t output = 0; output < pass.color_writes.size(); output++) {
+                    if(used_outputs[output]) {
+                        needed_attachments.erase(find_attachment(pass.color_writes[output]));
+                    }
+                }
+                if(!pass.depth_write.empty()) {
+                    needed_attachments.erase(find_attachment(pass.depth_write));
+                }
+            }
+
+            for(const auto& read : pass.reads) {
+                int attachment_idx = find_attachment(read);
+                if(attachment_idx < 0) {
+                    LOG(WARNING) << "Pass " << pass.name << " reads from attachment " << read << ", which doesn't exist";
+                    continue;
+                }
+                needed_attachments.insert(attachment_idx);
+            }
+        }
+
+        // Find out when each attachment is first and last used by a live pass
+        const size_t unused = std::numeric_limits<size_t>::max();
+        std::vector<size_t> first_use(attachments.size(), unused);
+        std::vector<size_t> last_use(attachments.size(), 0);
+        std::vector<bool> first_use_overwrites(attachments.size(), false);
+
+        auto use_attachment = [&](int attachment_idx, size_t pass_idx, bool overwrites) {
+            if(attachment_idx < 0) {
+                return;
+            }
+            if(first_use[attachment_idx] == unused) {
+                first_use[attachment_idx] = pass_idx;
+                first_use_overwrites[attachment_idx] = overwrites;
+            }
+            last_use[attachment_idx] = pass_idx;
+        };
+
+        for(size_t i = 0; i < passes.size(); i++) {
+            if(!is_live[i]) {
+                continue;
+            }
+
+            const auto& pass = passes[i];
+            for(const auto& read : pass.reads) {
+                use_attachment(find_attachment(read), i, false);
+            }
+
+            if(pass.writes_to_backbuffer) {
+                continue;
+            }
+
+            for(size_t output = 0; output < pass.color_writes.size(); output++) {
+                if(output_is_used[i][output]) {
+                    use_attachment(find_attachment(pass.color_writes[output]), i, pass.covers_whole_target);
+                }
+            }
+
+            if(!pass.depth_write.empty()) {
+                int depth_idx = find_attachment(pass.depth_write);
+                if(depth_idx < 0) {
+                    LOG(WARNING) << "Pass " << pass.name << " writes to depth attachment " << pass.depth_write << ", which doesn't exist";
+                }
+                use_attachment(depth_idx, i, pass.covers_whole_target);
+            }
+
+            // A mask keeps its attachment alive until this pass, but only if something drew it first
+            const int mask_idx = find_attachment(pass.stencil_mask);
+            if(mask_idx >= 0 && first_use[mask_idx] != unused) {
+                last_use[mask_idx] = i;
+            }
+        }
+
+        // Give each attachment a texture, reusing textures from attachments that are already done with them
+        std::vector<size_t> attachments_by_first_use;
+        for(size_t i = 0; i < attachments.size(); i++) {
+            if(first_use[i] != unused) {
+                attachments_by_first_use.push_back(i);
+            }
+        }
+        std::stable_sort(attachments_by_first_use.begin(), attachments_by_first_use.end(), [&](size_t a, size_t b) {
+            return first_use[a] < first_use[b];
+        });
+
+        for(size_t attachment_idx : attachments_by_first_use) {
+            const auto& attachment = attachments[attachment_idx];
+
+            // Persistent attachments never share, so nothing else can draw over what they're keeping
+            int texture_idx = -1;
+            for(size_t i = 0; i < textures.size() && !attachment.persistent; i++) {
+                const auto& tex = textures[i];
+                if(tex.width == attachment.width && tex.height == attachment.height &&
+                   tex.internal_format == attachment.internal_format &&
+                   tex.scales_with_resolution == attachment.scales_with_resolution && tex.last_use < first_use[attachment_idx]) {
+                    texture_idx = static_cast<int>(i);
+                    break;
+                }
+            }
+
+            if(texture_idx < 0) {
+                textures.push_back({attachment.width, attachment.height, attachment.internal_format, 0, attachment.scales_with_resolution});
+                texture_idx = static_cast<int>(textures.size() - 1);
+            }
+
+            textures[texture_idx].last_use = attachment.persistent ? unused : last_use[attachment_idx];
+            attachment_textures[attachment_idx] = texture_idx;
+        }
+
+        // Now that we know where everything lives, work out what each pass has to do before it draws
+        std::vector<bool> written_with_image_stores(attachments.size(), false);
+
+        for(size_t i = 0; i < passes.size(); i++) {
+            if(!is_live[i]) {
+                continue;
+            }
+
+            const auto& pass = passes[i];
+            compiled_pass compiled = {};
+            compiled.description_idx = i;
+
+            for(const auto& read : pass.reads) {
+                int attachment_idx = find_attachment(read);
+                if(attachment_idx < 0) {
+                    continue;
+                }
+                if(written_with_image_stores[attachment_idx]) {
+                    // The final pass might blit the attachment instead of sampling it
+                    compiled.barrier_bits |= GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT;
+                }
+            }
+
+            if(!pass.writes_to_backbuffer) {
+                compiled.color_textures.assign(pass.color_writes.size(), -1);
+                for(size_t output = 0; output < pass.color_writes.size(); output++) {
+                    if(output_is_used[i][output]) {
+                        int attachment_idx = find_attachment(pass.color_writes[output]);
+                        compiled.color_textures[output] = attachment_textures[attachment_idx];
+                        written_with_image_stores[attachment_idx] = pass.writes_with_image_stores;
+                    }
+                }
+
+                int depth_idx = find_attachment(pass.depth_write);
+                if(depth_idx >= 0) {
+                    compiled.depth_texture = attachment_textures[depth_idx];
+                }
+
+                const int mask_idx = find_attachment(pass.stencil_mask);
+                if(mask_idx >= 0 && !pass.writes_with_image_stores && first_use[mask_idx] <= i &&
+                   has_stencil(attachments[mask_idx].internal_format)) {
+                    if(compiled.depth_texture < 0) {
+                        compiled.depth_texture = attachment_textures[mask_idx];
+                        compiled.is_stencil_only = true;
+                    }
+
+                    if(compiled.depth_texture == attachment_textures[mask_idx]) {
+                        compiled.is_stencil_masked = true;
+                    } else {
+                        LOG(WARNING) << "Pass " << pass.name << " can't be masked by " << pass.stencil_mask
+                                     << " since it draws into a different depth attachment";
+                    }
+                }
+            }
+
+            for(size_t attachment_idx = 0; attachment_idx < attachments.size(); attachment_idx++) {
+                if(first_use[attachment_idx] == i && !first_use_overwrites[attachment_idx] && !attachments[attachment_idx].persistent) {
+                    compiled.attachments_to_clear.push_back(attachment_idx);
+
+                    auto& reads = pass.reads;
+                    if(std::find(reads.begin(), reads.end(), attachments[attachment_idx].name) != reads.end()) {
+                        LOG(WARNING) << "Pass " << pass.name << " reads from " << attachments[attachment_idx].name
+                                     << " before anything writes to it";
+                    }
+                }
+            }
+
+            live_passes.push_back(std::move(compiled));
+        }
+    }
+
+    void frame_graph::create_gl_objects() {
+        for(auto& tex : textures) {
+            glCreateTextures(GL_TEXTURE_2D, 1, &tex.texture);
+            glTextureStorage2D(tex.texture, 1, tex.internal_format, tex.width, tex.height);
+            gpu_memory::track_texture(tex.texture, gpu_memory_category::framebuffers,
+                                      gpu_memory::get_texture_size(tex.internal_format, tex.width, tex.height));
+
+            GLint filter = is_depth_format(tex.internal_format) ? GL_NEAREST : GL_LINEAR;
+            glTextureParameteri(tex.texture, GL_TEXTURE_MIN_FILTER, filter);
+            glTextureParameteri(tex.texture, GL_TEXTURE_MAG_FILTER, filter);
+            glTextureParameteri(tex.texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTextureParameteri(tex.texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        }
+
+        for(auto& compiled : live_passes) {
+            const auto& pass = passes[compiled.description_idx];
+            if(pass.writes_to_backbuffer) {
+                continue;
+            }
+
+            glCreateFramebuffers(1, &compiled.framebuffer);
+            glObjectLabel(GL_FRAMEBUFFER, compiled.framebuffer, static_cast<GLsizei>(pass.name.size()), pass.name.c_str());
+
+            std::vector<GLenum> drawbuffers(compiled.color_textures.size(), GL_NONE);
+            for(size_t output = 0; output < compiled.color_textures.size(); output++) {
+                int texture_idx = compiled.color_textures[output];
+                if(texture_idx >= 0) {
+                    glNamedFramebufferTexture(compiled.framebuffer, GL_COLOR_ATTACHMENT0 + output, textures[texture_idx].texture, 0);
+                    drawbuffers[output] = GL_COLOR_ATTACHMENT0 + static_cast<GLenum>(output);
+                }
+            }
+
+            if(drawbuffers.empty()) {
+                glNamedFramebufferDrawBuffer(compiled.framebuffer, GL_NONE);
+            } else {
+                glNamedFramebufferDrawBuffers(compiled.framebuffer, static_cast<GLsizei>(drawbuffers.size()), drawbuffers.data());
+            }
+
+            if(compiled.depth_texture >= 0) {
+                const auto& depth = textures[compiled.depth_texture];
+                const GLenum attachment_point = has_stencil(depth.internal_format) ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+                glNamedFramebufferTexture(compiled.framebuffer, attachment_point, depth.texture, 0);
+            }
+
+            auto status = glCheckNamedFramebufferStatus(compiled.framebuffer, GL_DRAW_FRAMEBUFFER);
+            if(status != GL_FRAMEBUFFER_COMPLETE) {
+                LOG(ERROR) << "Framebuffer for pass " << pass.name << " is incomplete: status " << status;
+            }
+        }
+    }
+
+    void frame_graph::destroy_gl_objects() {
+        for(auto& compiled : live_passes) {
+            if(compiled.framebuffer != 0) {
+                glDeleteFramebuffers(1, &compiled.framebuffer);
+                compiled.framebuffer = 0;
+            }
+        }
+
+        for(auto& tex : textures) {
+            if(tex.texture != 0) {
+                gl_state::delete_textures(1, &tex.texture);
+                tex.texture = 0;
+            }
+        }
+
+        if(blit_framebuffer != 0) {
+            glDeleteFramebuffers(1, &blit_framebuffer);
+            blit_framebuffer = 0;
+        }
+    }
+
+    void frame_graph::reset() {
+        destroy_gl_objects();
+
+        attachments.clear();
+        attachment_indices.clear();
+        passes.clear();
+        live_passes.clear();
+        textures.clear();
+        attachment_textures.clear();
+    }
+
+    void frame_graph::execute() {
+        for(const auto& compiled : live_passes) {
+            const auto& pass = passes[compiled.description_idx];
+
+            if(compiled.barrier_bits != 0) {
+                glMemoryBarrier(compiled.barrier_bits);
+            }
+
+            if(pass.writes_to_backbuffer) {
+                glBindFramebuffer(GL_FRAMEBUFFER, 0);
+                glViewport(0, 0, backbuffer_width, backbuffer_height);
+                if(!pass.covers_whole_target) {
+                    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                }
+
+            } else {
+                glBindFramebuffer(GL_FRAMEBUFFER, compiled.framebuffer);
+
+                // All of a pass's attachments have to be the same size, so any of them tells us the viewport
+                int sized_texture = compiled.depth_texture;
+                for(int texture_idx : compiled.color_textures) {
+                    if(texture_idx >= 0) {
+                        sized_texture = texture_idx;
+                        break;
+                    }
+                }
+                if(sized_texture >= 0) {
+                    const glm::uvec2 drawn_size = get_drawn_size(textures[sized_texture]);
+                    glViewport(0, 0, drawn_size.x, drawn_size.y);
+                }
+            }
+
+            for(size_t attachment_idx : compiled.attachments_to_clear) {
+                clear_attachment(attachment_idx);
+            }
+
+            for(const auto& read : pass.reads) {
+                int attachment_idx = find_attachment(read);
+                if(attachment_idx >= 0 && attachment_textures[attachment_idx] >= 0) {
+                    gl_state::bind_texture_unit(attachments[attachment_idx].texture_unit, textures[attachment_textures[attachment_idx]].texture);
+                }
+            }
+
+            if(pass.writes_with_image_stores) {
+                // Outputs that nothing reads get no texture, so their stores are dropped
+                for(size_t output = 0; output < compiled.color_textures.size(); output++) {
+                    const int texture_idx = compiled.color_textures[output];
+                    if(texture_idx >= 0) {
+                        glBindImageTexture(static_cast<GLuint>(output), textures[texture_idx].texture, 0, GL_FALSE, 0,
+                                           GL_WRITE_ONLY, textures[texture_idx].internal_format);
+                    } else {
+                        glBindImageTexture(static_cast<GLuint>(output), 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+                    }
+                }
+            }
+
+            // The mask is never written, so passes that sample it while it's attached don't make a feedback loop
+            if(compiled.is_stencil_masked) {
+                gl_state::set_enabled(GL_STENCIL_TEST, true);
+                glStencilFunc(GL_EQUAL, 0, 0xFF);
+                glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+            }
+            if(compiled.is_stencil_only) {
+                gl_state::set_enabled(GL_DEPTH_TEST, false);
+            }
+
+            frame_stats::begin_pass(pass.name);
+            if(pass.execute) {
+                pass.execute();
+            }
+            frame_stats::end_pass();
+
+            if(compiled.is_stencil_masked) {
+                gl_state::set_enabled(GL_STENCIL_TEST, false);
+            }
+            if(compiled.is_stencil_only) {
+                gl_state::set_enabled(GL_DEPTH_TEST, true);
+            }
+
+            if(pass_finished_callback) {
+                pass_finished_callback(pass.name);
+            }
+        }
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, backbuffer_width, backbuffer_height);
+    }
+
+    void frame_graph::clear_attachment(size_t attachment_idx) {
+        const auto& attachment = attachments[attachment_idx];
+        GLuint texture = textures[attachment_textures[attachment_idx]].texture;
+
+        if(has_stencil(attachment.internal_format)) {
+            // Stencils are always cleared to 0, so nothing starts out masked
+            struct {
+                GLfloat depth;
+                GLuint stencil;
+            } clear_value = {attachment.clear_value.x, 0};
+            glClearTexImage(texture, 0, GL_DEPTH_STENCIL, GL_FLOAT_32_UNSIGNED_INT_24_8_REV, &clear_value);
+
+        } else if(is_depth_format(attachment.internal_format)) {
+            glClearTexImage(texture, 0, GL_DEPTH_COMPONENT, GL_FLOAT, &attachment.clear_value.x);
+        } else {
+            glClearTexImage(texture, 0, GL_RGBA, GL_FLOAT, &attachment.clear_value[0]);
+        }
+    }
+
+    void frame_graph::set_backbuffer_size(unsigned int width, unsigned int height) {
+        backbuffer_width = width;
+        backbuffer_height = height;
+    }
+
+    void frame_graph::set_resolution_scale(float scale) {
+        resolution_scale = std::min(std::max(scale, 0.0f), 1.0f);
+    }
+
+    glm::uvec2 frame_graph::get_drawn_size(const physical_texture& texture) const {
+        const glm::uvec2 size(texture.width, texture.height);
+        return texture.scales_with_resolution ? get_scaled_size(size, resolution_scale) : size;
+    }
+
+    void frame_graph::blit_to_backbuffer(const std::string& attachment_name) {
+        int attachment_idx = find_attachment(attachment_name);
+        if(attachment_idx < 0 || attachment_textures[attachment_idx] < 0) {
+            LOG(WARNING) << "Can't copy attachment " << attachment_name << " to the backbuffer since it isn't used";
+            return;
+        }
+
+        const auto& tex = textures[attachment_textures[attachment_idx]];
+        const glm::uvec2 drawn_size = get_drawn_size(tex);
+
+        if(blit_framebuffer == 0) {
+            glCreateFramebuffers(1, &blit_framebuffer);
+        }
+        glNamedFramebufferTexture(blit_framebuffer, GL_COLOR_ATTACHMENT0, tex.texture, 0);
+        glNamedFramebufferReadBuffer(blit_framebuffer, GL_COLOR_ATTACHMENT0);
+
+        glBlitNamedFramebuffer(blit_framebuffer, 0,
+                               0, 0, drawn_size.x, drawn_size.y,
+                               0, 0, backbuffer_width, backbuffer_height,
+                               GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    }
+
+    GLuint frame_graph::get_texture(const std::string& attachment_name) const {
+        int texture_idx = get_physical_texture_idx(attachment_name);
+        if(texture_idx < 0) {
+            return 0;
+        }
+
+        return textures[texture_idx].texture;
+    }
+
+    glm::uvec2 frame_graph::get_texture_size(const std::string& attachment_name) const {
+        int texture_idx = get_physical_texture_idx(attachment_name);
+        if(texture_idx < 0) {
+            return glm::uvec2(0);
+        }
+
+        return glm::uvec2(textures[texture_idx].width, textures[texture_idx].height);
+    }
+
+    std::string frame_graph::get_last_writer(const std::string& attachment_name) const {
+        for(auto itr = live_passes.rbegin(); itr != live_passes.rend(); ++itr) {
+            const auto& pass = passes[itr->description_idx];
+            if(pass.writes_to_backbuffer) {
+                continue;
+            }
+
+            // Outputs that nothing reads are written to GL_NONE, so they don't count
+            for(size_t i = 0; i < pass.color_writes.size(); i++) {
+                if(pass.color_writes[i] == attachment_name && i < itr->color_textures.size() && itr->color_textures[i] >= 0) {
+                    return pass.name;
+                }
+            }
+            if(pass.depth_write == attachment_name && itr->depth_texture >= 0) {
+                return pass.name;
+            }
+        }
+
+        return "";
+    }
+
+    void frame_graph::set_pass_finished_callback(std::function<void(const std::string&)> callback) {
+        pass_finished_callback = std::move(callback);
+    }
+
+    int frame_graph::get_physical_texture_idx(const std::string& attachment_name) const {
+        int attachment_idx = find_attachment(attachment_name);
+        if(attachment_idx < 0 || attachment_idx >= attachment_textures.size()) {
+            return -1;
+        }
+
+        return attachment_textures[attachment_idx];
+    }
+
+    const std::vector<compiled_pass>& frame_graph::get_compiled_passes() const {
+        return live_passes;
+    }
+
+    size_t frame_graph::get_num_physical_textures() const {
+        return textures.size();
+    }
+}
@@ -0,0 +1,323 @@
+/*!
+ * \brief Orders the render passes of a frame and manages the attachments they read and write
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_FRAME_GRAPH_H
+#define RENDERER_FRAME_GRAPH_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace nova {
+    /*!
+     * \brief Describes a texture that render passes can write to and read from
+     */
+    struct attachment_description {
+        std::string name;
+        unsigned int width = 0;
+        unsigned int height = 0;
+        GLenum internal_format = GL_RGBA8;
+
+        /*!
+         * \brief The texture unit that this attachment is bound to for passes that read it
+         */
+        GLuint texture_unit = 0;
+
+        /*!
+         * \brief The value this attachment is cleared to. Depth attachments only use the x component
+         */
+        glm::vec4 clear_value = glm::vec4(0);
+
+        /*!
+         * \brief If true, this attachment keeps what's drawn into it from one frame to the next
+         *
+         * Persistent attachments get a texture of their own, and the graph never clears them. The passes that write
+         * them have to clear whatever part they're about to redraw
+         */
+        bool persistent = false;
+
+        /*!
+         * \brief If true, passes only draw into the part of this attachment given by the graph's resolution scale
+         *
+         * The texture is always made at the full size, so the scale can change from one frame to the next without
+         * making new textures
+         */
+        bool scales_with_resolution = false;
+    };
+
+    /*!
+     * \brief Describes a single render pass: what it reads, what it writes, and how to draw it
+     */
+    struct render_pass_description {
+        std::string name;
+
+        /*!
+         * \brief The attachments that this pass samples from
+         */
+        std::vector<std::string> reads;
+
+        /*!
+         * \brief The attachments that this pass renders to. The attachment at index i receives fragment output i
+         */
+        std::vector<std::string> color_writes;
+
+        /*!
+         * \brief The depth attachment this pass renders to, or an empty string for no depth attachment
+         */
+        std::string depth_write;
+
+        /*!
+         * \brief A depth-stencil attachment whose stencil masks this pass, or an empty string for no mask. Pixels
+         * where the stencil isn't 0 aren't drawn
+         *
+         * If it isn't also the pass's depth_write, it's attached with depth testing and writing turned off. Masking a
+         * pass with an attachment doesn't count as using it, so a pass is only masked if it or an earlier pass draws
+         * into the attachment. Passes that write with image stores and passes that write to the backbuffer aren't
+         * masked
+         */
+        std::string stencil_mask;
+
+        /*!
+         * \brief If true, this pass renders to the default framebuffer and its color_writes and depth_write are ignored
+         */
+        bool writes_to_backbuffer = false;
+
+        /*!
+         * \brief True if this pass overwrites every pixel of its targets, like a fullscreen pass does
+         *
+         * Passes that cover their whole target don't need their attachments cleared first, and anything written to
+         * those attachments before them is thrown away
+         */
+        bool covers_whole_target = false;
+
+        /*!
+         * \brief True if this pass writes its attachments with image stores rather than through the framebuffer
+         *
+         * OpenGL orders framebuffer writes before later texture fetches on its own, but image stores need a
+         * glMemoryBarrier before anything can sample the result. The texture behind color write i is bound to image
+         * unit i before the pass executes
+         */
+        bool writes_with_image_stores = false;
+
+        /*!
+         * \brief Issues the draws for this pass. The pass's framebuffer and input textures are bound when this is called
+         */
+        std::function<void()> execute;
+    };
+
+    /*!
+     * \brief A render pass that survived culling, along with everything needed to run it
+     */
+    struct compiled_pass {
+        size_t description_idx;
+
+        /*!
+         * \brief The physical texture behind each of the pass's color writes, or -1 if no later pass reads that output
+         */
+        std::vector<int> color_textures;
+        int depth_texture = -1;
+
+        /*!
+         * \brief True if the depth texture's stencil masks this pass
+         */
+        bool is_stencil_masked = false;
+
+        /*!
+         * \brief True if the depth texture is only attached for its stencil, and the pass doesn't test or write depth
+         */
+        bool is_stencil_only = false;
+
+        /*!
+         * \brief The attachments, by index into the graph's attachments, that need to be cleared before this pass
+         */
+        std::vector<size_t> attachments_to_clear;
+
+        /*!
+         * \brief The glMemoryBarrier bits needed before this pass, or 0 if it doesn't need a barrier
+         */
+        GLbitfield barrier_bits = 0;
+
+        GLuint framebuffer = 0;
+    };
+
+    /*!
+     * \brief Figures out which passes and attachments a frame actually needs
+     *
+     * Each pass declares the attachments it reads and writes. When the graph is compiled, it walks back from the
+     * passes that write to the backbuffer and culls every pass whose output is never used. Outputs that nothing reads
+     * get GL_NONE as their draw buffer rather than a texture.
+     *
+     * Attachments only live from the first pass that uses them to the last one. Attachments with the same size and
+     * format whose lifetimes don't overlap share a texture, so a shaderpack that writes to eight color attachments over
+     * the course of a frame doesn't necessarily need eight textures.
+     *
+     * Attachments are only cleared by the first pass that uses them, and only if that pass doesn't overwrite the whole
+     * attachment anyway. Persistent attachments are never shared or cleared
+     */
+    class frame_graph {
+    public:
+        frame_graph() = default;
+
+        frame_graph(const frame_graph&) = delete;
+        frame_graph& operator=(const frame_graph&) = delete;
+
+        ~frame_graph();
+
+        void add_attachment(const attachment_description& attachment);
+
+        /*!
+         * \brief Adds a pass to the end of the frame. Passes run in the order they're added
+         */
+        void add_pass(const render_pass_description& pass);
+
+        /*!
+         * \brief Culls unused passes, assigns attachments to textures, then creates those textures and the framebuffers
+         * for each pass
+         */
+        void compile();
+
+        /*!
+         * \brief Works out which passes run, which textures they use, and what they need to clear, without touching
+         * OpenGL
+         *
+         * compile() calls this before making any GL objects
+         */
+        void build_plan();
+
+        /*!
+         * \brief Runs all the passes that survived culling
+         */
+        void execute();
+
+        /*!
+         * \brief Destroys all the textures and framebuffers and forgets all the attachments and passes
+         */
+        void reset();
+
+        /*!
+         * \brief Sets the viewport that passes rendering to the backbuffer use
+         */
+        void set_backbuffer_size(unsigned int width, unsigned int height);
+
+        /*!
+         * \brief Sets how much of the attachments that scale with resolution is drawn to, from 0 to 1
+         */
+        void set_resolution_scale(float scale);
+
+        /*!
+         * \brief Copies the part of the given attachment that was drawn to the backbuffer, stretching it to fill the
+         * whole thing
+         *
+         * Meant to be called from a pass that writes to the backbuffer
+         */
+        void blit_to_backbuffer(const std::string& attachment_name);
+
+        /*!
+         * \brief The full size of the texture behind the given attachment, or (0, 0) if the attachment isn't used
+         */
+        glm::uvec2 get_texture_size(const std::string& attachment_name) const;
+
+        /*!
+         * \brief Gets the texture that currently backs the given attachment
+         *
+         * \return The texture's GL name, or 0 if the attachment isn't used by any live pass
+         */
+        GLuint get_texture(const std::string& attachment_name) const;
+
+        const std::vector<compiled_pass>& get_compiled_passes() const;
+
+        /*!
+         * \brief The number of textures needed to hold all the live attachments, after aliasing
+         */
+        size_t get_num_physical_textures() const;
+
+        /*!
+         * \brief The physical texture index used by the given attachment, or -1 if the attachment isn't used
+         */
+        int get_physical_texture_idx(const std::string& attachment_name) const;
+
+        /*!
+         * \brief Finds the last live pass that draws into the given attachment
+         *
+         * Attachments share textures, so the attachment only holds what was drawn into it until the pass after that one
+         * starts
+         *
+         * \return The pass's name, or an empty string if no live pass keeps what it draws into the attachment
+         */
+        std::string get_last_writer(const std::string& attachment_name) const;
+
+        /*!
+         * \brief Sets a function to call after each pass has been executed, with the pass's name
+         */
+        void set_pass_finished_callback(std::function<void(const std::string&)> callback);
+
+    private:
+        struct physical_texture {
+            unsigned int width;
+            unsigned int height;
+            GLenum internal_format;
+            size_t last_use;
+            bool scales_with_resolution;
+            GLuint texture = 0;
+        };
+
+        std::vector<attachment_description> attachments;
+        std::unordered_map<std::string, size_t> attachment_indices;
+
+        std::vector<render_pass_description> passes;
+
+        std::vector<compiled_pass> live_passes;
+        std::vector<physical_texture> textures;
+
+        /*!
+         * \brief The physical texture for each attachment, or -1 if the attachment was culled
+         */
+        std::vector<int> attachment_textures;
+
+        unsigned int backbuffer_width = 0;
+        unsigned int backbuffer_height = 0;
+
+        float resolution_scale = 1;
+
+        /*!
+         * \brief The part of the texture that passes draw into
+         */
+        glm::uvec2 get_drawn_size(const physical_texture& texture) const;
+
+        GLuint blit_framebuffer = 0;
+
+        std::function<void(const std::string&)> pass_finished_callback;
+
+        void create_gl_objects();
+
+        void destroy_gl_objects();
+
+        void clear_attachment(size_t attachment_idx);
+
+        int find_attachment(const std::string& name) const;
+    };
+
+    /*!
+     * \brief Checks if the given internal format is a depth format, with or without stencil
+     */
+    bool is_depth_format(GLenum internal_format);
+
+    /*!
+     * \brief Checks if the given internal format has a stencil
+     */
+    bool has_stencil(GLenum internal_format);
+
+    /*!
+     * \brief Scales a size, rounding up so no side is ever smaller than one pixel
+     */
+    glm::uvec2 get_scaled_size(const glm::uvec2& size, float scale);
+}
+
+#endif //RENDERER_FRAME_GRAPH_H
@@ -5,8 +5,17 @@
 #include "nova_renderer.h"
 #include "../utils/utils.h"
 #include "../data_loading/loaders/loaders.h"
+#include "../data_loading/loaders/shader_loading.h"
 #include "../utils/profiler.h"
-
+#include "../utils/logging.h"
+#include "objects/gl_state.h"
+#include "objects/frame_stats.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <set>
+#include <sstream>
 #include <easylogging++.h>
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -15,16 +24,85 @@ INITIALIZE_EASYLOGGINGPP
 namespace nova {
     std::unique_ptr<nova_renderer> nova_renderer::instance;
 
-    nova_renderer::nova_renderer() {
+    /*!
+     * \brief The shader whose geometry gets a depth pre-pass
+     */
+    static const char* DEPTH_PREPASS_SHADER = "gbuffers_terrain";
+
+    /*!
+     * \brief The shaders whose geometry is solid enough to block the sun
+     */
+    static const char* SHADOW_CASTER_SHADERS[] = {"gbuffers_terrain", "gbuffers_water"};
+
+    static const char* DEPTH_PREPASS_FRAGMENT_SOURCE = R"(#version 450
+layout(binding = 0) uniform sampler2D colortex;
+
+in vec2 uv;
+
+void main() {
+    // Cutout blocks like leaves have holes where their texture is see-through, and what's behind the holes has to
+    // still pass the depth test
+    if(textureSize(colortex, 0).x > 0 && texture(colortex, uv).a < 0.5) {
+        discard;
+    }
+}
+)";
+
+    nova_renderer::nova_renderer(std::future<shaderpack_sources> startup_shaderpack) {
+        profiler::start(NOVA_PROFILER_SCOPE("startup_create_window"));
+
         game_window = std::make_unique<glfw_gl_window>();
         enable_debug();
+
+        if(GLAD_GL_ARB_parallel_shader_compile) {
+            // Let the driver compile on as many threads as it likes, so new shaderpacks compile in the background
+            glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+        }
+        profiler::end(NOVA_PROFILER_SCOPE("startup_create_window"));
+
+        if(startup_shaderpack.valid()) {
+            // Handing the shaders to the driver now means they compile while the texture manager and everything else
+            // gets made. The first config change finishes loading it
+            profiler::start(NOVA_PROFILER_SCOPE("startup_start_compiling"));
+            try {
+                auto sources = startup_shaderpack.get();
+                const nlohmann::json& startup_settings = render_settings->get_options()["settings"];
+                shaderpack_define_values = startup_settings.value("shaderpackDefines", nlohmann::json::object());
+                loading_shaderpack = std::make_shared<shaderpack>(load_shaderpack(sources, shaderpack_define_values));
+            } catch(std::exception& e) {
+                LOG(ERROR) << "Could not read the shaderpack while starting up, so it'll be read again. Reason: "
+                           << e.what();
+            }
+            profiler::end(NOVA_PROFILER_SCOPE("startup_start_compiling"));
+        }
+
         ubo_manager = std::make_unique<uniform_buffer_store>();
         textures = std::make_unique<texture_manager>();
+        lightmap_handle = textures->get_texture_handle("lightmap");
         meshes = std::make_unique<mesh_store>();
+        meshes->set_upload_context(&game_window->get_upload_context());
         inputs = std::make_unique<input_handler>();
-		render_settings->register_change_listener(ubo_manager.get());
-		render_settings->register_change_listener(game_window.get());
-        render_settings->register_change_listener(this);
+		render_settings->register_change_listener(ubo_manager.get(), {"viewWidth", "viewHeight", "scalefactor"});
+		render_settings->register_change_listener(game_window.get(), {"presentMode", "frameRateLimit"});
+        render_settings->register_change_listener(meshes.get(), {"chunkUploadBudgetBytes", "chunkUploadBudgetMicroseconds",
+                                                                 "chunkLods", "greedyMeshing", "chunkLodScreenSize",
+                                                                 "chunkLodHysteresis", "regionMerging", "regionMergeFrames",
+                                                                 "regionMergeDistance", "vramBudgetMegabytes", "chunkMeshCache",
+                                                                 "chunkMeshCacheDirectory", "chunkMeshCacheMegabytes",
+                                                                 "chunkUploadLookaheadSeconds"});
+        render_settings->register_change_listener(textures.get(), {"srgbTextures", "compressTextures", "textureCacheDirectory",
+                                                                   "textureFiltering", "textureMipLevels", "anisotropicFiltering"});
+        render_settings->register_change_listener(inputs.get(), {"coalesceMousePositions"});
+        render_settings->register_change_listener(this, {"loadedShaderpack", "hotReloadShaders", "maxFramesInFlight",
+                                                         "viewWidth", "viewHeight", "occlusionCulling",
+                                                         "shadowMapResolution", "shadowDistance", "statsOverlay",
+                                                         "pipelineStatistics", "blockLightDistance", "dynamicResolution",
+                                                         "dynamicResolutionTargetMs", "dynamicResolutionMinScale",
+                                                         "dynamicResolutionSharpness", "traceSpikeThresholdMs",
+                                                         "traceDirectory", "renderdocCaptureDirectory",
+                                                         "renderdocSpikeThresholdMs", "temporalAntialiasing",
+                                                         "shaderpackDefines", "guiLayer", "cloudDistance",
+                                                         "weatherParticles", "depthPrepass", "frontToBackChunks"});
 
         render_settings->update_config_loaded();
 		render_settings->update_config_changed();
@@ -39,14 +117,14 @@ namespace nova {
 
         glClearColor(135 / 255.0f, 206 / 255.0f, 235 / 255.0f, 1.0);
 
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LESS);
+        gl_state::set_enabled(GL_DEPTH_TEST, true);
+        gl_state::depth_func(GL_LESS);
         glClearDepth(1.0);
 
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        gl_state::set_enabled(GL_BLEND, true);
+        gl_state::blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-        glEnable(GL_CULL_FACE);
+        gl_state::set_enabled(GL_CULL_FACE, true);
         glCullFace(GL_BACK);
         glFrontFace(GL_CCW);
 
@@ -54,6 +132,21 @@ namespace nova {
     }
 
     nova_renderer::~nova_renderer() {
+        render_commands.reset();
+        for(GLsync fence : frame_fences) {
+            glDeleteSync(fence);
+        }
+        frame_fences.clear();
+        shader_reloader.reset();
+        if(depth_prepass_program) {
+            gl_state::delete_program(depth_prepass_program->gl_name);
+        }
+        passes.reset();
+        frame_stats::destroy();
+        if(fullscreen_pass_vao != 0) {
+            gl_state::delete_vertex_arrays(1, &fullscreen_pass_vao);
+        }
+
         inputs.reset();
         meshes.reset();
         textures.reset();
@@ -62,81 +155,313 @@ namespace nova {
     }
 
     void nova_renderer::render_frame() {
-        profiler::log_all_profiler_data();
+        if(!render_commands) {
+            // Input is polled right before the camera is updated, so the frame shows the newest input we have. With
+            // a render thread, execute_frame polls right before queueing the frame
+            if(game_window->poll_events()) {
+                game_window->set_framebuffer_size(glm::ivec2(game_window->get_size()));
+            }
+        }
+
+        profiler::end_frame();
+        if(inputs->take_trace_request()) {
+            save_requested_trace();
+        }
+        gl_state::end_frame();
+        frame_stats::end_frame();
+        frame_memory.reset();
+        NOVA_LOG_HOT(TRACE) << "The GL state cache dropped " << gl_state::get_calls_saved_last_frame() << " of "
+                            << gl_state::get_calls_saved_last_frame() + gl_state::get_calls_made_last_frame()
+                            << " state changes last frame";
         player_camera.recalculate_frustum();
 
-        // Make geometry for any new chunks
-        meshes->upload_new_geometry();
+        if(loading_shaderpack && loading_shaderpack->is_ready()) {
+            finish_loading_shaderpack();
+        }
 
+        if(loaded_shaderpack) {
+            reload_changed_shaders();
+        }
 
-        // upload shadow UBO things
+        textures->update_uploads();
 
-        render_shadow_pass();
+        // Make geometry for any new chunks, the ones the camera is heading towards first
+        const auto now = std::chrono::steady_clock::now().time_since_epoch();
+        meshes->get_upload_prioritizer().add_camera_sample(player_camera.position, player_camera.get_view_direction(),
+                                                           std::chrono::duration<double>(now).count());
+        meshes->upload_new_geometry(player_camera.position);
+        entities.begin_frame(player_camera.get_frustum());
+        particles.update(player_camera.get_view_matrix());
+        block_lights.update(player_camera);
 
-        // main_framebuffer->bind();
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        update_shadow_cascades();
+        update_resolution_scale();
         update_gbuffer_ubos();
 
-        render_gbuffers();
-
-        render_composite_passes();
+        // Pixels that were under an opaque menu last frame have nothing to blend with
+        copied_gui_mask = false;
+        if(use_gui_layer && gui.get_mask_version() != gui_mask_version) {
+            gui_mask_version = gui.get_mask_version();
+            temporal.invalidate();
+        }
 
-        //glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        //glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        render_final_pass();
+        // Runs the shadow, gbuffer, composite, and final passes that the shaderpack actually needs
+        resolution.begin_timing();
+        passes.execute();
+        resolution.end_timing();
 
-        // We want to draw the GUI on top of the other things, so we'll render it last
-        // Additionally, I could use the stencil buffer to not draw MC underneath the GUI. Could be a fun
-        // optimization - I'd have to watch out for when the user hides the GUI, though. I can just re-render the
-        // stencil buffer when the GUI screen changes
+        // We want to draw the GUI on top of the other things, so we'll render it last. It's only drawn again when it
+        // changes, and the world isn't drawn under its opaque parts
         render_gui();
 
+        // Attachments are saved as soon as they're drawn, so anything else left is a screenshot
+        if(!pending_saves.empty()) {
+            const auto& snapshot = render_settings->get_snapshot();
+            for(const auto& save : pending_saves) {
+                if(save.attachment_name.empty()) {
+                    readbacks.read_backbuffer(save.ticket, glm::ivec2(snapshot.view_width, snapshot.view_height), save.path);
+                } else {
+                    LOG(ERROR) << "Attachment " << save.attachment_name << " wasn't drawn this frame, so it can't be saved";
+                    readbacks.fail(save.ticket);
+                }
+            }
+            pending_saves.clear();
+        }
+
         game_window->end_frame();
+        limit_frames_in_flight();
+
+        readbacks.update();
     }
 
-    void nova_renderer::render_shadow_pass() {
-        LOG(TRACE) << "Rendering shadow pass";
+    void nova_renderer::save_requested_trace() {
+        const std::string directory = profiler::get_trace_directory();
+        make_directory(directory);
+
+        const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        profiler::save_trace(directory + "/nova-trace-" + std::to_string(seconds) + ".json");
     }
 
-    void nova_renderer::render_gbuffers() {
-        LOG(TRACE) << "Rendering gbuffer pass";
+    void nova_renderer::limit_frames_in_flight() {
+        frame_fences.push_back(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+
+        while(frame_fences.size() > max_frames_in_flight) {
+            GLsync oldest_frame = frame_fences.front();
+            frame_fences.pop_front();
 
-        // TODO: Get shaders with gbuffers prefix, draw transparents last, etc
-        auto& terrain_shader = loaded_shaderpack->get_shader("gbuffers_terrain");
-        render_shader(terrain_shader);
-        auto& water_shader = loaded_shaderpack->get_shader("gbuffers_water");
-        render_shader(water_shader);
+            GLenum status = glClientWaitSync(oldest_frame, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+            while(status == GL_TIMEOUT_EXPIRED) {
+                LOG(WARNING) << "Still waiting on the GPU to finish a frame";
+                status = glClientWaitSync(oldest_frame, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+            }
+            glDeleteSync(oldest_frame);
+        }
+    }
+
+    void nova_renderer::start_render_thread() {
+        // Minecraft asks for this from its own thread, which won't have the context anymore
+        textures->get_max_texture_size();
+
+        render_commands = std::make_unique<render_thread>(*game_window);
+    }
+
+    render_thread* nova_renderer::get_render_thread() {
+        return render_commands.get();
+    }
+
+    void nova_renderer::render_shadow_pass(gl_shader_program& shader) {
+        NOVA_LOG_HOT(TRACE) << "Rendering shadow pass";
+        profiler::start_gpu(shader.get_name());
+        shader.bind();
+
+        const auto& builtin_uniforms = shader.get_builtin_uniforms();
+        const auto num_color_outputs = static_cast<GLint>(shader.get_drawbuffers().size());
+        const GLfloat clear_depth = 1;
+        const glm::vec4 clear_color(0);
+
+        // The frame graph doesn't clear the shadow attachments, so the cascades that are still good are kept. Clears
+        // only touch the scissor box, which lets each cascade clear just its own part
+        gl_state::set_enabled(GL_SCISSOR_TEST, true);
+        for(uint32_t cascade_idx = 0; cascade_idx < NUM_SHADOW_CASCADES; cascade_idx++) {
+            const auto& cascade = shadows.get_cascade(cascade_idx);
+            if(!cascade.needs_render) {
+                continue;
+            }
+
+            const auto& viewport = cascade.viewport;
+            glViewport(viewport.x, viewport.y, viewport.z, viewport.w);
+            glScissor(viewport.x, viewport.y, viewport.z, viewport.w);
+            glClearBufferfv(GL_DEPTH, 0, &clear_depth);
+            for(GLint output = 0; output < num_color_outputs; output++) {
+                glClearBufferfv(GL_COLOR, output, &clear_color[0]);
+            }
+
+            if(builtin_uniforms.shadow_cascade >= 0) {
+                glUniform1i(builtin_uniforms.shadow_cascade, static_cast<GLint>(cascade_idx));
+            }
+
+            for(size_t caster = 0; caster < shadow_caster_ids.size(); caster++) {
+                auto& batch = shadow_caster_batches[caster];
+                batch.clear();
+                batch.set_keep_order(false);
+                draw_geometry(shader, shadow_caster_ids[caster], cascade.light_frustum, batch, nullptr);
+            }
+
+            shadows.mark_rendered(cascade_idx);
+        }
+        gl_state::set_enabled(GL_SCISSOR_TEST, false);
+
+        profiler::end(shader.get_name());
+    }
+
+    void nova_renderer::update_shadow_cascades() {
+        const glm::vec3 sun_direction = get_sun_direction();
+
+        // The moon casts the shadows once the sun has set
+        const bool sun_is_up = sun_direction.y >= 0;
+        shadows.set_light_direction(sun_is_up ? sun_direction : -sun_direction);
+        shadows.update(player_camera.get_view_matrix(), player_camera.fov, player_camera.aspect_ratio, player_camera.near_plane);
+
+        meshes->take_changed_bounds(changed_chunk_bounds);
+        for(const auto& bounds : changed_chunk_bounds) {
+            shadows.mark_changed(bounds);
+        }
+
+        shadow_cascade_uniforms cascade_uniforms = {};
+        for(uint32_t i = 0; i < NUM_SHADOW_CASCADES; i++) {
+            const auto& cascade = shadows.get_cascade(i);
+            cascade_uniforms.shadowCascadeViewProjection[i] = cascade.view_projection;
+            cascade_uniforms.shadowCascadeTexture[i] = cascade.texture_matrix;
+            cascade_uniforms.shadowCascadeSplits[i] = cascade.split_distance;
+        }
+        ubo_manager->get_shadow_cascade_uniforms().send_data(cascade_uniforms);
+
+        // Shaders that don't know about cascades get the first one, which is the sharpest
+        auto& per_frame_uniform_data = ubo_manager->get_per_frame_uniform_variables();
+        per_frame_uniform_data.shadowModelView = shadows.get_light_view();
+        per_frame_uniform_data.shadowModelViewInverse = glm::inverse(shadows.get_light_view());
+        per_frame_uniform_data.shadowProjection = shadows.get_cascade(0).projection;
+        per_frame_uniform_data.shadowProjectionInverse = glm::inverse(shadows.get_cascade(0).projection);
+
+        // sunAngle is 0 at sunrise rather than noon, like Optifine's
+        const float sun_angle = std::fmod(celestial_angle + 0.25f, 1.0f);
+        const glm::mat3 view_rotation(player_camera.get_view_matrix());
+        per_frame_uniform_data.sunAngle = sun_angle;
+        per_frame_uniform_data.shadowAngle = sun_is_up ? sun_angle : sun_angle - 0.5f;
+        per_frame_uniform_data.sunPosition = view_rotation * (sun_direction * 100.0f);
+        per_frame_uniform_data.moonPosition = -per_frame_uniform_data.sunPosition;
+        per_frame_uniform_data.shadowLightPosition = sun_is_up ? per_frame_uniform_data.sunPosition : per_frame_uniform_data.moonPosition;
+        per_frame_uniform_data.upPosition = view_rotation * glm::vec3(0, 100, 0);
+    }
+
+    glm::vec3 nova_renderer::get_sun_direction() const {
+        // Minecraft spins the sun around the x axis, then turns the whole sky so it rises in the east
+        const float angle = glm::radians(celestial_angle * 360.0f);
+        return {-std::sin(angle), std::cos(angle), 0};
     }
 
-    void nova_renderer::render_composite_passes() {
-        LOG(TRACE) << "Rendering composite passes";
+    void nova_renderer::set_celestial_angle(float angle) {
+        celestial_angle = angle - std::floor(angle);
+    }
+
+    void nova_renderer::render_sky_layer(gl_shader_program& shader, sky_layer layer) {
+        NOVA_LOG_HOT(TRACE) << "Rendering sky layer " << shader.get_name();
+        profiler::start_gpu(shader.get_name());
+        shader.bind();
+        sky.draw(layer);
+        profiler::end(shader.get_name());
+    }
+
+    void nova_renderer::render_fullscreen_pass(gl_shader_program& shader) {
+        NOVA_LOG_HOT(TRACE) << "Rendering fullscreen pass " << shader.get_name();
+        if(fullscreen_pass_vao == 0) {
+            glCreateVertexArrays(1, &fullscreen_pass_vao);
+        }
+
+        shader.bind();
+        block_lights.bind();
+        gl_state::bind_vertex_array(fullscreen_pass_vao);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        frame_stats::count_draw(1);
+    }
+
+    void nova_renderer::render_compute_pass(gl_shader_program& shader) {
+        NOVA_LOG_HOT(TRACE) << "Running compute pass " << shader.get_name();
+        const glm::uvec3& group_size = shader.get_work_group_size();
+        if(group_size.x == 0 || group_size.y == 0) {
+            return;
+        }
+
+        shader.bind();
+        block_lights.bind();
+        const glm::uvec2 size = get_scaled_size(glm::uvec2(frame_graph_view_size), resolution.get_scale());
+        glDispatchCompute((size.x + group_size.x - 1) / group_size.x, (size.y + group_size.y - 1) / group_size.y, 1);
     }
 
     void nova_renderer::render_final_pass() {
-        LOG(TRACE) << "Rendering final pass";
-        //meshes->get_fullscreen_quad->set_active();
-        //meshes->get_fullscreen_quad->draw();
+        NOVA_LOG_HOT(TRACE) << "Rendering final pass";
+        if(final_program != nullptr && !final_program->is_compute()) {
+            render_fullscreen_pass(*final_program);
+        } else {
+            // Without a final shader, colortex0 goes straight to the screen, sharpened if it was drawn smaller
+            if(!resolution.upscale(passes.get_texture("colortex0"), passes.get_texture_size("colortex0"))) {
+                passes.blit_to_backbuffer("colortex0");
+            }
+        }
     }
 
     void nova_renderer::render_gui() {
-        LOG(TRACE) << "Rendering GUI";
-        glClear(GL_DEPTH_BUFFER_BIT);
+        NOVA_LOG_HOT(TRACE) << "Rendering GUI";
+        frame_stats::begin_pass("gui");
+        const auto& config = render_settings->get_snapshot();
+
+        if(use_gui_layer && gui.is_available()) {
+            gui_layer_state state;
+            state.size = glm::uvec2(config.view_width, config.view_height);
+            state.scalefactor = config.scalefactor;
+            state.geometry_version = meshes->get_gui_batcher().get_version();
+            state.locations_version = textures->get_locations_version();
+            state.contents_version = textures->get_contents_version();
+            if(gui.update(state, [&]() { draw_gui_meshes(); })) {
+                glViewport(0, 0, config.view_width, config.view_height);
+            }
+
+            gui.composite();
+
+        } else {
+            glClear(GL_DEPTH_BUFFER_BIT);
+            draw_gui_meshes();
+        }
+        frame_stats::end_pass();
+
+        if(show_stats_overlay) {
+            overlay.draw(frame_stats::get_last_frame(), glm::ivec2(config.view_width, config.view_height), frame_memory);
+        }
+    }
+
+    void nova_renderer::draw_gui_meshes() {
+        if(gui_program == nullptr) {
+            return;
+        }
 
         // Bind all the GUI data
-        auto &gui_shader = loaded_shaderpack->get_shader("gui");
-        gui_shader.bind();
+        gui_program->bind();
 
-        upload_gui_model_matrix(gui_shader);
+        upload_gui_model_matrix(*gui_program);
 
-        // Render GUI objects
-        std::vector<render_object>& gui_geometry = meshes->get_meshes_for_shader("gui");
-        for(const auto& geom : gui_geometry) {
-            if (!geom.color_texture.empty()) {
-                auto color_texture = textures->get_texture(geom.color_texture);
-                color_texture.bind(0);
-            }
-            geom.geometry->set_active();
-            geom.geometry->draw();
+        meshes->get_gui_batcher().draw(*textures, gui_program->get_builtin_uniforms().has_sprite_locations);
+    }
+
+    void nova_renderer::copy_gui_mask() {
+        if(copied_gui_mask) {
+            return;
+        }
+        copied_gui_mask = true;
+
+        // depthtex0 was just cleared, so its stencil is 0 everywhere the mask doesn't put a 1
+        if(use_gui_layer && gui.has_opaque_pixels()) {
+            gui.copy_mask(get_scaled_size(glm::uvec2(frame_graph_view_size), resolution.get_scale()));
         }
     }
 
@@ -148,9 +473,35 @@ namespace nova {
 	std::unique_ptr<settings> nova_renderer::render_settings;
 
     void nova_renderer::init() {
+        profiler::start(NOVA_PROFILER_SCOPE("startup"));
+        const auto start_time = std::chrono::steady_clock::now();
+
+        // The window needs the settings to know how big to be, so they're read first
+        profiler::start(NOVA_PROFILER_SCOPE("startup_load_config"));
 		render_settings = std::make_unique<settings>("config/config.json");
-	
-		instance = std::make_unique<nova_renderer>();
+        profiler::end(NOVA_PROFILER_SCOPE("startup_load_config"));
+
+        // Reading the shaderpack and pasting in its includes only needs the disk, so it happens on another thread
+        // while this one makes the window and its context
+        std::future<shaderpack_sources> startup_shaderpack;
+        const nlohmann::json& startup_settings = render_settings->get_options()["settings"];
+        const auto shaderpack_setting = startup_settings.is_object() ? startup_settings.find("loadedShaderpack")
+                                                                     : startup_settings.end();
+        if(shaderpack_setting != startup_settings.end() && shaderpack_setting->is_string()) {
+            const std::string shaderpack_name = *shaderpack_setting;
+            startup_shaderpack = std::async(std::launch::async, [shaderpack_name]() {
+                profiler::start(NOVA_PROFILER_SCOPE("startup_read_shaderpack"));
+                auto sources = read_shaderpack_sources(shaderpack_name);
+                profiler::end(NOVA_PROFILER_SCOPE("startup_read_shaderpack"));
+                return sources;
+            });
+        }
+
+		instance = std::make_unique<nova_renderer>(std::move(startup_shaderpack));
+
+        profiler::end(NOVA_PROFILER_SCOPE("startup"));
+        const std::chrono::duration<double, std::milli> startup_time = std::chrono::steady_clock::now() - start_time;
+        LOG(INFO) << "Nova started up in " << startup_time.count() << "ms";
     }
 
     std::string translate_debug_source(GLenum source) {
@@ -200,6 +551,10 @@ namespace nova {
     void APIENTRY
     debug_logger(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar *message,
                  const void *user_param) {
+        if(type == GL_DEBUG_TYPE_PERFORMANCE) {
+            frame_stats::count_performance_warning();
+        }
+
         std::string source_name = translate_debug_source(source);
         std::string type_name = translate_debug_type(type);
 
@@ -214,13 +569,13 @@ namespace nova {
                 break;
 
             case GL_DEBUG_SEVERITY_LOW:
-                LOG(DEBUG) << id << " - Message from " << source_name << " of type " << type_name << ": "
-                           << message;
+                NOVA_LOG_HOT(DEBUG) << id << " - Message from " << source_name << " of type " << type_name
+                                    << ": " << message;
                 break;
 
             case GL_DEBUG_SEVERITY_NOTIFICATION:
-                LOG(TRACE) << id << " - Message from " << source_name << " of type " << type_name << ": "
-                           << message;
+                NOVA_LOG_HOT(TRACE) << id << " - Message from " << source_name << " of type " << type_name
+                                    << ": " << message;
                 break;
 
             default:
@@ -237,16 +592,79 @@ namespace nova {
 		auto& shaderpack_name = new_config["loadedShaderpack"];
         LOG(INFO) << "Shaderpack in settings: " << shaderpack_name;
 
+        hot_reload_shaders = new_config.value("hotReloadShaders", false);
+        shadows.set_shadow_distance(render_settings->get_snapshot().shadow_distance);
+        max_frames_in_flight = std::max(new_config.value("maxFramesInFlight", max_frames_in_flight), 1u);
+        occlusion.set_enabled(new_config.value("occlusionCulling", true));
+        show_stats_overlay = new_config.value("statsOverlay", false);
+        frame_stats::set_pipeline_statistics_enabled(new_config.value("pipelineStatistics", false));
+        block_lights.set_max_distance(new_config.value("blockLightDistance", 64.0f));
+        resolution.set_enabled(new_config.value("dynamicResolution", false));
+        resolution.set_target_frame_time(new_config.value("dynamicResolutionTargetMs", 1000.0f / 60.0f));
+        resolution.set_min_scale(new_config.value("dynamicResolutionMinScale", 0.5f));
+        resolution.set_sharpness(new_config.value("dynamicResolutionSharpness", 0.3f));
+        sort_chunks_front_to_back = new_config.value("frontToBackChunks", true);
+        sky.set_cloud_distance(new_config.value("cloudDistance", 192.0f));
+        sky.set_max_weather_particles(new_config.value("weatherParticles", 8192u));
+        profiler::set_trace_spike_threshold(new_config.value("traceSpikeThresholdMs", 0.0));
+        profiler::set_trace_directory(new_config.value("traceDirectory", profiler::get_trace_directory()));
+
+        auto& renderdoc = game_window->get_renderdoc();
+        renderdoc.set_capture_directory(new_config.value("renderdocCaptureDirectory", std::string("renderdoc_captures")));
+        renderdoc.set_spike_threshold(new_config.value("renderdocSpikeThresholdMs", 0.0f));
+        // Frames have to be timed on the GPU to know which ones are slow, even if the resolution isn't being scaled
+        resolution.set_always_timed(renderdoc.is_loaded() && renderdoc.get_spike_threshold() > 0);
+
+        const bool used_temporal_antialiasing = temporal.is_enabled();
+        temporal.set_enabled(new_config.value("temporalAntialiasing", false));
+        // Settings like scalefactor change how the GUI looks without Minecraft sending it again
+        use_gui_layer = new_config.value("guiLayer", true);
+        gui.invalidate();
+
+        const bool used_depth_prepass = use_depth_prepass;
+        use_depth_prepass = new_config.value("depthPrepass", false);
+        if(use_depth_prepass != used_depth_prepass && loaded_shaderpack) {
+            create_depth_prepass_program();
+        }
+
+        const auto define_values = new_config.value("shaderpackDefines", nlohmann::json::object());
+        const bool defines_changed = define_values != shaderpack_define_values;
+        shaderpack_define_values = define_values;
+
         if(!loaded_shaderpack) {
             LOG(DEBUG) << "There's currenty no shaderpack, so we're loading a new one";
             load_new_shaderpack(shaderpack_name);
             return;
         }
 
-        bool shaderpack_in_settings_is_new = shaderpack_name != loaded_shaderpack->get_name();
+        if(defines_changed) {
+            // The new variants compile while the old ones keep rendering, and render_frame swaps them in
+            LOG(DEBUG) << "The shaderpack's defines changed to " << shaderpack_define_values;
+            loaded_shaderpack->set_define_values(shaderpack_define_values);
+            if(loading_shaderpack) {
+                loading_shaderpack->set_define_values(shaderpack_define_values);
+            }
+        }
+
+        update_shader_reloader();
+
+        const std::string& newest_shaderpack_name = loading_shaderpack ? loading_shaderpack->get_name() : loaded_shaderpack->get_name();
+        bool shaderpack_in_settings_is_new = shaderpack_name != newest_shaderpack_name;
         if(shaderpack_in_settings_is_new) {
             LOG(DEBUG) << "Shaderpack " << shaderpack_name << " is about to replace shaderpack " << loaded_shaderpack->get_name();
             load_new_shaderpack(shaderpack_name);
+
+        } else {
+            const auto& snapshot = render_settings->get_snapshot();
+            glm::ivec2 view_size(snapshot.view_width, snapshot.view_height);
+            if(view_size != frame_graph_view_size || snapshot.shadow_map_resolution != frame_graph_shadow_resolution) {
+                LOG(DEBUG) << "The window or the shadow map changed size, so the frame graph's attachments need to be remade";
+                create_frame_graph_from_shaderpack();
+
+            } else if(temporal.is_enabled() != used_temporal_antialiasing) {
+                LOG(DEBUG) << "Temporal antialiasing was turned " << (temporal.is_enabled() ? "on" : "off") << ", so the frame graph needs to be remade";
+                create_frame_graph_from_shaderpack();
+            }
         }
 
         LOG(DEBUG) << "Finished dealing with possible new shaderpack";
@@ -276,117 +694,584 @@ namespace nova {
         return *meshes;
     }
 
+    entity_renderer &nova_renderer::get_entity_renderer() {
+        return entities;
+    }
+
+    particle_system &nova_renderer::get_particle_system() {
+        return particles;
+    }
+
+    sky_renderer &nova_renderer::get_sky() {
+        return sky;
+    }
+
+    clustered_lights &nova_renderer::get_block_lights() {
+        return block_lights;
+    }
+
+    readback_queue &nova_renderer::get_readback_queue() {
+        return readbacks;
+    }
+
+    frame_arena &nova_renderer::get_frame_arena() {
+        return frame_memory;
+    }
+
+    void nova_renderer::save_screenshot(uint64_t ticket, const std::string& path) {
+        pending_saves.push_back({ticket, "", path});
+    }
+
+    void nova_renderer::save_attachment(uint64_t ticket, const std::string& attachment_name, const std::string& path) {
+        if(passes.get_last_writer(attachment_name).empty()) {
+            LOG(ERROR) << "Can't save attachment " << attachment_name << " because no pass keeps what it draws into it";
+            readbacks.fail(ticket);
+            return;
+        }
+
+        pending_saves.push_back({ticket, attachment_name, path});
+    }
+
     void nova_renderer::load_new_shaderpack(const std::string &new_shaderpack_name) {
 		LOG(INFO) << "Loading a new shaderpack";
         LOG(INFO) << "Name of shaderpack " << new_shaderpack_name;
-        loaded_shaderpack = std::make_shared<shaderpack>(load_shaderpack(new_shaderpack_name));
+        if(loading_shaderpack && loading_shaderpack->get_name() == new_shaderpack_name) {
+            // Started while Nova was starting up, so it's already compiling
+            LOG(DEBUG) << "Shaderpack " << new_shaderpack_name << " is already loading";
+
+        } else {
+            loading_shaderpack = std::make_shared<shaderpack>(load_shaderpack(new_shaderpack_name, shaderpack_define_values));
+        }
+
+        if(!loaded_shaderpack) {
+            // Nothing to render with in the meantime, so there's no point in waiting for a later frame
+            finish_loading_shaderpack();
+        }
+    }
+
+    void nova_renderer::finish_loading_shaderpack() {
+        loading_shaderpack->finish_loading();
+        loaded_shaderpack = std::move(loading_shaderpack);
         LOG(DEBUG) << "Shaderpack loaded, wiring everything together";
         LOG(INFO) << "Loading complete";
-		
+
         link_up_uniform_buffers(loaded_shaderpack->get_loaded_shaders(), *ubo_manager);
         LOG(DEBUG) << "Linked up UBOs";
 
-        create_framebuffers_from_shaderpack();
+        resolve_shader_ids();
+        update_packed_vertex_shaders();
+        create_depth_prepass_program();
+
+        create_frame_graph_from_shaderpack();
+        update_shader_reloader();
+    }
+
+    void nova_renderer::reload_changed_shaders() {
+        std::vector<std::string> swapped_programs;
+        bool added_program = loaded_shaderpack->update_variants(swapped_programs);
+        if(shader_reloader && shader_reloader->update(swapped_programs)) {
+            added_program = true;
+        }
+        if(swapped_programs.empty()) {
+            return;
+        }
+
+        auto& shaders = loaded_shaderpack->get_loaded_shaders();
+        for(const auto& name : swapped_programs) {
+            ubo_manager->register_all_buffers_with_shader(shaders[name]);
+        }
+        resolve_shader_ids();
+        update_packed_vertex_shaders();
+
+        if(std::find(swapped_programs.begin(), swapped_programs.end(), "gui") != swapped_programs.end()) {
+            gui.invalidate();
+        }
+
+        if(std::find(swapped_programs.begin(), swapped_programs.end(), DEPTH_PREPASS_SHADER) != swapped_programs.end()) {
+            create_depth_prepass_program();
+        }
+
+        // The frame graph refers to the programs it was made with, which got the new ones swapped into them. A
+        // program it didn't have before needs a pass made for it though
+        if(added_program) {
+            LOG(DEBUG) << "A shader that didn't compile before does now, so the frame graph needs to be remade";
+            create_frame_graph_from_shaderpack();
+        }
+    }
+
+    void nova_renderer::update_shader_reloader() {
+        if(!hot_reload_shaders || !loaded_shaderpack) {
+            shader_reloader.reset();
+
+        } else if(!shader_reloader || !shader_reloader->is_watching(*loaded_shaderpack)) {
+            shader_reloader = std::make_unique<shader_hot_reloader>(loaded_shaderpack);
+        }
+    }
+
+    void nova_renderer::update_packed_vertex_shaders() {
+        for(const auto& shader : loaded_shaderpack->get_loaded_shaders()) {
+            const bool takes_packed_vertices = shader.second.get_builtin_uniforms().has_object_data;
+            meshes->set_shader_takes_packed_vertices(shader.second.get_geometry_id(), takes_packed_vertices);
+        }
+    }
+
+    void nova_renderer::resolve_shader_ids() {
+        // Swapped in programs don't have an ID yet, so every program is done each time
+        for(auto& shader : loaded_shaderpack->get_loaded_shaders()) {
+            shader.second.set_geometry_id(meshes->get_shader_id(shader.first));
+        }
+
+        for(size_t caster = 0; caster < shadow_caster_ids.size(); caster++) {
+            shadow_caster_ids[caster] = meshes->get_shader_id(SHADOW_CASTER_SHADERS[caster]);
+        }
+
+        auto& shaders = loaded_shaderpack->get_loaded_shaders();
+        auto final_shader = shaders.find("final");
+        final_program = final_shader == shaders.end() ? nullptr : &final_shader->second;
+        auto gui_shader = shaders.find("gui");
+        gui_program = gui_shader == shaders.end() ? nullptr : &gui_shader->second;
     }
 
-    void nova_renderer::create_framebuffers_from_shaderpack() {
-        // TODO: Examine the shaderpack and determine what's needed
-        // For now, just create framebuffers with all possible attachments
+    chunk_draw_batch& nova_renderer::get_chunk_batch(shader_id shader) {
+        if(shader >= chunk_batches.size()) {
+            chunk_batches.resize(shader + 1);
+        }
+
+        auto& batch = chunk_batches[shader];
+        if(!batch) {
+            batch = std::make_unique<chunk_draw_batch>();
+        }
+        return *batch;
+    }
+
+    void nova_renderer::create_frame_graph_from_shaderpack() {
+        const auto& settings = render_settings->get_snapshot();
+        unsigned int view_width = settings.view_width;
+        unsigned int view_height = settings.view_height;
+        unsigned int shadow_resolution = settings.shadow_map_resolution;
+        frame_graph_view_size = glm::ivec2(view_width, view_height);
+        frame_graph_shadow_resolution = shadow_resolution;
+
+        passes.reset();
+        passes.set_backbuffer_size(view_width, view_height);
+
+        // Every attachment a shaderpack might use. The frame graph only makes textures for the ones that are read
+        for(unsigned int i = 0; i < 8; i++) {
+            attachment_description colortex;
+            colortex.name = "colortex" + std::to_string(i);
+            colortex.width = view_width;
+            colortex.height = view_height;
+            colortex.texture_unit = i;
+            colortex.scales_with_resolution = true;
+            if(i == 0) {
+                // The sky color, so the sky is the right color where nothing's drawn
+                colortex.clear_value = glm::vec4(135 / 255.0f, 206 / 255.0f, 235 / 255.0f, 1.0);
+            }
+            passes.add_attachment(colortex);
+        }
+
+        attachment_description depthtex;
+        depthtex.name = "depthtex0";
+        depthtex.width = view_width;
+        depthtex.height = view_height;
+        // Its stencil holds the GUI's mask, which has to be in the same format as the GUI layer's stencil
+        depthtex.internal_format = GL_DEPTH32F_STENCIL8;
+        depthtex.texture_unit = 8;
+        depthtex.scales_with_resolution = true;
+        depthtex.clear_value = glm::vec4(1);
+        passes.add_attachment(depthtex);
+
+        // How far each pixel moved since the last frame. It's only drawn if something reads it
+        attachment_description velocitytex;
+        velocitytex.name = "velocitytex";
+        velocitytex.width = view_width;
+        velocitytex.height = view_height;
+        velocitytex.internal_format = GL_RG16F;
+        velocitytex.texture_unit = temporal_accumulation::VELOCITY_TEXTURE_UNIT;
+        velocitytex.scales_with_resolution = true;
+        passes.add_attachment(velocitytex);
+
+        for(unsigned int i = 0; i < 4; i++) {
+            attachment_description shadowcolor;
+            shadowcolor.name = "shadowcolor" + std::to_string(i);
+            shadowcolor.width = shadow_resolution;
+            shadowcolor.height = shadow_resolution;
+            shadowcolor.texture_unit = 9 + i;
+            shadowcolor.persistent = true;
+            passes.add_attachment(shadowcolor);
+        }
+
+        attachment_description shadowtex;
+        shadowtex.name = "shadowtex0";
+        shadowtex.width = shadow_resolution;
+        shadowtex.height = shadow_resolution;
+        shadowtex.internal_format = GL_DEPTH_COMPONENT32F;
+        shadowtex.texture_unit = 13;
+        shadowtex.clear_value = glm::vec4(1);
+        shadowtex.persistent = true;
+        passes.add_attachment(shadowtex);
+
+        auto& shaders = loaded_shaderpack->get_loaded_shaders();
+        std::set<std::string> written_color_textures;
+        auto add_shader_pass = [&](const std::string& shader_name, const std::string& attachment_prefix,
+                                   const std::string& depth_attachment, bool is_fullscreen, std::function<void(gl_shader_program&)> execute) {
+            auto shader_itr = shaders.find(shader_name);
+            if(shader_itr == shaders.end()) {
+                return;
+            }
+            auto& shader = shader_itr->second;
+            if(shader.is_compute() && !is_fullscreen) {
+                LOG(WARNING) << "Shader " << shader_name << " is a compute shader, but only fullscreen passes can be";
+                return;
+            }
+
+            render_pass_description pass;
+            pass.name = shader_name;
+            pass.reads = shader.get_reads();
+            if(is_fullscreen && pass.reads.empty()) {
+                // Shaderpacks from before "reads" don't say what their composite passes sample. A composite that read
+                // nothing would hide everything drawn before it and get every earlier pass culled, so it reads every
+                // colortex that's been drawn to
+                pass.reads.assign(written_color_textures.begin(), written_color_textures.end());
+            }
+            for(unsigned int drawbuffer : shader.get_drawbuffers()) {
+                pass.color_writes.push_back(attachment_prefix + std::to_string(drawbuffer));
+                if(attachment_prefix == "colortex") {
+                    written_color_textures.insert(pass.color_writes.back());
+                }
+            }
+            pass.depth_write = depth_attachment;
+            pass.covers_whole_target = is_fullscreen;
+            pass.writes_with_image_stores = shader.is_compute();
+            pass.execute = [&shader, execute]() { execute(shader); };
+
+            // Nothing under an opaque part of the GUI is ever seen, so the gbuffer and composite passes skip it
+            if(depth_attachment == "depthtex0" || is_fullscreen) {
+                pass.stencil_mask = "depthtex0";
+            }
+            if(depth_attachment == "depthtex0") {
+                pass.execute = [this, &shader, execute]() {
+                    copy_gui_mask();
+                    execute(shader);
+                };
+            }
+
+            passes.add_pass(pass);
+        };
+
+        add_shader_pass("shadow", "shadowcolor", "shadowtex0", false, [&](gl_shader_program& shader) { render_shadow_pass(shader); });
 
-        auto settings = render_settings->get_options()["settings"];
+        // The sky goes under everything else
+        add_shader_pass("gbuffers_skybasic", "colortex", "depthtex0", false, [&](gl_shader_program& shader) {
+            render_sky_layer(shader, sky_layer::sky);
+        });
 
-        main_framebuffer_builder.set_framebuffer_size(settings["viewWidth"], settings["viewHeight"])
-                                .enable_color_attachment(0)
-                                .enable_color_attachment(1)
-                                .enable_color_attachment(2)
-                                .enable_color_attachment(3)
-                                .enable_color_attachment(4)
-                                .enable_color_attachment(5)
-                                .enable_color_attachment(6)
-                                .enable_color_attachment(7);
+        // TODO: Get shaders with gbuffers prefix
+        for(const auto& gbuffers_shader : {"gbuffers_terrain", "gbuffers_entities", "gbuffers_textured"}) {
+            add_shader_pass(gbuffers_shader, "colortex", "depthtex0", false, [&](gl_shader_program& shader) { render_shader(shader); });
+        }
+
+        // Transparent things go after everything opaque, so they blend with whatever's behind them
+        add_shader_pass("gbuffers_clouds", "colortex", "depthtex0", false, [&](gl_shader_program& shader) {
+            render_sky_layer(shader, sky_layer::clouds);
+        });
+        for(const auto& gbuffers_shader : {"gbuffers_water"}) {
+            add_shader_pass(gbuffers_shader, "colortex", "depthtex0", false, [&](gl_shader_program& shader) { render_shader(shader, true); });
+        }
+        add_shader_pass("gbuffers_weather", "colortex", "depthtex0", false, [&](gl_shader_program& shader) {
+            render_sky_layer(shader, sky_layer::weather);
+        });
+
+        // Everything that draws depth is done, so the composite passes can reproject with velocitytex
+        render_pass_description velocity_pass;
+        velocity_pass.name = "velocity";
+        velocity_pass.reads = {"depthtex0"};
+        velocity_pass.color_writes = {"velocitytex"};
+        velocity_pass.covers_whole_target = true;
+        velocity_pass.execute = [&]() { temporal.write_velocity(); };
+        passes.add_pass(velocity_pass);
+
+        // Composite passes with a compute shader write their outputs with image stores, without rasterizing anything
+        auto render_composite_pass = [&](gl_shader_program& shader) {
+            if(shader.is_compute()) {
+                render_compute_pass(shader);
+            } else {
+                render_fullscreen_pass(shader);
+            }
+        };
+        add_shader_pass("composite", "colortex", "", true, render_composite_pass);
+        for(int i = 1; i < 8; i++) {
+            add_shader_pass("composite" + std::to_string(i), "colortex", "", true, render_composite_pass);
+        }
 
-        main_framebuffer = std::make_unique<framebuffer>(main_framebuffer_builder.build());
+        if(temporal.is_enabled()) {
+            // Blends colortex0 with the last frame before the final pass sees it. colortex0 is listed as a write so
+            // the pass isn't culled, but the result is copied in after it's drawn, since it can't be read and drawn
+            // to at once
+            render_pass_description temporal_pass;
+            temporal_pass.name = "temporal_accumulation";
+            temporal_pass.reads = {"colortex0", "velocitytex"};
+            temporal_pass.color_writes = {"colortex0"};
+            temporal_pass.execute = [&]() {
+                temporal.resolve(passes.get_texture("colortex0"), passes.get_texture_size("colortex0"), resolution.get_scale());
+            };
+            passes.add_pass(temporal_pass);
+        }
 
-        shadow_framebuffer_builder.set_framebuffer_size(settings["shadowMapResolution"], settings["shadowMapResolution"])
-                                  .enable_color_attachment(0)
-                                  .enable_color_attachment(1)
-                                  .enable_color_attachment(2)
-                                  .enable_color_attachment(3);
+        render_pass_description final_pass;
+        final_pass.name = "final";
+        auto final_shader = shaders.find("final");
+        if(final_shader != shaders.end() && !final_shader->second.get_reads().empty()) {
+            final_pass.reads = final_shader->second.get_reads();
+        } else {
+            final_pass.reads = {"colortex0"};
+        }
+        final_pass.writes_to_backbuffer = true;
+        final_pass.covers_whole_target = true;
+        final_pass.execute = [&]() { render_final_pass(); };
+        passes.add_pass(final_pass);
+
+        passes.compile();
+
+        // The attachments share textures, so each one has to be read before the next pass can draw over it
+        passes.set_pass_finished_callback([&](const std::string& pass_name) {
+            auto save = pending_saves.begin();
+            while(save != pending_saves.end()) {
+                if(!save->attachment_name.empty() && passes.get_last_writer(save->attachment_name) == pass_name) {
+                    readbacks.read_texture(save->ticket, passes.get_texture(save->attachment_name), save->path);
+                    save = pending_saves.erase(save);
+                } else {
+                    ++save;
+                }
+            }
+        });
 
-        shadow_framebuffer = std::make_unique<framebuffer>(shadow_framebuffer_builder.build());
+        // The gbuffer passes draw into depthtex0, so that's what chunks are culled against
+        occlusion.set_depth_texture(passes.get_texture("depthtex0"), frame_graph_view_size);
 
+        // The shadow attachments are brand new, so nothing in them can be kept
+        shadows.set_resolution(shadow_resolution);
+        shadows.invalidate();
+        temporal.invalidate();
+        gui.invalidate();
     }
 
     void nova_renderer::deinit() {
+        if(instance) {
+            // Gives the context back to this thread
+            instance->render_commands.reset();
+        }
         instance.release();
     }
 
-    void nova_renderer::render_shader(gl_shader_program &shader) {
-        LOG(TRACE) << "Rendering everything for shader " << shader.get_name();
-        profiler::start(shader.get_name());
+    void nova_renderer::render_shader(gl_shader_program &shader, bool is_transparent) {
+        NOVA_LOG_HOT(TRACE) << "Rendering everything for shader " << shader.get_name();
+        profiler::start_gpu(shader.get_name());
+
+        const auto shader_id = shader.get_geometry_id();
+        const bool has_depth_prepass = depth_prepass_program && !is_transparent &&
+                                       shader.get_name() == DEPTH_PREPASS_SHADER;
+        if(has_depth_prepass) {
+            render_depth_prepass(shader_id);
+        }
+
         shader.bind();
+        block_lights.bind();
 
-        profiler::start("get_meshes_for_shader");
-        auto& geometry = meshes->get_meshes_for_shader(shader.get_name());
-        profiler::end("get_meshes_for_shader");
-        profiler::start("process_all");
-        for(auto& geom : geometry) {
-            profiler::start("process_renderable");
-
-            // if(!player_camera.has_object_in_frustum(geom.bounding_box)) {
-            //     continue;
-            // }
-
-            if(geom.geometry->has_data()) {
-                if(!geom.color_texture.empty()) {
-                    auto color_texture = textures->get_texture(geom.color_texture);
-                    color_texture.bind(0);
-                }
+        auto& batch = get_chunk_batch(shader_id);
+        batch.clear();
+        batch.set_keep_order(is_transparent);
 
-                if(geom.normalmap) {
-                    textures->get_texture(*geom.normalmap).bind(1);
-                }
+        if(is_transparent) {
+            profiler::start(NOVA_PROFILER_SCOPE("sort_back_to_front"));
+            meshes->sort_back_to_front(shader_id, player_camera.position);
+            profiler::end(NOVA_PROFILER_SCOPE("sort_back_to_front"));
+        }
+
+        if(has_depth_prepass) {
+            // The depth buffer already has the closest surface at every pixel, so only that surface's fragments are
+            // shaded. The order doesn't matter anymore, so the chunks aren't sorted again
+            gl_state::depth_func(GL_EQUAL);
+            gl_state::depth_mask(false);
+            draw_geometry(shader, shader_id, player_camera.get_frustum(), batch, &occlusion, false, true);
+            gl_state::depth_func(GL_LESS);
+            gl_state::depth_mask(true);
+
+        } else {
+            draw_geometry(shader, shader_id, player_camera.get_frustum(), batch, &occlusion,
+                          !is_transparent && sort_chunks_front_to_back);
+        }
+
+        entities.draw(shader_id, shader, *textures);
+        particles.draw(shader_id, *textures);
+
+        profiler::end(shader.get_name());
+    }
+
+    void nova_renderer::create_depth_prepass_program() {
+        if(depth_prepass_program) {
+            gl_state::delete_program(depth_prepass_program->gl_name);
+            depth_prepass_program.reset();
+        }
+
+        if(!use_depth_prepass || !loaded_shaderpack) {
+            return;
+        }
+
+        auto& definitions = loaded_shaderpack->get_definitions();
+        auto& shaders = loaded_shaderpack->get_loaded_shaders();
+        auto terrain = definitions.find(DEPTH_PREPASS_SHADER);
+        if(terrain == definitions.end() || shaders.find(DEPTH_PREPASS_SHADER) == shaders.end()) {
+            return;
+        }
+
+        // A program can't mix SPIR-V and GLSL shaders
+        if(terrain->second.is_compute() || terrain->second.vertex_source.is_spirv()) {
+            LOG(WARNING) << "The depth pre-pass needs a GLSL vertex shader for " << DEPTH_PREPASS_SHADER
+                         << ", so terrain is drawn without one";
+            return;
+        }
+
+        shader_definition prepass = terrain->second;
+        prepass.name = std::string(DEPTH_PREPASS_SHADER) + "_depth_prepass";
+        std::istringstream fragment_stream(DEPTH_PREPASS_FRAGMENT_SOURCE);
+        prepass.fragment_source = read_shader_stream(fragment_stream, "depth_prepass.frag");
+        prepass.drawbuffers.clear();
+        prepass.reads.clear();
+
+        try {
+            auto program = std::make_unique<gl_shader_program>(prepass, loaded_shaderpack->get_program_cache());
+            program->finish(loaded_shaderpack->get_program_cache());
+            ubo_manager->register_all_buffers_with_shader(*program);
+            depth_prepass_program = std::move(program);
+
+        } catch(std::exception& e) {
+            LOG(WARNING) << "Could not make the depth pre-pass program, so terrain is drawn without one. Reason: "
+                         << e.what();
+        }
+    }
+
+    void nova_renderer::render_depth_prepass(shader_id geometry_shader) {
+        profiler::start_gpu(NOVA_PROFILER_SCOPE("depth_prepass"));
+        depth_prepass_program->bind();
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+        depth_prepass_batch.clear();
+        depth_prepass_batch.set_keep_order(false);
+
+        // Occlusion culling runs here, so the gbuffer pass can use the visibility it works out
+        draw_geometry(*depth_prepass_program, geometry_shader, player_camera.get_frustum(), depth_prepass_batch,
+                      &occlusion, sort_chunks_front_to_back);
+
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        profiler::end(NOVA_PROFILER_SCOPE("depth_prepass"));
+    }
+
+    void nova_renderer::draw_geometry(gl_shader_program& shader, shader_id geometry_shader, const frustum& view_frustum,
+                                      chunk_draw_batch& batch, occlusion_culler* culler, bool front_to_back,
+                                      bool visibility_is_current) {
+        // Shaders which read their chunk positions from an SSBO can have all their chunks drawn with a few multi-draws
+        const auto& builtin_uniforms = shader.get_builtin_uniforms();
+        bool use_indirect_draws = builtin_uniforms.has_chunk_offsets || builtin_uniforms.has_object_data;
+        if(builtin_uniforms.has_object_data) {
+            meshes->get_object_data().bind();
+        }
+
+        profiler::start(NOVA_PROFILER_SCOPE("get_meshes_for_shader"));
+        auto& geometry = meshes->get_meshes_for_shader(geometry_shader);
+        profiler::end(NOVA_PROFILER_SCOPE("get_meshes_for_shader"));
+
+        profiler::start(NOVA_PROFILER_SCOPE("frustum_cull"));
+        meshes->cull_meshes_for_shader(geometry_shader, view_frustum, visible_indices);
+        profiler::end(NOVA_PROFILER_SCOPE("frustum_cull"));
+        meshes->mark_visible(geometry_shader, visible_indices);
+
+        if(front_to_back) {
+            profiler::start(NOVA_PROFILER_SCOPE("sort_front_to_back"));
+            meshes->sort_front_to_back(geometry_shader, player_camera.position, visible_indices);
+            profiler::end(NOVA_PROFILER_SCOPE("sort_front_to_back"));
+        }
+
+        const auto& lod_settings = meshes->get_lod_settings();
+
+        profiler::start(NOVA_PROFILER_SCOPE("process_all"));
+        for(uint32_t geom_idx : visible_indices) {
+            auto& geom = geometry[geom_idx];
+            profiler::start(NOVA_PROFILER_SCOPE("process_renderable"));
+
+            if(geom.num_lods > 1) {
+                const float screen_size = get_screen_size(geom.bounding_box, player_camera.position, player_camera.fov);
+                geom.current_lod = select_chunk_lod(screen_size, geom.current_lod, geom.num_lods, lod_settings);
+            }
+            const auto& arena_handle = geom.get_arena_handle(geom.current_lod);
 
-                if(geom.data_texture) {
-                    textures->get_texture(*geom.data_texture).bind(2);
+            bool in_arena = arena_handle.is_valid();
+            if(in_arena && use_indirect_draws) {
+                // All the chunks in a filter use the same textures, so the first one's textures work for the whole batch
+                if(batch.empty()) {
+                    bind_textures(meshes->get_material(geom.material));
                 }
+                batch.add(arena_handle, geom.position, geom.object_slot, geom.bounding_box);
 
-                textures->get_texture("lightmap").bind(3);
+            } else if(in_arena || (geom.geometry && geom.geometry->has_data())) {
+                bind_textures(meshes->get_material(geom.material));
 
-                upload_model_matrix(geom, shader);
+                // Objects with a slot in the object data buffer already have their position on the GPU
+                const bool has_object_slot = geom.object_slot != object_data_buffer::NO_OBJECT;
+                if(!builtin_uniforms.has_object_data || !has_object_slot) {
+                    upload_model_matrix(geom, shader);
+                }
 
-                profiler::start("drawcall");
-                geom.geometry->set_active();
-                geom.geometry->draw();
-                profiler::end("drawcall");
+                profiler::start(NOVA_PROFILER_SCOPE("drawcall"));
+                if(in_arena) {
+                    meshes->get_chunk_arena().draw(arena_handle, has_object_slot ? geom.object_slot : 0);
+                } else {
+                    geom.geometry->set_active();
+                    geom.geometry->draw();
+                }
+                profiler::end(NOVA_PROFILER_SCOPE("drawcall"));
             } else {
-                LOG(TRACE) << "Skipping some geometry since it has no data";
+                NOVA_LOG_HOT(TRACE) << "Skipping some geometry since it has no data";
             }
-            profiler::end("process_renderable");
+            profiler::end(NOVA_PROFILER_SCOPE("process_renderable"));
         }
-        for(int i=0;i<geometry.size();i++){
-            if(geometry[i].needs_deletion){
-                geometry.erase( geometry.begin()+i);
-                i--;
-            }
+        profiler::end(NOVA_PROFILER_SCOPE("process_all"));
+
+        if(!batch.empty()) {
+            profiler::start(NOVA_PROFILER_SCOPE("multidraw"));
+            batch.submit(meshes->get_chunk_arena(), builtin_uniforms.has_chunk_offsets, culler, shader.gl_name,
+                         visibility_is_current);
+            profiler::end(NOVA_PROFILER_SCOPE("multidraw"));
         }
-        profiler::end("process_all");
+    }
 
-        profiler::end(shader.get_name());
+    void nova_renderer::bind_textures(const render_material &material) {
+        if(material.color_texture_handle != NO_TEXTURE) {
+            textures->bind_texture(material.color_texture_handle, 0);
+        }
+
+        if(material.normalmap_handle != NO_TEXTURE) {
+            textures->bind_texture(material.normalmap_handle, 1);
+        }
+
+        if(material.data_texture_handle != NO_TEXTURE) {
+            textures->bind_texture(material.data_texture_handle, 2);
+        }
+
+        textures->bind_texture(lightmap_handle, 3);
     }
 
     inline void nova_renderer::upload_model_matrix(render_object &geom, gl_shader_program &program) const {
         glm::mat4 model_matrix = glm::translate(glm::mat4(1), geom.position);
 
-        auto model_matrix_location = program.get_uniform_location("gbufferModel");
-        glUniformMatrix4fv(model_matrix_location, 1, GL_FALSE, &model_matrix[0][0]);
+        glUniformMatrix4fv(program.get_builtin_uniforms().gbuffer_model, 1, GL_FALSE, &model_matrix[0][0]);
     }
 
     void nova_renderer::upload_gui_model_matrix(gl_shader_program &program) {
-        auto config = render_settings->get_options()["settings"];
-        float view_width = config["viewWidth"];
-        float view_height = config["viewHeight"];
-        float scalefactor = config["scalefactor"];
+        const auto& config = render_settings->get_snapshot();
+        float view_width = config.view_width;
+        float view_height = config.view_height;
+        float scalefactor = config.scalefactor;
         // The GUI matrix is super simple, just a viewport transformation
         glm::mat4 gui_model(1.0f);
         gui_model = glm::translate(gui_model, glm::vec3(-1.0f, 1.0f, 0.0f));
@@ -394,21 +1279,49 @@ namespace nova {
         gui_model = glm::scale(gui_model, glm::vec3(1.0 / view_width, 1.0 / view_height, 1.0));
         gui_model = glm::scale(gui_model, glm::vec3(1.0f, -1.0f, 1.0f));
 
-        auto model_matrix_location = program.get_uniform_location("gbufferModel");
+        glUniformMatrix4fv(program.get_builtin_uniforms().gbuffer_model, 1, GL_FALSE, &gui_model[0][0]);
+    }
+
+    void nova_renderer::update_resolution_scale() {
+        resolution.update();
+        game_window->get_renderdoc().trigger_for_spike(resolution.get_slowest_new_frame_time());
+        const float scale = resolution.get_scale();
+        passes.set_resolution_scale(scale);
 
-        glUniformMatrix4fv(model_matrix_location, 1, GL_FALSE, &gui_model[0][0]);
+        const glm::uvec2 view_size(frame_graph_view_size);
+        occlusion.set_render_scale(glm::vec2(get_scaled_size(view_size, scale)) / glm::vec2(glm::max(view_size, glm::uvec2(1))));
+        ubo_manager->get_per_frame_uniform_variables().renderScale = scale;
     }
 
     void nova_renderer::update_gbuffer_ubos() {
         // Big thing here is to update the camera's matrices
 
-        auto& per_frame_ubo = ubo_manager->get_per_frame_uniforms();
-
-        auto per_frame_uniform_data = per_frame_uniforms{};
-        per_frame_uniform_data.gbufferProjection = player_camera.get_projection_matrix();
-        per_frame_uniform_data.gbufferModelView = player_camera.get_view_matrix();
-
-        per_frame_ubo.send_data(per_frame_uniform_data);
+        // Keep the values from the settings, like viewWidth and aspectRatio, and just replace the camera's
+        const glm::mat4& view = player_camera.get_view_matrix();
+        const glm::mat4& projection = player_camera.get_projection_matrix();
+        temporal.begin_frame(view, projection, player_camera.position,
+                             get_scaled_size(glm::uvec2(frame_graph_view_size), resolution.get_scale()));
+
+        auto& per_frame_uniform_data = ubo_manager->get_per_frame_uniform_variables();
+        per_frame_uniform_data.gbufferProjection = temporal.get_projection();
+        per_frame_uniform_data.gbufferModelView = view;
+        per_frame_uniform_data.gbufferProjectionInverse = glm::inverse(per_frame_uniform_data.gbufferProjection);
+        per_frame_uniform_data.gbufferModelViewInverse = glm::inverse(per_frame_uniform_data.gbufferModelView);
+        per_frame_uniform_data.gbufferPreviousProjection = temporal.get_previous_projection();
+        per_frame_uniform_data.gbufferPreviousModelView = temporal.get_previous_view();
+        per_frame_uniform_data.cameraPosition = player_camera.position;
+        per_frame_uniform_data.previousCameraPosition = temporal.get_previous_position();
+        per_frame_uniform_data.frameCounter = static_cast<GLint>(temporal.get_frame_counter());
+        per_frame_uniform_data.temporalJitter = temporal.get_jitter();
+        per_frame_uniform_data.rainStrength = sky.get_rain_strength();
+
+        ubo_manager->get_per_frame_uniforms().send_data(per_frame_uniform_data);
+
+        // The sky, clouds, and weather make all their geometry from this one block
+        ubo_manager->get_sky_uniforms().send_data(sky.get_uniforms());
+
+        // The jitter is less than a pixel, so culling uses the steady projection
+        occlusion.set_view_projection(projection * view);
     }
 
     camera &nova_renderer::get_player_camera() {
@@ -420,7 +1333,7 @@ namespace nova {
     }
 
     void link_up_uniform_buffers(std::unordered_map<std::string, gl_shader_program> &shaders, uniform_buffer_store &ubos) {
-        nova::foreach(shaders, [&](auto shader) { ubos.register_all_buffers_with_shader(shader.second); });
+        nova::foreach(shaders, [&](const auto& shader) { ubos.register_all_buffers_with_shader(shader.second); });
     }
 }
 
@@ -5,16 +5,34 @@
 #ifndef RENDERER_VULKAN_MOD_H
 #define RENDERER_VULKAN_MOD_H
 
+#include <array>
+#include <deque>
+#include <future>
 #include <memory>
 #include <thread>
 #include "objects/shaders/gl_shader_program.h"
+#include "objects/shaders/shader_hot_reloader.h"
 #include "objects/uniform_buffers/uniform_buffer_store.h"
 #include "windowing/glfw_gl_window.h"
 #include "../geometry_cache/mesh_store.h"
 #include "objects/textures/texture_manager.h"
 #include "../input/InputHandler.h"
-#include "objects/framebuffer.h"
 #include "objects/camera.h"
+#include "objects/chunk_draw_batch.h"
+#include "objects/clustered_lights.h"
+#include "objects/dynamic_resolution.h"
+#include "objects/entity_renderer.h"
+#include "objects/gui_layer.h"
+#include "objects/occlusion_culler.h"
+#include "objects/particle_system.h"
+#include "objects/readback_queue.h"
+#include "objects/shadow_cascades.h"
+#include "objects/sky_renderer.h"
+#include "objects/stats_overlay.h"
+#include "objects/temporal_accumulation.h"
+#include "../utils/frame_arena.h"
+#include "frame_graph.h"
+#include "render_thread.h"
 
 namespace nova {
     /*!
@@ -50,8 +68,12 @@ namespace nova {
          *
          * Initializing the nova_renderer is a lot of work. I create an OpenGL context, create a GLFW window, initialize
          * the texture manager, shader manager, UBO manager, etc. and set up initial OpenGL state.
+         *
+         * \param startup_shaderpack The shaderpack named in the settings, being read on another thread. Its shaders
+         * start compiling as soon as the context is made, so the driver compiles them while everything else is set
+         * up. If it's not valid, the shaderpack is read once the settings are sent out
          */
-        nova_renderer();
+        explicit nova_renderer(std::future<shaderpack_sources> startup_shaderpack = {});
 
         /*!
          * \brief Destructor
@@ -61,12 +83,26 @@ namespace nova {
         /*!
          * \brief Renders a single frame
          *
-         * This method runs in a separate thread from the rest of the methods in this class. This is because the other
-         * methods are called by Minecraft, from the Minecraft thread, while this method is run in a separate thread. This
-         * is done to keep the OpenGL contexts separate. Hopefully it'll work
+         * Once the render thread is started this runs on it, and the thread that made the window has to poll its
+         * events. Otherwise this polls them itself, right before the camera is updated
+         *
+         * Waits at the end if the GPU is more than maxFramesInFlight frames behind
          */
         void render_frame();
 
+        /*!
+         * \brief Moves the OpenGL context to a new render thread. Everything that touches GL has to go through it
+         * from then on
+         *
+         * The facade calls this right after init. Tests that use GL directly just never start it
+         */
+        void start_render_thread();
+
+        /*!
+         * \brief The render thread, if it's been started. See #start_render_thread
+         */
+        render_thread* get_render_thread();
+
         /*!
          * \brief determines whether or not the Nova Renderer, and by extension Minecraft, should shut down. Called directly
          * by the C interface
@@ -85,8 +121,49 @@ namespace nova {
 
         mesh_store& get_mesh_store();
 
+        entity_renderer& get_entity_renderer();
+
+        particle_system& get_particle_system();
+
+        sky_renderer& get_sky();
+
+        clustered_lights& get_block_lights();
+
+        readback_queue& get_readback_queue();
+
+        /*!
+         * \brief Memory for things that only last until the end of the frame. It's reset at the start of every frame,
+         * and must only be used from the render thread
+         */
+        frame_arena& get_frame_arena();
+
+        /*!
+         * \brief Saves what's in the window at the end of the next frame, GUI and all
+         *
+         * \param ticket The ticket from the readback queue
+         * \param path Where to write the PNG
+         */
+        void save_screenshot(uint64_t ticket, const std::string& path);
+
+        /*!
+         * \brief Saves one of the frame graph's attachments in the next frame, right after the last pass that draws
+         * into it
+         *
+         * \param ticket The ticket from the readback queue
+         * \param attachment_name The attachment, like colortex0 or depthtex0
+         * \param path Where to write the PNG
+         */
+        void save_attachment(uint64_t ticket, const std::string& attachment_name, const std::string& path);
+
         camera& get_player_camera();
 
+        /*!
+         * \brief Sets where the sun and moon are in the sky
+         *
+         * \param angle Minecraft's celestial angle: 0 at noon, 0.25 at sunset, 0.5 at midnight, and 0.75 at sunrise
+         */
+        void set_celestial_angle(float angle);
+
         std::shared_ptr<shaderpack> get_shaders();
 
         // Overrides from iconfig_listener
@@ -101,53 +178,361 @@ namespace nova {
 
         std::unique_ptr<glfw_gl_window> game_window;
 
+        /*!
+         * \brief Stopped before anything else is destroyed, so its commands never see a half destroyed renderer
+         */
+        std::unique_ptr<render_thread> render_commands;
+
         std::shared_ptr<shaderpack> loaded_shaderpack;
 
+        /*!
+         * \brief The shaderpack that's being compiled. The loaded shaderpack keeps rendering until this one is ready
+         */
+        std::shared_ptr<shaderpack> loading_shaderpack;
+
+        /*!
+         * \brief Recompiles the loaded shaderpack's shaders when their files change. Only made when the
+         * hotReloadShaders setting is on
+         */
+        std::unique_ptr<shader_hot_reloader> shader_reloader;
+
+        bool hot_reload_shaders = false;
+
+        /*!
+         * \brief The value of each of the shaderpack's defines, from the shaderpackDefines setting
+         */
+        nlohmann::json shaderpack_define_values = nlohmann::json::object();
+
+        /*!
+         * \brief How many frames the GPU can be behind us before we wait for it. Fewer frames means less latency
+         * between input and the screen, more frames means we're less likely to stall
+         */
+        unsigned int max_frames_in_flight = 2;
+
+        /*!
+         * \brief A fence for the end of each frame the GPU might still be working on, oldest first
+         */
+        std::deque<GLsync> frame_fences;
+
         std::unique_ptr<texture_manager> textures;
 
+        texture_handle lightmap_handle = NO_TEXTURE;
+
         std::unique_ptr<input_handler> inputs;
 
         std::unique_ptr<mesh_store> meshes;
 
         std::unique_ptr<uniform_buffer_store> ubo_manager;
 
-        std::vector<GLuint> shadow_depth_textures;
-        std::unique_ptr<framebuffer> shadow_framebuffer;
-        framebuffer_builder shadow_framebuffer_builder;
+        /*!
+         * \brief All the passes in a frame, along with the attachments they render to
+         */
+        frame_graph passes;
+
+        /*!
+         * \brief The view size that the frame graph's attachments were made for, so we know when to rebuild them
+         */
+        glm::ivec2 frame_graph_view_size;
+        unsigned int frame_graph_shadow_resolution = 0;
 
-        std::unique_ptr<framebuffer> main_framebuffer;
-        std::vector<GLuint> gbuffer_depth_textures;
-        framebuffer_builder main_framebuffer_builder;
+        /*!
+         * \brief An empty VAO, since fullscreen passes make their vertices from gl_VertexID
+         */
+        GLuint fullscreen_pass_vao = 0;
 
         camera player_camera;
 
+        /*!
+         * \brief The multi-draw batch for each shader, indexed by shader ID and kept around so their buffers can be
+         * reused every frame
+         */
+        std::vector<std::unique_ptr<chunk_draw_batch>> chunk_batches;
+
+        /*!
+         * \brief The shaders whose geometry is drawn into the shadow map, and the batches they're drawn with. The IDs
+         * are looked up when the shaderpack loads
+         */
+        std::array<shader_id, 2> shadow_caster_ids = {};
+        std::array<chunk_draw_batch, 2> shadow_caster_batches;
+
+        chunk_draw_batch depth_prepass_batch;
+
+        /*!
+         * \brief The programs drawn outside of the shaders' own passes, or nullptr if the shaderpack doesn't have them.
+         * Found when the shaderpack loads, like the shader IDs, since the shaderpack never moves its programs
+         */
+        gl_shader_program* final_program = nullptr;
+        gl_shader_program* gui_program = nullptr;
+
+        /*!
+         * \brief Hides chunks that are behind other chunks. Turned on and off by the occlusionCulling setting
+         */
+        occlusion_culler occlusion;
+
+        /*!
+         * \brief Draws the depth of the terrain before it's shaded, so gbuffers_terrain's fragment shader only runs
+         * once per pixel. Turned on and off by the depthPrepass setting, and nullptr when it's off or the shaderpack
+         * can't have one
+         */
+        std::unique_ptr<gl_shader_program> depth_prepass_program;
+        bool use_depth_prepass = false;
+
+        /*!
+         * \brief If true, opaque chunks are drawn closest first. Set by the frontToBackChunks setting
+         */
+        bool sort_chunks_front_to_back = true;
+
+        /*!
+         * \brief Draws the entity models Minecraft has sent, with one instanced draw per model
+         */
+        entity_renderer entities;
+
+        /*!
+         * \brief Simulates and draws particles, entirely on the GPU
+         */
+        particle_system particles;
+
+        /*!
+         * \brief Draws the sky, clouds, and weather from the time and weather Minecraft sends
+         */
+        sky_renderer sky;
+
+        /*!
+         * \brief The lights from emissive blocks, binned into clusters for the shaders that shade them
+         */
+        clustered_lights block_lights;
+
+        /*!
+         * \brief Picks how much of the gbuffer and composite attachments is drawn to, from how long the GPU takes
+         */
+        dynamic_resolution resolution;
+
+        /*!
+         * \brief Keeps the last frame's camera for reprojection, and blends frames together when temporal
+         * antialiasing is on
+         */
+        temporal_accumulation temporal;
+
+        /*!
+         * \brief Keeps the GUI drawn between the frames it changes in, and masks the world under its opaque parts.
+         * Turned on and off by the guiLayer setting
+         */
+        gui_layer gui;
+        bool use_gui_layer = true;
+
+        /*!
+         * \brief True once the GUI's mask has been copied into depthtex0 this frame
+         */
+        bool copied_gui_mask = false;
+        uint32_t gui_mask_version = 0;
+
+        /*!
+         * \brief Saves screenshots and attachments to disk without waiting on the GPU
+         */
+        readback_queue readbacks;
+
+        /*!
+         * \brief A screenshot or attachment that will be read in the next frame
+         */
+        struct pending_save {
+            uint64_t ticket;
+            std::string attachment_name;    //!< Empty for screenshots of the whole window
+            std::string path;
+        };
+
+        std::vector<pending_save> pending_saves;
+
+        /*!
+         * \brief The indices of the render objects that passed frustum culling for the shader currently being drawn
+         */
+        std::vector<uint32_t> visible_indices;
+
+        /*!
+         * \brief The cascades of the shadow map, and which of them need to be drawn this frame
+         */
+        shadow_cascades shadows;
+
+        /*!
+         * \brief The bounding boxes of the chunks that changed this frame, kept around so they don't allocate
+         */
+        std::vector<aabb> changed_chunk_bounds;
+
+        float celestial_angle = 0;
+
+        /*!
+         * \brief Shows the last frame's statistics over the GUI. Turned on and off by the statsOverlay setting
+         */
+        stats_overlay overlay;
+        bool show_stats_overlay = false;
+
+        frame_arena frame_memory;
+
         /*!
          * \brief Renders the GUI of Minecraft
          */
         void render_gui();
 
-        void render_shadow_pass();
+        /*!
+         * \brief Draws every GUI mesh with the shaderpack's GUI shader, into whatever framebuffer is bound
+         */
+        void draw_gui_meshes();
+
+        /*!
+         * \brief Copies the GUI's mask into depthtex0, the first time a pass that draws into depthtex0 runs each frame
+         */
+        void copy_gui_mask();
+
+        /*!
+         * \brief Draws the chunks into each shadow cascade that's out of date, leaving the others as they are
+         */
+        void render_shadow_pass(gl_shader_program& shader);
+
+        /*!
+         * \brief Fits the shadow cascades to the camera and the light, works out which of them need to be drawn, and
+         * fills in the shadow and celestial uniforms
+         */
+        void update_shadow_cascades();
+
+        /*!
+         * \brief The direction towards the sun, in world space
+         */
+        glm::vec3 get_sun_direction() const;
+
+        /*!
+         * \brief Draws one layer of the sky with the given shader
+         */
+        void render_sky_layer(gl_shader_program& shader, sky_layer layer);
 
-        void render_gbuffers();
+        /*!
+         * \brief Draws a single triangle that covers the whole screen with the given shader
+         *
+         * The shader's vertex shader has to generate the triangle's positions from gl_VertexID
+         */
+        void render_fullscreen_pass(gl_shader_program& shader);
 
-        void render_composite_passes();
+        /*!
+         * \brief Runs a compute shader over every pixel of the view, instead of drawing a fullscreen triangle
+         *
+         * The frame graph binds the shader's drawbuffers to image units in order, so the shader writes output i with
+         * imageStore to image binding i. One invocation is dispatched per pixel, rounded up to whole work groups
+         */
+        void render_compute_pass(gl_shader_program& shader);
+
+        /*!
+         * \brief Picks this frame's resolution scale and hands it to everything that draws at it
+         */
+        void update_resolution_scale();
 
         void render_final_pass();
 
         void enable_debug();
 
+        /*!
+         * \brief Fences off the frame that was just submitted, then waits for old frames until no more than
+         * max_frames_in_flight are left
+         */
+        void limit_frames_in_flight();
+
+        /*!
+         * \brief Saves the profiler's trace to the trace directory, named after the time, when the trace hotkey is
+         * pressed
+         */
+        void save_requested_trace();
+
         void init_opengl_state() const;
 
+        /*!
+         * \brief Starts loading the shaderpack with the given name
+         *
+         * If there's already a shaderpack, it keeps rendering until the new one is done compiling. If there isn't,
+         * this waits for the new one, so there's always something to render with
+         */
         void load_new_shaderpack(const std::string &new_shaderpack_name);
 
-        void create_framebuffers_from_shaderpack();
+        /*!
+         * \brief Replaces the loaded shaderpack with the one that's been loading, and wires it up to everything
+         */
+        void finish_loading_shaderpack();
+
+        /*!
+         * \brief Swaps in the shaders that were edited since last frame and the shader variants that finished compiling,
+         * and wires them up to everything
+         */
+        void reload_changed_shaders();
+
+        /*!
+         * \brief Makes or throws away the shader reloader, to match the hotReloadShaders setting and the loaded
+         * shaderpack
+         */
+        void update_shader_reloader();
+
+        /*!
+         * \brief Tells the mesh store which of the loaded shaders can draw packed block vertices, which are the ones
+         * that read the object_data block
+         */
+        void update_packed_vertex_shaders();
+
+        /*!
+         * \brief Looks up the mesh store's ID for each loaded shader and for the shadow casters, and finds the final and
+         * GUI programs, so nothing is looked up by name every frame
+         */
+        void resolve_shader_ids();
+
+        /*!
+         * \brief The multi-draw batch for the shader with the given ID, which is made the first time it's asked for
+         */
+        chunk_draw_batch& get_chunk_batch(shader_id shader);
+
+        /*!
+         * \brief Builds the frame graph from the passes and attachments the loaded shaderpack uses
+         *
+         * Shadow, gbuffer, composite, and final shaders each become a pass that reads and writes the attachments
+         * named in their shaders.json entry
+         */
+        void create_frame_graph_from_shaderpack();
 
         /*!
          * \brief Renders all the geometry that uses the specified shader, setting up textures and whatnot
          *
          * \param shader The shader to render things with
+         * \param is_transparent If true, the shader's geometry is sorted and drawn back to front so it blends properly
+         */
+        void render_shader(gl_shader_program& shader, bool is_transparent = false);
+
+        /*!
+         * \brief Makes the depth pre-pass program from the loaded shaderpack's terrain vertex shader, or throws away
+         * the old one if the pre-pass is off
+         *
+         * The pre-pass uses the shaderpack's own vertex shader, so its depths match the gbuffer pass's exactly and
+         * that pass can test with GL_EQUAL. Its fragment shader only throws out the see-through parts of cutout blocks,
+         * which needs the vertex shader to output the texture coordinate as uv
+         */
+        void create_depth_prepass_program();
+
+        /*!
+         * \brief Draws the depth of the terrain that's in view, without writing any color
+         */
+        void render_depth_prepass(shader_id geometry_shader);
+
+        /*!
+         * \brief Draws the geometry for the given shader ID that's inside the frustum, with a program that's already bound
+         *
+         * \param shader The program to draw with
+         * \param geometry_shader The ID of the shader whose geometry should be drawn
+         * \param view_frustum The frustum to cull the geometry against
+         * \param batch The batch to collect multi-draws in. It should be empty
+         * \param culler The occlusion culler to use for the batch, or nullptr to draw everything in the frustum
+         * \param front_to_back If true, the visible geometry is drawn closest to the camera first
+         * \param visibility_is_current If true, the same geometry was already drawn with the culler this frame
+         */
+        void draw_geometry(gl_shader_program& shader, shader_id geometry_shader, const frustum& view_frustum,
+                           chunk_draw_batch& batch, occlusion_culler* culler, bool front_to_back = false,
+                           bool visibility_is_current = false);
+
+        /*!
+         * \brief Binds the color texture, normal map, data texture, and lightmap for the given material
          */
-        void render_shader(gl_shader_program& shader);
+        void bind_textures(const render_material &material);
 
         inline void upload_gui_model_matrix(gl_shader_program &program);
 
@@ -12,33 +12,57 @@ namespace nova {
         if(projection_matrix_is_dirty) {
             projection_matrix = glm::perspective(glm::radians(fov), aspect_ratio, near_plane, far_plane);
             projection_matrix_is_dirty = false;
+            version++;
         }
 
         return projection_matrix;
     }
 
-    glm::mat4 camera::get_view_matrix() {
-        glm::mat4 view_matrix;
-        view_matrix = glm::rotate(view_matrix, glm::radians(180.0f), {0, 1, 0});
-        view_matrix = glm::rotate(view_matrix, glm::radians(-rotation.y), { 1, 0, 0 });
-        view_matrix = glm::rotate(view_matrix, glm::radians(rotation.x), { 0, 1, 0 });
-        view_matrix = glm::translate(view_matrix, -position);
-
+    const glm::mat4& camera::get_view_matrix() {
+        update_view_matrix();
         return view_matrix;
     }
 
     glm::vec3 camera::get_view_direction() {
-        glm::mat4 view_matrix;
-        view_matrix = glm::rotate(view_matrix, glm::radians(180.0f), {0, 1, 0});
-        view_matrix = glm::rotate(view_matrix, glm::radians(-rotation.y), { 1, 0, 0 });
-        view_matrix = glm::rotate(view_matrix, glm::radians(rotation.x), { 0, 1, 0 });
+        update_view_matrix();
+        return glm::mat3(rotation_matrix) * glm::vec3{0, 0, 1};
+    }
+
+    uint64_t camera::get_version() {
+        // Both of these bump the version if their matrix needs to change
+        get_projection_matrix();
+        update_view_matrix();
+
+        return version;
+    }
+
+    void camera::update_view_matrix() {
+        // The position and rotation are set straight from Minecraft, so compare them to what the matrix was made with
+        if(view_matrix_is_valid && position == view_matrix_position && rotation == view_matrix_rotation) {
+            return;
+        }
+
+        rotation_matrix = glm::rotate(glm::mat4(1), glm::radians(180.0f), {0, 1, 0});
+        rotation_matrix = glm::rotate(rotation_matrix, glm::radians(-rotation.y), { 1, 0, 0 });
+        rotation_matrix = glm::rotate(rotation_matrix, glm::radians(rotation.x), { 0, 1, 0 });
+        view_matrix = glm::translate(rotation_matrix, -position);
 
-        return glm::mat3(view_matrix) * glm::vec3{0, 0, 1};
+        view_matrix_position = position;
+        view_matrix_rotation = rotation;
+        view_matrix_is_valid = true;
+        version++;
     }
 
     void camera::recalculate_frustum() {
-        glm::mat4 proj = get_projection_matrix();
-        glm::mat4 modl = get_view_matrix();
+        const uint64_t current_version = get_version();
+        if(frustum_is_valid && frustum_version == current_version) {
+            return;
+        }
+        frustum_version = current_version;
+        frustum_is_valid = true;
+
+        const glm::mat4& proj = get_projection_matrix();
+        const glm::mat4& modl = get_view_matrix();
         glm::mat4 clip;
 
         float t;
@@ -46,82 +70,82 @@ namespace nova {
         clip = proj * modl;
 
         /* Extract the numbers for the RIGHT plane */
-        frustum[0][0] = clip[0][3] - clip[0][0];
-        frustum[0][1] = clip[1][3] - clip[1][0];
-        frustum[0][2] = clip[2][3] - clip[2][0];
-        frustum[0][3] = clip[3][3] - clip[3][0];
+        view_frustum.planes[0][0] = clip[0][3] - clip[0][0];
+        view_frustum.planes[0][1] = clip[1][3] - clip[1][0];
+        view_frustum.planes[0][2] = clip[2][3] - clip[2][0];
+        view_frustum.planes[0][3] = clip[3][3] - clip[3][0];
 
         /* Normalize the result */
-        t = std::sqrt(frustum[0][0] * frustum[0][0] + frustum[0][1] * frustum[0][1] + frustum[0][2] * frustum[0][2]);
-        frustum[0][0] /= t;
-        frustum[0][1] /= t;
-        frustum[0][2] /= t;
-        frustum[0][3] /= t;
+        t = std::sqrt(view_frustum.planes[0][0] * view_frustum.planes[0][0] + view_frustum.planes[0][1] * view_frustum.planes[0][1] + view_frustum.planes[0][2] * view_frustum.planes[0][2]);
+        view_frustum.planes[0][0] /= t;
+        view_frustum.planes[0][1] /= t;
+        view_frustum.planes[0][2] /= t;
+        view_frustum.planes[0][3] /= t;
 
         /* Extract the numbers for the LEFT plane */
-        frustum[1][0] = clip[0][3] + clip[0][0];
-        frustum[1][1] = clip[1][3] + clip[1][0];
-        frustum[1][2] = clip[2][3] + clip[2][0];
-        frustum[1][3] = clip[3][3] + clip[3][0];
+        view_frustum.planes[1][0] = clip[0][3] + clip[0][0];
+        view_frustum.planes[1][1] = clip[1][3] + clip[1][0];
+        view_frustum.planes[1][2] = clip[2][3] + clip[2][0];
+        view_frustum.planes[1][3] = clip[3][3] + clip[3][0];
 
         /* Normalize the result */
-        t = std::sqrt(frustum[1][0] * frustum[1][0] + frustum[1][1] * frustum[1][1] + frustum[1][2] * frustum[1][2]);
-        frustum[1][0] /= t;
-        frustum[1][1] /= t;
-        frustum[1][2] /= t;
-        frustum[1][3] /= t;
+        t = std::sqrt(view_frustum.planes[1][0] * view_frustum.planes[1][0] + view_frustum.planes[1][1] * view_frustum.planes[1][1] + view_frustum.planes[1][2] * view_frustum.planes[1][2]);
+        view_frustum.planes[1][0] /= t;
+        view_frustum.planes[1][1] /= t;
+        view_frustum.planes[1][2] /= t;
+        view_frustum.planes[1][3] /= t;
 
         /* Extract the BOTTOM plane */
-        frustum[2][0] = clip[0][3] + clip[0][1];
-        frustum[2][1] = clip[1][3] + clip[1][1];
-        frustum[2][2] = clip[2][3] + clip[2][1];
-        frustum[2][3] = clip[3][3] + clip[3][1];
+        view_frustum.planes[2][0] = clip[0][3] + clip[0][1];
+        view_frustum.planes[2][1] = clip[1][3] + clip[1][1];
+        view_frustum.planes[2][2] = clip[2][3] + clip[2][1];
+        view_frustum.planes[2][3] = clip[3][3] + clip[3][1];
 
         /* Normalize the result */
-        t = std::sqrt(frustum[2][0] * frustum[2][0] + frustum[2][1] * frustum[2][1] + frustum[2][2] * frustum[2][2]);
-        frustum[2][0] /= t;
-        frustum[2][1] /= t;
-        frustum[2][2] /= t;
-        frustum[2][3] /= t;
+        t = std::sqrt(view_frustum.planes[2][0] * view_frustum.planes[2][0] + view_frustum.planes[2][1] * view_frustum.planes[2][1] + view_frustum.planes[2][2] * view_frustum.planes[2][2]);
+        view_frustum.planes[2][0] /= t;
+        view_frustum.planes[2][1] /= t;
+        view_frustum.planes[2][2] /= t;
+        view_frustum.planes[2][3] /= t;
 
         /* Extract the TOP plane */
-        frustum[3][0] = clip[0][3] - clip[0][1];
-        frustum[3][1] = clip[1][3] - clip[1][1];
-        frustum[3][2] = clip[2][3] - clip[2][1];
-        frustum[3][3] = clip[3][3] - clip[3][1];
+        view_frustum.planes[3][0] = clip[0][3] - clip[0][1];
+        view_frustum.planes[3][1] = clip[1][3] - clip[1][1];
+        view_frustum.planes[3][2] = clip[2][3] - clip[2][1];
+        view_frustum.planes[3][3] = clip[3][3] - clip[3][1];
 
         /* Normalize the result */
-        t = std::sqrt(frustum[3][0] * frustum[3][0] + frustum[3][1] * frustum[3][1] + frustum[3][2] * frustum[3][2]);
-        frustum[3][0] /= t;
-        frustum[3][1] /= t;
-        frustum[3][2] /= t;
-        frustum[3][3] /= t;
+        t = std::sqrt(view_frustum.planes[3][0] * view_frustum.planes[3][0] + view_frustum.planes[3][1] * view_frustum.planes[3][1] + view_frustum.planes[3][2] * view_frustum.planes[3][2]);
+        view_frustum.planes[3][0] /= t;
+        view_frustum.planes[3][1] /= t;
+        view_frustum.planes[3][2] /= t;
+        view_frustum.planes[3][3] /= t;
 
         /* Extract the FAR plane */
-        frustum[4][0] = clip[0][3] - clip[0][2];
-        frustum[4][1] = clip[1][3] - clip[1][2];
-        frustum[4][2] = clip[2][3] - clip[2][2];
-        frustum[4][3] = clip[3][3] - clip[3][2];
+        view_frustum.planes[4][0] = clip[0][3] - clip[0][2];
+        view_frustum.planes[4][1] = clip[1][3] - clip[1][2];
+        view_frustum.planes[4][2] = clip[2][3] - clip[2][2];
+        view_frustum.planes[4][3] = clip[3][3] - clip[3][2];
 
         /* Normalize the result */
-        t = std::sqrt(frustum[4][0] * frustum[4][0] + frustum[4][1] * frustum[4][1] + frustum[4][2] * frustum[4][2]);
-        frustum[4][0] /= t;
-        frustum[4][1] /= t;
-        frustum[4][2] /= t;
-        frustum[4][3] /= t;
+        t = std::sqrt(view_frustum.planes[4][0] * view_frustum.planes[4][0] + view_frustum.planes[4][1] * view_frustum.planes[4][1] + view_frustum.planes[4][2] * view_frustum.planes[4][2]);
+        view_frustum.planes[4][0] /= t;
+        view_frustum.planes[4][1] /= t;
+        view_frustum.planes[4][2] /= t;
+        view_frustum.planes[4][3] /= t;
 
         /* Extract the NEAR plane */
-        frustum[5][0] = clip[0][3] + clip[0][2];
-        frustum[5][1] = clip[1][3] + clip[1][2];
-        frustum[5][2] = clip[2][3] + clip[2][2];
-        frustum[5][3] = clip[3][3] + clip[3][2];
+        view_frustum.planes[5][0] = clip[0][3] + clip[0][2];
+        view_frustum.planes[5][1] = clip[1][3] + clip[1][2];
+        view_frustum.planes[5][2] = clip[2][3] + clip[2][2];
+        view_frustum.planes[5][3] = clip[3][3] + clip[3][2];
 
         /* Normalize the result */
-        t = std::sqrt(frustum[5][0] * frustum[5][0] + frustum[5][1] * frustum[5][1] + frustum[5][2] * frustum[5][2]);
-        frustum[5][0] /= t;
-        frustum[5][1] /= t;
-        frustum[5][2] /= t;
-        frustum[5][3] /= t;
+        t = std::sqrt(view_frustum.planes[5][0] * view_frustum.planes[5][0] + view_frustum.planes[5][1] * view_frustum.planes[5][1] + view_frustum.planes[5][2] * view_frustum.planes[5][2]);
+        view_frustum.planes[5][0] /= t;
+        view_frustum.planes[5][1] /= t;
+        view_frustum.planes[5][2] /= t;
+        view_frustum.planes[5][3] /= t;
     }
 
     bool camera::has_object_in_frustum(aabb &bounding_box) {
@@ -137,24 +161,28 @@ namespace nova {
 
         for( p = 0; p < 6; p++ )
         {
-            if( frustum[p][0] * (x - xSize) + frustum[p][1] * (y - ySize) + frustum[p][2] * (z - zSize) + frustum[p][3] > 0 )
+            if( view_frustum.planes[p][0] * (x - xSize) + view_frustum.planes[p][1] * (y - ySize) + view_frustum.planes[p][2] * (z - zSize) + view_frustum.planes[p][3] > 0 )
                 continue;
-            if( frustum[p][0] * (x + xSize) + frustum[p][1] * (y - ySize) + frustum[p][2] * (z - zSize) + frustum[p][3] > 0 )
+            if( view_frustum.planes[p][0] * (x + xSize) + view_frustum.planes[p][1] * (y - ySize) + view_frustum.planes[p][2] * (z - zSize) + view_frustum.planes[p][3] > 0 )
                 continue;
-            if( frustum[p][0] * (x - xSize) + frustum[p][1] * (y + ySize) + frustum[p][2] * (z - zSize) + frustum[p][3] > 0 )
+            if( view_frustum.planes[p][0] * (x - xSize) + view_frustum.planes[p][1] * (y + ySize) + view_frustum.planes[p][2] * (z - zSize) + view_frustum.planes[p][3] > 0 )
                 continue;
-            if( frustum[p][0] * (x + xSize) + frustum[p][1] * (y + ySize) + frustum[p][2] * (z - zSize) + frustum[p][3] > 0 )
+            if( view_frustum.planes[p][0] * (x + xSize) + view_frustum.planes[p][1] * (y + ySize) + view_frustum.planes[p][2] * (z - zSize) + view_frustum.planes[p][3] > 0 )
                 continue;
-            if( frustum[p][0] * (x - xSize) + frustum[p][1] * (y - ySize) + frustum[p][2] * (z + zSize) + frustum[p][3] > 0 )
+            if( view_frustum.planes[p][0] * (x - xSize) + view_frustum.planes[p][1] * (y - ySize) + view_frustum.planes[p][2] * (z + zSize) + view_frustum.planes[p][3] > 0 )
                 continue;
-            if( frustum[p][0] * (x + xSize) + frustum[p][1] * (y - ySize) + frustum[p][2] * (z + zSize) + frustum[p][3] > 0 )
+            if( view_frustum.planes[p][0] * (x + xSize) + view_frustum.planes[p][1] * (y - ySize) + view_frustum.planes[p][2] * (z + zSize) + view_frustum.planes[p][3] > 0 )
                 continue;
-            if( frustum[p][0] * (x - xSize) + frustum[p][1] * (y + ySize) + frustum[p][2] * (z + zSize) + frustum[p][3] > 0 )
+            if( view_frustum.planes[p][0] * (x - xSize) + view_frustum.planes[p][1] * (y + ySize) + view_frustum.planes[p][2] * (z + zSize) + view_frustum.planes[p][3] > 0 )
                 continue;
-            if( frustum[p][0] * (x + xSize) + frustum[p][1] * (y + ySize) + frustum[p][2] * (z + zSize) + frustum[p][3] > 0 )
+            if( view_frustum.planes[p][0] * (x + xSize) + view_frustum.planes[p][1] * (y + ySize) + view_frustum.planes[p][2] * (z + zSize) + view_frustum.planes[p][3] > 0 )
                 continue;
             return false;
         }
         return true;
     }
+
+    const frustum& camera::get_frustum() const {
+        return view_frustum;
+    }
 }
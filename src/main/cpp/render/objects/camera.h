@@ -6,8 +6,10 @@
 #ifndef RENDERER_CAMERA_H
 #define RENDERER_CAMERA_H
 
+#include <cstdint>
 #include <glm/glm.hpp>
 #include "../../data_loading/physics/aabb.h"
+#include "../../data_loading/physics/frustum.h"
 
 namespace nova {
     /*!
@@ -24,20 +26,64 @@ namespace nova {
         glm::vec3 position;
 
         glm::mat4& get_projection_matrix();
-        glm::mat4 get_view_matrix();
+
+        /*!
+         * \brief Returns the view matrix for the current position and rotation
+         *
+         * The matrix is only recomputed when the position or rotation has changed since the last call, so everything
+         * that needs it in a frame shares one matrix
+         */
+        const glm::mat4& get_view_matrix();
 
         glm::vec3 get_view_direction();
 
+        /*!
+         * \brief Returns a number that changes whenever the view or projection matrix does
+         */
+        uint64_t get_version();
+
+        /*!
+         * \brief Recomputes the frustum planes, if the camera has changed since they were last computed
+         */
         void recalculate_frustum();
 
         bool has_object_in_frustum(aabb& bounding_box);
 
+        /*!
+         * \brief Returns the planes computed by the last call to recalculate_frustum
+         */
+        const frustum& get_frustum() const;
+
     private:
-        bool projection_matrix_is_dirty;
+        bool projection_matrix_is_dirty = true;
 
         glm::mat4 projection_matrix;
 
-        float frustum[6][4];
+        /*!
+         * \brief The position and rotation that view_matrix was made from
+         */
+        glm::vec3 view_matrix_position;
+        glm::vec2 view_matrix_rotation;
+        bool view_matrix_is_valid = false;
+
+        glm::mat4 view_matrix;
+
+        /*!
+         * \brief Just the rotation part of view_matrix
+         */
+        glm::mat4 rotation_matrix;
+
+        uint64_t version = 0;
+
+        frustum view_frustum;
+
+        /*!
+         * \brief The version the frustum planes were computed for
+         */
+        uint64_t frustum_version = 0;
+        bool frustum_is_valid = false;
+
+        void update_view_matrix();
     };
 }
 
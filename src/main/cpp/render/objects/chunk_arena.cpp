@@ -0,0 +1,319 @@
+/*!
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <cstring>
+#include <easylogging++.h>
+#include "chunk_arena.h"
+#include "frame_stats.h"
+#include "gl_state.h"
+#include "gpu_memory.h"
+#include "../windowing/glfw_gl_window.h"
+
+namespace nova {
+    bool chunk_arena_handle::is_valid() const {
+        return page >= 0 && num_indices > 0;
+    }
+
+    /*!
+     * \brief Writes #QUAD_INDEX_PATTERN for the given number of quads, starting at vertex 0
+     */
+    static void write_quad_indices(GLuint* destination, uint32_t num_quads) {
+        for(uint32_t quad = 0; quad < num_quads; quad++) {
+            for(int index : QUAD_INDEX_PATTERN) {
+                *destination++ = quad * 4 + static_cast<GLuint>(index);
+            }
+        }
+    }
+
+    static const uint32_t SHARED_QUAD_INDEX_SIZE = chunk_arena::MAX_SHARED_QUAD_VERTICES / 4 * 6 * sizeof(GLuint);
+
+    chunk_arena::~chunk_arena() {
+        if(glfwGetCurrentContext() == nullptr) {
+            return;
+        }
+
+        for(auto& fenced : frees_waiting_on_gpu) {
+            glDeleteSync(fenced.fence);
+        }
+
+        for(auto& vao : vaos) {
+            gl_state::delete_vertex_arrays(1, &vao.second);
+        }
+
+        for(auto& cur_page : pages) {
+            glUnmapNamedBuffer(cur_page.buffer);
+            gl_state::delete_buffers(1, &cur_page.buffer);
+        }
+    }
+
+    chunk_arena_handle chunk_arena::add_mesh(const mesh_definition& definition) {
+        return add_mesh(definition.vertex_data.data(), definition.vertex_data.size(),
+                        definition.indices.data(), definition.indices.size(),
+                        definition.vertex_format, definition.id);
+    }
+
+    chunk_arena_handle chunk_arena::add_mesh(const int* vertex_data, size_t vertex_data_size, const int* indices, size_t num_indices,
+                                             format vertex_format, int id) {
+        chunk_arena_handle handle = allocate_mesh(vertex_data_size, indices, num_indices, vertex_format, id);
+        if(handle.page >= 0) {
+            write_mesh(get_page_data(handle.page), handle, vertex_data, num_indices > 0 ? indices : nullptr);
+        }
+        return handle;
+    }
+
+    chunk_arena_handle chunk_arena::allocate_mesh(size_t vertex_data_size, const int* indices, size_t num_indices,
+                                                  format vertex_format, int id) {
+        chunk_arena_handle handle = {};
+        handle.vertex_format = vertex_format;
+
+        if(vertex_data_size == 0 || (num_indices == 0 && !is_quad_format(vertex_format))) {
+            return handle;
+        }
+
+        const GLsizei stride = get_vertex_stride(vertex_format);
+        const auto vertex_size = static_cast<uint32_t>(vertex_data_size * sizeof(int));
+
+        // Quads with no indices get the quad pattern, either the page's shared copy or one of their own if there are
+        // too many vertices for the shared one
+        const bool has_indices = num_indices > 0;
+        if(!has_indices) {
+            num_indices = vertex_size / static_cast<uint32_t>(stride) / 4 * 6;
+            if(num_indices == 0) {
+                return handle;
+            }
+        }
+        const bool is_quads = !has_indices || is_quad_index_list(indices, num_indices);
+        handle.uses_shared_quad_indices = is_quads && num_indices / 6 * 4 <= MAX_SHARED_QUAD_VERTICES;
+        const auto index_size = handle.uses_shared_quad_indices ? 0 : static_cast<uint32_t>(num_indices * sizeof(GLuint));
+
+        if(vertex_size + index_size + stride > PAGE_SIZE - SHARED_QUAD_INDEX_SIZE) {
+            LOG(ERROR) << "Mesh for chunk " << id << " needs " << vertex_size + index_size
+                       << " bytes, which is more than a whole arena page. It will not be drawn";
+            return handle;
+        }
+
+        int page_idx = -1;
+        for(int i = 0; i < pages.size(); i++) {
+            if(allocate_in_page(i, vertex_size, index_size, stride, handle)) {
+                page_idx = i;
+                break;
+            }
+        }
+
+        if(page_idx < 0) {
+            page_idx = create_page();
+            if(!allocate_in_page(page_idx, vertex_size, index_size, stride, handle)) {
+                LOG(ERROR) << "Could not allocate space for chunk " << id << " in a brand new arena page";
+                return handle;
+            }
+        }
+
+        frame_stats::count_upload(vertex_size + index_size);
+
+        handle.page = page_idx;
+        handle.num_indices = static_cast<unsigned int>(num_indices);
+        handle.base_vertex = handle.vertex_range.offset / stride;
+        bytes_in_use += get_size(handle);
+
+        return handle;
+    }
+
+    uint8_t* chunk_arena::get_page_data(int page_idx) const {
+        return static_cast<uint8_t*>(pages[page_idx].mapped_data);
+    }
+
+    void chunk_arena::write_mesh(uint8_t* page_data, const chunk_arena_handle& handle, const int* vertex_data, const int* indices) {
+        // The buffer is mapped coherently, so a memcpy is all it takes to get the data to the GPU
+        std::memcpy(page_data + handle.vertex_range.offset, vertex_data, handle.vertex_range.size);
+        if(handle.uses_shared_quad_indices) {
+            return;
+        }
+
+        if(indices != nullptr) {
+            std::memcpy(page_data + handle.index_range.offset, indices, handle.index_range.size);
+        } else {
+            auto* index_data = reinterpret_cast<GLuint*>(page_data + handle.index_range.offset);
+            write_quad_indices(index_data, handle.num_indices / 6);
+        }
+    }
+
+    void chunk_arena::set_newest_write(uint64_t ticket) {
+        newest_write_ticket = ticket;
+    }
+
+    bool chunk_arena::allocate_in_page(int page_idx, uint32_t vertex_size, uint32_t index_size, GLsizei stride, chunk_arena_handle& handle) {
+        auto& allocator = pages[page_idx].allocator;
+        if(allocator.get_bytes_free() < vertex_size + index_size) {
+            return false;
+        }
+
+        auto vertex_range = allocator.allocate(vertex_size, static_cast<uint32_t>(stride));
+        if(!vertex_range) {
+            return false;
+        }
+
+        if(index_size == 0) {
+            handle.vertex_range = *vertex_range;
+            handle.index_range = pages[page_idx].quad_indices;
+            return true;
+        }
+
+        auto index_range = allocator.allocate(index_size, sizeof(GLuint));
+        if(!index_range) {
+            allocator.free(*vertex_range);
+            return false;
+        }
+
+        handle.vertex_range = *vertex_range;
+        handle.index_range = *index_range;
+        return true;
+    }
+
+    int chunk_arena::create_page() {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        page new_page;
+        glCreateBuffers(1, &new_page.buffer);
+        glNamedBufferStorage(new_page.buffer, PAGE_SIZE, nullptr, flags);
+        gpu_memory::track_buffer(new_page.buffer, gpu_memory_category::chunk_arena, PAGE_SIZE);
+        new_page.mapped_data = glMapNamedBufferRange(new_page.buffer, 0, PAGE_SIZE, flags);
+
+        if(new_page.mapped_data == nullptr) {
+            LOG(FATAL) << "Could not map chunk arena page " << pages.size();
+        }
+
+        // The shared quad indices are the first thing in the page and stay for as long as the page does
+        new_page.quad_indices = *new_page.allocator.allocate(SHARED_QUAD_INDEX_SIZE, sizeof(GLuint));
+        auto* quad_index_data = static_cast<uint8_t*>(new_page.mapped_data) + new_page.quad_indices.offset;
+        write_quad_indices(reinterpret_cast<GLuint*>(quad_index_data), MAX_SHARED_QUAD_VERTICES / 4);
+        frame_stats::count_upload(SHARED_QUAD_INDEX_SIZE);
+
+        LOG(INFO) << "Created chunk arena page " << pages.size();
+
+        pages.push_back(std::move(new_page));
+        return static_cast<int>(pages.size() - 1);
+    }
+
+    void chunk_arena::free_mesh(chunk_arena_handle& handle) {
+        if(handle.page < 0) {
+            return;
+        }
+
+        frees_this_frame.push_back({handle.page, handle.vertex_range});
+        if(!handle.uses_shared_quad_indices) {
+            frees_this_frame.push_back({handle.page, handle.index_range});
+        }
+        bytes_in_use -= get_size(handle);
+
+        handle = {};
+    }
+
+    void chunk_arena::begin_frame(uint64_t completed_write) {
+        // Anything freed since the last frame may still be read by draws the GPU hasn't finished, or written by the
+        // upload thread, so fence it off
+        if(!frees_this_frame.empty()) {
+            fenced_frees fenced;
+            fenced.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            fenced.write_ticket = newest_write_ticket;
+            fenced.ranges = std::move(frees_this_frame);
+            frees_waiting_on_gpu.push_back(std::move(fenced));
+            frees_this_frame.clear();
+        }
+
+        // Fences are signaled and uploads finish in order, so we can stop at the first one that hasn't passed
+        auto fenced_itr = frees_waiting_on_gpu.begin();
+        for(; fenced_itr != frees_waiting_on_gpu.end(); ++fenced_itr) {
+            if(fenced_itr->write_ticket > completed_write) {
+                break;
+            }
+
+            GLenum status = glClientWaitSync(fenced_itr->fence, 0, 0);
+            if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+                break;
+            }
+
+            for(const auto& range : fenced_itr->ranges) {
+                pages[range.page].allocator.free(range.range);
+            }
+            glDeleteSync(fenced_itr->fence);
+        }
+        frees_waiting_on_gpu.erase(frees_waiting_on_gpu.begin(), fenced_itr);
+    }
+
+    void chunk_arena::draw(const chunk_arena_handle& handle, GLuint base_instance) {
+        bind_page(handle.vertex_format, handle.page);
+        glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, handle.num_indices, GL_UNSIGNED_INT,
+                                                      reinterpret_cast<void*>(static_cast<uintptr_t>(handle.index_range.offset)),
+                                                      1, handle.base_vertex, base_instance);
+        frame_stats::count_draw(handle.num_indices / 3);
+    }
+
+    uint64_t chunk_arena::get_bytes_in_use() const {
+        return bytes_in_use;
+    }
+
+    uint64_t chunk_arena::get_size(const chunk_arena_handle& handle) {
+        if(handle.page < 0) {
+            return 0;
+        }
+        if(handle.uses_shared_quad_indices) {
+            return handle.vertex_range.size;
+        }
+        return handle.vertex_range.size + handle.index_range.size;
+    }
+
+    void chunk_arena::release_empty_pages() {
+        // Ranges that are waiting on a fence are still allocated, so a page with nothing but its quad indices has
+        // nothing pending
+        while(!pages.empty() && pages.back().allocator.get_bytes_free() + pages.back().quad_indices.size == PAGE_SIZE) {
+            const int page_idx = static_cast<int>(pages.size() - 1);
+            // A VAO that still points at the buffer would keep it alive
+            for(auto& bound_page : page_bound_to_vao) {
+                if(bound_page.second == page_idx) {
+                    const GLuint vao = vaos[bound_page.first];
+                    glVertexArrayVertexBuffer(vao, 0, 0, 0, get_vertex_stride(format(bound_page.first)));
+                    glVertexArrayElementBuffer(vao, 0);
+                    bound_page.second = -1;
+                }
+            }
+
+            glUnmapNamedBuffer(pages.back().buffer);
+            gl_state::delete_buffers(1, &pages.back().buffer);
+            pages.pop_back();
+
+            LOG(INFO) << "Released chunk arena page " << page_idx;
+        }
+    }
+
+    void chunk_arena::bind_page(format vertex_format, int page_idx) {
+        GLuint vao = get_vao_for_format(vertex_format);
+
+        auto& bound_page = page_bound_to_vao[vertex_format];
+        if(bound_page != page_idx) {
+            GLuint buffer = pages[page_idx].buffer;
+            glVertexArrayVertexBuffer(vao, 0, buffer, 0, get_vertex_stride(vertex_format));
+            glVertexArrayElementBuffer(vao, buffer);
+            bound_page = page_idx;
+        }
+
+        gl_state::bind_vertex_array(vao);
+    }
+
+    GLuint chunk_arena::get_vao_for_format(format vertex_format) {
+        auto vao_itr = vaos.find(vertex_format);
+        if(vao_itr != vaos.end()) {
+            return vao_itr->second;
+        }
+
+        GLuint vao;
+        glCreateVertexArrays(1, &vao);
+        set_vertex_attributes(vao, vertex_format, 0);
+
+        vaos[vertex_format] = vao;
+        page_bound_to_vao[vertex_format] = -1;
+
+        return vao;
+    }
+}
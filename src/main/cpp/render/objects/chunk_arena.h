@@ -0,0 +1,238 @@
+/*!
+ * \brief Holds the geometry for every chunk in a handful of big persistently mapped buffers
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_CHUNK_ARENA_H
+#define RENDERER_CHUNK_ARENA_H
+
+#include <glad/glad.h>
+#include <vector>
+#include <unordered_map>
+#include "../../geometry_cache/mesh_definition.h"
+#include "../../geometry_cache/free_list_allocator.h"
+#include "vertex_formats.h"
+
+namespace nova {
+    /*!
+     * \brief Tells a render_object where its geometry lives in the chunk arena
+     */
+    struct chunk_arena_handle {
+        int page = -1;                  //!< The index of the arena page that holds the geometry, or -1 for no geometry
+        allocation vertex_range;        //!< Where, in the page buffer, the vertices live
+        allocation index_range;         //!< Where, in the page buffer, the indices live
+        unsigned int num_indices = 0;
+        unsigned int base_vertex = 0;   //!< The vertex_range's offset measured in vertices rather than bytes
+        bool uses_shared_quad_indices = false;  //!< If true, index_range is the page's quad indices and isn't ours to free
+        format vertex_format;
+
+        bool is_valid() const;
+    };
+
+    /*!
+     * \brief Allocates space for chunk geometry out of a few large GL buffers
+     *
+     * Making a VAO, VBO, and IBO for every chunk section leaves us with tens of thousands of GL objects, and we rebind
+     * all of them for every draw. Instead, the arena hands out ranges of large buffers that are mapped for the whole
+     * life of the program. Chunk data is memcpy'd straight into the mapped range, and there's one VAO for each vertex
+     * format, so drawing a chunk only rebinds things when it lives in a different page than the last chunk
+     *
+     * Vertices and indices share a page. Vertex ranges are aligned to the vertex stride so that the base vertex can be
+     * passed to glDrawElementsBaseVertex and the chunk's indices don't need to be rewritten
+     *
+     * Chunk geometry is almost all quads split the same way, so every page starts with #QUAD_INDEX_PATTERN repeated
+     * for #MAX_SHARED_QUAD_VERTICES vertices. Meshes in a quad format with no indices, or whose indices are just that
+     * pattern, draw from the shared copy and take up no index space of their own
+     *
+     * The GPU may still be reading from a range when we free it, so freed ranges wait on a fence before they go back
+     * to the allocator
+     */
+    class chunk_arena {
+    public:
+        /*!
+         * \brief The size, in bytes, of each page. New pages are created whenever the existing ones fill up
+         */
+        static const uint32_t PAGE_SIZE = 64 * 1024 * 1024;
+
+        /*!
+         * \brief How many vertices each page's shared quad indices cover. Bigger quad meshes get indices of their own
+         */
+        static const uint32_t MAX_SHARED_QUAD_VERTICES = 65536;
+
+        chunk_arena() = default;
+
+        chunk_arena(const chunk_arena&) = delete;
+        chunk_arena& operator=(const chunk_arena&) = delete;
+
+        ~chunk_arena();
+
+        /*!
+         * \brief Copies the given mesh into the arena
+         *
+         * \param definition The mesh to copy
+         * \return A handle to the mesh's geometry. The handle will be invalid if the mesh was empty or too large to
+         * fit in a page
+         */
+        chunk_arena_handle add_mesh(const mesh_definition& definition);
+
+        /*!
+         * \brief Copies the given raw vertex and index data into the arena
+         *
+         * This is what add_mesh(const mesh_definition&) uses. It's exposed so data that's already in its final layout,
+         * such as a Java direct buffer, can be copied into the arena without going through a mesh_definition
+         *
+         * \param vertex_data The vertex data, already in the layout for the given format
+         * \param vertex_data_size The number of ints in vertex_data
+         * \param indices The indices
+         * \param num_indices The number of indices. May be 0 for quad formats, see is_quad_format
+         * \param vertex_format The format of vertex_data
+         * \param id The id of the chunk, for log messages
+         */
+        chunk_arena_handle add_mesh(const int* vertex_data, size_t vertex_data_size, const int* indices, size_t num_indices,
+                                    format vertex_format, int id);
+
+        /*!
+         * \brief Finds space for a mesh without copying anything into it. #write_mesh fills it in
+         *
+         * The parameters are the same as add_mesh's. The indices are only read to see if they're the quad pattern
+         */
+        chunk_arena_handle allocate_mesh(size_t vertex_data_size, const int* indices, size_t num_indices,
+                                         format vertex_format, int id);
+
+        /*!
+         * \brief Where the given page's buffer is mapped. Stays valid for as long as the page has meshes in it
+         */
+        uint8_t* get_page_data(int page_idx) const;
+
+        /*!
+         * \brief Copies a mesh into the space #allocate_mesh found for it
+         *
+         * Only touches the handle's ranges, so it can run on any thread as long as the arena knows about it through
+         * #set_newest_write
+         *
+         * \param page_data What #get_page_data returned for the handle's page
+         * \param handle The handle from allocate_mesh
+         * \param vertex_data The vertex data
+         * \param indices The indices, or nullptr if the mesh had none and should get the quad pattern
+         */
+        static void write_mesh(uint8_t* page_data, const chunk_arena_handle& handle, const int* vertex_data, const int* indices);
+
+        /*!
+         * \brief Tells the arena that meshes up to the given upload ticket may still be being written on another
+         * thread. Anything freed from now on isn't reused until that ticket is complete
+         */
+        void set_newest_write(uint64_t ticket);
+
+        /*!
+         * \brief Releases the space used by the given handle, once the GPU is done with it
+         *
+         * \param handle The handle to free. It's reset to an invalid handle
+         */
+        void free_mesh(chunk_arena_handle& handle);
+
+        /*!
+         * \brief Fences off everything freed since the last call and returns the ranges whose fences have passed to
+         * their allocators
+         *
+         * Should be called once per frame
+         *
+         * \param completed_write The newest upload ticket whose writes have finished. See #set_newest_write
+         */
+        void begin_frame(uint64_t completed_write = 0);
+
+        /*!
+         * \brief Binds the VAO for the handle's format, pointing it at the handle's page if needed, and draws the
+         * handle's geometry
+         *
+         * \param handle The geometry to draw
+         * \param base_instance The base instance of the draw, which is how shaders find the object's slot in the
+         * object data buffer
+         */
+        void draw(const chunk_arena_handle& handle, GLuint base_instance = 0);
+
+        /*!
+         * \brief Binds the VAO for the given format and points it at the given page's buffer
+         *
+         * After this, any geometry from that page and format can be drawn with base vertex/first index draws
+         */
+        void bind_page(format vertex_format, int page_idx);
+
+        /*!
+         * \brief How many bytes of the arena's pages are handed out to meshes. Freed meshes stop counting right away,
+         * even though their space can't be reused until the GPU is done with it
+         */
+        uint64_t get_bytes_in_use() const;
+
+        /*!
+         * \brief How many bytes the meshes for the given handle take up
+         */
+        static uint64_t get_size(const chunk_arena_handle& handle);
+
+        /*!
+         * \brief Deletes the pages at the end of the list that have nothing in them, to give their memory back
+         *
+         * Handles point to pages by index, so pages in the middle of the list have to stay even if they're empty
+         */
+        void release_empty_pages();
+
+    private:
+        struct page {
+            GLuint buffer = 0;
+            void* mapped_data = nullptr;
+            free_list_allocator allocator{PAGE_SIZE};
+            allocation quad_indices;    //!< #QUAD_INDEX_PATTERN for #MAX_SHARED_QUAD_VERTICES vertices
+        };
+
+        struct pending_free {
+            int page;
+            allocation range;
+        };
+
+        struct fenced_frees {
+            GLsync fence;
+            uint64_t write_ticket;  //!< The ranges can't be reused until this upload ticket is complete either
+            std::vector<pending_free> ranges;
+        };
+
+        std::vector<page> pages;
+
+        uint64_t bytes_in_use = 0;
+
+        uint64_t newest_write_ticket = 0;
+
+        /*!
+         * \brief Ranges freed since the last call to begin_frame
+         */
+        std::vector<pending_free> frees_this_frame;
+
+        /*!
+         * \brief Ranges that will be usable once their fence is signaled
+         */
+        std::vector<fenced_frees> frees_waiting_on_gpu;
+
+        /*!
+         * \brief One VAO for each vertex format
+         */
+        std::unordered_map<int, GLuint> vaos;
+
+        /*!
+         * \brief The page that each VAO is currently reading from, so we only rebind buffers when the page changes
+         */
+        std::unordered_map<int, int> page_bound_to_vao;
+
+        /*!
+         * \brief Tries to allocate the vertex and index space for the given definition in the given page
+         *
+         * \return True if both ranges could be allocated, false otherwise
+         */
+        bool allocate_in_page(int page_idx, uint32_t vertex_size, uint32_t index_size, GLsizei stride, chunk_arena_handle& handle);
+
+        int create_page();
+
+        GLuint get_vao_for_format(format vertex_format);
+    };
+}
+
+#endif //RENDERER_CHUNK_ARENA_H
@@ -0,0 +1,214 @@
+/*!
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <algorithm>
+#include "chunk_draw_batch.h"
+#include "frame_stats.h"
+#include "gpu_memory.h"
+#include "gl_state.h"
+#include "../windowing/glfw_gl_window.h"
+
+namespace nova {
+    chunk_draw_batch::~chunk_draw_batch() {
+        if(command_buffer != 0 && glfwGetCurrentContext() != nullptr) {
+            gl_state::delete_buffers(1, &command_buffer);
+            gl_state::delete_buffers(1, &chunk_offset_buffer);
+            gl_state::delete_buffers(1, &bounds_buffer);
+        }
+    }
+
+    void chunk_draw_batch::clear() {
+        for(auto& group : groups) {
+            group.second.commands.clear();
+            group.second.chunk_offsets.clear();
+            group.second.bounds.clear();
+        }
+        num_ordered_runs = 0;
+        num_draws = 0;
+        all_draws_have_object_slots = true;
+        max_object_slot = 0;
+    }
+
+    void chunk_draw_batch::add(const chunk_arena_handle& handle, const glm::vec3& position, uint32_t object_slot, const aabb& bounding_box) {
+        const group_key key(static_cast<int>(handle.vertex_format), handle.page);
+        draw_group* group_ptr;
+        if(keep_order) {
+            if(num_ordered_runs == 0 || ordered_runs[num_ordered_runs - 1].first != key) {
+                if(num_ordered_runs == ordered_runs.size()) {
+                    ordered_runs.emplace_back();
+                }
+
+                auto& run = ordered_runs[num_ordered_runs];
+                run.first = key;
+                run.second.commands.clear();
+                run.second.chunk_offsets.clear();
+                run.second.bounds.clear();
+                num_ordered_runs++;
+            }
+            group_ptr = &ordered_runs[num_ordered_runs - 1].second;
+
+        } else {
+            group_ptr = &groups[key];
+        }
+        auto& group = *group_ptr;
+
+        draw_elements_indirect_command command = {};
+        command.count = handle.num_indices;
+        command.instance_count = 1;
+        command.first_index = handle.index_range.offset / sizeof(GLuint);
+        command.base_vertex = static_cast<GLint>(handle.base_vertex);
+        command.base_instance = object_slot == object_data_buffer::NO_OBJECT ? 0 : object_slot;
+
+        group.commands.push_back(command);
+        // The w component tells the shader whether it needs to unpack the vertices
+        const bool is_packed = handle.vertex_format == format::PACKED_POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT;
+        group.chunk_offsets.emplace_back(position, is_packed ? 1.0f : 0.0f);
+        group.bounds.emplace_back(bounding_box.center, 0.0f);
+        group.bounds.emplace_back(bounding_box.extents, 0.0f);
+        num_draws++;
+
+        if(object_slot == object_data_buffer::NO_OBJECT) {
+            all_draws_have_object_slots = false;
+        } else {
+            max_object_slot = std::max(max_object_slot, object_slot);
+        }
+    }
+
+    bool chunk_draw_batch::empty() const {
+        return num_draws == 0;
+    }
+
+    void chunk_draw_batch::set_keep_order(bool keep_order) {
+        this->keep_order = keep_order;
+    }
+
+    void chunk_draw_batch::create_buffers() {
+        glCreateBuffers(1, &command_buffer);
+        glCreateBuffers(1, &chunk_offset_buffer);
+        glCreateBuffers(1, &bounds_buffer);
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storage_buffer_alignment);
+    }
+
+    void chunk_draw_batch::submit(chunk_arena& arena, bool use_chunk_offsets, occlusion_culler* culler, GLuint draw_program,
+                                  bool visibility_is_current) {
+        if(empty()) {
+            return;
+        }
+
+        if(command_buffer == 0) {
+            create_buffers();
+        }
+
+        // Pack every group into one command buffer and one offset buffer. Each group's offsets have to start on an
+        // SSBO alignment boundary so we can bind just that group's range and index it with gl_DrawIDARB
+        const auto offsets_per_alignment = static_cast<size_t>(std::max(1, storage_buffer_alignment / static_cast<GLint>(sizeof(glm::vec4))));
+
+        const bool cull_occluded = culler != nullptr && culler->is_enabled() && all_draws_have_object_slots;
+
+        draw_list.clear();
+        if(keep_order) {
+            for(size_t i = 0; i < num_ordered_runs; i++) {
+                draw_list.emplace_back(ordered_runs[i].first, &ordered_runs[i].second);
+            }
+        } else {
+            for(const auto& group : groups) {
+                draw_list.emplace_back(group.first, &group.second);
+            }
+        }
+
+        all_commands.clear();
+        all_chunk_offsets.clear();
+        all_bounds.clear();
+        uint64_t num_indices = 0;
+        for(const auto& group : draw_list) {
+            all_commands.insert(all_commands.end(), group.second->commands.begin(), group.second->commands.end());
+            for(const auto& command : group.second->commands) {
+                num_indices += command.count;
+            }
+            if(cull_occluded) {
+                all_bounds.insert(all_bounds.end(), group.second->bounds.begin(), group.second->bounds.end());
+            }
+
+            while(all_chunk_offsets.size() % offsets_per_alignment != 0) {
+                all_chunk_offsets.emplace_back(0);
+            }
+            all_chunk_offsets.insert(all_chunk_offsets.end(), group.second->chunk_offsets.begin(), group.second->chunk_offsets.end());
+        }
+
+        // Respecifying the buffers each frame lets the driver hand us fresh storage instead of waiting for last frame's
+        // draws to finish with the old data
+        glNamedBufferData(command_buffer, all_commands.size() * sizeof(draw_elements_indirect_command), all_commands.data(), GL_STREAM_DRAW);
+        frame_stats::count_upload(all_commands.size() * sizeof(draw_elements_indirect_command));
+        gpu_memory::track_buffer(command_buffer, gpu_memory_category::buffers, all_commands.size() * sizeof(draw_elements_indirect_command));
+        if(use_chunk_offsets) {
+            glNamedBufferData(chunk_offset_buffer, all_chunk_offsets.size() * sizeof(glm::vec4), all_chunk_offsets.data(), GL_STREAM_DRAW);
+            frame_stats::count_upload(all_chunk_offsets.size() * sizeof(glm::vec4));
+            gpu_memory::track_buffer(chunk_offset_buffer, gpu_memory_category::buffers, all_chunk_offsets.size() * sizeof(glm::vec4));
+        }
+
+        // Occlusion culling submits the commands twice, but the second time only draws what the first didn't
+        frame_stats::count_triangles(num_indices / 3);
+
+        if(!cull_occluded) {
+            draw_groups(arena, use_chunk_offsets);
+            return;
+        }
+
+        glNamedBufferData(bounds_buffer, all_bounds.size() * sizeof(glm::vec4), all_bounds.data(), GL_STREAM_DRAW);
+        frame_stats::count_upload(all_bounds.size() * sizeof(glm::vec4));
+        gpu_memory::track_buffer(bounds_buffer, gpu_memory_category::buffers, all_bounds.size() * sizeof(glm::vec4));
+        const auto num_commands = static_cast<GLuint>(all_commands.size());
+        culler->reserve_objects(max_object_slot + 1);
+
+        // Phase 1: whatever was visible last frame
+        culler->keep_last_frames_visible(command_buffer, num_commands);
+        gl_state::use_program(draw_program);
+        draw_groups(arena, use_chunk_offsets);
+        if(!culler->is_enabled() || visibility_is_current) {
+            // Either the culler's shaders didn't build, so phase 1 drew everything, or phase 2 already ran this frame
+            return;
+        }
+
+        // Phase 2: whatever is visible now but wasn't drawn in phase 1
+        culler->build_hi_z();
+        culler->cull_against_hi_z(command_buffer, bounds_buffer, num_commands);
+        gl_state::use_program(draw_program);
+        draw_groups(arena, use_chunk_offsets);
+    }
+
+    void chunk_draw_batch::draw_groups(chunk_arena& arena, bool use_chunk_offsets) {
+        const auto offsets_per_alignment = static_cast<size_t>(std::max(1, storage_buffer_alignment / static_cast<GLint>(sizeof(glm::vec4))));
+
+        gl_state::bind_buffer(GL_DRAW_INDIRECT_BUFFER, command_buffer);
+
+        size_t command_start = 0;
+        size_t offset_start = 0;
+        for(const auto& group : draw_list) {
+            const auto num_commands = group.second->commands.size();
+            if(num_commands == 0) {
+                continue;
+            }
+
+            while(offset_start % offsets_per_alignment != 0) {
+                offset_start++;
+            }
+
+            arena.bind_page(group.first.first, group.first.second);
+            if(use_chunk_offsets) {
+                gl_state::bind_buffer_range(GL_SHADER_STORAGE_BUFFER, CHUNK_OFFSETS_BINDING, chunk_offset_buffer,
+                                            offset_start * sizeof(glm::vec4), num_commands * sizeof(glm::vec4));
+            }
+            glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                                        reinterpret_cast<void*>(command_start * sizeof(draw_elements_indirect_command)),
+                                        static_cast<GLsizei>(num_commands), 0);
+            frame_stats::count_multi_draw(num_commands);
+
+            command_start += num_commands;
+            offset_start += num_commands;
+        }
+
+        gl_state::bind_buffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+}
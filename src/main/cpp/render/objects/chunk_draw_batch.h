@@ -0,0 +1,162 @@
+/*!
+ * \brief Collects chunk draws so they can be submitted with glMultiDrawElementsIndirect
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_CHUNK_DRAW_BATCH_H
+#define RENDERER_CHUNK_DRAW_BATCH_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <map>
+#include <utility>
+#include <vector>
+#include "chunk_arena.h"
+#include "object_data_buffer.h"
+#include "occlusion_culler.h"
+#include "../../data_loading/physics/aabb.h"
+
+namespace nova {
+    /*!
+     * \brief The layout OpenGL expects for each command in a GL_DRAW_INDIRECT_BUFFER
+     */
+    struct draw_elements_indirect_command {
+        GLuint count;
+        GLuint instance_count;
+        GLuint first_index;
+        GLint base_vertex;
+        GLuint base_instance;
+    };
+
+    /*!
+     * \brief Builds the indirect commands and per-draw chunk offsets for all the arena geometry drawn by one shader
+     *
+     * Shaders that declare a shader storage block named `chunk_offsets` at binding CHUNK_OFFSETS_BINDING get their
+     * chunks drawn through this batch. The block holds one vec4 per draw, and the shader reads its chunk's position
+     * with `chunk_offset[gl_DrawIDARB].xyz` instead of using the gbufferModel uniform. The w component is 1 if the
+     * chunk uses the packed vertex format, and 0 otherwise
+     *
+     * Each command's base instance is the chunk's slot in the object data buffer, so shaders that read the
+     * `object_data` block instead find their chunk with `object_data[gl_BaseInstanceARB]`. Those shaders don't need
+     * the chunk offsets, so they aren't uploaded for them
+     *
+     * Draws are grouped by arena page and vertex format, since those decide which VAO and buffers are bound, and each
+     * group is submitted with one glMultiDrawElementsIndirect call. With an occlusion_culler, every group is submitted
+     * twice, once for each of the culler's phases
+     *
+     * Batches for transparent geometry can keep their draws in the order they were added instead. Then a new group is
+     * started whenever the page or format changes, so there are more multi-draws, but blending still happens back to
+     * front
+     */
+    class chunk_draw_batch {
+    public:
+        /*!
+         * \brief The SSBO binding point that the chunk offsets are bound to
+         */
+        static const GLuint CHUNK_OFFSETS_BINDING = 0;
+
+        chunk_draw_batch() = default;
+
+        chunk_draw_batch(const chunk_draw_batch&) = delete;
+        chunk_draw_batch& operator=(const chunk_draw_batch&) = delete;
+
+        ~chunk_draw_batch();
+
+        /*!
+         * \brief Removes all the draws from this batch, but keeps the memory around for next frame
+         */
+        void clear();
+
+        /*!
+         * \brief Adds a draw of the given arena geometry, translated to the given position
+         *
+         * \param handle The geometry to draw
+         * \param position The chunk's position, for the chunk offsets
+         * \param object_slot The chunk's slot in the object data buffer
+         * \param bounding_box The chunk's bounding box, for occlusion culling
+         */
+        void add(const chunk_arena_handle& handle, const glm::vec3& position, uint32_t object_slot, const aabb& bounding_box);
+
+        bool empty() const;
+
+        /*!
+         * \brief If true, the draws are submitted in the order they were added. Must be set while the batch is empty
+         */
+        void set_keep_order(bool keep_order);
+
+        /*!
+         * \brief Uploads the commands and chunk offsets, then issues one multi-draw for each page and format
+         *
+         * \param arena The arena that all the handles in this batch came from
+         * \param use_chunk_offsets If false, the shader reads the object data buffer, so the chunk offsets aren't
+         * uploaded or bound
+         * \param culler The culler to hide occluded chunks with, or nullptr to draw everything. It's only used if it's
+         * enabled and every draw in the batch has an object data slot
+         * \param draw_program The program to draw with. The culler binds its own programs, so this is bound again before
+         * each phase's draws
+         * \param visibility_is_current If true, the same chunks were already drawn with the culler this frame, like in a
+         * depth pre-pass, so its visibility flags are already this frame's. Then only phase 1 runs
+         */
+        void submit(chunk_arena& arena, bool use_chunk_offsets, occlusion_culler* culler = nullptr, GLuint draw_program = 0,
+                    bool visibility_is_current = false);
+
+    private:
+        struct draw_group {
+            std::vector<draw_elements_indirect_command> commands;
+            std::vector<glm::vec4> chunk_offsets;
+
+            /*!
+             * \brief The center and then the extents of each draw's bounding box
+             */
+            std::vector<glm::vec4> bounds;
+        };
+
+        typedef std::pair<int, int> group_key;
+
+        /*!
+         * \brief All the draws, grouped by (vertex format, arena page)
+         */
+        std::map<group_key, draw_group> groups;
+
+        /*!
+         * \brief When keeping order, each run of draws that share a vertex format and arena page, in the order they
+         * were added. Only the first num_ordered_runs are in use, the rest are kept for their memory
+         */
+        std::vector<std::pair<group_key, draw_group>> ordered_runs;
+        size_t num_ordered_runs = 0;
+        bool keep_order = false;
+
+        /*!
+         * \brief The groups or runs that submit uploads and draws, in the order it draws them
+         */
+        std::vector<std::pair<group_key, const draw_group*>> draw_list;
+
+        unsigned int num_draws = 0;
+
+        std::vector<draw_elements_indirect_command> all_commands;
+        std::vector<glm::vec4> all_chunk_offsets;
+        std::vector<glm::vec4> all_bounds;
+
+        /*!
+         * \brief If false, at least one draw has no object data slot, so there's nowhere to keep its visibility
+         */
+        bool all_draws_have_object_slots = true;
+        uint32_t max_object_slot = 0;
+
+        GLuint command_buffer = 0;
+        GLuint chunk_offset_buffer = 0;
+        GLuint bounds_buffer = 0;
+        GLint storage_buffer_alignment = 0;
+
+        void create_buffers();
+
+        /*!
+         * \brief Issues one multi-draw for each group, using the commands and offsets that were uploaded by submit
+         */
+        void draw_groups(chunk_arena& arena, bool use_chunk_offsets);
+    };
+}
+
+#endif //RENDERER_CHUNK_DRAW_BATCH_H
@@ -0,0 +1,289 @@
+/*!
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <easylogging++.h>
+#include <GLFW/glfw3.h>
+#include "clustered_lights.h"
+#include "gl_state.h"
+#include "gpu_memory.h"
+#include "../../geometry_cache/greedy_mesher.h"
+
+namespace nova {
+    /*!
+     * \brief The start of the block_lights block, before the array of lights
+     */
+    struct block_lights_header {
+        glm::uvec4 grid_size;
+        glm::vec4 grid_depth;
+    };
+
+    clustered_lights::~clustered_lights() {
+        if(glfwGetCurrentContext() == nullptr) {
+            return;
+        }
+
+        if(lights_buffer != 0) {
+            gl_state::delete_buffers(1, &lights_buffer);
+            gl_state::delete_buffers(1, &clusters_buffer);
+        }
+    }
+
+    void clustered_lights::set_block_light_value(int block_id, int light_value) {
+        if(block_id < 0 || block_id > UINT16_MAX) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(lights_lock);
+        const auto id = static_cast<size_t>(block_id);
+        if(id >= light_values.size()) {
+            light_values.resize(id + 1);
+        }
+        light_values[id] = static_cast<uint8_t>(std::min(std::max(light_value, 0), 15));
+    }
+
+    void clustered_lights::add_section(const mc_chunk_section_blocks& section) {
+        const glm::vec3 position(section.x, section.y, section.z);
+        const chunk_key key(position, section.id);
+
+        std::lock_guard<std::mutex> lock(lights_lock);
+        std::vector<block_light> lights;
+        find_section_lights(section.block_ids, light_values, position, lights);
+
+        if(lights.empty()) {
+            lights_changed |= section_lights.erase(key) > 0;
+        } else {
+            section_lights[key] = std::move(lights);
+            lights_changed = true;
+        }
+    }
+
+    void clustered_lights::remove_section(const glm::vec3& position, int id) {
+        std::lock_guard<std::mutex> lock(lights_lock);
+        lights_changed |= section_lights.erase(chunk_key(position, id)) > 0;
+    }
+
+    void clustered_lights::set_max_distance(float distance) {
+        std::lock_guard<std::mutex> lock(lights_lock);
+        max_distance = std::max(distance, 1.0f);
+    }
+
+    void clustered_lights::update(camera& player_camera) {
+        float distance;
+        {
+            std::lock_guard<std::mutex> lock(lights_lock);
+            if(lights_changed) {
+                all_lights.clear();
+                for(const auto& section : section_lights) {
+                    all_lights.insert(all_lights.end(), section.second.begin(), section.second.end());
+                }
+                lights_changed = false;
+            }
+            distance = max_distance;
+        }
+
+        if(lights_buffer == 0) {
+            create_gl_objects();
+        }
+
+        const glm::mat4& view = player_camera.get_view_matrix();
+        const glm::mat4& projection = player_camera.get_projection_matrix();
+        const glm::vec2 projection_scale(projection[0][0], projection[1][1]);
+        const glm::vec4 depth_slicing = get_depth_slicing(player_camera.near_plane, distance);
+
+        candidates.clear();
+        for(const auto& light : all_lights) {
+            const glm::vec3 offset = light.position - player_camera.position;
+            const float reach = distance + light.light_value;
+            const float distance_squared = glm::dot(offset, offset);
+            if(distance_squared > reach * reach) {
+                continue;
+            }
+
+            const glm::vec4 view_position = view * glm::vec4(light.position, 1);
+            light_candidate candidate;
+            candidate.distance_squared = distance_squared;
+            candidate.data.view_position_radius = glm::vec4(glm::vec3(view_position), static_cast<float>(light.light_value));
+            candidate.data.info = glm::uvec4(light.block_id, light.light_value, 0, 0);
+            candidates.push_back(candidate);
+        }
+
+        // The closest lights are the ones that matter most, so they're the ones that are kept when there's too many
+        std::sort(candidates.begin(), candidates.end(), [](const light_candidate& a, const light_candidate& b) {
+            return a.distance_squared < b.distance_squared;
+        });
+
+        visible_lights.clear();
+        visible_ranges.clear();
+        for(const auto& candidate : candidates) {
+            if(visible_lights.size() == MAX_LIGHTS) {
+                break;
+            }
+
+            light_cluster_range range;
+            if(get_cluster_range(candidate.data.view_position_radius, projection_scale, depth_slicing, range)) {
+                visible_lights.push_back(candidate.data);
+                visible_ranges.push_back(range);
+            }
+        }
+
+        bin_lights(visible_ranges, cluster_data);
+
+        block_lights_header header;
+        header.grid_size = glm::uvec4(CLUSTER_COLUMNS, CLUSTER_ROWS, CLUSTER_SLICES, static_cast<uint32_t>(visible_lights.size()));
+        header.grid_depth = depth_slicing;
+        glNamedBufferSubData(lights_buffer, 0, sizeof(header), &header);
+        if(!visible_lights.empty()) {
+            glNamedBufferSubData(lights_buffer, sizeof(header), static_cast<GLsizeiptr>(visible_lights.size() * sizeof(block_light_data)),
+                                 visible_lights.data());
+        }
+        glNamedBufferSubData(clusters_buffer, 0, static_cast<GLsizeiptr>(cluster_data.size() * sizeof(uint32_t)), cluster_data.data());
+    }
+
+    void clustered_lights::bind() {
+        if(lights_buffer == 0) {
+            return;
+        }
+
+        gl_state::bind_buffer_range(GL_SHADER_STORAGE_BUFFER, BLOCK_LIGHTS_BINDING, lights_buffer, 0, lights_size);
+        gl_state::bind_buffer_range(GL_SHADER_STORAGE_BUFFER, LIGHT_CLUSTERS_BINDING, clusters_buffer, 0, clusters_size);
+    }
+
+    uint32_t clustered_lights::get_num_visible_lights() const {
+        return static_cast<uint32_t>(visible_lights.size());
+    }
+
+    void clustered_lights::find_section_lights(const uint16_t* block_ids, const std::vector<uint8_t>& light_values,
+                                               const glm::vec3& section_position, std::vector<block_light>& lights) {
+        if(light_values.empty()) {
+            return;
+        }
+
+        for(int y = 1; y <= SECTION_SIZE; y++) {
+            for(int z = 1; z <= SECTION_SIZE; z++) {
+                const int row = (y * PADDED_SECTION_SIZE + z) * PADDED_SECTION_SIZE;
+                for(int x = 1; x <= SECTION_SIZE; x++) {
+                    const uint16_t block_id = block_ids[row + x];
+                    if(block_id >= light_values.size() || light_values[block_id] == 0) {
+                        continue;
+                    }
+
+                    block_light light;
+                    light.position = section_position + glm::vec3(x - 0.5f, y - 0.5f, z - 0.5f);
+                    light.block_id = block_id;
+                    light.light_value = light_values[block_id];
+                    lights.push_back(light);
+                }
+            }
+        }
+    }
+
+    glm::vec4 clustered_lights::get_depth_slicing(float near_plane, float far_plane) {
+        far_plane = std::max(far_plane, near_plane * 2);
+        const float log_ratio = std::log(far_plane / near_plane);
+        const float scale = CLUSTER_SLICES / log_ratio;
+        return {near_plane, far_plane, scale, -std::log(near_plane) * scale};
+    }
+
+    static uint32_t to_cell(float value, uint32_t num_cells) {
+        const auto cell = static_cast<int64_t>(std::floor(value));
+        return static_cast<uint32_t>(std::min(std::max(cell, int64_t(0)), static_cast<int64_t>(num_cells) - 1));
+    }
+
+    bool clustered_lights::get_cluster_range(const glm::vec4& view_position_radius, const glm::vec2& projection_scale,
+                                             const glm::vec4& depth_slicing, light_cluster_range& range) {
+        const float radius = view_position_radius.w;
+        const float depth = -view_position_radius.z;
+        const float near_plane = depth_slicing.x;
+        const float far_plane = depth_slicing.y;
+
+        const float min_depth = depth - radius;
+        const float max_depth = depth + radius;
+        if(max_depth <= near_plane || min_depth >= far_plane) {
+            return false;
+        }
+
+        range.min.z = to_cell(std::log(std::max(min_depth, near_plane)) * depth_slicing.z + depth_slicing.w, CLUSTER_SLICES);
+        range.max.z = to_cell(std::log(std::min(max_depth, far_plane)) * depth_slicing.z + depth_slicing.w, CLUSTER_SLICES);
+
+        // A light that reaches past the near plane could cover any part of the screen
+        glm::vec2 ndc_min(-1);
+        glm::vec2 ndc_max(1);
+        if(min_depth > near_plane) {
+            // x / depth is smallest and largest at the corners of the light's box
+            for(int axis = 0; axis < 2; axis++) {
+                const float low = (view_position_radius[axis] - radius) * projection_scale[axis];
+                const float high = (view_position_radius[axis] + radius) * projection_scale[axis];
+                ndc_min[axis] = std::min(low / min_depth, low / max_depth);
+                ndc_max[axis] = std::max(high / min_depth, high / max_depth);
+            }
+
+            if(ndc_max.x < -1 || ndc_min.x > 1 || ndc_max.y < -1 || ndc_min.y > 1) {
+                return false;
+            }
+        }
+
+        range.min.x = to_cell((ndc_min.x * 0.5f + 0.5f) * CLUSTER_COLUMNS, CLUSTER_COLUMNS);
+        range.max.x = to_cell((ndc_max.x * 0.5f + 0.5f) * CLUSTER_COLUMNS, CLUSTER_COLUMNS);
+        range.min.y = to_cell((ndc_min.y * 0.5f + 0.5f) * CLUSTER_ROWS, CLUSTER_ROWS);
+        range.max.y = to_cell((ndc_max.y * 0.5f + 0.5f) * CLUSTER_ROWS, CLUSTER_ROWS);
+        return true;
+    }
+
+    void clustered_lights::bin_lights(const std::vector<light_cluster_range>& ranges, std::vector<uint32_t>& cluster_data) {
+        cluster_data.assign(NUM_CLUSTERS * 2, 0);
+
+        auto for_each_cluster = [](const light_cluster_range& range, auto&& func) {
+            for(uint32_t slice = range.min.z; slice <= range.max.z; slice++) {
+                for(uint32_t row = range.min.y; row <= range.max.y; row++) {
+                    for(uint32_t column = range.min.x; column <= range.max.x; column++) {
+                        func((slice * CLUSTER_ROWS + row) * CLUSTER_COLUMNS + column);
+                    }
+                }
+            }
+        };
+
+        // Count the lights in each cluster, then give each cluster its part of the index list
+        for(const auto& range : ranges) {
+            for_each_cluster(range, [&](uint32_t cluster) {
+                auto& count = cluster_data[cluster * 2 + 1];
+                count = std::min(count + 1, MAX_LIGHTS_PER_CLUSTER);
+            });
+        }
+
+        auto offset = static_cast<uint32_t>(cluster_data.size());
+        for(uint32_t cluster = 0; cluster < NUM_CLUSTERS; cluster++) {
+            cluster_data[cluster * 2] = offset;
+            offset += cluster_data[cluster * 2 + 1];
+            cluster_data[cluster * 2 + 1] = 0;
+        }
+        cluster_data.resize(offset);
+
+        // The lights go in the same order as they were counted, so the same ones are cut off
+        for(uint32_t light = 0; light < ranges.size(); light++) {
+            for_each_cluster(ranges[light], [&](uint32_t cluster) {
+                auto& count = cluster_data[cluster * 2 + 1];
+                if(count < MAX_LIGHTS_PER_CLUSTER) {
+                    cluster_data[cluster_data[cluster * 2] + count] = light;
+                    count++;
+                }
+            });
+        }
+    }
+
+    void clustered_lights::create_gl_objects() {
+        lights_size = static_cast<GLsizeiptr>(sizeof(block_lights_header) + MAX_LIGHTS * sizeof(block_light_data));
+        clusters_size = static_cast<GLsizeiptr>((NUM_CLUSTERS * 2 + NUM_CLUSTERS * MAX_LIGHTS_PER_CLUSTER) * sizeof(uint32_t));
+
+        glCreateBuffers(1, &lights_buffer);
+        glNamedBufferStorage(lights_buffer, lights_size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+        gpu_memory::track_buffer(lights_buffer, gpu_memory_category::buffers, static_cast<uint64_t>(lights_size));
+
+        glCreateBuffers(1, &clusters_buffer);
+        glNamedBufferStorage(clusters_buffer, clusters_size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+        gpu_memory::track_buffer(clusters_buffer, gpu_memory_category::buffers, static_cast<uint64_t>(clusters_size));
+    }
+}
@@ -0,0 +1,210 @@
+/*!
+ * \brief Sorts the light from emissive blocks into clusters, so shaders only look at the lights that can reach them
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_CLUSTERED_LIGHTS_H
+#define RENDERER_CLUSTERED_LIGHTS_H
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "camera.h"
+#include "../../geometry_cache/chunk_key.h"
+#include "../../mc_interface/mc_objects.h"
+
+namespace nova {
+    /*!
+     * \brief A block that gives off light, in world space
+     */
+    struct block_light {
+        glm::vec3 position;     //!< The center of the block
+        uint16_t block_id;
+        uint8_t light_value;    //!< Minecraft's light value, 1 to 15. Also how many blocks the light reaches
+    };
+
+    /*!
+     * \brief One light as shaders see it, laid out like the std430 struct in the shader
+     */
+    struct block_light_data {
+        glm::vec4 view_position_radius;     //!< xyz is the light's position in view space, w is how far it reaches
+        glm::uvec4 info;                    //!< x is the block ID, y is the light value. z and w are unused
+    };
+
+    /*!
+     * \brief The clusters that a light touches, as inclusive (column, row, slice) ranges
+     */
+    struct light_cluster_range {
+        glm::uvec3 min;
+        glm::uvec3 max;
+    };
+
+    /*!
+     * \brief Keeps every emissive block in the loaded sections, and bins the ones near the camera into a froxel grid
+     *
+     * The view frustum is split into CLUSTER_COLUMNS by CLUSTER_ROWS tiles on the screen, and CLUSTER_SLICES slices in
+     * depth. The slices are spaced exponentially from the near plane out to the blockLightDistance setting, so the
+     * clusters are about as deep as they are wide. Each frame the lights closest to the camera are put in every cluster
+     * that their sphere touches, so a shader only has to shade the few lights in its pixel's cluster, however many
+     * lights there are in the world. Both the number of lights and the number of lights in a cluster are capped, and the
+     * closest lights are kept, so the cost of shading stays the same however many torches the player puts down
+     *
+     * Shaders that declare these shader storage blocks get the lights bound:
+     *
+     *     struct block_light { vec4 viewPositionRadius; uvec4 info; };
+     *     layout(std430, binding = 3) readonly buffer block_lights {
+     *         uvec4 lightGridSize;    // columns, rows, slices, number of lights
+     *         vec4 lightGridDepth;    // near, far, scale, bias
+     *         block_light lights[];
+     *     };
+     *     layout(std430, binding = 4) readonly buffer light_clusters { uint lightClusterData[]; };
+     *
+     * A pixel's cluster is
+     *
+     *     uvec3 cell = uvec3(gl_FragCoord.xy / (vec2(viewWidth, viewHeight) * renderScale) * lightGridSize.xy,
+     *                        max(log(view_depth) * lightGridDepth.z + lightGridDepth.w, 0));
+     *     uint cluster = (min(cell.z, lightGridSize.z - 1) * lightGridSize.y + cell.y) * lightGridSize.x + cell.x;
+     *
+     * and lightClusterData[cluster * 2] is where its list of light indices starts in lightClusterData, with
+     * lightClusterData[cluster * 2 + 1] lights in it. Pixels further than lightGridDepth.y don't get any lights
+     *
+     * Lights come from the native mesher's sections. Everything but #update and #bind can be called from any thread
+     */
+    class clustered_lights {
+    public:
+        /*!
+         * \brief The SSBO binding points the lights and the clusters are bound to
+         */
+        static const GLuint BLOCK_LIGHTS_BINDING = 3;
+        static const GLuint LIGHT_CLUSTERS_BINDING = 4;
+
+        static const uint32_t CLUSTER_COLUMNS = 16;
+        static const uint32_t CLUSTER_ROWS = 9;
+        static const uint32_t CLUSTER_SLICES = 24;
+        static const uint32_t NUM_CLUSTERS = CLUSTER_COLUMNS * CLUSTER_ROWS * CLUSTER_SLICES;
+
+        /*!
+         * \brief The most lights that are sent to the GPU in a frame
+         */
+        static const uint32_t MAX_LIGHTS = 4096;
+
+        /*!
+         * \brief The most lights that one cluster can have
+         */
+        static const uint32_t MAX_LIGHTS_PER_CLUSTER = 64;
+
+        clustered_lights() = default;
+
+        clustered_lights(const clustered_lights&) = delete;
+        clustered_lights& operator=(const clustered_lights&) = delete;
+
+        ~clustered_lights();
+
+        /*!
+         * \brief Sets how much light a kind of block gives off. Blocks default to none
+         */
+        void set_block_light_value(int block_id, int light_value);
+
+        /*!
+         * \brief Replaces the lights in a section with the emissive blocks in the section's array
+         */
+        void add_section(const mc_chunk_section_blocks& section);
+
+        /*!
+         * \brief Forgets the lights in a section, because it's been unloaded
+         */
+        void remove_section(const glm::vec3& position, int id);
+
+        /*!
+         * \brief Lights further away from the camera than this aren't drawn
+         */
+        void set_max_distance(float distance);
+
+        /*!
+         * \brief Bins the lights close to the camera and sends them to the GPU. Should be called once per frame, after
+         * the camera has moved
+         */
+        void update(camera& player_camera);
+
+        /*!
+         * \brief Binds the lights and the clusters to their binding points
+         */
+        void bind();
+
+        uint32_t get_num_visible_lights() const;
+
+        /*!
+         * \brief Finds the blocks in a padded 18x18x18 section that give off light. The border blocks are skipped,
+         * since they're in their own sections
+         *
+         * \param block_ids The section's blocks, indexed by (y * 18 + z) * 18 + x
+         * \param light_values How much light each block ID gives off
+         * \param section_position Where the section's corner is in the world
+         * \param lights The lights are added to the end of this
+         */
+        static void find_section_lights(const uint16_t* block_ids, const std::vector<uint8_t>& light_values,
+                                        const glm::vec3& section_position, std::vector<block_light>& lights);
+
+        /*!
+         * \brief Works out the near and far planes of the grid, and the scale and bias that turns the log of a view
+         * depth into a slice
+         */
+        static glm::vec4 get_depth_slicing(float near_plane, float far_plane);
+
+        /*!
+         * \brief Finds the clusters that a light's sphere touches
+         *
+         * \param view_position_radius The light's position in view space, and its radius
+         * \param projection_scale The x and y scale of the projection matrix, [0][0] and [1][1]
+         * \param depth_slicing From get_depth_slicing
+         * \param range Set to the clusters the light touches
+         * \return False if the light isn't in any cluster
+         */
+        static bool get_cluster_range(const glm::vec4& view_position_radius, const glm::vec2& projection_scale,
+                                      const glm::vec4& depth_slicing, light_cluster_range& range);
+
+        /*!
+         * \brief Puts lights in clusters
+         *
+         * \param ranges The clusters each light touches, from the light that should be kept the most to the least
+         * \param cluster_data Set to each cluster's offset and count, followed by the lists of light indices
+         */
+        static void bin_lights(const std::vector<light_cluster_range>& ranges, std::vector<uint32_t>& cluster_data);
+
+    private:
+        mutable std::mutex lights_lock;
+        std::vector<uint8_t> light_values;
+        std::unordered_map<chunk_key, std::vector<block_light>, chunk_key_hash> section_lights;
+        bool lights_changed = false;
+        float max_distance = 64;
+
+        /*!
+         * \brief Every light in every section, copied out of section_lights whenever it changes. Only used by the
+         * render thread
+         */
+        std::vector<block_light> all_lights;
+
+        struct light_candidate {
+            float distance_squared;
+            block_light_data data;
+        };
+        std::vector<light_candidate> candidates;
+        std::vector<block_light_data> visible_lights;
+        std::vector<light_cluster_range> visible_ranges;
+        std::vector<uint32_t> cluster_data;
+
+        GLuint lights_buffer = 0;
+        GLuint clusters_buffer = 0;
+        GLsizeiptr lights_size = 0;
+        GLsizeiptr clusters_size = 0;
+
+        void create_gl_objects();
+    };
+}
+
+#endif //RENDERER_CLUSTERED_LIGHTS_H
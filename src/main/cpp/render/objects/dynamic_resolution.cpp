@@ -0,0 +1,322 @@
+/*!
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <easylogging++.h>
+#include <GLFW/glfw3.h>
+#include "dynamic_resolution.h"
+#include "gl_state.h"
+#include "frame_stats.h"
+#include "../frame_graph.h"
+
+namespace nova {
+    static const char* UPSCALE_VERTEX_SOURCE = R"(#version 450
+out vec2 uv;
+
+void main() {
+    // One triangle that covers the whole screen
+    uv = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(uv * 2 - 1, 0, 1);
+}
+)";
+
+    static const char* UPSCALE_FRAGMENT_SOURCE = R"(#version 450
+in vec2 uv;
+
+layout(binding = 0) uniform sampler2D source;
+
+layout(location = 0) uniform vec2 uv_scale;
+layout(location = 1) uniform float sharpness;
+
+layout(location = 0) out vec4 color;
+
+vec3 sample_drawn_part(vec2 offset, vec2 texel) {
+    // Everything past the drawn part of the texture is left over from an older frame
+    vec2 source_uv = clamp(uv * uv_scale + offset * texel, texel * 0.5, uv_scale - texel * 0.5);
+    return texture(source, source_uv).rgb;
+}
+
+void main() {
+    vec2 texel = 1.0 / vec2(textureSize(source, 0));
+    vec3 center = sample_drawn_part(vec2(0), texel);
+    vec3 up = sample_drawn_part(vec2(0, 1), texel);
+    vec3 down = sample_drawn_part(vec2(0, -1), texel);
+    vec3 left = sample_drawn_part(vec2(-1, 0), texel);
+    vec3 right = sample_drawn_part(vec2(1, 0), texel);
+
+    // Push the pixel away from its neighbors, but never past the brightest or darkest of them so edges don't ring
+    vec3 sharpened = center + (center * 4 - (up + down + left + right)) * (sharpness * 0.25);
+    vec3 min_color = min(center, min(min(up, down), min(left, right)));
+    vec3 max_color = max(center, max(max(up, down), max(left, right)));
+    color = vec4(clamp(sharpened, min_color, max_color), 1);
+}
+)";
+
+    /*!
+     * \brief How many frames' timer queries can be waiting on the GPU at once
+     */
+    static const size_t NUM_FRAME_TIMERS = 8;
+
+    /*!
+     * \brief How many frames at the same scale are averaged before the scale is picked again
+     */
+    static const uint32_t SAMPLES_PER_DECISION = 4;
+
+    /*!
+     * \brief The scale only goes up when frames take less than this much of the target time
+     */
+    static const float SCALE_UP_THRESHOLD = 0.8f;
+
+    /*!
+     * \brief Compiles one stage of the upscaling shader
+     *
+     * \return The shader, or 0 if it didn't compile
+     */
+    static GLuint compile_shader(GLenum stage, const char* source) {
+        GLuint shader = glCreateShader(stage);
+        glShaderSource(shader, 1, &source, nullptr);
+        glCompileShader(shader);
+
+        GLint compiled = GL_FALSE;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+        if(compiled == GL_FALSE) {
+            GLint log_length = 0;
+            glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &log_length);
+            std::string info_log(static_cast<size_t>(std::max(log_length, 1)), '\0');
+            glGetShaderInfoLog(shader, log_length, nullptr, &info_log[0]);
+
+            LOG(ERROR) << "Could not compile the upscaling shader, so the picture won't be sharpened: " << info_log;
+            glDeleteShader(shader);
+            return 0;
+        }
+
+        return shader;
+    }
+
+    dynamic_resolution::~dynamic_resolution() {
+        if(glfwGetCurrentContext() == nullptr) {
+            return;
+        }
+
+        for(auto& timer : timers) {
+            glDeleteQueries(2, timer.queries);
+        }
+        if(upscale_program != 0) {
+            gl_state::delete_program(upscale_program);
+        }
+        if(upscale_vao != 0) {
+            gl_state::delete_vertex_arrays(1, &upscale_vao);
+        }
+    }
+
+    void dynamic_resolution::set_enabled(bool enabled) {
+        this->enabled = enabled;
+    }
+
+    void dynamic_resolution::set_target_frame_time(float milliseconds) {
+        target_frame_time = std::max(milliseconds, 1.0f);
+    }
+
+    void dynamic_resolution::set_min_scale(float scale) {
+        min_scale = std::min(std::max(scale, RESOLUTION_SCALE_STEP), 1.0f);
+    }
+
+    void dynamic_resolution::set_sharpness(float sharpness) {
+        this->sharpness = std::min(std::max(sharpness, 0.0f), 1.0f);
+    }
+
+    void dynamic_resolution::set_always_timed(bool always_timed) {
+        this->always_timed = always_timed;
+    }
+
+    bool dynamic_resolution::update() {
+        const float old_scale = scale;
+        slowest_new_frame_time = 0;
+        if(!enabled) {
+            scale = 1;
+        }
+        if(!enabled && !always_timed) {
+            return scale != old_scale;
+        }
+
+        // Read the timers oldest first, and stop at the first one the GPU hasn't gotten to
+        for(size_t i = 0; i < timers.size(); i++) {
+            auto& timer = timers[(next_timer + i) % timers.size()];
+            if(!timer.pending) {
+                continue;
+            }
+
+            GLint available = 0;
+            glGetQueryObjectiv(timer.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if(!available) {
+                break;
+            }
+
+            GLuint64 start_time = 0;
+            GLuint64 end_time = 0;
+            glGetQueryObjectui64v(timer.queries[0], GL_QUERY_RESULT, &start_time);
+            glGetQueryObjectui64v(timer.queries[1], GL_QUERY_RESULT, &end_time);
+            timer.pending = false;
+
+            const float frame_time = static_cast<float>(end_time - start_time) / 1000000.0f;
+            slowest_new_frame_time = std::max(slowest_new_frame_time, frame_time);
+            if(timer.scale == scale) {
+                frame_time_sum += frame_time;
+                num_samples++;
+            }
+        }
+
+        if(!enabled) {
+            frame_time_sum = 0;
+            num_samples = 0;
+            return scale != old_scale;
+        }
+
+        if(num_samples >= SAMPLES_PER_DECISION) {
+            average_frame_time = frame_time_sum / num_samples;
+            scale = pick_scale(scale, average_frame_time, target_frame_time, min_scale);
+            frame_time_sum = 0;
+            num_samples = 0;
+
+            if(scale != old_scale) {
+                LOG(DEBUG) << "The world took " << average_frame_time << "ms on the GPU, so it's now drawn at "
+                           << scale << "x resolution";
+            }
+        }
+
+        return scale != old_scale;
+    }
+
+    void dynamic_resolution::begin_timing() {
+        current_timer = -1;
+        if(!enabled && !always_timed) {
+            return;
+        }
+
+        if(timers.empty()) {
+            timers.resize(NUM_FRAME_TIMERS);
+            for(auto& timer : timers) {
+                glGenQueries(2, timer.queries);
+            }
+        }
+
+        // If the GPU is that far behind, this frame just isn't timed
+        auto& timer = timers[next_timer];
+        if(timer.pending) {
+            return;
+        }
+
+        glQueryCounter(timer.queries[0], GL_TIMESTAMP);
+        timer.scale = scale;
+        current_timer = static_cast<int>(next_timer);
+    }
+
+    void dynamic_resolution::end_timing() {
+        if(current_timer < 0) {
+            return;
+        }
+
+        auto& timer = timers[current_timer];
+        glQueryCounter(timer.queries[1], GL_TIMESTAMP);
+        timer.pending = true;
+        next_timer = (next_timer + 1) % timers.size();
+        current_timer = -1;
+    }
+
+    float dynamic_resolution::get_scale() const {
+        return scale;
+    }
+
+    float dynamic_resolution::get_frame_time() const {
+        return average_frame_time;
+    }
+
+    float dynamic_resolution::get_slowest_new_frame_time() const {
+        return slowest_new_frame_time;
+    }
+
+    bool dynamic_resolution::upscale(GLuint texture, const glm::uvec2& texture_size) {
+        if(scale == 1 || sharpness == 0 || upscale_broken) {
+            return false;
+        }
+
+        if(upscale_program == 0) {
+            create_upscale_program();
+            if(upscale_broken) {
+                return false;
+            }
+        }
+
+        const glm::vec2 uv_scale = glm::vec2(get_scaled_size(texture_size, scale)) / glm::vec2(texture_size);
+        gl_state::use_program(upscale_program);
+        glProgramUniform2f(upscale_program, 0, uv_scale.x, uv_scale.y);
+        glProgramUniform1f(upscale_program, 1, sharpness);
+
+        gl_state::bind_texture_unit(0, texture);
+        gl_state::bind_vertex_array(upscale_vao);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        frame_stats::count_draw(1);
+
+        return true;
+    }
+
+    float dynamic_resolution::pick_scale(float scale, float frame_time, float target_time, float min_scale) {
+        if(frame_time <= 0 || target_time <= 0) {
+            return scale;
+        }
+
+        const float min_steps = std::ceil(min_scale / RESOLUTION_SCALE_STEP);
+        const float max_steps = 1 / RESOLUTION_SCALE_STEP;
+        const float steps = scale / RESOLUTION_SCALE_STEP;
+
+        // The number of pixels goes with the square of the scale, and so does the time it takes to draw them
+        const float pixel_ratio = std::sqrt(target_time / frame_time);
+
+        float new_steps = steps;
+        if(frame_time > target_time) {
+            // Drop quickly, since every frame over the target is a dropped frame, and always by at least a step
+            new_steps = std::min(std::floor(steps * std::max(pixel_ratio, 0.75f)), steps - 1);
+
+        } else if(frame_time < target_time * SCALE_UP_THRESHOLD) {
+            // Climb slowly, and aim a bit under the target so the next frame doesn't go right back over it
+            new_steps = std::round(steps * std::min(pixel_ratio * 0.95f, 1.1f));
+            new_steps = std::max(new_steps, steps);
+        }
+
+        return std::min(std::max(new_steps, min_steps), max_steps) * RESOLUTION_SCALE_STEP;
+    }
+
+    void dynamic_resolution::create_upscale_program() {
+        GLuint vertex_shader = compile_shader(GL_VERTEX_SHADER, UPSCALE_VERTEX_SOURCE);
+        GLuint fragment_shader = compile_shader(GL_FRAGMENT_SHADER, UPSCALE_FRAGMENT_SOURCE);
+        if(vertex_shader == 0 || fragment_shader == 0) {
+            glDeleteShader(vertex_shader);
+            glDeleteShader(fragment_shader);
+            upscale_broken = true;
+            return;
+        }
+
+        upscale_program = glCreateProgram();
+        glAttachShader(upscale_program, vertex_shader);
+        glAttachShader(upscale_program, fragment_shader);
+        glLinkProgram(upscale_program);
+        glDeleteShader(vertex_shader);
+        glDeleteShader(fragment_shader);
+
+        GLint linked = GL_FALSE;
+        glGetProgramiv(upscale_program, GL_LINK_STATUS, &linked);
+        if(linked == GL_FALSE) {
+            LOG(ERROR) << "Could not link the upscaling shader, so the picture won't be sharpened";
+            gl_state::delete_program(upscale_program);
+            upscale_program = 0;
+            upscale_broken = true;
+            return;
+        }
+
+        glCreateVertexArrays(1, &upscale_vao);
+    }
+}
@@ -0,0 +1,170 @@
+/*!
+ * \brief Picks the resolution the world is drawn at, so the GPU keeps up with the frame rate the player asked for
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#ifndef RENDERER_DYNAMIC_RESOLUTION_H
+#define RENDERER_DYNAMIC_RESOLUTION_H
+
+#include <cstdint>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+namespace nova {
+    /*!
+     * \brief How finely the scale is picked. Scales are always a whole number of these steps, so tiny changes in the
+     * frame time don't change the resolution every frame
+     */
+    const float RESOLUTION_SCALE_STEP = 1.0f / 32.0f;
+
+    /*!
+     * \brief Times the world's passes on the GPU, and scales the gbuffer and composite attachments to keep that time
+     * under a target
+     *
+     * The attachments are always made at the full view size, and the frame graph only draws into the scaled part of
+     * them, so changing the scale never makes new textures. Fullscreen passes have to multiply their texture
+     * coordinates by renderScale in per_frame_uniforms to read the part that was drawn.
+     *
+     * The GPU time comes from a pair of GL_TIMESTAMP queries around the frame graph's passes. They're read a few frames
+     * later so the CPU never waits on the GPU, and frames drawn at a different scale than the current one are ignored,
+     * since they'd make the controller undo its own change. Drawing time goes up with the number of pixels, so the
+     * controller moves the scale by the square root of how far off the time is. The scale only goes up once there's
+     * a good bit of room under the target, so it doesn't bounce between two scales.
+     *
+     * When the shaderpack doesn't have a final shader, the scaled colortex0 is stretched to the screen with a shader
+     * that sharpens it a bit, to get back some of the detail lost to the lower resolution.
+     *
+     * Everything here has to be called from the render thread
+     */
+    class dynamic_resolution {
+    public:
+        dynamic_resolution() = default;
+
+        dynamic_resolution(const dynamic_resolution&) = delete;
+        dynamic_resolution& operator=(const dynamic_resolution&) = delete;
+
+        ~dynamic_resolution();
+
+        /*!
+         * \brief Turns the scaling on or off. When it's off the scale is always 1
+         */
+        void set_enabled(bool enabled);
+
+        /*!
+         * \brief Times the world's passes even when the scaling is off, so other things can look at how long frames
+         * take on the GPU
+         */
+        void set_always_timed(bool always_timed);
+
+        /*!
+         * \brief Sets how long the world's passes should take on the GPU, in milliseconds
+         */
+        void set_target_frame_time(float milliseconds);
+
+        /*!
+         * \brief Sets the smallest scale that can be picked, so the picture never gets too blurry
+         */
+        void set_min_scale(float scale);
+
+        /*!
+         * \brief Sets how much the picture is sharpened when it's stretched to the screen. 0 turns sharpening off
+         */
+        void set_sharpness(float sharpness);
+
+        /*!
+         * \brief Reads the GPU times that have come in, and picks the scale for this frame
+         *
+         * \return True if the scale changed
+         */
+        bool update();
+
+        /*!
+         * \brief Starts timing the world's passes. Goes right before the frame graph runs
+         */
+        void begin_timing();
+
+        /*!
+         * \brief Stops timing the world's passes. Goes right after the frame graph runs
+         */
+        void end_timing();
+
+        float get_scale() const;
+
+        /*!
+         * \brief The average GPU time of the last few timed frames, in milliseconds
+         */
+        float get_frame_time() const;
+
+        /*!
+         * \brief The longest GPU time of the frames whose timers were read in the last #update, in milliseconds, or 0
+         * if none were
+         */
+        float get_slowest_new_frame_time() const;
+
+        /*!
+         * \brief Stretches the drawn part of a texture over the whole of the bound framebuffer, sharpening it
+         *
+         * \param texture The texture to stretch
+         * \param texture_size The size of the whole texture
+         * \return False if there's nothing to sharpen, or the shader couldn't be made, so the texture should be
+         * blitted instead
+         */
+        bool upscale(GLuint texture, const glm::uvec2& texture_size);
+
+        /*!
+         * \brief Picks the next scale from the current one and how long the last frame at that scale took
+         *
+         * \param scale The scale the frame was drawn at
+         * \param frame_time How long the frame took, in milliseconds
+         * \param target_time How long frames should take, in milliseconds
+         * \param min_scale The smallest scale that can be picked
+         * \return The new scale, a multiple of RESOLUTION_SCALE_STEP between min_scale and 1
+         */
+        static float pick_scale(float scale, float frame_time, float target_time, float min_scale);
+
+    private:
+        /*!
+         * \brief A GL_TIMESTAMP query pair for one frame, and the scale that frame was drawn at
+         */
+        struct frame_timer {
+            GLuint queries[2] = {0, 0};
+            float scale = 1;
+            bool pending = false;
+        };
+
+        bool enabled = false;
+        bool always_timed = false;
+        float target_frame_time = 1000.0f / 60.0f;
+        float min_scale = 0.5f;
+        float sharpness = 0.3f;
+
+        float scale = 1;
+
+        /*!
+         * \brief The GPU times read at the current scale since the last time the scale was picked
+         */
+        float frame_time_sum = 0;
+        uint32_t num_samples = 0;
+        float average_frame_time = 0;
+        float slowest_new_frame_time = 0;
+
+        std::vector<frame_timer> timers;
+        size_t next_timer = 0;
+
+        /*!
+         * \brief The timer for the frame being drawn, or -1 if every timer was still waiting on the GPU
+         */
+        int current_timer = -1;
+
+        GLuint upscale_program = 0;
+        GLuint upscale_vao = 0;
+        bool upscale_broken = false;
+
+        void create_upscale_program();
+    };
+}
+
+#endif //RENDERER_DYNAMIC_RESOLUTION_H
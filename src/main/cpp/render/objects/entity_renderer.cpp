@@ -0,0 +1,292 @@
+/*!
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <easylogging++.h>
+#include <GLFW/glfw3.h>
+#include "entity_renderer.h"
+#include "frame_stats.h"
+#include "gl_state.h"
+#include "gpu_memory.h"
+#include "vertex_formats.h"
+
+namespace nova {
+    /*!
+     * \brief The number of ints between the starts of two vertices, for formats whose first three ints are a float
+     * position. Other formats get 0
+     */
+    static size_t get_position_stride(format vertex_format) {
+        return visit_vertex_layout(vertex_format, [](auto layout) -> size_t {
+            using vertex = typename decltype(layout)::vertex;
+            const bool has_float_position = std::is_same<decltype(vertex::position), GLfloat[3]>::value && offsetof(vertex, position) == 0;
+            return has_float_position ? decltype(layout)::ints_per_vertex : 0;
+        });
+    }
+
+    entity_renderer::~entity_renderer() {
+        if(glfwGetCurrentContext() == nullptr) {
+            return;
+        }
+
+        for(auto& region : retired_regions) {
+            glDeleteSync(region.fence);
+        }
+
+        if(buffer != 0) {
+            glUnmapNamedBuffer(buffer);
+            gl_state::delete_buffers(1, &buffer);
+        }
+    }
+
+    uint32_t entity_renderer::reserve_model_id() {
+        return next_model_id++;
+    }
+
+    void entity_renderer::add_model(uint32_t model_id, uint32_t shader, const mesh_definition& definition, texture_handle texture) {
+        if(get_position_stride(definition.vertex_format) == 0) {
+            LOG(WARNING) << "Entity model " << model_id << " uses the " << definition.vertex_format.to_string()
+                         << " format, which isn't supported for entities. It won't be drawn";
+            return;
+        }
+
+        entity_model model = {};
+        model.id = model_id;
+        model.shader = shader;
+        model.mesh = std::make_unique<gl_mesh>(definition);
+        model.texture = texture;
+        model.bounds = get_model_bounds(definition);
+
+        auto index_itr = model_indices.find(model_id);
+        if(index_itr != model_indices.end()) {
+            models[index_itr->second] = std::move(model);
+        } else {
+            model_indices[model_id] = models.size();
+            models.push_back(std::move(model));
+        }
+    }
+
+    void entity_renderer::remove_model(uint32_t model_id) {
+        auto index_itr = model_indices.find(model_id);
+        if(index_itr == model_indices.end()) {
+            return;
+        }
+
+        // Swap the last model into the removed one's place so the list stays packed
+        const size_t index = index_itr->second;
+        model_indices.erase(index_itr);
+        if(index != models.size() - 1) {
+            models[index] = std::move(models.back());
+            model_indices[models[index].id] = index;
+        }
+        models.pop_back();
+    }
+
+    void entity_renderer::set_instances(std::vector<mc_entity_instance> new_instances) {
+        instances = std::move(new_instances);
+    }
+
+    void entity_renderer::begin_frame(const frustum& view_frustum) {
+        if(buffer == 0) {
+            create_gl_objects();
+        }
+
+        // Everything that read last frame's region has been submitted by now
+        if(current_end > current_begin) {
+            retired_regions.push_back({glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0)});
+        }
+        current_begin = 0;
+        current_end = 0;
+
+        while(!retired_regions.empty() && retire_oldest_region(false)) {}
+
+        for(auto& model : models) {
+            model.first_instance = 0;
+            model.num_instances = 0;
+        }
+        visible_instances.clear();
+
+        // Instances of models we don't have can't be drawn, so they're not worth culling
+        instance_bounds.resize(0);
+        culled_instances.clear();
+        instance_models.clear();
+        for(uint32_t i = 0; i < instances.size(); i++) {
+            auto model_itr = model_indices.find(static_cast<uint32_t>(instances[i].model_id));
+            if(model_itr == model_indices.end()) {
+                continue;
+            }
+
+            glm::mat4 transform;
+            std::memcpy(&transform[0][0], instances[i].transform, sizeof(transform));
+            instance_bounds.push_back(get_instance_bounds(models[model_itr->second].bounds, transform));
+            culled_instances.push_back(i);
+            instance_models.push_back(static_cast<uint32_t>(model_itr->second));
+        }
+
+        instance_bounds.cull(view_frustum, visible_indices);
+        if(visible_indices.empty()) {
+            return;
+        }
+
+        const auto max_instances = static_cast<size_t>(RING_SIZE / 2 / sizeof(entity_instance_data));
+        if(visible_indices.size() > max_instances) {
+            if(!warned_about_ring_size) {
+                LOG(WARNING) << visible_indices.size() << " entity instances are visible, but only " << max_instances
+                             << " fit in the ring buffer. The rest won't be drawn";
+                warned_about_ring_size = true;
+            }
+            visible_indices.resize(max_instances);
+        }
+
+        // Counting sort by model, so each model's instances are next to each other
+        for(uint32_t visible : visible_indices) {
+            models[instance_models[visible]].num_instances++;
+        }
+        uint32_t next_instance = 0;
+        for(auto& model : models) {
+            model.first_instance = next_instance;
+            next_instance += model.num_instances;
+            model.num_instances = 0;
+        }
+
+        visible_instances.resize(visible_indices.size());
+        for(uint32_t visible : visible_indices) {
+            auto& model = models[instance_models[visible]];
+            const auto& instance = instances[culled_instances[visible]];
+
+            auto& data = visible_instances[model.first_instance + model.num_instances];
+            std::memcpy(&data.transform[0][0], instance.transform, sizeof(data.transform));
+            data.tint = glm::vec4(instance.tint[0], instance.tint[1], instance.tint[2], instance.tint[3]);
+            data.info = glm::ivec4(instance.entity_id, instance.animation_frame, instance.lightmap_coord, 0);
+            model.num_instances++;
+        }
+
+        // The ring starts regions on an SSBO alignment boundary so they can be bound on their own
+        const auto size = static_cast<GLsizeiptr>(visible_instances.size() * sizeof(entity_instance_data));
+        const GLsizeiptr begin = allocate(size);
+        std::memcpy(mapped_data + begin, visible_instances.data(), static_cast<size_t>(size));
+        frame_stats::count_upload(static_cast<uint64_t>(size));
+
+        current_begin = begin;
+        current_end = begin + size;
+    }
+
+    void entity_renderer::draw(uint32_t shader, gl_shader_program& program, texture_manager& textures) {
+        if(visible_instances.empty()) {
+            return;
+        }
+
+        const auto& builtin_uniforms = program.get_builtin_uniforms();
+        const bool use_instancing = builtin_uniforms.has_entity_instances;
+        if(use_instancing) {
+            gl_state::bind_buffer_range(GL_SHADER_STORAGE_BUFFER, ENTITY_INSTANCES_BINDING, buffer, current_begin,
+                                        current_end - current_begin);
+        }
+
+        for(const auto& model : models) {
+            if(model.shader != shader || model.num_instances == 0) {
+                continue;
+            }
+
+            textures.bind_texture(model.texture, 0);
+            model.mesh->set_active();
+
+            if(use_instancing) {
+                model.mesh->draw_instanced(model.num_instances, model.first_instance);
+
+            } else if(builtin_uniforms.gbuffer_model >= 0) {
+                for(uint32_t i = model.first_instance; i < model.first_instance + model.num_instances; i++) {
+                    glUniformMatrix4fv(builtin_uniforms.gbuffer_model, 1, GL_FALSE, &visible_instances[i].transform[0][0]);
+                    model.mesh->draw();
+                }
+            }
+        }
+    }
+
+    size_t entity_renderer::get_num_visible_instances() const {
+        return visible_instances.size();
+    }
+
+    aabb entity_renderer::get_model_bounds(const mesh_definition& definition) {
+        const size_t stride = get_position_stride(definition.vertex_format);
+        if(stride == 0 || definition.vertex_data.size() < 3) {
+            return {glm::vec3(0), glm::vec3(0)};
+        }
+
+        glm::vec3 bounds_min(std::numeric_limits<float>::max());
+        glm::vec3 bounds_max(std::numeric_limits<float>::lowest());
+        for(size_t vertex = 0; vertex + 3 <= definition.vertex_data.size(); vertex += stride) {
+            float position_floats[3];
+            std::memcpy(position_floats, &definition.vertex_data[vertex], sizeof(position_floats));
+            const glm::vec3 position(position_floats[0], position_floats[1], position_floats[2]);
+            bounds_min = glm::min(bounds_min, position);
+            bounds_max = glm::max(bounds_max, position);
+        }
+
+        return {(bounds_min + bounds_max) * 0.5f, (bounds_max - bounds_min) * 0.5f};
+    }
+
+    aabb entity_renderer::get_instance_bounds(const aabb& model_bounds, const glm::mat4& transform) {
+        // Each world axis reaches as far as the transformed local axes reach along it
+        const glm::mat3 axes(transform);
+
+        aabb bounds;
+        bounds.center = glm::vec3(transform * glm::vec4(model_bounds.center, 1));
+        bounds.extents = glm::abs(axes[0]) * model_bounds.extents.x
+                         + glm::abs(axes[1]) * model_bounds.extents.y
+                         + glm::abs(axes[2]) * model_bounds.extents.z;
+        return bounds;
+    }
+
+    void entity_renderer::create_gl_objects() {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        glCreateBuffers(1, &buffer);
+        glNamedBufferStorage(buffer, RING_SIZE, nullptr, flags);
+        gpu_memory::track_buffer(buffer, gpu_memory_category::buffers, RING_SIZE);
+        mapped_data = static_cast<uint8_t*>(glMapNamedBufferRange(buffer, 0, RING_SIZE, flags));
+
+        if(mapped_data == nullptr) {
+            LOG(FATAL) << "Could not map the entity instance ring buffer";
+        }
+
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storage_buffer_alignment);
+        ring = ring_allocator(RING_SIZE, static_cast<uint64_t>(storage_buffer_alignment));
+    }
+
+    GLsizeiptr entity_renderer::allocate(GLsizeiptr size) {
+        // Last frame's region was retired before this, so every allocation in the ring has a retired region
+        uint64_t offset = 0;
+        while(!ring.allocate(static_cast<uint64_t>(size), offset)) {
+            retire_oldest_region(true);
+        }
+        return static_cast<GLsizeiptr>(offset);
+    }
+
+    bool entity_renderer::retire_oldest_region(bool wait) {
+        auto& oldest = retired_regions.front();
+
+        if(wait) {
+            GLenum status = glClientWaitSync(oldest.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+            while(status == GL_TIMEOUT_EXPIRED) {
+                LOG(WARNING) << "Still waiting on the GPU to finish drawing old entity instances";
+                status = glClientWaitSync(oldest.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+            }
+
+        } else {
+            GLenum status = glClientWaitSync(oldest.fence, 0, 0);
+            if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+                return false;
+            }
+        }
+
+        glDeleteSync(oldest.fence);
+        retired_regions.pop_front();
+        ring.free_oldest();
+        return true;
+    }
+}
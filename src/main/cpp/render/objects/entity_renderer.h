@@ -0,0 +1,220 @@
+/*!
+ * \brief Draws every copy of an entity model with one instanced draw
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_ENTITY_RENDERER_H
+#define RENDERER_ENTITY_RENDERER_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "gl_mesh.h"
+#include "textures/texture_manager.h"
+#include "shaders/gl_shader_program.h"
+#include "../../data_loading/physics/aabb.h"
+#include "../../data_loading/physics/frustum.h"
+#include "../../geometry_cache/aabb_table.h"
+#include "../../mc_interface/mc_objects.h"
+#include "../../utils/ring_allocator.h"
+
+namespace nova {
+    /*!
+     * \brief One drawn copy of an entity model, laid out like the std430 struct in the shader
+     */
+    struct entity_instance_data {
+        glm::mat4 transform;    //!< From the model's space to world space
+        glm::vec4 tint;         //!< Multiplied with the model's color. Minecraft uses this for hurt flashes and dyes
+        glm::ivec4 info;        //!< x is the entity's ID, y is its animation frame, z is its lightmap coordinate. w is unused
+    };
+
+    /*!
+     * \brief Holds the entity models Minecraft has sent, and streams where their instances are each frame
+     *
+     * Each model is uploaded once into its own gl_mesh, with a texture and the shader whose filter it passes. Every
+     * frame, Minecraft sends the whole list of instances with set_entity_instances: which model, its transform,
+     * animation frame, and tint. A mob made of several model parts, like a zombie's head and limbs, is one instance
+     * for each part.
+     *
+     * #begin_frame frustum culls the instances, sorts the ones that are left by model, and copies them into one region
+     * of a persistently mapped ring buffer. Shaders that declare a shader storage block named `entity_instances` at
+     * binding ENTITY_INSTANCES_BINDING get every model drawn with one glDrawElementsInstancedBaseInstance, and find
+     * their instance with `entity_instances[gl_BaseInstanceARB + gl_InstanceID]`. Shaders without the block get one
+     * draw per instance, with the instance's transform in gbufferModel. Regions of the ring are fenced, and only
+     * reused once the GPU is done with them. The last list of instances is drawn until a new one is sent
+     *
+     * Like everything else that touches GL, this has to be used from the render thread, except for #reserve_model_id.
+     * The GL objects aren't made until the first frame, so this can be made before there's a context
+     */
+    class entity_renderer {
+    public:
+        /*!
+         * \brief The SSBO binding point that the instances are bound to
+         */
+        static const GLuint ENTITY_INSTANCES_BINDING = 2;
+
+        /*!
+         * \brief The size, in bytes, of the ring buffer that instances are streamed through
+         */
+        static const GLsizeiptr RING_SIZE = 8 * 1024 * 1024;
+
+        entity_renderer() = default;
+
+        entity_renderer(const entity_renderer&) = delete;
+        entity_renderer& operator=(const entity_renderer&) = delete;
+
+        ~entity_renderer();
+
+        /*!
+         * \brief Hands out a new model ID. Can be called from any thread
+         */
+        uint32_t reserve_model_id();
+
+        /*!
+         * \brief Uploads an entity model
+         *
+         * \param model_id The model's ID, from #reserve_model_id
+         * \param shader The mesh store's ID for the shader whose filter the model passes
+         * \param definition The model's geometry, with its position at the origin of the model's space
+         * \param texture The model's texture
+         */
+        void add_model(uint32_t model_id, uint32_t shader, const mesh_definition& definition, texture_handle texture);
+
+        /*!
+         * \brief Removes a model. Instances of it are skipped from then on
+         */
+        void remove_model(uint32_t model_id);
+
+        /*!
+         * \brief Replaces the instances that are drawn, starting with the next frame
+         */
+        void set_instances(std::vector<mc_entity_instance> instances);
+
+        /*!
+         * \brief Culls the instances against the view frustum and copies the visible ones into the ring buffer
+         *
+         * Should be called once per frame, before anything is drawn
+         */
+        void begin_frame(const frustum& view_frustum);
+
+        /*!
+         * \brief Draws the visible instances of every model that uses the given shader
+         *
+         * \param shader The mesh store's ID for the shader
+         * \param program The shader, which must be bound
+         * \param textures The texture manager to bind the models' textures from
+         */
+        void draw(uint32_t shader, gl_shader_program& program, texture_manager& textures);
+
+        size_t get_num_visible_instances() const;
+
+        /*!
+         * \brief Finds the box around a model's vertices
+         *
+         * \return The box, or a box with no extents at the origin if the model's format doesn't have float positions
+         */
+        static aabb get_model_bounds(const mesh_definition& definition);
+
+        /*!
+         * \brief Finds the world space box around a model's box once it's been transformed
+         */
+        static aabb get_instance_bounds(const aabb& model_bounds, const glm::mat4& transform);
+
+    private:
+        struct entity_model {
+            uint32_t id;
+            uint32_t shader;
+            std::unique_ptr<gl_mesh> mesh;
+            texture_handle texture;
+            aabb bounds;
+
+            /*!
+             * \brief Where this model's visible instances start in this frame's region, and how many there are
+             */
+            uint32_t first_instance = 0;
+            uint32_t num_instances = 0;
+        };
+
+        /*!
+         * \brief A part of the ring that the GPU may still be reading instances from
+         */
+        struct ring_region {
+            GLsync fence;
+        };
+
+        std::atomic<uint32_t> next_model_id{1};
+
+        std::vector<entity_model> models;
+
+        /*!
+         * \brief The index in #models of each model ID
+         */
+        std::unordered_map<uint32_t, size_t> model_indices;
+
+        std::vector<mc_entity_instance> instances;
+
+        /*!
+         * \brief This frame's visible instances, sorted by model. This is what was copied into the ring
+         */
+        std::vector<entity_instance_data> visible_instances;
+
+        /*!
+         * \brief Scratch space for culling, kept around so it doesn't have to be allocated every frame
+         */
+        aabb_table instance_bounds;
+        std::vector<uint32_t> culled_instances;
+        std::vector<uint32_t> instance_models;
+        std::vector<uint32_t> visible_indices;
+
+        /*!
+         * \brief Where this frame's instances are in the ring. Empty if there aren't any
+         */
+        GLsizeiptr current_begin = 0;
+        GLsizeiptr current_end = 0;
+
+        /*!
+         * \brief Regions from earlier frames that the GPU may still be reading, oldest first
+         */
+        std::deque<ring_region> retired_regions;
+
+        /*!
+         * \brief Which parts of the ring are in use. The newest allocation is this frame's region, if there is one, and
+         * the others are the retired regions, in the same order. Remade with the GL objects, once the SSBO alignment
+         * is known
+         */
+        ring_allocator ring{RING_SIZE, 256};
+
+        GLuint buffer = 0;
+        uint8_t* mapped_data = nullptr;
+        GLint storage_buffer_alignment = 256;
+
+        bool warned_about_ring_size = false;
+
+        void create_gl_objects();
+
+        /*!
+         * \brief Finds space for the given number of bytes, waiting on old regions if needed
+         *
+         * \return The offset of the space in the ring
+         */
+        GLsizeiptr allocate(GLsizeiptr size);
+
+        /*!
+         * \brief Frees the oldest retired region
+         *
+         * \param wait If true, waits for the GPU to finish with the region. If false, only frees it if the GPU is
+         * already done
+         * \return True if the region was freed
+         */
+        bool retire_oldest_region(bool wait);
+    };
+}
+
+#endif //RENDERER_ENTITY_RENDERER_H
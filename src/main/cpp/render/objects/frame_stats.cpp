@@ -0,0 +1,274 @@
+/*!
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <atomic>
+#include <utility>
+#include <easylogging++.h>
+#include "frame_stats.h"
+#include "gl_state.h"
+
+namespace nova {
+    static const GLenum PIPELINE_STATISTICS_TARGETS[] = {
+            GL_PRIMITIVES_SUBMITTED,
+            GL_VERTEX_SHADER_INVOCATIONS,
+            GL_CLIPPING_OUTPUT_PRIMITIVES,
+            GL_FRAGMENT_SHADER_INVOCATIONS,
+    };
+    static const int NUM_PIPELINE_STATISTICS = sizeof(PIPELINE_STATISTICS_TARGETS) / sizeof(GLenum);
+
+    /*!
+     * \brief How many frames of queries can be waiting on the GPU. It's more than maxFramesInFlight usually is, so
+     * end_frame hardly ever has to wait for results
+     */
+    static const size_t NUM_QUERY_FRAMES = 4;
+
+    struct pass_queries {
+        GLuint queries[NUM_PIPELINE_STATISTICS];
+    };
+
+    /*!
+     * \brief A frame whose counts are done, but whose queries may not be
+     */
+    struct pending_frame {
+        frame_statistics stats;
+
+        /*!
+         * \brief A set of queries for each pass in stats. They're kept when the frame is reused, so they only have to
+         * be made once
+         */
+        std::vector<pass_queries> queries;
+
+        bool is_waiting = false;
+    };
+
+    static frame_statistics current_frame;
+    static frame_statistics last_frame;
+    static uint64_t num_frames = 0;
+
+    static std::atomic<uint64_t> performance_warnings(0);
+
+    static bool pipeline_statistics_enabled = false;
+    static pending_frame pending_frames[NUM_QUERY_FRAMES];
+    static size_t current_pending_frame = 0;
+
+    /*!
+     * \brief True if the frame being counted has queries running, false if its counts are published as soon as it ends
+     */
+    static bool frame_has_queries = false;
+
+    static bool in_pass = false;
+
+    /*!
+     * \brief The names of the passes of frames that have been recycled. Each new pass takes one, so after the first
+     * few frames pass names are copied into strings that already have room for them
+     */
+    static std::vector<std::string> spare_pass_names;
+
+    /*!
+     * \brief Clears the frame's counts and passes, but keeps the memory its passes and their names used
+     */
+    static void recycle_frame(frame_statistics& stats) {
+        // Backwards, so passes take the names back in the order they gave them up
+        for(auto pass = stats.passes.rbegin(); pass != stats.passes.rend(); ++pass) {
+            spare_pass_names.push_back(std::move(pass->name));
+        }
+
+        auto passes = std::move(stats.passes);
+        passes.clear();
+        stats = frame_statistics();
+        stats.passes = std::move(passes);
+    }
+
+    static bool supports_pipeline_statistics() {
+        return GLAD_GL_VERSION_4_6 || GLAD_GL_ARB_pipeline_statistics_query;
+    }
+
+    /*!
+     * \brief Reads the frame's queries into its passes and makes it the last frame
+     *
+     * \param wait If true, waits for the GPU to finish the frame. If false, only reads the frame if it's done
+     * \return True if the frame was read
+     */
+    static bool read_pending_frame(pending_frame& frame, bool wait) {
+        auto& passes = frame.stats.passes;
+        if(!wait && !passes.empty()) {
+            // Queries finish in order, so the last one tells us about all of them
+            GLuint is_available = GL_FALSE;
+            glGetQueryObjectuiv(frame.queries[passes.size() - 1].queries[NUM_PIPELINE_STATISTICS - 1], GL_QUERY_RESULT_AVAILABLE, &is_available);
+            if(is_available == GL_FALSE) {
+                return false;
+            }
+        }
+
+        for(size_t pass_idx = 0; pass_idx < passes.size(); pass_idx++) {
+            GLuint64 results[NUM_PIPELINE_STATISTICS];
+            for(int i = 0; i < NUM_PIPELINE_STATISTICS; i++) {
+                glGetQueryObjectui64v(frame.queries[pass_idx].queries[i], GL_QUERY_RESULT, &results[i]);
+            }
+
+            auto& pass = passes[pass_idx];
+            pass.primitives_submitted = results[0];
+            pass.vertex_shader_invocations = results[1];
+            pass.clipping_output_primitives = results[2];
+            pass.fragment_shader_invocations = results[3];
+        }
+
+        // The frame that used to be last is recycled when this slot is used again
+        std::swap(last_frame, frame.stats);
+        frame.is_waiting = false;
+        return true;
+    }
+
+    /*!
+     * \brief Reads the waiting frames, oldest first
+     *
+     * \param wait If true, waits for all of them. If false, stops at the first one that's not done
+     */
+    static void read_pending_frames(bool wait) {
+        for(size_t i = 0; i < NUM_QUERY_FRAMES; i++) {
+            auto& frame = pending_frames[(current_pending_frame + i) % NUM_QUERY_FRAMES];
+            if(frame.is_waiting && !read_pending_frame(frame, wait)) {
+                return;
+            }
+        }
+    }
+
+    void frame_stats::set_pipeline_statistics_enabled(bool enabled) {
+        if(enabled && !supports_pipeline_statistics()) {
+            LOG(WARNING) << "pipelineStatistics is on, but this driver doesn't have GL_ARB_pipeline_statistics_query";
+        }
+        pipeline_statistics_enabled = enabled;
+    }
+
+    void frame_stats::count_draw(uint64_t num_triangles) {
+        current_frame.draw_calls++;
+        current_frame.draw_commands++;
+        current_frame.triangles += num_triangles;
+    }
+
+    void frame_stats::count_multi_draw(uint64_t num_commands) {
+        current_frame.draw_calls++;
+        current_frame.draw_commands += num_commands;
+    }
+
+    void frame_stats::count_triangles(uint64_t num_triangles) {
+        current_frame.triangles += num_triangles;
+    }
+
+    void frame_stats::count_texture_bind() {
+        current_frame.texture_binds++;
+    }
+
+    void frame_stats::count_upload(uint64_t num_bytes) {
+        current_frame.bytes_uploaded += num_bytes;
+    }
+
+    void frame_stats::count_performance_warning() {
+        performance_warnings++;
+    }
+
+    void frame_stats::begin_pass(const std::string& name) {
+        if(in_pass) {
+            LOG(WARNING) << "Pass " << current_frame.passes.back().name << " was still going when pass " << name << " began";
+            end_pass();
+        }
+
+        // The pass holds the frame's totals until it ends, then gets what it added to them
+        current_frame.passes.emplace_back();
+        auto& pass = current_frame.passes.back();
+        if(!spare_pass_names.empty()) {
+            pass.name = std::move(spare_pass_names.back());
+            spare_pass_names.pop_back();
+        }
+        pass.name.assign(name);
+        pass.draw_calls = current_frame.draw_calls;
+        pass.draw_commands = current_frame.draw_commands;
+        pass.triangles = current_frame.triangles;
+        in_pass = true;
+
+        if(frame_has_queries) {
+            auto& frame = pending_frames[current_pending_frame];
+            const size_t pass_idx = current_frame.passes.size() - 1;
+            if(frame.queries.size() <= pass_idx) {
+                pass_queries new_queries = {};
+                for(int i = 0; i < NUM_PIPELINE_STATISTICS; i++) {
+                    glCreateQueries(PIPELINE_STATISTICS_TARGETS[i], 1, &new_queries.queries[i]);
+                }
+                frame.queries.push_back(new_queries);
+            }
+
+            for(int i = 0; i < NUM_PIPELINE_STATISTICS; i++) {
+                glBeginQuery(PIPELINE_STATISTICS_TARGETS[i], frame.queries[pass_idx].queries[i]);
+            }
+        }
+    }
+
+    void frame_stats::end_pass() {
+        if(!in_pass) {
+            return;
+        }
+
+        auto& pass = current_frame.passes.back();
+        pass.draw_calls = current_frame.draw_calls - pass.draw_calls;
+        pass.draw_commands = current_frame.draw_commands - pass.draw_commands;
+        pass.triangles = current_frame.triangles - pass.triangles;
+
+        if(frame_has_queries) {
+            for(const auto target : PIPELINE_STATISTICS_TARGETS) {
+                glEndQuery(target);
+            }
+        }
+        in_pass = false;
+    }
+
+    void frame_stats::end_frame() {
+        end_pass();
+
+        current_frame.state_changes = gl_state::get_calls_made_last_frame();
+        current_frame.state_changes_saved = gl_state::get_calls_saved_last_frame();
+        current_frame.performance_warnings = performance_warnings.exchange(0);
+
+        if(frame_has_queries) {
+            auto& frame = pending_frames[current_pending_frame];
+            std::swap(frame.stats, current_frame);
+            frame.is_waiting = true;
+            current_pending_frame = (current_pending_frame + 1) % NUM_QUERY_FRAMES;
+            read_pending_frames(false);
+
+        } else {
+            // Frames from before pipeline statistics were turned off have to come out first
+            read_pending_frames(true);
+            std::swap(last_frame, current_frame);
+        }
+
+        frame_has_queries = pipeline_statistics_enabled && supports_pipeline_statistics();
+        if(frame_has_queries && pending_frames[current_pending_frame].is_waiting) {
+            // The GPU is more than NUM_QUERY_FRAMES behind, which limit_frames_in_flight should stop from happening
+            read_pending_frame(pending_frames[current_pending_frame], true);
+        }
+
+        // Whatever frame was swapped out is reused, so counting passes doesn't allocate once the vectors are big enough
+        num_frames++;
+        recycle_frame(current_frame);
+        current_frame.frame = num_frames;
+        current_frame.has_pipeline_statistics = frame_has_queries;
+    }
+
+    const frame_statistics& frame_stats::get_last_frame() {
+        return last_frame;
+    }
+
+    void frame_stats::destroy() {
+        for(auto& frame : pending_frames) {
+            for(auto& queries : frame.queries) {
+                glDeleteQueries(NUM_PIPELINE_STATISTICS, queries.queries);
+            }
+            frame.queries.clear();
+            frame.is_waiting = false;
+        }
+        frame_has_queries = false;
+        in_pass = false;
+    }
+}
@@ -0,0 +1,155 @@
+/*!
+ * \brief Counts what each frame asks of the GPU: draws, triangles, state changes, texture binds, and uploads
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_FRAME_STATS_H
+#define RENDERER_FRAME_STATS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+
+namespace nova {
+    /*!
+     * \brief What one pass of the frame graph drew
+     */
+    struct pass_statistics {
+        std::string name;
+
+        /*!
+         * \brief How many draw calls were made. A multi-draw is one call
+         */
+        uint64_t draw_calls = 0;
+
+        /*!
+         * \brief How many meshes were drawn. A multi-draw counts every command in it
+         */
+        uint64_t draw_commands = 0;
+
+        /*!
+         * \brief How many triangles were sent, before any culling on the GPU
+         */
+        uint64_t triangles = 0;
+
+        /*!
+         * \brief The pipeline statistics queries for the pass. Only filled in if has_pipeline_statistics is true on the
+         * frame
+         */
+        uint64_t primitives_submitted = 0;
+        uint64_t vertex_shader_invocations = 0;
+        uint64_t clipping_output_primitives = 0;
+        uint64_t fragment_shader_invocations = 0;
+    };
+
+    /*!
+     * \brief Everything that was counted during one frame
+     */
+    struct frame_statistics {
+        /*!
+         * \brief Which frame this is, counting from when Nova started
+         */
+        uint64_t frame = 0;
+
+        uint64_t draw_calls = 0;
+        uint64_t draw_commands = 0;
+        uint64_t triangles = 0;
+
+        /*!
+         * \brief Calls that gl_state passed on to the driver, and calls it dropped because they wouldn't change anything
+         */
+        uint64_t state_changes = 0;
+        uint64_t state_changes_saved = 0;
+
+        /*!
+         * \brief Texture binds that actually reached the driver
+         */
+        uint64_t texture_binds = 0;
+
+        /*!
+         * \brief Bytes of geometry, textures, and draw commands that were copied to the GPU
+         */
+        uint64_t bytes_uploaded = 0;
+
+        /*!
+         * \brief How many GL_DEBUG_TYPE_PERFORMANCE messages the driver sent
+         */
+        uint64_t performance_warnings = 0;
+
+        /*!
+         * \brief True if the passes have their pipeline statistics. They need pipelineStatistics to be on and either
+         * OpenGL 4.6 or GL_ARB_pipeline_statistics_query
+         */
+        bool has_pipeline_statistics = false;
+
+        std::vector<pass_statistics> passes;
+    };
+
+    /*!
+     * \brief Collects the counts for each frame and hands out the last finished one
+     *
+     * Everything that draws or uploads calls one of the count_ functions, and the frame graph puts #begin_pass and
+     * #end_pass around each pass so the counts can be split up by pass. Counting is just adding to a few integers, so
+     * it's always on.
+     *
+     * With pipeline statistics turned on, each pass also gets a set of GL_ARB_pipeline_statistics_query queries. Their
+     * results are read a few frames later so the CPU never waits on the GPU, and the CPU counts are held back until
+     * then so every number in a snapshot is from the same frame. Only one query per target can be running, so passes
+     * can't be nested.
+     *
+     * Like gl_state, this is all static and everything but #count_performance_warning has to be called from the
+     * thread that owns the OpenGL context. Performance warnings can come from the driver's own threads
+     */
+    class frame_stats {
+    public:
+        static void set_pipeline_statistics_enabled(bool enabled);
+
+        /*!
+         * \brief Counts one draw call that drew one mesh
+         */
+        static void count_draw(uint64_t num_triangles);
+
+        /*!
+         * \brief Counts one multi-draw call. Its triangles are counted separately with #count_triangles, since the
+         * same commands can be submitted more than once
+         */
+        static void count_multi_draw(uint64_t num_commands);
+
+        static void count_triangles(uint64_t num_triangles);
+
+        static void count_texture_bind();
+
+        static void count_upload(uint64_t num_bytes);
+
+        static void count_performance_warning();
+
+        /*!
+         * \brief Starts counting for the pass with the given name. Ends the last pass if it's still going
+         */
+        static void begin_pass(const std::string& name);
+
+        static void end_pass();
+
+        /*!
+         * \brief Finishes the frame and reads back any pipeline statistics that are ready
+         *
+         * Should be called once per frame, right after gl_state#end_frame so its counts are for the same frame
+         */
+        static void end_frame();
+
+        /*!
+         * \brief The newest frame whose statistics are all in
+         */
+        static const frame_statistics& get_last_frame();
+
+        /*!
+         * \brief Deletes the queries. Must be called before the context goes away
+         */
+        static void destroy();
+    };
+}
+
+#endif //RENDERER_FRAME_STATS_H
@@ -3,6 +3,8 @@
 //
 
 #include "framebuffer.h"
+#include "gl_state.h"
+#include "gpu_memory.h"
 #include <easylogging++.h>
 
 namespace nova {
@@ -18,6 +20,8 @@ namespace nova {
         // TODO: Set texture format
         for(unsigned int i = 0; i < num_color_attachments; i++) {
             glTextureStorage2D(color_attachments[i], 1, GL_RGBA8, width, height);
+            gpu_memory::track_texture(color_attachments[i], gpu_memory_category::framebuffers,
+                                      gpu_memory::get_texture_size(GL_RGBA8, width, height));
             glNamedFramebufferTexture(framebuffer_id, GL_COLOR_ATTACHMENT0 + i, color_attachments[i], 0);
             color_attachments_map[i] = color_attachments[i];
         }
@@ -36,7 +40,7 @@ namespace nova {
 
     framebuffer::~framebuffer() {
         LOG(TRACE) << "Deleting framebuffer " << framebuffer_id;
-        glDeleteTextures(color_attachments_map.size(), color_attachments);
+        gl_state::delete_textures(color_attachments_map.size(), color_attachments);
         glDeleteFramebuffers(1, &framebuffer_id);
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
     }
@@ -114,7 +118,11 @@ namespace nova {
     }
 
     framebuffer framebuffer_builder::build() {
-        auto num_color_attachments = *enabled_color_attachments.rbegin();
+        // Attachments are indexed from zero, so the highest enabled index plus one is how many we need
+        unsigned int num_color_attachments = 0;
+        if(!enabled_color_attachments.empty()) {
+            num_color_attachments = *enabled_color_attachments.rbegin() + 1;
+        }
 
         return framebuffer(width, height, num_color_attachments);
     }
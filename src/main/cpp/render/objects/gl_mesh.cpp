@@ -3,13 +3,18 @@
  * \date 13-May-16.
  */
 
+#include <algorithm>
 #include <stdexcept>
 #include <easylogging++.h>
 #include "gl_mesh.h"
+#include "gl_state.h"
+#include "frame_stats.h"
+#include "gpu_memory.h"
+#include "vertex_formats.h"
 #include "../windowing/glfw_gl_window.h"
 
 namespace nova {
-    gl_mesh::gl_mesh() : vertex_array(0), vertex_buffer(0), indices(0), num_indices(0) {
+    gl_mesh::gl_mesh() : vertex_array(0), vertex_buffer(0), indices(0), num_indices(0), index_type(GL_UNSIGNED_INT) {
         create();
     }
 
@@ -25,7 +30,7 @@ namespace nova {
 
     void gl_mesh::create() {
         glGenVertexArrays(1, &vertex_array);
-        glBindVertexArray(vertex_array);
+        gl_state::bind_vertex_array(vertex_array);
         glGenBuffers(1, &vertex_buffer);
         glGenBuffers(1, &indices);
     }
@@ -33,26 +38,35 @@ namespace nova {
     void gl_mesh::destroy() {
         if(vertex_buffer != 0) {
             if(glfwGetCurrentContext() != nullptr) {
-                glDeleteBuffers(1, &vertex_buffer);
+                gl_state::delete_buffers(1, &vertex_buffer);
             }
             vertex_buffer = 0;
         }
 
         if(indices != 0) {
             if(glfwGetCurrentContext() != nullptr) {
-                glDeleteBuffers(1, &indices);
+                gl_state::delete_buffers(1, &indices);
             }
             indices = 0;
         }
+
+        if(vertex_array != 0) {
+            if(glfwGetCurrentContext() != nullptr) {
+                gl_state::delete_vertex_arrays(1, &vertex_array);
+            }
+            vertex_array = 0;
+        }
     }
 
-    void gl_mesh::set_data(std::vector<int> data, format data_format, usage data_usage) {
+    void gl_mesh::set_data(const std::vector<int>& data, format data_format, usage data_usage) {
         this->data_format = data_format;
 
-        glBindVertexArray(vertex_array);
-        glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+        gl_state::bind_vertex_array(vertex_array);
+        gl_state::bind_buffer(GL_ARRAY_BUFFER, vertex_buffer);
         GLenum buffer_usage = translate_usage(data_usage);
         glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), data.data(), buffer_usage);
+        frame_stats::count_upload(data.size() * sizeof(float));
+        gpu_memory::track_buffer(vertex_buffer, gpu_memory_category::meshes, data.size() * sizeof(float));
 
         enable_vertex_attributes(data_format);
     }
@@ -67,83 +81,48 @@ namespace nova {
     }
 
     void gl_mesh::set_active() const {
-        glBindVertexArray(vertex_array);
-        glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices);
+        // The vertex array already knows about the vertex and index buffers
+        gl_state::bind_vertex_array(vertex_array);
     }
 
-    void gl_mesh::set_index_array(std::vector<int> data, usage data_usage) {
-        glBindVertexArray(vertex_array);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices);
+    void gl_mesh::set_index_array(const std::vector<int>& data, usage data_usage) {
+        gl_state::bind_vertex_array(vertex_array);
+        gl_state::bind_buffer(GL_ELEMENT_ARRAY_BUFFER, indices);
         GLenum buffer_usage = translate_usage(data_usage);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, data.size() * sizeof(unsigned int), data.data(), buffer_usage);
+
+        const auto index_range = std::minmax_element(data.begin(), data.end());
+        const bool fits_in_shorts = data.empty() || (*index_range.first >= 0 && *index_range.second <= UINT16_MAX);
+
+        size_t data_size;
+        if(fits_in_shorts) {
+            std::vector<uint16_t> short_indices(data.begin(), data.end());
+            data_size = short_indices.size() * sizeof(uint16_t);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, data_size, short_indices.data(), buffer_usage);
+            index_type = GL_UNSIGNED_SHORT;
+        } else {
+            data_size = data.size() * sizeof(unsigned int);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, data_size, data.data(), buffer_usage);
+            index_type = GL_UNSIGNED_INT;
+        }
+        frame_stats::count_upload(data_size);
+        gpu_memory::track_buffer(indices, gpu_memory_category::meshes, data_size);
 
         num_indices = (unsigned int) data.size();
     }
 
     void gl_mesh::draw() const {
-        glDrawElements(GL_TRIANGLES, num_indices, GL_UNSIGNED_INT, nullptr);
+        glDrawElements(GL_TRIANGLES, num_indices, index_type, nullptr);
+        frame_stats::count_draw(num_indices / 3);
     }
 
-    void gl_mesh::enable_vertex_attributes(format data_format) {
-        switch(data_format) {
-            case format::POS:
-                // We only need to set up positional data
-                // Positions are always at vertex attribute 0
-                glEnableVertexAttribArray(0);   // Position
-
-                glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
-
-                break;
-
-            case format::POS_UV:
-                glEnableVertexAttribArray(0);   // Position
-                glEnableVertexAttribArray(1);   // Texture UV
-
-                glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), nullptr);
-                glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void *) (3 * sizeof(GLfloat)));
-
-                break;
-
-            case format::POS_UV_COLOR:
-                glEnableVertexAttribArray(0);   // Position
-                glEnableVertexAttribArray(1);   // Texture UV
-                glEnableVertexAttribArray(2);   // Vertex color
-
-                glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(GLfloat), nullptr);
-                glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 9 * sizeof(GLfloat), (void *) (3 * sizeof(GLfloat)));
-                glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, 9 * sizeof(GLfloat), (void *) (5 * sizeof(GLfloat)));
-
-                break;
-
-            case format::POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT:
-                glEnableVertexAttribArray(0);   // Position
-                glEnableVertexAttribArray(1);   // Texture UV
-                glEnableVertexAttribArray(2);   // Lightmap UV
-                glEnableVertexAttribArray(3);   // Normal
-                glEnableVertexAttribArray(4);   // Tangent
-                glEnableVertexAttribArray(5);   // Color
-
-                // position
-                glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 13 * sizeof(GLfloat), nullptr);
-
-                // color
-                glVertexAttribPointer(5, 4, GL_UNSIGNED_BYTE, GL_FALSE, 13 * sizeof(GLfloat), (void *) (12 * sizeof(GLbyte)));
-
-                // texture UV
-                glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 13 * sizeof(GLfloat), (void *) (16 * sizeof(GLbyte)));
-
-                // lightmap UV
-                glVertexAttribPointer(2, 2, GL_SHORT, GL_FALSE, 13 * sizeof(GLfloat), (void *) (24 * sizeof(GLbyte)));
-
-                // normal
-                glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 13 * sizeof(GLfloat), (void *) (32 * sizeof(GLbyte)));
-
-                // tangent
-                glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 13 * sizeof(GLfloat), (void *) (44 * sizeof(GLbyte)));
+    void gl_mesh::draw_instanced(GLsizei num_instances, GLuint base_instance) const {
+        glDrawElementsInstancedBaseInstance(GL_TRIANGLES, num_indices, index_type, nullptr, num_instances, base_instance);
+        frame_stats::count_draw(static_cast<uint64_t>(num_indices / 3) * num_instances);
+    }
 
-                break;
-        }
+    void gl_mesh::enable_vertex_attributes(format data_format) {
+        set_vertex_attributes(vertex_array, data_format, 0);
+        glVertexArrayVertexBuffer(vertex_array, 0, vertex_buffer, 0, get_vertex_stride(data_format));
     }
 
     format gl_mesh::get_format() {
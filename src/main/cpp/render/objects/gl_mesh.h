@@ -51,14 +51,26 @@ namespace nova {
          * \param data The interleaved vertex data
          * \param data_format The format of the data (\see format)
          */
-        void set_data(std::vector<int> data, format data_format, usage data_usage);
+        void set_data(const std::vector<int>& data, format data_format, usage data_usage);
 
-        void set_index_array(std::vector<int> data, usage data_usage);
+        /*!
+         * \brief Uploads the given indices. If they all fit in 16 bits, which they do for any mesh with fewer than
+         * 65536 vertices, they're uploaded as shorts to halve their size
+         */
+        void set_index_array(const std::vector<int>& data, usage data_usage);
 
         void set_active() const;
 
         void draw() const;
 
+        /*!
+         * \brief Draws the mesh the given number of times with one glDrawElementsInstancedBaseInstance
+         *
+         * \param num_instances How many copies to draw
+         * \param base_instance Where gl_BaseInstanceARB starts
+         */
+        void draw_instanced(GLsizei num_instances, GLuint base_instance) const;
+
         /*!
          * \brief Returns the format of this vertex buffer
          *
@@ -79,12 +91,14 @@ namespace nova {
         /*!
          * \brief Enables all the proper OpenGL vertex attributes for the given format
          *
-         * Enables the proper vertex attribute array bind points and the vertex attribute pointers
+         * The attributes come from the format's layout in vertex_formats.h, and read from the vertex buffer at
+         * binding 0
          */
         void enable_vertex_attributes(format data_format);
 
         unsigned int vertex_array;
         unsigned int num_indices;
+        GLenum index_type;  //!< GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
     };
 }
 
@@ -0,0 +1,305 @@
+/*!
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include "gl_state.h"
+#include "frame_stats.h"
+#include "gpu_memory.h"
+
+namespace nova {
+    /*!
+     * \brief Stands in for state the cache doesn't know, so the next call always goes to the driver
+     */
+    static const GLuint UNKNOWN = 0xFFFFFFFF;
+
+    static const GLenum TRACKED_BUFFER_TARGETS[] = {
+            GL_ARRAY_BUFFER,
+            GL_ELEMENT_ARRAY_BUFFER,
+            GL_PIXEL_UNPACK_BUFFER,
+            GL_PIXEL_PACK_BUFFER,
+            GL_DRAW_INDIRECT_BUFFER,
+            GL_UNIFORM_BUFFER,
+            GL_SHADER_STORAGE_BUFFER,
+            GL_COPY_READ_BUFFER,
+            GL_COPY_WRITE_BUFFER,
+    };
+    static const int NUM_BUFFER_TARGETS = sizeof(TRACKED_BUFFER_TARGETS) / sizeof(GLenum);
+
+    static const GLenum TRACKED_CAPABILITIES[] = {
+            GL_DEPTH_TEST,
+            GL_BLEND,
+            GL_CULL_FACE,
+            GL_SCISSOR_TEST,
+            GL_STENCIL_TEST,
+    };
+    static const int NUM_CAPABILITIES = sizeof(TRACKED_CAPABILITIES) / sizeof(GLenum);
+
+    static const int NUM_TEXTURE_UNITS = 32;
+
+    struct cached_state {
+        GLuint program;
+        GLuint vertex_array;
+        GLuint buffers[NUM_BUFFER_TARGETS];
+        GLuint active_texture_unit;
+        GLuint textures[NUM_TEXTURE_UNITS];
+        GLuint capabilities[NUM_CAPABILITIES];
+        GLuint blend_source;
+        GLuint blend_destination;
+        GLuint blend_source_alpha;
+        GLuint blend_destination_alpha;
+        GLuint depth_func;
+        GLuint depth_mask;
+    };
+
+    /*!
+     * \brief Marks everything in the state as unknown
+     */
+    static void forget_everything(cached_state& state) {
+        state.program = UNKNOWN;
+        state.vertex_array = UNKNOWN;
+        for(auto& buffer : state.buffers) {
+            buffer = UNKNOWN;
+        }
+        state.active_texture_unit = UNKNOWN;
+        for(auto& texture : state.textures) {
+            texture = UNKNOWN;
+        }
+        for(auto& capability : state.capabilities) {
+            capability = UNKNOWN;
+        }
+        state.blend_source = UNKNOWN;
+        state.blend_destination = UNKNOWN;
+        state.blend_source_alpha = UNKNOWN;
+        state.blend_destination_alpha = UNKNOWN;
+        state.depth_func = UNKNOWN;
+        state.depth_mask = UNKNOWN;
+    }
+
+    static cached_state make_unknown_state() {
+        cached_state state;
+        forget_everything(state);
+        return state;
+    }
+
+    static cached_state state = make_unknown_state();
+
+    static uint64_t calls_saved = 0;
+    static uint64_t calls_made = 0;
+    static uint64_t calls_saved_last_frame = 0;
+    static uint64_t calls_made_last_frame = 0;
+
+    /*!
+     * \brief Sets the cached value to the new value and returns true if the GL call needs to be made
+     */
+    static bool update(GLuint& cached, GLuint value) {
+        if(cached == value) {
+            calls_saved++;
+            return false;
+        }
+
+        cached = value;
+        calls_made++;
+        return true;
+    }
+
+    static int get_buffer_target_index(GLenum target) {
+        for(int i = 0; i < NUM_BUFFER_TARGETS; i++) {
+            if(TRACKED_BUFFER_TARGETS[i] == target) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    static int get_capability_index(GLenum capability) {
+        for(int i = 0; i < NUM_CAPABILITIES; i++) {
+            if(TRACKED_CAPABILITIES[i] == capability) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    static GLuint& get_element_array_buffer() {
+        return state.buffers[get_buffer_target_index(GL_ELEMENT_ARRAY_BUFFER)];
+    }
+
+    void gl_state::use_program(GLuint program) {
+        if(update(state.program, program)) {
+            glUseProgram(program);
+        }
+    }
+
+    void gl_state::bind_vertex_array(GLuint vertex_array) {
+        if(update(state.vertex_array, vertex_array)) {
+            glBindVertexArray(vertex_array);
+            get_element_array_buffer() = UNKNOWN;
+        }
+    }
+
+    void gl_state::bind_buffer(GLenum target, GLuint buffer) {
+        int target_idx = get_buffer_target_index(target);
+        if(target_idx < 0) {
+            calls_made++;
+            glBindBuffer(target, buffer);
+
+        } else if(update(state.buffers[target_idx], buffer)) {
+            glBindBuffer(target, buffer);
+        }
+    }
+
+    void gl_state::bind_buffer_range(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+        calls_made++;
+        glBindBufferRange(target, index, buffer, offset, size);
+
+        int target_idx = get_buffer_target_index(target);
+        if(target_idx >= 0) {
+            state.buffers[target_idx] = buffer;
+        }
+    }
+
+    void gl_state::bind_texture_unit(GLuint unit, GLuint texture) {
+        if(unit >= NUM_TEXTURE_UNITS) {
+            calls_made++;
+            frame_stats::count_texture_bind();
+            glBindTextureUnit(unit, texture);
+
+        } else if(update(state.textures[unit], texture)) {
+            frame_stats::count_texture_bind();
+            glBindTextureUnit(unit, texture);
+        }
+    }
+
+    void gl_state::bind_texture_2d(GLuint unit, GLuint texture) {
+        if(update(state.active_texture_unit, unit)) {
+            glActiveTexture(GL_TEXTURE0 + unit);
+        }
+
+        if(unit >= NUM_TEXTURE_UNITS) {
+            calls_made++;
+            frame_stats::count_texture_bind();
+            glBindTexture(GL_TEXTURE_2D, texture);
+
+        } else if(update(state.textures[unit], texture)) {
+            frame_stats::count_texture_bind();
+            glBindTexture(GL_TEXTURE_2D, texture);
+        }
+    }
+
+    void gl_state::set_enabled(GLenum capability, bool enabled) {
+        int capability_idx = get_capability_index(capability);
+        if(capability_idx >= 0 && !update(state.capabilities[capability_idx], enabled ? 1u : 0u)) {
+            return;
+        }
+        if(capability_idx < 0) {
+            calls_made++;
+        }
+
+        if(enabled) {
+            glEnable(capability);
+        } else {
+            glDisable(capability);
+        }
+    }
+
+    void gl_state::blend_func(GLenum source_factor, GLenum destination_factor) {
+        blend_func_separate(source_factor, destination_factor, source_factor, destination_factor);
+    }
+
+    void gl_state::blend_func_separate(GLenum source_factor, GLenum destination_factor, GLenum source_alpha_factor,
+                                       GLenum destination_alpha_factor) {
+        if(state.blend_source == source_factor && state.blend_destination == destination_factor &&
+           state.blend_source_alpha == source_alpha_factor && state.blend_destination_alpha == destination_alpha_factor) {
+            calls_saved++;
+            return;
+        }
+
+        state.blend_source = source_factor;
+        state.blend_destination = destination_factor;
+        state.blend_source_alpha = source_alpha_factor;
+        state.blend_destination_alpha = destination_alpha_factor;
+        calls_made++;
+        glBlendFuncSeparate(source_factor, destination_factor, source_alpha_factor, destination_alpha_factor);
+    }
+
+    void gl_state::depth_func(GLenum func) {
+        if(update(state.depth_func, func)) {
+            glDepthFunc(func);
+        }
+    }
+
+    void gl_state::depth_mask(bool write_depth) {
+        if(update(state.depth_mask, write_depth ? 1u : 0u)) {
+            glDepthMask(write_depth ? GL_TRUE : GL_FALSE);
+        }
+    }
+
+    void gl_state::delete_buffers(GLsizei count, const GLuint* buffers) {
+        for(GLsizei i = 0; i < count; i++) {
+            for(auto& bound_buffer : state.buffers) {
+                if(bound_buffer == buffers[i]) {
+                    bound_buffer = 0;
+                }
+            }
+            gpu_memory::untrack_buffer(buffers[i]);
+        }
+
+        glDeleteBuffers(count, buffers);
+    }
+
+    void gl_state::delete_vertex_arrays(GLsizei count, const GLuint* vertex_arrays) {
+        for(GLsizei i = 0; i < count; i++) {
+            if(state.vertex_array == vertex_arrays[i]) {
+                state.vertex_array = 0;
+                get_element_array_buffer() = UNKNOWN;
+            }
+        }
+
+        glDeleteVertexArrays(count, vertex_arrays);
+    }
+
+    void gl_state::delete_textures(GLsizei count, const GLuint* textures) {
+        for(GLsizei i = 0; i < count; i++) {
+            for(auto& bound_texture : state.textures) {
+                if(bound_texture == textures[i]) {
+                    bound_texture = 0;
+                }
+            }
+            gpu_memory::untrack_texture(textures[i]);
+        }
+
+        glDeleteTextures(count, textures);
+    }
+
+    void gl_state::delete_program(GLuint program) {
+        // A program that's in use isn't really deleted until something else is used, so whatever comes next has to
+        // be bound for real
+        if(state.program == program) {
+            state.program = UNKNOWN;
+        }
+
+        glDeleteProgram(program);
+    }
+
+    void gl_state::invalidate() {
+        forget_everything(state);
+    }
+
+    void gl_state::end_frame() {
+        calls_saved_last_frame = calls_saved;
+        calls_made_last_frame = calls_made;
+        calls_saved = 0;
+        calls_made = 0;
+
+        invalidate();
+    }
+
+    uint64_t gl_state::get_calls_saved_last_frame() {
+        return calls_saved_last_frame;
+    }
+
+    uint64_t gl_state::get_calls_made_last_frame() {
+        return calls_made_last_frame;
+    }
+}
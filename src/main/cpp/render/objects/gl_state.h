@@ -0,0 +1,114 @@
+/*!
+ * \brief A cache of OpenGL state that drops calls which wouldn't change anything
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_GL_STATE_H
+#define RENDERER_GL_STATE_H
+
+#include <cstdint>
+#include <glad/glad.h>
+
+namespace nova {
+    /*!
+     * \brief Tracks the bound program, vertex array, buffers, textures, and blend and depth state, and only calls
+     * OpenGL when one of them actually changes
+     *
+     * Everything in render/objects binds things through here. Anything that changes the same state without going
+     * through here has to call #invalidate afterwards, or the cache will skip calls that it needs to make. The cache
+     * forgets everything at the start of each frame anyway, so GL calls made between frames can't confuse it.
+     *
+     * The element array buffer binding belongs to the bound vertex array, so binding a new vertex array makes the
+     * cache forget which element array buffer is bound.
+     *
+     * There's only one OpenGL context, so this is all static. Like every other GL call, these have to be made from the
+     * thread that owns the context
+     */
+    class gl_state {
+    public:
+        static void use_program(GLuint program);
+
+        static void bind_vertex_array(GLuint vertex_array);
+
+        /*!
+         * \brief Binds the buffer to the given target. Targets that the cache doesn't know about are always bound
+         */
+        static void bind_buffer(GLenum target, GLuint buffer);
+
+        /*!
+         * \brief Binds a range of the buffer to an indexed binding point with glBindBufferRange
+         *
+         * Indexed bindings aren't cached, but glBindBufferRange also binds the buffer to the target's regular binding
+         * point, which is
+         */
+        static void bind_buffer_range(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+
+        /*!
+         * \brief Binds the texture to the given texture unit with glBindTextureUnit
+         *
+         * The texture must already have a target. A texture from glGenTextures that has never been bound doesn't, so
+         * use #bind_texture_2d for those
+         */
+        static void bind_texture_unit(GLuint unit, GLuint texture);
+
+        /*!
+         * \brief Makes the given texture unit active and binds the texture to its GL_TEXTURE_2D target, for the
+         * non-DSA texture functions
+         */
+        static void bind_texture_2d(GLuint unit, GLuint texture);
+
+        static void set_enabled(GLenum capability, bool enabled);
+
+        static void blend_func(GLenum source_factor, GLenum destination_factor);
+
+        /*!
+         * \brief Sets how colors are blended and how alphas are blended separately, with glBlendFuncSeparate
+         */
+        static void blend_func_separate(GLenum source_factor, GLenum destination_factor, GLenum source_alpha_factor,
+                                        GLenum destination_alpha_factor);
+
+        static void depth_func(GLenum func);
+
+        static void depth_mask(bool write_depth);
+
+        /*!
+         * \brief Deletes the buffers and forgets any bindings they had
+         *
+         * Deleting an object unbinds it, and OpenGL is free to give its name to the next new object. If the cache
+         * didn't know about the delete it could think that new object was already bound
+         */
+        static void delete_buffers(GLsizei count, const GLuint* buffers);
+
+        static void delete_vertex_arrays(GLsizei count, const GLuint* vertex_arrays);
+
+        static void delete_textures(GLsizei count, const GLuint* textures);
+
+        static void delete_program(GLuint program);
+
+        /*!
+         * \brief Forgets all the cached state, so every state-setting call after this goes to the driver
+         */
+        static void invalidate();
+
+        /*!
+         * \brief Saves this frame's counts of calls, then forgets the cached state for the next frame
+         *
+         * Should be called once per frame
+         */
+        static void end_frame();
+
+        /*!
+         * \brief How many calls the cache dropped during the last frame
+         */
+        static uint64_t get_calls_saved_last_frame();
+
+        /*!
+         * \brief How many calls the cache passed on to the driver during the last frame
+         */
+        static uint64_t get_calls_made_last_frame();
+    };
+}
+
+#endif //RENDERER_GL_STATE_H
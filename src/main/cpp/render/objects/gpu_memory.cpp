@@ -0,0 +1,141 @@
+/*!
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <algorithm>
+#include <unordered_map>
+#include "gpu_memory.h"
+
+namespace nova {
+    struct tracked_object {
+        gpu_memory_category category;
+        uint64_t num_bytes;
+    };
+
+    static std::unordered_map<GLuint, tracked_object> tracked_buffers;
+    static std::unordered_map<GLuint, tracked_object> tracked_textures;
+    static gpu_memory_usage usage;
+
+    static void track(std::unordered_map<GLuint, tracked_object>& objects, GLuint name, gpu_memory_category category, uint64_t num_bytes) {
+        if(name == 0) {
+            return;
+        }
+
+        auto& tracked = objects[name];
+        usage.bytes[static_cast<int>(tracked.category)] -= tracked.num_bytes;
+        tracked = {category, num_bytes};
+        usage.bytes[static_cast<int>(category)] += num_bytes;
+    }
+
+    static void untrack(std::unordered_map<GLuint, tracked_object>& objects, GLuint name) {
+        auto itr = objects.find(name);
+        if(itr == objects.end()) {
+            return;
+        }
+
+        usage.bytes[static_cast<int>(itr->second.category)] -= itr->second.num_bytes;
+        objects.erase(itr);
+    }
+
+    uint64_t gpu_memory_usage::get(gpu_memory_category category) const {
+        return bytes[static_cast<int>(category)];
+    }
+
+    uint64_t gpu_memory_usage::get_total() const {
+        uint64_t total = 0;
+        for(uint64_t category_bytes : bytes) {
+            total += category_bytes;
+        }
+        return total;
+    }
+
+    void gpu_memory::track_buffer(GLuint buffer, gpu_memory_category category, uint64_t num_bytes) {
+        track(tracked_buffers, buffer, category, num_bytes);
+    }
+
+    void gpu_memory::track_texture(GLuint texture, gpu_memory_category category, uint64_t num_bytes) {
+        track(tracked_textures, texture, category, num_bytes);
+    }
+
+    void gpu_memory::untrack_buffer(GLuint buffer) {
+        untrack(tracked_buffers, buffer);
+    }
+
+    void gpu_memory::untrack_texture(GLuint texture) {
+        untrack(tracked_textures, texture);
+    }
+
+    const gpu_memory_usage& gpu_memory::get_usage() {
+        return usage;
+    }
+
+    /*!
+     * \brief The number of bytes in each 4x4 block of a compressed format, or 0 if the format isn't block compressed
+     */
+    static uint64_t get_bytes_per_block(GLenum internal_format) {
+        switch(internal_format) {
+            case GL_COMPRESSED_RED_RGTC1:
+            case GL_COMPRESSED_SIGNED_RED_RGTC1:
+                return 8;
+            case GL_COMPRESSED_RG_RGTC2:
+            case GL_COMPRESSED_SIGNED_RG_RGTC2:
+            case GL_COMPRESSED_RGBA_BPTC_UNORM:
+            case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+            case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+            case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+                return 16;
+            default:
+                return 0;
+        }
+    }
+
+    static uint64_t get_bytes_per_pixel(GLenum internal_format) {
+        switch(internal_format) {
+            case GL_R8:
+                return 1;
+            case GL_RG8:
+            case GL_R16F:
+            case GL_DEPTH_COMPONENT16:
+                return 2;
+            case GL_DEPTH_COMPONENT24:
+                return 3;
+            case GL_RG16F:
+            case GL_R32F:
+            case GL_R32UI:
+            case GL_R11F_G11F_B10F:
+            case GL_RGB10_A2:
+            case GL_DEPTH_COMPONENT32F:
+            case GL_DEPTH24_STENCIL8:
+                return 4;
+            case GL_DEPTH32F_STENCIL8:
+                return 5;
+            case GL_RGBA16F:
+            case GL_RG32F:
+                return 8;
+            case GL_RGBA32F:
+                return 16;
+            default:
+                // RGBA8, SRGB8_ALPHA8, and everything we don't know about
+                return 4;
+        }
+    }
+
+    uint64_t gpu_memory::get_texture_size(GLenum internal_format, GLsizei width, GLsizei height, GLsizei num_levels) {
+        const uint64_t bytes_per_block = get_bytes_per_block(internal_format);
+        const uint64_t bytes_per_pixel = get_bytes_per_pixel(internal_format);
+
+        uint64_t total = 0;
+        for(GLsizei level = 0; level < std::max(num_levels, 1); level++) {
+            const uint64_t level_width = static_cast<uint64_t>(std::max(width >> level, 1));
+            const uint64_t level_height = static_cast<uint64_t>(std::max(height >> level, 1));
+
+            if(bytes_per_block > 0) {
+                total += ((level_width + 3) / 4) * ((level_height + 3) / 4) * bytes_per_block;
+            } else {
+                total += level_width * level_height * bytes_per_pixel;
+            }
+        }
+        return total;
+    }
+}
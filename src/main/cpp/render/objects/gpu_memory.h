@@ -0,0 +1,69 @@
+/*!
+ * \brief Keeps track of how much GPU memory Nova's buffers and textures take up
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_GPU_MEMORY_H
+#define RENDERER_GPU_MEMORY_H
+
+#include <cstdint>
+#include <glad/glad.h>
+
+namespace nova {
+    /*!
+     * \brief What a tracked buffer or texture is used for
+     */
+    enum class gpu_memory_category {
+        chunk_arena,    //!< The chunk arena's pages, whether or not anything has been allocated in them
+        meshes,         //!< The vertex and index buffers of every gl_mesh
+        textures,       //!< Block, item, GUI, and font textures
+        framebuffers,   //!< Everything that gets rendered to or into, like the frame graph's attachments
+        buffers,        //!< Uniform buffers, upload rings, and everything else
+    };
+
+    const int NUM_GPU_MEMORY_CATEGORIES = 5;
+
+    /*!
+     * \brief How many bytes each category of GPU memory is using
+     */
+    struct gpu_memory_usage {
+        uint64_t bytes[NUM_GPU_MEMORY_CATEGORIES] = {};
+
+        uint64_t get(gpu_memory_category category) const;
+
+        uint64_t get_total() const;
+    };
+
+    /*!
+     * \brief Records the size of every buffer and texture that's made, and forgets them when they're deleted
+     *
+     * Whatever creates a buffer or texture calls #track_buffer or #track_texture once it's given it storage. Calling
+     * them again for the same object replaces its old size. gl_state's delete functions untrack whatever they delete,
+     * so nothing else has to remember to. Buffers and textures that are never tracked just aren't counted.
+     *
+     * Like gl_state, this is all static and has to be used from the thread that owns the OpenGL context
+     */
+    class gpu_memory {
+    public:
+        static void track_buffer(GLuint buffer, gpu_memory_category category, uint64_t num_bytes);
+
+        static void track_texture(GLuint texture, gpu_memory_category category, uint64_t num_bytes);
+
+        static void untrack_buffer(GLuint buffer);
+
+        static void untrack_texture(GLuint texture);
+
+        static const gpu_memory_usage& get_usage();
+
+        /*!
+         * \brief Works out how many bytes a texture with the given format and size takes, counting all its mip levels
+         *
+         * Formats that aren't known are guessed to have four bytes per pixel
+         */
+        static uint64_t get_texture_size(GLenum internal_format, GLsizei width, GLsizei height, GLsizei num_levels = 1);
+    };
+}
+
+#endif //RENDERER_GPU_MEMORY_H
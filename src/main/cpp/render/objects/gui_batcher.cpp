@@ -0,0 +1,280 @@
+/*!
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <cstring>
+#include <easylogging++.h>
+#include "gui_batcher.h"
+#include "frame_stats.h"
+#include "gpu_memory.h"
+#include "gl_state.h"
+#include "../windowing/glfw_gl_window.h"
+
+namespace nova {
+    /*!
+     * \brief The number of floats in each POS_UV_COLOR vertex
+     */
+    static const int FLOATS_PER_VERTEX = 9;
+
+    /*!
+     * \brief Every region starts at a multiple of this many bytes
+     */
+    static const GLsizeiptr REGION_ALIGNMENT = 16;
+
+    static GLsizeiptr align(GLsizeiptr offset) {
+        return ((offset + REGION_ALIGNMENT - 1) / REGION_ALIGNMENT) * REGION_ALIGNMENT;
+    }
+
+    /*!
+     * \brief Turns a resource path like textures/gui/widgets.png into the name the texture manager uses, like
+     * minecraft:gui/widgets
+     */
+    static std::string get_texture_name(const std::string& texture_path) {
+        static const std::string PREFIX = "textures/";
+        static const std::string SUFFIX = ".png";
+
+        size_t begin = 0;
+        size_t end = texture_path.size();
+        if(texture_path.compare(0, PREFIX.size(), PREFIX) == 0) {
+            begin = PREFIX.size();
+        }
+        if(end - begin >= SUFFIX.size() && texture_path.compare(end - SUFFIX.size(), SUFFIX.size(), SUFFIX) == 0) {
+            end -= SUFFIX.size();
+        }
+
+        return "minecraft:" + texture_path.substr(begin, end - begin);
+    }
+
+    gui_batcher::gui_batcher() : ring(RING_SIZE, REGION_ALIGNMENT) {}
+
+    gui_batcher::~gui_batcher() {
+        if(buffer == 0 || glfwGetCurrentContext() == nullptr) {
+            return;
+        }
+
+        for(auto& region : retired_regions) {
+            glDeleteSync(region.fence);
+        }
+
+        gl_state::delete_vertex_arrays(1, &vao);
+        glUnmapNamedBuffer(buffer);
+        gl_state::delete_buffers(1, &buffer);
+    }
+
+    void gui_batcher::add_geometry(const mc_gui_geometry& command, texture_manager& textures) {
+        if(command.vertex_buffer_size < FLOATS_PER_VERTEX || command.index_buffer_size <= 0) {
+            return;
+        }
+
+        // The path goes into a string that's kept around, so looking up a sprite we already know doesn't allocate
+        texture_path.assign(command.texture_name == nullptr ? "" : command.texture_name);
+        const sprite_handle sprite = get_sprite(texture_path, textures);
+
+        const auto first_vertex = static_cast<uint32_t>(vertices.size() / FLOATS_PER_VERTEX);
+        const int num_vertices = command.vertex_buffer_size / FLOATS_PER_VERTEX;
+        const int num_floats = num_vertices * FLOATS_PER_VERTEX;
+
+        vertices.insert(vertices.end(), command.vertex_buffer, command.vertex_buffer + num_floats);
+        vertex_sprites.insert(vertex_sprites.end(), static_cast<size_t>(num_vertices), sprite);
+
+        // Every command's indices start at zero, so move them to where the command's vertices ended up
+        const auto first_index = static_cast<uint32_t>(indices.size());
+        for(int i = 0; i < command.index_buffer_size; i++) {
+            indices.push_back(static_cast<uint32_t>(command.index_buffer[i]) + first_vertex);
+        }
+
+        const char* atlas_name = command.atlas_name == nullptr ? "" : command.atlas_name;
+        if(!batches.empty() && batches.back().atlas_name == atlas_name) {
+            batches.back().num_indices += command.index_buffer_size;
+
+        } else {
+            gui_batch batch;
+            batch.atlas_name = atlas_name;
+            batch.atlas = textures.get_texture_handle(batch.atlas_name);
+            batch.first_index = first_index;
+            batch.num_indices = static_cast<uint32_t>(command.index_buffer_size);
+            batches.push_back(batch);
+        }
+
+        contents_hash = chunk_mesh_cache::add_to_hash(contents_hash, command.vertex_buffer, num_floats * sizeof(float));
+        contents_hash = chunk_mesh_cache::add_to_hash(contents_hash, command.index_buffer, command.index_buffer_size * sizeof(int));
+        contents_hash = chunk_mesh_cache::add_to_hash(contents_hash, texture_path.c_str(), texture_path.size() + 1);
+        contents_hash = chunk_mesh_cache::add_to_hash(contents_hash, atlas_name, std::strlen(atlas_name) + 1);
+        needs_upload = true;
+    }
+
+    void gui_batcher::clear() {
+        vertices.clear();
+        vertex_sprites.clear();
+        indices.clear();
+        batches.clear();
+        contents_hash = chunk_mesh_cache::FNV_OFFSET_BASIS;
+        needs_upload = true;
+    }
+
+    void gui_batcher::draw(texture_manager& textures, bool shader_has_sprite_locations) {
+        if(buffer == 0) {
+            create_gl_objects();
+        }
+
+        // Free whatever the GPU is done with, so uploads don't have to wait on it later
+        while(!retired_regions.empty() && retire_oldest_region(false)) {}
+
+        if(shader_has_sprite_locations) {
+            textures.bind_sprite_locations();
+        }
+
+        // UVs that were moved into the atlas on the CPU are stale once the sprites move
+        const bool uvs_are_stale = uploaded_sprite_uvs != shader_has_sprite_locations ||
+                (!shader_has_sprite_locations && uploaded_locations_version != textures.get_locations_version());
+        if(needs_upload || (has_uploaded_geometry && uvs_are_stale)) {
+            upload(textures, shader_has_sprite_locations);
+        }
+
+        if(!has_uploaded_geometry) {
+            return;
+        }
+
+        gl_state::bind_vertex_array(vao);
+        for(const auto& batch : batches) {
+            if(batch.atlas != NO_TEXTURE) {
+                textures.bind_texture(batch.atlas, 0);
+            }
+
+            const auto offset = static_cast<size_t>(index_offset + batch.first_index * sizeof(uint32_t));
+            glDrawElements(GL_TRIANGLES, batch.num_indices, GL_UNSIGNED_INT, reinterpret_cast<void*>(offset));
+            frame_stats::count_draw(batch.num_indices / 3);
+        }
+    }
+
+    const std::vector<gui_batch>& gui_batcher::get_batches() const {
+        return batches;
+    }
+
+    uint32_t gui_batcher::get_version() {
+        if(contents_hash != versioned_hash) {
+            versioned_hash = contents_hash;
+            version++;
+        }
+        return version;
+    }
+
+    sprite_handle gui_batcher::get_sprite(const std::string& texture_path, texture_manager& textures) {
+        auto sprite = sprite_cache.find(texture_path);
+        if(sprite == sprite_cache.end()) {
+            sprite = sprite_cache.emplace(texture_path, textures.get_sprite_handle(get_texture_name(texture_path))).first;
+        }
+
+        return sprite->second;
+    }
+
+    void gui_batcher::create_gl_objects() {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        glCreateBuffers(1, &buffer);
+        glNamedBufferStorage(buffer, RING_SIZE, nullptr, flags);
+        gpu_memory::track_buffer(buffer, gpu_memory_category::buffers, RING_SIZE);
+        mapped_data = static_cast<uint8_t*>(glMapNamedBufferRange(buffer, 0, RING_SIZE, flags));
+
+        if(mapped_data == nullptr) {
+            LOG(FATAL) << "Could not map the GUI ring buffer";
+        }
+
+        glCreateVertexArrays(1, &vao);
+        glEnableVertexArrayAttrib(vao, 0);   // Position
+        glEnableVertexArrayAttrib(vao, 1);   // Texture UV
+        glEnableVertexArrayAttrib(vao, 2);   // Vertex color
+        glEnableVertexArrayAttrib(vao, 3);   // Sprite handle
+        glVertexArrayAttribFormat(vao, 0, 3, GL_FLOAT, GL_FALSE, 0);
+        glVertexArrayAttribFormat(vao, 1, 2, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat));
+        glVertexArrayAttribFormat(vao, 2, 4, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat));
+        glVertexArrayAttribIFormat(vao, 3, 1, GL_UNSIGNED_INT, 0);
+        glVertexArrayAttribBinding(vao, 0, 0);
+        glVertexArrayAttribBinding(vao, 1, 0);
+        glVertexArrayAttribBinding(vao, 2, 0);
+        glVertexArrayAttribBinding(vao, 3, 1);
+        glVertexArrayElementBuffer(vao, buffer);
+    }
+
+    void gui_batcher::upload(const texture_manager& textures, bool sprite_uvs) {
+        needs_upload = false;
+
+        // Everything drawn from the current region so far comes before this fence
+        if(has_uploaded_geometry) {
+            retired_regions.push_back({glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0)});
+            has_uploaded_geometry = false;
+        }
+
+        if(batches.empty()) {
+            return;
+        }
+
+        const auto vertex_size = static_cast<GLsizeiptr>(vertices.size() * sizeof(float));
+        const auto sprite_size = static_cast<GLsizeiptr>(vertex_sprites.size() * sizeof(sprite_handle));
+        const auto index_size = static_cast<GLsizeiptr>(indices.size() * sizeof(uint32_t));
+        const GLsizeiptr size = align(vertex_size) + align(sprite_size) + index_size;
+        if(size > RING_SIZE) {
+            LOG(ERROR) << "The GUI needs " << size << " bytes, which is more than the whole GUI ring. It will not be drawn";
+            return;
+        }
+
+        const GLsizeiptr offset = allocate(size);
+        const GLsizeiptr sprite_offset = offset + align(vertex_size);
+        index_offset = sprite_offset + align(sprite_size);
+        std::memcpy(mapped_data + offset, vertices.data(), static_cast<size_t>(vertex_size));
+        std::memcpy(mapped_data + sprite_offset, vertex_sprites.data(), static_cast<size_t>(sprite_size));
+        std::memcpy(mapped_data + index_offset, indices.data(), static_cast<size_t>(index_size));
+        frame_stats::count_upload(static_cast<uint64_t>(vertex_size + sprite_size + index_size));
+
+        if(!sprite_uvs) {
+            // Only written, never read back, since the ring is write-combined memory
+            auto* mapped_vertices = reinterpret_cast<float*>(mapped_data + offset);
+            for(size_t vertex = 0; vertex < vertex_sprites.size(); vertex++) {
+                const auto& location = textures.get_texture_location(vertex_sprites[vertex]);
+                const size_t uv = vertex * FLOATS_PER_VERTEX + 3;
+                mapped_vertices[uv] = vertices[uv] * (location.max.x - location.min.x) + location.min.x;
+                mapped_vertices[uv + 1] = vertices[uv + 1] * (location.max.y - location.min.y) + location.min.y;
+            }
+        }
+        uploaded_sprite_uvs = sprite_uvs;
+        uploaded_locations_version = textures.get_locations_version();
+
+        glVertexArrayVertexBuffer(vao, 0, buffer, offset, FLOATS_PER_VERTEX * sizeof(GLfloat));
+        glVertexArrayVertexBuffer(vao, 1, buffer, sprite_offset, sizeof(sprite_handle));
+
+        has_uploaded_geometry = true;
+    }
+
+    GLsizeiptr gui_batcher::allocate(GLsizeiptr size) {
+        // The region being drawn was retired before this, so every allocation in the ring has a retired region
+        uint64_t offset = 0;
+        while(!ring.allocate(static_cast<uint64_t>(size), offset)) {
+            retire_oldest_region(true);
+        }
+        return static_cast<GLsizeiptr>(offset);
+    }
+
+    bool gui_batcher::retire_oldest_region(bool wait) {
+        auto& oldest = retired_regions.front();
+
+        if(wait) {
+            GLenum status = glClientWaitSync(oldest.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+            while(status == GL_TIMEOUT_EXPIRED) {
+                LOG(WARNING) << "Still waiting on the GPU to finish drawing old GUI geometry";
+                status = glClientWaitSync(oldest.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+            }
+
+        } else {
+            GLenum status = glClientWaitSync(oldest.fence, 0, 0);
+            if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+                return false;
+            }
+        }
+
+        glDeleteSync(oldest.fence);
+        retired_regions.pop_front();
+        ring.free_oldest();
+        return true;
+    }
+}
@@ -0,0 +1,201 @@
+/*!
+ * \brief Collects GUI geometry into as few draws as possible and streams it through one ring buffer
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_GUI_BATCHER_H
+#define RENDERER_GUI_BATCHER_H
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glad/glad.h>
+#include "../../mc_interface/mc_objects.h"
+#include "textures/texture_manager.h"
+#include "../../geometry_cache/chunk_mesh_cache.h"
+#include "../../utils/ring_allocator.h"
+
+namespace nova {
+    /*!
+     * \brief A run of GUI geometry that all uses the same atlas, so it can be drawn with one call
+     */
+    struct gui_batch {
+        std::string atlas_name;
+        texture_handle atlas = NO_TEXTURE;
+        uint32_t first_index = 0;
+        uint32_t num_indices = 0;
+    };
+
+    /*!
+     * \brief Holds the GUI geometry Minecraft has sent since the last time the GUI was cleared
+     *
+     * Minecraft sends the GUI as a lot of small commands. Each command's vertices and indices are appended to one big
+     * list on the CPU, and a command that uses the same atlas as the one before it is merged into that command's
+     * batch. When the GUI is drawn after it's changed, the whole list is copied into a persistently mapped ring
+     * buffer, and each batch is one glDrawElements from there. The GUI is drawn from the same copy until it changes
+     * again, and the space in the ring is only reused once a fence says the GPU is done drawing from it.
+     *
+     * Minecraft names GUI textures by their resource path, like textures/gui/widgets.png. Each path is turned into
+     * the texture manager's sprite handle for it once, and every vertex keeps its command's handle in a second vertex
+     * stream, at attribute 3. If the GUI shader reads the sprite_locations block, the UVs are left going across the
+     * sprite and the shader moves them into the atlas, so the geometry doesn't have to be copied again when the
+     * sprites move. Otherwise the UVs are moved into the atlas while they're copied into the ring, and copied again
+     * whenever the texture manager's locations change
+     *
+     * Like everything else that touches GL, this has to be used from the render thread. The GL objects aren't made
+     * until the first draw, so this can be made before there's a context
+     */
+    class gui_batcher {
+    public:
+        /*!
+         * \brief The size, in bytes, of the ring buffer
+         */
+        static const GLsizeiptr RING_SIZE = 4 * 1024 * 1024;
+
+        gui_batcher();
+
+        gui_batcher(const gui_batcher&) = delete;
+        gui_batcher& operator=(const gui_batcher&) = delete;
+
+        ~gui_batcher();
+
+        /*!
+         * \brief Adds the command's geometry to the GUI, tagged with its texture's sprite handle
+         *
+         * The command's memory can be freed as soon as this returns
+         *
+         * \param command The GUI geometry, in the POS_UV_COLOR format
+         * \param textures The texture manager to get the command's sprite handle from
+         */
+        void add_geometry(const mc_gui_geometry& command, texture_manager& textures);
+
+        /*!
+         * \brief Removes all the GUI geometry
+         */
+        void clear();
+
+        /*!
+         * \brief Draws all the GUI geometry with whatever shader is bound, uploading it first if it's changed
+         *
+         * \param textures The texture manager to bind each batch's atlas from
+         * \param shader_has_sprite_locations True if the bound shader moves the UVs into the atlas itself, with the
+         * sprite_locations block
+         */
+        void draw(texture_manager& textures, bool shader_has_sprite_locations);
+
+        const std::vector<gui_batch>& get_batches() const;
+
+        /*!
+         * \brief Changes every time the geometry is different from what it was the last time this was called, so
+         * anything that keeps a drawn copy of the GUI knows when to draw it again
+         *
+         * Minecraft clears the GUI and sends all of it again whenever anything in it might have changed, so the
+         * geometry is hashed as it's added, and sending the same GUI again doesn't change the version
+         */
+        uint32_t get_version();
+
+    private:
+        /*!
+         * \brief A part of the ring that the GPU may still be drawing from
+         */
+        struct ring_region {
+            GLsync fence;
+        };
+
+        std::vector<float> vertices;
+        std::vector<sprite_handle> vertex_sprites;
+        std::vector<uint32_t> indices;
+        std::vector<gui_batch> batches;
+
+        /*!
+         * \brief True if the geometry has changed since it was last copied into the ring
+         */
+        bool needs_upload = false;
+
+        /*!
+         * \brief A hash of everything added since the last clear, and the hash the current version was given for
+         */
+        uint64_t contents_hash = chunk_mesh_cache::FNV_OFFSET_BASIS;
+        uint64_t versioned_hash = chunk_mesh_cache::FNV_OFFSET_BASIS;
+        uint32_t version = 0;
+
+        /*!
+         * \brief True if the geometry in the ring can be drawn. False if there isn't any, or it didn't fit
+         */
+        bool has_uploaded_geometry = false;
+
+        /*!
+         * \brief Where the indices of the geometry that's being drawn live in the ring
+         */
+        GLsizeiptr index_offset = 0;
+
+        /*!
+         * \brief Whether the UVs in the ring still go across their sprite, and if not, the texture manager's locations
+         * version they were moved into the atlas with
+         */
+        bool uploaded_sprite_uvs = false;
+        uint32_t uploaded_locations_version = 0;
+
+        /*!
+         * \brief Regions that have been replaced but that the GPU may still be reading, oldest first
+         */
+        std::deque<ring_region> retired_regions;
+
+        /*!
+         * \brief Which parts of the ring are in use. The newest allocation is the region being drawn, if there is one,
+         * and the others are the retired regions, in the same order
+         */
+        ring_allocator ring;
+
+        GLuint buffer = 0;
+        GLuint vao = 0;
+        uint8_t* mapped_data = nullptr;
+
+        /*!
+         * \brief The sprite handle for each resource path. Handles never change, so this is never cleared
+         */
+        std::unordered_map<std::string, sprite_handle> sprite_cache;
+
+        /*!
+         * \brief The resource path of the command being added
+         */
+        std::string texture_path;
+
+        /*!
+         * \brief Finds the sprite handle of the texture with the given resource path, from the cache if it can
+         */
+        sprite_handle get_sprite(const std::string& texture_path, texture_manager& textures);
+
+        void create_gl_objects();
+
+        /*!
+         * \brief Copies the geometry into a new part of the ring and retires the part it used to be in
+         *
+         * \param textures The texture manager to find the sprites' locations in
+         * \param sprite_uvs If true, the UVs are copied as they are. If false, they're moved into the atlas
+         */
+        void upload(const texture_manager& textures, bool sprite_uvs);
+
+        /*!
+         * \brief Finds space for the given number of bytes, waiting on old regions if needed
+         *
+         * \return The offset of the space in the ring
+         */
+        GLsizeiptr allocate(GLsizeiptr size);
+
+        /*!
+         * \brief Frees the oldest retired region
+         *
+         * \param wait If true, waits for the GPU to finish with the region. If false, only frees it if the GPU is
+         * already done
+         * \return True if the region was freed
+         */
+        bool retire_oldest_region(bool wait);
+    };
+}
+
+#endif //RENDERER_GUI_BATCHER_H
@@ -0,0 +1,318 @@
+/*!
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include <algorithm>
+#include <string>
+#include <easylogging++.h>
+#include <GLFW/glfw3.h>
+#include "gui_layer.h"
+#include "gl_state.h"
+#include "gpu_memory.h"
+#include "frame_stats.h"
+
+namespace nova {
+    static const char* FULLSCREEN_VERTEX_SOURCE = R"(#version 450
+void main() {
+    // One triangle that covers the whole screen
+    vec2 uv = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(uv * 2 - 1, 0, 1);
+}
+)";
+
+    static const char* COMPOSITE_FRAGMENT_SOURCE = R"(#version 450
+layout(binding = 17) uniform sampler2D gui_layer;
+
+layout(location = 0) out vec4 color;
+
+void main() {
+    color = texelFetch(gui_layer, ivec2(gl_FragCoord.xy), 0);
+}
+)";
+
+    // Off the edge of the screen counts as opaque, so a menu that fills the screen is masked right up to its edges
+    static const char* MASK_FRAGMENT_SOURCE = R"(#version 450
+layout(binding = 17) uniform sampler2D gui_layer;
+
+layout(location = 0) uniform int margin;
+
+void main() {
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    ivec2 last_pixel = textureSize(gui_layer, 0) - 1;
+    for(int y = -margin; y <= margin; y++) {
+        for(int x = -margin; x <= margin; x++) {
+            if(texelFetch(gui_layer, clamp(pixel + ivec2(x, y), ivec2(0), last_pixel), 0).a < 1) {
+                discard;
+            }
+        }
+    }
+}
+)";
+
+    /*!
+     * \brief Compiles one stage of one of the GUI layer's shaders
+     *
+     * \return The shader, or 0 if it didn't compile
+     */
+    static GLuint compile_shader(GLenum stage, const char* source) {
+        GLuint shader = glCreateShader(stage);
+        glShaderSource(shader, 1, &source, nullptr);
+        glCompileShader(shader);
+
+        GLint compiled = GL_FALSE;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+        if(compiled == GL_FALSE) {
+            GLint log_length = 0;
+            glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &log_length);
+            std::string info_log(static_cast<size_t>(std::max(log_length, 1)), '\0');
+            glGetShaderInfoLog(shader, log_length, nullptr, &info_log[0]);
+
+            LOG(ERROR) << "Could not compile a GUI layer shader: " << info_log;
+            glDeleteShader(shader);
+            return 0;
+        }
+
+        return shader;
+    }
+
+    /*!
+     * \brief Links the fullscreen vertex shader with the given fragment shader
+     *
+     * \return The program, or 0 if it couldn't be made
+     */
+    static GLuint create_program(const char* fragment_source) {
+        GLuint vertex_shader = compile_shader(GL_VERTEX_SHADER, FULLSCREEN_VERTEX_SOURCE);
+        GLuint fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_source);
+        if(vertex_shader == 0 || fragment_shader == 0) {
+            glDeleteShader(vertex_shader);
+            glDeleteShader(fragment_shader);
+            return 0;
+        }
+
+        GLuint program = glCreateProgram();
+        glAttachShader(program, vertex_shader);
+        glAttachShader(program, fragment_shader);
+        glLinkProgram(program);
+        glDeleteShader(vertex_shader);
+        glDeleteShader(fragment_shader);
+
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if(linked == GL_FALSE) {
+            LOG(ERROR) << "Could not link a GUI layer shader";
+            gl_state::delete_program(program);
+            return 0;
+        }
+
+        return program;
+    }
+
+    bool gui_layer_state::operator==(const gui_layer_state& other) const {
+        return size == other.size && scalefactor == other.scalefactor && geometry_version == other.geometry_version &&
+               locations_version == other.locations_version && contents_version == other.contents_version;
+    }
+
+    bool gui_layer_state::operator!=(const gui_layer_state& other) const {
+        return !(*this == other);
+    }
+
+    gui_layer::~gui_layer() {
+        if(glfwGetCurrentContext() == nullptr) {
+            return;
+        }
+
+        destroy_layer();
+        if(mask_query != 0) {
+            glDeleteQueries(1, &mask_query);
+        }
+        if(composite_program != 0) {
+            gl_state::delete_program(composite_program);
+        }
+        if(mask_program != 0) {
+            gl_state::delete_program(mask_program);
+        }
+        if(vao != 0) {
+            gl_state::delete_vertex_arrays(1, &vao);
+        }
+    }
+
+    bool gui_layer::update(const gui_layer_state& state, const std::function<void()>& draw_gui) {
+        if(!is_available() || (is_drawn && state == drawn_state)) {
+            return false;
+        }
+        if(layer_size != state.size) {
+            create_layer(state.size);
+        }
+
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glViewport(0, 0, layer_size.x, layer_size.y);
+
+        const GLfloat transparent[4] = {0, 0, 0, 0};
+        glClearNamedFramebufferfv(framebuffer, GL_COLOR, 0, transparent);
+        glClearNamedFramebufferfi(framebuffer, GL_DEPTH_STENCIL, 0, 1.0f, 0);
+
+        // Alphas are blended so the layer ends up premultiplied, which is what compositing it later needs
+        gl_state::blend_func_separate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        draw_gui();
+        gl_state::blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        draw_mask();
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        drawn_state = state;
+        is_drawn = true;
+        return true;
+    }
+
+    void gui_layer::composite() {
+        if(!is_drawn || programs_broken) {
+            return;
+        }
+
+        gl_state::use_program(composite_program);
+        gl_state::bind_texture_unit(LAYER_TEXTURE_UNIT, color_texture);
+        gl_state::blend_func(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        gl_state::set_enabled(GL_DEPTH_TEST, false);
+
+        gl_state::bind_vertex_array(vao);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        frame_stats::count_draw(1);
+
+        gl_state::set_enabled(GL_DEPTH_TEST, true);
+        gl_state::blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
+
+    void gui_layer::copy_mask(const glm::uvec2& target_size) {
+        if(!is_drawn) {
+            return;
+        }
+
+        // Blits can stretch a stencil, as long as the filter is GL_NEAREST
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+        glBlitFramebuffer(0, 0, layer_size.x, layer_size.y, 0, 0, target_size.x, target_size.y,
+                          GL_STENCIL_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    }
+
+    bool gui_layer::has_opaque_pixels() {
+        if(is_query_pending) {
+            GLint is_available = GL_FALSE;
+            glGetQueryObjectiv(mask_query, GL_QUERY_RESULT_AVAILABLE, &is_available);
+            if(is_available == GL_TRUE) {
+                GLuint any_samples_passed = GL_FALSE;
+                glGetQueryObjectuiv(mask_query, GL_QUERY_RESULT, &any_samples_passed);
+                is_query_pending = false;
+
+                const bool had_pixels = mask_has_pixels;
+                mask_has_pixels = any_samples_passed == GL_TRUE;
+                if(mask_has_pixels || had_pixels) {
+                    mask_version++;
+                }
+            }
+        }
+
+        return is_drawn && mask_has_pixels;
+    }
+
+    uint32_t gui_layer::get_mask_version() const {
+        return mask_version;
+    }
+
+    bool gui_layer::is_available() {
+        if(composite_program == 0 && !programs_broken) {
+            create_programs();
+        }
+        return !programs_broken;
+    }
+
+    void gui_layer::invalidate() {
+        is_drawn = false;
+    }
+
+    void gui_layer::create_programs() {
+        composite_program = create_program(COMPOSITE_FRAGMENT_SOURCE);
+        mask_program = create_program(MASK_FRAGMENT_SOURCE);
+        if(composite_program == 0 || mask_program == 0) {
+            LOG(ERROR) << "The GUI will be drawn straight to the screen every frame, since its layer's shaders couldn't be made";
+            programs_broken = true;
+            return;
+        }
+
+        glCreateVertexArrays(1, &vao);
+    }
+
+    void gui_layer::create_layer(const glm::uvec2& size) {
+        destroy_layer();
+
+        glCreateTextures(GL_TEXTURE_2D, 1, &color_texture);
+        glTextureStorage2D(color_texture, 1, GL_RGBA8, size.x, size.y);
+        glTextureParameteri(color_texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTextureParameteri(color_texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        gpu_memory::track_texture(color_texture, gpu_memory_category::framebuffers,
+                                  gpu_memory::get_texture_size(GL_RGBA8, size.x, size.y));
+
+        // The same format as depthtex0, since the mask can only be blitted into a stencil of its own format
+        glCreateTextures(GL_TEXTURE_2D, 1, &depth_stencil_texture);
+        glTextureStorage2D(depth_stencil_texture, 1, GL_DEPTH32F_STENCIL8, size.x, size.y);
+        gpu_memory::track_texture(depth_stencil_texture, gpu_memory_category::framebuffers,
+                                  gpu_memory::get_texture_size(GL_DEPTH32F_STENCIL8, size.x, size.y));
+
+        glCreateFramebuffers(1, &framebuffer);
+        glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT0, color_texture, 0);
+        glNamedFramebufferTexture(framebuffer, GL_DEPTH_STENCIL_ATTACHMENT, depth_stencil_texture, 0);
+
+        auto status = glCheckNamedFramebufferStatus(framebuffer, GL_DRAW_FRAMEBUFFER);
+        if(status != GL_FRAMEBUFFER_COMPLETE) {
+            LOG(ERROR) << "The GUI layer's framebuffer is incomplete: " << status;
+        }
+
+        layer_size = size;
+        is_drawn = false;
+    }
+
+    void gui_layer::destroy_layer() {
+        if(color_texture != 0) {
+            gl_state::delete_textures(1, &color_texture);
+            gl_state::delete_textures(1, &depth_stencil_texture);
+            glDeleteFramebuffers(1, &framebuffer);
+            color_texture = depth_stencil_texture = framebuffer = 0;
+        }
+        layer_size = glm::uvec2(0);
+    }
+
+    void gui_layer::draw_mask() {
+        if(mask_has_pixels) {
+            // What's copied out changes right away, before the query says what's in the new mask
+            mask_version++;
+        }
+        if(is_query_pending) {
+            glDeleteQueries(1, &mask_query);
+            mask_query = 0;
+        }
+        if(mask_query == 0) {
+            glCreateQueries(GL_ANY_SAMPLES_PASSED, 1, &mask_query);
+        }
+
+        gl_state::use_program(mask_program);
+        glProgramUniform1i(mask_program, 0, MASK_MARGIN);
+        gl_state::bind_texture_unit(LAYER_TEXTURE_UNIT, color_texture);
+
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        gl_state::set_enabled(GL_DEPTH_TEST, false);
+        gl_state::set_enabled(GL_STENCIL_TEST, true);
+        glStencilFunc(GL_ALWAYS, 1, 0xFF);
+        glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+
+        glBeginQuery(GL_ANY_SAMPLES_PASSED, mask_query);
+        gl_state::bind_vertex_array(vao);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        frame_stats::count_draw(1);
+        glEndQuery(GL_ANY_SAMPLES_PASSED);
+        is_query_pending = true;
+
+        gl_state::set_enabled(GL_STENCIL_TEST, false);
+        gl_state::set_enabled(GL_DEPTH_TEST, true);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    }
+}
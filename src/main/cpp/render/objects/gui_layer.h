@@ -0,0 +1,149 @@
+/*!
+ * \brief Keeps the GUI drawn in its own texture, and only draws it again when it changes
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#ifndef RENDERER_GUI_LAYER_H
+#define RENDERER_GUI_LAYER_H
+
+#include <cstdint>
+#include <functional>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+namespace nova {
+    /*!
+     * \brief Everything that changes what the GUI looks like. The layer is drawn again when any of it changes
+     */
+    struct gui_layer_state {
+        glm::uvec2 size = glm::uvec2(0);
+        float scalefactor = 0;
+        uint32_t geometry_version = 0;
+        uint32_t locations_version = 0;
+        uint32_t contents_version = 0;
+
+        bool operator==(const gui_layer_state& other) const;
+        bool operator!=(const gui_layer_state& other) const;
+    };
+
+    /*!
+     * \brief Draws the GUI once into a texture and a stencil, then puts that texture on the screen every frame
+     *
+     * Minecraft only sends the GUI again when something in it might have changed, and most frames nothing has, so
+     * redrawing every GUI mesh each frame is wasted work. #update draws the GUI into the layer's color texture,
+     * premultiplied by its alpha, when the gui_layer_state it's given is different from the one it was last drawn
+     * with. #composite blends that texture over whatever's on the screen.
+     *
+     * While the GUI is drawn, a mask is made in the layer's stencil: 1 wherever the GUI is opaque, and 0 everywhere
+     * else. Each opaque area is shrunk by MASK_MARGIN pixels first, so passes that read the pixels around the one
+     * they're drawing, and pixels that are stretched by dynamic resolution, never see a pixel that wasn't drawn.
+     * #copy_mask copies the mask into a depth-stencil attachment, so the frame graph can skip the world under opaque
+     * menus. Whether there's anything in the mask is found with an occlusion query, which is read a frame or two
+     * later so it never stalls.
+     *
+     * Everything here has to be called from the render thread
+     */
+    class gui_layer {
+    public:
+        /*!
+         * \brief How many pixels are taken off every side of an opaque area before it goes into the mask
+         */
+        static const int MASK_MARGIN = 4;
+
+        /*!
+         * \brief The texture unit the layer is bound to while it's put on the screen or made into the mask
+         */
+        static const GLuint LAYER_TEXTURE_UNIT = 17;
+
+        gui_layer() = default;
+
+        gui_layer(const gui_layer&) = delete;
+        gui_layer& operator=(const gui_layer&) = delete;
+
+        ~gui_layer();
+
+        /*!
+         * \brief Draws the GUI into the layer if anything that changes it has changed
+         *
+         * \param state What the GUI looks like right now
+         * \param draw_gui Draws the GUI. The layer's framebuffer is bound and the viewport set before it's called
+         * \return True if the layer was drawn again
+         */
+        bool update(const gui_layer_state& state, const std::function<void()>& draw_gui);
+
+        /*!
+         * \brief Blends the layer over the whole of the framebuffer that's bound, which has to be the layer's size
+         */
+        void composite();
+
+        /*!
+         * \brief Copies the mask into the stencil of the framebuffer that's bound for drawing, stretched to fill it
+         *
+         * The framebuffer's stencil has to be GL_DEPTH32F_STENCIL8, since blits can't change stencil formats
+         *
+         * \param target_size The size of the part of the bound framebuffer that's drawn
+         */
+        void copy_mask(const glm::uvec2& target_size);
+
+        /*!
+         * \brief True if the mask has anything in it, as far as the newest finished query knows
+         */
+        bool has_opaque_pixels();
+
+        /*!
+         * \brief Changes every time the mask that #copy_mask copies out changes, so anything that remembers pixels
+         * under it knows they may have been left out or put back
+         */
+        uint32_t get_mask_version() const;
+
+        /*!
+         * \brief False if the layer's shaders couldn't be made, in which case the GUI has to be drawn straight to the
+         * screen
+         */
+        bool is_available();
+
+        /*!
+         * \brief Makes the next #update draw the GUI again, even if nothing it's given changed. Shaderpacks call this
+         * when their GUI shader changes
+         */
+        void invalidate();
+
+    private:
+        gui_layer_state drawn_state;
+        bool is_drawn = false;
+
+        GLuint color_texture = 0;
+        GLuint depth_stencil_texture = 0;
+        GLuint framebuffer = 0;
+        glm::uvec2 layer_size = glm::uvec2(0);
+
+        /*!
+         * \brief Counts the pixels that go into the newest mask. A query that hasn't finished when the mask is made
+         * again is thrown away, since its answer is already stale
+         */
+        GLuint mask_query = 0;
+        bool is_query_pending = false;
+        bool mask_has_pixels = false;
+        uint32_t mask_version = 0;
+
+        GLuint composite_program = 0;
+        GLuint mask_program = 0;
+        GLuint vao = 0;
+        bool programs_broken = false;
+
+        void create_programs();
+
+        void create_layer(const glm::uvec2& size);
+
+        void destroy_layer();
+
+        /*!
+         * \brief Writes 1 into the layer's stencil wherever the GUI is opaque, shrunk by MASK_MARGIN
+         */
+        void draw_mask();
+    };
+}
+
+#endif //RENDERER_GUI_LAYER_H
@@ -0,0 +1,138 @@
+/*!
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <easylogging++.h>
+#include "object_data_buffer.h"
+#include "frame_stats.h"
+#include "gpu_memory.h"
+#include "gl_state.h"
+#include "../windowing/glfw_gl_window.h"
+
+namespace nova {
+    static_assert(sizeof(object_data) == 16, "object_data has to match the std430 layout of the object_data block");
+
+    /*!
+     * \brief The number of slots in the first buffer. Enough for a small render distance without growing
+     */
+    static const uint32_t INITIAL_CAPACITY = 4096;
+
+    object_data_buffer::~object_data_buffer() {
+        if(buffer == 0 || glfwGetCurrentContext() == nullptr) {
+            return;
+        }
+
+        for(auto& fenced : slots_waiting_on_gpu) {
+            glDeleteSync(fenced.fence);
+        }
+
+        glUnmapNamedBuffer(buffer);
+        gl_state::delete_buffers(1, &buffer);
+    }
+
+    uint32_t object_data_buffer::add(const object_data& data) {
+        uint32_t slot;
+        if(!free_slots.empty()) {
+            slot = free_slots.back();
+            free_slots.pop_back();
+            objects[slot] = data;
+
+        } else {
+            slot = static_cast<uint32_t>(objects.size());
+            objects.push_back(data);
+        }
+
+        if(slot >= capacity) {
+            // Growing copies every object, including this one
+            grow(slot + 1);
+        } else {
+            mapped_data[slot] = data;
+            frame_stats::count_upload(sizeof(object_data));
+        }
+
+        return slot;
+    }
+
+    void object_data_buffer::remove(uint32_t& slot) {
+        if(slot == NO_OBJECT) {
+            return;
+        }
+
+        slots_removed_this_frame.push_back(slot);
+        slot = NO_OBJECT;
+    }
+
+    void object_data_buffer::begin_frame() {
+        // Draws the GPU hasn't finished may still read the removed slots, so fence them off
+        if(!slots_removed_this_frame.empty()) {
+            fenced_slots fenced;
+            fenced.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            fenced.slots = std::move(slots_removed_this_frame);
+            slots_waiting_on_gpu.push_back(std::move(fenced));
+            slots_removed_this_frame.clear();
+        }
+
+        // Fences are signaled in order, so we can stop at the first one that hasn't passed
+        auto fenced_itr = slots_waiting_on_gpu.begin();
+        for(; fenced_itr != slots_waiting_on_gpu.end(); ++fenced_itr) {
+            GLenum status = glClientWaitSync(fenced_itr->fence, 0, 0);
+            if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+                break;
+            }
+
+            free_slots.insert(free_slots.end(), fenced_itr->slots.begin(), fenced_itr->slots.end());
+            glDeleteSync(fenced_itr->fence);
+        }
+        slots_waiting_on_gpu.erase(slots_waiting_on_gpu.begin(), fenced_itr);
+    }
+
+    void object_data_buffer::bind() {
+        if(buffer == 0) {
+            grow(INITIAL_CAPACITY);
+        }
+
+        gl_state::bind_buffer_range(GL_SHADER_STORAGE_BUFFER, OBJECT_DATA_BINDING, buffer, 0,
+                                    static_cast<GLsizeiptr>(capacity * sizeof(object_data)));
+    }
+
+    const object_data& object_data_buffer::get(uint32_t slot) const {
+        return objects[slot];
+    }
+
+    void object_data_buffer::grow(uint32_t min_capacity) {
+        uint32_t new_capacity = std::max(capacity, INITIAL_CAPACITY);
+        while(new_capacity < min_capacity) {
+            new_capacity *= 2;
+        }
+
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        const auto size = static_cast<GLsizeiptr>(new_capacity * sizeof(object_data));
+
+        GLuint new_buffer = 0;
+        glCreateBuffers(1, &new_buffer);
+        glNamedBufferStorage(new_buffer, size, nullptr, flags);
+        gpu_memory::track_buffer(new_buffer, gpu_memory_category::buffers, size);
+        auto* new_mapped_data = static_cast<object_data*>(glMapNamedBufferRange(new_buffer, 0, size, flags));
+        if(new_mapped_data == nullptr) {
+            LOG(FATAL) << "Could not map the object data buffer";
+        }
+
+        // The GPU has never seen the new buffer, so it's safe to write all of it right away
+        std::memcpy(new_mapped_data, objects.data(), objects.size() * sizeof(object_data));
+        frame_stats::count_upload(objects.size() * sizeof(object_data));
+
+        if(buffer != 0) {
+            // GL keeps the old buffer alive until the draws that use it are done
+            glUnmapNamedBuffer(buffer);
+            gl_state::delete_buffers(1, &buffer);
+        }
+
+        LOG(DEBUG) << "Object data buffer grew from " << capacity << " to " << new_capacity << " objects";
+        buffer = new_buffer;
+        mapped_data = new_mapped_data;
+        capacity = new_capacity;
+    }
+}
@@ -0,0 +1,111 @@
+/*!
+ * \brief Keeps the data that shaders need about each object in one shader storage buffer
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_OBJECT_DATA_BUFFER_H
+#define RENDERER_OBJECT_DATA_BUFFER_H
+
+#include <cstdint>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+namespace nova {
+    /*!
+     * \brief Everything a shader knows about one object, laid out like the std430 struct in the shader
+     */
+    struct object_data {
+        glm::vec4 position;     //!< xyz is the object's position. w is 1 if its vertices are packed, 0 otherwise
+    };
+
+    /*!
+     * \brief Hands out a slot in a persistently mapped SSBO to each object, and writes the object's data into it once
+     *
+     * Shaders that declare a shader storage block named `object_data` at binding OBJECT_DATA_BINDING use it instead of
+     * the gbufferModel uniform. The block holds an array of object_data, and every draw of an object that has a slot
+     * passes the slot as its base instance, so the shader finds its object with `object_data[gl_BaseInstanceARB]`.
+     * That's the same for single draws and multi-draws, so nothing about the object needs to be sent while drawing
+     *
+     * Removed objects' slots wait on a fence before they're reused, since the GPU could still be drawing them. The
+     * buffer grows when it runs out of slots. Everything is also kept on the CPU, so growing is just a memcpy into the
+     * new buffer
+     */
+    class object_data_buffer {
+    public:
+        /*!
+         * \brief The SSBO binding point that the object data is bound to
+         */
+        static const GLuint OBJECT_DATA_BINDING = 1;
+
+        /*!
+         * \brief The slot of an object that isn't in the buffer
+         */
+        static const uint32_t NO_OBJECT = 0xFFFFFFFF;
+
+        object_data_buffer() = default;
+
+        object_data_buffer(const object_data_buffer&) = delete;
+        object_data_buffer& operator=(const object_data_buffer&) = delete;
+
+        ~object_data_buffer();
+
+        /*!
+         * \brief Gives the object a slot and writes its data there
+         *
+         * \return The object's slot
+         */
+        uint32_t add(const object_data& data);
+
+        /*!
+         * \brief Gives up the object's slot, once the GPU is done with it
+         *
+         * \param slot The slot to free. It's set to NO_OBJECT. Does nothing if it already is NO_OBJECT
+         */
+        void remove(uint32_t& slot);
+
+        /*!
+         * \brief Fences off the slots removed since the last call, and lets the slots whose fences have passed be reused
+         *
+         * Should be called once per frame
+         */
+        void begin_frame();
+
+        /*!
+         * \brief Binds the buffer to OBJECT_DATA_BINDING
+         */
+        void bind();
+
+        const object_data& get(uint32_t slot) const;
+
+    private:
+        struct fenced_slots {
+            GLsync fence;
+            std::vector<uint32_t> slots;
+        };
+
+        GLuint buffer = 0;
+        object_data* mapped_data = nullptr;
+        uint32_t capacity = 0;
+
+        /*!
+         * \brief A copy of everything in the buffer
+         */
+        std::vector<object_data> objects;
+
+        std::vector<uint32_t> free_slots;
+
+        std::vector<uint32_t> slots_removed_this_frame;
+
+        std::vector<fenced_slots> slots_waiting_on_gpu;
+
+        /*!
+         * \brief Replaces the buffer with one that has room for at least the given number of slots
+         */
+        void grow(uint32_t min_capacity);
+    };
+}
+
+#endif //RENDERER_OBJECT_DATA_BUFFER_H
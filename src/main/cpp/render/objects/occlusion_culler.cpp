@@ -0,0 +1,361 @@
+/*!
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <easylogging++.h>
+#include "occlusion_culler.h"
+#include "chunk_draw_batch.h"
+#include "gl_state.h"
+#include "gpu_memory.h"
+#include "../windowing/glfw_gl_window.h"
+
+namespace nova {
+    /*!
+     * \brief The number of invocations in each work group of the shaders that run once per command
+     */
+    static const GLuint COMMANDS_PER_GROUP = 64;
+
+    /*!
+     * \brief The width and height of each work group of the shader that builds the hierarchical depth buffer
+     */
+    static const GLuint HI_Z_GROUP_SIZE = 8;
+
+    static const char* FIRST_PHASE_SOURCE = R"(#version 450
+layout(local_size_x = 64) in;
+
+struct draw_command {
+    uint count;
+    uint instance_count;
+    uint first_index;
+    int base_vertex;
+    uint base_instance;
+};
+
+layout(std430, binding = 5) buffer commands_block { draw_command commands[]; };
+layout(std430, binding = 7) readonly buffer visibility_block { uint visibility[]; };
+
+layout(location = 0) uniform uint num_commands;
+
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    if(i >= num_commands) {
+        return;
+    }
+
+    commands[i].instance_count = visibility[commands[i].base_instance];
+}
+)";
+
+    static const char* HI_Z_SOURCE = R"(#version 450
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(binding = 15) uniform sampler2D source;
+layout(r32f, binding = 7) writeonly uniform image2D destination;
+
+layout(location = 0) uniform int source_level;
+
+void main() {
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 destination_size = imageSize(destination);
+    if(any(greaterThanEqual(texel, destination_size))) {
+        return;
+    }
+
+    // Take the farthest depth of every source texel that this texel covers. When a size is odd that's three texels
+    // along that axis, and missing one would let something be culled that's actually visible
+    ivec2 source_size = textureSize(source, source_level);
+    ivec2 start = (texel * source_size) / destination_size;
+    ivec2 end = min(((texel + 1) * source_size + destination_size - 1) / destination_size, source_size);
+
+    float max_depth = 0;
+    for(int y = start.y; y < end.y; y++) {
+        for(int x = start.x; x < end.x; x++) {
+            max_depth = max(max_depth, texelFetch(source, ivec2(x, y), source_level).r);
+        }
+    }
+
+    imageStore(destination, texel, vec4(max_depth));
+}
+)";
+
+    static const char* CULL_SOURCE = R"(#version 450
+layout(local_size_x = 64) in;
+
+struct draw_command {
+    uint count;
+    uint instance_count;
+    uint first_index;
+    int base_vertex;
+    uint base_instance;
+};
+
+layout(std430, binding = 5) buffer commands_block { draw_command commands[]; };
+layout(std430, binding = 6) readonly buffer bounds_block { vec4 bounds[]; };
+layout(std430, binding = 7) buffer visibility_block { uint visibility[]; };
+
+layout(binding = 15) uniform sampler2D hi_z;
+
+layout(location = 0) uniform uint num_commands;
+layout(location = 1) uniform mat4 view_projection;
+layout(location = 2) uniform vec2 render_scale;
+
+bool is_visible(vec3 center, vec3 extents) {
+    vec2 min_uv = vec2(1);
+    vec2 max_uv = vec2(0);
+    float min_depth = 1;
+
+    for(int c = 0; c < 8; c++) {
+        vec3 direction = vec3((c & 1) != 0 ? 1 : -1, (c & 2) != 0 ? 1 : -1, (c & 4) != 0 ? 1 : -1);
+        vec4 clip = view_projection * vec4(center + extents * direction, 1);
+        if(clip.w <= 0) {
+            // The box goes behind the camera, so it's right in front of us
+            return true;
+        }
+
+        vec3 ndc = clip.xyz / clip.w;
+        vec2 uv = ndc.xy * 0.5 + 0.5;
+        min_uv = min(min_uv, uv);
+        max_uv = max(max_uv, uv);
+        min_depth = min(min_depth, ndc.z * 0.5 + 0.5);
+    }
+
+    // Only the render_scale part of the depth buffer was drawn this frame
+    min_uv = clamp(min_uv, vec2(0), vec2(1)) * render_scale;
+    max_uv = clamp(max_uv, vec2(0), vec2(1)) * render_scale;
+
+    // Pick the level where the box covers at most two texels in each direction, so four samples cover all of it
+    vec2 size_in_texels = (max_uv - min_uv) * vec2(textureSize(hi_z, 0));
+    float level = ceil(log2(max(max(size_in_texels.x, size_in_texels.y), 1)));
+
+    float max_depth = max(max(textureLod(hi_z, min_uv, level).r, textureLod(hi_z, vec2(max_uv.x, min_uv.y), level).r),
+                          max(textureLod(hi_z, vec2(min_uv.x, max_uv.y), level).r, textureLod(hi_z, max_uv, level).r));
+
+    return min_depth <= max_depth;
+}
+
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    if(i >= num_commands) {
+        return;
+    }
+
+    bool visible = is_visible(bounds[i * 2].xyz, bounds[i * 2 + 1].xyz);
+
+    uint slot = commands[i].base_instance;
+    bool was_visible = visibility[slot] != 0;
+    visibility[slot] = visible ? 1u : 0u;
+
+    // Chunks that were visible last frame have already been drawn
+    commands[i].instance_count = (visible && !was_visible) ? 1u : 0u;
+}
+)";
+
+    /*!
+     * \brief Compiles and links a compute shader
+     *
+     * \return The program, or 0 if it didn't compile or link
+     */
+    static GLuint compile_compute_program(const char* name, const char* source) {
+        GLuint program = glCreateShaderProgramv(GL_COMPUTE_SHADER, 1, &source);
+
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if(linked == GL_FALSE) {
+            GLint log_length = 0;
+            glGetProgramiv(program, GL_INFO_LOG_LENGTH, &log_length);
+            std::string info_log(static_cast<size_t>(std::max(log_length, 1)), '\0');
+            glGetProgramInfoLog(program, log_length, nullptr, &info_log[0]);
+
+            LOG(ERROR) << "Could not build the " << name << " compute shader, so occlusion culling is off: " << info_log;
+            gl_state::delete_program(program);
+            return 0;
+        }
+
+        return program;
+    }
+
+    /*!
+     * \brief The number of work groups needed for the given number of invocations
+     */
+    static GLuint get_num_groups(GLuint num_invocations, GLuint group_size) {
+        return (num_invocations + group_size - 1) / group_size;
+    }
+
+    occlusion_culler::~occlusion_culler() {
+        if(glfwGetCurrentContext() == nullptr) {
+            return;
+        }
+
+        for(GLuint program : {first_phase_program, hi_z_program, cull_program}) {
+            if(program != 0) {
+                gl_state::delete_program(program);
+            }
+        }
+
+        if(hi_z_texture != 0) {
+            gl_state::delete_textures(1, &hi_z_texture);
+        }
+
+        if(visibility_buffer != 0) {
+            gl_state::delete_buffers(1, &visibility_buffer);
+        }
+    }
+
+    void occlusion_culler::set_enabled(bool enabled) {
+        this->enabled = enabled;
+    }
+
+    bool occlusion_culler::is_enabled() const {
+        return enabled && !programs_failed && depth_texture != 0;
+    }
+
+    void occlusion_culler::set_depth_texture(GLuint depth_texture, const glm::ivec2& size) {
+        this->depth_texture = depth_texture;
+        depth_size = size;
+
+        // The pyramid is half the size of the depth buffer, since level 0 is already a max over 2x2 depth texels
+        const glm::ivec2 new_hi_z_size((size.x + 1) / 2, (size.y + 1) / 2);
+        if(new_hi_z_size != hi_z_size && hi_z_texture != 0) {
+            gl_state::delete_textures(1, &hi_z_texture);
+            hi_z_texture = 0;
+        }
+        hi_z_size = new_hi_z_size;
+    }
+
+    void occlusion_culler::set_view_projection(const glm::mat4& view_projection) {
+        this->view_projection = view_projection;
+    }
+
+    void occlusion_culler::set_render_scale(const glm::vec2& scale) {
+        render_scale = scale;
+    }
+
+    void occlusion_culler::reserve_objects(uint32_t num_objects) {
+        if(num_objects <= visibility_capacity) {
+            return;
+        }
+
+        const uint32_t new_capacity = std::max(num_objects, visibility_capacity * 2);
+
+        GLuint new_buffer;
+        glCreateBuffers(1, &new_buffer);
+        glNamedBufferData(new_buffer, new_capacity * sizeof(GLuint), nullptr, GL_DYNAMIC_COPY);
+        gpu_memory::track_buffer(new_buffer, gpu_memory_category::buffers, new_capacity * sizeof(GLuint));
+
+        // New objects start out invisible, so phase 2 is what draws them for the first time
+        glClearNamedBufferData(new_buffer, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+        if(visibility_buffer != 0) {
+            glCopyNamedBufferSubData(visibility_buffer, new_buffer, 0, 0, visibility_capacity * sizeof(GLuint));
+            gl_state::delete_buffers(1, &visibility_buffer);
+        }
+
+        visibility_buffer = new_buffer;
+        visibility_capacity = new_capacity;
+    }
+
+    bool occlusion_culler::create_programs() {
+        if(programs_failed) {
+            return false;
+        }
+
+        if(cull_program == 0) {
+            first_phase_program = compile_compute_program("first phase", FIRST_PHASE_SOURCE);
+            hi_z_program = compile_compute_program("hi-z", HI_Z_SOURCE);
+            cull_program = compile_compute_program("cull", CULL_SOURCE);
+            programs_failed = first_phase_program == 0 || hi_z_program == 0 || cull_program == 0;
+        }
+
+        return !programs_failed;
+    }
+
+    void occlusion_culler::create_hi_z_texture() {
+        num_hi_z_levels = 1 + static_cast<int>(std::floor(std::log2(std::max(hi_z_size.x, hi_z_size.y))));
+
+        glCreateTextures(GL_TEXTURE_2D, 1, &hi_z_texture);
+        glTextureStorage2D(hi_z_texture, num_hi_z_levels, GL_R32F, hi_z_size.x, hi_z_size.y);
+        gpu_memory::track_texture(hi_z_texture, gpu_memory_category::framebuffers,
+                                  gpu_memory::get_texture_size(GL_R32F, hi_z_size.x, hi_z_size.y, num_hi_z_levels));
+
+        // Culling samples exact texels from the level it picks, so there must be no filtering between them
+        glTextureParameteri(hi_z_texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+        glTextureParameteri(hi_z_texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTextureParameteri(hi_z_texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(hi_z_texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        LOG(DEBUG) << "Made a " << hi_z_size.x << "x" << hi_z_size.y << " hi-z buffer with " << num_hi_z_levels << " levels";
+    }
+
+    void occlusion_culler::keep_last_frames_visible(GLuint command_buffer, GLuint num_commands) {
+        if(!create_programs()) {
+            return;
+        }
+
+        gl_state::use_program(first_phase_program);
+        glProgramUniform1ui(first_phase_program, 0, num_commands);
+        gl_state::bind_buffer_range(GL_SHADER_STORAGE_BUFFER, COMMANDS_BINDING, command_buffer, 0,
+                                    num_commands * sizeof(draw_elements_indirect_command));
+        gl_state::bind_buffer_range(GL_SHADER_STORAGE_BUFFER, VISIBILITY_BINDING, visibility_buffer, 0,
+                                    visibility_capacity * sizeof(GLuint));
+
+        glDispatchCompute(get_num_groups(num_commands, COMMANDS_PER_GROUP), 1, 1);
+        glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+    }
+
+    void occlusion_culler::build_hi_z() {
+        if(!create_programs()) {
+            return;
+        }
+
+        if(hi_z_texture == 0) {
+            create_hi_z_texture();
+        }
+
+        // Makes the depth that was just drawn visible to our texture fetches, since the depth texture is still
+        // attached to the bound framebuffer
+        glTextureBarrier();
+
+        gl_state::use_program(hi_z_program);
+
+        glm::ivec2 level_size = hi_z_size;
+        for(int level = 0; level < num_hi_z_levels; level++) {
+            // Level 0 reads the depth buffer, and every level after that reads the level before it
+            gl_state::bind_texture_unit(HI_Z_TEXTURE_UNIT, level == 0 ? depth_texture : hi_z_texture);
+            glProgramUniform1i(hi_z_program, 0, level == 0 ? 0 : level - 1);
+            glBindImageTexture(HI_Z_IMAGE_UNIT, hi_z_texture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+
+            glDispatchCompute(get_num_groups(static_cast<GLuint>(level_size.x), HI_Z_GROUP_SIZE),
+                              get_num_groups(static_cast<GLuint>(level_size.y), HI_Z_GROUP_SIZE), 1);
+            glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+            level_size = glm::max(level_size / 2, glm::ivec2(1));
+        }
+    }
+
+    void occlusion_culler::cull_against_hi_z(GLuint command_buffer, GLuint bounds_buffer, GLuint num_commands) {
+        if(!create_programs() || hi_z_texture == 0) {
+            return;
+        }
+
+        gl_state::use_program(cull_program);
+        glProgramUniform1ui(cull_program, 0, num_commands);
+        glProgramUniformMatrix4fv(cull_program, 1, 1, GL_FALSE, &view_projection[0][0]);
+        glProgramUniform2f(cull_program, 2, render_scale.x, render_scale.y);
+
+        gl_state::bind_texture_unit(HI_Z_TEXTURE_UNIT, hi_z_texture);
+        gl_state::bind_buffer_range(GL_SHADER_STORAGE_BUFFER, COMMANDS_BINDING, command_buffer, 0,
+                                    num_commands * sizeof(draw_elements_indirect_command));
+        gl_state::bind_buffer_range(GL_SHADER_STORAGE_BUFFER, BOUNDS_BINDING, bounds_buffer, 0,
+                                    num_commands * sizeof(glm::vec4) * 2);
+        gl_state::bind_buffer_range(GL_SHADER_STORAGE_BUFFER, VISIBILITY_BINDING, visibility_buffer, 0,
+                                    visibility_capacity * sizeof(GLuint));
+
+        glDispatchCompute(get_num_groups(num_commands, COMMANDS_PER_GROUP), 1, 1);
+
+        // The commands are read by the phase 2 draws, and the visibility flags by next frame's phase 1
+        glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+}
@@ -0,0 +1,148 @@
+/*!
+ * \brief Culls chunks that are hidden behind other chunks, using a hierarchical depth buffer on the GPU
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_OCCLUSION_CULLER_H
+#define RENDERER_OCCLUSION_CULLER_H
+
+#include <cstdint>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+namespace nova {
+    /*!
+     * \brief Runs the compute shaders for two-phase occlusion culling of multi-drawn chunks
+     *
+     * Every chunk with a slot in the object data buffer has a visibility flag on the GPU, indexed by its slot. Each
+     * frame, a batch of chunks that passed frustum culling is drawn in two phases:
+     *
+     * 1. #keep_last_frames_visible sets each draw's instance count to the chunk's flag, so only chunks that were
+     *    visible last frame are drawn. Those are almost always most of what's visible this frame
+     * 2. #build_hi_z makes a max-depth mip pyramid from what phase 1 drew, and #cull_against_hi_z tests every chunk's
+     *    bounding box against it. Each chunk's flag is set to whether it passed, and only the chunks that passed but
+     *    weren't drawn in phase 1 are drawn again
+     *
+     * Nothing is read back to the CPU, so culling never stalls. Chunks that come into view show up the same frame,
+     * since phase 2 catches them, and chunks that go out of view stop being drawn the frame after
+     *
+     * The compute shaders use the SSBO bindings below, texture unit HI_Z_TEXTURE_UNIT, and image unit HI_Z_IMAGE_UNIT,
+     * and they leave their own program bound
+     */
+    class occlusion_culler {
+    public:
+        static const GLuint COMMANDS_BINDING = 5;
+        static const GLuint BOUNDS_BINDING = 6;
+        static const GLuint VISIBILITY_BINDING = 7;
+
+        static const GLuint HI_Z_TEXTURE_UNIT = 15;
+        static const GLuint HI_Z_IMAGE_UNIT = 7;
+
+        occlusion_culler() = default;
+
+        occlusion_culler(const occlusion_culler&) = delete;
+        occlusion_culler& operator=(const occlusion_culler&) = delete;
+
+        ~occlusion_culler();
+
+        void set_enabled(bool enabled);
+
+        /*!
+         * \brief Checks if culling is turned on, and if it has everything it needs to run
+         */
+        bool is_enabled() const;
+
+        /*!
+         * \brief Points the culler at the depth buffer that the chunks are drawn into
+         *
+         * Should be called whenever the depth buffer is remade. A depth texture of 0 turns culling off until there's
+         * a real one
+         */
+        void set_depth_texture(GLuint depth_texture, const glm::ivec2& size);
+
+        /*!
+         * \brief Sets the matrix that bounding boxes are projected with. Should be called once per frame
+         */
+        void set_view_projection(const glm::mat4& view_projection);
+
+        /*!
+         * \brief Sets how much of the depth buffer is drawn to, from dynamic resolution
+         *
+         * The rest of the depth buffer is left over from older frames. Boxes are only tested against the drawn part,
+         * and the hi-z texels on its edge take the farthest depth of both parts, so old depths can only keep things
+         * visible, never hide them
+         */
+        void set_render_scale(const glm::vec2& scale);
+
+        /*!
+         * \brief Makes sure there's a visibility flag for every object slot below the given number
+         */
+        void reserve_objects(uint32_t num_objects);
+
+        /*!
+         * \brief Sets the instance count of every command to the visibility flag of the object it draws
+         *
+         * \param command_buffer A buffer of draw_elements_indirect_command, whose base instances are object slots
+         * \param num_commands The number of commands in the buffer
+         */
+        void keep_last_frames_visible(GLuint command_buffer, GLuint num_commands);
+
+        /*!
+         * \brief Builds the hierarchical depth buffer from the depth texture
+         *
+         * Must be called after everything that should occlude has been drawn
+         */
+        void build_hi_z();
+
+        /*!
+         * \brief Tests each command's bounding box against the hierarchical depth buffer
+         *
+         * Each object's visibility flag is set to whether its box passed, and each command's instance count is set to
+         * 1 if its box passed but wasn't visible before, or 0 otherwise
+         *
+         * \param command_buffer The same commands that were passed to keep_last_frames_visible
+         * \param bounds_buffer Two vec4s for each command: the center of its bounding box, then the box's extents
+         * \param num_commands The number of commands in the buffers
+         */
+        void cull_against_hi_z(GLuint command_buffer, GLuint bounds_buffer, GLuint num_commands);
+
+    private:
+        bool enabled = true;
+
+        /*!
+         * \brief Set if a compute shader failed to build, so we don't try again every frame
+         */
+        bool programs_failed = false;
+
+        GLuint first_phase_program = 0;
+        GLuint hi_z_program = 0;
+        GLuint cull_program = 0;
+
+        GLuint depth_texture = 0;
+        glm::ivec2 depth_size;
+
+        GLuint hi_z_texture = 0;
+        glm::ivec2 hi_z_size;
+        int num_hi_z_levels = 0;
+
+        GLuint visibility_buffer = 0;
+        uint32_t visibility_capacity = 0;
+
+        glm::mat4 view_projection;
+
+        glm::vec2 render_scale = glm::vec2(1);
+
+        /*!
+         * \brief Compiles the compute shaders if they haven't been yet
+         *
+         * \return True if all the compute shaders are ready
+         */
+        bool create_programs();
+
+        void create_hi_z_texture();
+    };
+}
+
+#endif //RENDERER_OCCLUSION_CULLER_H
@@ -0,0 +1,653 @@
+/*!
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <algorithm>
+#include <numeric>
+#include <string>
+#include <easylogging++.h>
+#include "particle_system.h"
+#include "chunk_draw_batch.h"
+#include "frame_stats.h"
+#include "gl_state.h"
+#include "gpu_memory.h"
+#include "../windowing/glfw_gl_window.h"
+
+namespace nova {
+    /*!
+     * \brief The number of invocations in each work group of the shaders that run once per particle
+     */
+    static const GLuint PARTICLES_PER_GROUP = 64;
+
+    /*!
+     * \brief How many emitters can wait in the queue. Minecraft spawning more than this means the GPU can't keep up
+     * anyway, so the extras are dropped
+     */
+    static const size_t MAX_PENDING_EMITTERS = 16384;
+
+    static const GLuint PARTICLES_BINDING = 0;
+    static const GLuint ALIVE_BINDING = 1;
+    static const GLuint NEXT_ALIVE_BINDING = 2;
+    static const GLuint DEAD_BINDING = 3;
+    static const GLuint COUNTERS_BINDING = 4;
+    static const GLuint EMITTERS_BINDING = 5;
+    static const GLuint VERTICES_BINDING = 6;
+    static const GLuint INDIRECT_BINDING = 7;
+
+    /*!
+     * \brief Position, UV, and color, like format::POS_UV_COLOR
+     */
+    static const GLsizei FLOATS_PER_VERTEX = 9;
+
+    /*!
+     * \brief The particle, as the shaders see it
+     */
+    struct gpu_particle {
+        glm::vec4 position_age;
+        glm::vec4 velocity_lifetime;
+        glm::vec4 color;
+        glm::vec4 uv_rect;
+        glm::vec4 params;   //!< Size, gravity, drag, and the atlas and frame count packed into the float's bits
+    };
+
+    /*!
+     * \brief The counters the shaders share, laid out like the std430 block in the shaders
+     */
+    struct particle_counters {
+        GLint dead_count;
+        GLuint alive_count;
+        GLuint next_alive_count;
+        GLuint padding;
+        GLuint atlas_counts[particle_system::MAX_ATLASES];
+        GLuint atlas_offsets[particle_system::MAX_ATLASES];
+        GLuint atlas_cursors[particle_system::MAX_ATLASES];
+    };
+
+    /*!
+     * \brief Where the draw commands start in the indirect buffer, after the dispatch size
+     */
+    static const GLintptr DRAW_COMMANDS_OFFSET = 4 * sizeof(GLuint);
+
+    /*!
+     * \brief Goes in front of every particle shader
+     */
+    static const char* COMMON_SOURCE = R"(#version 450
+struct particle {
+    vec4 position_age;
+    vec4 velocity_lifetime;
+    vec4 color;
+    vec4 uv_rect;
+    vec4 params;
+};
+
+layout(std430, binding = 4) buffer counters {
+    int dead_count;
+    uint alive_count;
+    uint next_alive_count;
+    uint counters_padding;
+    uint atlas_counts[8];
+    uint atlas_offsets[8];
+    uint atlas_cursors[8];
+};
+
+struct draw_command {
+    uint count;
+    uint instance_count;
+    uint first_index;
+    int base_vertex;
+    uint base_instance;
+};
+)";
+
+    static const char* SPAWN_SOURCE = R"(
+layout(local_size_x = 64) in;
+
+struct emitter {
+    vec4 position_spread;
+    vec4 velocity_spread;
+    vec4 color;
+    vec4 uv_rect;
+    vec4 params;
+    vec4 lifetime_spread;
+    uvec4 info;
+};
+
+layout(std430, binding = 0) writeonly buffer particles {
+    particle all_particles[];
+};
+
+layout(std430, binding = 1) writeonly buffer alive_list {
+    uint alive[];
+};
+
+layout(std430, binding = 3) readonly buffer dead_list {
+    uint dead[];
+};
+
+layout(std430, binding = 5) readonly buffer emitter_list {
+    emitter emitters[];
+};
+
+layout(location = 0) uniform uint num_emitters;
+layout(location = 1) uniform uint num_spawns;
+layout(location = 2) uniform uint seed;
+
+uint hash(uint x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+float random(inout uint state) {
+    state = hash(state);
+    return float(state) / 4294967295.0;
+}
+
+vec3 random_in_cube(inout uint state) {
+    return vec3(random(state), random(state), random(state)) * 2.0 - 1.0;
+}
+
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    if(i >= num_spawns) {
+        return;
+    }
+
+    // Find the last emitter whose particles start at or before this one
+    uint low = 0;
+    uint high = num_emitters - 1;
+    while(low < high) {
+        uint middle = (low + high + 1) / 2;
+        if(emitters[middle].info.x <= i) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+    emitter source = emitters[low];
+
+    // Nothing is added to the dead list while this runs, so a slot that was popped can't be handed out twice
+    int dead_index = atomicAdd(dead_count, -1) - 1;
+    if(dead_index < 0) {
+        atomicAdd(dead_count, 1);
+        return;
+    }
+    uint slot = dead[dead_index];
+
+    uint state = hash(i ^ hash(seed));
+    float lifetime = max(source.params.w + (random(state) * 2.0 - 1.0) * source.lifetime_spread.x, 0.05);
+
+    particle new_particle;
+    new_particle.position_age = vec4(source.position_spread.xyz + random_in_cube(state) * source.position_spread.w, 0);
+    new_particle.velocity_lifetime = vec4(source.velocity_spread.xyz + random_in_cube(state) * source.velocity_spread.w, lifetime);
+    new_particle.color = source.color;
+    new_particle.uv_rect = source.uv_rect;
+    new_particle.params = vec4(source.params.xyz, uintBitsToFloat(source.info.z | (source.info.w << 8)));
+    all_particles[slot] = new_particle;
+
+    alive[atomicAdd(alive_count, 1u)] = slot;
+}
+)";
+
+    static const char* PREPARE_SIMULATE_SOURCE = R"(
+layout(local_size_x = 1) in;
+
+layout(std430, binding = 7) writeonly buffer indirect {
+    uvec4 dispatch_size;
+    draw_command commands[];
+};
+
+void main() {
+    dispatch_size = uvec4((alive_count + 63) / 64, 1, 1, 0);
+    next_alive_count = 0;
+    for(int atlas = 0; atlas < 8; atlas++) {
+        atlas_counts[atlas] = 0;
+    }
+}
+)";
+
+    static const char* SIMULATE_SOURCE = R"(
+layout(local_size_x = 64) in;
+
+layout(std430, binding = 0) buffer particles {
+    particle all_particles[];
+};
+
+layout(std430, binding = 1) readonly buffer alive_list {
+    uint alive[];
+};
+
+layout(std430, binding = 2) writeonly buffer next_alive_list {
+    uint next_alive[];
+};
+
+layout(std430, binding = 3) writeonly buffer dead_list {
+    uint dead[];
+};
+
+layout(location = 0) uniform float delta_time;
+
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    if(i >= alive_count) {
+        return;
+    }
+
+    uint slot = alive[i];
+    particle current = all_particles[slot];
+
+    float age = current.position_age.w + delta_time;
+    if(age >= current.velocity_lifetime.w) {
+        dead[atomicAdd(dead_count, 1)] = slot;
+        return;
+    }
+
+    vec3 velocity = current.velocity_lifetime.xyz;
+    velocity.y -= current.params.y * delta_time;
+    velocity *= pow(current.params.z, delta_time);
+
+    all_particles[slot].position_age = vec4(current.position_age.xyz + velocity * delta_time, age);
+    all_particles[slot].velocity_lifetime.xyz = velocity;
+
+    next_alive[atomicAdd(next_alive_count, 1u)] = slot;
+    atomicAdd(atlas_counts[floatBitsToUint(current.params.w) & 0xffu], 1u);
+}
+)";
+
+    static const char* PREPARE_EXPAND_SOURCE = R"(
+layout(local_size_x = 1) in;
+
+layout(std430, binding = 7) writeonly buffer indirect {
+    uvec4 dispatch_size;
+    draw_command commands[];
+};
+
+void main() {
+    alive_count = next_alive_count;
+    dispatch_size = uvec4((alive_count + 63) / 64, 1, 1, 0);
+
+    // Each atlas's quads go right after the one before it, so each atlas is one draw
+    uint offset = 0;
+    for(int atlas = 0; atlas < 8; atlas++) {
+        atlas_offsets[atlas] = offset;
+        atlas_cursors[atlas] = 0;
+        commands[atlas] = draw_command(atlas_counts[atlas] * 6u, 1u, offset * 6u, 0, 0u);
+        offset += atlas_counts[atlas];
+    }
+}
+)";
+
+    static const char* EXPAND_SOURCE = R"(
+layout(local_size_x = 64) in;
+
+layout(std430, binding = 0) readonly buffer particles {
+    particle all_particles[];
+};
+
+layout(std430, binding = 1) readonly buffer alive_list {
+    uint alive[];
+};
+
+layout(std430, binding = 6) writeonly buffer vertex_list {
+    float vertices[];
+};
+
+layout(location = 0) uniform vec3 camera_right;
+layout(location = 1) uniform vec3 camera_up;
+
+const vec2 CORNERS[4] = vec2[](vec2(-1, -1), vec2(1, -1), vec2(1, 1), vec2(-1, 1));
+
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    if(i >= alive_count) {
+        return;
+    }
+
+    particle current = all_particles[alive[i]];
+    uint packed_info = floatBitsToUint(current.params.w);
+    uint atlas = packed_info & 0xffu;
+    uint num_frames = max(packed_info >> 8, 1u);
+    uint quad = atlas_offsets[atlas] + atomicAdd(atlas_cursors[atlas], 1u);
+
+    float life = clamp(current.position_age.w / current.velocity_lifetime.w, 0.0, 1.0);
+    uint frame = min(uint(life * float(num_frames)), num_frames - 1);
+    float frame_width = (current.uv_rect.z - current.uv_rect.x) / float(num_frames);
+    vec2 uv_min = vec2(current.uv_rect.x + float(frame) * frame_width, current.uv_rect.y);
+    vec2 uv_max = vec2(uv_min.x + frame_width, current.uv_rect.w);
+
+    float half_size = current.params.x * 0.5;
+    for(uint corner = 0; corner < 4; corner++) {
+        vec2 offset = CORNERS[corner];
+        vec3 position = current.position_age.xyz + (camera_right * offset.x + camera_up * offset.y) * half_size;
+        vec2 uv = vec2(offset.x < 0 ? uv_min.x : uv_max.x, offset.y < 0 ? uv_max.y : uv_min.y);
+
+        uint base = (quad * 4 + corner) * 9;
+        vertices[base + 0] = position.x;
+        vertices[base + 1] = position.y;
+        vertices[base + 2] = position.z;
+        vertices[base + 3] = uv.x;
+        vertices[base + 4] = uv.y;
+        vertices[base + 5] = current.color.r;
+        vertices[base + 6] = current.color.g;
+        vertices[base + 7] = current.color.b;
+        vertices[base + 8] = current.color.a;
+    }
+}
+)";
+
+    /*!
+     * \brief Compiles and links a compute shader, with the common source in front of it
+     *
+     * \return The program, or 0 if it didn't compile or link
+     */
+    static GLuint compile_compute_program(const char* name, const char* source) {
+        const char* sources[] = {COMMON_SOURCE, source};
+        GLuint program = glCreateShaderProgramv(GL_COMPUTE_SHADER, 2, sources);
+
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if(linked == GL_FALSE) {
+            GLint log_length = 0;
+            glGetProgramiv(program, GL_INFO_LOG_LENGTH, &log_length);
+            std::string info_log(static_cast<size_t>(std::max(log_length, 1)), '\0');
+            glGetProgramInfoLog(program, log_length, nullptr, &info_log[0]);
+
+            LOG(ERROR) << "Could not build the particle " << name << " compute shader, so particles are off: " << info_log;
+            gl_state::delete_program(program);
+            return 0;
+        }
+
+        return program;
+    }
+
+    /*!
+     * \brief Makes a buffer and counts it against the GPU memory budget
+     */
+    static GLuint create_buffer(GLsizeiptr size, const void* data, GLbitfield flags) {
+        GLuint buffer;
+        glCreateBuffers(1, &buffer);
+        glNamedBufferStorage(buffer, size, data, flags);
+        gpu_memory::track_buffer(buffer, gpu_memory_category::buffers, static_cast<uint64_t>(size));
+        return buffer;
+    }
+
+    particle_system::~particle_system() {
+        if(glfwGetCurrentContext() == nullptr) {
+            return;
+        }
+
+        for(GLuint program : {spawn_program, prepare_simulate_program, simulate_program, prepare_expand_program, expand_program}) {
+            if(program != 0) {
+                gl_state::delete_program(program);
+            }
+        }
+
+        for(GLuint buffer : {particle_buffer, alive_buffers[0], alive_buffers[1], dead_buffer, counter_buffer, emitter_buffer,
+                             indirect_buffer, vertex_buffer, index_buffer}) {
+            if(buffer != 0) {
+                gl_state::delete_buffers(1, &buffer);
+            }
+        }
+
+        if(vao != 0) {
+            gl_state::delete_vertex_arrays(1, &vao);
+        }
+    }
+
+    int particle_system::add_atlas(uint32_t shader, texture_handle texture) {
+        for(size_t i = 0; i < atlases.size(); i++) {
+            if(atlases[i].shader == shader && atlases[i].texture == texture) {
+                return static_cast<int>(i);
+            }
+        }
+
+        if(atlases.size() >= MAX_ATLASES) {
+            LOG(ERROR) << "Particles can only use " << static_cast<uint32_t>(MAX_ATLASES) << " atlases";
+            return -1;
+        }
+
+        atlases.push_back({shader, texture});
+        return static_cast<int>(atlases.size() - 1);
+    }
+
+    void particle_system::spawn(const std::vector<mc_particle_emitter>& emitters) {
+        const size_t room = MAX_PENDING_EMITTERS - std::min(pending_emitters.size(), MAX_PENDING_EMITTERS);
+        if(emitters.size() > room) {
+            LOG(DEBUG) << "Dropping " << emitters.size() - room << " particle emitters, because too many are waiting";
+        }
+
+        pending_emitters.insert(pending_emitters.end(), emitters.begin(), emitters.begin() + std::min(emitters.size(), room));
+    }
+
+    void particle_system::clear() {
+        pending_emitters.clear();
+        needs_reset = true;
+    }
+
+    void particle_system::update(const glm::mat4& view_matrix) {
+        // Particles can't be spawned until there's an atlas for them, so there's nothing to do
+        if(atlases.empty() || !create_gl_objects()) {
+            return;
+        }
+
+        if(needs_reset) {
+            reset_buffers();
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        float delta_time = 0;
+        if(last_update != std::chrono::steady_clock::time_point{}) {
+            // Long hitches would send particles flying, so they get slowed down instead
+            delta_time = std::min(std::chrono::duration<float>(now - last_update).count(), 0.1f);
+        }
+        last_update = now;
+
+        const uint32_t num_spawns = take_emitters(pending_emitters, static_cast<uint32_t>(atlases.size()),
+                                                  MAX_EMITTERS_PER_FRAME, MAX_PARTICLES, emitter_batch);
+
+        gl_state::bind_buffer_range(GL_SHADER_STORAGE_BUFFER, PARTICLES_BINDING, particle_buffer, 0,
+                                    MAX_PARTICLES * sizeof(gpu_particle));
+        gl_state::bind_buffer_range(GL_SHADER_STORAGE_BUFFER, DEAD_BINDING, dead_buffer, 0, MAX_PARTICLES * sizeof(GLuint));
+        gl_state::bind_buffer_range(GL_SHADER_STORAGE_BUFFER, COUNTERS_BINDING, counter_buffer, 0, sizeof(particle_counters));
+        gl_state::bind_buffer_range(GL_SHADER_STORAGE_BUFFER, INDIRECT_BINDING, indirect_buffer, 0,
+                                    DRAW_COMMANDS_OFFSET + MAX_ATLASES * sizeof(draw_elements_indirect_command));
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, indirect_buffer);
+
+        const GLuint current_list = alive_buffers[current_alive];
+        const GLuint next_list = alive_buffers[1 - current_alive];
+
+        if(num_spawns > 0) {
+            const auto emitter_size = static_cast<GLsizeiptr>(emitter_batch.size() * sizeof(particle_emitter_data));
+            glNamedBufferSubData(emitter_buffer, 0, emitter_size, emitter_batch.data());
+            frame_stats::count_upload(static_cast<uint64_t>(emitter_size));
+
+            gl_state::bind_buffer_range(GL_SHADER_STORAGE_BUFFER, ALIVE_BINDING, current_list, 0, MAX_PARTICLES * sizeof(GLuint));
+            gl_state::bind_buffer_range(GL_SHADER_STORAGE_BUFFER, EMITTERS_BINDING, emitter_buffer, 0, emitter_size);
+
+            gl_state::use_program(spawn_program);
+            glProgramUniform1ui(spawn_program, 0, static_cast<GLuint>(emitter_batch.size()));
+            glProgramUniform1ui(spawn_program, 1, num_spawns);
+            glProgramUniform1ui(spawn_program, 2, frame_seed);
+            glDispatchCompute((num_spawns + PARTICLES_PER_GROUP - 1) / PARTICLES_PER_GROUP, 1, 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+
+        gl_state::use_program(prepare_simulate_program);
+        glDispatchCompute(1, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+        gl_state::bind_buffer_range(GL_SHADER_STORAGE_BUFFER, ALIVE_BINDING, current_list, 0, MAX_PARTICLES * sizeof(GLuint));
+        gl_state::bind_buffer_range(GL_SHADER_STORAGE_BUFFER, NEXT_ALIVE_BINDING, next_list, 0, MAX_PARTICLES * sizeof(GLuint));
+        gl_state::use_program(simulate_program);
+        glProgramUniform1f(simulate_program, 0, delta_time);
+        glDispatchComputeIndirect(0);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        gl_state::use_program(prepare_expand_program);
+        glDispatchCompute(1, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+        // The camera's right and up vectors are the first two rows of the view matrix
+        const glm::vec3 camera_right(view_matrix[0][0], view_matrix[1][0], view_matrix[2][0]);
+        const glm::vec3 camera_up(view_matrix[0][1], view_matrix[1][1], view_matrix[2][1]);
+
+        gl_state::bind_buffer_range(GL_SHADER_STORAGE_BUFFER, ALIVE_BINDING, next_list, 0, MAX_PARTICLES * sizeof(GLuint));
+        gl_state::bind_buffer_range(GL_SHADER_STORAGE_BUFFER, VERTICES_BINDING, vertex_buffer, 0,
+                                    MAX_PARTICLES * 4 * FLOATS_PER_VERTEX * sizeof(GLfloat));
+        gl_state::use_program(expand_program);
+        glProgramUniform3fv(expand_program, 0, 1, &camera_right[0]);
+        glProgramUniform3fv(expand_program, 1, 1, &camera_up[0]);
+        glDispatchComputeIndirect(0);
+        glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+
+        current_alive = 1 - current_alive;
+        frame_seed++;
+    }
+
+    void particle_system::draw(uint32_t shader, texture_manager& textures) {
+        if(vao == 0 || programs_failed) {
+            return;
+        }
+
+        bool bound_buffers = false;
+        for(size_t i = 0; i < atlases.size(); i++) {
+            if(atlases[i].shader != shader) {
+                continue;
+            }
+
+            if(!bound_buffers) {
+                gl_state::bind_vertex_array(vao);
+                gl_state::bind_buffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer);
+                bound_buffers = true;
+            }
+
+            textures.bind_texture(atlases[i].texture, 0);
+            glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                                   reinterpret_cast<void*>(DRAW_COMMANDS_OFFSET + i * sizeof(draw_elements_indirect_command)));
+
+            // The number of particles never comes back to the CPU, so neither does the number of triangles
+            frame_stats::count_draw(0);
+        }
+
+        if(bound_buffers) {
+            gl_state::bind_buffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        }
+    }
+
+    uint32_t particle_system::take_emitters(std::deque<mc_particle_emitter>& pending, uint32_t num_atlases,
+                                            uint32_t max_emitters, uint32_t max_particles,
+                                            std::vector<particle_emitter_data>& batch) {
+        batch.clear();
+
+        uint32_t num_particles = 0;
+        while(!pending.empty() && batch.size() < max_emitters) {
+            const auto& emitter = pending.front();
+            if(emitter.atlas < 0 || static_cast<uint32_t>(emitter.atlas) >= num_atlases || emitter.count <= 0) {
+                pending.pop_front();
+                continue;
+            }
+
+            const uint32_t count = std::min(static_cast<uint32_t>(emitter.count), max_particles);
+            if(num_particles + count > max_particles) {
+                break;
+            }
+
+            particle_emitter_data data = {};
+            data.position_spread = glm::vec4(emitter.position[0], emitter.position[1], emitter.position[2], emitter.position_spread);
+            data.velocity_spread = glm::vec4(emitter.velocity[0], emitter.velocity[1], emitter.velocity[2], emitter.velocity_spread);
+            data.color = glm::vec4(emitter.color[0], emitter.color[1], emitter.color[2], emitter.color[3]);
+            data.uv_rect = glm::vec4(emitter.uv_min[0], emitter.uv_min[1], emitter.uv_max[0], emitter.uv_max[1]);
+            data.params = glm::vec4(emitter.size, emitter.gravity, emitter.drag, emitter.lifetime);
+            data.lifetime_spread = glm::vec4(emitter.lifetime_spread, 0, 0, 0);
+
+            // The frame count shares a uint with the atlas in the shaders, so it has to fit in 24 bits
+            const auto num_frames = static_cast<uint32_t>(std::min(std::max(emitter.num_frames, 1), 0xffffff));
+            data.info = glm::uvec4(num_particles, count, static_cast<uint32_t>(emitter.atlas), num_frames);
+
+            batch.push_back(data);
+            num_particles += count;
+            pending.pop_front();
+        }
+
+        return num_particles;
+    }
+
+    bool particle_system::create_gl_objects() {
+        if(programs_failed) {
+            return false;
+        }
+
+        if(spawn_program != 0) {
+            return true;
+        }
+
+        spawn_program = compile_compute_program("spawn", SPAWN_SOURCE);
+        prepare_simulate_program = compile_compute_program("prepare simulate", PREPARE_SIMULATE_SOURCE);
+        simulate_program = compile_compute_program("simulate", SIMULATE_SOURCE);
+        prepare_expand_program = compile_compute_program("prepare expand", PREPARE_EXPAND_SOURCE);
+        expand_program = compile_compute_program("expand", EXPAND_SOURCE);
+        programs_failed = spawn_program == 0 || prepare_simulate_program == 0 || simulate_program == 0
+                          || prepare_expand_program == 0 || expand_program == 0;
+        if(programs_failed) {
+            return false;
+        }
+
+        particle_buffer = create_buffer(MAX_PARTICLES * sizeof(gpu_particle), nullptr, 0);
+        alive_buffers[0] = create_buffer(MAX_PARTICLES * sizeof(GLuint), nullptr, 0);
+        alive_buffers[1] = create_buffer(MAX_PARTICLES * sizeof(GLuint), nullptr, 0);
+        dead_buffer = create_buffer(MAX_PARTICLES * sizeof(GLuint), nullptr, GL_DYNAMIC_STORAGE_BIT);
+        counter_buffer = create_buffer(sizeof(particle_counters), nullptr, GL_DYNAMIC_STORAGE_BIT);
+        emitter_buffer = create_buffer(MAX_EMITTERS_PER_FRAME * sizeof(particle_emitter_data), nullptr, GL_DYNAMIC_STORAGE_BIT);
+        indirect_buffer = create_buffer(DRAW_COMMANDS_OFFSET + MAX_ATLASES * sizeof(draw_elements_indirect_command),
+                                        nullptr, GL_DYNAMIC_STORAGE_BIT);
+        vertex_buffer = create_buffer(MAX_PARTICLES * 4 * FLOATS_PER_VERTEX * sizeof(GLfloat), nullptr, 0);
+
+        // Every particle is a quad, so the indices never change
+        std::vector<GLuint> indices;
+        indices.reserve(MAX_PARTICLES * 6);
+        for(GLuint quad = 0; quad < MAX_PARTICLES; quad++) {
+            for(GLuint corner : {0, 1, 2, 2, 3, 0}) {
+                indices.push_back(quad * 4 + corner);
+            }
+        }
+        index_buffer = create_buffer(static_cast<GLsizeiptr>(indices.size() * sizeof(GLuint)), indices.data(), 0);
+        frame_stats::count_upload(indices.size() * sizeof(GLuint));
+
+        glCreateVertexArrays(1, &vao);
+        glEnableVertexArrayAttrib(vao, 0);   // Position
+        glEnableVertexArrayAttrib(vao, 1);   // Texture UV
+        glEnableVertexArrayAttrib(vao, 2);   // Vertex color
+        glVertexArrayAttribFormat(vao, 0, 3, GL_FLOAT, GL_FALSE, 0);
+        glVertexArrayAttribFormat(vao, 1, 2, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat));
+        glVertexArrayAttribFormat(vao, 2, 4, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat));
+        glVertexArrayAttribBinding(vao, 0, 0);
+        glVertexArrayAttribBinding(vao, 1, 0);
+        glVertexArrayAttribBinding(vao, 2, 0);
+        glVertexArrayVertexBuffer(vao, 0, vertex_buffer, 0, FLOATS_PER_VERTEX * sizeof(GLfloat));
+        glVertexArrayElementBuffer(vao, index_buffer);
+
+        return true;
+    }
+
+    void particle_system::reset_buffers() {
+        std::vector<GLuint> free_slots(MAX_PARTICLES);
+        std::iota(free_slots.begin(), free_slots.end(), 0);
+        glNamedBufferSubData(dead_buffer, 0, static_cast<GLsizeiptr>(free_slots.size() * sizeof(GLuint)), free_slots.data());
+
+        particle_counters counters = {};
+        counters.dead_count = MAX_PARTICLES;
+        glNamedBufferSubData(counter_buffer, 0, sizeof(counters), &counters);
+
+        // Draws before the next update shouldn't draw anything
+        glClearNamedBufferData(indirect_buffer, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+        frame_stats::count_upload(free_slots.size() * sizeof(GLuint) + sizeof(counters));
+
+        needs_reset = false;
+    }
+}
@@ -0,0 +1,208 @@
+/*!
+ * \brief Spawns, simulates, and draws particles on the GPU
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_PARTICLE_SYSTEM_H
+#define RENDERER_PARTICLE_SYSTEM_H
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "textures/texture_manager.h"
+#include "../../mc_interface/mc_objects.h"
+
+namespace nova {
+    /*!
+     * \brief One emitter in the buffer that the spawn shader reads, laid out like the std430 struct in the shader
+     */
+    struct particle_emitter_data {
+        glm::vec4 position_spread;      //!< xyz is where particles spawn, w is how far from there they can be
+        glm::vec4 velocity_spread;      //!< xyz is the particles' starting velocity, w is how far it can be off by
+        glm::vec4 color;
+        glm::vec4 uv_rect;              //!< xy is the top left of the first frame in the atlas, zw the bottom right of the last
+        glm::vec4 params;               //!< Size, gravity, drag, and lifetime
+        glm::vec4 lifetime_spread;      //!< x is how far the lifetime can be off by. yzw are unused
+
+        /*!
+         * \brief x is the index of this emitter's first particle among all the particles spawned this frame, y is how
+         * many particles it spawns, z is its atlas, and w is how many animation frames it has
+         */
+        glm::uvec4 info;
+    };
+
+    /*!
+     * \brief Keeps every particle on the GPU, so the CPU does the same small amount of work each frame no matter how
+     * many particles are alive
+     *
+     * Minecraft sends emitters with spawn_particles. Each emitter spawns a burst of particles with randomized
+     * positions, velocities, and lifetimes, all with the same texture. The emitters are queued, and each frame
+     * #update uploads the queued emitters and runs a few compute shaders:
+     *
+     * 1. The spawn shader takes a free particle slot from the dead list for each new particle, and adds it to the list
+     *    of live particles
+     * 2. The simulate shader moves each live particle. Particles that have outlived their lifetime go back on the
+     *    dead list, and the rest are compacted into the other live list, counting how many use each atlas
+     * 3. The expand shader sorts the live particles by atlas, and writes a camera-facing quad for each of them into a
+     *    vertex buffer, in the POS_UV_COLOR format
+     *
+     * The dispatches after the spawn shader, and the draws, take their sizes from indirect buffers the shaders fill
+     * in, so the particle counts are never read back. #draw then needs one glDrawElementsIndirect per atlas, with
+     * whichever shader the atlas's filter picked. Since the quads have normal vertex attributes, any shader that
+     * draws POS_UV_COLOR geometry in world space can draw particles
+     *
+     * Like everything else that touches GL, this has to be used from the render thread. The GL objects aren't made
+     * until the first frame, so this can be made before there's a context
+     */
+    class particle_system {
+    public:
+        /*!
+         * \brief How many particles can be alive at once. Particles spawned while the system is full are dropped
+         */
+        static const uint32_t MAX_PARTICLES = 65536;
+
+        /*!
+         * \brief How many textures particles can use. Each one costs a draw
+         */
+        static const uint32_t MAX_ATLASES = 8;
+
+        /*!
+         * \brief How many emitters are uploaded each frame. The rest wait for the next frame
+         */
+        static const uint32_t MAX_EMITTERS_PER_FRAME = 1024;
+
+        particle_system() = default;
+
+        particle_system(const particle_system&) = delete;
+        particle_system& operator=(const particle_system&) = delete;
+
+        ~particle_system();
+
+        /*!
+         * \brief Adds a texture that particles can use
+         *
+         * \param shader The mesh store's ID for the shader the atlas's particles are drawn with
+         * \param texture The texture
+         * \return The atlas's index for mc_particle_emitter::atlas, or -1 if there are already MAX_ATLASES atlases
+         */
+        int add_atlas(uint32_t shader, texture_handle texture);
+
+        /*!
+         * \brief Queues emitters, which spawn their particles in the next frame that has room for them
+         */
+        void spawn(const std::vector<mc_particle_emitter>& emitters);
+
+        /*!
+         * \brief Kills every particle and drops every queued emitter, like when the player leaves a world
+         */
+        void clear();
+
+        /*!
+         * \brief Spawns new particles, moves the live ones, and builds this frame's quads
+         *
+         * Should be called once per frame, before anything is drawn
+         *
+         * \param view_matrix The camera's view matrix, which the quads are turned to face
+         */
+        void update(const glm::mat4& view_matrix);
+
+        /*!
+         * \brief Draws the particles of every atlas that uses the given shader
+         *
+         * \param shader The mesh store's ID for the shader
+         * \param textures The texture manager to bind the atlases from
+         */
+        void draw(uint32_t shader, texture_manager& textures);
+
+        /*!
+         * \brief Takes as many emitters off the front of the queue as can be spawned this frame
+         *
+         * The emitters are taken in order, and stop at the first one that doesn't fit in max_emitters or max_particles.
+         * An emitter that spawns more than max_particles on its own is cut down to max_particles, so it can't block
+         * the queue forever. Emitters with an atlas that doesn't exist are dropped
+         *
+         * \param pending The queued emitters
+         * \param num_atlases The number of atlases
+         * \param max_emitters How many emitters can be taken
+         * \param max_particles How many particles they can spawn between them
+         * \param batch Filled with the emitters that were taken, with their first particles counted up
+         * \return The number of particles the batch spawns
+         */
+        static uint32_t take_emitters(std::deque<mc_particle_emitter>& pending, uint32_t num_atlases, uint32_t max_emitters,
+                                      uint32_t max_particles, std::vector<particle_emitter_data>& batch);
+
+    private:
+        struct particle_atlas {
+            uint32_t shader;
+            texture_handle texture;
+        };
+
+        std::vector<particle_atlas> atlases;
+
+        std::deque<mc_particle_emitter> pending_emitters;
+
+        /*!
+         * \brief Scratch space for the emitters uploaded each frame
+         */
+        std::vector<particle_emitter_data> emitter_batch;
+
+        /*!
+         * \brief Set if a compute shader failed to build, so we don't try again every frame
+         */
+        bool programs_failed = false;
+
+        /*!
+         * \brief Set when every particle should be killed before the next update
+         */
+        bool needs_reset = true;
+
+        GLuint spawn_program = 0;
+        GLuint prepare_simulate_program = 0;
+        GLuint simulate_program = 0;
+        GLuint prepare_expand_program = 0;
+        GLuint expand_program = 0;
+
+        GLuint particle_buffer = 0;
+
+        /*!
+         * \brief The two lists of live particle indices. Each frame's simulation reads one and writes the other
+         */
+        GLuint alive_buffers[2] = {0, 0};
+        int current_alive = 0;
+
+        GLuint dead_buffer = 0;
+        GLuint counter_buffer = 0;
+        GLuint emitter_buffer = 0;
+
+        /*!
+         * \brief The compute dispatch size, then one draw_elements_indirect_command for each atlas
+         */
+        GLuint indirect_buffer = 0;
+
+        GLuint vertex_buffer = 0;
+        GLuint index_buffer = 0;
+        GLuint vao = 0;
+
+        uint32_t frame_seed = 0;
+        std::chrono::steady_clock::time_point last_update;
+
+        /*!
+         * \brief Compiles the compute shaders and makes the buffers if they haven't been yet
+         *
+         * \return True if the particle system can run
+         */
+        bool create_gl_objects();
+
+        /*!
+         * \brief Puts every particle slot on the dead list and empties the live lists
+         */
+        void reset_buffers();
+    };
+}
+
+#endif //RENDERER_PARTICLE_SYSTEM_H
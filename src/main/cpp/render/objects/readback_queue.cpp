@@ -0,0 +1,167 @@
+/*!
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <easylogging++.h>
+#include "readback_queue.h"
+#include "gl_state.h"
+#include "../windowing/glfw_gl_window.h"
+#include "../../utils/stb_image_write.h"
+
+namespace nova {
+    readback_queue::readback_queue() : encoder(std::make_unique<thread_pool>(1, "readback encoder")) {}
+
+    readback_queue::~readback_queue() {
+        if(glfwGetCurrentContext() != nullptr) {
+            for(auto& read : reads_in_flight) {
+                glDeleteSync(read.fence);
+                gl_state::delete_buffers(1, &read.buffer);
+            }
+        }
+
+        // The encodes use this queue's tickets, so they have to finish before anything else goes away
+        encoder.reset();
+    }
+
+    uint64_t readback_queue::reserve_ticket() {
+        uint64_t ticket = next_ticket++;
+
+        std::lock_guard<std::mutex> lock(pending_tickets_lock);
+        pending_tickets.insert(ticket);
+        return ticket;
+    }
+
+    bool readback_queue::is_complete(uint64_t ticket) const {
+        std::lock_guard<std::mutex> lock(pending_tickets_lock);
+        return pending_tickets.find(ticket) == pending_tickets.end();
+    }
+
+    void readback_queue::read_backbuffer(uint64_t ticket, const glm::ivec2& size, const std::string& path) {
+        if(size.x <= 0 || size.y <= 0) {
+            LOG(ERROR) << "Can't save " << path << " because the window has no size";
+            fail(ticket);
+            return;
+        }
+
+        GLuint buffer = begin_read(size, 4);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        glReadBuffer(GL_BACK);
+        glReadPixels(0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        end_read(ticket, path, size, 4, buffer);
+    }
+
+    void readback_queue::read_texture(uint64_t ticket, GLuint texture, const std::string& path) {
+        glm::ivec2 size;
+        glGetTextureLevelParameteriv(texture, 0, GL_TEXTURE_WIDTH, &size.x);
+        glGetTextureLevelParameteriv(texture, 0, GL_TEXTURE_HEIGHT, &size.y);
+        if(size.x <= 0 || size.y <= 0) {
+            LOG(ERROR) << "Can't save " << path << " because its texture is empty";
+            fail(ticket);
+            return;
+        }
+
+        GLint depth_size = 0;
+        glGetTextureLevelParameteriv(texture, 0, GL_TEXTURE_DEPTH_SIZE, &depth_size);
+        const bool is_depth = depth_size > 0;
+        const int num_components = is_depth ? 1 : 4;
+
+        GLuint buffer = begin_read(size, num_components);
+        const auto buffer_size = static_cast<GLsizei>(size.x * size.y * num_components);
+        if(is_depth) {
+            glGetTextureImage(texture, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_BYTE, buffer_size, nullptr);
+        } else {
+            glGetTextureImage(texture, 0, GL_RGBA, GL_UNSIGNED_BYTE, buffer_size, nullptr);
+        }
+        end_read(ticket, path, size, num_components, buffer);
+    }
+
+    void readback_queue::update() {
+        auto read = reads_in_flight.begin();
+        while(read != reads_in_flight.end()) {
+            GLenum status = glClientWaitSync(read->fence, 0, 0);
+            if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+                ++read;
+                continue;
+            }
+
+            const auto row_size = static_cast<size_t>(read->size.x * read->num_components);
+            auto pixels = std::make_shared<std::vector<uint8_t>>(row_size * read->size.y);
+            const void* mapped = glMapNamedBufferRange(read->buffer, 0, static_cast<GLsizeiptr>(pixels->size()), GL_MAP_READ_BIT);
+            if(mapped != nullptr) {
+                std::memcpy(pixels->data(), mapped, pixels->size());
+                glUnmapNamedBuffer(read->buffer);
+            } else {
+                LOG(ERROR) << "Could not map the pixels for " << read->path;
+                pixels.reset();
+            }
+
+            glDeleteSync(read->fence);
+            gl_state::delete_buffers(1, &read->buffer);
+
+            if(pixels) {
+                const auto ticket = read->ticket;
+                const auto path = read->path;
+                const auto size = read->size;
+                const auto num_components = read->num_components;
+                encoder->add_task([this, ticket, path, size, num_components, row_size, pixels]() {
+                    flip_rows(*pixels, row_size);
+                    if(stbi_write_png(path.c_str(), size.x, size.y, num_components, pixels->data(), static_cast<int>(row_size)) == 0) {
+                        LOG(ERROR) << "Could not write " << path;
+                    } else {
+                        LOG(INFO) << "Saved " << path;
+                    }
+                    complete(ticket);
+                });
+
+            } else {
+                complete(read->ticket);
+            }
+
+            read = reads_in_flight.erase(read);
+        }
+    }
+
+    void readback_queue::fail(uint64_t ticket) {
+        complete(ticket);
+    }
+
+    void readback_queue::flip_rows(std::vector<uint8_t>& pixels, size_t row_size) {
+        if(row_size == 0) {
+            return;
+        }
+
+        const size_t num_rows = pixels.size() / row_size;
+        for(size_t row = 0; row < num_rows / 2; row++) {
+            std::swap_ranges(pixels.begin() + row * row_size, pixels.begin() + (row + 1) * row_size,
+                             pixels.begin() + (num_rows - row - 1) * row_size);
+        }
+    }
+
+    GLuint readback_queue::begin_read(const glm::ivec2& size, int num_components) {
+        const auto buffer_size = static_cast<GLsizeiptr>(size.x * size.y * num_components);
+
+        // Client storage asks the driver to keep the buffer where the CPU can read it quickly
+        GLuint buffer;
+        glCreateBuffers(1, &buffer);
+        glNamedBufferStorage(buffer, buffer_size, nullptr, GL_MAP_READ_BIT | GL_CLIENT_STORAGE_BIT);
+
+        gl_state::bind_buffer(GL_PIXEL_PACK_BUFFER, buffer);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        return buffer;
+    }
+
+    void readback_queue::end_read(uint64_t ticket, const std::string& path, const glm::ivec2& size, int num_components, GLuint buffer) {
+        gl_state::bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+        reads_in_flight.push_back({ticket, path, size, num_components, buffer, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0)});
+    }
+
+    void readback_queue::complete(uint64_t ticket) {
+        std::lock_guard<std::mutex> lock(pending_tickets_lock);
+        pending_tickets.erase(ticket);
+    }
+}
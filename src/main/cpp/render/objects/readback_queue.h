@@ -0,0 +1,113 @@
+/*!
+ * \brief Reads images back from the GPU and saves them as PNGs without stalling the render thread
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_READBACK_QUEUE_H
+#define RENDERER_READBACK_QUEUE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "../../utils/thread_pool.h"
+
+namespace nova {
+    /*!
+     * \brief Copies images into pixel pack buffers, and writes them to disk once the GPU has caught up
+     *
+     * A read starts a glReadPixels or glGetTextureImage into a new pixel pack buffer, and puts a fence after it. The
+     * GPU does the copy whenever it gets to it, so the render thread doesn't wait. Each frame #update checks the
+     * fences without blocking, and maps the buffers whose copies are done, usually a frame or two later. The pixels
+     * are then flipped and encoded to PNG on a worker thread.
+     *
+     * Reads are tracked with tickets, like texture uploads. #reserve_ticket and #is_complete can be called from any
+     * thread, and everything else has to be called from the render thread
+     */
+    class readback_queue {
+    public:
+        readback_queue();
+
+        readback_queue(const readback_queue&) = delete;
+        readback_queue& operator=(const readback_queue&) = delete;
+
+        ~readback_queue();
+
+        uint64_t reserve_ticket();
+
+        /*!
+         * \brief Checks if the image for the given ticket has been written, or has failed to be
+         */
+        bool is_complete(uint64_t ticket) const;
+
+        /*!
+         * \brief Starts reading the default framebuffer's back buffer
+         *
+         * Should be called after everything has been drawn, and before the buffers are swapped
+         */
+        void read_backbuffer(uint64_t ticket, const glm::ivec2& size, const std::string& path);
+
+        /*!
+         * \brief Starts reading level 0 of a texture. Depth textures are saved as grayscale
+         */
+        void read_texture(uint64_t ticket, GLuint texture, const std::string& path);
+
+        /*!
+         * \brief Hands every read the GPU has finished to the encoder
+         */
+        void update();
+
+        /*!
+         * \brief Marks a ticket as done without reading anything, for reads that couldn't be started
+         */
+        void fail(uint64_t ticket);
+
+        /*!
+         * \brief Turns bottom-up rows, like OpenGL gives back, into top-down rows
+         */
+        static void flip_rows(std::vector<uint8_t>& pixels, size_t row_size);
+
+    private:
+        struct pending_read {
+            uint64_t ticket;
+            std::string path;
+            glm::ivec2 size;
+            int num_components;
+            GLuint buffer;
+            GLsync fence;
+        };
+
+        std::atomic<uint64_t> next_ticket{1};
+
+        mutable std::mutex pending_tickets_lock;
+        std::unordered_set<uint64_t> pending_tickets;
+
+        std::vector<pending_read> reads_in_flight;
+
+        /*!
+         * \brief Encodes PNGs. Destroying it finishes the encodes that are already queued
+         */
+        std::unique_ptr<thread_pool> encoder;
+
+        /*!
+         * \brief Makes a pixel pack buffer big enough for the image, and binds it so the next read goes into it
+         */
+        GLuint begin_read(const glm::ivec2& size, int num_components);
+
+        /*!
+         * \brief Fences the read that was just issued, and starts waiting for it
+         */
+        void end_read(uint64_t ticket, const std::string& path, const glm::ivec2& size, int num_components, GLuint buffer);
+
+        void complete(uint64_t ticket);
+    };
+}
+
+#endif //RENDERER_READBACK_QUEUE_H
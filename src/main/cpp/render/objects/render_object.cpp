@@ -2,44 +2,115 @@
 // Created by ddubois on 8/8/17.
 //
 
+#include <algorithm>
+#include <iterator>
 #include "render_object.h"
 
 namespace nova {
     render_object::render_object(render_object &&other) noexcept {
         parent_id = other.parent_id;
         type = other.type;
+        name = other.name;
         geometry = std::move(other.geometry);
-        color_texture = std::move(other.color_texture);
-        normalmap = std::move(other.normalmap);
-        data_texture = std::move(other.data_texture);
+        arena_handle = other.arena_handle;
+        std::copy(std::begin(other.lod_arena_handles), std::end(other.lod_arena_handles), std::begin(lod_arena_handles));
+        num_lods = other.num_lods;
+        current_lod = other.current_lod;
+        last_visible_frame = other.last_visible_frame;
+        object_slot = other.object_slot;
+        material = other.material;
         bounding_box = std::move(other.bounding_box);
-        needs_deletion=std::move(other.needs_deletion);
         position = other.position;
 
         other.parent_id = 0;
         other.geometry.reset();
-        other.normalmap = std::experimental::optional<std::string>();
-        other.data_texture = std::experimental::optional<std::string>();
+        other.arena_handle = {};
+        std::fill(std::begin(other.lod_arena_handles), std::end(other.lod_arena_handles), chunk_arena_handle());
+        other.num_lods = 1;
+        other.current_lod = 0;
+        other.last_visible_frame = 0;
+        other.object_slot = object_data_buffer::NO_OBJECT;
+        other.material = NO_MATERIAL;
+        other.name = NO_NAME;
         other.position = {0, 0, 0};
     }
 
     render_object &render_object::operator=(render_object && other) noexcept {
         parent_id = other.parent_id;
         type = other.type;
+        name = other.name;
         geometry = std::move(other.geometry);
-        color_texture = std::move(other.color_texture);
-        normalmap = std::move(other.normalmap);
-        data_texture = std::move(other.data_texture);
+        arena_handle = other.arena_handle;
+        std::copy(std::begin(other.lod_arena_handles), std::end(other.lod_arena_handles), std::begin(lod_arena_handles));
+        num_lods = other.num_lods;
+        current_lod = other.current_lod;
+        last_visible_frame = other.last_visible_frame;
+        object_slot = other.object_slot;
+        material = other.material;
         bounding_box = std::move(other.bounding_box);
         position = other.position;
-        needs_deletion=std::move(other.needs_deletion);
 
         other.parent_id = 0;
         other.geometry.reset();
-        other.normalmap = std::experimental::optional<std::string>();
-        other.data_texture = std::experimental::optional<std::string>();
+        other.arena_handle = {};
+        std::fill(std::begin(other.lod_arena_handles), std::end(other.lod_arena_handles), chunk_arena_handle());
+        other.num_lods = 1;
+        other.current_lod = 0;
+        other.last_visible_frame = 0;
+        other.object_slot = object_data_buffer::NO_OBJECT;
+        other.material = NO_MATERIAL;
+        other.name = NO_NAME;
         other.position = {0, 0, 0};
 
         return *this;
     }
+
+    const chunk_arena_handle& render_object::get_arena_handle(uint32_t lod) const {
+        return lod == 0 ? arena_handle : lod_arena_handles[lod - 1];
+    }
+
+    material_id material_table::add(const render_material& material) {
+        // Newlines can't be in texture names, so they keep the names apart in the key
+        std::string key = material.color_texture;
+        key += '\n';
+        key += material.normalmap ? *material.normalmap : "";
+        key += '\n';
+        key += material.data_texture ? *material.data_texture : "";
+
+        auto id = material_ids.find(key);
+        if(id != material_ids.end()) {
+            return id->second;
+        }
+
+        const auto new_id = static_cast<material_id>(materials.size());
+        materials.push_back(material);
+        material_ids.emplace(std::move(key), new_id);
+        return new_id;
+    }
+
+    const render_material& material_table::get(material_id id) const {
+        static const render_material no_material = {};
+        return id < materials.size() ? materials[id] : no_material;
+    }
+
+    size_t material_table::size() const {
+        return materials.size();
+    }
+
+    name_id name_table::intern(const std::string& name) {
+        auto id = name_ids.find(name);
+        if(id != name_ids.end()) {
+            return id->second;
+        }
+
+        const auto new_id = static_cast<name_id>(names.size());
+        names.push_back(name);
+        name_ids.emplace(name, new_id);
+        return new_id;
+    }
+
+    const std::string& name_table::get(name_id id) const {
+        static const std::string no_name;
+        return id < names.size() ? names[id] : no_name;
+    }
 }
\ No newline at end of file
@@ -10,11 +10,16 @@
 
 #include <string>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 #include <optional.hpp>
 
 #include "gl_mesh.h"
+#include "chunk_arena.h"
+#include "object_data_buffer.h"
 #include "../../utils/smart_enum.h"
 #include "textures/texture_manager.h"
+#include "../../geometry_cache/chunk_lod.h"
 
 
 namespace nova {
@@ -34,12 +39,130 @@ namespace nova {
     lit_particle, \
     eyes);
 
+    /*!
+     * \brief Identifies a render_material in a material_table
+     */
+    typedef uint32_t material_id;
+    const material_id NO_MATERIAL = 0xFFFFFFFF;
+
+    /*!
+     * \brief Identifies a render object's name in a name_table
+     */
+    typedef uint32_t name_id;
+    const name_id NO_NAME = 0xFFFFFFFF;
+
+    /*!
+     * \brief The textures that a render object is drawn with
+     */
+    struct render_material {
+        std::string color_texture;
+        std::experimental::optional<std::string> normalmap;
+        std::experimental::optional<std::string> data_texture;
+
+        /*!
+         * \brief The texture manager's handles for the textures above, so drawing never has to look textures up by
+         * name. Whatever sets a texture name should set its handle too
+         */
+        texture_handle color_texture_handle = NO_TEXTURE;
+        texture_handle normalmap_handle = NO_TEXTURE;
+        texture_handle data_texture_handle = NO_TEXTURE;
+    };
+
+    /*!
+     * \brief Every distinct material that render objects use
+     *
+     * Tens of thousands of chunks share a handful of materials, so each render object only keeps a material_id. Adding
+     * a material that's already in the table gives back the ID it already has
+     */
+    class material_table {
+    public:
+        material_id add(const render_material& material);
+
+        /*!
+         * \brief Gets the material with the given ID. NO_MATERIAL, or an ID that isn't in the table, gives a material
+         * with no textures
+         */
+        const render_material& get(material_id id) const;
+
+        size_t size() const;
+
+    private:
+        std::vector<render_material> materials;
+
+        /*!
+         * \brief The ID of each material, keyed by its texture names
+         */
+        std::unordered_map<std::string, material_id> material_ids;
+    };
+
+    /*!
+     * \brief Every distinct render object name
+     *
+     * Names are only there for debugging, so they're kept out of the way of the draw loop
+     */
+    class name_table {
+    public:
+        name_id intern(const std::string& name);
+
+        /*!
+         * \brief Gets the name with the given ID, or an empty string for NO_NAME
+         */
+        const std::string& get(name_id id) const;
+
+    private:
+        std::vector<std::string> names;
+        std::unordered_map<std::string, name_id> name_ids;
+    };
+
     /*!
      * \brief Represents something that can be rendered
      *
      * This provides a number of values that you can filter things by.
+     *
+     * The draw loop goes through every visible render object each frame, so the fields it reads are at the front, and
+     * anything big that it doesn't need lives in a side table. The name and the textures are IDs into a name_table
+     * and a material_table
      */
     struct render_object {
+        /*!
+         * \brief Where this object's geometry lives in the chunk arena, for objects which don't have their own gl_mesh
+         */
+        chunk_arena_handle arena_handle;
+
+        /*!
+         * \brief Where the simplified versions of this object's geometry live in the chunk arena. Level 1 is at index 0
+         */
+        chunk_arena_handle lod_arena_handles[NUM_CHUNK_LODS - 1];
+
+        glm::vec3 position;
+
+        /*!
+         * \brief This object's slot in the object data buffer, or object_data_buffer::NO_OBJECT if it doesn't have one
+         */
+        uint32_t object_slot = object_data_buffer::NO_OBJECT;
+
+        /*!
+         * \brief How many levels of detail this object has, counting arena_handle as level 0
+         */
+        uint32_t num_lods = 1;
+
+        /*!
+         * \brief The level of detail this object was last drawn with
+         */
+        uint32_t current_lod = 0;
+
+        material_id material = NO_MATERIAL;
+
+        aabb bounding_box;
+
+        std::unique_ptr<gl_mesh> geometry;
+
+        /*!
+         * \brief The last frame, as counted by the mesh store, that this object passed culling. The least recently
+         * seen chunks are the first to go when the mesh store is over its memory budget
+         */
+        uint64_t last_visible_frame = 0;
+
         int parent_id;  //!< The ID of the thing that owns us. Could be the ID of a chunk, entity, whatever
 
         geometry_type type;
@@ -68,25 +191,17 @@ namespace nova {
          * - snow
          * - fullscreen_quad
          */
-        std::string name;
-
-        std::unique_ptr<gl_mesh> geometry;
-
-        std::string color_texture;
-        std::experimental::optional<std::string> normalmap;
-        std::experimental::optional<std::string> data_texture;
-
-        glm::vec3 position;
-
-        aabb bounding_box;
-
-        bool needs_deletion;
+        name_id name = NO_NAME;
 
         render_object() = default;
         render_object(render_object&& other) noexcept;
-        render_object(const render_object&) = default;
 
         render_object& operator=(render_object&& other) noexcept;
+
+        /*!
+         * \brief Returns the arena handle for the given level of detail, which must be less than num_lods
+         */
+        const chunk_arena_handle& get_arena_handle(uint32_t lod) const;
     };
 }
 
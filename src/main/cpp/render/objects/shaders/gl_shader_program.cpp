@@ -5,31 +5,119 @@
 
 #include <cstdlib>
 #include <algorithm>
+#include <cctype>
 
 #include <easylogging++.h>
 #include "gl_shader_program.h"
+#include "../gl_state.h"
 
 namespace nova {
-    gl_shader_program::gl_shader_program(const shader_definition &source) : name(source.name) {
+    gl_shader_program::gl_shader_program(const shader_definition &source, const shader_program_cache* cache) :
+            name(source.name), drawbuffers(source.drawbuffers), reads(source.reads), compute(source.is_compute()) {
         LOG(TRACE) << "Creating shader with filter expression " << source.filter_expression;
         filter = source.filter_expression;
         LOG(TRACE) << "Created filter expression " << filter;
-        create_shader(source.vertex_source, GL_VERTEX_SHADER);
+
+        if(compute) {
+            const std::string compute_source = get_full_source(source.compute_source, source.specialization_constants,
+                                                               source.define_lines);
+            if(cache != nullptr && cache->is_supported()) {
+                // Every fragment shader has a version line, so an empty one keeps compute programs from sharing keys with the
+                // vertex and fragment programs
+                cache_key = cache->make_key(compute_source, "");
+                if(load_from_cache(*cache)) {
+                    LOG(DEBUG) << "Loaded program " << name << " from the program cache";
+                    return;
+                }
+
+                save_to_cache = true;
+            }
+
+            create_shader(compute_source, source.compute_source, source.specialization_constants, GL_COMPUTE_SHADER);
+            link();
+            return;
+        }
+
+        const std::string vertex_source = get_full_source(source.vertex_source, source.specialization_constants,
+                                                          source.define_lines, true);
+        const std::string fragment_source = get_full_source(source.fragment_source, source.specialization_constants,
+                                                            source.define_lines);
+
+        if(cache != nullptr && cache->is_supported()) {
+            cache_key = cache->make_key(vertex_source, fragment_source);
+            if(load_from_cache(*cache)) {
+                LOG(DEBUG) << "Loaded program " << name << " from the program cache";
+                return;
+            }
+
+            save_to_cache = true;
+        }
+
+        create_shader(vertex_source, source.vertex_source, source.specialization_constants, GL_VERTEX_SHADER);
         LOG(TRACE) << "Creatd vertex shader";
-        create_shader(source.fragment_source, GL_FRAGMENT_SHADER);
+        create_shader(fragment_source, source.fragment_source, source.specialization_constants, GL_FRAGMENT_SHADER);
         LOG(TRACE) << "Created fragment shader";
 
         link();
     }
 
     gl_shader_program::gl_shader_program(gl_shader_program &&other) noexcept :
-            name(std::move(other.name)), filter(std::move(other.filter)) {
+            name(std::move(other.name)), geometry_id(other.geometry_id), added_shaders(std::move(other.added_shaders)),
+            added_shader_sources(std::move(other.added_shader_sources)), cache_key(other.cache_key),
+            save_to_cache(other.save_to_cache), finished(other.finished),
+            uniform_locations(std::move(other.uniform_locations)),
+            uniform_block_indices(std::move(other.uniform_block_indices)),
+            storage_block_indices(std::move(other.storage_block_indices)), builtin_uniforms(other.builtin_uniforms),
+            filter(std::move(other.filter)), drawbuffers(std::move(other.drawbuffers)), reads(std::move(other.reads)),
+            compute(other.compute), work_group_size(other.work_group_size) {
 
         this->gl_name = other.gl_name;
 
         // Make the other shader not a thing
         other.gl_name = 0;
         other.added_shaders.clear();
+        other.added_shader_sources.clear();
+    }
+
+    gl_shader_program& gl_shader_program::operator=(gl_shader_program &&other) noexcept {
+        if(this == &other) {
+            return *this;
+        }
+
+        for(GLuint shader : added_shaders) {
+            glDeleteShader(shader);
+        }
+        if(gl_name != 0) {
+            gl_state::delete_program(gl_name);
+        }
+
+        gl_name = other.gl_name;
+        name = std::move(other.name);
+        geometry_id = other.geometry_id;
+        added_shaders = std::move(other.added_shaders);
+        added_shader_sources = std::move(other.added_shader_sources);
+        cache_key = other.cache_key;
+        save_to_cache = other.save_to_cache;
+        finished = other.finished;
+        uniform_locations = std::move(other.uniform_locations);
+        uniform_block_indices = std::move(other.uniform_block_indices);
+        storage_block_indices = std::move(other.storage_block_indices);
+        builtin_uniforms = other.builtin_uniforms;
+        filter = std::move(other.filter);
+        drawbuffers = std::move(other.drawbuffers);
+        reads = std::move(other.reads);
+        compute = other.compute;
+        work_group_size = other.work_group_size;
+
+        other.gl_name = 0;
+        other.added_shaders.clear();
+        other.added_shader_sources.clear();
+        other.uniform_locations.clear();
+        other.uniform_block_indices.clear();
+        other.storage_block_indices.clear();
+        other.builtin_uniforms = {};
+
+        return *this;
     }
 
     void gl_shader_program::link() {
@@ -41,8 +129,37 @@ namespace nova {
             glAttachShader(gl_name, shader);
         }
 
+        if(save_to_cache) {
+            glProgramParameteri(gl_name, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+
+        // With parallel shader compilation this returns right away. The errors are checked in finish
         glLinkProgram(gl_name);
+    }
+
+    bool gl_shader_program::is_ready() const {
+        if(finished || !GLAD_GL_ARB_parallel_shader_compile) {
+            return true;
+        }
+
+        GLint is_complete = GL_FALSE;
+        glGetProgramiv(gl_name, GL_COMPLETION_STATUS_ARB, &is_complete);
+        return is_complete == GL_TRUE;
+    }
+
+    void gl_shader_program::finish(const shader_program_cache* cache) {
+        if(finished) {
+            return;
+        }
+        finished = true;
+
+        // A shader that didn't compile makes the link fail too, and the compile error is the useful one
+        for(size_t i = 0; i < added_shaders.size(); i++) {
+            check_for_shader_errors(added_shaders[i], added_shader_sources[i]);
+        }
+
         check_for_linking_errors();
+        reflect();
 
         LOG(DEBUG) << "Program " << name << " linked successfully";
 
@@ -51,11 +168,58 @@ namespace nova {
             glDetachShader(gl_name, shader);
             glDeleteShader(shader);
         }
+        added_shaders.clear();
+        added_shader_sources.clear();
 
         LOG(DEBUG) << "Cleaned up resources";
+
+        if(save_to_cache && cache != nullptr) {
+            save_to(*cache);
+        }
+    }
+
+    bool gl_shader_program::load_from_cache(const shader_program_cache& cache) {
+        GLenum binary_format = GL_NONE;
+        std::vector<uint8_t> binary;
+        if(!cache.load(cache_key, binary_format, binary)) {
+            return false;
+        }
+
+        gl_name = glCreateProgram();
+        glObjectLabel(GL_PROGRAM, gl_name, (GLsizei) name.length(), name.c_str());
+        glProgramBinary(gl_name, binary_format, binary.data(), (GLsizei) binary.size());
+
+        GLint is_linked = GL_FALSE;
+        glGetProgramiv(gl_name, GL_LINK_STATUS, &is_linked);
+        if(is_linked == GL_FALSE) {
+            LOG(INFO) << "The driver didn't take the cached binary for program " << name << ", so it'll be compiled";
+            gl_state::delete_program(gl_name);
+            gl_name = 0;
+            return false;
+        }
+
+        reflect();
+        finished = true;
+        return true;
     }
 
-    void gl_shader_program::check_for_shader_errors(GLuint shader_to_check, const std::vector<shader_line>& line_map) {
+    void gl_shader_program::save_to(const shader_program_cache& cache) {
+        GLint binary_length = 0;
+        glGetProgramiv(gl_name, GL_PROGRAM_BINARY_LENGTH, &binary_length);
+        if(binary_length <= 0) {
+            return;
+        }
+
+        GLenum binary_format = GL_NONE;
+        std::vector<uint8_t> binary(static_cast<size_t>(binary_length));
+        glGetProgramBinary(gl_name, binary_length, &binary_length, &binary_format, binary.data());
+        binary.resize(static_cast<size_t>(binary_length));
+
+        cache.save(cache_key, binary_format, binary);
+        LOG(DEBUG) << "Saved program " << name << " to the program cache";
+    }
+
+    void gl_shader_program::check_for_shader_errors(GLuint shader_to_check, const shader_source& line_map) {
         GLint success = 0;
 
         glGetShaderiv(shader_to_check, GL_COMPILE_STATUS, &success);
@@ -87,7 +251,7 @@ namespace nova {
             glGetProgramInfoLog(gl_name, log_length, &log_length, info_log);
 
             if(log_length > 0) {
-                glDeleteProgram(gl_name);
+                gl_state::delete_program(gl_name);
 
                 LOG(ERROR) << "Error linking program " << gl_name << ":\n" << info_log;
 
@@ -99,7 +263,7 @@ namespace nova {
 
     void gl_shader_program::bind() noexcept {
         //LOG(INFO) << "Binding program " << name;
-        glUseProgram(gl_name);
+        gl_state::use_program(gl_name);
     }
 
     gl_shader_program::~gl_shader_program() {
@@ -108,22 +272,105 @@ namespace nova {
         //glDeleteProgram(gl_name);
     }
 
-    void gl_shader_program::create_shader(const std::vector<shader_line>& shader_source, const GLenum shader_type) {
-        LOG(TRACE) << "Creating a shader from source\n" << shader_source;
+    std::string gl_shader_program::get_full_source(const shader_source& source,
+                                                   const std::vector<specialization_constant>& constants,
+                                                   const std::vector<std::string>& define_lines,
+                                                   bool invariant_position) {
+        LOG(TRACE) << "Creating a shader from source\n" << source;
 
-        std::string full_shader_source;
-        auto& version_line = shader_source[0].line;
+        if(source.empty()) {
+            throw wrong_shader_version("");
+        }
+
+        if(source.is_spirv()) {
+            // The driver gets the words themselves, so this is only for the program cache's key. The constants change
+            // the compiled program as much as the code does
+            std::string key_text(reinterpret_cast<const char*>(source.spirv.data()),
+                                 source.spirv.size() * sizeof(uint32_t));
+            key_text.append(reinterpret_cast<const char*>(constants.data()),
+                            constants.size() * sizeof(specialization_constant));
+            return key_text;
+        }
+
+        auto& version_line = source[0].line;
         LOG(TRACE) << "Version line: '" << version_line << "'";
 
-        if(version_line == "#version 450") {
-            // GLSL 450 code! This is the simplest: just concatenate all the lines in the shader file
-            std::for_each(
-                    std::begin(shader_source), std::end(shader_source),
-                    [&](auto &line) { full_shader_source.append(line.line + "\n"); }
-            );
+        if(version_line != "#version 450") {
+            throw wrong_shader_version(version_line);
+        }
 
-        } else {
-            throw wrong_shader_version(shader_source[0].line);
+        // #extension lines have to come before any declarations, so the invariant declaration goes after the last one
+        // at the top of the file
+        static const std::string INVARIANT_POSITION = "invariant gl_Position;";
+        size_t invariant_after = 0;
+        if(invariant_position) {
+            for(const auto& line : source.lines) {
+                if(line.line.find(INVARIANT_POSITION) != std::string::npos) {
+                    invariant_position = false;
+                    break;
+                }
+            }
+
+            for(size_t i = 1; i < source.lines.size(); i++) {
+                const auto& line = source.lines[i].line;
+                const size_t first_char = line.find_first_not_of(" \t");
+                if(first_char == std::string::npos || line.compare(first_char, 2, "//") == 0) {
+                    continue;
+                }
+                if(line.compare(first_char, 1, "#") != 0) {
+                    break;
+                }
+                if(line.compare(first_char, 10, "#extension") == 0) {
+                    invariant_after = i;
+                }
+            }
+        }
+
+        // GLSL 450 code! This is the simplest: just concatenate all the lines in the shader file, with the variant's
+        // defines after the version line. #line puts the line numbers back, so errors still point at the right line
+        size_t full_size = INVARIANT_POSITION.size() + 32;
+        for(auto& line : define_lines) {
+            full_size += line.size() + 1;
+        }
+        for(auto& line : source.lines) {
+            full_size += line.line.size() + 1;
+        }
+
+        std::string full_shader_source;
+        full_shader_source.reserve(full_size);
+        for(size_t i = 0; i < source.lines.size(); i++) {
+            full_shader_source.append(source.lines[i].line);
+            full_shader_source.push_back('\n');
+
+            bool added_lines = false;
+            if(i == 0 && !define_lines.empty()) {
+                for(auto& line : define_lines) {
+                    full_shader_source.append(line);
+                    full_shader_source.push_back('\n');
+                }
+                added_lines = true;
+            }
+            if(invariant_position && i == invariant_after) {
+                full_shader_source.append(INVARIANT_POSITION);
+                full_shader_source.push_back('\n');
+                added_lines = true;
+            }
+            if(added_lines) {
+                // Keeps the driver counting the shader's own lines, which is how compilation_error maps errors back
+                full_shader_source.append("#line " + std::to_string(i + 2));
+                full_shader_source.push_back('\n');
+            }
+        }
+
+        return full_shader_source;
+    }
+
+    void gl_shader_program::create_shader(const std::string& full_shader_source, const shader_source& source,
+                                          const std::vector<specialization_constant>& constants,
+                                          const GLenum shader_type) {
+        if(source.is_spirv()) {
+            create_spirv_shader(source, constants, shader_type);
+            return;
         }
 
         auto shader_name = glCreateShader(shader_type);
@@ -132,11 +379,45 @@ namespace nova {
 
         glShaderSource(shader_name, 1, &shader_source_char, nullptr);
 
+        // With parallel shader compilation this returns right away. The errors are checked in finish
         glCompileShader(shader_name);
 
-        check_for_shader_errors(shader_name, shader_source);
+        added_shaders.push_back(shader_name);
+        added_shader_sources.push_back(source);
+    }
+
+    void gl_shader_program::create_spirv_shader(const shader_source& source,
+                                                const std::vector<specialization_constant>& constants,
+                                                const GLenum shader_type) {
+        if(!GLAD_GL_VERSION_4_6 && !GLAD_GL_ARB_gl_spirv) {
+            throw spirv_not_supported(source.files[0]);
+        }
+
+        auto shader_name = glCreateShader(shader_type);
+        glShaderBinary(1, &shader_name, GL_SHADER_BINARY_FORMAT_SPIR_V_ARB, source.spirv.data(),
+                       (GLsizei) (source.spirv.size() * sizeof(uint32_t)));
+
+        // Constants the module doesn't declare are ignored, so every shader can get all of the shaderpack's options
+        std::vector<GLuint> constant_ids;
+        std::vector<GLuint> constant_values;
+        constant_ids.reserve(constants.size());
+        constant_values.reserve(constants.size());
+        for(const auto& constant : constants) {
+            constant_ids.push_back(constant.id);
+            constant_values.push_back(constant.value);
+        }
+
+        // Specializing is where the driver compiles the SPIR-V, so it sets the compile status like glCompileShader
+        if(GLAD_GL_VERSION_4_6) {
+            glSpecializeShader(shader_name, "main", (GLuint) constant_ids.size(), constant_ids.data(),
+                               constant_values.data());
+        } else {
+            glSpecializeShaderARB(shader_name, "main", (GLuint) constant_ids.size(), constant_ids.data(),
+                                  constant_values.data());
+        }
 
         added_shaders.push_back(shader_name);
+        added_shader_sources.push_back(source);
     }
 
     std::string & gl_shader_program::get_filter() noexcept {
@@ -147,27 +428,196 @@ namespace nova {
         return name;
     }
 
-    GLint gl_shader_program::get_uniform_location(const std::string uniform_name) {
-        auto location_in_uniform_locations = uniform_locations.find(uniform_name);
-        if(location_in_uniform_locations == uniform_locations.end()) {
-            uniform_locations[uniform_name] = glGetUniformLocation(gl_name, uniform_name.c_str());
+    GLint gl_shader_program::get_uniform_location(const std::string& uniform_name) const {
+        auto location = uniform_locations.find(uniform_name);
+        return location == uniform_locations.end() ? -1 : location->second;
+    }
+
+    GLuint gl_shader_program::get_uniform_block_index(const std::string& block_name) const {
+        auto index = uniform_block_indices.find(block_name);
+        return index == uniform_block_indices.end() ? GL_INVALID_INDEX : index->second;
+    }
+
+    bool gl_shader_program::has_shader_storage_block(const std::string& block_name) const {
+        return storage_block_indices.find(block_name) != storage_block_indices.end();
+    }
+
+    const builtin_uniform_slots& gl_shader_program::get_builtin_uniforms() const noexcept {
+        return builtin_uniforms;
+    }
+
+    /*!
+     * \brief Gets the name of every active resource in one of the program's interfaces, in order of resource index
+     */
+    static std::vector<std::string> get_resource_names(GLuint program, GLenum program_interface) {
+        GLint num_resources = 0;
+        GLint max_name_length = 0;
+        glGetProgramInterfaceiv(program, program_interface, GL_ACTIVE_RESOURCES, &num_resources);
+        glGetProgramInterfaceiv(program, program_interface, GL_MAX_NAME_LENGTH, &max_name_length);
+
+        std::vector<std::string> names;
+        names.reserve(static_cast<size_t>(num_resources));
+        std::vector<GLchar> name_buffer(static_cast<size_t>(max_name_length) + 1);
+        for(GLint i = 0; i < num_resources; i++) {
+            GLsizei length = 0;
+            glGetProgramResourceName(program, program_interface, static_cast<GLuint>(i), (GLsizei) name_buffer.size(),
+                                     &length, name_buffer.data());
+            names.emplace_back(name_buffer.data(), static_cast<size_t>(length));
+        }
+
+        return names;
+    }
+
+    void gl_shader_program::reflect() {
+        uniform_locations.clear();
+        uniform_block_indices.clear();
+        storage_block_indices.clear();
+
+        const auto uniform_names = get_resource_names(gl_name, GL_UNIFORM);
+        for(size_t i = 0; i < uniform_names.size(); i++) {
+            const GLenum property = GL_LOCATION;
+            GLint location = -1;
+            glGetProgramResourceiv(gl_name, GL_UNIFORM, static_cast<GLuint>(i), 1, &property, 1, nullptr, &location);
+            if(location < 0) {
+                // Uniforms in blocks don't have locations
+                continue;
+            }
+
+            const auto& uniform_name = uniform_names[i];
+            uniform_locations[uniform_name] = location;
+
+            static const std::string ARRAY_SUFFIX = "[0]";
+            if(uniform_name.size() > ARRAY_SUFFIX.size() &&
+               uniform_name.compare(uniform_name.size() - ARRAY_SUFFIX.size(), ARRAY_SUFFIX.size(), ARRAY_SUFFIX) == 0) {
+                uniform_locations[uniform_name.substr(0, uniform_name.size() - ARRAY_SUFFIX.size())] = location;
+            }
+        }
+
+        const auto uniform_block_names = get_resource_names(gl_name, GL_UNIFORM_BLOCK);
+        for(size_t i = 0; i < uniform_block_names.size(); i++) {
+            uniform_block_indices[uniform_block_names[i]] = static_cast<GLuint>(i);
+        }
+
+        const auto storage_block_names = get_resource_names(gl_name, GL_SHADER_STORAGE_BLOCK);
+        for(size_t i = 0; i < storage_block_names.size(); i++) {
+            storage_block_indices[storage_block_names[i]] = static_cast<GLuint>(i);
+        }
+
+        builtin_uniforms.gbuffer_model = get_uniform_location("gbufferModel");
+        builtin_uniforms.shadow_cascade = get_uniform_location("shadowCascade");
+        builtin_uniforms.has_chunk_offsets = has_shader_storage_block("chunk_offsets");
+        builtin_uniforms.has_object_data = has_shader_storage_block("object_data");
+        builtin_uniforms.has_entity_instances = has_shader_storage_block("entity_instances");
+        builtin_uniforms.has_sprite_locations = has_shader_storage_block("sprite_locations");
+
+        work_group_size = glm::uvec3(0);
+        if(compute) {
+            GLint local_size[3] = {0, 0, 0};
+            glGetProgramiv(gl_name, GL_COMPUTE_WORK_GROUP_SIZE, local_size);
+            work_group_size = glm::uvec3(local_size[0], local_size[1], local_size[2]);
         }
 
-        return uniform_locations[uniform_name];
+        LOG(TRACE) << "Program " << name << " has " << uniform_locations.size() << " uniforms, "
+                   << uniform_block_indices.size() << " uniform blocks, and " << storage_block_indices.size()
+                   << " shader storage blocks";
     }
 
+    const std::vector<unsigned int>& gl_shader_program::get_drawbuffers() const noexcept {
+        return drawbuffers;
+    }
+
+    const std::vector<std::string>& gl_shader_program::get_reads() const noexcept {
+        return reads;
+    }
+
+    bool gl_shader_program::is_compute() const noexcept {
+        return compute;
+    }
+
+    const glm::uvec3& gl_shader_program::get_work_group_size() const noexcept {
+        return work_group_size;
+    }
+
+    uint32_t gl_shader_program::get_geometry_id() const noexcept {
+        return geometry_id;
+    }
+
+    void gl_shader_program::set_geometry_id(uint32_t id) noexcept {
+        geometry_id = id;
+    }
+
+    spirv_not_supported::spirv_not_supported(const std::string &file_name) :
+            std::runtime_error(
+                    "Could not load " + file_name + " because the driver doesn't support SPIR-V shaders"
+            ) {}
+
     wrong_shader_version::wrong_shader_version(const std::string &version_line) :
             std::runtime_error(
                     "Invalid version line: '" + version_line + "'. Please only use GLSL version 450 (NOT compatibility profile)"
             ) {}
 
-    compilation_error::compilation_error(const std::string &error_message,
-                                         const std::vector<shader_line> source_lines) :
-            std::runtime_error(error_message + get_original_line_message(error_message, source_lines)) {}
+    compilation_error::compilation_error(const std::string &error_message, const shader_source &source) :
+            std::runtime_error(error_message + get_original_line_message(error_message, source)) {}
+
+    /*!
+     * \brief Finds the line number in a line of a driver's error log
+     *
+     * \return The line number, or -1 if the error line doesn't have one
+     */
+    static int get_error_line_number(const std::string &error_line) {
+        // Look for the source string number, then a ':' or '(', then the line number
+        for(size_t i = 0; i < error_line.size(); i++) {
+            if(!std::isdigit(static_cast<unsigned char>(error_line[i]))) {
+                continue;
+            }
+
+            size_t separator = i;
+            while(separator < error_line.size() && std::isdigit(static_cast<unsigned char>(error_line[separator]))) {
+                separator++;
+            }
+
+            if(separator + 1 < error_line.size() && (error_line[separator] == ':' || error_line[separator] == '(') &&
+                    std::isdigit(static_cast<unsigned char>(error_line[separator + 1]))) {
+                return std::atoi(error_line.c_str() + separator + 1);
+            }
+
+            i = separator;
+        }
+
+        return -1;
+    }
 
     std::string compilation_error::get_original_line_message(const std::string &error_message,
-                                                             const std::vector<shader_line> source_lines) {
-        return "This logic isn't implemented yet";
+                                                             const shader_source &source) {
+        if(source.is_spirv()) {
+            // There's no source to map the error back to, only the file the SPIR-V came from
+            return "\nIn " + source.files[0];
+        }
+
+        std::string message;
+
+        size_t line_begin = 0;
+        while(line_begin < error_message.size()) {
+            size_t line_end = error_message.find('\n', line_begin);
+            if(line_end == std::string::npos) {
+                line_end = error_message.size();
+            }
+
+            const std::string error_line = error_message.substr(line_begin, line_end - line_begin);
+            const int line_number = get_error_line_number(error_line);
+            if(line_number >= 1 && static_cast<size_t>(line_number) <= source.size()) {
+                const auto& line = source[line_number - 1];
+                message += "\n" + source.get_file_name(line) + ":" + std::to_string(line.line_num) + ": " + error_line;
+            }
+
+            line_begin = line_end + 1;
+        }
+
+        if(message.empty()) {
+            return "";
+        }
+
+        return "\nIn the original files:" + message;
     }
 
 }
@@ -13,8 +13,10 @@
 #include <vector>
 
 #include <glad/glad.h>
+#include <glm/glm.hpp>
 #include "../../../utils/export.h"
 #include "../../../data_loading/loaders/shader_source_structs.h"
+#include "shader_program_cache.h"
 
 
 namespace nova {
@@ -24,19 +26,24 @@ namespace nova {
     class compilation_error : public std::runtime_error {
     public:
         /*!
-         * \brief Constructs a compilation_error with the provided message, using the given list of shader_lines to
+         * \brief Constructs a compilation_error with the provided message, using the given shader source to
          * map from line number in the error message to line number and shader file on disk
          *
          * \param error_message The compilation message, straight from the driver
-         * \param source_lines The list of source_line objects that maps from line in the shader sent to the driver
-         * to the line number and shader file on disk
+         * \param source The source that was sent to the driver. Its lines map from line in the shader sent to the
+         * driver to the line number and shader file on disk
          */
-        compilation_error(const std::string &error_message, const std::vector<shader_line> source_lines);
+        compilation_error(const std::string &error_message, const shader_source &source);
 
-    private:
-
-        std::string
-        get_original_line_message(const std::string &error_message, const std::vector<shader_line> source_lines);
+        /*!
+         * \brief Finds the line each line of the error message is about, and says where that line is on disk
+         *
+         * Drivers write the line as 0(12) or 0:12, where 0 is the source string and 12 is the line in it. Error lines
+         * without a line number that's in the source are left out
+         *
+         * \return The error lines with their original file and line number, or an empty string if none had one
+         */
+        static std::string get_original_line_message(const std::string &error_message, const shader_source &source);
     };
 
     class wrong_shader_version : public std::runtime_error {
@@ -44,15 +51,63 @@ namespace nova {
         wrong_shader_version(const std::string &version_line);
     };
 
+    /*!
+     * \brief Thrown when a shaderpack has a SPIR-V shader but the driver doesn't support GL_ARB_gl_spirv
+     */
+    class spirv_not_supported : public std::runtime_error {
+    public:
+        spirv_not_supported(const std::string &file_name);
+    };
+
     class program_linking_failure : public std::runtime_error {
     public:
         program_linking_failure(const std::string name) : std::runtime_error("Program " + name + " failed to link") {};
     };
 
+    /*!
+     * \brief Where the uniforms that Nova sets on every draw live in a program, so drawing doesn't look them up by name
+     */
+    struct builtin_uniform_slots {
+        /*!
+         * \brief The location of gbufferModel, or -1 if the program doesn't use it
+         */
+        GLint gbuffer_model = -1;
+
+        /*!
+         * \brief The location of shadowCascade, the index of the shadow cascade being drawn, or -1 if the program
+         * doesn't use it
+         */
+        GLint shadow_cascade = -1;
+
+        /*!
+         * \brief If true, the program reads its chunk offsets from the chunk_offsets shader storage block, so its
+         * chunks can be drawn with multi-draws
+         */
+        bool has_chunk_offsets = false;
+
+        /*!
+         * \brief If true, the program reads each object's data from the object_data shader storage block, indexed
+         * by gl_BaseInstanceARB, so it doesn't need gbufferModel for objects that have an object data slot
+         */
+        bool has_object_data = false;
+
+        /*!
+         * \brief If true, the program reads each entity's transform from the entity_instances shader storage block,
+         * so every copy of an entity model can be drawn with one instanced draw
+         */
+        bool has_entity_instances = false;
+
+        /*!
+         * \brief If true, the program reads sprites' UV rectangles from the sprite_locations shader storage block, so
+         * it can be given UVs that go across one sprite instead of the whole atlas
+         */
+        bool has_sprite_locations = false;
+    };
+
     /*!
      * \brief Represents an OpenGL shader program
      *
-     * Shader programs can include between two and five shaders. At the bare minimum, a shader program needs a vertex shader
+     * Shader programs can include between two and five shaders, or be a single compute shader. At the bare minimum, a shader program needs a vertex shader
      * and a fragment shader. A shader program can also have a geometry shader, a tessellation control shader, and a
      * tessellation evaluation shader. Note that if a shader program has one of the tessellation shaders, it must also have
      * the other tessellation shader.
@@ -65,12 +120,20 @@ namespace nova {
      */
     class gl_shader_program {
     public:
-        GLuint gl_name;
+        GLuint gl_name = 0;
 
         /*!
-         * \brief Constructs a gl_shader_program
+         * \brief Constructs a gl_shader_program and starts compiling it
+         *
+         * If the cache has a binary for the program's source, the program is loaded from that and is ready right away.
+         * Otherwise its shaders are compiled and linked. With GL_ARB_parallel_shader_compile the driver does that on
+         * its own threads, so this returns before it's done. Either way, #finish has to be called before the program
+         * is used
+         *
+         * \param source The program's shaders
+         * \param cache The cache to load the program from and save it to, or nullptr to not cache it
          */
-        explicit gl_shader_program(const shader_definition &source);
+        explicit gl_shader_program(const shader_definition &source, const shader_program_cache* cache = nullptr);
 
         /*!
          * \brief Default copy constructor
@@ -87,6 +150,14 @@ namespace nova {
          */
         gl_shader_program(gl_shader_program &&other) noexcept;
 
+        /*!
+         * \brief Replaces this program with the other one, deleting this program's GL objects
+         *
+         * Anything holding a reference to this gl_shader_program uses the other program from now on, which is how
+         * reloaded shaders get swapped in
+         */
+        gl_shader_program& operator=(gl_shader_program &&other) noexcept;
+
         gl_shader_program() = default;
 
         /*!
@@ -94,6 +165,23 @@ namespace nova {
          */
         ~gl_shader_program();
 
+        /*!
+         * \brief Checks if the driver is done compiling and linking this program, so #finish won't have to wait
+         */
+        bool is_ready() const;
+
+        /*!
+         * \brief Waits for the program to finish linking and checks it for errors
+         *
+         * If the program wasn't loaded from the cache, its binary is saved to the cache. Does nothing if the program
+         * has already finished
+         *
+         * \param cache The cache to save the program to. Should be the same cache the program was constructed with
+         * \throws compilation_error if one of the shaders didn't compile
+         * \throws program_linking_failure if the program didn't link
+         */
+        void finish(const shader_program_cache* cache = nullptr);
+
         /*!
          * \brief Sets this shader as the currently active shader
          */
@@ -103,25 +191,95 @@ namespace nova {
 
         std::string& get_name() noexcept;
 
+        /*!
+         * \brief The ID that the mesh store keeps this shader's geometry under
+         *
+         * The renderer sets it when the shaderpack loads, so passes don't have to look it up by name every frame
+         */
+        uint32_t get_geometry_id() const noexcept;
+
+        void set_geometry_id(uint32_t id) noexcept;
+
         /*!
          * \brief Finds the uniform location of the given uniform variable
          *
-         * The first time this method is called for a given string, it calls glGetUniformLocation to get the uniform
-         * location. The result of that function is then cached so that glGetUniformLocation only needs to be called
-         * once for every uniform variable, no matter how many times you upload data to that variable
+         * Every active uniform is looked up once when the program links, so this never calls into GL. Uniforms that
+         * Nova sets on every draw are faster to get from #get_builtin_uniforms
          *
          * \param uniform_name The name of the uniform variable to get the location of
-         * \return The location of the desired uniform variable
+         * \return The location of the desired uniform variable, or -1 if the program doesn't have it
+         */
+        GLint get_uniform_location(const std::string& uniform_name) const;
+
+        /*!
+         * \brief Finds the index of the given uniform block, for glUniformBlockBinding and friends
+         *
+         * \return The index of the block, or GL_INVALID_INDEX if the program doesn't have it
+         */
+        GLuint get_uniform_block_index(const std::string& block_name) const;
+
+        /*!
+         * \brief Checks if this shader declares a shader storage block with the given name
+         *
+         * \param block_name The name of the block to look for
+         * \return True if the linked program has an active shader storage block with that name
+         */
+        bool has_shader_storage_block(const std::string& block_name) const;
+
+        const builtin_uniform_slots& get_builtin_uniforms() const noexcept;
+
+        /*!
+         * \brief The color attachments written by this shader, in the order of the fragment outputs
          */
-        GLint get_uniform_location(std::string uniform_name);
+        const std::vector<unsigned int>& get_drawbuffers() const noexcept;
+
+        /*!
+         * \brief The names of the attachments this shader samples from
+         */
+        const std::vector<std::string>& get_reads() const noexcept;
+
+        /*!
+         * \brief True if this program is a compute shader, which writes its drawbuffers with image stores
+         */
+        bool is_compute() const noexcept;
+
+        /*!
+         * \brief The local size the compute shader declares, or (0, 0, 0) if this isn't a compute shader
+         */
+        const glm::uvec3& get_work_group_size() const noexcept;
 
     private:
         std::string name;
 
+        uint32_t geometry_id = 0;
+
         std::vector<GLuint> added_shaders;
 
+        /*!
+         * \brief The source lines of each shader in added_shaders, to make sense of compile errors with
+         */
+        std::vector<shader_source> added_shader_sources;
+
+        uint64_t cache_key = 0;
+
+        /*!
+         * \brief If true, the program was compiled from source and its binary should go in the cache
+         */
+        bool save_to_cache = false;
+
+        bool finished = false;
+
+        /*!
+         * \brief The location of every active uniform that isn't in a block. Arrays are under both name and name[0]
+         */
         std::unordered_map<std::string, GLint> uniform_locations;
 
+        std::unordered_map<std::string, GLuint> uniform_block_indices;
+
+        std::unordered_map<std::string, GLuint> storage_block_indices;
+
+        builtin_uniform_slots builtin_uniforms;
+
         /*!
          * \brief The filter that the renderer should use to get the geometry for this shader
          *
@@ -130,13 +288,63 @@ namespace nova {
          */
         std::string filter;
 
-        void create_shader(const std::vector<shader_line>& shader_source, GLenum shader_type);
+        std::vector<unsigned int> drawbuffers;
+
+        std::vector<std::string> reads;
+
+        bool compute = false;
+
+        glm::uvec3 work_group_size = glm::uvec3(0);
+
+        /*!
+         * \brief Joins a shader's lines into the source that's sent to the driver, with the define lines of the
+         * shader's variant after the version line
+         *
+         * A SPIR-V shader isn't sent as text, so for one of those this gives its words and the specialization constants
+         * as a string of bytes, for the program cache's key. SPIR-V shaders can't have defines
+         *
+         * \param invariant_position If true, and the shader doesn't declare gl_Position invariant itself, a declaration
+         * is added after the shader's #extension lines. Programs that draw the same geometry, like the depth pre-pass and
+         * the terrain pass it's drawn for, then get exactly the same depths
+         *
+         * \throws wrong_shader_version if the shader isn't GLSL 450 or SPIR-V
+         */
+        static std::string get_full_source(const shader_source& source,
+                                           const std::vector<specialization_constant>& constants,
+                                           const std::vector<std::string>& define_lines,
+                                           bool invariant_position = false);
 
-        void check_for_shader_errors(GLuint shader_to_check, const std::vector<shader_line>& line_map);
+        void create_shader(const std::string& full_shader_source, const shader_source& source,
+                           const std::vector<specialization_constant>& constants, GLenum shader_type);
+
+        /*!
+         * \brief Hands the driver a shader's SPIR-V and specializes it with the shaderpack's options, which skips
+         * parsing any GLSL
+         *
+         * \throws spirv_not_supported if the driver can't take SPIR-V
+         */
+        void create_spirv_shader(const shader_source& source, const std::vector<specialization_constant>& constants,
+                                 GLenum shader_type);
+
+        /*!
+         * \brief Makes the program from the cache's binary for it
+         *
+         * \return True if the cache had a binary for the program, and the driver took it
+         */
+        bool load_from_cache(const shader_program_cache& cache);
+
+        void save_to(const shader_program_cache& cache);
+
+        void check_for_shader_errors(GLuint shader_to_check, const shader_source& line_map);
 
         void link();
 
         void check_for_linking_errors();
+
+        /*!
+         * \brief Asks the linked program for all its active uniforms and blocks, and remembers where they are
+         */
+        void reflect();
     };
 }
 
@@ -0,0 +1,156 @@
+/*!
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <algorithm>
+#include <easylogging++.h>
+#include "shader_hot_reloader.h"
+#include "../../../data_loading/loaders/loaders.h"
+#include "../../../data_loading/loaders/shader_loading.h"
+
+namespace nova {
+    /*!
+     * \brief Takes the . and .. parts out of a path and makes it use '/', so paths to the same file compare equal
+     */
+    static std::string normalize_path(std::string path) {
+        std::replace(path.begin(), path.end(), '\\', '/');
+
+        std::vector<std::string> parts;
+        size_t begin = 0;
+        while(begin <= path.size()) {
+            size_t end = path.find('/', begin);
+            if(end == std::string::npos) {
+                end = path.size();
+            }
+
+            const std::string part = path.substr(begin, end - begin);
+            if(part == ".." && !parts.empty() && parts.back() != "..") {
+                parts.pop_back();
+            } else if(!part.empty() && part != ".") {
+                parts.push_back(part);
+            }
+
+            begin = end + 1;
+        }
+
+        std::string normalized = path.compare(0, 1, "/") == 0 ? "/" : "";
+        for(size_t i = 0; i < parts.size(); i++) {
+            if(i > 0) {
+                normalized += '/';
+            }
+            normalized += parts[i];
+        }
+
+        return normalized;
+    }
+
+    /*!
+     * \brief Checks if any of the source's files is in the list of changed files
+     */
+    static bool uses_any_file(const shader_source& source, const std::vector<std::string>& changed_files) {
+        for(const auto& file : source.files) {
+            if(std::find(changed_files.begin(), changed_files.end(), normalize_path(file)) != changed_files.end()) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    shader_hot_reloader::shader_hot_reloader(std::shared_ptr<shaderpack> pack) :
+            pack(pack), watcher("shaderpacks/" + pack->get_name() + "/shaders") {
+        LOG(INFO) << "Watching shaderpack " << pack->get_name() << " for changes";
+    }
+
+    bool shader_hot_reloader::update(std::vector<std::string>& swapped_programs) {
+        auto changed_files = watcher.get_changed_files();
+        if(!changed_files.empty()) {
+            for(auto& file : changed_files) {
+                file = normalize_path(file);
+            }
+
+            // A shader's files are only known from its last successful load, so a shader whose file is brand new
+            // won't be noticed
+            for(auto& definition : pack->get_definitions()) {
+                if(uses_any_file(definition.second.vertex_source, changed_files) ||
+                   uses_any_file(definition.second.fragment_source, changed_files) ||
+                   uses_any_file(definition.second.compute_source, changed_files)) {
+                    start_compiling(definition.second);
+                }
+            }
+        }
+
+        auto& loaded_shaders = pack->get_loaded_shaders();
+        bool added_program = false;
+        for(auto program = pending_programs.begin(); program != pending_programs.end();) {
+            if(!program->second.is_ready()) {
+                ++program;
+                continue;
+            }
+
+            try {
+                program->second.finish(pack->get_program_cache());
+
+                auto loaded_program = loaded_shaders.find(program->first);
+                if(loaded_program == loaded_shaders.end()) {
+                    loaded_shaders.emplace(program->first, std::move(program->second));
+                    added_program = true;
+
+                } else {
+                    // Assign in place instead of replacing the map entry, since the frame graph holds references to it
+                    loaded_program->second = std::move(program->second);
+                }
+
+                LOG(INFO) << "Reloaded shader " << program->first;
+                swapped_programs.push_back(program->first);
+
+            } catch(std::exception& e) {
+                LOG(ERROR) << "Could not reload shader " << program->first << " because " << e.what()
+                           << ". Keeping the old one";
+
+                // Assigning an empty program deletes whatever GL objects the failed one still has
+                program->second = gl_shader_program();
+            }
+
+            program = pending_programs.erase(program);
+        }
+
+        return added_program;
+    }
+
+    bool shader_hot_reloader::is_watching(const shaderpack& pack) const {
+        return this->pack.get() == &pack;
+    }
+
+    void shader_hot_reloader::start_compiling(shader_definition& definition) {
+        LOG(DEBUG) << "Recompiling shader " << definition.name << " because one of its files changed";
+
+        // A fresh resolver, since the whole point is to read the files that changed again
+        shader_include_resolver includes;
+        shader_definition new_definition = definition;
+        try {
+            load_shader_sources(pack->get_name(), new_definition, includes);
+
+            gl_shader_program program(new_definition, pack->get_program_cache());
+            auto pending_program = pending_programs.find(definition.name);
+            if(pending_program == pending_programs.end()) {
+                pending_programs.emplace(definition.name, std::move(program));
+            } else {
+                pending_program->second = std::move(program);
+            }
+
+        } catch(std::exception& e) {
+            LOG(ERROR) << "Could not reload shader " << definition.name << " because " << e.what();
+            return;
+        }
+
+        // The other variants were compiled from the old files
+        pack->forget_variants(definition.name);
+
+        // Remember the new files, so a file that's just been included is watched too
+        definition.vertex_source = std::move(new_definition.vertex_source);
+        definition.fragment_source = std::move(new_definition.fragment_source);
+        definition.compute_source = std::move(new_definition.compute_source);
+    }
+}
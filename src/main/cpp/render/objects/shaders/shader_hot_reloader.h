@@ -0,0 +1,65 @@
+/*!
+ * \brief Recompiles the shaders in a shaderpack when their files change
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_SHADER_HOT_RELOADER_H
+#define RENDERER_SHADER_HOT_RELOADER_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "shaderpack.h"
+#include "../../../utils/file_watcher.h"
+
+namespace nova {
+    /*!
+     * \brief Watches a folder shaderpack's shaders folder, and recompiles just the programs that use a file that changed
+     *
+     * A program uses every file in its vertex and fragment sources, so editing an included file recompiles every
+     * program that includes it, and nothing else. The new program compiles in the background while the old one keeps
+     * rendering. Once it's done, it's swapped into the shaderpack's gl_shader_program, so everything that refers to
+     * that program uses the new one. A program that doesn't compile just logs its errors, and the old one stays
+     */
+    class shader_hot_reloader {
+    public:
+        explicit shader_hot_reloader(std::shared_ptr<shaderpack> pack);
+
+        /*!
+         * \brief Starts compiling the programs whose files changed, and swaps in the ones that finished compiling
+         *
+         * Call this once a frame, on the thread that owns the GL context
+         *
+         * \param swapped_programs Filled with the names of the programs that were swapped in this call
+         * \return True if one of the swapped programs wasn't in the shaderpack before, because it didn't compile
+         * when the shaderpack loaded
+         */
+        bool update(std::vector<std::string>& swapped_programs);
+
+        /*!
+         * \brief Checks if this is reloading the given shaderpack
+         */
+        bool is_watching(const shaderpack& pack) const;
+
+    private:
+        std::shared_ptr<shaderpack> pack;
+
+        file_watcher watcher;
+
+        /*!
+         * \brief The programs that are compiling, by name
+         */
+        std::unordered_map<std::string, gl_shader_program> pending_programs;
+
+        /*!
+         * \brief Reloads the program's sources from disk and starts compiling it
+         */
+        void start_compiling(shader_definition& definition);
+    };
+}
+
+#endif //RENDERER_SHADER_HOT_RELOADER_H
@@ -0,0 +1,132 @@
+/*!
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <easylogging++.h>
+#include "shader_program_cache.h"
+#include "../../../utils/utils.h"
+
+namespace nova {
+    /*!
+     * \brief Marks a file as one of ours. Bump the version whenever the file layout changes
+     */
+    static const uint32_t CACHE_FILE_MAGIC = 0x5053564e;  // "NVSP"
+    static const uint32_t CACHE_FILE_VERSION = 1;
+
+    /*!
+     * \brief Gets a GL string, or an empty string if the driver doesn't have one
+     */
+    static std::string get_gl_string(GLenum name) {
+        auto value = reinterpret_cast<const char*>(glGetString(name));
+        return value == nullptr ? "" : value;
+    }
+
+    shader_program_cache::shader_program_cache(std::string directory) : directory(std::move(directory)) {
+        driver = get_gl_string(GL_VENDOR) + "\n" + get_gl_string(GL_RENDERER) + "\n" + get_gl_string(GL_VERSION);
+
+        GLint num_binary_formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_binary_formats);
+        supported = num_binary_formats > 0;
+
+        if(!supported) {
+            LOG(INFO) << "The driver doesn't support program binaries, so shader programs won't be cached";
+        }
+    }
+
+    bool shader_program_cache::is_supported() const {
+        return supported;
+    }
+
+    uint64_t shader_program_cache::make_key(const std::string& vertex_source, const std::string& fragment_source) const {
+        // 64-bit FNV-1a
+        uint64_t hash = 14695981039346656037ull;
+        auto add_string = [&hash](const std::string& str) {
+            for(char c : str) {
+                hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+            }
+            // Separate the strings, so moving text from the end of one to the start of the next changes the key
+            hash = (hash ^ 0xFF) * 1099511628211ull;
+        };
+
+        add_string(driver);
+        add_string(vertex_source);
+        add_string(fragment_source);
+        hash = (hash ^ CACHE_FILE_VERSION) * 1099511628211ull;
+
+        return hash;
+    }
+
+    bool shader_program_cache::load(uint64_t key, GLenum& binary_format, std::vector<uint8_t>& binary) const {
+        if(!supported) {
+            return false;
+        }
+
+        std::ifstream file(get_path(key), std::ios::binary);
+        if(!file.is_open()) {
+            return false;
+        }
+
+        uint32_t magic = 0;
+        uint32_t version = 0;
+        uint64_t file_key = 0;
+        uint32_t format = 0;
+        uint64_t size = 0;
+        file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+        file.read(reinterpret_cast<char*>(&version), sizeof(version));
+        file.read(reinterpret_cast<char*>(&file_key), sizeof(file_key));
+        file.read(reinterpret_cast<char*>(&format), sizeof(format));
+        file.read(reinterpret_cast<char*>(&size), sizeof(size));
+        if(!file || magic != CACHE_FILE_MAGIC || version != CACHE_FILE_VERSION || file_key != key || size > (1ull << 30)) {
+            LOG(WARNING) << "Ignoring shader program cache file " << get_path(key) << " because it's not one I understand";
+            return false;
+        }
+
+        binary_format = format;
+        binary.resize(static_cast<size_t>(size));
+        file.read(reinterpret_cast<char*>(binary.data()), static_cast<std::streamsize>(size));
+
+        return static_cast<bool>(file);
+    }
+
+    void shader_program_cache::save(uint64_t key, GLenum binary_format, const std::vector<uint8_t>& binary) const {
+        if(!supported) {
+            return;
+        }
+
+        make_directory(directory);
+
+        // Write to a temporary file first so a crash halfway through never leaves a broken entry behind
+        const std::string path = get_path(key);
+        const std::string temp_path = path + ".tmp";
+        {
+            std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+            if(!file.is_open()) {
+                LOG(WARNING) << "Could not write the shader program cache file " << temp_path;
+                return;
+            }
+
+            const auto format = static_cast<uint32_t>(binary_format);
+            const auto size = static_cast<uint64_t>(binary.size());
+            file.write(reinterpret_cast<const char*>(&CACHE_FILE_MAGIC), sizeof(CACHE_FILE_MAGIC));
+            file.write(reinterpret_cast<const char*>(&CACHE_FILE_VERSION), sizeof(CACHE_FILE_VERSION));
+            file.write(reinterpret_cast<const char*>(&key), sizeof(key));
+            file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+            file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+            file.write(reinterpret_cast<const char*>(binary.data()), static_cast<std::streamsize>(size));
+        }
+
+        std::remove(path.c_str());
+        if(std::rename(temp_path.c_str(), path.c_str()) != 0) {
+            LOG(WARNING) << "Could not move the shader program cache file " << temp_path << " to " << path;
+        }
+    }
+
+    std::string shader_program_cache::get_path(uint64_t key) const {
+        char name[17];
+        std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+        return directory + "/" + name + ".bin";
+    }
+}
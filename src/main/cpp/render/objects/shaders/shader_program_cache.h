@@ -0,0 +1,70 @@
+/*!
+ * \brief Keeps linked shader programs on disk so they don't have to be compiled again
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_SHADER_PROGRAM_CACHE_H
+#define RENDERER_SHADER_PROGRAM_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+
+namespace nova {
+    /*!
+     * \brief Reads and writes program binaries from glGetProgramBinary in a directory, one file per program
+     *
+     * Programs are keyed by a hash of their full GLSL source, after includes, along with the GL vendor, renderer, and
+     * version strings. A binary only works with the driver that made it, so a driver update changes every key and
+     * the old files are just never read again. Even with the right key the driver can still reject a binary, so
+     * whoever loads one has to check that it linked
+     *
+     * The constructor asks GL about the driver, so this has to be made on the thread that owns the context
+     */
+    class shader_program_cache {
+    public:
+        explicit shader_program_cache(std::string directory);
+
+        /*!
+         * \brief Checks if the driver can give us program binaries at all. If it can't, nothing is read or written
+         */
+        bool is_supported() const;
+
+        /*!
+         * \brief Hashes a program's sources and the driver into a cache key
+         */
+        uint64_t make_key(const std::string& vertex_source, const std::string& fragment_source) const;
+
+        /*!
+         * \brief Reads the program binary with the given key
+         *
+         * \param key The key to read
+         * \param binary_format Set to the format of the binary, for glProgramBinary
+         * \param binary Filled with the binary
+         * \return True if the cache had an entry for the key
+         */
+        bool load(uint64_t key, GLenum& binary_format, std::vector<uint8_t>& binary) const;
+
+        /*!
+         * \brief Writes the program binary for the given key, replacing anything that was there
+         */
+        void save(uint64_t key, GLenum binary_format, const std::vector<uint8_t>& binary) const;
+
+    private:
+        std::string directory;
+
+        /*!
+         * \brief The vendor, renderer, and version strings of the driver
+         */
+        std::string driver;
+
+        bool supported = false;
+
+        std::string get_path(uint64_t key) const;
+    };
+}
+
+#endif //RENDERER_SHADER_PROGRAM_CACHE_H
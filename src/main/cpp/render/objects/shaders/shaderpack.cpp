@@ -8,16 +8,23 @@
 #include <algorithm>
 #include <utility>
 #include "shaderpack.h"
+#include "../../../data_loading/loaders/shader_loading.h"
 
 #include <easylogging++.h>
 
 namespace nova {
-    shaderpack::shaderpack(std::string name, nlohmann::json shaders_json, std::vector<shader_definition> &shaders) {
+    shaderpack::shaderpack(std::string name, nlohmann::json shaders_json, std::vector<shader_definition> &shaders,
+                           const std::string& program_cache_directory, const nlohmann::json& define_values) {
         this->name = std::move(name);
+        program_cache = std::make_shared<shader_program_cache>(program_cache_directory);
+        defines = get_shader_defines(shaders_json);
+
         for(auto& shader : shaders) {
             LOG(TRACE) << "Adding shader " << shader.name;
+            shader.define_lines = get_define_lines(shader, defines, define_values);
+            definitions.emplace(shader.name, shader);
             try {
-                loaded_shaders.emplace(shader.name, gl_shader_program(shader));
+                loaded_shaders.emplace(shader.name, gl_shader_program(shader, program_cache.get()));
             } catch(std::exception& e) {
                 LOG(ERROR) << "Could not load shader " << shader.name << " because " << e.what();
             }
@@ -26,6 +33,31 @@ namespace nova {
         LOG(TRACE) << "Shaderpack created";
     }
 
+    bool shaderpack::is_ready() const {
+        for(auto& shader : loaded_shaders) {
+            if(!shader.second.is_ready()) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void shaderpack::finish_loading() {
+        for(auto shader = loaded_shaders.begin(); shader != loaded_shaders.end();) {
+            try {
+                shader->second.finish(program_cache.get());
+                ++shader;
+
+            } catch(std::exception& e) {
+                LOG(ERROR) << "Could not load shader " << shader->first << " because " << e.what();
+                shader = loaded_shaders.erase(shader);
+            }
+        }
+
+        LOG(TRACE) << "Shaderpack finished loading";
+    }
+
     gl_shader_program &shaderpack::operator[](std::string key) {
         return get_shader(std::move(key));
     }
@@ -34,8 +66,145 @@ namespace nova {
         return loaded_shaders;
     }
 
+    std::unordered_map<std::string, shader_definition> &shaderpack::get_definitions() {
+        return definitions;
+    }
+
+    const shader_program_cache* shaderpack::get_program_cache() const {
+        return program_cache.get();
+    }
+
+    const std::vector<shader_define>& shaderpack::get_defines() const {
+        return defines;
+    }
+
+    void shaderpack::set_define_values(const nlohmann::json& define_values) {
+        if(defines.empty()) {
+            return;
+        }
+
+        for(auto& definition : definitions) {
+            const std::string& shader_name = definition.first;
+            std::vector<std::string> define_lines = get_define_lines(definition.second, defines, define_values);
+
+            auto pending = pending_variants.find(shader_name);
+            if(define_lines == definition.second.define_lines) {
+                if(pending != pending_variants.end()) {
+                    // Switched back before the other variant was swapped in, so it's not needed after all
+                    LOG(DEBUG) << "Shader " << shader_name << " doesn't need the variant it was waiting for anymore";
+                    pending->second.program = gl_shader_program();
+                    pending_variants.erase(pending);
+                }
+                continue;
+            }
+
+            if(pending != pending_variants.end() && pending->second.define_lines == define_lines) {
+                continue;
+            }
+
+            pending_variant variant;
+            auto& unused = unused_variants[shader_name];
+            auto compiled = unused.find(get_variant_key(define_lines));
+            if(compiled != unused.end()) {
+                variant.program = std::move(compiled->second);
+                unused.erase(compiled);
+
+            } else {
+                shader_definition variant_definition = definition.second;
+                variant_definition.define_lines = define_lines;
+                try {
+                    variant.program = gl_shader_program(variant_definition, program_cache.get());
+                } catch(std::exception& e) {
+                    LOG(ERROR) << "Could not make a variant of shader " << shader_name << " because " << e.what();
+                    continue;
+                }
+                LOG(DEBUG) << "Compiling a new variant of shader " << shader_name;
+            }
+            variant.define_lines = std::move(define_lines);
+
+            if(pending == pending_variants.end()) {
+                pending_variants.emplace(shader_name, std::move(variant));
+            } else {
+                // Assigning over the old program deletes whatever GL objects it has
+                pending->second.program = std::move(variant.program);
+                pending->second.define_lines = std::move(variant.define_lines);
+            }
+        }
+    }
+
+    bool shaderpack::update_variants(std::vector<std::string>& swapped_programs) {
+        bool added_program = false;
+        for(auto variant = pending_variants.begin(); variant != pending_variants.end();) {
+            if(!variant->second.program.is_ready()) {
+                ++variant;
+                continue;
+            }
+
+            const std::string& shader_name = variant->first;
+            try {
+                variant->second.program.finish(program_cache.get());
+
+                auto& definition = definitions.at(shader_name);
+                auto loaded_program = loaded_shaders.find(shader_name);
+                if(loaded_program == loaded_shaders.end()) {
+                    loaded_shaders.emplace(shader_name, std::move(variant->second.program));
+                    added_program = true;
+
+                } else {
+                    // Keep the old variant so switching back to it is free. Assign in place instead of replacing the
+                    // map entry, since the frame graph holds references to it
+                    auto& unused = unused_variants[shader_name];
+                    unused[get_variant_key(definition.define_lines)] = std::move(loaded_program->second);
+                    loaded_program->second = std::move(variant->second.program);
+                }
+                definition.define_lines = std::move(variant->second.define_lines);
+
+                LOG(INFO) << "Swapped in a new variant of shader " << shader_name;
+                swapped_programs.push_back(shader_name);
+
+            } catch(std::exception& e) {
+                LOG(ERROR) << "Could not compile a variant of shader " << shader_name << " because " << e.what()
+                           << ". Keeping the old one";
+                variant->second.program = gl_shader_program();
+            }
+
+            variant = pending_variants.erase(variant);
+        }
+
+        return added_program;
+    }
+
+    void shaderpack::forget_variants(const std::string& shader_name) {
+        auto pending = pending_variants.find(shader_name);
+        if(pending != pending_variants.end()) {
+            pending->second.program = gl_shader_program();
+            pending_variants.erase(pending);
+        }
+
+        auto unused = unused_variants.find(shader_name);
+        if(unused != unused_variants.end()) {
+            for(auto& variant : unused->second) {
+                variant.second = gl_shader_program();
+            }
+            unused_variants.erase(unused);
+        }
+    }
+
+    std::string shaderpack::get_variant_key(const std::vector<std::string>& define_lines) {
+        std::string key;
+        for(const auto& line : define_lines) {
+            key += line;
+            key += '\n';
+        }
+
+        return key;
+    }
+
     void shaderpack::operator=(const shaderpack &other) {
         loaded_shaders = other.loaded_shaders;
+        definitions = other.definitions;
+        program_cache = other.program_cache;
+        defines = other.defines;
     }
 
     std::string &shaderpack::get_name() {
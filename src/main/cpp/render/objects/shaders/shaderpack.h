@@ -14,6 +14,7 @@
 #include <functional>
 #include <unordered_map>
 #include <initializer_list>
+#include <memory>
 #include <mutex>
 #include <optional.hpp>
 
@@ -35,10 +36,30 @@ namespace nova {
          * reason to keep that running in a separate thread, so why not put
          * it here?
          *
+         * The shaders start compiling here, but they aren't done until #finish_loading is called. Programs that have
+         * been compiled before are loaded from the program cache in program_cache_directory instead
+         *
+         * Each shader is compiled as the variant for the given define values. #set_define_values picks other variants
+         * later
+         *
          * \param shaderpack_name The name of the shaderpcack to load
+         * \param program_cache_directory The directory to keep this shaderpack's program binaries in
+         * \param define_values The value of each of the shaderpack's defines, like the shaderpackDefines setting
          *
          */
-        shaderpack(std::string name, nlohmann::json shaders_json, std::vector<shader_definition> &shaders);
+        shaderpack(std::string name, nlohmann::json shaders_json, std::vector<shader_definition> &shaders,
+                   const std::string& program_cache_directory,
+                   const nlohmann::json& define_values = nlohmann::json::object());
+
+        /*!
+         * \brief Checks if every shader is done compiling, so #finish_loading won't have to wait
+         */
+        bool is_ready() const;
+
+        /*!
+         * \brief Waits for every shader to finish compiling, and throws out the ones that didn't compile or link
+         */
+        void finish_loading();
 
         gl_shader_program &operator[](std::string key);
 
@@ -46,6 +67,47 @@ namespace nova {
 
 		std::unordered_map<std::string, gl_shader_program> &get_loaded_shaders();
 
+        /*!
+         * \brief The definition of every shader in the shaderpack, with the sources it was compiled from
+         */
+        std::unordered_map<std::string, shader_definition>& get_definitions();
+
+        const shader_program_cache* get_program_cache() const;
+
+        /*!
+         * \brief The preprocessor defines the shaderpack declares in its shaders.json
+         */
+        const std::vector<shader_define>& get_defines() const;
+
+        /*!
+         * \brief Picks the variant of each shader that goes with the given define values
+         *
+         * Only shaders that use a define that changed get a new variant. A variant that's been used before is kept
+         * around, so switching back to it is free. Variants that haven't been used yet start compiling here, or
+         * come out of the program cache, and the old variant keeps rendering until #update_variants swaps them in
+         *
+         * \param define_values The value of each define, by name, like the shaderpackDefines setting
+         */
+        void set_define_values(const nlohmann::json& define_values);
+
+        /*!
+         * \brief Swaps in the variants that finished compiling since the last call
+         *
+         * The variant is moved into the shader's gl_shader_program, so anything that refers to the program uses the
+         * variant from now on. A variant that doesn't compile logs its errors, and the old one stays. Call this once a
+         * frame, on the thread that owns the GL context
+         *
+         * \param swapped_programs Filled with the names of the programs that were swapped in this call
+         * \return True if one of the swapped programs wasn't in the shaderpack before, because it didn't compile
+         * when the shaderpack loaded
+         */
+        bool update_variants(std::vector<std::string>& swapped_programs);
+
+        /*!
+         * \brief Throws away every variant of the shader besides the one in use, for when its sources change
+         */
+        void forget_variants(const std::string& shader_name);
+
         void operator=(const shaderpack& other);
 
         std::string& get_name();
@@ -53,8 +115,37 @@ namespace nova {
     private:
         std::unordered_map<std::string, gl_shader_program> loaded_shaders;
 
+        std::unordered_map<std::string, shader_definition> definitions;
+
         std::string name;
 
+        std::shared_ptr<shader_program_cache> program_cache;
+
+        std::vector<shader_define> defines;
+
+        /*!
+         * \brief A variant of a shader that's waiting to be swapped in
+         */
+        struct pending_variant {
+            std::vector<std::string> define_lines;
+            gl_shader_program program;
+        };
+
+        /*!
+         * \brief The variant that each shader should switch to, by shader name
+         */
+        std::unordered_map<std::string, pending_variant> pending_variants;
+
+        /*!
+         * \brief The variants that have been used but aren't right now, by shader name and then by variant key
+         */
+        std::unordered_map<std::string, std::unordered_map<std::string, gl_shader_program>> unused_variants;
+
+        /*!
+         * \brief Joins a variant's define lines into one string, to look the variant up with
+         */
+        static std::string get_variant_key(const std::vector<std::string>& define_lines);
+
         /*!
          * \brief The indices of the framebuffer attachments that any of the non-shadow shaders write to
          */
@@ -0,0 +1,217 @@
+/*!
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+#include "shadow_cascades.h"
+
+namespace nova {
+    /*!
+     * \brief How much the splits between cascades lean towards being logarithmic instead of evenly spaced
+     *
+     * Logarithmic splits give each cascade about the same texels per pixel, but they make the first cascade tiny, so
+     * it's blended with evenly spaced splits
+     */
+    static const float SPLIT_BLEND = 0.75f;
+
+    /*!
+     * \brief How far from the camera the first split starts counting from. Splitting from the real near plane would
+     * give the first cascade a few centimeters
+     */
+    static const float MIN_SPLIT_START = 1.0f;
+
+    /*!
+     * \brief How far, as a fraction of its radius, a cached cascade's slice can drift before the cascade is moved
+     */
+    static const float CACHED_MARGIN_FRACTION = 0.25f;
+
+    /*!
+     * \brief Pulls the six planes out of a view-projection matrix, in the same order as camera#recalculate_frustum
+     */
+    static frustum make_frustum(const glm::mat4& view_projection) {
+        auto row = [&](int r) {
+            return glm::vec4(view_projection[0][r], view_projection[1][r], view_projection[2][r], view_projection[3][r]);
+        };
+
+        const glm::vec4 planes[6] = {
+            row(3) - row(0), row(3) + row(0),
+            row(3) + row(1), row(3) - row(1),
+            row(3) - row(2), row(3) + row(2)
+        };
+
+        frustum result = {};
+        for(int p = 0; p < 6; p++) {
+            const float length = glm::length(glm::vec3(planes[p]));
+            for(int i = 0; i < 4; i++) {
+                result.planes[p][i] = planes[p][i] / length;
+            }
+        }
+        return result;
+    }
+
+    /*!
+     * \brief Checks if any part of the box is on the inside of every plane of the frustum
+     */
+    static bool box_in_frustum(const frustum& view_frustum, const aabb& bounds) {
+        for(const auto& plane : view_frustum.planes) {
+            const float distance = plane[0] * bounds.center.x + plane[1] * bounds.center.y + plane[2] * bounds.center.z + plane[3];
+            const float reach = std::abs(plane[0]) * bounds.extents.x + std::abs(plane[1]) * bounds.extents.y +
+                                std::abs(plane[2]) * bounds.extents.z;
+            if(distance + reach < 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    shadow_cascades::shadow_cascades() {
+        update_light_view();
+    }
+
+    void shadow_cascades::set_resolution(unsigned int new_resolution) {
+        if(new_resolution != resolution) {
+            resolution = new_resolution;
+            has_been_fit = false;
+            invalidate();
+        }
+    }
+
+    void shadow_cascades::set_shadow_distance(float distance) {
+        shadow_distance = distance;
+    }
+
+    void shadow_cascades::set_light_direction(const glm::vec3& direction) {
+        const glm::vec3 new_direction = glm::normalize(direction);
+        if(glm::dot(new_direction, light_direction) >= std::cos(glm::radians(SHADOW_LIGHT_ANGLE_THRESHOLD))) {
+            return;
+        }
+
+        light_direction = new_direction;
+        update_light_view();
+        has_been_fit = false;
+        invalidate();
+    }
+
+    const glm::vec3& shadow_cascades::get_light_direction() const {
+        return light_direction;
+    }
+
+    const glm::mat4& shadow_cascades::get_light_view() const {
+        return light_view;
+    }
+
+    void shadow_cascades::update_light_view() {
+        // The sun moves in the x-y plane, so +z is never parallel to it. Other lights might be though
+        const glm::vec3 up = std::abs(light_direction.z) < 0.99f ? glm::vec3(0, 0, 1) : glm::vec3(1, 0, 0);
+        light_view = glm::lookAt(glm::vec3(0), -light_direction, up);
+    }
+
+    void shadow_cascades::update(const glm::mat4& view, float fov, float aspect_ratio, float near_plane) {
+        const float tile_size = static_cast<float>(std::max(resolution / 2, 1u));
+        const glm::mat4 inverse_view = glm::inverse(view);
+        const float tan_half_fov = std::tan(glm::radians(fov) * 0.5f);
+
+        const float split_start = std::max(near_plane, MIN_SPLIT_START);
+        const float split_end = std::max(shadow_distance, split_start * 2);
+
+        float slice_near = near_plane;
+        for(uint32_t i = 0; i < NUM_SHADOW_CASCADES; i++) {
+            auto& cascade = cascades[i];
+
+            const float fraction = static_cast<float>(i + 1) / NUM_SHADOW_CASCADES;
+            const float log_split = split_start * std::pow(split_end / split_start, fraction);
+            const float even_split = split_start + (split_end - split_start) * fraction;
+            const float slice_far = SPLIT_BLEND * log_split + (1 - SPLIT_BLEND) * even_split;
+
+            // The bounding sphere of the slice. Its radius only depends on the slice's shape, so it stays the same as
+            // the camera turns
+            glm::vec3 corners[8];
+            glm::vec3 center(0);
+            for(int c = 0; c < 8; c++) {
+                const float depth = c < 4 ? slice_near : slice_far;
+                const float half_height = depth * tan_half_fov;
+                const float half_width = half_height * aspect_ratio;
+                const glm::vec4 view_corner((c & 1) ? half_width : -half_width, (c & 2) ? half_height : -half_height, -depth, 1);
+                corners[c] = glm::vec3(inverse_view * view_corner);
+                center += corners[c] / 8.0f;
+            }
+
+            float radius = 0;
+            for(const auto& corner : corners) {
+                radius = std::max(radius, glm::length(corner - center));
+            }
+
+            // The first cascade follows the camera texel by texel. The others are made big enough to cover their slice
+            // while its center is anywhere within a margin of where they were fit, and only move when it leaves
+            float half_size = radius;
+            float margin = 0;
+            if(i > 0) {
+                margin = radius * CACHED_MARGIN_FRACTION;
+                half_size = radius + margin;
+            }
+            const float texel_size = 2 * half_size / tile_size;
+
+            const glm::vec3 light_space_center(light_view * glm::vec4(center, 1));
+            const glm::vec3 snapped_center = glm::floor(light_space_center / texel_size) * texel_size;
+
+            const glm::vec3 drift = light_space_center - fit_centers[i];
+            const bool left_margin = glm::length(glm::vec2(drift.x, drift.y)) > margin || std::abs(drift.z) > margin;
+            const bool moved = !has_been_fit || slice_far != cascade.split_distance ||
+                               (i == 0 ? snapped_center != fit_centers[i] : left_margin);
+            if(moved) {
+                // Light space looks down -z, so the side facing the light has the biggest z
+                cascade.projection = glm::ortho(snapped_center.x - half_size, snapped_center.x + half_size,
+                                                snapped_center.y - half_size, snapped_center.y + half_size,
+                                                -(snapped_center.z + half_size + SHADOW_CASTER_DISTANCE),
+                                                -(snapped_center.z - half_size));
+                cascade.view_projection = cascade.projection * light_view;
+                cascade.light_frustum = make_frustum(cascade.view_projection);
+
+                const glm::vec2 tile_offset((i % 2) * 0.5f, (i / 2) * 0.5f);
+                glm::mat4 to_texture = glm::translate(glm::mat4(1), glm::vec3(tile_offset, 0));
+                to_texture = glm::scale(to_texture, glm::vec3(0.5f, 0.5f, 1));
+                to_texture = glm::translate(to_texture, glm::vec3(0.5f));
+                to_texture = glm::scale(to_texture, glm::vec3(0.5f));
+                cascade.texture_matrix = to_texture * cascade.view_projection;
+
+                const int tile = static_cast<int>(tile_size);
+                cascade.viewport = glm::ivec4((i % 2) * tile, (i / 2) * tile, tile, tile);
+                cascade.split_distance = slice_far;
+                cascade.needs_render = true;
+                fit_centers[i] = snapped_center;
+            }
+
+            slice_near = slice_far;
+        }
+
+        has_been_fit = true;
+
+        // Nothing is cached for the first cascade, since it's small enough that it usually moves every frame anyway
+        cascades[0].needs_render = true;
+    }
+
+    void shadow_cascades::mark_changed(const aabb& bounds) {
+        for(auto& cascade : cascades) {
+            if(!cascade.needs_render && box_in_frustum(cascade.light_frustum, bounds)) {
+                cascade.needs_render = true;
+            }
+        }
+    }
+
+    void shadow_cascades::invalidate() {
+        for(auto& cascade : cascades) {
+            cascade.needs_render = true;
+        }
+    }
+
+    void shadow_cascades::mark_rendered(uint32_t cascade_idx) {
+        cascades[cascade_idx].needs_render = false;
+    }
+
+    const shadow_cascade& shadow_cascades::get_cascade(uint32_t cascade_idx) const {
+        return cascades[cascade_idx];
+    }
+}
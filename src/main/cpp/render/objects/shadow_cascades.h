@@ -0,0 +1,171 @@
+/*!
+ * \brief Fits cascaded shadow maps to the player's view, and keeps track of which cascades have to be redrawn
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_SHADOW_CASCADES_H
+#define RENDERER_SHADOW_CASCADES_H
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "../../data_loading/physics/aabb.h"
+#include "../../data_loading/physics/frustum.h"
+
+namespace nova {
+    /*!
+     * \brief How many cascades the shadow map is split into. They're laid out in a 2x2 grid in shadowtex0
+     */
+    const uint32_t NUM_SHADOW_CASCADES = 4;
+
+    /*!
+     * \brief How many degrees the light has to turn before the shadow map is redrawn
+     *
+     * The sun creeps across the sky a tiny bit every tick. Following it exactly would mean redrawing every cascade
+     * every tick
+     */
+    const float SHADOW_LIGHT_ANGLE_THRESHOLD = 0.5f;
+
+    /*!
+     * \brief How far past its slice each cascade reaches towards the light, so things above the slice still cast
+     * shadows into it
+     */
+    const float SHADOW_CASTER_DISTANCE = 256;
+
+    /*!
+     * \brief One slice of the player's view, and the light's view of it
+     */
+    struct shadow_cascade {
+        /*!
+         * \brief Takes light space positions, from shadow_cascades#get_light_view, to the cascade's clip space
+         */
+        glm::mat4 projection;
+
+        /*!
+         * \brief Takes world space positions to the cascade's clip space
+         */
+        glm::mat4 view_projection;
+
+        /*!
+         * \brief Takes world space positions to the cascade's spot in the shadow map, with depth in z. This is what
+         * shaders sample the shadow map with
+         */
+        glm::mat4 texture_matrix;
+
+        /*!
+         * \brief The planes of view_projection, for culling the shadow casters
+         */
+        frustum light_frustum;
+
+        /*!
+         * \brief The part of the shadow map this cascade is drawn into, as (x, y, width, height)
+         */
+        glm::ivec4 viewport;
+
+        /*!
+         * \brief How far from the camera this cascade reaches
+         */
+        float split_distance = 0;
+
+        /*!
+         * \brief If true, what's in the shadow map for this cascade is out of date and it has to be drawn this frame
+         */
+        bool needs_render = true;
+    };
+
+    /*!
+     * \brief Splits the player's view into NUM_SHADOW_CASCADES slices, and gives each one an orthographic projection
+     * from the light that covers it
+     *
+     * Each cascade covers a bounding sphere of its slice, which doesn't change size when the camera turns, and its
+     * center is snapped to whole texels in light space so the edges of shadows don't crawl when the camera moves
+     *
+     * The first cascade follows the camera and is drawn every frame. The rest have a border big enough that their
+     * slice is still covered after it drifts a ways from where they were fit, so they only move when the camera has
+     * gone a good distance. What they drew is kept, and they're only drawn again when they move, when the light moves
+     * far enough, or when a chunk they can see changes
+     */
+    class shadow_cascades {
+    public:
+        /*!
+         * \brief Starts with the sun straight overhead
+         */
+        shadow_cascades();
+
+        /*!
+         * \brief Sets the size of the whole shadow map. Each cascade gets a quarter of it
+         */
+        void set_resolution(unsigned int resolution);
+
+        /*!
+         * \brief Sets how far from the camera the last cascade reaches
+         */
+        void set_shadow_distance(float distance);
+
+        /*!
+         * \brief Sets the direction towards the light
+         *
+         * Small changes are ignored, see SHADOW_LIGHT_ANGLE_THRESHOLD
+         */
+        void set_light_direction(const glm::vec3& direction);
+
+        /*!
+         * \brief The direction towards the light that the cascades were fit with
+         */
+        const glm::vec3& get_light_direction() const;
+
+        /*!
+         * \brief The rotation from world space to light space that every cascade shares
+         */
+        const glm::mat4& get_light_view() const;
+
+        /*!
+         * \brief Fits each cascade to its slice of the camera's view, and marks the ones that moved as needing to be
+         * drawn
+         *
+         * \param view The camera's view matrix
+         * \param fov The camera's vertical field of view, in degrees
+         * \param aspect_ratio The camera's width over its height
+         * \param near_plane The camera's near plane
+         */
+        void update(const glm::mat4& view, float fov, float aspect_ratio, float near_plane);
+
+        /*!
+         * \brief Tells the cascades that something inside the box has changed, so the cascades that can see it need
+         * to be drawn again
+         */
+        void mark_changed(const aabb& bounds);
+
+        /*!
+         * \brief Makes every cascade get drawn next frame, like when the shadow map was remade
+         */
+        void invalidate();
+
+        /*!
+         * \brief Tells the cascade that it's been drawn
+         */
+        void mark_rendered(uint32_t cascade_idx);
+
+        const shadow_cascade& get_cascade(uint32_t cascade_idx) const;
+
+    private:
+        shadow_cascade cascades[NUM_SHADOW_CASCADES];
+
+        /*!
+         * \brief The light space center that each cascade was last fit around
+         */
+        glm::vec3 fit_centers[NUM_SHADOW_CASCADES];
+        bool has_been_fit = false;
+
+        unsigned int resolution = 1024;
+        float shadow_distance = 128;
+
+        glm::vec3 light_direction = glm::vec3(0, 1, 0);
+        glm::mat4 light_view;
+
+        void update_light_view();
+    };
+}
+
+#endif //RENDERER_SHADOW_CASCADES_H
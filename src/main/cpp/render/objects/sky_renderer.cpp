@@ -0,0 +1,138 @@
+/*!
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "sky_renderer.h"
+#include "frame_stats.h"
+#include "gl_state.h"
+#include "../windowing/glfw_gl_window.h"
+
+namespace nova {
+    /*!
+     * \brief How many blocks the clouds drift along x each tick, like Minecraft's clouds
+     */
+    static const double CLOUD_BLOCKS_PER_TICK = 0.03;
+
+    static const float CLOUD_HEIGHT = 128;
+
+    static const double TICKS_PER_DAY = 24000;
+
+    /*!
+     * \brief How much of the sky clouds cover on a clear day, and how much more they cover in a storm
+     */
+    static const float CLEAR_CLOUD_COVERAGE = 0.45f;
+    static const float STORM_CLOUD_COVERAGE = 0.35f;
+
+    static const float WEATHER_RADIUS = 24;
+
+    sky_renderer::~sky_renderer() {
+        if(vao != 0 && glfwGetCurrentContext() != nullptr) {
+            gl_state::delete_vertex_arrays(1, &vao);
+        }
+    }
+
+    void sky_renderer::set_state(double world_time, float rain_strength, bool is_snowing) {
+        this->world_time = std::max(world_time, 0.0);
+        this->rain_strength = std::min(std::max(rain_strength, 0.0f), 1.0f);
+        this->is_snowing = is_snowing;
+    }
+
+    void sky_renderer::set_cloud_distance(float distance) {
+        cloud_distance = std::max(distance, 0.0f);
+    }
+
+    void sky_renderer::set_max_weather_particles(uint32_t count) {
+        max_weather_particles = count;
+    }
+
+    float sky_renderer::get_rain_strength() const {
+        return rain_strength;
+    }
+
+    sky_uniforms sky_renderer::get_uniforms() const {
+        // The offset is wrapped in doubles, so the floats the shaders get stay small however long the world has run
+        const double pattern_size = static_cast<double>(CLOUD_PATTERN_CELLS) * CLOUD_CELL_SIZE;
+
+        sky_uniforms uniforms = {};
+        uniforms.cloudOffset = glm::vec2(std::fmod(world_time * CLOUD_BLOCKS_PER_TICK, pattern_size), 0);
+        uniforms.cloudHeight = CLOUD_HEIGHT;
+        uniforms.cloudCellSize = CLOUD_CELL_SIZE;
+        uniforms.skyTime = static_cast<float>(std::fmod(world_time, TICKS_PER_DAY));
+        uniforms.weatherStrength = rain_strength;
+        uniforms.snowStrength = is_snowing ? 1.0f : 0.0f;
+        uniforms.weatherRadius = WEATHER_RADIUS;
+        uniforms.cloudCoverage = CLEAR_CLOUD_COVERAGE + STORM_CLOUD_COVERAGE * rain_strength;
+        uniforms.cloudGridSize = get_cloud_grid_size();
+        uniforms.cloudPatternCells = CLOUD_PATTERN_CELLS;
+        uniforms.weatherParticleCount = static_cast<GLint>(get_num_weather_particles());
+        return uniforms;
+    }
+
+    int sky_renderer::get_cloud_grid_size() const {
+        if(cloud_distance <= 0) {
+            return 0;
+        }
+
+        // An odd number of cells, so the camera's cell is in the middle
+        const auto cells_out = static_cast<int>(std::ceil(cloud_distance / CLOUD_CELL_SIZE));
+        const int grid_size = cells_out * 2 + 1;
+        return grid_size < MAX_CLOUD_GRID_SIZE ? grid_size : MAX_CLOUD_GRID_SIZE;
+    }
+
+    uint32_t sky_renderer::get_num_weather_particles() const {
+        return static_cast<uint32_t>(max_weather_particles * rain_strength);
+    }
+
+    void sky_renderer::draw(sky_layer layer) {
+        if(vao == 0) {
+            glCreateVertexArrays(1, &vao);
+        }
+        gl_state::bind_vertex_array(vao);
+
+        switch(layer) {
+            case sky_layer::sky:
+                // The sky is behind everything, so it doesn't need depth at all
+                gl_state::set_enabled(GL_DEPTH_TEST, false);
+                gl_state::depth_mask(false);
+                glDrawArrays(GL_TRIANGLES, 0, 3);
+                frame_stats::count_draw(1);
+                gl_state::depth_mask(true);
+                gl_state::set_enabled(GL_DEPTH_TEST, true);
+                break;
+
+            case sky_layer::clouds: {
+                const int grid_size = get_cloud_grid_size();
+                if(grid_size == 0) {
+                    break;
+                }
+
+                // Clouds are seen from above and below, and they blend, so they neither cull nor write depth
+                gl_state::set_enabled(GL_CULL_FACE, false);
+                gl_state::depth_mask(false);
+                glDrawArrays(GL_TRIANGLES, 0, grid_size * grid_size * 6);
+                frame_stats::count_draw(static_cast<uint64_t>(grid_size) * grid_size * 2);
+                gl_state::depth_mask(true);
+                gl_state::set_enabled(GL_CULL_FACE, true);
+                break;
+            }
+
+            case sky_layer::weather: {
+                const uint32_t num_particles = get_num_weather_particles();
+                if(num_particles == 0) {
+                    break;
+                }
+
+                gl_state::set_enabled(GL_CULL_FACE, false);
+                gl_state::depth_mask(false);
+                glDrawArraysInstanced(GL_TRIANGLES, 0, 6, static_cast<GLsizei>(num_particles));
+                frame_stats::count_draw(static_cast<uint64_t>(num_particles) * 2);
+                gl_state::depth_mask(true);
+                gl_state::set_enabled(GL_CULL_FACE, true);
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,116 @@
+/*!
+ * \brief Draws the sky, the clouds, and rain and snow without any vertex data
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#ifndef RENDERER_SKY_RENDERER_H
+#define RENDERER_SKY_RENDERER_H
+
+#include <cstdint>
+#include <glad/glad.h>
+#include "uniform_buffers/uniform_buffer_definitions.h"
+
+namespace nova {
+    /*!
+     * \brief The parts of the sky that are drawn separately, each with its own shader
+     */
+    enum class sky_layer {
+        sky,        //!< One triangle over the whole screen, drawn with gbuffers_skybasic before anything else
+        clouds,     //!< A square of cloud cells around the camera, drawn with gbuffers_clouds
+        weather,    //!< Rain or snow around the camera, drawn with gbuffers_weather
+    };
+
+    /*!
+     * \brief Keeps the time and weather, and draws the sky layers from them
+     *
+     * Minecraft remakes its cloud and rain meshes every frame. Sending those over JNI every frame would cost far more
+     * than drawing them, so instead Minecraft only sends the time and the weather with set_sky_state. The shaders
+     * build everything else from gl_VertexID, gl_InstanceID, and the sky_parameters block that #get_uniforms fills in:
+     *
+     * - The sky is a triangle that covers the screen. Its fragment shader works out the view direction of each pixel
+     * - Clouds are a square grid of cloudGridSize cells, six vertices each, centered on the camera. The vertex shader
+     *   hashes each cell's spot in the cloud pattern and collapses the cells that have no cloud
+     * - Each raindrop or snowflake is an instance of one quad. The vertex shader scatters them around the camera from
+     *   a hash of gl_InstanceID, and moves them down as skyTime goes by
+     *
+     * Like everything else that touches GL, drawing has to happen on the render thread. The VAO isn't made until the
+     * first draw, so this can be made before there's a context
+     */
+    class sky_renderer {
+    public:
+        /*!
+         * \brief How many blocks wide each cell of the cloud pattern is, like Minecraft's clouds
+         */
+        static const int CLOUD_CELL_SIZE = 12;
+
+        /*!
+         * \brief How many cells wide the cloud pattern is before it repeats. The shaders wrap cells with a mask, so it
+         * has to be a power of two
+         */
+        static const int CLOUD_PATTERN_CELLS = 256;
+
+        /*!
+         * \brief The most cloud cells across the grid can be, which keeps a huge cloud distance from asking for
+         * millions of vertices
+         */
+        static const int MAX_CLOUD_GRID_SIZE = 255;
+
+        sky_renderer() = default;
+
+        sky_renderer(const sky_renderer&) = delete;
+        sky_renderer& operator=(const sky_renderer&) = delete;
+
+        ~sky_renderer();
+
+        /*!
+         * \param world_time The world's time in ticks, with the partial tick
+         * \param rain_strength How hard it's raining, from World#getRainStrength
+         * \param is_snowing True if it's cold enough where the camera is for the rain to be snow
+         */
+        void set_state(double world_time, float rain_strength, bool is_snowing);
+
+        /*!
+         * \brief How far from the camera, in blocks, clouds are drawn. 0 turns clouds off
+         */
+        void set_cloud_distance(float distance);
+
+        /*!
+         * \brief How many raindrops or snowflakes are drawn while it's raining as hard as it can
+         */
+        void set_max_weather_particles(uint32_t count);
+
+        float get_rain_strength() const;
+
+        /*!
+         * \brief Fills in the sky_parameters block for the current time and weather
+         */
+        sky_uniforms get_uniforms() const;
+
+        /*!
+         * \brief Draws one of the layers with the shader that's bound. The layer's shader has to use the
+         * sky_parameters block
+         */
+        void draw(sky_layer layer);
+
+    private:
+        double world_time = 0;
+        float rain_strength = 0;
+        bool is_snowing = false;
+
+        float cloud_distance = 192;
+        uint32_t max_weather_particles = 8192;
+
+        /*!
+         * \brief An empty VAO, since none of the layers have vertex attributes
+         */
+        GLuint vao = 0;
+
+        int get_cloud_grid_size() const;
+
+        uint32_t get_num_weather_particles() const;
+    };
+}
+
+#endif //RENDERER_SKY_RENDERER_H
@@ -0,0 +1,405 @@
+/*!
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstddef>
+#include <cstdio>
+#include <easylogging++.h>
+#include "stats_overlay.h"
+#include "gl_state.h"
+#include "../windowing/glfw_gl_window.h"
+
+namespace nova {
+    static const char* VERTEX_SOURCE = R"(#version 450
+layout(location = 0) in vec4 rect;
+layout(location = 1) in uint bits;
+layout(location = 2) in vec4 color;
+
+uniform vec2 screen_size;
+
+out vec2 glyph_pixel;
+flat out uint glyph_bits;
+out vec4 glyph_color;
+
+void main() {
+    // A triangle strip that goes counterclockwise once y is flipped
+    vec2 corner = vec2(gl_VertexID >> 1, gl_VertexID & 1);
+    vec2 position = rect.xy + corner * rect.zw;
+    gl_Position = vec4(position / screen_size * vec2(2, -2) + vec2(-1, 1), 0, 1);
+
+    glyph_pixel = corner * vec2(3, 5);
+    glyph_bits = bits;
+    glyph_color = color;
+}
+)";
+
+    static const char* FRAGMENT_SOURCE = R"(#version 450
+in vec2 glyph_pixel;
+flat in uint glyph_bits;
+in vec4 glyph_color;
+
+layout(location = 0) out vec4 color;
+
+void main() {
+    ivec2 pixel = min(ivec2(glyph_pixel), ivec2(2, 4));
+    if((glyph_bits & (1u << (pixel.y * 3 + pixel.x))) == 0u) {
+        discard;
+    }
+    color = glyph_color;
+}
+)";
+
+    /*!
+     * \brief How many screen pixels each pixel of the font covers
+     */
+    static const float FONT_SCALE = 2;
+    static const float GLYPH_WIDTH = 3 * FONT_SCALE;
+    static const float GLYPH_HEIGHT = 5 * FONT_SCALE;
+    static const float GLYPH_ADVANCE = 4 * FONT_SCALE;
+    static const float LINE_HEIGHT = 7 * FONT_SCALE;
+    static const float MARGIN = 4 * FONT_SCALE;
+
+    static const uint16_t SOLID_GLYPH = 0x7FFF;
+
+    static const uint32_t TEXT_COLOR = 0xFFFFFFFF;
+    static const uint32_t PASS_COLOR = 0xFF80E0FF;
+    static const uint32_t BACKGROUND_COLOR = 0xB0000000;
+
+    struct font_glyph {
+        char character;
+
+        /*!
+         * \brief The glyph's five rows, top to bottom, with # for lit pixels
+         */
+        const char* rows;
+    };
+
+    static const font_glyph FONT[] = {
+            {'0', "###" "#.#" "#.#" "#.#" "###"},
+            {'1', ".#." "##." ".#." ".#." "###"},
+            {'2', "###" "..#" "###" "#.." "###"},
+            {'3', "###" "..#" "###" "..#" "###"},
+            {'4', "#.#" "#.#" "###" "..#" "..#"},
+            {'5', "###" "#.." "###" "..#" "###"},
+            {'6', "###" "#.." "###" "#.#" "###"},
+            {'7', "###" "..#" "..#" "..#" "..#"},
+            {'8', "###" "#.#" "###" "#.#" "###"},
+            {'9', "###" "#.#" "###" "..#" "###"},
+            {'A', ".#." "#.#" "###" "#.#" "#.#"},
+            {'B', "##." "#.#" "##." "#.#" "##."},
+            {'C', ".##" "#.." "#.." "#.." ".##"},
+            {'D', "##." "#.#" "#.#" "#.#" "##."},
+            {'E', "###" "#.." "##." "#.." "###"},
+            {'F', "###" "#.." "##." "#.." "#.."},
+            {'G', ".##" "#.." "#.#" "#.#" ".##"},
+            {'H', "#.#" "#.#" "###" "#.#" "#.#"},
+            {'I', "###" ".#." ".#." ".#." "###"},
+            {'J', "..#" "..#" "..#" "#.#" ".#."},
+            {'K', "#.#" "#.#" "##." "#.#" "#.#"},
+            {'L', "#.." "#.." "#.." "#.." "###"},
+            {'M', "#.#" "###" "###" "#.#" "#.#"},
+            {'N', "##." "#.#" "#.#" "#.#" "#.#"},
+            {'O', ".#." "#.#" "#.#" "#.#" ".#."},
+            {'P', "##." "#.#" "##." "#.." "#.."},
+            {'Q', ".#." "#.#" "#.#" "##." ".##"},
+            {'R', "##." "#.#" "##." "#.#" "#.#"},
+            {'S', ".##" "#.." ".#." "..#" "##."},
+            {'T', "###" ".#." ".#." ".#." ".#."},
+            {'U', "#.#" "#.#" "#.#" "#.#" "###"},
+            {'V', "#.#" "#.#" "#.#" "#.#" ".#."},
+            {'W', "#.#" "#.#" "###" "###" "#.#"},
+            {'X', "#.#" "#.#" ".#." "#.#" "#.#"},
+            {'Y', "#.#" "#.#" ".#." ".#." ".#."},
+            {'Z', "###" "..#" ".#." "#.." "###"},
+            {':', "..." ".#." "..." ".#." "..."},
+            {'.', "..." "..." "..." "..." ".#."},
+            {',', "..." "..." "..." ".#." "#.."},
+            {'/', "..#" "..#" ".#." "#.." "#.."},
+            {'-', "..." "..." "###" "..." "..."},
+            {'_', "..." "..." "..." "..." "###"},
+            {'(', ".#." "#.." "#.." "#.." ".#."},
+            {')', ".#." "..#" "..#" "..#" ".#."},
+    };
+
+    static std::array<uint16_t, 128> make_glyph_table() {
+        std::array<uint16_t, 128> table = {};
+        for(const auto& glyph : FONT) {
+            uint16_t bits = 0;
+            for(int pixel = 0; pixel < 15; pixel++) {
+                if(glyph.rows[pixel] == '#') {
+                    bits |= 1 << pixel;
+                }
+            }
+            table[static_cast<uint8_t>(glyph.character)] = bits;
+        }
+        return table;
+    }
+
+    uint16_t get_glyph_bits(char character) {
+        static const std::array<uint16_t, 128> glyph_table = make_glyph_table();
+
+        const auto upper = static_cast<uint8_t>(std::toupper(static_cast<unsigned char>(character)));
+        return upper < glyph_table.size() ? glyph_table[upper] : 0;
+    }
+
+    /*!
+     * \brief Formats the value divided by the unit with one decimal place, then the suffix
+     */
+    static void format_scaled(double value, double unit, const char* suffix, char (&buffer)[32]) {
+        std::snprintf(buffer, sizeof(buffer), "%.1f%s", value / unit, suffix);
+    }
+
+    /*!
+     * \brief Formats into a buffer on the stack, so building the overlay's lines doesn't allocate
+     */
+    static void format_count(uint64_t count, char (&buffer)[32]) {
+        const auto value = static_cast<double>(count);
+        if(count < 1000) {
+            std::snprintf(buffer, sizeof(buffer), "%llu", static_cast<unsigned long long>(count));
+        } else if(count < 1000000) {
+            format_scaled(value, 1e3, "K", buffer);
+        } else if(count < 1000000000) {
+            format_scaled(value, 1e6, "M", buffer);
+        } else {
+            format_scaled(value, 1e9, "G", buffer);
+        }
+    }
+
+    static void format_bytes(uint64_t num_bytes, char (&buffer)[32]) {
+        const auto value = static_cast<double>(num_bytes);
+        if(num_bytes < 1024) {
+            std::snprintf(buffer, sizeof(buffer), "%llu B", static_cast<unsigned long long>(num_bytes));
+        } else if(num_bytes < 1024 * 1024) {
+            format_scaled(value, 1024, " KB", buffer);
+        } else {
+            format_scaled(value, 1024 * 1024, " MB", buffer);
+        }
+    }
+
+    std::string format_count(uint64_t count) {
+        char buffer[32];
+        format_count(count, buffer);
+        return buffer;
+    }
+
+    std::string format_bytes(uint64_t num_bytes) {
+        char buffer[32];
+        format_bytes(num_bytes, buffer);
+        return buffer;
+    }
+
+    static void append_count(frame_string& line, uint64_t count) {
+        char buffer[32];
+        format_count(count, buffer);
+        line += buffer;
+    }
+
+    static void append_bytes(frame_string& line, uint64_t num_bytes) {
+        char buffer[32];
+        format_bytes(num_bytes, buffer);
+        line += buffer;
+    }
+
+    frame_vector<frame_string> get_overlay_lines(const frame_statistics& stats, frame_arena& arena) {
+        frame_vector<frame_string> lines{frame_allocator<frame_string>(arena)};
+        lines.reserve(4 + stats.passes.size());
+        auto new_line = [&](const char* text) -> frame_string& {
+            lines.emplace_back(text, frame_allocator<char>(arena));
+            return lines.back();
+        };
+
+        // The frame number is the one count that isn't shortened
+        char frame_number[32];
+        std::snprintf(frame_number, sizeof(frame_number), "%llu", static_cast<unsigned long long>(stats.frame));
+        new_line("Frame ") += frame_number;
+
+        auto& draws_line = new_line("Draws ");
+        append_count(draws_line, stats.draw_calls);
+        draws_line += " (";
+        append_count(draws_line, stats.draw_commands);
+        draws_line += " meshes)  Tris ";
+        append_count(draws_line, stats.triangles);
+
+        auto& state_line = new_line("State changes ");
+        append_count(state_line, stats.state_changes);
+        state_line += " (";
+        append_count(state_line, stats.state_changes_saved);
+        state_line += " saved)  Texture binds ";
+        append_count(state_line, stats.texture_binds);
+
+        auto& upload_line = new_line("Uploaded ");
+        append_bytes(upload_line, stats.bytes_uploaded);
+        upload_line += "  Perf warnings ";
+        append_count(upload_line, stats.performance_warnings);
+
+        for(const auto& pass : stats.passes) {
+            auto& line = new_line(pass.name.c_str());
+            line += ": ";
+            append_count(line, pass.draw_calls);
+            line += " draws ";
+            append_count(line, pass.triangles);
+            line += " tris";
+            if(stats.has_pipeline_statistics) {
+                line += "  Prims ";
+                append_count(line, pass.primitives_submitted);
+                line += " clipped ";
+                append_count(line, pass.clipping_output_primitives);
+                line += "  VS ";
+                append_count(line, pass.vertex_shader_invocations);
+                line += " FS ";
+                append_count(line, pass.fragment_shader_invocations);
+            }
+        }
+
+        return lines;
+    }
+
+    /*!
+     * \brief Compiles one stage of the overlay's shader
+     *
+     * \return The shader, or 0 if it didn't compile
+     */
+    static GLuint compile_shader(GLenum stage, const char* source) {
+        GLuint shader = glCreateShader(stage);
+        glShaderSource(shader, 1, &source, nullptr);
+        glCompileShader(shader);
+
+        GLint compiled = GL_FALSE;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+        if(compiled == GL_FALSE) {
+            GLint log_length = 0;
+            glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &log_length);
+            std::string info_log(static_cast<size_t>(std::max(log_length, 1)), '\0');
+            glGetShaderInfoLog(shader, log_length, nullptr, &info_log[0]);
+
+            LOG(ERROR) << "Could not compile the stats overlay's shader, so it won't be drawn: " << info_log;
+            glDeleteShader(shader);
+            return 0;
+        }
+
+        return shader;
+    }
+
+    stats_overlay::~stats_overlay() {
+        if(glfwGetCurrentContext() == nullptr) {
+            return;
+        }
+
+        if(program != 0) {
+            gl_state::delete_program(program);
+        }
+        if(buffer != 0) {
+            gl_state::delete_buffers(1, &buffer);
+        }
+        if(vao != 0) {
+            gl_state::delete_vertex_arrays(1, &vao);
+        }
+    }
+
+    void stats_overlay::create_gl_objects() {
+        GLuint vertex_shader = compile_shader(GL_VERTEX_SHADER, VERTEX_SOURCE);
+        GLuint fragment_shader = compile_shader(GL_FRAGMENT_SHADER, FRAGMENT_SOURCE);
+        if(vertex_shader == 0 || fragment_shader == 0) {
+            glDeleteShader(vertex_shader);
+            glDeleteShader(fragment_shader);
+            is_broken = true;
+            return;
+        }
+
+        program = glCreateProgram();
+        glAttachShader(program, vertex_shader);
+        glAttachShader(program, fragment_shader);
+        glLinkProgram(program);
+        glDeleteShader(vertex_shader);
+        glDeleteShader(fragment_shader);
+
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if(linked == GL_FALSE) {
+            LOG(ERROR) << "Could not link the stats overlay's shader, so it won't be drawn";
+            gl_state::delete_program(program);
+            program = 0;
+            is_broken = true;
+            return;
+        }
+        screen_size_location = glGetUniformLocation(program, "screen_size");
+
+        glCreateBuffers(1, &buffer);
+        glCreateVertexArrays(1, &vao);
+        glVertexArrayVertexBuffer(vao, 0, buffer, 0, sizeof(overlay_glyph));
+        glVertexArrayBindingDivisor(vao, 0, 1);
+
+        glEnableVertexArrayAttrib(vao, 0);
+        glVertexArrayAttribFormat(vao, 0, 4, GL_FLOAT, GL_FALSE, offsetof(overlay_glyph, rect));
+        glVertexArrayAttribBinding(vao, 0, 0);
+
+        glEnableVertexArrayAttrib(vao, 1);
+        glVertexArrayAttribIFormat(vao, 1, 1, GL_UNSIGNED_INT, offsetof(overlay_glyph, bits));
+        glVertexArrayAttribBinding(vao, 1, 0);
+
+        glEnableVertexArrayAttrib(vao, 2);
+        glVertexArrayAttribFormat(vao, 2, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(overlay_glyph, color));
+        glVertexArrayAttribBinding(vao, 2, 0);
+    }
+
+    float stats_overlay::add_text(float x, float y, const frame_string& text, uint32_t color) {
+        float pen_x = x;
+        for(char character : text) {
+            const uint16_t bits = get_glyph_bits(character);
+            if(bits != 0) {
+                glyphs.push_back({{pen_x, y, GLYPH_WIDTH, GLYPH_HEIGHT}, bits, color});
+            }
+            pen_x += GLYPH_ADVANCE;
+        }
+        return pen_x - x;
+    }
+
+    void stats_overlay::draw(const frame_statistics& stats, const glm::ivec2& screen_size, frame_arena& arena) {
+        if(is_broken) {
+            return;
+        }
+        if(program == 0) {
+            create_gl_objects();
+            if(is_broken) {
+                return;
+            }
+        }
+
+        const auto lines = get_overlay_lines(stats, arena);
+
+        // The background goes first so the text is drawn over it
+        glyphs.clear();
+        glyphs.push_back({{0, 0, 0, 0}, SOLID_GLYPH, BACKGROUND_COLOR});
+
+        float width = 0;
+        float y = MARGIN;
+        for(size_t i = 0; i < lines.size(); i++) {
+            // The first few lines are the totals, and the rest are passes
+            const bool is_pass = i >= lines.size() - stats.passes.size();
+            width = std::max(width, add_text(MARGIN, y, lines[i], is_pass ? PASS_COLOR : TEXT_COLOR));
+            y += LINE_HEIGHT;
+        }
+
+        auto& background = glyphs.front();
+        background.rect[2] = width + MARGIN * 2;
+        background.rect[3] = y + MARGIN - (LINE_HEIGHT - GLYPH_HEIGHT);
+
+        // Orphaning the buffer every frame means we never wait on last frame's draw. It's only a few kilobytes
+        glNamedBufferData(buffer, glyphs.size() * sizeof(overlay_glyph), glyphs.data(), GL_STREAM_DRAW);
+
+        gl_state::use_program(program);
+        glUniform2f(screen_size_location, static_cast<float>(screen_size.x), static_cast<float>(screen_size.y));
+        gl_state::bind_vertex_array(vao);
+        gl_state::set_enabled(GL_DEPTH_TEST, false);
+        gl_state::set_enabled(GL_BLEND, true);
+        gl_state::blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(glyphs.size()));
+
+        gl_state::set_enabled(GL_DEPTH_TEST, true);
+    }
+}
@@ -0,0 +1,113 @@
+/*!
+ * \brief Draws the frame's statistics in the corner of the screen
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_STATS_OVERLAY_H
+#define RENDERER_STATS_OVERLAY_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "frame_stats.h"
+#include "../../utils/frame_arena.h"
+
+namespace nova {
+    /*!
+     * \brief Formats a count with a K, M, or G suffix so it fits in a few characters, like 12.3K
+     */
+    std::string format_count(uint64_t count);
+
+    /*!
+     * \brief Formats a number of bytes as B, KB, or MB
+     */
+    std::string format_bytes(uint64_t num_bytes);
+
+    /*!
+     * \brief The lines of text the overlay shows for the given frame: the frame's totals, then one line per pass
+     *
+     * The lines are allocated from the arena, so they have to be used before it's reset
+     */
+    frame_vector<frame_string> get_overlay_lines(const frame_statistics& stats, frame_arena& arena);
+
+    /*!
+     * \brief The overlay font's picture of the given character
+     *
+     * Each glyph is three pixels wide and five tall, with bit (row * 3 + column) set for each lit pixel, starting from
+     * the top left. Lowercase letters look like uppercase ones, and characters the font doesn't have are blank
+     */
+    uint16_t get_glyph_bits(char character);
+
+    /*!
+     * \brief Draws text on top of everything else, with its own tiny font and a shader that's built in
+     *
+     * Each character is one instance of a quad, and the fragment shader picks the pixels out of the glyph's bits. The
+     * dark box behind the text is a character with every bit set. That means the overlay doesn't depend on
+     * Minecraft's font or on any texture atlas, so it still works when the shaderpack or resource pack is broken.
+     *
+     * Like everything else that touches GL, this has to be used from the render thread. The GL objects aren't made
+     * until the first draw
+     */
+    class stats_overlay {
+    public:
+        stats_overlay() = default;
+
+        stats_overlay(const stats_overlay&) = delete;
+        stats_overlay& operator=(const stats_overlay&) = delete;
+
+        ~stats_overlay();
+
+        /*!
+         * \brief Draws the statistics in the top left corner of the backbuffer
+         *
+         * \param stats The statistics to show
+         * \param screen_size The size of the backbuffer, in pixels
+         * \param arena Where the overlay's text is put together
+         */
+        void draw(const frame_statistics& stats, const glm::ivec2& screen_size, frame_arena& arena);
+
+    private:
+        /*!
+         * \brief One character, or the background box
+         */
+        struct overlay_glyph {
+            /*!
+             * \brief The top left corner and size, in pixels
+             */
+            float rect[4];
+            uint32_t bits;
+
+            /*!
+             * \brief RGBA, one byte each
+             */
+            uint32_t color;
+        };
+
+        GLuint program = 0;
+        GLint screen_size_location = -1;
+        GLuint vao = 0;
+        GLuint buffer = 0;
+
+        /*!
+         * \brief True if the shader didn't build, so there's no point in trying again
+         */
+        bool is_broken = false;
+
+        std::vector<overlay_glyph> glyphs;
+
+        void create_gl_objects();
+
+        /*!
+         * \brief Adds a glyph for each character of the text
+         *
+         * \return The width of the text, in pixels
+         */
+        float add_text(float x, float y, const frame_string& text, uint32_t color);
+    };
+}
+
+#endif //RENDERER_STATS_OVERLAY_H
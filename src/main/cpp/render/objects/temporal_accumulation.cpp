@@ -0,0 +1,383 @@
+/*!
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include <algorithm>
+#include <string>
+#include <easylogging++.h>
+#include <GLFW/glfw3.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include "temporal_accumulation.h"
+#include "gl_state.h"
+#include "gpu_memory.h"
+#include "frame_stats.h"
+#include "../frame_graph.h"
+
+namespace nova {
+    static const char* FULLSCREEN_VERTEX_SOURCE = R"(#version 450
+out vec2 uv;
+
+void main() {
+    // One triangle that covers the whole screen
+    uv = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(uv * 2 - 1, 0, 1);
+}
+)";
+
+    // depthtex0 is on texture unit 8, like it is for the shaderpack's passes
+    static const char* VELOCITY_FRAGMENT_SOURCE = R"(#version 450
+in vec2 uv;
+
+layout(binding = 8) uniform sampler2D depthtex0;
+
+layout(location = 0) uniform mat4 reprojection;
+
+layout(location = 0) out vec2 velocity;
+
+void main() {
+    float depth = texelFetch(depthtex0, ivec2(gl_FragCoord.xy), 0).r;
+    vec4 previous = reprojection * vec4(vec3(uv, depth) * 2 - 1, 1);
+    if(previous.w <= 0) {
+        // It was behind the camera last frame, so send it off the screen
+        velocity = vec2(2);
+        return;
+    }
+
+    velocity = uv - (previous.xy / previous.w * 0.5 + 0.5);
+}
+)";
+
+    static const char* RESOLVE_FRAGMENT_SOURCE = R"(#version 450
+in vec2 uv;
+
+layout(binding = 0) uniform sampler2D colortex0;
+layout(binding = 14) uniform sampler2D velocitytex;
+layout(binding = 16) uniform sampler2D history;
+
+layout(location = 0) uniform ivec2 drawn_size;
+layout(location = 1) uniform vec2 history_uv_scale;
+layout(location = 2) uniform float history_weight;
+
+layout(location = 0) out vec4 color;
+
+void main() {
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec3 current = texelFetch(colortex0, pixel, 0).rgb;
+
+    // Whatever was here last frame is only trusted as far as it looks like the pixels around this one now, so
+    // things that moved or were uncovered don't leave ghosts behind
+    vec3 min_color = current;
+    vec3 max_color = current;
+    for(int y = -1; y <= 1; y++) {
+        for(int x = -1; x <= 1; x++) {
+            vec3 neighbor = texelFetch(colortex0, clamp(pixel + ivec2(x, y), ivec2(0), drawn_size - 1), 0).rgb;
+            min_color = min(min_color, neighbor);
+            max_color = max(max_color, neighbor);
+        }
+    }
+
+    vec2 previous_uv = uv - texelFetch(velocitytex, pixel, 0).xy;
+    float weight = history_weight;
+    if(any(lessThan(previous_uv, vec2(0))) || any(greaterThan(previous_uv, vec2(1)))) {
+        weight = 0;
+    }
+
+    vec2 history_texel = 1.0 / vec2(textureSize(history, 0));
+    vec2 history_uv = clamp(previous_uv * history_uv_scale, history_texel * 0.5, history_uv_scale - history_texel * 0.5);
+    vec3 previous = clamp(texture(history, history_uv).rgb, min_color, max_color);
+
+    color = vec4(mix(current, previous, weight), 1);
+}
+)";
+
+    /*!
+     * \brief How much of each pixel comes from the frames before it. Higher is smoother but slower to catch up
+     */
+    static const float HISTORY_WEIGHT = 0.9f;
+
+    static float halton(uint32_t index, uint32_t base) {
+        float result = 0;
+        float fraction = 1;
+        while(index > 0) {
+            fraction /= base;
+            result += fraction * (index % base);
+            index /= base;
+        }
+        return result;
+    }
+
+    /*!
+     * \brief Compiles one stage of one of the temporal shaders
+     *
+     * \return The shader, or 0 if it didn't compile
+     */
+    static GLuint compile_shader(GLenum stage, const char* source) {
+        GLuint shader = glCreateShader(stage);
+        glShaderSource(shader, 1, &source, nullptr);
+        glCompileShader(shader);
+
+        GLint compiled = GL_FALSE;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+        if(compiled == GL_FALSE) {
+            GLint log_length = 0;
+            glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &log_length);
+            std::string info_log(static_cast<size_t>(std::max(log_length, 1)), '\0');
+            glGetShaderInfoLog(shader, log_length, nullptr, &info_log[0]);
+
+            LOG(ERROR) << "Could not compile a temporal accumulation shader: " << info_log;
+            glDeleteShader(shader);
+            return 0;
+        }
+
+        return shader;
+    }
+
+    /*!
+     * \brief Links the fullscreen vertex shader with the given fragment shader
+     *
+     * \return The program, or 0 if it couldn't be made
+     */
+    static GLuint create_program(const char* fragment_source) {
+        GLuint vertex_shader = compile_shader(GL_VERTEX_SHADER, FULLSCREEN_VERTEX_SOURCE);
+        GLuint fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_source);
+        if(vertex_shader == 0 || fragment_shader == 0) {
+            glDeleteShader(vertex_shader);
+            glDeleteShader(fragment_shader);
+            return 0;
+        }
+
+        GLuint program = glCreateProgram();
+        glAttachShader(program, vertex_shader);
+        glAttachShader(program, fragment_shader);
+        glLinkProgram(program);
+        glDeleteShader(vertex_shader);
+        glDeleteShader(fragment_shader);
+
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if(linked == GL_FALSE) {
+            LOG(ERROR) << "Could not link a temporal accumulation shader";
+            gl_state::delete_program(program);
+            return 0;
+        }
+
+        return program;
+    }
+
+    temporal_accumulation::~temporal_accumulation() {
+        if(glfwGetCurrentContext() == nullptr) {
+            return;
+        }
+
+        destroy_history();
+        if(output_framebuffer != 0) {
+            glDeleteFramebuffers(1, &output_framebuffer);
+        }
+        if(velocity_program != 0) {
+            gl_state::delete_program(velocity_program);
+        }
+        if(resolve_program != 0) {
+            gl_state::delete_program(resolve_program);
+        }
+        if(vao != 0) {
+            gl_state::delete_vertex_arrays(1, &vao);
+        }
+    }
+
+    void temporal_accumulation::set_enabled(bool enabled) {
+        if(enabled != this->enabled) {
+            has_history = false;
+        }
+        this->enabled = enabled;
+    }
+
+    bool temporal_accumulation::is_enabled() const {
+        return enabled;
+    }
+
+    void temporal_accumulation::begin_frame(const glm::mat4& view, const glm::mat4& projection,
+                                            const glm::vec3& camera_position, const glm::uvec2& drawn_size) {
+        if(has_previous_frame) {
+            previous_view = this->view;
+            previous_projection = this->projection;
+            previous_jittered_projection = jittered_projection;
+            previous_position = position;
+            frame_counter = (frame_counter + 1) % FRAME_COUNTER_PERIOD;
+        }
+
+        this->view = view;
+        this->projection = projection;
+        position = camera_position;
+
+        jitter = enabled ? get_jitter_offset(frame_counter) : glm::vec2(0);
+        jittered_projection = enabled ? jitter_projection(projection, jitter, drawn_size) : projection;
+
+        if(!has_previous_frame) {
+            // There's no last frame yet, so pretend it looked just like this one
+            previous_view = view;
+            previous_projection = projection;
+            previous_jittered_projection = jittered_projection;
+            previous_position = camera_position;
+            has_previous_frame = true;
+        }
+
+        reprojection = get_reprojection(previous_view, previous_projection, previous_position, view, projection, position);
+    }
+
+    const glm::mat4& temporal_accumulation::get_projection() const {
+        return jittered_projection;
+    }
+
+    const glm::mat4& temporal_accumulation::get_previous_view() const {
+        return previous_view;
+    }
+
+    const glm::mat4& temporal_accumulation::get_previous_projection() const {
+        return previous_jittered_projection;
+    }
+
+    const glm::vec3& temporal_accumulation::get_previous_position() const {
+        return previous_position;
+    }
+
+    glm::vec2 temporal_accumulation::get_jitter() const {
+        return jitter;
+    }
+
+    uint32_t temporal_accumulation::get_frame_counter() const {
+        return frame_counter;
+    }
+
+    void temporal_accumulation::write_velocity() {
+        if(velocity_program == 0 && !programs_broken) {
+            create_programs();
+        }
+        if(programs_broken) {
+            // Nothing moved, as far as anyone reading velocitytex can tell
+            const GLfloat no_velocity[4] = {0, 0, 0, 0};
+            glClearBufferfv(GL_COLOR, 0, no_velocity);
+            return;
+        }
+
+        gl_state::use_program(velocity_program);
+        glProgramUniformMatrix4fv(velocity_program, 0, 1, GL_FALSE, &reprojection[0][0]);
+
+        gl_state::bind_vertex_array(vao);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        frame_stats::count_draw(1);
+    }
+
+    void temporal_accumulation::resolve(GLuint color_texture, const glm::uvec2& texture_size, float scale) {
+        if(!enabled || programs_broken || color_texture == 0) {
+            return;
+        }
+        if(resolve_program == 0) {
+            create_programs();
+            if(programs_broken) {
+                return;
+            }
+        }
+        if(history_size != texture_size) {
+            create_history(texture_size);
+        }
+
+        const glm::uvec2 drawn_size = get_scaled_size(texture_size, scale);
+        const size_t previous_history = 1 - current_history;
+
+        // The frame graph already set the viewport to colortex0's drawn size, and the history textures are the same size
+        glBindFramebuffer(GL_FRAMEBUFFER, history_framebuffers[current_history]);
+
+        gl_state::use_program(resolve_program);
+        glProgramUniform2i(resolve_program, 0, static_cast<GLint>(drawn_size.x), static_cast<GLint>(drawn_size.y));
+        glProgramUniform2f(resolve_program, 1, history_uv_scale.x, history_uv_scale.y);
+        glProgramUniform1f(resolve_program, 2, has_history ? HISTORY_WEIGHT : 0.0f);
+        gl_state::bind_texture_unit(HISTORY_TEXTURE_UNIT, history_textures[previous_history]);
+
+        gl_state::bind_vertex_array(vao);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        frame_stats::count_draw(1);
+
+        // The final pass reads colortex0, so the result goes back in there
+        glNamedFramebufferTexture(output_framebuffer, GL_COLOR_ATTACHMENT0, color_texture, 0);
+        glBlitNamedFramebuffer(history_framebuffers[current_history], output_framebuffer,
+                               0, 0, drawn_size.x, drawn_size.y,
+                               0, 0, drawn_size.x, drawn_size.y,
+                               GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+        history_uv_scale = glm::vec2(drawn_size) / glm::vec2(texture_size);
+        has_history = true;
+        current_history = previous_history;
+    }
+
+    void temporal_accumulation::invalidate() {
+        has_history = false;
+    }
+
+    glm::vec2 temporal_accumulation::get_jitter_offset(uint32_t frame_index) {
+        // The sequence starts at 1, since every base's first number is 0
+        const uint32_t index = frame_index % JITTER_SEQUENCE_LENGTH + 1;
+        return glm::vec2(halton(index, 2), halton(index, 3)) - 0.5f;
+    }
+
+    glm::mat4 temporal_accumulation::jitter_projection(const glm::mat4& projection, const glm::vec2& offset, const glm::uvec2& size) {
+        // Moving clip space by offset * w moves the whole picture by offset in normalized device coordinates
+        const glm::vec2 ndc_offset = offset * 2.0f / glm::vec2(glm::max(size, glm::uvec2(1)));
+        return glm::translate(glm::mat4(1), glm::vec3(ndc_offset, 0)) * projection;
+    }
+
+    glm::mat4 temporal_accumulation::get_reprojection(const glm::mat4& previous_view, const glm::mat4& previous_projection,
+                                                      const glm::vec3& previous_position, const glm::mat4& view,
+                                                      const glm::mat4& projection, const glm::vec3& position) {
+        // The view matrices are a rotation times a move to the camera's position, so the rotation is their top left
+        const glm::mat4 rotation = glm::mat4(glm::mat3(view));
+        const glm::mat4 previous_rotation = glm::mat4(glm::mat3(previous_view));
+        const glm::mat4 camera_movement = glm::translate(glm::mat4(1), position - previous_position);
+
+        return previous_projection * previous_rotation * camera_movement * glm::transpose(rotation) * glm::inverse(projection);
+    }
+
+    void temporal_accumulation::create_programs() {
+        velocity_program = create_program(VELOCITY_FRAGMENT_SOURCE);
+        resolve_program = create_program(RESOLVE_FRAGMENT_SOURCE);
+        if(velocity_program == 0 || resolve_program == 0) {
+            LOG(ERROR) << "Temporal accumulation is off, since its shaders couldn't be made";
+            programs_broken = true;
+            return;
+        }
+
+        glCreateVertexArrays(1, &vao);
+        glCreateFramebuffers(1, &output_framebuffer);
+    }
+
+    void temporal_accumulation::create_history(const glm::uvec2& size) {
+        destroy_history();
+
+        glCreateTextures(GL_TEXTURE_2D, 2, history_textures);
+        glCreateFramebuffers(2, history_framebuffers);
+        for(size_t i = 0; i < 2; i++) {
+            glTextureStorage2D(history_textures[i], 1, GL_RGBA16F, size.x, size.y);
+            glTextureParameteri(history_textures[i], GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTextureParameteri(history_textures[i], GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTextureParameteri(history_textures[i], GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTextureParameteri(history_textures[i], GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            gpu_memory::track_texture(history_textures[i], gpu_memory_category::framebuffers,
+                                      gpu_memory::get_texture_size(GL_RGBA16F, size.x, size.y));
+
+            glNamedFramebufferTexture(history_framebuffers[i], GL_COLOR_ATTACHMENT0, history_textures[i], 0);
+        }
+
+        history_size = size;
+        has_history = false;
+    }
+
+    void temporal_accumulation::destroy_history() {
+        if(history_textures[0] != 0) {
+            gl_state::delete_textures(2, history_textures);
+            glDeleteFramebuffers(2, history_framebuffers);
+            history_textures[0] = history_textures[1] = 0;
+            history_framebuffers[0] = history_framebuffers[1] = 0;
+        }
+        history_size = glm::uvec2(0);
+    }
+}
@@ -0,0 +1,204 @@
+/*!
+ * \brief Jitters the projection and blends each frame with the ones before it, using how far each pixel moved
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#ifndef RENDERER_TEMPORAL_ACCUMULATION_H
+#define RENDERER_TEMPORAL_ACCUMULATION_H
+
+#include <cstdint>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+namespace nova {
+    /*!
+     * \brief Works out where every pixel was last frame, and uses that to build up the picture over several frames
+     *
+     * Each frame, #begin_frame keeps the last frame's camera and works out this frame's. The velocity pass runs after
+     * the gbuffer passes and writes velocitytex, which holds how far each pixel moved since the last frame, in
+     * fractions of the screen. A pixel at uv was at uv - velocity last frame. Only the camera moves things, since
+     * everything but entities sits still and entities don't move far in a frame. Shaderpacks can read velocitytex at
+     * texture unit VELOCITY_TEXTURE_UNIT to reproject their own results, for example to do their SSAO on a quarter of
+     * the pixels each frame, using frameCounter to pick which quarter.
+     *
+     * When temporal antialiasing is on, the projection is moved by a different fraction of a pixel each frame, so the
+     * gbuffers see a slightly different part of each pixel every frame. After the composite passes, #resolve blends
+     * colortex0 with what it was last frame at that pixel, clamped to the colors around the pixel this frame so
+     * things that weren't there last frame don't leave ghosts behind. The result goes back into colortex0 for the
+     * final pass, and is kept to blend with the next frame.
+     *
+     * Everything here but the static functions has to be called from the render thread
+     */
+    class temporal_accumulation {
+    public:
+        /*!
+         * \brief The texture unit velocitytex is bound to for passes that read it
+         */
+        static const GLuint VELOCITY_TEXTURE_UNIT = 14;
+
+        /*!
+         * \brief The texture unit the last frame's result is bound to while it's blended with this frame
+         */
+        static const GLuint HISTORY_TEXTURE_UNIT = 16;
+
+        /*!
+         * \brief frameCounter goes back to 0 after this many frames. Every number up to 16 divides it, so
+         * frameCounter % n never skips when it wraps
+         */
+        static const uint32_t FRAME_COUNTER_PERIOD = 720720;
+
+        /*!
+         * \brief How many different jitter offsets are used before they repeat
+         */
+        static const uint32_t JITTER_SEQUENCE_LENGTH = 8;
+
+        temporal_accumulation() = default;
+
+        temporal_accumulation(const temporal_accumulation&) = delete;
+        temporal_accumulation& operator=(const temporal_accumulation&) = delete;
+
+        ~temporal_accumulation();
+
+        /*!
+         * \brief Turns the jitter and the blending on or off. The velocity pass doesn't need either of them
+         */
+        void set_enabled(bool enabled);
+
+        bool is_enabled() const;
+
+        /*!
+         * \brief Moves on to the next frame, keeping this one's camera as the previous camera
+         *
+         * \param view The camera's view matrix
+         * \param projection The camera's projection matrix, without any jitter
+         * \param camera_position Where the camera is
+         * \param drawn_size How many pixels the gbuffers are drawn at this frame, after dynamic resolution
+         */
+        void begin_frame(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& camera_position,
+                         const glm::uvec2& drawn_size);
+
+        /*!
+         * \brief The projection to draw the gbuffers with this frame. It's jittered if temporal antialiasing is on
+         */
+        const glm::mat4& get_projection() const;
+
+        /*!
+         * \brief The camera's view matrix last frame, or this frame's if there wasn't a last frame
+         */
+        const glm::mat4& get_previous_view() const;
+
+        /*!
+         * \brief The projection the gbuffers were drawn with last frame, jitter and all
+         */
+        const glm::mat4& get_previous_projection() const;
+
+        const glm::vec3& get_previous_position() const;
+
+        /*!
+         * \brief How far this frame's projection is moved, in pixels. 0 if temporal antialiasing is off
+         */
+        glm::vec2 get_jitter() const;
+
+        /*!
+         * \brief Counts up by one each frame, and wraps at FRAME_COUNTER_PERIOD
+         */
+        uint32_t get_frame_counter() const;
+
+        /*!
+         * \brief Draws velocitytex from depthtex0. The frame graph binds depthtex0 and velocitytex's framebuffer
+         */
+        void write_velocity();
+
+        /*!
+         * \brief Blends colortex0 with the last frame, and writes the result back to it
+         *
+         * The frame graph binds colortex0 to texture unit 0 and velocitytex to VELOCITY_TEXTURE_UNIT
+         *
+         * \param color_texture colortex0's texture
+         * \param texture_size The size of colortex0's texture
+         * \param scale How much of colortex0 was drawn this frame
+         */
+        void resolve(GLuint color_texture, const glm::uvec2& texture_size, float scale);
+
+        /*!
+         * \brief Throws the last frame's result away, so the next frame doesn't blend with it
+         */
+        void invalidate();
+
+        /*!
+         * \brief The jitter for a frame, in pixels, between -0.5 and 0.5
+         *
+         * The offsets come from the Halton sequence in bases 2 and 3, which spreads them evenly over the pixel no
+         * matter how many of them are looked at
+         */
+        static glm::vec2 get_jitter_offset(uint32_t frame_index);
+
+        /*!
+         * \brief Moves a projection by the given number of pixels
+         */
+        static glm::mat4 jitter_projection(const glm::mat4& projection, const glm::vec2& offset, const glm::uvec2& size);
+
+        /*!
+         * \brief Makes the matrix that takes a point from this frame's clip space to the last frame's
+         *
+         * The camera's position is taken out of both view matrices and only the difference between them is kept, so
+         * the matrix stays precise far from the world's origin
+         */
+        static glm::mat4 get_reprojection(const glm::mat4& previous_view, const glm::mat4& previous_projection,
+                                          const glm::vec3& previous_position, const glm::mat4& view,
+                                          const glm::mat4& projection, const glm::vec3& position);
+
+    private:
+        bool enabled = false;
+
+        uint32_t frame_counter = 0;
+        bool has_previous_frame = false;
+
+        glm::mat4 view;
+        glm::mat4 projection;
+        glm::mat4 jittered_projection;
+        glm::vec3 position;
+        glm::vec2 jitter = glm::vec2(0);
+
+        glm::mat4 previous_view;
+        glm::mat4 previous_projection;
+        glm::mat4 previous_jittered_projection;
+        glm::vec3 previous_position;
+
+        /*!
+         * \brief Takes this frame's clip space to the last frame's, for the velocity pass
+         */
+        glm::mat4 reprojection = glm::mat4(1);
+
+        /*!
+         * \brief The result of the last two frames. One is read while the other is written, then they swap
+         */
+        GLuint history_textures[2] = {0, 0};
+        GLuint history_framebuffers[2] = {0, 0};
+        glm::uvec2 history_size = glm::uvec2(0);
+        size_t current_history = 0;
+
+        /*!
+         * \brief How much of the last frame's history texture was drawn
+         */
+        glm::vec2 history_uv_scale = glm::vec2(1);
+        bool has_history = false;
+
+        GLuint output_framebuffer = 0;
+
+        GLuint velocity_program = 0;
+        GLuint resolve_program = 0;
+        GLuint vao = 0;
+        bool programs_broken = false;
+
+        void create_programs();
+
+        void create_history(const glm::uvec2& size);
+
+        void destroy_history();
+    };
+}
+
+#endif //RENDERER_TEMPORAL_ACCUMULATION_H
@@ -0,0 +1,234 @@
+/*!
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include "atlas_stitcher.h"
+#include "../../../utils/thread_pool.h"
+
+namespace nova {
+    skyline_packer::skyline_packer(const glm::ivec2& bin_size) : bin_size(bin_size) {
+        skyline.push_back({0, 0, bin_size.x});
+    }
+
+    bool skyline_packer::pack(const glm::ivec2& size, glm::ivec2& position) {
+        if(size.x <= 0 || size.y <= 0) {
+            return false;
+        }
+
+        size_t best_segment = skyline.size();
+        int best_top = bin_size.y;
+        for(size_t i = 0; i < skyline.size(); i++) {
+            const int top = find_top(i, size);
+            if(top >= 0 && top + size.y <= best_top && (top + size.y < best_top || best_segment == skyline.size())) {
+                best_segment = i;
+                best_top = top + size.y;
+            }
+        }
+
+        if(best_segment == skyline.size()) {
+            return false;
+        }
+
+        position = glm::ivec2(skyline[best_segment].x, best_top - size.y);
+        skyline.insert(skyline.begin() + best_segment, segment{position.x, best_top, size.x});
+
+        // Cut away the parts of the segments the new one covers
+        const int right = position.x + size.x;
+        size_t next = best_segment + 1;
+        while(next < skyline.size() && skyline[next].x < right) {
+            const int covered = right - skyline[next].x;
+            skyline[next].x += covered;
+            skyline[next].width -= covered;
+            if(skyline[next].width > 0) {
+                break;
+            }
+            skyline.erase(skyline.begin() + next);
+        }
+
+        // Join neighbors at the same height so the list stays short
+        for(size_t i = 0; i + 1 < skyline.size();) {
+            if(skyline[i].y == skyline[i + 1].y) {
+                skyline[i].width += skyline[i + 1].width;
+                skyline.erase(skyline.begin() + i + 1);
+            } else {
+                i++;
+            }
+        }
+
+        return true;
+    }
+
+    int skyline_packer::find_top(size_t first_segment, const glm::ivec2& size) const {
+        if(skyline[first_segment].x + size.x > bin_size.x) {
+            return -1;
+        }
+
+        // The segments cover the whole width of the bin, so the rectangle always ends on one of them
+        int top = 0;
+        int width_left = size.x;
+        for(size_t i = first_segment; width_left > 0; i++) {
+            top = std::max(top, skyline[i].y);
+            if(top + size.y > bin_size.y) {
+                return -1;
+            }
+            width_left -= skyline[i].width;
+        }
+
+        return top;
+    }
+
+    bool stitched_atlas::is_valid() const {
+        return size.x > 0 && size.y > 0;
+    }
+
+    glm::vec2 stitched_atlas::get_min_uv(size_t sprite) const {
+        return glm::vec2(positions[sprite]) / glm::vec2(size);
+    }
+
+    glm::vec2 stitched_atlas::get_max_uv(size_t sprite) const {
+        return glm::vec2(positions[sprite] + sprite_sizes[sprite]) / glm::vec2(size);
+    }
+
+    int get_sprite_alignment(int max_mip_level) {
+        return 1 << std::min(std::max(max_mip_level, 0), 30);
+    }
+
+    static int round_up(int value, int multiple) {
+        return (value + multiple - 1) / multiple * multiple;
+    }
+
+    static int next_power_of_two(int value) {
+        int power = 1;
+        while(power < value) {
+            power *= 2;
+        }
+        return power;
+    }
+
+    /*!
+     * \brief Copies a sprite into the atlas, and fills its gutter with copies of its edge texels
+     *
+     * The parts of the gutter that would be outside the atlas are left off
+     */
+    static void blit_sprite(const atlas_sprite& sprite, const glm::ivec2& position, int gutter, stitched_atlas& atlas) {
+        const auto texel_size = static_cast<size_t>(atlas.num_components);
+        const auto row_size = static_cast<size_t>(sprite.size.x) * texel_size;
+        const int first_x = std::max(position.x - gutter, 0);
+        const int last_x = std::min(position.x + sprite.size.x + gutter, atlas.size.x);
+
+        for(int row = -gutter; row < sprite.size.y + gutter; row++) {
+            const int y = position.y + row;
+            if(y < 0 || y >= atlas.size.y) {
+                continue;
+            }
+
+            const uint8_t* source = sprite.pixels + std::min(std::max(row, 0), sprite.size.y - 1) * row_size;
+            uint8_t* destination = atlas.pixels.data() + (static_cast<size_t>(y) * atlas.size.x) * texel_size;
+
+            for(int x = first_x; x < position.x; x++) {
+                std::memcpy(destination + x * texel_size, source, texel_size);
+            }
+            std::memcpy(destination + position.x * texel_size, source, row_size);
+            for(int x = position.x + sprite.size.x; x < last_x; x++) {
+                std::memcpy(destination + x * texel_size, source + row_size - texel_size, texel_size);
+            }
+        }
+    }
+
+    stitched_atlas stitch_atlas(const std::vector<atlas_sprite>& sprites, int num_components, int max_mip_level,
+                                int max_size, unsigned int num_threads) {
+        stitched_atlas atlas;
+        atlas.num_components = num_components;
+        if(sprites.empty()) {
+            return atlas;
+        }
+
+        // Each sprite's cell is the sprite rounded up to the alignment, plus a gap. The sprite sits in the cell's
+        // top-left corner. Half the gap is the sprite's right and bottom gutter, and the other half is the left and
+        // top gutter of whatever's placed after it
+        const int alignment = get_sprite_alignment(max_mip_level);
+        const int gap = std::max(alignment, 2);
+        const int gutter = gap / 2;
+
+        std::vector<glm::ivec2> cell_sizes(sprites.size());
+        glm::ivec2 biggest_cell(0);
+        int64_t total_area = 0;
+        for(size_t i = 0; i < sprites.size(); i++) {
+            if(sprites[i].size.x <= 0 || sprites[i].size.y <= 0 || sprites[i].pixels == nullptr) {
+                return atlas;
+            }
+
+            cell_sizes[i].x = round_up(sprites[i].size.x, alignment) + gap;
+            cell_sizes[i].y = round_up(sprites[i].size.y, alignment) + gap;
+            biggest_cell = glm::max(biggest_cell, cell_sizes[i]);
+            total_area += static_cast<int64_t>(cell_sizes[i].x) * cell_sizes[i].y;
+        }
+
+        std::vector<size_t> packing_order(sprites.size());
+        std::iota(packing_order.begin(), packing_order.end(), 0);
+        std::stable_sort(packing_order.begin(), packing_order.end(), [&](size_t a, size_t b) {
+            if(cell_sizes[a].y != cell_sizes[b].y) {
+                return cell_sizes[a].y > cell_sizes[b].y;
+            }
+            return cell_sizes[a].x > cell_sizes[b].x;
+        });
+
+        // Try atlases from the smallest that could hold all the cells up, growing the width and height in turn
+        glm::ivec2 size(next_power_of_two(std::max(biggest_cell.x, biggest_cell.y)));
+        auto grow = [&]() {
+            if(size.x == size.y) {
+                size.x *= 2;
+            } else {
+                size.y *= 2;
+            }
+        };
+        while(static_cast<int64_t>(size.x) * size.y < total_area) {
+            grow();
+        }
+
+        std::vector<glm::ivec2> positions(sprites.size());
+        bool packed = false;
+        while(!packed && size.x <= max_size && size.y <= max_size) {
+            skyline_packer packer(size);
+            packed = true;
+            for(const size_t sprite : packing_order) {
+                if(!packer.pack(cell_sizes[sprite], positions[sprite])) {
+                    packed = false;
+                    grow();
+                    break;
+                }
+            }
+        }
+
+        if(!packed) {
+            return atlas;
+        }
+
+        atlas.size = size;
+        atlas.positions = std::move(positions);
+        atlas.sprite_sizes.reserve(sprites.size());
+        for(const auto& sprite : sprites) {
+            atlas.sprite_sizes.push_back(sprite.size);
+        }
+        atlas.pixels.assign(static_cast<size_t>(size.x) * size.y * num_components, 0);
+
+        // The pool's destructor waits for every sprite to be copied, so it has to be gone before the atlas is returned
+        num_threads = static_cast<unsigned int>(std::min<size_t>(std::max(num_threads, 1u), sprites.size()));
+        {
+            thread_pool workers(num_threads, "atlas_stitcher");
+            for(unsigned int thread = 0; thread < num_threads; thread++) {
+                workers.add_task([&, thread]() {
+                    for(size_t i = thread; i < sprites.size(); i += num_threads) {
+                        blit_sprite(sprites[i], atlas.positions[i], gutter, atlas);
+                    }
+                });
+            }
+        }
+
+        return atlas;
+    }
+}
@@ -0,0 +1,117 @@
+/*!
+ * \brief Packs a batch of sprites into one texture atlas
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#ifndef RENDERER_ATLAS_STITCHER_H
+#define RENDERER_ATLAS_STITCHER_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace nova {
+    /*!
+     * \brief Places rectangles in a bin with the bottom-left skyline heuristic
+     *
+     * The skyline is the top edge of everything placed so far, kept as a list of flat segments from left to right. A
+     * new rectangle goes wherever its top edge ends up lowest, and the leftmost of those spots if there's a tie. The
+     * space under a rectangle that sits on more than one segment is lost, which is why sprites are packed tallest
+     * first
+     */
+    class skyline_packer {
+    public:
+        explicit skyline_packer(const glm::ivec2& bin_size);
+
+        /*!
+         * \brief Finds room for a rectangle and takes it
+         *
+         * \param size The size of the rectangle
+         * \param position Where the rectangle's top-left corner went
+         * \return False if the rectangle doesn't fit anywhere. Nothing is taken then
+         */
+        bool pack(const glm::ivec2& size, glm::ivec2& position);
+
+    private:
+        struct segment {
+            int x;
+            int y;
+            int width;
+        };
+
+        glm::ivec2 bin_size;
+        std::vector<segment> skyline;
+
+        /*!
+         * \brief Finds how far down a rectangle starting at the given segment would have to sit
+         *
+         * \return The y the rectangle's top would be at, or -1 if it doesn't fit there
+         */
+        int find_top(size_t first_segment, const glm::ivec2& size) const;
+    };
+
+    /*!
+     * \brief One sprite to stitch
+     */
+    struct atlas_sprite {
+        glm::ivec2 size;
+        const uint8_t* pixels;  //!< Tightly packed rows of texels, top row first
+    };
+
+    /*!
+     * \brief The atlas that #stitch_atlas made
+     */
+    struct stitched_atlas {
+        glm::ivec2 size = glm::ivec2(0);
+        int num_components = 4;
+        std::vector<uint8_t> pixels;
+
+        /*!
+         * \brief The top-left texel of each sprite, in the order the sprites were given
+         */
+        std::vector<glm::ivec2> positions;
+
+        /*!
+         * \brief The size of each sprite, in the order the sprites were given
+         */
+        std::vector<glm::ivec2> sprite_sizes;
+
+        /*!
+         * \brief False if the sprites didn't fit in the biggest atlas allowed
+         */
+        bool is_valid() const;
+
+        glm::vec2 get_min_uv(size_t sprite) const;
+
+        glm::vec2 get_max_uv(size_t sprite) const;
+    };
+
+    /*!
+     * \brief How many texels every sprite's position and gutter is rounded to so the given mip level doesn't blend
+     * sprites together
+     */
+    int get_sprite_alignment(int max_mip_level);
+
+    /*!
+     * \brief Packs the sprites into the smallest power of two atlas they fit in, and copies them into it
+     *
+     * Each sprite gets a gutter around it that repeats its edge texels, so bilinear filtering and the smaller mip
+     * levels sample the sprite's own edge instead of its neighbors. Sprites start on a multiple of
+     * #get_sprite_alignment and the gutters are at least that wide, so a texel of the last mip level never covers
+     * two sprites. The sprites are copied in by a few worker threads, since each one writes to its own part of the
+     * atlas
+     *
+     * \param sprites The sprites to stitch. Their pixels only need to stay alive until this returns
+     * \param num_components How many bytes each texel of every sprite has
+     * \param max_mip_level The smallest mip level the atlas will have
+     * \param max_size The biggest width or height the atlas can have
+     * \param num_threads How many threads copy sprites into the atlas
+     * \return The atlas. If the sprites didn't fit, it isn't valid
+     */
+    stitched_atlas stitch_atlas(const std::vector<atlas_sprite>& sprites, int num_components, int max_mip_level,
+                                int max_size, unsigned int num_threads);
+}
+
+#endif //RENDERER_ATLAS_STITCHER_H
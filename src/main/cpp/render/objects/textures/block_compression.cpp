@@ -0,0 +1,306 @@
+/*!
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "block_compression.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <xmmintrin.h>
+#define NOVA_BC7_SSE
+#endif
+
+namespace nova {
+    /*!
+     * \brief The weights that BC7 uses to blend between a block's endpoints with 4-bit indices, out of 64
+     */
+    static const int BC7_WEIGHTS_4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+    size_t get_block_compressed_size(int width, int height) {
+        return static_cast<size_t>((width + 3) / 4) * static_cast<size_t>((height + 3) / 4) * 16;
+    }
+
+    /*!
+     * \brief Copies the 4x4 block with the given top-left corner out of the image. Texels past the edge of the image
+     * repeat the edge
+     */
+    static void load_block(const uint8_t* pixels, int width, int height, int num_components, int block_x, int block_y,
+                           uint8_t block[16][4]) {
+        for(int y = 0; y < 4; y++) {
+            const int src_y = std::min(block_y + y, height - 1);
+            for(int x = 0; x < 4; x++) {
+                const int src_x = std::min(block_x + x, width - 1);
+                const uint8_t* src = pixels + (static_cast<size_t>(src_y) * width + src_x) * num_components;
+
+                uint8_t* dst = block[y * 4 + x];
+                dst[0] = dst[1] = dst[2] = 0;
+                dst[3] = 255;
+                std::memcpy(dst, src, static_cast<size_t>(std::min(num_components, 4)));
+            }
+        }
+    }
+
+    /*!
+     * \brief Writes bits into a 128-bit block, least significant bit first, the way BC7 lays out its fields
+     */
+    class block_bit_writer {
+    public:
+        explicit block_bit_writer(uint8_t* block) : block(block) {
+            std::memset(block, 0, 16);
+        }
+
+        void write(uint32_t value, int num_bits) {
+            for(int i = 0; i < num_bits; i++) {
+                if(value & (1u << i)) {
+                    block[position / 8] |= static_cast<uint8_t>(1u << (position % 8));
+                }
+                position++;
+            }
+        }
+
+    private:
+        uint8_t* block;
+        int position = 0;
+    };
+
+    /*!
+     * \brief Finds the palette entry closest to each texel and returns the total squared error
+     */
+    static float find_bc7_indices(const float texels[16][4], const float palette[4][16], uint8_t indices[16]) {
+        float total_error = 0;
+        for(int t = 0; t < 16; t++) {
+            float distances[16];
+#if defined(NOVA_BC7_SSE)
+            const __m128 r = _mm_set1_ps(texels[t][0]);
+            const __m128 g = _mm_set1_ps(texels[t][1]);
+            const __m128 b = _mm_set1_ps(texels[t][2]);
+            const __m128 a = _mm_set1_ps(texels[t][3]);
+            for(int i = 0; i < 16; i += 4) {
+                const __m128 dr = _mm_sub_ps(_mm_loadu_ps(&palette[0][i]), r);
+                const __m128 dg = _mm_sub_ps(_mm_loadu_ps(&palette[1][i]), g);
+                const __m128 db = _mm_sub_ps(_mm_loadu_ps(&palette[2][i]), b);
+                const __m128 da = _mm_sub_ps(_mm_loadu_ps(&palette[3][i]), a);
+                __m128 distance = _mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg));
+                distance = _mm_add_ps(distance, _mm_add_ps(_mm_mul_ps(db, db), _mm_mul_ps(da, da)));
+                _mm_storeu_ps(&distances[i], distance);
+            }
+#else
+            for(int i = 0; i < 16; i++) {
+                distances[i] = 0;
+                for(int c = 0; c < 4; c++) {
+                    const float d = palette[c][i] - texels[t][c];
+                    distances[i] += d * d;
+                }
+            }
+#endif
+
+            int best_index = 0;
+            for(int i = 1; i < 16; i++) {
+                if(distances[i] < distances[best_index]) {
+                    best_index = i;
+                }
+            }
+
+            indices[t] = static_cast<uint8_t>(best_index);
+            total_error += distances[best_index];
+        }
+
+        return total_error;
+    }
+
+    static void compress_bc7_block(const uint8_t block[16][4], uint8_t* out) {
+        float texels[16][4];
+        float mean[4] = {0, 0, 0, 0};
+        for(int t = 0; t < 16; t++) {
+            for(int c = 0; c < 4; c++) {
+                texels[t][c] = block[t][c];
+                mean[c] += texels[t][c] / 16.0f;
+            }
+        }
+
+        // The principal axis of the block's colors is where the endpoints go. A few rounds of power iteration on the
+        // covariance matrix find it well enough
+        float covariance[4][4] = {};
+        for(int t = 0; t < 16; t++) {
+            for(int i = 0; i < 4; i++) {
+                for(int j = 0; j < 4; j++) {
+                    covariance[i][j] += (texels[t][i] - mean[i]) * (texels[t][j] - mean[j]);
+                }
+            }
+        }
+
+        float axis[4] = {1, 1, 1, 1};
+        for(int iteration = 0; iteration < 8; iteration++) {
+            float next_axis[4] = {0, 0, 0, 0};
+            for(int i = 0; i < 4; i++) {
+                for(int j = 0; j < 4; j++) {
+                    next_axis[i] += covariance[i][j] * axis[j];
+                }
+            }
+
+            float length = std::sqrt(next_axis[0] * next_axis[0] + next_axis[1] * next_axis[1] +
+                                     next_axis[2] * next_axis[2] + next_axis[3] * next_axis[3]);
+            if(length < 1e-6f) {
+                break;
+            }
+
+            for(int i = 0; i < 4; i++) {
+                axis[i] = next_axis[i] / length;
+            }
+        }
+
+        float min_t = 0;
+        float max_t = 0;
+        for(int t = 0; t < 16; t++) {
+            float projection = 0;
+            for(int c = 0; c < 4; c++) {
+                projection += (texels[t][c] - mean[c]) * axis[c];
+            }
+            min_t = std::min(min_t, projection);
+            max_t = std::max(max_t, projection);
+        }
+
+        float endpoints[2][4];
+        for(int c = 0; c < 4; c++) {
+            endpoints[0][c] = std::min(std::max(mean[c] + axis[c] * min_t, 0.0f), 255.0f);
+            endpoints[1][c] = std::min(std::max(mean[c] + axis[c] * max_t, 0.0f), 255.0f);
+        }
+
+        // Each endpoint is seven bits per channel plus a p-bit shared by its channels. Try every p-bit and keep
+        // whichever quantization fits the block best
+        float best_error = -1;
+        int best_quantized[2][4] = {};
+        int best_pbits[2] = {};
+        uint8_t best_indices[16] = {};
+        for(int pbits = 0; pbits < 4; pbits++) {
+            const int pbit[2] = {pbits & 1, pbits >> 1};
+
+            int quantized[2][4];
+            float palette[4][16];
+            for(int e = 0; e < 2; e++) {
+                for(int c = 0; c < 4; c++) {
+                    quantized[e][c] = std::min(std::max(static_cast<int>(std::lround((endpoints[e][c] - pbit[e]) / 2.0f)), 0), 127);
+                }
+            }
+
+            for(int i = 0; i < 16; i++) {
+                for(int c = 0; c < 4; c++) {
+                    const int e0 = (quantized[0][c] << 1) | pbit[0];
+                    const int e1 = (quantized[1][c] << 1) | pbit[1];
+                    palette[c][i] = static_cast<float>(((64 - BC7_WEIGHTS_4[i]) * e0 + BC7_WEIGHTS_4[i] * e1 + 32) >> 6);
+                }
+            }
+
+            uint8_t indices[16];
+            const float error = find_bc7_indices(texels, palette, indices);
+            if(best_error < 0 || error < best_error) {
+                best_error = error;
+                std::memcpy(best_quantized, quantized, sizeof(quantized));
+                best_pbits[0] = pbit[0];
+                best_pbits[1] = pbit[1];
+                std::memcpy(best_indices, indices, sizeof(indices));
+            }
+        }
+
+        // The first texel's index only gets three bits, so its top bit has to be zero. Swapping the endpoints and
+        // flipping every index makes that true without changing the decoded block
+        if(best_indices[0] >= 8) {
+            for(int c = 0; c < 4; c++) {
+                std::swap(best_quantized[0][c], best_quantized[1][c]);
+            }
+            std::swap(best_pbits[0], best_pbits[1]);
+            for(auto& index : best_indices) {
+                index = static_cast<uint8_t>(15 - index);
+            }
+        }
+
+        block_bit_writer writer(out);
+        writer.write(1u << 6, 7);
+        for(int c = 0; c < 4; c++) {
+            writer.write(static_cast<uint32_t>(best_quantized[0][c]), 7);
+            writer.write(static_cast<uint32_t>(best_quantized[1][c]), 7);
+        }
+        writer.write(static_cast<uint32_t>(best_pbits[0]), 1);
+        writer.write(static_cast<uint32_t>(best_pbits[1]), 1);
+
+        writer.write(best_indices[0], 3);
+        for(int t = 1; t < 16; t++) {
+            writer.write(best_indices[t], 4);
+        }
+    }
+
+    /*!
+     * \brief Encodes one channel of a block as a BC4 block, using the mode with six blended values between the
+     * endpoints
+     */
+    static void compress_bc4_block(const uint8_t block[16][4], int channel, uint8_t* out) {
+        int max_value = 0;
+        int min_value = 255;
+        for(int t = 0; t < 16; t++) {
+            max_value = std::max(max_value, static_cast<int>(block[t][channel]));
+            min_value = std::min(min_value, static_cast<int>(block[t][channel]));
+        }
+
+        // With the first endpoint higher, index 0 is the max, index 1 is the min, and indices 2-7 step from the max
+        // to the min
+        int palette[8];
+        palette[0] = max_value;
+        palette[1] = min_value;
+        for(int i = 2; i < 8; i++) {
+            palette[i] = ((8 - i) * max_value + (i - 1) * min_value) / 7;
+        }
+
+        uint64_t index_bits = 0;
+        for(int t = 0; t < 16; t++) {
+            int best_index = 0;
+            for(int i = 1; i < 8; i++) {
+                if(std::abs(palette[i] - block[t][channel]) < std::abs(palette[best_index] - block[t][channel])) {
+                    best_index = i;
+                }
+            }
+            index_bits |= static_cast<uint64_t>(best_index) << (t * 3);
+        }
+
+        out[0] = static_cast<uint8_t>(max_value);
+        out[1] = static_cast<uint8_t>(min_value);
+        for(int i = 0; i < 6; i++) {
+            out[2 + i] = static_cast<uint8_t>(index_bits >> (i * 8));
+        }
+    }
+
+    std::vector<uint8_t> compress_bc7(const uint8_t* pixels, int width, int height) {
+        std::vector<uint8_t> compressed(get_block_compressed_size(width, height));
+
+        uint8_t* out = compressed.data();
+        uint8_t block[16][4];
+        for(int y = 0; y < height; y += 4) {
+            for(int x = 0; x < width; x += 4) {
+                load_block(pixels, width, height, 4, x, y, block);
+                compress_bc7_block(block, out);
+                out += 16;
+            }
+        }
+
+        return compressed;
+    }
+
+    std::vector<uint8_t> compress_bc5(const uint8_t* pixels, int width, int height, int num_components) {
+        std::vector<uint8_t> compressed(get_block_compressed_size(width, height));
+
+        uint8_t* out = compressed.data();
+        uint8_t block[16][4];
+        for(int y = 0; y < height; y += 4) {
+            for(int x = 0; x < width; x += 4) {
+                load_block(pixels, width, height, num_components, x, y, block);
+                compress_bc4_block(block, 0, out);
+                compress_bc4_block(block, 1, out + 8);
+                out += 16;
+            }
+        }
+
+        return compressed;
+    }
+}
@@ -0,0 +1,53 @@
+/*!
+ * \brief CPU encoders for the BC7 and BC5 block compressed texture formats
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_BLOCK_COMPRESSION_H
+#define RENDERER_BLOCK_COMPRESSION_H
+
+#include <cstdint>
+#include <vector>
+
+namespace nova {
+    /*!
+     * \brief How many bytes a BC7 or BC5 image of the given size takes up
+     *
+     * Both formats store each 4x4 block of texels in 16 bytes. Images that aren't a multiple of four texels on a side
+     * still take up whole blocks
+     */
+    size_t get_block_compressed_size(int width, int height);
+
+    /*!
+     * \brief Compresses RGBA8 pixels to BC7 (GL_COMPRESSED_RGBA_BPTC_UNORM)
+     *
+     * Every block is encoded in mode 6, which has one pair of RGBA endpoints and sixteen 4-bit indices. That's the mode
+     * that does best on blocks without sharp edges between colors, which is most of a Minecraft atlas, and it can be
+     * encoded quickly enough to run on a resource pack load. The endpoints come from the blocks' principal axis, and
+     * both p-bits are tried to find the best fit
+     *
+     * \param pixels The pixels to compress, four bytes each and tightly packed
+     * \param width The width of the image, in pixels
+     * \param height The height of the image, in pixels
+     * \return The compressed blocks, in row-major order
+     */
+    std::vector<uint8_t> compress_bc7(const uint8_t* pixels, int width, int height);
+
+    /*!
+     * \brief Compresses the first two channels of the given pixels to BC5 (GL_COMPRESSED_RG_RGTC2)
+     *
+     * BC5 is two independent BC4 blocks, which is what normal maps want: X and Y each get their own endpoints, and the
+     * shader rebuilds Z
+     *
+     * \param pixels The pixels to compress, tightly packed
+     * \param width The width of the image, in pixels
+     * \param height The height of the image, in pixels
+     * \param num_components How many bytes each pixel has. Must be at least two
+     * \return The compressed blocks, in row-major order
+     */
+    std::vector<uint8_t> compress_bc5(const uint8_t* pixels, int width, int height, int num_components);
+}
+
+#endif //RENDERER_BLOCK_COMPRESSION_H
@@ -0,0 +1,111 @@
+/*!
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <easylogging++.h>
+#include "compressed_texture_cache.h"
+#include "../../../utils/utils.h"
+
+namespace nova {
+    /*!
+     * \brief Marks a file as one of ours. Bump the version whenever the encoders change what they output
+     */
+    static const uint32_t CACHE_FILE_MAGIC = 0x4342564e;  // "NVBC"
+    static const uint32_t CACHE_FILE_VERSION = 1;
+
+    compressed_texture_cache::compressed_texture_cache(std::string directory) : directory(std::move(directory)) {}
+
+    uint64_t compressed_texture_cache::make_key(const uint8_t* pixels, size_t num_bytes, int width, int height,
+                                                uint32_t compressed_format, int num_levels) {
+        // 64-bit FNV-1a
+        uint64_t hash = 14695981039346656037ull;
+        auto add = [&hash](uint64_t value) {
+            hash = (hash ^ value) * 1099511628211ull;
+        };
+
+        add(static_cast<uint64_t>(width));
+        add(static_cast<uint64_t>(height));
+        add(compressed_format);
+        add(static_cast<uint64_t>(num_levels));
+        add(CACHE_FILE_VERSION);
+        for(size_t i = 0; i < num_bytes; i++) {
+            add(pixels[i]);
+        }
+
+        return hash;
+    }
+
+    bool compressed_texture_cache::load(uint64_t key, std::vector<std::vector<uint8_t>>& levels) const {
+        std::ifstream file(get_path(key), std::ios::binary);
+        if(!file.is_open()) {
+            return false;
+        }
+
+        uint32_t magic = 0;
+        uint32_t version = 0;
+        uint64_t file_key = 0;
+        uint32_t num_levels = 0;
+        file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+        file.read(reinterpret_cast<char*>(&version), sizeof(version));
+        file.read(reinterpret_cast<char*>(&file_key), sizeof(file_key));
+        file.read(reinterpret_cast<char*>(&num_levels), sizeof(num_levels));
+        if(!file || magic != CACHE_FILE_MAGIC || version != CACHE_FILE_VERSION || file_key != key || num_levels > 32) {
+            LOG(WARNING) << "Ignoring compressed texture cache file " << get_path(key) << " because it's not one I understand";
+            return false;
+        }
+
+        levels.resize(num_levels);
+        for(auto& level : levels) {
+            uint64_t size = 0;
+            file.read(reinterpret_cast<char*>(&size), sizeof(size));
+            if(!file || size > (1ull << 32)) {
+                return false;
+            }
+
+            level.resize(static_cast<size_t>(size));
+            file.read(reinterpret_cast<char*>(level.data()), static_cast<std::streamsize>(size));
+        }
+
+        return static_cast<bool>(file);
+    }
+
+    void compressed_texture_cache::save(uint64_t key, const std::vector<std::vector<uint8_t>>& levels) const {
+        make_directory(directory);
+
+        // Write to a temporary file first so a crash halfway through never leaves a broken entry behind
+        const std::string path = get_path(key);
+        const std::string temp_path = path + ".tmp";
+        {
+            std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+            if(!file.is_open()) {
+                LOG(WARNING) << "Could not write the compressed texture cache file " << temp_path;
+                return;
+            }
+
+            const auto num_levels = static_cast<uint32_t>(levels.size());
+            file.write(reinterpret_cast<const char*>(&CACHE_FILE_MAGIC), sizeof(CACHE_FILE_MAGIC));
+            file.write(reinterpret_cast<const char*>(&CACHE_FILE_VERSION), sizeof(CACHE_FILE_VERSION));
+            file.write(reinterpret_cast<const char*>(&key), sizeof(key));
+            file.write(reinterpret_cast<const char*>(&num_levels), sizeof(num_levels));
+            for(const auto& level : levels) {
+                const auto size = static_cast<uint64_t>(level.size());
+                file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+                file.write(reinterpret_cast<const char*>(level.data()), static_cast<std::streamsize>(size));
+            }
+        }
+
+        std::remove(path.c_str());
+        if(std::rename(temp_path.c_str(), path.c_str()) != 0) {
+            LOG(WARNING) << "Could not move the compressed texture cache file " << temp_path << " to " << path;
+        }
+    }
+
+    std::string compressed_texture_cache::get_path(uint64_t key) const {
+        char name[17];
+        std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+        return directory + "/" + name + ".nbc";
+    }
+}
@@ -0,0 +1,62 @@
+/*!
+ * \brief Keeps block compressed textures on disk so they only have to be encoded once
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_COMPRESSED_TEXTURE_CACHE_H
+#define RENDERER_COMPRESSED_TEXTURE_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace nova {
+    /*!
+     * \brief Reads and writes compressed mip chains in a directory, one file per texture
+     *
+     * Textures are keyed by a hash of their uncompressed pixels along with everything that changes how they're
+     * encoded. A texture atlas is built from the loaded resource packs, so the same packs give the same key and a
+     * reload can read the blocks straight from disk. Nothing here touches OpenGL, so it's safe to use from any thread
+     * as long as two threads aren't writing the same key
+     */
+    class compressed_texture_cache {
+    public:
+        explicit compressed_texture_cache(std::string directory);
+
+        /*!
+         * \brief Hashes a texture and how it'll be encoded into a cache key
+         *
+         * \param pixels The uncompressed pixels
+         * \param num_bytes How many bytes of pixels there are
+         * \param width The width of the texture
+         * \param height The height of the texture
+         * \param compressed_format The GL format the texture is compressed to
+         * \param num_levels How many mip levels will be compressed
+         */
+        static uint64_t make_key(const uint8_t* pixels, size_t num_bytes, int width, int height,
+                                 uint32_t compressed_format, int num_levels);
+
+        /*!
+         * \brief Reads the mip chain with the given key
+         *
+         * \param key The key to read
+         * \param levels Filled with the compressed data for each mip level, largest first
+         * \return True if the cache had a complete entry for the key
+         */
+        bool load(uint64_t key, std::vector<std::vector<uint8_t>>& levels) const;
+
+        /*!
+         * \brief Writes the mip chain for the given key, replacing anything that was there
+         */
+        void save(uint64_t key, const std::vector<std::vector<uint8_t>>& levels) const;
+
+    private:
+        std::string directory;
+
+        std::string get_path(uint64_t key) const;
+    };
+}
+
+#endif //RENDERER_COMPRESSED_TEXTURE_CACHE_H
@@ -3,9 +3,13 @@
 //
 
 #include "texture2D.h"
+#include <algorithm>
 #include <stdexcept>
 #include <easylogging++.h>
 #include "../../../utils/utils.h"
+#include "../frame_stats.h"
+#include "../gl_state.h"
+#include "../gpu_memory.h"
 
 namespace nova {
     texture2D::texture2D() : size(0) {
@@ -13,25 +17,83 @@ namespace nova {
     }
 
     void texture2D::set_data(void* pixel_data, glm::ivec2 &dimensions, GLenum format, GLenum type, GLenum internal_format) {
-        GLint previous_texture;
-        glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous_texture);
-        glBindTexture(GL_TEXTURE_2D, gl_name);
+        // The state cache knows this texture is bound now, so nothing has to be put back afterwards
+        gl_state::bind_texture_2d(0, gl_name);
         glTexImage2D(GL_TEXTURE_2D, 0, internal_format, dimensions.x, dimensions.y, 0, format, type, pixel_data);
+        gpu_memory::track_texture(gl_name, gpu_memory_category::textures,
+                                  gpu_memory::get_texture_size(internal_format, dimensions.x, dimensions.y));
 
         glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
         glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        
-        glBindTexture(GL_TEXTURE_2D, (GLuint) previous_texture);
+
+        size = dimensions;
+        this->format = internal_format;
+        num_levels = 1;
+    }
+
+    void texture2D::set_storage(const glm::ivec2 &dimensions, GLenum internal_format, GLsizei num_levels) {
+        if(has_immutable_storage && size == dimensions && format == static_cast<GLint>(internal_format)) {
+            return;
+        }
+
+        // Either this texture has immutable storage of the wrong size, or glTexImage2D has already given it mutable
+        // storage. Neither can become the storage we want, so start over with a fresh texture
+        gl_state::delete_textures(1, &gl_name);
+        glCreateTextures(GL_TEXTURE_2D, 1, &gl_name);
+        glTextureStorage2D(gl_name, num_levels, internal_format, dimensions.x, dimensions.y);
+        gpu_memory::track_texture(gl_name, gpu_memory_category::textures,
+                                  gpu_memory::get_texture_size(internal_format, dimensions.x, dimensions.y, num_levels));
+
+        glTextureParameteri(gl_name, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTextureParameteri(gl_name, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        size = dimensions;
+        format = internal_format;
+        has_immutable_storage = true;
+        this->num_levels = num_levels;
+        max_level = num_levels - 1;
+    }
+
+    void texture2D::set_sub_data(const void* pixel_data, GLenum format, GLenum type) {
+        // Rows of one, two, or three byte pixels aren't necessarily four-byte aligned
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTextureSubImage2D(gl_name, 0, 0, 0, size.x, size.y, format, type, pixel_data);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+
+    void texture2D::set_compressed_level(GLint level, const std::vector<uint8_t>& compressed_data) {
+        const GLsizei width = std::max(size.x >> level, 1);
+        const GLsizei height = std::max(size.y >> level, 1);
+        glCompressedTextureSubImage2D(gl_name, level, 0, 0, width, height, static_cast<GLenum>(format),
+                                      static_cast<GLsizei>(compressed_data.size()), compressed_data.data());
+        frame_stats::count_upload(compressed_data.size());
+    }
+
+    void texture2D::generate_mipmaps() {
+        if(num_levels > 1) {
+            glGenerateTextureMipmap(gl_name);
+        }
+    }
+
+    void texture2D::limit_mip_levels(GLint new_max_level) {
+        new_max_level = std::max(new_max_level, 0);
+        if(new_max_level >= max_level) {
+            return;
+        }
+
+        glTextureParameteri(gl_name, GL_TEXTURE_MAX_LEVEL, new_max_level);
+        max_level = new_max_level;
     }
 
     void texture2D::bind(unsigned int binding) {
-        glBindTextureUnit(binding, gl_name);
+        gl_state::bind_texture_unit(binding, gl_name);
         current_location = binding;
     }
 
     void texture2D::unbind() {
-        glActiveTexture((GLenum) current_location);
-        glBindTexture(GL_TEXTURE_2D, 0);
+        if(current_location >= 0) {
+            gl_state::bind_texture_unit(static_cast<GLuint>(current_location), 0);
+        }
         current_location = -1;
     }
 
@@ -48,7 +110,46 @@ namespace nova {
     }
 
     void texture2D::set_filtering_parameters(texture_filtering_params &params) {
-        // TODO
+        GLint min_filter = GL_NEAREST;
+        if(num_levels > 1) {
+            switch(params.texture_downsample_filter) {
+                case texture_filtering_params::POINT:
+                    min_filter = GL_NEAREST_MIPMAP_NEAREST;
+                    break;
+                case texture_filtering_params::BILINEAR:
+                    min_filter = GL_LINEAR_MIPMAP_NEAREST;
+                    break;
+                case texture_filtering_params::TRILINEAR:
+                    min_filter = GL_LINEAR_MIPMAP_LINEAR;
+                    break;
+            }
+
+        } else if(params.texture_downsample_filter != texture_filtering_params::POINT) {
+            min_filter = GL_LINEAR;
+        }
+
+        GLint mag_filter = params.texture_upsample_filter == texture_filtering_params::POINT ? GL_NEAREST : GL_LINEAR;
+
+        glTextureParameteri(gl_name, GL_TEXTURE_MIN_FILTER, min_filter);
+        glTextureParameteri(gl_name, GL_TEXTURE_MAG_FILTER, mag_filter);
+
+        if(GLAD_GL_VERSION_4_6 || GLAD_GL_ARB_texture_filter_anisotropic || GLAD_GL_EXT_texture_filter_anisotropic) {
+            static GLfloat max_anisotropy = 0;
+            if(max_anisotropy == 0) {
+                glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &max_anisotropy);
+            }
+
+            auto anisotropy = std::min(std::max(static_cast<GLfloat>(params.anisotropic_level), 1.0f), max_anisotropy);
+            glTextureParameterf(gl_name, GL_TEXTURE_MAX_ANISOTROPY, anisotropy);
+        }
+    }
+
+    GLsizei texture2D::get_num_levels() const {
+        return num_levels;
+    }
+
+    GLint texture2D::get_max_mip_level() const {
+        return max_level;
     }
 
     const unsigned int &texture2D::get_gl_name() {
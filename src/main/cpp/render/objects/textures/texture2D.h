@@ -24,11 +24,18 @@ namespace nova {
             TRILINEAR,
         };
 
-        filter texture_upsample_filter;
-        filter texture_downsample_filter;
+        filter texture_upsample_filter = POINT;
+        filter texture_downsample_filter = POINT;
 
-        int num_mipmap_levels;
-        int anisotropic_level;
+        /*!
+         * \brief How many mip levels to make below the full-size image. The texture may get fewer if it's too small
+         */
+        int num_mipmap_levels = 0;
+
+        /*!
+         * \brief The max anisotropy to sample with. 1 turns anisotropic filtering off
+         */
+        int anisotropic_level = 1;
     };
 
     class texture_creation_exception : public std::exception {
@@ -79,8 +86,70 @@ namespace nova {
          */
         void set_data(void* pixel_data, glm::ivec2 &dimensions, GLenum format, GLenum type = GL_FLOAT, GLenum internal_format = GL_RGBA);
 
+        /*!
+         * \brief Gives this texture immutable storage with the given size and sized internal format
+         *
+         * Immutable storage can't be resized, so if this texture already has storage with a different size or format,
+         * this texture gets a brand new texture object and the old one is deleted
+         *
+         * \param dimensions The size of the texture
+         * \param internal_format A sized internal format, like GL_RGBA8 or GL_SRGB8_ALPHA8
+         * \param num_levels The number of mip levels to allocate
+         */
+        void set_storage(const glm::ivec2 &dimensions, GLenum internal_format, GLsizei num_levels = 1);
+
+        /*!
+         * \brief Uploads pixels to the whole of mip level 0. The texture must have storage from #set_storage
+         *
+         * \param pixel_data The pixels to upload, tightly packed
+         * \param format The format of the pixel data, like GL_RGBA or GL_BGRA
+         * \param type The type of each component of the pixel data
+         */
+        void set_sub_data(const void* pixel_data, GLenum format, GLenum type = GL_UNSIGNED_BYTE);
+
+        /*!
+         * \brief Uploads already block compressed data to a whole mip level. The texture must have compressed storage
+         * from #set_storage
+         *
+         * \param level The mip level to upload to
+         * \param compressed_data The compressed blocks for that level
+         */
+        void set_compressed_level(GLint level, const std::vector<uint8_t>& compressed_data);
+
+        /*!
+         * \brief Fills in every mip level below level 0 from level 0, on the GPU
+         *
+         * Does nothing if this texture only has one level
+         */
+        void generate_mipmaps();
+
+        /*!
+         * \brief Stops this texture from being sampled below the given mip level
+         *
+         * The limit only ever goes down. Texture atlases use this to keep sprites from blurring into their neighbors
+         * once a mip level's texels are bigger than a sprite
+         *
+         * \param new_max_level The smallest mip level that can be sampled
+         */
+        void limit_mip_levels(GLint new_max_level);
+
+        /*!
+         * \brief Sets this texture's min and mag filters and anisotropy
+         *
+         * The mip filter is only used if this texture has more than one mip level
+         */
         void set_filtering_parameters(texture_filtering_params &params);
 
+        /*!
+         * \brief Returns how many mip levels this texture has storage for
+         */
+        GLsizei get_num_levels() const;
+
+        /*!
+         * \brief Returns the smallest mip level that can be sampled, as set by #limit_mip_levels
+         */
+        GLint get_max_mip_level() const;
+
         /*!
          * \brief Returns the width of this texture
          *
@@ -116,6 +185,14 @@ namespace nova {
         GLuint gl_name;
         GLint current_location = -1;
         std::string name;
+
+        /*!
+         * \brief True if this texture's storage was made by #set_storage and so can't be respecified
+         */
+        bool has_immutable_storage = false;
+
+        GLsizei num_levels = 1;
+        GLint max_level = 1000;
     };
 }
 
@@ -4,10 +4,22 @@
  */
 
 #include <algorithm>
+#include <cmath>
+#include <thread>
 #include <easylogging++.h>
 #include "texture_manager.h"
+#include "block_compression.h"
+#include "../gl_state.h"
+#include "../gpu_memory.h"
+#include "../frame_stats.h"
+#include "../../windowing/glfw_gl_window.h"
 
 namespace nova {
+    /*!
+     * \brief Where a texture that isn't in an atlas is: everywhere
+     */
+    static const texture_manager::texture_location WHOLE_TEXTURE = {{0, 0}, {1, 1}};
+
     texture_manager::texture_manager() {
         LOG(INFO) << "Creating the Texture Manager";
         reset();
@@ -18,44 +30,60 @@ namespace nova {
         // gotta free up all the OpenGL textures
         // The driver probably does that for me, but I ain't about to let no stinkin' driver boss me around!
         reset();
+
+        if(sprite_location_buffer != 0 && glfwGetCurrentContext() != nullptr) {
+            gl_state::delete_buffers(1, &sprite_location_buffer);
+        }
     }
 
     void texture_manager::reset() {
         if(!atlases.empty()) {
-            // Nothing to deallocate, let's just return
-            return;
-        }
-        // Gather all the textures into a list so we only need one call to delete them
-        std::vector<GLuint> texture_ids(atlases.size());
-        for(auto tex : atlases) {
-            texture_ids.push_back(tex.second.get_gl_name());
+            // Gather all the textures into a list so we only need one call to delete them
+            std::vector<GLuint> texture_ids;
+            texture_ids.reserve(atlases.size());
+            for(auto& tex : atlases) {
+                texture_ids.push_back(tex.second.get_gl_name());
+            }
+
+            gl_state::delete_textures((GLsizei) texture_ids.size(), texture_ids.data());
         }
 
-        glDeleteTextures((GLsizei) texture_ids.size(), texture_ids.data());
+        for(auto& texture : handle_textures) {
+            texture = nullptr;
+        }
 
         atlases.clear();
-        locations.clear();
 
-        atlases["lightmap"] = texture2D{};
+        // Sprite handles stay good, but none of them have a location anymore
+        std::fill(sprite_locations.begin(), sprite_locations.end(), WHOLE_TEXTURE);
+        sprite_locations_changed = true;
+        locations_version++;
+        contents_version++;
+
+        // Any compression jobs still running will see that their atlas is gone and be thrown away
+        atlas_tickets.clear();
+
+        get_or_create_atlas("lightmap") = texture2D{};
     }
 
     void texture_manager::update_texture(std::string texture_name, void* data, glm::ivec2 &size, GLenum format, GLenum type, GLenum internal_format) {
-        auto &texture = atlases[texture_name];
-        texture.set_data(data, size, format, type, internal_format);
+        auto &texture = get_or_create_atlas(texture_name);
+        texture.set_storage(size, internal_format);
+        get_uploader().upload(texture.get_gl_name(), size.x, size.y, format, type, data);
     }
 
-    void texture_manager::add_texture(mc_atlas_texture &new_texture) {
+    uint64_t texture_manager::add_texture(mc_atlas_texture &new_texture) {
+        uint64_t ticket = reserve_upload_ticket();
+        add_texture(new_texture, ticket);
+        return ticket;
+    }
+
+    void texture_manager::add_texture(mc_atlas_texture &new_texture, uint64_t ticket) {
         LOG(INFO) << "Adding texture " << new_texture.name << " (" << new_texture.width << "x" << new_texture.height << ")";
         std::string texture_name = new_texture.name;
         texture2D texture;
         texture.set_name(texture_name);
 
-        std::vector<float> pixel_data(
-                (size_t) (new_texture.width * new_texture.height * new_texture.num_components));
-        for(int i = 0; i < new_texture.width * new_texture.height * new_texture.num_components; i++) {
-            pixel_data[i] = float(new_texture.texture_data[i]) / 255.0f;
-        }
-
         auto dimensions = glm::ivec2{new_texture.width, new_texture.height};
 
         GLenum format = GL_RGB;
@@ -76,12 +104,250 @@ namespace nova {
                 LOG(ERROR) << "Unsupported number of components. You have " << new_texture.num_components
                            << " components "
                            << ", but I need a number in [1,4]";
+                complete_upload_ticket(ticket);
+                return;
+        }
+
+        // The bytes from Minecraft go straight to the GPU. Sized 8-bit storage means the driver doesn't have to
+        // convert anything
+        texture.set_storage(dimensions, get_internal_format(new_texture.num_components), get_num_mip_levels(dimensions));
+        texture.set_filtering_parameters(atlas_filtering);
+
+        get_uploader().upload(texture.get_gl_name(), dimensions.x, dimensions.y, format, GL_UNSIGNED_BYTE,
+                              new_texture.texture_data, [this, ticket]() { complete_upload_ticket(ticket); });
+
+        // The upload is queued before this, so the GPU builds the mips from the new pixels
+        texture.generate_mipmaps();
+
+        auto old_texture = atlases.find(texture_name);
+        if(old_texture != atlases.end()) {
+            GLuint old_gl_name = old_texture->second.get_gl_name();
+            gl_state::delete_textures(1, &old_gl_name);
+        }
+
+        get_or_create_atlas(texture_name) = texture;
+        atlas_tickets[texture_name] = ticket;
+        last_added_atlas = texture_name;
+        contents_version++;
+
+        GLenum compressed_format = get_compressed_format(texture_name, new_texture.num_components);
+        if(compress_textures && compressed_format != GL_NONE) {
+            start_compression(new_texture, compressed_format, texture.get_num_levels(), ticket);
+        }
+        LOG(DEBUG) << "Texture atlas " << texture_name << " is OpenGL texture " << texture.get_gl_name() << " with "
+                   << texture.get_num_levels() << " mip levels";
+    }
+
+    uint64_t texture_manager::reserve_upload_ticket() {
+        uint64_t ticket = next_upload_ticket++;
+
+        std::lock_guard<std::mutex> lock(pending_upload_tickets_lock);
+        pending_upload_tickets.insert(ticket);
+        return ticket;
+    }
+
+    bool texture_manager::is_texture_upload_complete(uint64_t ticket) const {
+        std::lock_guard<std::mutex> lock(pending_upload_tickets_lock);
+        return pending_upload_tickets.find(ticket) == pending_upload_tickets.end();
+    }
+
+    void texture_manager::complete_upload_ticket(uint64_t ticket) {
+        contents_version++;
+
+        std::lock_guard<std::mutex> lock(pending_upload_tickets_lock);
+        pending_upload_tickets.erase(ticket);
+    }
+
+    void texture_manager::update_uploads() {
+        if(uploader) {
+            uploader->update();
+        }
+
+        for(auto job = compression_jobs.begin(); job != compression_jobs.end();) {
+            if(job->levels.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                ++job;
+                continue;
+            }
+
+            finish_compression(*job);
+            job = compression_jobs.erase(job);
+        }
+    }
+
+    GLenum texture_manager::get_compressed_format(const std::string& texture_name, int num_components) const {
+        const std::string normal_suffix = "_normal";
+        const bool is_normal_map = texture_name.size() > normal_suffix.size() &&
+                texture_name.compare(texture_name.size() - normal_suffix.size(), normal_suffix.size(), normal_suffix) == 0;
+
+        if(is_normal_map && num_components >= 2) {
+            return GL_COMPRESSED_RG_RGTC2;
+        }
+
+        if(num_components == 4) {
+            return use_srgb_textures ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+        }
+
+        return GL_NONE;
+    }
+
+    /*!
+     * \brief Halves the image in each direction by averaging each 2x2 square of pixels
+     */
+    static std::vector<uint8_t> downsample(const std::vector<uint8_t>& pixels, const glm::ivec2& dimensions, int num_components) {
+        const glm::ivec2 half_size = glm::max(dimensions / 2, glm::ivec2(1));
+        std::vector<uint8_t> half(static_cast<size_t>(half_size.x) * half_size.y * num_components);
+
+        for(int y = 0; y < half_size.y; y++) {
+            const int y0 = std::min(y * 2, dimensions.y - 1);
+            const int y1 = std::min(y * 2 + 1, dimensions.y - 1);
+            for(int x = 0; x < half_size.x; x++) {
+                const int x0 = std::min(x * 2, dimensions.x - 1);
+                const int x1 = std::min(x * 2 + 1, dimensions.x - 1);
+                for(int c = 0; c < num_components; c++) {
+                    auto texel = [&](int tx, int ty) {
+                        return pixels[(static_cast<size_t>(ty) * dimensions.x + tx) * num_components + c];
+                    };
+                    const int sum = texel(x0, y0) + texel(x1, y0) + texel(x0, y1) + texel(x1, y1);
+                    half[(static_cast<size_t>(y) * half_size.x + x) * num_components + c] = static_cast<uint8_t>((sum + 2) / 4);
+                }
+            }
+        }
+
+        return half;
+    }
+
+    void texture_manager::start_compression(mc_atlas_texture& new_texture, GLenum compressed_format, GLsizei num_levels, uint64_t ticket) {
+        const glm::ivec2 dimensions{new_texture.width, new_texture.height};
+        const int num_components = new_texture.num_components;
+
+        // Minecraft's memory is gone as soon as add_texture returns, so the worker gets its own copy
+        std::vector<uint8_t> pixels(new_texture.texture_data, new_texture.texture_data + static_cast<size_t>(dimensions.x) * dimensions.y * num_components);
+        compressed_texture_cache cache(texture_cache_directory);
+        std::string name = new_texture.name;
+
+        compression_job job;
+        job.atlas_name = name;
+        job.atlas_ticket = ticket;
+        job.compressed_format = compressed_format;
+        job.dimensions = dimensions;
+        job.levels = std::async(std::launch::async, [=, pixels = std::move(pixels)]() mutable {
+            const uint64_t key = compressed_texture_cache::make_key(pixels.data(), pixels.size(), dimensions.x, dimensions.y, compressed_format, num_levels);
+
+            std::vector<std::vector<uint8_t>> levels;
+            if(cache.load(key, levels) && levels.size() == static_cast<size_t>(num_levels)) {
+                LOG(INFO) << "Loaded compressed texture " << name << " from the texture cache";
+                return levels;
+            }
+
+            levels.clear();
+            glm::ivec2 level_size = dimensions;
+            for(GLsizei level = 0; level < num_levels; level++) {
+                if(level > 0) {
+                    pixels = downsample(pixels, level_size, num_components);
+                    level_size = glm::max(level_size / 2, glm::ivec2(1));
+                }
+
+                if(compressed_format == GL_COMPRESSED_RG_RGTC2) {
+                    levels.push_back(compress_bc5(pixels.data(), level_size.x, level_size.y, num_components));
+                } else {
+                    levels.push_back(compress_bc7(pixels.data(), level_size.x, level_size.y));
+                }
+            }
+
+            cache.save(key, levels);
+            LOG(INFO) << "Compressed texture " << name << " and saved it to the texture cache";
+            return levels;
+        });
+
+        compression_jobs.push_back(std::move(job));
+    }
+
+    void texture_manager::finish_compression(compression_job& job) {
+        std::vector<std::vector<uint8_t>> levels;
+        try {
+            levels = job.levels.get();
+        } catch(std::exception& e) {
+            LOG(ERROR) << "Could not compress texture " << job.atlas_name << ": " << e.what();
+            return;
+        }
+
+        auto current_ticket = atlas_tickets.find(job.atlas_name);
+        if(current_ticket == atlas_tickets.end() || current_ticket->second != job.atlas_ticket) {
+            return;
         }
 
-        texture.set_data(pixel_data.data(), dimensions, format);
+        auto& old_texture = get_or_create_atlas(job.atlas_name);
 
-        atlases[texture_name] = texture;
-        LOG(DEBUG) << "Texture atlas " << texture_name << " is OpenGL texture " << texture.get_gl_name();
+        texture2D texture;
+        texture.set_name(job.atlas_name);
+        texture.set_storage(job.dimensions, job.compressed_format, static_cast<GLsizei>(levels.size()));
+        for(size_t level = 0; level < levels.size(); level++) {
+            texture.set_compressed_level(static_cast<GLint>(level), levels[level]);
+        }
+        texture.set_filtering_parameters(atlas_filtering);
+        texture.limit_mip_levels(old_texture.get_max_mip_level());
+
+        GLuint old_gl_name = old_texture.get_gl_name();
+        gl_state::delete_textures(1, &old_gl_name);
+        old_texture = texture;
+        contents_version++;
+
+        LOG(DEBUG) << "Texture atlas " << job.atlas_name << " is now compressed OpenGL texture " << texture.get_gl_name();
+    }
+
+    texture_uploader& texture_manager::get_uploader() {
+        if(!uploader) {
+            uploader = std::make_unique<texture_uploader>();
+        }
+
+        return *uploader;
+    }
+
+    GLenum texture_manager::get_internal_format(int num_components) const {
+        switch(num_components) {
+            case 1:
+                return GL_R8;
+            case 2:
+                return GL_RG8;
+            case 3:
+                return use_srgb_textures ? GL_SRGB8 : GL_RGB8;
+            case 4:
+            default:
+                return use_srgb_textures ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+        }
+    }
+
+    GLsizei texture_manager::get_num_mip_levels(const glm::ivec2& dimensions) const {
+        GLsizei num_levels = 1;
+        glm::ivec2 level_size = dimensions;
+        while(num_levels <= atlas_filtering.num_mipmap_levels && level_size.x % 2 == 0 && level_size.y % 2 == 0) {
+            level_size /= 2;
+            num_levels++;
+        }
+
+        return num_levels;
+    }
+
+    /*!
+     * \brief Finds the smallest mip level whose texels still fit inside the given sprite
+     *
+     * A texel at mip level L covers a 2^L by 2^L block of the atlas, so the sprite's edges all have to be multiples of
+     * 2^L
+     */
+    static GLint get_max_mip_level_for_sprite(const mc_texture_atlas_location& location, texture2D& atlas) {
+        const int width = atlas.get_width();
+        const int height = atlas.get_height();
+        const int edges = static_cast<int>(std::round(location.min_u * width)) |
+                          static_cast<int>(std::round(location.max_u * width)) |
+                          static_cast<int>(std::round(location.min_v * height)) |
+                          static_cast<int>(std::round(location.max_v * height));
+
+        GLint max_level = 0;
+        while(max_level < 31 && (edges & (1 << max_level)) == 0) {
+            max_level++;
+        }
+
+        return max_level;
     }
 
     void texture_manager::add_texture_location(mc_texture_atlas_location &location) {
@@ -90,24 +356,148 @@ namespace nova {
                 { location.max_u, location.max_v }
         };
 
-        locations[location.name] = tex_loc;
+        sprite_locations[get_sprite_handle(location.name)] = tex_loc;
+        sprite_locations_changed = true;
+        locations_version++;
+
+        auto atlas = atlases.find(last_added_atlas);
+        if(atlas != atlases.end() && atlas->second.get_num_levels() > 1) {
+            atlas->second.limit_mip_levels(get_max_mip_level_for_sprite(location, atlas->second));
+        }
+    }
+
+
+    stitched_atlas texture_manager::stitch_sprites(const std::vector<atlas_sprite>& sprites) {
+        const auto num_threads = std::max(1u, std::thread::hardware_concurrency());
+        return stitch_atlas(sprites, 4, stitch_mip_levels, get_max_texture_size(), num_threads);
     }
 
+    void texture_manager::add_stitched_atlas(const std::string& atlas_name, stitched_atlas& atlas,
+                                             const std::vector<std::string>& sprite_names, uint64_t ticket) {
+        mc_atlas_texture texture = {};
+        texture.width = atlas.size.x;
+        texture.height = atlas.size.y;
+        texture.num_components = atlas.num_components;
+        texture.texture_data = atlas.pixels.data();
+        texture.name = atlas_name.c_str();
+        add_texture(texture, ticket);
+
+        for(size_t i = 0; i < sprite_names.size() && i < atlas.positions.size(); i++) {
+            const glm::vec2 min_uv = atlas.get_min_uv(i);
+            const glm::vec2 max_uv = atlas.get_max_uv(i);
+            mc_texture_atlas_location location = {sprite_names[i].c_str(), min_uv.x, max_uv.x, min_uv.y, max_uv.y};
+            add_texture_location(location);
+        }
+    }
 
     const texture_manager::texture_location texture_manager::get_texture_location(const std::string &texture_name) {
         // If we haven't explicitly added a texture location for this texture, let's just assume that the texture isn't
         // in an atlas and thus covers the whole (0 - 1) UV space
+        auto handle = sprite_handles.find(texture_name);
+        if(handle == sprite_handles.end()) {
+            return WHOLE_TEXTURE;
+        }
+
+        return sprite_locations[handle->second];
+    }
 
-        if(locations.find(texture_name) != locations.end()) {
-            return locations[texture_name];
+    sprite_handle texture_manager::get_sprite_handle(const std::string& sprite_name) {
+        auto handle = sprite_handles.find(sprite_name);
+        if(handle != sprite_handles.end()) {
+            return handle->second;
+        }
+
+        auto new_handle = static_cast<sprite_handle>(sprite_locations.size());
+        sprite_handles[sprite_name] = new_handle;
+        sprite_locations.push_back(WHOLE_TEXTURE);
+        sprite_locations_changed = true;
 
-        } else {
-            return {{0, 0}, {1, 1}};
+        return new_handle;
+    }
+
+    const texture_manager::texture_location& texture_manager::get_texture_location(sprite_handle handle) const {
+        if(handle >= sprite_locations.size()) {
+            return WHOLE_TEXTURE;
         }
+
+        return sprite_locations[handle];
+    }
+
+    void texture_manager::bind_sprite_locations() {
+        if(sprite_location_buffer == 0) {
+            glCreateBuffers(1, &sprite_location_buffer);
+        }
+
+        if(sprite_locations_changed && !sprite_locations.empty()) {
+            // texture_location is two vec2s, which is the same layout as the vec4 the shaders read
+            const auto size = static_cast<GLsizeiptr>(sprite_locations.size() * sizeof(texture_location));
+            if(size > sprite_location_buffer_size) {
+                sprite_location_buffer_size = std::max(size, sprite_location_buffer_size * 2);
+                glNamedBufferData(sprite_location_buffer, sprite_location_buffer_size, nullptr, GL_DYNAMIC_DRAW);
+                gpu_memory::track_buffer(sprite_location_buffer, gpu_memory_category::buffers,
+                                         sprite_location_buffer_size);
+            }
+
+            glNamedBufferSubData(sprite_location_buffer, 0, size, sprite_locations.data());
+            frame_stats::count_upload(static_cast<uint64_t>(size));
+            sprite_locations_changed = false;
+        }
+
+        if(sprite_location_buffer_size > 0) {
+            gl_state::bind_buffer_range(GL_SHADER_STORAGE_BUFFER, SPRITE_LOCATIONS_BINDING, sprite_location_buffer, 0,
+                                        sprite_location_buffer_size);
+        }
+    }
+
+    uint32_t texture_manager::get_locations_version() const {
+        return locations_version;
+    }
+
+    uint32_t texture_manager::get_contents_version() const {
+        return contents_version;
     }
 
     texture2D &texture_manager::get_texture(std::string texture_name) {
-        return atlases[texture_name];
+        return get_or_create_atlas(texture_name);
+    }
+
+    texture2D& texture_manager::get_or_create_atlas(const std::string& texture_name) {
+        auto& atlas = atlases[texture_name];
+
+        auto handle = texture_handles.find(texture_name);
+        if(handle != texture_handles.end()) {
+            handle_textures[handle->second] = &atlas;
+        }
+
+        return atlas;
+    }
+
+    texture_handle texture_manager::get_texture_handle(const std::string& texture_name) {
+        auto handle = texture_handles.find(texture_name);
+        if(handle != texture_handles.end()) {
+            return handle->second;
+        }
+
+        auto new_handle = static_cast<texture_handle>(handle_textures.size());
+        texture_handles[texture_name] = new_handle;
+
+        auto atlas = atlases.find(texture_name);
+        handle_textures.push_back(atlas != atlases.end() ? &atlas->second : nullptr);
+
+        return new_handle;
+    }
+
+    texture2D* texture_manager::get_texture(texture_handle handle) {
+        if(handle >= handle_textures.size()) {
+            return nullptr;
+        }
+
+        return handle_textures[handle];
+    }
+
+    void texture_manager::bind_texture(texture_handle handle, GLuint unit) {
+        texture2D* texture = get_texture(handle);
+        gl_state::bind_texture_unit(unit, texture != nullptr ? texture->get_gl_name() : 0);
     }
 
     int texture_manager::get_max_texture_size() {
@@ -118,4 +508,45 @@ namespace nova {
         }
         return max_texture_size;
     }
+
+    /*!
+     * \brief Turns the name of a filter from the settings into a filter, keeping the current filter if the name isn't
+     * one of point, bilinear, or trilinear
+     */
+    static texture_filtering_params::filter parse_filter(const std::string& name, texture_filtering_params::filter current) {
+        if(name == "point") {
+            return texture_filtering_params::POINT;
+        } else if(name == "bilinear") {
+            return texture_filtering_params::BILINEAR;
+        } else if(name == "trilinear") {
+            return texture_filtering_params::TRILINEAR;
+        }
+
+        LOG(WARNING) << "Unknown texture filter " << name << ", I only know point, bilinear, and trilinear";
+        return current;
+    }
+
+    void texture_manager::on_config_change(nlohmann::json& new_config) {
+        use_srgb_textures = new_config.value("srgbTextures", use_srgb_textures);
+        compress_textures = new_config.value("compressTextures", compress_textures);
+        texture_cache_directory = new_config.value("textureCacheDirectory", texture_cache_directory);
+
+        // Blocks are pixel art, so they're never blurred when they're magnified
+        atlas_filtering.texture_downsample_filter = parse_filter(new_config.value("textureFiltering", std::string("point")), atlas_filtering.texture_downsample_filter);
+        atlas_filtering.num_mipmap_levels = new_config.value("textureMipLevels", atlas_filtering.num_mipmap_levels);
+        stitch_mip_levels = atlas_filtering.num_mipmap_levels;
+        atlas_filtering.anisotropic_level = new_config.value("anisotropicFiltering", atlas_filtering.anisotropic_level);
+
+        // The mip chain is part of the textures' storage, so a new number of mip levels only shows up when the
+        // resource pack is reloaded. Filtering can change right away
+        if(glfwGetCurrentContext() != nullptr) {
+            for(auto& atlas : atlases) {
+                if(atlas.first != "lightmap") {
+                    atlas.second.set_filtering_parameters(atlas_filtering);
+                }
+            }
+        }
+    }
+
+    void texture_manager::on_config_loaded(nlohmann::json& config) {}
 }
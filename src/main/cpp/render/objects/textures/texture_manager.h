@@ -6,15 +6,40 @@
 #ifndef RENDERER_TEXTURE_RECEIVER_H
 #define RENDERER_TEXTURE_RECEIVER_H
 
+#include <atomic>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include "../../../mc_interface/mc_objects.h"
 #include "texture2D.h"
+#include "texture_uploader.h"
+#include "compressed_texture_cache.h"
+#include "atlas_stitcher.h"
 #include "../../../utils/smart_enum.h"
+#include "../../../data_loading/settings.h"
 
 namespace nova {
+    /*!
+     * \brief Names a texture without needing its string name. See texture_manager#get_texture_handle
+     */
+    typedef uint32_t texture_handle;
+
+    /*!
+     * \brief The handle of no texture at all
+     */
+    const texture_handle NO_TEXTURE = 0xFFFFFFFF;
+
+    /*!
+     * \brief Names a sprite's location in its atlas without needing its string name. See
+     * texture_manager#get_sprite_handle
+     */
+    typedef uint32_t sprite_handle;
+
     /*!
      * \brief Holds all the textures that the Nova Renderer can deal with
      *
@@ -39,9 +64,18 @@ namespace nova {
      * texture" or "I really need the entity texture". I'm going to be using texture atlases as much as possible.
      * Anyway, I'll ask the texture manager for a certain texture atlas, and the texture manager will give it back to
      * me. Then, I can bind that texture and render my pants off.
+     *
+     * Render objects don't look their textures up by name every time they're drawn, though. They get a texture_handle
+     * for each texture name when they're made, and #bind_texture turns that handle into a texture with an array
+     * lookup, and the bind goes through gl_state so it's skipped if the texture is already bound there
      */
-    class texture_manager {
+    class texture_manager : public iconfig_listener {
     public:
+        /*!
+         * \brief The SSBO binding point that the sprite locations are bound to
+         */
+        static const GLuint SPRITE_LOCATIONS_BINDING = 8;
+
         /*!
          * \brief Tells you the min/max UV coordinates of a texture in an atlas
          *
@@ -78,33 +112,98 @@ namespace nova {
         /*!
          * \brief Updates the texture with the given name with the given data
          *
-         * This method is essentially a wrapper around glTexImage2D so the docs for that will give you a lot of good info
+         * The data is copied into the upload ring and this returns right away, while the GPU copies it into the texture
+         * in the background. The texture keeps its storage as long as the size and internal format stay the same
          *
          * \param texture_name The name of the texture to update
          * \param data The data to set as the texture
          * \param size The size of the new texture data
          * \param format The format of the texture data
-         * \param internal_format The internal format of the texture data
+         * \param type The type of each component of the texture data
+         * \param internal_format The sized internal format of the texture
          */
-        void update_texture(std::string texture_name, void* data, glm::ivec2 &size, GLenum format, GLenum type = GL_FLOAT, GLenum internal_format = GL_RGBA);
+        void update_texture(std::string texture_name, void* data, glm::ivec2 &size, GLenum format, GLenum type = GL_UNSIGNED_BYTE, GLenum internal_format = GL_RGBA8);
 
         /*!
          * \brief Adds a texture to this resource manager
          *
-         * The texture is not put into an atlas immediately. Rather, it is held in a staging area until #finalize_textures
-         * is called. Then it's put into an atlas
+         * The texture's bytes are uploaded as they are, into immutable 8-bit storage. Four-component textures use
+         * GL_SRGB8_ALPHA8 if the srgbTextures setting is on, and GL_RGBA8 otherwise. If there's already a texture with
+         * the same name, it's replaced and its memory is freed
+         *
+         * The GPU then builds up to textureMipLevels mip levels for the texture, and it gets the filtering from the
+         * textureFiltering and anisotropicFiltering settings
+         *
+         * If the compressTextures setting is on, the texture is also block compressed on a worker thread: BC5 for
+         * textures whose name ends in _normal, and BC7 for other four-component textures. The uncompressed texture is
+         * used until the compressed one is ready, and the compressed one is cached in textureCacheDirectory so the
+         * same resource packs load it from disk next time
+         *
+         * The pixels are streamed through the upload ring, so this returns before the GPU has the texture. The texture
+         * data can be freed as soon as this returns
          *
          * \param new_texture The new texture
+         * \return A ticket to check with #is_texture_upload_complete
+         */
+        uint64_t add_texture(mc_atlas_texture &new_texture);
+
+        /*!
+         * \brief Adds a texture whose ticket was already handed out by #reserve_upload_ticket
+         *
+         * This is how textures from the facade get added: the ticket goes back to Minecraft right away, and the
+         * texture itself is added on the render thread later
+         */
+        void add_texture(mc_atlas_texture &new_texture, uint64_t ticket);
+
+        /*!
+         * \brief Makes a new upload ticket, which stays pending until the texture it's for is on the GPU. Can be
+         * called from any thread
+         */
+        uint64_t reserve_upload_ticket();
+
+        /*!
+         * \brief Checks if the GPU has finished copying the texture for the given ticket. Can be called from any thread
          */
-        void add_texture(mc_atlas_texture &new_texture);
+        bool is_texture_upload_complete(uint64_t ticket) const;
+
+        /*!
+         * \brief Retires any finished texture uploads and swaps in any textures that have finished compressing.
+         * Should be called once per frame
+         */
+        void update_uploads();
 
         /*!
          * \brief Adds the given texture location to the list of texture locations
          *
+         * Locations are expected right after the atlas they're in. Each one limits that atlas's mip chain so the
+         * sprite never shares a texel with its neighbors
+         *
          * \param location The location to add
          */
         void add_texture_location(mc_texture_atlas_location &location);
 
+        /*!
+         * \brief Packs a batch of sprites into a new atlas, spaced out for the number of mip levels atlases get
+         *
+         * Doesn't touch OpenGL or the texture manager's atlases, so it can be called from any thread once the render
+         * thread has started. The atlas goes to #add_stitched_atlas on the render thread afterwards
+         *
+         * \param sprites The sprites, with four components per texel
+         * \return The atlas. It isn't valid if the sprites don't fit in the biggest texture the GPU allows
+         */
+        stitched_atlas stitch_sprites(const std::vector<atlas_sprite>& sprites);
+
+        /*!
+         * \brief Adds an atlas from #stitch_sprites, and the location of each sprite in it
+         *
+         * \param atlas_name The name of the new atlas
+         * \param atlas The atlas
+         * \param sprite_names The name of each sprite, in the order they were stitched
+         * \param ticket The atlas's upload ticket, from #reserve_upload_ticket
+         */
+        void add_stitched_atlas(const std::string& atlas_name, stitched_atlas& atlas,
+                                const std::vector<std::string>& sprite_names, uint64_t ticket);
+
         /*!
          * \brief Retrieves the texture location for a texture with a specific name
          *
@@ -114,6 +213,48 @@ namespace nova {
          */
         const texture_location get_texture_location(const std::string &texture_name);
 
+        /*!
+         * \brief Gets the handle for the sprite with the given name
+         *
+         * Like texture handles, a name always gets the same handle, even before the sprite has a location and after
+         * the locations are cleared. Sprite handles count up from zero, so they're also the sprite's index in the
+         * sprite locations buffer
+         *
+         * \param sprite_name The MC resource location of the sprite
+         * \return The handle for that name
+         */
+        sprite_handle get_sprite_handle(const std::string& sprite_name);
+
+        /*!
+         * \brief Gets the location of the sprite with the given handle with an array lookup. Sprites without a location
+         * cover the whole (0 - 1) UV space
+         */
+        const texture_location& get_texture_location(sprite_handle handle) const;
+
+        /*!
+         * \brief Binds the location of every sprite to SPRITE_LOCATIONS_BINDING, uploading them first if they've
+         * changed
+         *
+         * Shaders that declare a shader storage block named `sprite_locations` at that binding find a sprite's UV
+         * rectangle with `sprite_location[handle]`, as a vec4 of the min UV and then the max UV. They can turn UVs that
+         * go from 0 to 1 across the sprite into atlas UVs with `mix(location.xy, location.zw, uv)`, so the geometry
+         * doesn't have to change when an atlas is stitched again
+         */
+        void bind_sprite_locations();
+
+        /*!
+         * \brief Changes every time texture locations are added or cleared, so anything that caches locations knows
+         * when its cache is stale
+         */
+        uint32_t get_locations_version() const;
+
+        /*!
+         * \brief Changes every time an atlas's pixels change, so anything drawn from the atlases knows when to draw
+         * again. Atlases change when they're added, when their upload finishes, and when their compressed copy
+         * replaces them
+         */
+        uint32_t get_contents_version() const;
+
         /*!
          * \brief Returns a pointer to the specified atlas
          *
@@ -122,15 +263,48 @@ namespace nova {
          */
         texture2D &get_texture(std::string texture_name);
 
+        /*!
+         * \brief Gets the handle for the texture with the given name
+         *
+         * A name always gets the same handle, even if the texture with that name is replaced or there isn't a texture
+         * with that name yet. Handles are good until the texture manager is destroyed
+         *
+         * \param texture_name The name of the texture
+         * \return The handle for that name
+         */
+        texture_handle get_texture_handle(const std::string& texture_name);
+
+        /*!
+         * \brief Gets the texture with the given handle, or nullptr if there's no texture with that handle's name
+         */
+        texture2D* get_texture(texture_handle handle);
+
+        /*!
+         * \brief Binds the texture with the given handle to the given texture unit
+         *
+         * If there's no texture with the handle's name, or the handle is NO_TEXTURE, the texture unit is cleared
+         *
+         * \param handle The texture to bind
+         * \param unit The texture unit to bind it to
+         */
+        void bind_texture(texture_handle handle, GLuint unit);
+
         /*!
          * \brief Returns the maximum texture size supported by OpenGL on the current platform
          *
          * This size is used primarily as an upper bound for the size of the texture atlases Nova uses. Nova uses OpenGL
          * 4.3, which allows for a greater texture size than the OpenGL 2.1 that the Shaders Mod uses. This allows for
          * bigger texture atlases, which in turn means I don't have to bind textures as much.
+         *
+         * The size is asked for the first time this is called and remembered after that, so later calls don't need
+         * the OpenGL context
          */
         int get_max_texture_size();
 
+        void on_config_change(nlohmann::json& new_config) override;
+
+        void on_config_loaded(nlohmann::json& config) override;
+
     private:
         std::unordered_map<std::string, texture2D> atlases;
 
@@ -138,9 +312,131 @@ namespace nova {
          * \brief A map from the name of a texture according to Minecraft and the UV coordinates it takes up in its
          * texture atlas
          */
-        std::unordered_map<std::string, texture_location> locations;
+        std::unordered_map<std::string, sprite_handle> sprite_handles;
+
+        /*!
+         * \brief The location of each sprite, by handle
+         */
+        std::vector<texture_location> sprite_locations;
+
+        /*!
+         * \brief Holds a copy of sprite_locations for shaders. Made the first time it's bound
+         */
+        GLuint sprite_location_buffer = 0;
+        GLsizeiptr sprite_location_buffer_size = 0;
+        bool sprite_locations_changed = true;
+
+        uint32_t locations_version = 0;
+
+        /*!
+         * \brief Uploads can finish on the upload thread, so this is bumped from there too
+         */
+        std::atomic<uint32_t> contents_version{0};
+
+        std::unordered_map<std::string, texture_handle> texture_handles;
+
+        /*!
+         * \brief The atlas for each texture handle, or nullptr if there's no atlas with that handle's name right now
+         *
+         * The atlases live in an unordered_map, so these pointers stay good until the atlas is erased
+         */
+        std::vector<texture2D*> handle_textures;
 
         int max_texture_size = -1;
+
+        /*!
+         * \brief If true, color atlases are stored as sRGB so the GPU linearizes them when they're sampled
+         */
+        bool use_srgb_textures = false;
+
+        /*!
+         * \brief Made the first time something's uploaded, since the texture manager is made before there's any GL
+         */
+        std::unique_ptr<texture_uploader> uploader;
+
+        /*!
+         * \brief The filtering that every atlas from #add_texture uses
+         */
+        texture_filtering_params atlas_filtering;
+
+        /*!
+         * \brief A copy of atlas_filtering's number of mip levels, for #stitch_sprites on Minecraft's threads
+         */
+        std::atomic<int> stitch_mip_levels{0};
+
+        /*!
+         * \brief The name of the atlas that the next texture locations are in
+         */
+        std::string last_added_atlas;
+
+        std::atomic<uint64_t> next_upload_ticket{1};
+
+        /*!
+         * \brief Tickets are made and checked on Minecraft's threads, but retired on the render thread
+         */
+        mutable std::mutex pending_upload_tickets_lock;
+        std::unordered_set<uint64_t> pending_upload_tickets;
+
+        void complete_upload_ticket(uint64_t ticket);
+
+        /*!
+         * \brief A texture being block compressed on a worker thread
+         */
+        struct compression_job {
+            std::string atlas_name;
+
+            /*!
+             * \brief The upload ticket of the atlas that's being compressed. If the atlas has been replaced by the time
+             * the job is done, the job is thrown away
+             */
+            uint64_t atlas_ticket;
+
+            GLenum compressed_format;
+            glm::ivec2 dimensions;
+
+            /*!
+             * \brief The compressed data for each mip level, largest first
+             */
+            std::future<std::vector<std::vector<uint8_t>>> levels;
+        };
+
+        bool compress_textures = false;
+        std::string texture_cache_directory = "texture_cache";
+        std::vector<compression_job> compression_jobs;
+
+        /*!
+         * \brief The upload ticket for the current version of each atlas
+         */
+        std::unordered_map<std::string, uint64_t> atlas_tickets;
+
+        /*!
+         * \brief Decides which block compressed format a texture should use, or returns GL_NONE if it shouldn't be
+         * compressed
+         */
+        GLenum get_compressed_format(const std::string& texture_name, int num_components) const;
+
+        void start_compression(mc_atlas_texture& new_texture, GLenum compressed_format, GLsizei num_levels, uint64_t ticket);
+
+        void finish_compression(compression_job& job);
+
+        texture_uploader& get_uploader();
+
+        GLenum get_internal_format(int num_components) const;
+
+        /*!
+         * \brief Gets the atlas with the given name, making it if it's not there, and points the name's handle at it
+         *
+         * Everything that adds an atlas should go through here so handles never point at the wrong texture
+         */
+        texture2D& get_or_create_atlas(const std::string& texture_name);
+
+        /*!
+         * \brief Decides how many mip levels a texture of the given size should have
+         *
+         * Each mip level halves the texture, so once a side can't be halved evenly anymore, texels would start to
+         * straddle the atlas's grid. The mip chain stops there, or at the textureMipLevels setting if that's sooner
+         */
+        GLsizei get_num_mip_levels(const glm::ivec2& dimensions) const;
     };
 }
 
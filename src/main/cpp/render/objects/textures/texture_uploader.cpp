@@ -0,0 +1,160 @@
+/*!
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <cstring>
+#include <easylogging++.h>
+#include "texture_uploader.h"
+#include "../frame_stats.h"
+#include "../gpu_memory.h"
+#include "../gl_state.h"
+#include "../../windowing/glfw_gl_window.h"
+
+namespace nova {
+    /*!
+     * \brief Every upload starts at a multiple of this many bytes, which covers the alignment of every pixel type
+     */
+    const GLsizeiptr UPLOAD_ALIGNMENT = 16;
+
+    texture_uploader::texture_uploader() : ring(RING_SIZE, UPLOAD_ALIGNMENT) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        glCreateBuffers(1, &buffer);
+        glNamedBufferStorage(buffer, RING_SIZE, nullptr, flags);
+        gpu_memory::track_buffer(buffer, gpu_memory_category::buffers, RING_SIZE);
+        mapped_data = static_cast<uint8_t*>(glMapNamedBufferRange(buffer, 0, RING_SIZE, flags));
+
+        if(mapped_data == nullptr) {
+            LOG(FATAL) << "Could not map the texture upload buffer";
+        }
+    }
+
+    texture_uploader::~texture_uploader() {
+        if(glfwGetCurrentContext() == nullptr) {
+            return;
+        }
+
+        for(auto& upload : in_flight_uploads) {
+            glDeleteSync(upload.fence);
+        }
+
+        glUnmapNamedBuffer(buffer);
+        gl_state::delete_buffers(1, &buffer);
+    }
+
+    void texture_uploader::upload(GLuint texture, GLsizei width, GLsizei height, GLenum format, GLenum type,
+                                  const void* pixel_data, std::function<void()> on_complete) {
+        const auto size = static_cast<GLsizeiptr>(width * height * get_bytes_per_pixel(format, type));
+
+        frame_stats::count_upload(static_cast<uint64_t>(size));
+
+        // Rows of one, two, or three byte pixels aren't necessarily four-byte aligned
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        if(size > RING_SIZE) {
+            LOG(WARNING) << "Texture upload of " << size << " bytes is bigger than the whole upload ring, so it has "
+                         << "to be uploaded synchronously";
+            glTextureSubImage2D(texture, 0, 0, 0, width, height, format, type, pixel_data);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+            if(on_complete) {
+                on_complete();
+            }
+            return;
+        }
+
+        GLsizeiptr offset = allocate(size);
+        std::memcpy(mapped_data + offset, pixel_data, static_cast<size_t>(size));
+
+        gl_state::bind_buffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+        glTextureSubImage2D(texture, 0, 0, 0, width, height, format, type, reinterpret_cast<void*>(offset));
+        gl_state::bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        in_flight_upload new_upload;
+        new_upload.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        new_upload.on_complete = std::move(on_complete);
+        in_flight_uploads.push_back(std::move(new_upload));
+    }
+
+    GLsizeiptr texture_uploader::allocate(GLsizeiptr size) {
+        uint64_t offset = 0;
+        while(!ring.allocate(static_cast<uint64_t>(size), offset)) {
+            retire_oldest_upload();
+        }
+        return static_cast<GLsizeiptr>(offset);
+    }
+
+    void texture_uploader::retire_oldest_upload() {
+        auto& oldest = in_flight_uploads.front();
+
+        GLenum status = glClientWaitSync(oldest.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        while(status == GL_TIMEOUT_EXPIRED) {
+            LOG(WARNING) << "Still waiting on a texture upload to finish";
+            status = glClientWaitSync(oldest.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        }
+
+        glDeleteSync(oldest.fence);
+        auto on_complete = std::move(oldest.on_complete);
+        in_flight_uploads.pop_front();
+        ring.free_oldest();
+
+        if(on_complete) {
+            on_complete();
+        }
+    }
+
+    void texture_uploader::update() {
+        while(!in_flight_uploads.empty()) {
+            GLenum status = glClientWaitSync(in_flight_uploads.front().fence, 0, 0);
+            if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+                break;
+            }
+
+            retire_oldest_upload();
+        }
+    }
+
+    size_t texture_uploader::get_bytes_per_pixel(GLenum format, GLenum type) {
+        switch(type) {
+            case GL_UNSIGNED_INT_8_8_8_8:
+            case GL_UNSIGNED_INT_8_8_8_8_REV:
+            case GL_UNSIGNED_INT_2_10_10_10_REV:
+                return 4;
+            default:
+                break;
+        }
+
+        size_t num_components = 4;
+        switch(format) {
+            case GL_RED:
+            case GL_RED_INTEGER:
+            case GL_DEPTH_COMPONENT:
+                num_components = 1;
+                break;
+            case GL_RG:
+            case GL_RG_INTEGER:
+                num_components = 2;
+                break;
+            case GL_RGB:
+            case GL_BGR:
+                num_components = 3;
+                break;
+            default:
+                num_components = 4;
+        }
+
+        switch(type) {
+            case GL_BYTE:
+            case GL_UNSIGNED_BYTE:
+                return num_components;
+            case GL_SHORT:
+            case GL_UNSIGNED_SHORT:
+            case GL_HALF_FLOAT:
+                return num_components * 2;
+            default:
+                return num_components * 4;
+        }
+    }
+}
@@ -0,0 +1,99 @@
+/*!
+ * \brief Streams texture data to the GPU through a persistently mapped pixel buffer
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_TEXTURE_UPLOADER_H
+#define RENDERER_TEXTURE_UPLOADER_H
+
+#include <glad/glad.h>
+#include <deque>
+#include <functional>
+#include "../../../utils/ring_allocator.h"
+
+namespace nova {
+    /*!
+     * \brief Uploads texture data without making the CPU wait for the GPU
+     *
+     * Pixels are copied into a ring buffer that's mapped for the whole life of the uploader, then glTextureSubImage2D
+     * reads them from there. Since the source is a buffer object, the driver can return right away and do the copy on
+     * its own time. Each upload gets a fence, and its space in the ring is reused once that fence has passed.
+     *
+     * The caller's memory can be reused as soon as #upload returns. If the ring is full, #upload waits for the oldest
+     * upload to finish, and anything bigger than the whole ring is uploaded straight from the caller's memory
+     */
+    class texture_uploader {
+    public:
+        /*!
+         * \brief The size, in bytes, of the ring buffer
+         */
+        static const GLsizeiptr RING_SIZE = 32 * 1024 * 1024;
+
+        texture_uploader();
+
+        texture_uploader(const texture_uploader&) = delete;
+        texture_uploader& operator=(const texture_uploader&) = delete;
+
+        ~texture_uploader();
+
+        /*!
+         * \brief Queues an upload of the given pixels to mip level 0 of the given texture
+         *
+         * \param texture The texture to upload to. It must already have storage of the given size
+         * \param width The width of the pixel data
+         * \param height The height of the pixel data
+         * \param format The format of the pixel data, like GL_RGBA
+         * \param type The type of each component, like GL_UNSIGNED_BYTE
+         * \param pixel_data The pixels, tightly packed
+         * \param on_complete Called from #update once the GPU has finished with the upload. May be empty
+         */
+        void upload(GLuint texture, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixel_data,
+                    std::function<void()> on_complete = {});
+
+        /*!
+         * \brief Frees the space used by all the uploads that the GPU has finished and calls their completion
+         * callbacks
+         *
+         * Should be called once per frame
+         */
+        void update();
+
+        /*!
+         * \brief Calculates how many bytes a pixel with the given format and type takes up
+         */
+        static size_t get_bytes_per_pixel(GLenum format, GLenum type);
+
+    private:
+        struct in_flight_upload {
+            GLsync fence;
+            std::function<void()> on_complete;
+        };
+
+        GLuint buffer = 0;
+        uint8_t* mapped_data = nullptr;
+
+        /*!
+         * \brief Which parts of the ring the uploads below are in
+         */
+        ring_allocator ring;
+
+        /*!
+         * \brief All the uploads the GPU may still be reading, oldest first, in the same order as their space in the
+         * ring
+         */
+        std::deque<in_flight_upload> in_flight_uploads;
+
+        /*!
+         * \brief Finds space for the given number of bytes, waiting on old uploads if needed
+         *
+         * \return The offset of the space in the ring
+         */
+        GLsizeiptr allocate(GLsizeiptr size);
+
+        void retire_oldest_upload();
+    };
+}
+
+#endif //RENDERER_TEXTURE_UPLOADER_H
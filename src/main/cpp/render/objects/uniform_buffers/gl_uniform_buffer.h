@@ -6,59 +6,220 @@
 #ifndef RENDERER_GL_UNIFORM_BUFFER_H
 #define RENDERER_GL_UNIFORM_BUFFER_H
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <string>
+#include <vector>
 #include <glad/glad.h>
 #include "../shaders/gl_shader_program.h"
+#include "../gl_state.h"
+#include "../gpu_memory.h"
 #include <GLFW/glfw3.h>
 
 namespace nova {
     /*!
      * \brief A nice interface for uniform buffer objects
+     *
+     * The buffer is a ring of NUM_SLICES slices, each big enough for one T, that stays mapped for the buffer's whole
+     * life. Every #send_data writes to the next slice and binds just that slice, so we never overwrite data that the
+     * GPU could still be drawing with. A fence goes down whenever we move off a slice, and we only wait on it if we
+     * come all the way around the ring before the GPU is done with that slice
+     *
+     * We keep a copy of what's in each slice. Sending the same data as last time doesn't touch the buffer at all, and
+     * otherwise only the 16 byte std140 rows that differ from what the slice already holds are copied. T has to be
+     * trivially copyable with no padding bytes, or the comparisons will see changes that aren't there
      */
     template <typename T>
     class gl_uniform_buffer {
     public:
-        gl_uniform_buffer(std::string name) : name(name) {
+        /*!
+         * \brief The number of slices in the ring. Enough for the frame being recorded plus two frames in flight
+         */
+        static const unsigned int NUM_SLICES = 3;
+
+        /*!
+         * \param name The name of the uniform block in the shaders
+         * \param binding The uniform buffer binding point that the block is bound to
+         */
+        gl_uniform_buffer(std::string name, GLuint binding) : name(name), binding(binding) {
+            GLint offset_alignment = 0;
+            glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offset_alignment);
+            offset_alignment = std::max(offset_alignment, 1);
+            slice_size = ((static_cast<GLsizeiptr>(sizeof(T)) + offset_alignment - 1) / offset_alignment) * offset_alignment;
+
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
             glCreateBuffers(1, &gl_name);
-            LOG(TRACE) << "creating ubo " << name << " with size: " << sizeof(T);
-            glNamedBufferStorage(gl_name, sizeof(T), nullptr, GL_DYNAMIC_STORAGE_BIT);
-        }
+            LOG(TRACE) << "creating ubo " << name << " with size: " << sizeof(T) << " and " << NUM_SLICES << " slices";
+            glNamedBufferStorage(gl_name, slice_size * NUM_SLICES, nullptr, flags);
+            gpu_memory::track_buffer(gl_name, gpu_memory_category::buffers, slice_size * NUM_SLICES);
+            mapped_data = static_cast<uint8_t*>(glMapNamedBufferRange(gl_name, 0, slice_size * NUM_SLICES, flags));
+            if(mapped_data == nullptr) {
+                LOG(FATAL) << "Could not map uniform buffer " << name;
+            }
 
-        gl_uniform_buffer(gl_uniform_buffer &&old) noexcept {
-            gl_name = old.gl_name;
-            name = old.name;
+            slice_fences.resize(NUM_SLICES, nullptr);
+            slice_contents.resize(NUM_SLICES);
+            slice_is_written.resize(NUM_SLICES, false);
+        }
 
+        gl_uniform_buffer(gl_uniform_buffer &&old) noexcept : gl_name(old.gl_name), name(std::move(old.name)),
+                binding(old.binding), mapped_data(old.mapped_data), slice_size(old.slice_size),
+                current_slice(old.current_slice), slice_fences(std::move(old.slice_fences)),
+                slice_contents(std::move(old.slice_contents)), slice_is_written(std::move(old.slice_is_written)) {
             old.gl_name = 0;
             old.name = "";
+            old.mapped_data = nullptr;
         }
 
+        /*!
+         * \brief Points the shader's uniform block with our name at our binding point
+         */
         void link_to_shader(const gl_shader_program &shader) {
-            auto ubo_index = glGetUniformBlockIndex(shader.gl_name, name.c_str());
-            glBindBuffer(GL_UNIFORM_BUFFER, gl_name);
-            glBindBufferBase(GL_UNIFORM_BUFFER, ubo_index, gl_name);
+            auto ubo_index = shader.get_uniform_block_index(name);
+            if(ubo_index == GL_INVALID_INDEX) {
+                return;
+            }
+
+            glUniformBlockBinding(shader.gl_name, ubo_index, binding);
         }
 
-        void send_data(T &data) {
-            LOG(TRACE) << "sending date with size: " << sizeof(T) << " to ubo " << name;
-            glNamedBufferSubData(gl_name, 0, sizeof(T), &data);
+        /*!
+         * \brief Writes the data to the next slice of the ring, and binds that slice for everything drawn after this
+         *
+         * Does nothing if the data is the same as what was sent last time, since that's still bound
+         */
+        void send_data(const T &data) {
+            if(current_slice >= 0 && std::memcmp(&slice_contents[current_slice], &data, sizeof(T)) == 0) {
+                return;
+            }
+
+            if(current_slice >= 0) {
+                // Everything that uses the slice we're moving off of has been submitted, so fence it off
+                slice_fences[current_slice] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            }
+            current_slice = (current_slice + 1) % static_cast<int>(NUM_SLICES);
+
+            wait_for_slice(current_slice);
+
+            const size_t bytes_written = write_changed_rows(current_slice, data);
+            LOG(TRACE) << "sent " << bytes_written << " of " << sizeof(T) << " bytes to ubo " << name;
+            bind();
         }
 
+        /*!
+         * \brief Binds the slice that was last written to our binding point
+         */
         void bind() {
-            glBindBuffer(GL_UNIFORM_BUFFER, gl_name);
+            if(current_slice < 0) {
+                return;
+            }
+
+            gl_state::bind_buffer_range(GL_UNIFORM_BUFFER, binding, gl_name, current_slice * slice_size, sizeof(T));
         }
 
         /*!
          * \brief Deallocates this uniform buffer
          */
         ~gl_uniform_buffer() {
-            if(glfwGetCurrentContext() != NULL) {
-                glDeleteBuffers(1, &gl_name);
+            if(gl_name == 0 || glfwGetCurrentContext() == NULL) {
+                return;
             }
+
+            for(GLsync fence : slice_fences) {
+                if(fence != nullptr) {
+                    glDeleteSync(fence);
+                }
+            }
+
+            glUnmapNamedBuffer(gl_name);
+            gl_state::delete_buffers(1, &gl_name);
         }
 
     private:
-        GLuint gl_name;
+        GLuint gl_name = 0;
         std::string name;
+        GLuint binding = 0;
+
+        uint8_t* mapped_data = nullptr;
+        GLsizeiptr slice_size = 0;
+
+        /*!
+         * \brief The slice that was last written, or -1 if nothing has been written yet
+         */
+        int current_slice = -1;
+
+        /*!
+         * \brief The fence for each slice's last use, or nullptr for slices the GPU isn't using
+         */
+        std::vector<GLsync> slice_fences;
+
+        /*!
+         * \brief What each slice holds, so we know which parts of it need to change
+         */
+        std::vector<T> slice_contents;
+        std::vector<bool> slice_is_written;
+
+        /*!
+         * \brief Copies the rows of the data that are different from what's in the slice
+         *
+         * Runs of changed rows are copied with one memcpy
+         *
+         * \return The number of bytes that were copied
+         */
+        size_t write_changed_rows(int slice, const T& data) {
+            static const size_t ROW_SIZE = 16;
+
+            const auto* source = reinterpret_cast<const uint8_t*>(&data);
+            const auto* old_contents = reinterpret_cast<const uint8_t*>(&slice_contents[slice]);
+            uint8_t* destination = mapped_data + slice * slice_size;
+
+            if(!slice_is_written[slice]) {
+                // Nothing's been put in the slice yet, so none of it can be kept
+                std::memcpy(destination, source, sizeof(T));
+                slice_contents[slice] = data;
+                slice_is_written[slice] = true;
+                return sizeof(T);
+            }
+
+            size_t bytes_written = 0;
+            size_t run_start = 0;
+            bool in_run = false;
+            for(size_t row_start = 0; row_start < sizeof(T) + ROW_SIZE; row_start += ROW_SIZE) {
+                const size_t row_size = std::min(ROW_SIZE, sizeof(T) - std::min(row_start, sizeof(T)));
+                const bool row_changed = row_size > 0 && std::memcmp(source + row_start, old_contents + row_start, row_size) != 0;
+
+                if(row_changed && !in_run) {
+                    run_start = row_start;
+                    in_run = true;
+
+                } else if(!row_changed && in_run) {
+                    const size_t run_end = std::min(row_start, sizeof(T));
+                    std::memcpy(destination + run_start, source + run_start, run_end - run_start);
+                    bytes_written += run_end - run_start;
+                    in_run = false;
+                }
+            }
+
+            slice_contents[slice] = data;
+            return bytes_written;
+        }
+
+        void wait_for_slice(int slice) {
+            GLsync& fence = slice_fences[slice];
+            if(fence == nullptr) {
+                return;
+            }
+
+            GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+            while(status == GL_TIMEOUT_EXPIRED) {
+                LOG(WARNING) << "Still waiting on the GPU to finish with a slice of uniform buffer " << name;
+                status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+            }
+
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
     };
 }
 
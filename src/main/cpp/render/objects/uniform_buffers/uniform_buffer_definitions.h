@@ -37,22 +37,26 @@ namespace nova {
         glm::mat4 shadowModelView;
         glm::mat4 shadowModelViewInverse;
         glm::vec4 entityColor;
+
+        // std140 puts every vec3 on a 16 byte boundary, so each one is followed by a float that fills out its last
+        // four bytes. The per_frame_uniforms block in the shaders has to declare its members in this same order
         glm::vec3 fogColor;
-        float padding1; // needed to fit the GLSL std140 alignment rules. A future version will pack the data here more efficiently
+        GLfloat frameTimeCounter;
         glm::vec3 skyColor;
-        float padding2;
+        GLfloat sunAngle;
         glm::vec3 sunPosition;
-        float padding3;
+        GLfloat shadowAngle;
         glm::vec3 moonPosition;
-        float padding4;
+        GLfloat rainStrength;
         glm::vec3 shadowLightPosition;
-        float padding5;
+        GLfloat aspectRatio;
         glm::vec3 upPosition;
-        float padding6;
+        GLfloat viewWidth;
         glm::vec3 cameraPosition;
-        float padding7;
+        GLfloat viewHeight;
         glm::vec3 previousCameraPosition;
-        float padding8;
+        GLfloat nearPlane;  // near in the shaders. Re-named because GCC was yelling about "This line does not declare anything", like it's some great authority on declaring things
+
         glm::ivec2 eyeBrightness;
         glm::ivec2 eyeBrightnessSmooth;
         glm::ivec2 terrainTextureSize;
@@ -69,20 +73,73 @@ namespace nova {
         GLint hideGUI;
         GLint entityId;
         GLint blockEntityId;
-        GLfloat frameTimeCounter;
-        GLfloat sunAngle;
-        GLfloat shadowAngle;
-        GLfloat rainStrength;
-        GLfloat aspectRatio;
-        GLfloat viewWidth;
-        GLfloat viewHeight;
-        GLfloat nearPlane;  // near in the shaders. Re-named because GCC was yelling about "This line does not declare anything", like it's some great authority on declaring things
         GLfloat farPlane;   // far in the shaders
         GLfloat wetness;
         GLfloat eyeAltitude;
         GLfloat centerDepthSmooth;
+
+        // How much of each gbuffer and composite attachment was drawn to, from dynamic resolution. Fullscreen passes
+        // multiply their texture coordinates by this to read the part that was drawn
+        GLfloat renderScale;
+
+        // Counts up by one each frame and wraps at 720720, so effects can be spread over a few frames
+        GLint frameCounter;
+
+        // How far the gbuffer projection is moved this frame for temporal antialiasing, in pixels. The previous
+        // matrices are the ones last frame was drawn with, jitter and all
+        glm::vec2 temporalJitter;
+    };
+
+    static_assert(sizeof(per_frame_uniforms) == 896, "per_frame_uniforms has to match the std140 layout of the block in the shaders");
+
+    /*!
+     * \brief The matrices for each cascade of the shadow map, in the shadow_cascades block
+     *
+     * The cascades are laid out in a 2x2 grid in shadowtex0. The shadow shader draws with
+     * shadowCascadeViewProjection[shadowCascade], where shadowCascade is a plain int uniform that's set before each
+     * cascade is drawn. Other shaders pick the first cascade whose split is farther than the pixel, and look it up in
+     * the shadow map with shadowCascadeTexture[cascade], which gives the texture coordinate in xy and the depth in z
+     */
+    struct shadow_cascade_uniforms {
+        glm::mat4 shadowCascadeViewProjection[4];
+        glm::mat4 shadowCascadeTexture[4];
+
+        /*!
+         * \brief How far from the camera each cascade reaches
+         */
+        glm::vec4 shadowCascadeSplits;
     };
 
+    static_assert(sizeof(shadow_cascade_uniforms) == 528, "shadow_cascade_uniforms has to match the std140 layout of the block in the shaders");
+
+    /*!
+     * \brief What the sky, cloud, and weather shaders build their geometry from, in the sky_parameters block
+     *
+     * None of those passes have any vertex data. Their vertex shaders make everything from gl_VertexID and
+     * gl_InstanceID, so this block is the only thing the CPU sends them each frame
+     */
+    struct sky_uniforms {
+        /*!
+         * \brief How far the clouds have drifted along x and z, in blocks. It wraps every cloudPatternCells cells, so
+         * it never gets big enough to lose precision
+         */
+        glm::vec2 cloudOffset;
+        GLfloat cloudHeight;
+        GLfloat cloudCellSize;          //!< How many blocks wide each cell of the cloud pattern is
+
+        GLfloat skyTime;                //!< The world time in ticks, wrapped to a day
+        GLfloat weatherStrength;        //!< How hard it's raining or snowing, from 0 to 1
+        GLfloat snowStrength;           //!< 1 where it's snowing instead of raining
+        GLfloat weatherRadius;          //!< How far from the camera rain and snow are drawn
+
+        GLfloat cloudCoverage;          //!< How much of the sky the clouds cover, from 0 to 1
+        GLint cloudGridSize;            //!< How many cloud cells wide the square of clouds around the camera is
+        GLint cloudPatternCells;        //!< How many cells it takes for the cloud pattern to repeat
+        GLint weatherParticleCount;     //!< How many raindrops or snowflakes are drawn this frame
+    };
+
+    static_assert(sizeof(sky_uniforms) == 48, "sky_uniforms has to match the std140 layout of the block in the shaders");
+
     /*!
      * \brief Holds all the uniform variables that are specific to shadow passes
      */
@@ -11,12 +11,14 @@
 #include "uniform_buffer_store.h"
 
 namespace nova {
-    uniform_buffer_store::uniform_buffer_store() : per_frame_uniforms_buffer("per_frame_uniforms") {
+    uniform_buffer_store::uniform_buffer_store() : per_frame_uniforms_buffer("per_frame_uniforms", PER_FRAME_UNIFORMS_BINDING),
+            shadow_cascade_uniforms_buffer("shadow_cascades", SHADOW_CASCADE_UNIFORMS_BINDING),
+            sky_uniforms_buffer("sky_parameters", SKY_UNIFORMS_BINDING) {
 		LOG(INFO) << "Initialized uniform buffer store";
     }
 
     void uniform_buffer_store::update() {
-        update_per_frame_uniforms(nova_renderer::get_render_settings().get_options());
+        update_per_frame_uniforms(nova_renderer::get_render_settings().get_snapshot());
     }
 
     void uniform_buffer_store::on_config_change(nlohmann::json &new_config) {
@@ -24,19 +26,21 @@ namespace nova {
 
         // We'll probably also want to update the per frame uniforms so that we have the correct aspect ratio and
         // whatnot
-        update_per_frame_uniforms(new_config);
+        update_per_frame_uniforms(nova_renderer::get_render_settings().get_snapshot());
     }
 
     void uniform_buffer_store::on_config_loaded(nlohmann::json &config) {}
 
     void uniform_buffer_store::register_all_buffers_with_shader(const gl_shader_program &shader) noexcept {
         per_frame_uniforms_buffer.link_to_shader(shader);
+        shadow_cascade_uniforms_buffer.link_to_shader(shader);
+        sky_uniforms_buffer.link_to_shader(shader);
     }
 
-    void uniform_buffer_store::update_per_frame_uniforms(nlohmann::json &config) {
-		float view_width = config["viewWidth"];
-		float view_height = config["viewHeight"];
-        float scalefactor = config["scalefactor"];
+    void uniform_buffer_store::update_per_frame_uniforms(const settings_snapshot &config) {
+		float view_width = config.view_width;
+		float view_height = config.view_height;
+        float scalefactor = config.scalefactor;
         // The GUI matrix is super simple, just a viewport transformation
         glm::mat4 gui_model_view(1.0f);
         gui_model_view = glm::translate(gui_model_view, glm::vec3(-1.0f, 1.0f, 0.0f));
@@ -44,8 +48,6 @@ namespace nova {
         gui_model_view = glm::scale(gui_model_view, glm::vec3(1.0 / view_width, 1.0 / view_height, 1.0));
         gui_model_view = glm::scale(gui_model_view, glm::vec3(1.0f, -1.0f, 1.0f));
 
-        per_frame_uniform_variables.gbufferModelView = glm::mat4(1);
-        per_frame_uniform_variables.gbufferProjection = glm::mat4(1);
         per_frame_uniform_variables.aspectRatio = view_width / view_height;
         per_frame_uniform_variables.viewHeight = view_height;
         per_frame_uniform_variables.viewWidth = view_width;
@@ -59,5 +61,16 @@ namespace nova {
     gl_uniform_buffer<per_frame_uniforms>& uniform_buffer_store::get_per_frame_uniforms() {
         return per_frame_uniforms_buffer;
     }
-}
 
+    per_frame_uniforms& uniform_buffer_store::get_per_frame_uniform_variables() {
+        return per_frame_uniform_variables;
+    }
+
+    gl_uniform_buffer<shadow_cascade_uniforms>& uniform_buffer_store::get_shadow_cascade_uniforms() {
+        return shadow_cascade_uniforms_buffer;
+    }
+
+    gl_uniform_buffer<sky_uniforms>& uniform_buffer_store::get_sky_uniforms() {
+        return sky_uniforms_buffer;
+    }
+}
@@ -44,14 +44,43 @@ namespace nova {
 
         virtual void on_config_loaded(nlohmann::json &config);
 
+        /*!
+         * \brief The uniform buffer binding point that per_frame_uniforms is bound to
+         */
+        static const GLuint PER_FRAME_UNIFORMS_BINDING = 0;
+
         gl_uniform_buffer<per_frame_uniforms>& get_per_frame_uniforms();
 
+        /*!
+         * \brief The values that go in the per-frame uniform buffer. Change what you need, then send them with
+         * get_per_frame_uniforms().send_data
+         */
+        per_frame_uniforms& get_per_frame_uniform_variables();
+
+        /*!
+         * \brief The uniform buffer binding point that shadow_cascade_uniforms is bound to
+         */
+        static const GLuint SHADOW_CASCADE_UNIFORMS_BINDING = 1;
+
+        gl_uniform_buffer<shadow_cascade_uniforms>& get_shadow_cascade_uniforms();
+
+        /*!
+         * \brief The uniform buffer binding point that sky_uniforms is bound to
+         */
+        static const GLuint SKY_UNIFORMS_BINDING = 2;
+
+        gl_uniform_buffer<sky_uniforms>& get_sky_uniforms();
+
     private:
-        per_frame_uniforms per_frame_uniform_variables;
+        per_frame_uniforms per_frame_uniform_variables = {};
 
         gl_uniform_buffer<per_frame_uniforms> per_frame_uniforms_buffer;
 
-        void update_per_frame_uniforms(nlohmann::json &config);
+        gl_uniform_buffer<shadow_cascade_uniforms> shadow_cascade_uniforms_buffer;
+
+        gl_uniform_buffer<sky_uniforms> sky_uniforms_buffer;
+
+        void update_per_frame_uniforms(const settings_snapshot &config);
     };
 }
 
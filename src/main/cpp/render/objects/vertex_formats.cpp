@@ -0,0 +1,29 @@
+/*!
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include "vertex_formats.h"
+#include "../../geometry_cache/greedy_mesher.h"
+
+namespace nova {
+    static_assert(tiled_block_layout::ints_per_vertex == TILED_VERTEX_SIZE, "tiled_block_vertex has to match the native mesher's vertices");
+
+    GLsizei get_vertex_stride(format vertex_format) {
+        return visit_vertex_layout(vertex_format, [](auto layout) {
+            return decltype(layout)::stride;
+        });
+    }
+
+    uint32_t get_vertex_location_mask(format vertex_format) {
+        return visit_vertex_layout(vertex_format, [](auto layout) {
+            return decltype(layout)::location_mask;
+        });
+    }
+
+    void set_vertex_attributes(GLuint vao, format vertex_format, GLuint binding) {
+        visit_vertex_layout(vertex_format, [&](auto layout) {
+            decltype(layout)::set_attributes(vao, binding);
+        });
+    }
+}
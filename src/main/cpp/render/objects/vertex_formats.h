@@ -0,0 +1,313 @@
+/*!
+ * \brief Describes every vertex format once, at compile time, so the VAO setup, the strides, and the conversions
+ * between formats all come from the same place
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#ifndef RENDERER_VERTEX_FORMATS_H
+#define RENDERER_VERTEX_FORMATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <vector>
+#include <glad/glad.h>
+#include "../../geometry_cache/mesh_definition.h"
+#include "../../geometry_cache/vertex_packing.h"
+
+namespace nova {
+    /*!
+     * \brief The attribute locations the shaders read each kind of vertex data from. Every format puts the same kind
+     * of data at the same location, so a shader works with any format that has the inputs it reads
+     */
+    const GLuint POSITION_LOCATION = 0;
+    const GLuint UV_LOCATION = 1;
+    const GLuint LIGHTMAP_UV_LOCATION = 2;
+    const GLuint NORMAL_LOCATION = 3;
+    const GLuint TANGENT_LOCATION = 4;
+    const GLuint COLOR_LOCATION = 5;
+    const GLuint TILE_LOCATION = 6;
+
+    /*!
+     * \brief The size, in bytes, of one component of the given GL type
+     */
+    constexpr GLuint get_component_size(GLenum type) {
+        return type == GL_BYTE || type == GL_UNSIGNED_BYTE ? 1
+             : type == GL_SHORT || type == GL_UNSIGNED_SHORT ? 2
+             : type == GL_FLOAT || type == GL_INT || type == GL_UNSIGNED_INT ? 4
+             : 0;
+    }
+
+    /*!
+     * \brief One vertex attribute: where the shader reads it, how many components it has, what type they are, and
+     * where in the vertex it starts
+     */
+    template <GLuint Location, GLint Components, GLenum Type, GLboolean Normalized, size_t Offset>
+    struct vertex_attribute {
+        static const GLuint location = Location;
+        static const GLint components = Components;
+        static const GLenum type = Type;
+        static const GLboolean normalized = Normalized;
+        static const GLuint offset = static_cast<GLuint>(Offset);
+        static const GLuint size = Components * get_component_size(Type);
+
+        static_assert(get_component_size(Type) > 0, "Vertex attributes can only be bytes, shorts, ints, or floats");
+        static_assert(Components >= 1 && Components <= 4, "Vertex attributes have between one and four components");
+        static_assert(Offset % get_component_size(Type) == 0, "Vertex attributes have to be aligned to their component size");
+
+        static void enable(GLuint vao, GLuint binding) {
+            glEnableVertexArrayAttrib(vao, location);
+            glVertexArrayAttribFormat(vao, location, components, type, normalized, offset);
+            glVertexArrayAttribBinding(vao, location, binding);
+        }
+    };
+
+    constexpr bool attributes_fit_in(size_t stride, std::initializer_list<GLuint> attribute_ends) {
+        for(GLuint end : attribute_ends) {
+            if(end > stride) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    constexpr bool locations_are_unique(std::initializer_list<GLuint> locations) {
+        uint32_t seen = 0;
+        for(GLuint location : locations) {
+            if(location >= 32 || (seen & (1u << location)) != 0) {
+                return false;
+            }
+            seen |= 1u << location;
+        }
+        return true;
+    }
+
+    constexpr uint32_t get_location_mask(std::initializer_list<GLuint> locations) {
+        uint32_t mask = 0;
+        for(GLuint location : locations) {
+            mask |= 1u << location;
+        }
+        return mask;
+    }
+
+    /*!
+     * \brief A vertex format: the struct one vertex is stored as, and the attributes the shaders read out of it
+     *
+     * Everything about the layout is checked when it's compiled: every attribute has to fit inside the vertex, be
+     * aligned to its component size, and have a location of its own
+     */
+    template <typename Vertex, typename... Attributes>
+    struct vertex_layout {
+        using vertex = Vertex;
+
+        static const GLsizei stride = sizeof(Vertex);
+
+        /*!
+         * \brief The attribute locations this format fills in, one bit per location
+         */
+        static const uint32_t location_mask = get_location_mask({Attributes::location...});
+
+        static_assert(sizeof(Vertex) % sizeof(int) == 0, "Vertices are sent to us as ints, so they have to be a whole number of them");
+        static_assert(attributes_fit_in(sizeof(Vertex), {(Attributes::offset + Attributes::size)...}), "A vertex attribute runs past the end of the vertex");
+        static_assert(locations_are_unique({Attributes::location...}), "Two vertex attributes share a location");
+
+        /*!
+         * \brief The number of ints in one vertex
+         */
+        static const size_t ints_per_vertex = sizeof(Vertex) / sizeof(int);
+
+        /*!
+         * \brief Enables and describes every attribute on the VAO, reading them from the given buffer binding
+         */
+        static void set_attributes(GLuint vao, GLuint binding) {
+            const int expand[] = {0, (Attributes::enable(vao, binding), 0)...};
+            (void) expand;
+        }
+    };
+
+    /*!
+     * \brief A position, three floats
+     */
+    struct pos_vertex {
+        GLfloat position[3];
+    };
+
+    struct pos_uv_vertex {
+        GLfloat position[3];
+        GLfloat uv[2];
+    };
+
+    struct pos_uv_color_vertex {
+        GLfloat position[3];
+        GLfloat uv[2];
+        GLfloat color[4];
+    };
+
+    /*!
+     * \brief A block vertex as Minecraft sends it: position relative to the chunk, RGBA8 color, UV, and the lightmap
+     * coordinate as two shorts
+     */
+    struct mc_block_vertex {
+        GLfloat position[3];
+        uint8_t color[4];
+        GLfloat uv[2];
+        int16_t lightmap_uv[2];
+    };
+
+    /*!
+     * \brief A Minecraft block vertex with room for the normal and tangent, which we don't compute yet
+     */
+    struct block_vertex {
+        GLfloat position[3];
+        uint8_t color[4];
+        GLfloat uv[2];
+        int16_t lightmap_uv[2];
+        GLfloat normal[3];
+        GLfloat tangent[3];
+    };
+
+    /*!
+     * \brief A vertex made by the native chunk mesher. The UV counts texture tiles, and tile is the tile's rect in
+     * the atlas, so the shader can repeat it across a merged face
+     */
+    struct tiled_block_vertex {
+        GLfloat position[3];
+        uint8_t color[4];
+        GLfloat uv[2];
+        int16_t lightmap_uv[2];
+        GLfloat normal[3];
+        GLfloat tile[4];
+    };
+
+    using pos_layout = vertex_layout<pos_vertex,
+        vertex_attribute<POSITION_LOCATION,     3, GL_FLOAT, GL_FALSE, offsetof(pos_vertex, position)>>;
+
+    using pos_uv_layout = vertex_layout<pos_uv_vertex,
+        vertex_attribute<POSITION_LOCATION,     3, GL_FLOAT, GL_FALSE, offsetof(pos_uv_vertex, position)>,
+        vertex_attribute<UV_LOCATION,           2, GL_FLOAT, GL_FALSE, offsetof(pos_uv_vertex, uv)>>;
+
+    /*!
+     * \brief The GUI's format. Its color goes to the location block formats use for the lightmap, which the GUI
+     * shaders read it from
+     */
+    using pos_uv_color_layout = vertex_layout<pos_uv_color_vertex,
+        vertex_attribute<POSITION_LOCATION,     3, GL_FLOAT, GL_FALSE, offsetof(pos_uv_color_vertex, position)>,
+        vertex_attribute<UV_LOCATION,           2, GL_FLOAT, GL_FALSE, offsetof(pos_uv_color_vertex, uv)>,
+        vertex_attribute<LIGHTMAP_UV_LOCATION,  4, GL_FLOAT, GL_FALSE, offsetof(pos_uv_color_vertex, color)>>;
+
+    /*!
+     * \brief Minecraft's own block format. Nothing is drawn in it, it's only converted to the other block formats
+     */
+    using mc_block_layout = vertex_layout<mc_block_vertex,
+        vertex_attribute<POSITION_LOCATION,     3, GL_FLOAT,          GL_FALSE, offsetof(mc_block_vertex, position)>,
+        vertex_attribute<COLOR_LOCATION,        4, GL_UNSIGNED_BYTE,  GL_FALSE, offsetof(mc_block_vertex, color)>,
+        vertex_attribute<UV_LOCATION,           2, GL_FLOAT,          GL_FALSE, offsetof(mc_block_vertex, uv)>,
+        vertex_attribute<LIGHTMAP_UV_LOCATION,  2, GL_SHORT,          GL_FALSE, offsetof(mc_block_vertex, lightmap_uv)>>;
+
+    using block_layout = vertex_layout<block_vertex,
+        vertex_attribute<POSITION_LOCATION,     3, GL_FLOAT,          GL_FALSE, offsetof(block_vertex, position)>,
+        vertex_attribute<COLOR_LOCATION,        4, GL_UNSIGNED_BYTE,  GL_FALSE, offsetof(block_vertex, color)>,
+        vertex_attribute<UV_LOCATION,           2, GL_FLOAT,          GL_FALSE, offsetof(block_vertex, uv)>,
+        vertex_attribute<LIGHTMAP_UV_LOCATION,  2, GL_SHORT,          GL_FALSE, offsetof(block_vertex, lightmap_uv)>,
+        vertex_attribute<NORMAL_LOCATION,       3, GL_FLOAT,          GL_FALSE, offsetof(block_vertex, normal)>,
+        vertex_attribute<TANGENT_LOCATION,      3, GL_FLOAT,          GL_FALSE, offsetof(block_vertex, tangent)>>;
+
+    /*!
+     * \brief The position is fixed point, and the shader scales it back to blocks
+     */
+    using packed_block_layout = vertex_layout<packed_chunk_vertex,
+        vertex_attribute<POSITION_LOCATION,     3, GL_SHORT,          GL_FALSE, offsetof(packed_chunk_vertex, position)>,
+        vertex_attribute<COLOR_LOCATION,        4, GL_UNSIGNED_BYTE,  GL_FALSE, offsetof(packed_chunk_vertex, color)>,
+        vertex_attribute<UV_LOCATION,           2, GL_UNSIGNED_SHORT, GL_TRUE,  offsetof(packed_chunk_vertex, uv)>,
+        vertex_attribute<NORMAL_LOCATION,       2, GL_BYTE,           GL_TRUE,  offsetof(packed_chunk_vertex, normal)>,
+        vertex_attribute<TANGENT_LOCATION,      2, GL_BYTE,           GL_TRUE,  offsetof(packed_chunk_vertex, tangent)>,
+        vertex_attribute<LIGHTMAP_UV_LOCATION,  2, GL_UNSIGNED_BYTE,  GL_FALSE, offsetof(packed_chunk_vertex, lightmap)>>;
+
+    using tiled_block_layout = vertex_layout<tiled_block_vertex,
+        vertex_attribute<POSITION_LOCATION,     3, GL_FLOAT,          GL_FALSE, offsetof(tiled_block_vertex, position)>,
+        vertex_attribute<COLOR_LOCATION,        4, GL_UNSIGNED_BYTE,  GL_FALSE, offsetof(tiled_block_vertex, color)>,
+        vertex_attribute<UV_LOCATION,           2, GL_FLOAT,          GL_FALSE, offsetof(tiled_block_vertex, uv)>,
+        vertex_attribute<LIGHTMAP_UV_LOCATION,  2, GL_SHORT,          GL_FALSE, offsetof(tiled_block_vertex, lightmap_uv)>,
+        vertex_attribute<NORMAL_LOCATION,       3, GL_FLOAT,          GL_FALSE, offsetof(tiled_block_vertex, normal)>,
+        vertex_attribute<TILE_LOCATION,         4, GL_FLOAT,          GL_FALSE, offsetof(tiled_block_vertex, tile)>>;
+
+    static_assert(block_layout::ints_per_vertex == 13, "The Java side sends 13-int block vertices");
+    static_assert(mc_block_layout::ints_per_vertex == 7, "Minecraft's block vertices are 7 ints");
+
+    /*!
+     * \brief Calls the given function with a default-constructed value of the layout type for the given format
+     *
+     * The one place a runtime format becomes a compile-time layout. The function is usually a generic lambda that
+     * gets the layout with decltype
+     */
+    template <typename Function>
+    auto visit_vertex_layout(format vertex_format, Function&& function) -> decltype(function(pos_layout{})) {
+        switch(vertex_format) {
+            case format::POS:
+                return function(pos_layout{});
+            case format::POS_UV:
+                return function(pos_uv_layout{});
+            case format::POS_UV_COLOR:
+                return function(pos_uv_color_layout{});
+            case format::PACKED_POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT:
+                return function(packed_block_layout{});
+            case format::TILED_POS_COLOR_UV_LIGHTMAPUV_NORMAL_TILE:
+                return function(tiled_block_layout{});
+            case format::POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT:
+            default:
+                return function(block_layout{});
+        }
+    }
+
+    /*!
+     * \brief The number of bytes between the starts of two vertices in the given format
+     */
+    GLsizei get_vertex_stride(format vertex_format);
+
+    /*!
+     * \brief The attribute locations the given format fills in, one bit per location
+     */
+    uint32_t get_vertex_location_mask(format vertex_format);
+
+    /*!
+     * \brief Enables and describes every attribute of the given format on the VAO, reading them from the given
+     * buffer binding
+     */
+    void set_vertex_attributes(GLuint vao, format vertex_format, GLuint binding);
+
+    /*!
+     * \brief Copies vertices into a wider format that starts with the same bytes, leaving the rest of each vertex 0
+     *
+     * Both strides are known when this is compiled, so the copy for each vertex is a fixed size that the compiler
+     * turns into a few vector moves, rather than a call to memcpy or an insert that checks the capacity every time
+     *
+     * \param source The vertices to widen. Any trailing ints that don't make up a whole vertex are copied as-is
+     * \param destination The widened vertices are appended to this
+     */
+    template <typename From, typename To>
+    void widen_vertices(const std::vector<int>& source, std::vector<int>& destination) {
+        static_assert(From::stride <= To::stride, "Vertices can only be widened into a format at least as big");
+
+        const size_t num_vertices = source.size() / From::ints_per_vertex;
+        const size_t num_trailing = source.size() % From::ints_per_vertex;
+        const size_t first = destination.size();
+        destination.resize(first + num_vertices * To::ints_per_vertex + num_trailing);
+
+        const int* in = source.data();
+        int* out = destination.data() + first;
+        for(size_t i = 0; i < num_vertices; i++) {
+            std::memcpy(out, in, sizeof(typename From::vertex));
+            in += From::ints_per_vertex;
+            out += To::ints_per_vertex;
+        }
+
+        if(num_trailing > 0) {
+            std::memcpy(out, in, num_trailing * sizeof(int));
+        }
+    }
+}
+
+#endif //RENDERER_VERTEX_FORMATS_H
@@ -0,0 +1,83 @@
+/*!
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <easylogging++.h>
+#include "render_thread.h"
+#include "windowing/glfw_gl_window.h"
+
+namespace nova {
+    render_thread::render_thread(glfw_gl_window& window) : window(window) {
+        // A context can only be current on one thread at a time
+        window.release_context();
+        thread = std::thread(&render_thread::run_commands, this);
+        LOG(INFO) << "Started the render thread";
+    }
+
+    render_thread::~render_thread() {
+        should_stop = true;
+        wake();
+        thread.join();
+
+        window.make_context_current();
+        LOG(INFO) << "Stopped the render thread";
+    }
+
+    void render_thread::push(std::function<void()> command) {
+        commands.push(std::move(command));
+        wake();
+    }
+
+    void render_thread::push_frame(std::function<void()> frame) {
+        {
+            std::unique_lock<std::mutex> lock(frames_in_flight_lock);
+            frame_finished.wait(lock, [this]() { return num_frames_in_flight < MAX_FRAMES_IN_FLIGHT; });
+            num_frames_in_flight++;
+        }
+
+        push([this, frame]() {
+            frame();
+
+            {
+                std::lock_guard<std::mutex> lock(frames_in_flight_lock);
+                num_frames_in_flight--;
+            }
+            frame_finished.notify_all();
+        });
+    }
+
+    void render_thread::run_commands() {
+        window.make_context_current();
+
+        std::function<void()> command;
+        while(true) {
+            while(commands.try_pop(command)) {
+                command();
+                command = nullptr;
+            }
+
+            if(should_stop) {
+                // Anything pushed before we were told to stop still gets to run
+                while(commands.try_pop(command)) {
+                    command();
+                }
+                break;
+            }
+
+            std::unique_lock<std::mutex> lock(wake_lock);
+            wake_up.wait(lock, [this]() { return !commands.is_empty() || should_stop; });
+        }
+
+        window.release_context();
+    }
+
+    void render_thread::wake() {
+        // Taking the lock means the render thread is either asleep or hasn't checked for commands yet, so it can't
+        // miss the notification
+        {
+            std::lock_guard<std::mutex> lock(wake_lock);
+        }
+        wake_up.notify_one();
+    }
+}
@@ -0,0 +1,105 @@
+/*!
+ * \brief The thread that owns the OpenGL context and does everything Minecraft asks of the renderer
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_RENDER_THREAD_H
+#define RENDERER_RENDER_THREAD_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "../utils/mpsc_queue.h"
+
+namespace nova {
+    class glfw_gl_window;
+
+    /*!
+     * \brief Runs commands on a thread that has the window's OpenGL context
+     *
+     * Minecraft calls into Nova from whatever thread it likes. Instead of touching GL on those threads, the facade
+     * copies whatever it needs and pushes a command here. Pushing is lock-free, so Minecraft never waits on the driver.
+     * The one exception is frames: #push_frame waits while the last frame is still queued or rendering, so Minecraft
+     * can work on its next tick while we render, but can't get more than a frame ahead of us
+     *
+     * Commands run in the order they're pushed. The context moves to this thread when it's made and goes back to the
+     * thread that made it when it's destroyed, so the window has to be made and destroyed on the same thread
+     */
+    class render_thread {
+    public:
+        /*!
+         * \brief How many frames can be queued or rendering at once. One is enough for Minecraft's next tick to
+         * overlap with the frame we're rendering
+         */
+        static const unsigned int MAX_FRAMES_IN_FLIGHT = 1;
+
+        /*!
+         * \brief Takes the window's context from the calling thread and starts the render thread with it
+         */
+        explicit render_thread(glfw_gl_window& window);
+
+        render_thread(const render_thread&) = delete;
+        render_thread& operator=(const render_thread&) = delete;
+
+        /*!
+         * \brief Runs all the commands that are already queued, stops the render thread, and gives the context back
+         * to the calling thread
+         */
+        ~render_thread();
+
+        /*!
+         * \brief Queues up a command to run on the render thread. Can be called from any thread
+         *
+         * The command runs after this returns, so it has to own copies of everything it uses
+         */
+        void push(std::function<void()> command);
+
+        /*!
+         * \brief Queues up a frame, waiting first if there are already MAX_FRAMES_IN_FLIGHT frames that aren't done
+         */
+        void push_frame(std::function<void()> frame);
+
+        /*!
+         * \brief Runs a command on the render thread and waits for its result
+         *
+         * Only for things that need an answer right away, since it waits for everything queued before it
+         */
+        template <typename Func>
+        auto run_and_wait(Func command) -> decltype(command()) {
+            using result_type = decltype(command());
+            auto task = std::make_shared<std::packaged_task<result_type()>>(std::move(command));
+            auto result = task->get_future();
+            push([task]() { (*task)(); });
+            return result.get();
+        }
+
+    private:
+        glfw_gl_window& window;
+        std::thread thread;
+
+        mpsc_queue<std::function<void()>> commands;
+
+        /*!
+         * \brief Only used to put the render thread to sleep when there's nothing to do, and to wake it up again
+         */
+        std::mutex wake_lock;
+        std::condition_variable wake_up;
+        std::atomic<bool> should_stop{false};
+
+        std::mutex frames_in_flight_lock;
+        std::condition_variable frame_finished;
+        unsigned int num_frames_in_flight = 0;
+
+        void run_commands();
+
+        void wake();
+    };
+}
+
+#endif //RENDERER_RENDER_THREAD_H
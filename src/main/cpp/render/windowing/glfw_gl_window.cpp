@@ -5,6 +5,9 @@
 #include "glfw_gl_window.h"
 #include "../../utils/utils.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
 #include <easylogging++.h>
 #include "../../input/InputHandler.h"
 #include "../nova_renderer.h"
@@ -41,15 +44,23 @@ namespace nova {
         glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
         glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
         glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+        // RenderDoc has to hook OpenGL before there's a context
+        renderdoc.load(config["settings"].value("renderdocPath", std::string()));
+
+        // nova-bench runs without anyone watching, so it asks for a window that never shows up
+        const char* headless = std::getenv("NOVA_HEADLESS");
+        if(headless != nullptr && *headless != '\0' && *headless != '0') {
+            glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+            LOG(INFO) << "Making a hidden window, since NOVA_HEADLESS is set";
+        }
+
         window = glfwCreateWindow((int)view_width, (int)view_height, "Minecraft Nova Renderer", NULL, NULL);
         if(window == nullptr) {
             LOG(FATAL) << "Could not initialize window :(";
         }
         LOG(INFO) << "GLFW window created";
 
-        //renderdoc_manager = std::make_unique<RenderDocManager>(window, "C:\\Program Files\\RenderDoc\\renderdoc.dll", "capture");
-        //LOG(INFO) << "Hooked into RenderDoc";
-
         glfwMakeContextCurrent(window);
         gladLoadGLLoader((GLADloadproc) glfwGetProcAddress);
 
@@ -70,8 +81,12 @@ namespace nova {
 		glfwSetCursorPosCallback(window, mouse_position_callback);
         glfwSetScrollCallback(window, mouse_scroll_callback);
         glfwSetWindowFocusCallback(window, window_focus_callback);
-		glfwSwapInterval(0);
-		
+        apply_present_mode();
+
+        if(config["settings"].value("uploadThread", true)) {
+            uploads.start(window);
+        }
+
 		return 0;
     }
 
@@ -81,6 +96,7 @@ namespace nova {
     }
 
     void glfw_gl_window::destroy() {
+        uploads.stop();
         glfwDestroyWindow(window);
         glfwTerminate();
         window = nullptr;
@@ -116,8 +132,8 @@ namespace nova {
             height =windowed_window_parameters.height;
         }
 
+        // The next poll sees the new framebuffer size, and resizing goes from there
         glfwSetWindowMonitor(window, monitor, xPos, yPos, width, height, GLFW_DONT_CARE);
-        set_framebuffer_size({width,height});
     }
 
     bool glfw_gl_window::should_close() {
@@ -129,29 +145,124 @@ namespace nova {
     }
 
     void glfw_gl_window::end_frame() {
-        // We're in thread 29
+        wait_for_frame_limit();
         glfwSwapBuffers(window);
+        renderdoc.end_frame();
+    }
+
+    void glfw_gl_window::wait_for_frame_limit() {
+        if(mode != present_mode::limited || frame_rate_limit <= 0) {
+            return;
+        }
+
+        using clock = std::chrono::steady_clock;
+        const auto frame_time = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / frame_rate_limit));
+
+        auto now = clock::now();
+        if(now - next_frame_time > frame_time) {
+            // We're more than a frame behind, so don't rush to catch up
+            next_frame_time = now;
+        }
+
+        // Sleeping only wakes us up roughly on time, so we sleep in short steps until we're close and spin the rest
+        const auto sleep_step = std::chrono::milliseconds(1);
+        while(next_frame_time - now > max_sleep_overshoot + sleep_step) {
+            std::this_thread::sleep_for(sleep_step);
+            const auto woke_up = clock::now();
+            const auto overshoot = std::max(woke_up - now - sleep_step, clock::duration::zero());
+            if(overshoot > max_sleep_overshoot) {
+                max_sleep_overshoot = overshoot;
+            } else {
+                max_sleep_overshoot -= (max_sleep_overshoot - overshoot) / 16;
+            }
+            now = woke_up;
+        }
+
+        while(clock::now() < next_frame_time) {
+            std::this_thread::yield();
+        }
+
+        next_frame_time += frame_time;
+    }
+
+    bool glfw_gl_window::poll_events() {
         glfwPollEvents();
+        nova_renderer::instance->get_input_handler().end_poll();
 
         glm::ivec2 new_window_size;
         glfwGetFramebufferSize(window, &new_window_size.x, &new_window_size.y);
-		
-        if(new_window_size != window_dimensions) {
-            set_framebuffer_size(new_window_size);
+        if(new_window_size == window_dimensions) {
+            return false;
         }
+
+        // Only this thread touches window_dimensions, so input callbacks and get_size always agree with GLFW
+        window_dimensions = new_window_size;
+        return true;
     }
 
     void glfw_gl_window::set_framebuffer_size(glm::ivec2 new_framebuffer_size) {
         nlohmann::json &settings = nova_renderer::instance->get_render_settings().get_options();
         settings["settings"]["viewWidth"] = new_framebuffer_size.x;
         settings["settings"]["viewHeight"] = new_framebuffer_size.y;
-        window_dimensions = new_framebuffer_size;
-        glViewport(0, 0, window_dimensions.x, window_dimensions.y);
+        glViewport(0, 0, new_framebuffer_size.x, new_framebuffer_size.y);
         nova_renderer::instance->get_render_settings().update_config_changed();
     }
 
+    void glfw_gl_window::make_context_current() {
+        glfwMakeContextCurrent(window);
+    }
+
+    void glfw_gl_window::release_context() {
+        glfwMakeContextCurrent(nullptr);
+    }
+
+    /*!
+     * \brief Turns the name of a present mode from the settings into a present mode, keeping the current mode if the
+     * name isn't one of vsync, adaptive, uncapped, or limited
+     */
+    static present_mode parse_present_mode(const std::string& name, present_mode current) {
+        if(name == "vsync") {
+            return present_mode::vsync;
+        } else if(name == "adaptive") {
+            return present_mode::adaptive;
+        } else if(name == "uncapped") {
+            return present_mode::uncapped;
+        } else if(name == "limited") {
+            return present_mode::limited;
+        }
+
+        LOG(WARNING) << "Unknown present mode " << name << ", I only know vsync, adaptive, uncapped, and limited";
+        return current;
+    }
+
     void glfw_gl_window::on_config_change(nlohmann::json &new_config) {
         LOG(INFO) << "gl_glfw_window received the updated config";
+
+        frame_rate_limit = new_config.value("frameRateLimit", frame_rate_limit);
+
+        present_mode new_mode = parse_present_mode(new_config.value("presentMode", std::string("uncapped")), mode);
+        if(new_mode != mode) {
+            mode = new_mode;
+            apply_present_mode();
+        }
+    }
+
+    void glfw_gl_window::apply_present_mode() {
+        int swap_interval = 0;
+        if(mode == present_mode::vsync) {
+            swap_interval = 1;
+
+        } else if(mode == present_mode::adaptive) {
+            if(glfwExtensionSupported("WGL_EXT_swap_control_tear") || glfwExtensionSupported("GLX_EXT_swap_control_tear")) {
+                swap_interval = -1;
+            } else {
+                LOG(WARNING) << "The driver can't do adaptive vsync, so we'll use regular vsync";
+                swap_interval = 1;
+            }
+        }
+
+        glfwSwapInterval(swap_interval);
+        LOG(INFO) << "Swap interval is now " << swap_interval;
     }
 
     void glfw_gl_window::on_config_loaded(nlohmann::json &config) {
@@ -165,6 +276,14 @@ namespace nova {
         glfw_gl_window::active = active;
     }
 
+    renderdoc_capture& glfw_gl_window::get_renderdoc() {
+        return renderdoc;
+    }
+
+    upload_context& glfw_gl_window::get_upload_context() {
+        return uploads;
+    }
+
     void glfw_gl_window::set_mouse_grabbed(bool grabbed) {
         glfwSetInputMode(window, GLFW_CURSOR, grabbed ? GLFW_CURSOR_DISABLED : GLFW_CURSOR_NORMAL);
     }
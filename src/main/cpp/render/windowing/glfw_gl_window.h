@@ -6,13 +6,25 @@
 #define RENDERER_GLFW_GL_WINDOW_H
 
 
+#include <chrono>
 #include <glad/glad.h>
 #include <json.hpp>
 #include "GLFW/glfw3.h"
 #include "../../interfaces/iwindow.h"
-#include <RenderDocManager.h>
+#include "renderdoc_capture.h"
+#include "upload_context.h"
 
 namespace nova {
+    /*!
+     * \brief How frames are shown. Set with the presentMode setting
+     */
+    enum class present_mode {
+        vsync,      //!< Wait for vertical blank
+        adaptive,   //!< Wait for vertical blank, unless the frame is late. Falls back to vsync without driver support
+        uncapped,   //!< Never wait
+        limited     //!< Never wait for vertical blank, but don't go faster than the frameRateLimit setting
+    };
+
     struct window_parameters {
         int xPos;
         int yPos;
@@ -45,6 +57,12 @@ namespace nova {
 
         virtual void destroy();
 
+        /*!
+         * \brief Waits for the frame rate limit if there is one, then swaps buffers. Must be called from the thread
+         * that has the context
+         *
+         * Events aren't polled here, see #poll_events
+         */
         virtual void end_frame();
 
         virtual void set_fullscreen(bool fullscreen);
@@ -57,6 +75,31 @@ namespace nova {
 
         void set_mouse_grabbed(bool grabbed);
 
+        /*!
+         * \brief Handles all the window's events and checks its size. Must be called from the thread that made the
+         * window, since that's the only place GLFW lets us poll
+         *
+         * \return True if the window's framebuffer changed size. The new size is in #get_size, and should be passed
+         * to #set_framebuffer_size on the thread that has the context
+         */
+        bool poll_events();
+
+        /*!
+         * \brief Resizes the viewport and tells everything about the new view size. Must be called from the thread
+         * that has the context
+         */
+        void set_framebuffer_size(glm::ivec2 new_framebuffer_size);
+
+        /*!
+         * \brief Makes the window's context current on the calling thread
+         */
+        void make_context_current();
+
+        /*!
+         * \brief Releases the window's context from the calling thread, so another thread can make it current
+         */
+        void release_context();
+
         /**
          * iconfig_change_listener methods
          */
@@ -67,13 +110,51 @@ namespace nova {
 
         static void setActive(bool active);
 
+        /*!
+         * \brief Captures frames with RenderDoc, if it was loaded when the window was made
+         */
+        renderdoc_capture& get_renderdoc();
+
+        /*!
+         * \brief The context chunk uploads run on. Its thread only runs if the uploadThread setting was on when the
+         * window was made
+         */
+        upload_context& get_upload_context();
+
     private:
         static bool active;
         GLFWwindow *window;
         glm::ivec2 window_dimensions;
-        std::unique_ptr<RenderDocManager> renderdoc_manager;
+        renderdoc_capture renderdoc;
+        upload_context uploads;
         struct window_parameters windowed_window_parameters;
-        void set_framebuffer_size(glm::ivec2 new_framebuffer_size);
+
+        present_mode mode = present_mode::uncapped;
+        int frame_rate_limit = 120;
+
+        /*!
+         * \brief When the next frame should be shown, if the frame rate is limited
+         */
+        std::chrono::steady_clock::time_point next_frame_time;
+
+        /*!
+         * \brief About the most a sleep overshoots by lately. The frame limiter spins instead of sleeping for this much
+         * at the end of each frame, since that's as precise as sleeping gets on this system
+         *
+         * A longer overshoot raises it right away, and shorter ones bring it back down a little each sleep, so one
+         * slow wake-up, like when the system was busy, doesn't leave the limiter spinning for good
+         */
+        std::chrono::steady_clock::duration max_sleep_overshoot = std::chrono::milliseconds(1);
+
+        /*!
+         * \brief Sets the swap interval for the present mode. Must be called from the thread that has the context
+         */
+        void apply_present_mode();
+
+        /*!
+         * \brief Sleeps, then spins, until it's time for the next frame
+         */
+        void wait_for_frame_limit();
     };
 }
 
@@ -0,0 +1,167 @@
+/*!
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include <sstream>
+#include <vector>
+#include <easylogging++.h>
+#include "renderdoc_capture.h"
+#include "../../utils/utils.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+namespace nova {
+    /*!
+     * \brief Finds RENDERDOC_GetAPI in a RenderDoc that's already loaded, or in the library at the given path
+     */
+    static pRENDERDOC_GetAPI find_get_api(const std::string& library_path) {
+#if defined(_WIN32)
+        HMODULE library = GetModuleHandleA("renderdoc.dll");
+        if(library == nullptr && !library_path.empty()) {
+            library = LoadLibraryA(library_path.c_str());
+        }
+        if(library == nullptr) {
+            return nullptr;
+        }
+        return reinterpret_cast<pRENDERDOC_GetAPI>(GetProcAddress(library, "RENDERDOC_GetAPI"));
+#else
+        void* library = dlopen("librenderdoc.so", RTLD_NOW | RTLD_NOLOAD);
+        if(library == nullptr && !library_path.empty()) {
+            library = dlopen(library_path.c_str(), RTLD_NOW);
+        }
+        if(library == nullptr) {
+            return nullptr;
+        }
+        return reinterpret_cast<pRENDERDOC_GetAPI>(dlsym(library, "RENDERDOC_GetAPI"));
+#endif
+    }
+
+    std::string get_capture_comments(const std::string& reason, const frame_statistics& stats) {
+        std::stringstream comments;
+        comments << reason << "\n\n";
+        comments << "Counts from frame " << stats.frame << ", the frame before the capture:\n";
+        comments << "Draw calls: " << stats.draw_calls << " (" << stats.draw_commands << " meshes)\n";
+        comments << "Triangles: " << stats.triangles << "\n";
+        comments << "State changes: " << stats.state_changes << " (" << stats.state_changes_saved << " saved)\n";
+        comments << "Texture binds: " << stats.texture_binds << "\n";
+        comments << "Bytes uploaded: " << stats.bytes_uploaded << "\n";
+        comments << "Performance warnings: " << stats.performance_warnings << "\n";
+
+        for(const auto& pass : stats.passes) {
+            comments << pass.name << ": " << pass.draw_calls << " draws, " << pass.triangles << " triangles";
+            if(stats.has_pipeline_statistics) {
+                comments << ", " << pass.fragment_shader_invocations << " fragment shader invocations";
+            }
+            comments << "\n";
+        }
+
+        return comments.str();
+    }
+
+    bool renderdoc_capture::load(const std::string& library_path) {
+        pRENDERDOC_GetAPI get_api = find_get_api(library_path);
+        if(get_api == nullptr) {
+            if(!library_path.empty()) {
+                LOG(WARNING) << "Could not load RenderDoc from " << library_path << ", so frames won't be captured";
+            }
+            return false;
+        }
+
+        if(get_api(eRENDERDOC_API_Version_1_2_0, reinterpret_cast<void**>(&api)) != 1) {
+            LOG(WARNING) << "This RenderDoc is too old for Nova to capture frames with. Version 1.2 or newer is needed";
+            api = nullptr;
+            return false;
+        }
+
+        // Nova's own capture keys and the overlay are enough, RenderDoc doesn't need to draw over the game too
+        api->MaskOverlayBits(eRENDERDOC_Overlay_None, eRENDERDOC_Overlay_None);
+        num_captures = api->GetNumCaptures();
+        LOG(INFO) << "Hooked into RenderDoc";
+        return true;
+    }
+
+    bool renderdoc_capture::is_loaded() const {
+        return api != nullptr;
+    }
+
+    void renderdoc_capture::set_capture_directory(const std::string& directory) {
+        if(api == nullptr) {
+            return;
+        }
+
+        make_directory(directory);
+        api->SetCaptureFilePathTemplate((directory + "/nova").c_str());
+    }
+
+    void renderdoc_capture::set_spike_threshold(float threshold_ms) {
+        spike_threshold_ms = threshold_ms > 0 ? threshold_ms : 0;
+    }
+
+    float renderdoc_capture::get_spike_threshold() const {
+        return spike_threshold_ms;
+    }
+
+    void renderdoc_capture::trigger(const std::string& reason) {
+        if(api == nullptr) {
+            LOG(WARNING) << "Can't capture a frame, since RenderDoc isn't loaded. Set renderdocPath, or start Minecraft from RenderDoc";
+            return;
+        }
+
+        // Only one comment can go with the next capture, so asking again before it's written just keeps the first reason
+        if(is_capture_pending) {
+            return;
+        }
+
+        api->TriggerCapture();
+        pending_comments = get_capture_comments(reason, frame_stats::get_last_frame());
+        is_capture_pending = true;
+    }
+
+    void renderdoc_capture::trigger_for_spike(float gpu_frame_time_ms) {
+        if(api == nullptr || spike_threshold_ms <= 0 || gpu_frame_time_ms <= spike_threshold_ms) {
+            return;
+        }
+        if(has_captured_spike && frame_count < last_spike_frame + SPIKE_COOLDOWN_FRAMES) {
+            return;
+        }
+
+        std::stringstream reason;
+        reason << "A frame took " << gpu_frame_time_ms << " ms on the GPU, more than the renderdocSpikeThresholdMs of "
+               << spike_threshold_ms << " ms";
+        LOG(INFO) << reason.str() << ", so the next frame will be captured";
+
+        trigger(reason.str());
+        last_spike_frame = frame_count;
+        has_captured_spike = true;
+    }
+
+    void renderdoc_capture::end_frame() {
+        frame_count++;
+        if(api == nullptr || !is_capture_pending) {
+            return;
+        }
+
+        const uint32_t new_num_captures = api->GetNumCaptures();
+        if(new_num_captures == num_captures) {
+            return;
+        }
+
+        // The capture we asked for is the newest one
+        uint32_t path_length = 0;
+        api->GetCapture(new_num_captures - 1, nullptr, &path_length, nullptr);
+        std::vector<char> path(path_length + 1, '\0');
+        api->GetCapture(new_num_captures - 1, path.data(), &path_length, nullptr);
+
+        api->SetCaptureFileComments(path.data(), pending_comments.c_str());
+        LOG(INFO) << "RenderDoc saved a capture to " << path.data();
+
+        num_captures = new_num_captures;
+        pending_comments.clear();
+        is_capture_pending = false;
+    }
+}
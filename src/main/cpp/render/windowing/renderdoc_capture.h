@@ -0,0 +1,107 @@
+/*!
+ * \brief Asks RenderDoc to capture frames, so slow frames can be looked at after the fact
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#ifndef RENDERER_RENDERDOC_CAPTURE_H
+#define RENDERER_RENDERDOC_CAPTURE_H
+
+#include <cstdint>
+#include <string>
+#include <renderdoc_app.h>
+#include "../objects/frame_stats.h"
+
+namespace nova {
+    /*!
+     * \brief Builds the comments that are saved with a capture: why it was taken, then the counts from the frame
+     * before it
+     */
+    std::string get_capture_comments(const std::string& reason, const frame_statistics& stats);
+
+    /*!
+     * \brief Captures frames through RenderDoc's in-application API
+     *
+     * RenderDoc has to hook OpenGL before the context is made. If Nova was started from RenderDoc it's already
+     * loaded, and otherwise #load can load it from the renderdocPath setting. Without RenderDoc, everything here does
+     * nothing.
+     *
+     * #trigger captures the next frame that's presented. Once RenderDoc has written the capture, #end_frame adds the
+     * reason and the frame's counts to it as comments, which RenderDoc shows when the capture is opened. Slow frames
+     * come in bunches, so #trigger_for_spike only captures one frame every so often
+     *
+     * Everything but #load has to be called from the render thread
+     */
+    class renderdoc_capture {
+    public:
+        /*!
+         * \brief How many frames have to go by after a capture of a slow frame before another slow frame is captured
+         */
+        static const uint64_t SPIKE_COOLDOWN_FRAMES = 600;
+
+        /*!
+         * \brief Finds RenderDoc if it's been injected, or loads it from the given library if it hasn't
+         *
+         * Must be called before the OpenGL context is made
+         *
+         * \param library_path The RenderDoc library to load, like renderdoc.dll or librenderdoc.so. If it's empty, only
+         * a RenderDoc that's already loaded is used
+         * \return True if RenderDoc can take captures
+         */
+        bool load(const std::string& library_path);
+
+        bool is_loaded() const;
+
+        /*!
+         * \brief Sets where captures are saved. Each capture's file name starts with nova_ in that directory
+         */
+        void set_capture_directory(const std::string& directory);
+
+        /*!
+         * \brief Frames that take longer than this on the GPU, in milliseconds, are captured. 0 turns that off
+         */
+        void set_spike_threshold(float threshold_ms);
+
+        float get_spike_threshold() const;
+
+        /*!
+         * \brief Captures the next frame that's presented
+         *
+         * \param reason Saved with the capture, along with the counts from the last frame
+         */
+        void trigger(const std::string& reason);
+
+        /*!
+         * \brief Captures the next frame because the frame before it took the given time on the GPU, unless a frame
+         * was captured for that recently
+         */
+        void trigger_for_spike(float gpu_frame_time_ms);
+
+        /*!
+         * \brief Adds comments to captures RenderDoc has finished. Goes right after the frame is presented
+         */
+        void end_frame();
+
+    private:
+        RENDERDOC_API_1_2_0* api = nullptr;
+
+        float spike_threshold_ms = 0;
+        uint64_t frame_count = 0;
+        uint64_t last_spike_frame = 0;
+        bool has_captured_spike = false;
+
+        /*!
+         * \brief How many captures RenderDoc had the last time we looked, so we know which ones are new
+         */
+        uint32_t num_captures = 0;
+
+        /*!
+         * \brief The comments for the capture that's been asked for but hasn't been written yet
+         */
+        std::string pending_comments;
+        bool is_capture_pending = false;
+    };
+}
+
+#endif //RENDERER_RENDERDOC_CAPTURE_H
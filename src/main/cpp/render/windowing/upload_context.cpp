@@ -0,0 +1,154 @@
+/*!
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include <easylogging++.h>
+#include "upload_context.h"
+#include "../../utils/profiler.h"
+
+namespace nova {
+    upload_context::~upload_context() {
+        stop();
+    }
+
+    bool upload_context::start(GLFWwindow* main_window) {
+        if(window != nullptr) {
+            return true;
+        }
+
+        // The upload context is never shown. It has to be the same version as the main context to share with it
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        window = glfwCreateWindow(1, 1, "Nova uploads", nullptr, main_window);
+        glfwWindowHint(GLFW_VISIBLE, glfwGetWindowAttrib(main_window, GLFW_VISIBLE));
+
+        if(window == nullptr) {
+            LOG(WARNING) << "Could not make a context for uploads, so the render thread will upload everything itself";
+            return false;
+        }
+
+        stopping = false;
+        upload_thread = std::thread([this]() { run(); });
+        LOG(INFO) << "Started the upload thread";
+        return true;
+    }
+
+    void upload_context::stop() {
+        if(window == nullptr) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(tasks_lock);
+            stopping = true;
+        }
+        tasks_changed.notify_one();
+        upload_thread.join();
+
+        glfwDestroyWindow(window);
+        window = nullptr;
+    }
+
+    bool upload_context::is_running() const {
+        return window != nullptr;
+    }
+
+    uint64_t upload_context::submit(std::function<void()> task) {
+        if(window == nullptr) {
+            task();
+            const uint64_t ticket = next_ticket++;
+            completed_ticket.store(ticket, std::memory_order_release);
+            return ticket;
+        }
+
+        uint64_t ticket;
+        {
+            std::lock_guard<std::mutex> lock(tasks_lock);
+            ticket = next_ticket++;
+            tasks.push_back(std::move(task));
+        }
+        tasks_changed.notify_one();
+        return ticket;
+    }
+
+    uint64_t upload_context::get_completed_ticket() const {
+        return completed_ticket.load(std::memory_order_acquire);
+    }
+
+    bool upload_context::is_complete(uint64_t ticket) const {
+        return ticket <= get_completed_ticket();
+    }
+
+    void upload_context::wait_for(uint64_t ticket) {
+        std::unique_lock<std::mutex> lock(tasks_lock);
+        tasks_completed.wait(lock, [&]() { return is_complete(ticket); });
+    }
+
+    void upload_context::wait_on_gpu() {
+        std::lock_guard<std::mutex> lock(fence_lock);
+        if(newest_fence == nullptr || fence_ticket <= waited_ticket) {
+            return;
+        }
+
+        // The GPU waits, the CPU doesn't
+        glWaitSync(newest_fence, 0, GL_TIMEOUT_IGNORED);
+        waited_ticket = fence_ticket;
+    }
+
+    void upload_context::run() {
+        glfwMakeContextCurrent(window);
+
+        std::deque<std::function<void()>> batch;
+        while(true) {
+            uint64_t last_ticket;
+            {
+                std::unique_lock<std::mutex> lock(tasks_lock);
+                tasks_changed.wait(lock, [&]() { return stopping || !tasks.empty(); });
+                if(tasks.empty()) {
+                    break;
+                }
+
+                batch.swap(tasks);
+                last_ticket = next_ticket - 1;
+            }
+
+            profiler::start(NOVA_PROFILER_SCOPE("upload_thread_batch"));
+            for(auto& task : batch) {
+                task();
+            }
+            batch.clear();
+            profiler::end(NOVA_PROFILER_SCOPE("upload_thread_batch"));
+
+            // Other contexts only see a fence once the commands before it have been flushed
+            GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            glFlush();
+            {
+                std::lock_guard<std::mutex> lock(fence_lock);
+                if(newest_fence != nullptr) {
+                    glDeleteSync(newest_fence);
+                }
+                newest_fence = fence;
+                fence_ticket = last_ticket;
+            }
+            {
+                // Storing under the lock means wait_for can't miss the notification
+                std::lock_guard<std::mutex> lock(tasks_lock);
+                completed_ticket.store(last_ticket, std::memory_order_release);
+            }
+            tasks_completed.notify_all();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(fence_lock);
+            if(newest_fence != nullptr) {
+                glDeleteSync(newest_fence);
+                newest_fence = nullptr;
+            }
+        }
+        glfwMakeContextCurrent(nullptr);
+    }
+}
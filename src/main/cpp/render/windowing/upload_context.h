@@ -0,0 +1,123 @@
+/*!
+ * \brief A second OpenGL context, shared with the window's, that uploads data on its own thread
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#ifndef RENDERER_UPLOAD_CONTEXT_H
+#define RENDERER_UPLOAD_CONTEXT_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+namespace nova {
+    /*!
+     * \brief Runs upload tasks on a thread with its own OpenGL context, so copying data for the GPU doesn't take time
+     * away from drawing
+     *
+     * The context shares its objects with the window's context. Tasks run in the order they were submitted. After
+     * each batch of tasks the upload thread puts a fence in its context and flushes it, then marks the batch's
+     * tickets as complete. The render thread checks #is_complete for the ticket of whatever it wants to draw, and
+     * calls #wait_on_gpu before drawing it. That makes the render context's GPU commands wait on the newest fence,
+     * without making the CPU wait for anything
+     *
+     * If the context can't be made, #submit runs each task straight away on the thread that submits it, and its
+     * ticket is complete as soon as #submit returns
+     */
+    class upload_context {
+    public:
+        upload_context() = default;
+
+        upload_context(const upload_context&) = delete;
+        upload_context& operator=(const upload_context&) = delete;
+
+        ~upload_context();
+
+        /*!
+         * \brief Makes the context and starts the upload thread
+         *
+         * Has to be called from the thread that made the main window, since that's the only thread GLFW lets make
+         * windows
+         *
+         * \param main_window The window whose context the upload context shares objects with
+         * \return True if the upload thread is running
+         */
+        bool start(GLFWwindow* main_window);
+
+        /*!
+         * \brief Runs every task that's left, then stops the upload thread and destroys its context
+         */
+        void stop();
+
+        bool is_running() const;
+
+        /*!
+         * \brief Queues a task to run on the upload thread, with the upload context current
+         *
+         * Tasks can't use gl_state, since its cache only knows about the render thread's context
+         *
+         * \return The task's ticket. Tickets start at 1 and count up
+         */
+        uint64_t submit(std::function<void()> task);
+
+        /*!
+         * \brief The newest ticket whose task has run. Every older ticket's task has run too
+         */
+        uint64_t get_completed_ticket() const;
+
+        bool is_complete(uint64_t ticket) const;
+
+        /*!
+         * \brief Blocks until the given ticket's task has run. Only meant for shutting down, when whatever the task
+         * writes to is about to go away
+         */
+        void wait_for(uint64_t ticket);
+
+        /*!
+         * \brief Makes the render context's GPU commands wait for every task that's complete
+         *
+         * Call this from the render thread before drawing anything a task wrote. It only waits on the newest fence,
+         * and only once for each fence
+         */
+        void wait_on_gpu();
+
+    private:
+        GLFWwindow* window = nullptr;
+        std::thread upload_thread;
+
+        std::mutex tasks_lock;
+        std::condition_variable tasks_changed;
+        std::condition_variable tasks_completed;
+        std::deque<std::function<void()>> tasks;
+        uint64_t next_ticket = 1;
+        bool stopping = false;
+
+        std::atomic<uint64_t> completed_ticket{0};
+
+        std::mutex fence_lock;
+
+        /*!
+         * \brief Put in the upload context after the task for fence_ticket ran. Older fences are deleted when a new
+         * one is made, since fences in one context pass in order
+         */
+        GLsync newest_fence = nullptr;
+        uint64_t fence_ticket = 0;
+
+        /*!
+         * \brief The newest ticket the render context has waited for. Only used on the render thread
+         */
+        uint64_t waited_ticket = 0;
+
+        void run();
+    };
+}
+
+#endif //RENDERER_UPLOAD_CONTEXT_H
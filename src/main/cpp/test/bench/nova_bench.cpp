@@ -0,0 +1,647 @@
+/*!
+ * \brief Replays a capture made with NOVA_CAPTURE_FILE in a hidden window, and reports how long the frames took
+ *
+ * Usage: nova-bench <capture file> [--warmup <frames>] [--visible]
+ *        nova-bench --chunk-stress [--threads <count>] [--seconds <seconds>] [--warmup <frames>] [--visible]
+ *
+ * Calls are replayed as fast as Nova takes them, not at the pace they were captured at, so the frame times are how
+ * fast Nova can go with that workload. The first few frames are left out of the frame time numbers, since they're
+ * dominated by uploading the textures and the first chunks
+ *
+ * --chunk-stress doesn't need a capture. It adds and removes chunks from several threads at once, the way
+ * Minecraft's chunk builder threads do, while the main thread draws frames. Build with NOVA_TSAN to check those
+ * calls for races
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../../mc_interface/nova.h"
+#include "../../mc_interface/api_capture.h"
+#include "../../render/nova_renderer.h"
+#include "../../render/objects/gl_state.h"
+#include "../../render/objects/vertex_formats.h"
+#include "../../geometry_cache/greedy_mesher.h"
+
+using namespace nova;
+
+typedef std::chrono::steady_clock bench_clock;
+
+/*!
+ * \brief How many frames to draw after the capture ends before giving up on the chunks finishing their upload
+ */
+static const int MAX_DRAIN_FRAMES = 10000;
+
+/*!
+ * \brief How many chunks each --chunk-stress thread adds and removes. Each thread has its own, so a thread's last
+ * call for a chunk is the one that sticks
+ */
+static const int STRESS_CHUNKS_PER_THREAD = 256;
+
+/*!
+ * \brief How many quads are in each chunk --chunk-stress sends, which is about as many as a hilly section has
+ */
+static const int STRESS_QUADS_PER_CHUNK = 512;
+
+/*!
+ * \brief A chunk sent with the direct API. Its data has to stay alive until Nova says it's done with it
+ */
+struct direct_chunk {
+    std::vector<int> vertex_data;
+    std::vector<int> indices;
+    long long ticket;
+};
+
+/*!
+ * \brief How many times each thread has allocated from the heap. Every operator new in the program goes through the
+ * replacements below, including Nova's, since nova-bench is built from Nova's object files
+ */
+static thread_local uint64_t heap_allocations = 0;
+
+void* operator new(size_t size) {
+    heap_allocations++;
+    if(void* memory = std::malloc(size > 0 ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept {
+    std::free(memory);
+}
+
+struct bench_results {
+    std::vector<double> frame_ms;
+    std::vector<uint64_t> gl_calls_made;
+    std::vector<uint64_t> gl_calls_saved;
+
+    /*!
+     * \brief How many heap allocations the render thread made while drawing each frame
+     */
+    std::vector<uint64_t> frame_allocations;
+    uint64_t allocations_before_frame = 0;
+
+    uint64_t chunk_bytes = 0;
+    uint64_t section_bytes = 0;
+    uint64_t gui_bytes = 0;
+    uint64_t texture_bytes = 0;
+    uint64_t num_chunks = 0;
+    uint64_t num_records = 0;
+
+    /*!
+     * \brief Chunk updates that were never uploaded because the same section was sent again first
+     */
+    uint64_t superseded_chunks = 0;
+
+    bool has_chunks = false;
+    bench_clock::time_point first_chunk_time;
+    bench_clock::time_point chunks_done_time;
+};
+
+static bool read_file(const std::string& path, std::vector<uint8_t>& data) {
+    std::ifstream file(path, std::ios::binary);
+    if(!file.is_open()) {
+        return false;
+    }
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+static void set_environment_variable(const char* name, const char* value) {
+#ifdef _WIN32
+    _putenv_s(name, value);
+#else
+    setenv(name, value, 1);
+#endif
+}
+
+/*!
+ * \brief Reads the counts of GL calls from the frame that was just queued, once it's done
+ */
+static void sample_gl_calls(bench_results& results) {
+    (*nova_renderer::instance->get_render_thread()).push([&results]() {
+        results.frame_allocations.push_back(heap_allocations - results.allocations_before_frame);
+        results.gl_calls_made.push_back(gl_state::get_calls_made_last_frame());
+        results.gl_calls_saved.push_back(gl_state::get_calls_saved_last_frame());
+    });
+}
+
+/*!
+ * \brief Notes how many allocations the render thread has made so far, right before it draws the next frame. Replayed
+ * calls run on the render thread too, so only what happens between this and sample_gl_calls is the frame's
+ */
+static void start_counting_allocations(bench_results& results) {
+    (*nova_renderer::instance->get_render_thread()).push([&results]() {
+        results.allocations_before_frame = heap_allocations;
+    });
+}
+
+static bool has_pending_chunks() {
+    return nova_renderer::instance->get_render_thread()->run_and_wait([]() {
+        return nova_renderer::instance->get_mesh_store().has_pending_chunks();
+    });
+}
+
+static void note_chunk(bench_results& results, uint64_t num_bytes) {
+    if(!results.has_chunks) {
+        results.first_chunk_time = bench_clock::now();
+        results.has_chunks = true;
+    }
+    results.chunk_bytes += num_bytes;
+    results.num_chunks++;
+}
+
+static void replay_chunk(capture_payload& payload, bool is_removal, std::deque<direct_chunk>& direct_chunks, bench_results& results) {
+    const auto flags = payload.get<uint8_t>();
+    const std::string filter_name = payload.get_string();
+    const auto shader_id = payload.get<int>();
+
+    mc_chunk_render_object chunk = {};
+    if(!is_removal) {
+        chunk.format = payload.get<int>();
+    }
+    chunk.x = payload.get<float>();
+    chunk.y = payload.get<float>();
+    chunk.z = payload.get<float>();
+    chunk.id = payload.get<int>();
+
+    const bool by_filter_name = (flags & CAPTURE_CHUNK_BY_FILTER_NAME) != 0;
+    if(is_removal) {
+        if(by_filter_name) {
+            remove_chunk_geometry_for_filter(filter_name.c_str(), &chunk);
+        } else {
+            remove_chunk_geometry_for_shader(shader_id, &chunk);
+        }
+        return;
+    }
+
+    auto vertex_data = payload.get_array<int>();
+    auto indices = payload.get_array<int>();
+    note_chunk(results, (vertex_data.size() + indices.size()) * sizeof(int));
+
+    if((flags & CAPTURE_CHUNK_DIRECT) != 0) {
+        direct_chunks.push_back({std::move(vertex_data), std::move(indices), 0});
+        auto& direct = direct_chunks.back();
+        chunk.vertex_data = direct.vertex_data.data();
+        chunk.vertex_buffer_size = static_cast<int>(direct.vertex_data.size());
+        chunk.indices = direct.indices.data();
+        chunk.index_buffer_size = static_cast<int>(direct.indices.size());
+        direct.ticket = by_filter_name ? add_chunk_geometry_for_filter_direct(filter_name.c_str(), &chunk)
+                                       : add_chunk_geometry_for_shader_direct(shader_id, &chunk);
+        return;
+    }
+
+    chunk.vertex_data = vertex_data.data();
+    chunk.vertex_buffer_size = static_cast<int>(vertex_data.size());
+    chunk.indices = indices.data();
+    chunk.index_buffer_size = static_cast<int>(indices.size());
+    if(by_filter_name) {
+        add_chunk_geometry_for_filter(filter_name.c_str(), &chunk);
+    } else {
+        add_chunk_geometry_for_shader(shader_id, &chunk);
+    }
+}
+
+static void replay_record(capture_record& record, std::deque<direct_chunk>& direct_chunks, bench_results& results) {
+    auto& payload = record.payload;
+    results.num_records++;
+
+    switch(record.command) {
+        case capture_command::get_shader_id:
+            get_shader_id(payload.get_string().c_str());
+            break;
+
+        case capture_command::add_texture: {
+            mc_atlas_texture texture = {};
+            texture.width = payload.get<int>();
+            texture.height = payload.get<int>();
+            texture.num_components = payload.get<int>();
+            const std::string name = payload.get_string();
+            auto pixels = payload.get_array<unsigned char>();
+            texture.name = name.c_str();
+            texture.texture_data = pixels.data();
+            results.texture_bytes += pixels.size();
+            add_texture(texture);
+            break;
+        }
+
+        case capture_command::add_texture_location: {
+            mc_texture_atlas_location location = {};
+            const std::string name = payload.get_string();
+            location.name = name.c_str();
+            location.min_u = payload.get<float>();
+            location.max_u = payload.get<float>();
+            location.min_v = payload.get<float>();
+            location.max_v = payload.get<float>();
+            add_texture_location(location);
+            break;
+        }
+
+        case capture_command::reset_texture_manager:
+            reset_texture_manager();
+            break;
+
+        case capture_command::send_lightmap_texture: {
+            const auto width = payload.get<int>();
+            const auto height = payload.get<int>();
+            auto pixels = payload.get_array<int>();
+            send_lightmap_texture(pixels.data(), static_cast<int>(pixels.size()), width, height);
+            break;
+        }
+
+        case capture_command::add_chunk_geometry:
+            replay_chunk(payload, false, direct_chunks, results);
+            break;
+
+        case capture_command::remove_chunk_geometry:
+            replay_chunk(payload, true, direct_chunks, results);
+            break;
+
+        case capture_command::set_mesher_block_type: {
+            auto block_type = payload.get<mc_mesher_block_type>();
+            set_mesher_block_type(&block_type);
+            break;
+        }
+
+        case capture_command::add_chunk_section_blocks: {
+            mc_chunk_section_blocks section = {};
+            section.x = payload.get<float>();
+            section.y = payload.get<float>();
+            section.z = payload.get<float>();
+            section.id = payload.get<int>();
+            auto block_ids = payload.get_array<unsigned short>();
+            auto light = payload.get_array<unsigned char>();
+            if(block_ids.size() != PADDED_SECTION_VOLUME || light.size() != PADDED_SECTION_VOLUME) {
+                std::cerr << "Skipping a chunk section with the wrong number of blocks" << std::endl;
+                break;
+            }
+            section.block_ids = block_ids.data();
+            section.light = light.data();
+            note_chunk(results, 0);
+            results.section_bytes += block_ids.size() * sizeof(unsigned short) + light.size();
+            add_chunk_section_blocks(&section);
+            break;
+        }
+
+        case capture_command::add_gui_geometry: {
+            mc_gui_geometry geometry = {};
+            const std::string texture_name = payload.get_string();
+            const std::string atlas_name = payload.get_string();
+            auto indices = payload.get_array<int>();
+            auto vertices = payload.get_array<float>();
+            geometry.texture_name = texture_name.c_str();
+            geometry.atlas_name = atlas_name.c_str();
+            geometry.index_buffer = indices.data();
+            geometry.index_buffer_size = static_cast<int>(indices.size());
+            geometry.vertex_buffer = vertices.data();
+            geometry.vertex_buffer_size = static_cast<int>(vertices.size());
+            results.gui_bytes += (indices.size() + vertices.size()) * 4;
+            add_gui_geometry(&geometry);
+            break;
+        }
+
+        case capture_command::clear_gui_buffers:
+            clear_gui_buffers();
+            break;
+
+        case capture_command::set_string_setting: {
+            const std::string name = payload.get_string();
+            const std::string value = payload.get_string();
+            set_string_setting(name.c_str(), value.c_str());
+            break;
+        }
+
+        case capture_command::set_float_setting: {
+            const std::string name = payload.get_string();
+            const auto value = payload.get<float>();
+            set_float_setting(name.c_str(), value);
+            break;
+        }
+
+        case capture_command::set_player_camera_transform: {
+            const auto x = payload.get<double>();
+            const auto y = payload.get<double>();
+            const auto z = payload.get<double>();
+            const auto yaw = payload.get<float>();
+            const auto pitch = payload.get<float>();
+            set_player_camera_transform(x, y, z, yaw, pitch);
+            break;
+        }
+
+        case capture_command::set_celestial_angle:
+            set_celestial_angle(payload.get<float>());
+            break;
+
+        case capture_command::set_sky_state: {
+            const auto world_time = payload.get<double>();
+            const auto rain_strength = payload.get<float>();
+            const auto is_snowing = payload.get<int>();
+            set_sky_state(world_time, rain_strength, is_snowing);
+            break;
+        }
+
+        case capture_command::execute_frame:
+            // Handled by the main loop, which times it
+            break;
+
+        default:
+            std::cerr << "Skipping a record with unknown command " << static_cast<int>(record.command) << std::endl;
+            break;
+    }
+
+    if(payload.overran) {
+        std::cerr << "A record for command " << static_cast<int>(record.command) << " was shorter than expected" << std::endl;
+    }
+}
+
+/*!
+ * \brief Forgets the direct chunks that Nova is done reading, oldest first
+ */
+static void release_direct_chunks(std::deque<direct_chunk>& direct_chunks) {
+    while(!direct_chunks.empty() && is_chunk_geometry_upload_complete(direct_chunks.front().ticket)) {
+        direct_chunks.pop_front();
+    }
+}
+
+/*!
+ * \brief Makes a chunk of Minecraft's 7-int block vertices, all quads facing up, spread over the section
+ */
+static std::vector<int> make_stress_chunk_vertices() {
+    std::vector<int> vertex_data(STRESS_QUADS_PER_CHUNK * 4 * mc_block_layout::ints_per_vertex);
+    const float corners[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+    for(int quad = 0; quad < STRESS_QUADS_PER_CHUNK; quad++) {
+        for(int corner = 0; corner < 4; corner++) {
+            mc_block_vertex vertex = {};
+            vertex.position[0] = static_cast<float>(quad % 16) + corners[corner][0];
+            vertex.position[1] = static_cast<float>(quad / 256);
+            vertex.position[2] = static_cast<float>(quad / 16 % 16) + corners[corner][1];
+            std::memset(vertex.color, 255, sizeof(vertex.color));
+            vertex.uv[0] = corners[corner][0];
+            vertex.uv[1] = corners[corner][1];
+            vertex.lightmap_uv[0] = 240;
+            vertex.lightmap_uv[1] = 240;
+            std::memcpy(&vertex_data[(quad * 4 + corner) * mc_block_layout::ints_per_vertex], &vertex, sizeof(vertex));
+        }
+    }
+    return vertex_data;
+}
+
+/*!
+ * \brief Adds and removes chunks from num_threads threads for the given number of seconds, drawing frames the whole
+ * time. Removals are one in four calls
+ */
+template <typename Function>
+static void run_chunk_stress(int num_threads, double seconds, bench_results& results, Function&& run_frame) {
+    const int shader = get_shader_id("gbuffers_terrain");
+    const std::vector<int> vertex_data = make_stress_chunk_vertices();
+
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> num_calls{0};
+    std::atomic<uint64_t> num_chunks{0};
+    std::atomic<uint64_t> num_removals{0};
+
+    results.first_chunk_time = bench_clock::now();
+    results.has_chunks = true;
+
+    std::vector<std::thread> threads;
+    for(int thread_idx = 0; thread_idx < num_threads; thread_idx++) {
+        threads.emplace_back([&, thread_idx]() {
+            std::mt19937 random(static_cast<uint32_t>(thread_idx));
+            while(!stop) {
+                const int chunk_idx = static_cast<int>(random() % STRESS_CHUNKS_PER_THREAD);
+                mc_chunk_render_object chunk = {};
+                chunk.format = 2;   // POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT
+                chunk.x = static_cast<float>(chunk_idx % 16 * 16);
+                chunk.y = static_cast<float>(chunk_idx / 16 * 16);
+                chunk.z = static_cast<float>(thread_idx * 16);
+                chunk.id = thread_idx * STRESS_CHUNKS_PER_THREAD + chunk_idx;
+
+                if(random() % 4 == 0) {
+                    remove_chunk_geometry_for_shader(shader, &chunk);
+                    num_removals++;
+                } else {
+                    // Minecraft's buffers are only good until the call returns, so each call gets its own copy
+                    std::vector<int> chunk_vertices = vertex_data;
+                    chunk.vertex_data = chunk_vertices.data();
+                    chunk.vertex_buffer_size = static_cast<int>(chunk_vertices.size());
+                    add_chunk_geometry_for_shader(shader, &chunk);
+                    num_chunks++;
+                }
+                num_calls++;
+            }
+        });
+    }
+
+    const auto end_time = results.first_chunk_time + std::chrono::duration_cast<bench_clock::duration>(std::chrono::duration<double>(seconds));
+    while(bench_clock::now() < end_time) {
+        run_frame();
+    }
+
+    stop = true;
+    for(auto& thread : threads) {
+        thread.join();
+    }
+
+    results.num_records = num_calls;
+    results.num_chunks = num_chunks;
+    results.chunk_bytes = num_chunks * vertex_data.size() * sizeof(int);
+    std::cout << num_threads << " threads made " << num_calls << " calls (" << num_calls / seconds << " per second), "
+              << num_removals << " of them removals" << std::endl;
+}
+
+static double percentile(const std::vector<double>& sorted_values, double fraction) {
+    if(sorted_values.empty()) {
+        return 0;
+    }
+    const auto idx = static_cast<size_t>(std::ceil(fraction * sorted_values.size())) - 1;
+    return sorted_values[std::min(idx, sorted_values.size() - 1)];
+}
+
+template <typename T>
+static double average(const std::vector<T>& values) {
+    if(values.empty()) {
+        return 0;
+    }
+    double total = 0;
+    for(const auto& value : values) {
+        total += static_cast<double>(value);
+    }
+    return total / values.size();
+}
+
+static void print_results(const bench_results& results, size_t num_warmup_frames) {
+    std::vector<double> frame_ms;
+    if(results.frame_ms.size() > num_warmup_frames) {
+        frame_ms.assign(results.frame_ms.begin() + num_warmup_frames, results.frame_ms.end());
+    }
+    std::sort(frame_ms.begin(), frame_ms.end());
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "Replayed " << results.num_records << " calls and " << results.frame_ms.size() << " frames ("
+              << num_warmup_frames << " warmup frames not counted)" << std::endl;
+
+    std::cout << "Frame time (ms): avg " << average(frame_ms) << ", p50 " << percentile(frame_ms, 0.5)
+              << ", p90 " << percentile(frame_ms, 0.9) << ", p99 " << percentile(frame_ms, 0.99)
+              << ", max " << (frame_ms.empty() ? 0 : frame_ms.back()) << std::endl;
+
+    std::cout << "GL calls per frame: " << average(results.gl_calls_made) << " made, "
+              << average(results.gl_calls_saved) << " skipped by the state cache" << std::endl;
+
+    // The warmup frames allocate while the arenas and pools grow, so they're left out like they are for frame times
+    std::vector<uint64_t> frame_allocations;
+    if(results.frame_allocations.size() > num_warmup_frames) {
+        frame_allocations.assign(results.frame_allocations.begin() + num_warmup_frames, results.frame_allocations.end());
+    }
+    std::cout << "Heap allocations per frame on the render thread: avg " << average(frame_allocations) << ", max "
+              << (frame_allocations.empty() ? 0 : *std::max_element(frame_allocations.begin(), frame_allocations.end()))
+              << std::endl;
+
+    const double megabyte = 1024.0 * 1024.0;
+    std::cout << "Uploaded " << results.num_chunks << " chunks (" << results.chunk_bytes / megabyte << " MB of geometry, "
+              << results.section_bytes / megabyte << " MB of section blocks), " << results.texture_bytes / megabyte
+              << " MB of textures, " << results.gui_bytes / megabyte << " MB of GUI geometry" << std::endl;
+    std::cout << results.superseded_chunks << " chunk updates were replaced by newer ones before they were uploaded"
+              << std::endl;
+
+    if(results.has_chunks) {
+        const double seconds = std::chrono::duration<double>(results.chunks_done_time - results.first_chunk_time).count();
+        std::cout << "Chunks finished uploading " << seconds << " s after the first was sent";
+        if(seconds > 0) {
+            std::cout << ", " << results.chunk_bytes / megabyte / seconds << " MB/s of geometry, "
+                      << results.num_chunks / seconds << " chunks/s";
+        }
+        std::cout << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string capture_path;
+    size_t num_warmup_frames = 10;
+    bool visible = false;
+    bool chunk_stress = false;
+    int num_stress_threads = 4;
+    double stress_seconds = 10;
+
+    for(int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if(arg == "--warmup" && i + 1 < argc) {
+            num_warmup_frames = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if(arg == "--visible") {
+            visible = true;
+        } else if(arg == "--chunk-stress") {
+            chunk_stress = true;
+        } else if(arg == "--threads" && i + 1 < argc) {
+            num_stress_threads = std::max(1, std::atoi(argv[++i]));
+        } else if(arg == "--seconds" && i + 1 < argc) {
+            stress_seconds = std::max(0.1, std::atof(argv[++i]));
+        } else if(capture_path.empty()) {
+            capture_path = arg;
+        } else {
+            capture_path.clear();
+            break;
+        }
+    }
+
+    if(capture_path.empty() == !chunk_stress) {
+        std::cerr << "Usage: nova-bench <capture file> [--warmup <frames>] [--visible]" << std::endl;
+        std::cerr << "       nova-bench --chunk-stress [--threads <count>] [--seconds <seconds>] [--warmup <frames>] [--visible]" << std::endl;
+        return 1;
+    }
+
+    std::vector<uint8_t> capture_data;
+    if(!chunk_stress && !read_file(capture_path, capture_data)) {
+        std::cerr << "Could not read " << capture_path << std::endl;
+        return 1;
+    }
+
+    capture_reader reader(capture_data);
+    if(!chunk_stress && !reader.is_valid()) {
+        std::cerr << capture_path << " isn't a capture file, or is from a different version of Nova" << std::endl;
+        return 1;
+    }
+
+    if(!visible) {
+        set_environment_variable("NOVA_HEADLESS", "1");
+    }
+    initialize();
+
+    bench_results results;
+    std::deque<direct_chunk> direct_chunks;
+    auto last_frame_end = bench_clock::now();
+
+    auto run_frame = [&]() {
+        start_counting_allocations(results);
+        execute_frame();
+        const auto now = bench_clock::now();
+        results.frame_ms.push_back(std::chrono::duration<double, std::milli>(now - last_frame_end).count());
+        last_frame_end = now;
+
+        sample_gl_calls(results);
+        release_direct_chunks(direct_chunks);
+    };
+
+    if(chunk_stress) {
+        run_chunk_stress(num_stress_threads, stress_seconds, results, run_frame);
+    } else {
+        capture_record record;
+        while(reader.next(record)) {
+            if(record.command == capture_command::execute_frame) {
+                results.num_records++;
+                run_frame();
+            } else {
+                replay_record(record, direct_chunks, results);
+            }
+        }
+    }
+
+    // Keep drawing until everything that was sent is on the GPU, so the upload time is real
+    int num_drain_frames = 0;
+    while(has_pending_chunks() && num_drain_frames < MAX_DRAIN_FRAMES) {
+        run_frame();
+        num_drain_frames++;
+    }
+    results.chunks_done_time = bench_clock::now();
+    results.superseded_chunks = nova_renderer::instance->get_render_thread()->run_and_wait([]() {
+        return nova_renderer::instance->get_mesh_store().get_num_superseded_uploads();
+    });
+
+    // Wait for the last frame, and the GL call samples queued after it
+    nova_renderer::instance->get_render_thread()->run_and_wait([]() { return 0; });
+
+    print_results(results, num_warmup_frames);
+
+    nova_renderer::deinit();
+    return 0;
+}
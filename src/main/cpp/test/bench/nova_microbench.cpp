@@ -0,0 +1,374 @@
+/*!
+ * \brief Google Benchmark timings for the CPU work on Nova's hot paths
+ *
+ * Everything here runs without a window or a GL context. The mesh store is made on its own, with no renderer, so only
+ * the side of it that Minecraft's threads call is timed here. The render thread's side, and the parts of these paths
+ * that only talk to the driver, need a real context, and nova-bench measures them
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "../../geometry_cache/aabb_table.h"
+#include "../../geometry_cache/chunk_lod.h"
+#include "../../geometry_cache/greedy_mesher.h"
+#include "../../geometry_cache/mesh_store.h"
+#include "../../geometry_cache/vertex_packing.h"
+#include "../../render/objects/camera.h"
+#include "../../render/objects/textures/block_compression.h"
+
+namespace nova {
+    namespace bench {
+        /*!
+         * \brief Makes a chunk section with the given number of quads, in Minecraft's 7-int block format
+         *
+         * The quads are the tops of blocks at random heights, which is about what a hilly section looks like
+         */
+        static void make_chunk_section(int num_quads, std::vector<int>& mc_vertex_data, std::vector<int>& indices) {
+            std::mt19937 rng(1234);
+            std::uniform_int_distribution<int> coordinate(0, 15);
+
+            mc_vertex_data.clear();
+            indices.clear();
+            for(int quad = 0; quad < num_quads; quad++) {
+                const float x = static_cast<float>(coordinate(rng));
+                const float y = static_cast<float>(coordinate(rng));
+                const float z = static_cast<float>(coordinate(rng));
+                const float corners[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+
+                const int first_vertex = static_cast<int>(mc_vertex_data.size() / 7);
+                for(const auto& corner : corners) {
+                    const float position[3] = {x + corner[0], y + 1, z + corner[1]};
+                    const float uv[2] = {corner[0] / 64.0f, corner[1] / 64.0f};
+                    int vertex[7];
+                    std::memcpy(&vertex[0], position, sizeof(position));
+                    vertex[3] = -1;
+                    std::memcpy(&vertex[4], uv, sizeof(uv));
+                    vertex[6] = (240 << 16) | 240;
+                    mc_vertex_data.insert(mc_vertex_data.end(), vertex, vertex + 7);
+                }
+
+                const int quad_indices[6] = {0, 1, 2, 0, 2, 3};
+                for(int idx : quad_indices) {
+                    indices.push_back(first_vertex + idx);
+                }
+            }
+        }
+
+        /*!
+         * \brief A grid of chunk section bounding boxes around the origin, like a loaded world
+         */
+        static std::vector<aabb> make_chunk_boxes(size_t num_boxes) {
+            std::vector<aabb> boxes;
+            boxes.reserve(num_boxes);
+            const int side = static_cast<int>(std::ceil(std::cbrt(static_cast<double>(num_boxes))));
+            for(size_t i = 0; i < num_boxes; i++) {
+                const int x = static_cast<int>(i % side) - side / 2;
+                const int y = static_cast<int>((i / side) % side);
+                const int z = static_cast<int>(i / (side * side)) - side / 2;
+
+                aabb box = {};
+                box.center = glm::vec3(x * 16 + 8, y * 16 + 8, z * 16 + 8);
+                box.extents = glm::vec3(8);
+                boxes.push_back(box);
+            }
+            return boxes;
+        }
+
+        static camera make_camera() {
+            camera player_camera;
+            player_camera.position = glm::vec3(0, 64, 0);
+            player_camera.rotation = glm::vec2(30, 10);
+            player_camera.far_plane = 512;
+            player_camera.recalculate_frustum();
+            return player_camera;
+        }
+
+        /*!
+         * \brief Packing a section's vertices, which the conversion workers do for every chunk that's added
+         */
+        static void BM_pack_chunk_vertices(benchmark::State& state) {
+            std::vector<int> mc_vertex_data;
+            std::vector<int> indices;
+            make_chunk_section(static_cast<int>(state.range(0)), mc_vertex_data, indices);
+
+            std::vector<int> packed;
+            for(auto _ : state) {
+                packed.clear();
+                pack_chunk_vertices(mc_vertex_data, indices, packed);
+                benchmark::DoNotOptimize(packed.data());
+            }
+            state.SetBytesProcessed(state.iterations() * mc_vertex_data.size() * sizeof(int));
+        }
+        BENCHMARK(BM_pack_chunk_vertices)->Arg(512)->Arg(2048)->Arg(8192);
+
+        /*!
+         * \brief Building one level of detail for a section, which the workers do up to twice per chunk
+         */
+        static void BM_simplify_chunk_mesh(benchmark::State& state) {
+            std::vector<int> mc_vertex_data;
+            std::vector<int> indices;
+            make_chunk_section(static_cast<int>(state.range(0)), mc_vertex_data, indices);
+
+            std::vector<int> lod_vertex_data;
+            std::vector<int> lod_indices;
+            for(auto _ : state) {
+                simplify_chunk_mesh(mc_vertex_data, indices, CHUNK_LOD_CELL_SIZES[0], lod_vertex_data, lod_indices);
+                benchmark::DoNotOptimize(lod_indices.data());
+            }
+            state.SetItemsProcessed(state.iterations() * indices.size() / 3);
+        }
+        BENCHMARK(BM_simplify_chunk_mesh)->Arg(512)->Arg(2048)->Arg(8192);
+
+        /*!
+         * \brief Meshing a section from its blocks, with the bottom half solid and every other block in the top half
+         * filled in
+         */
+        static void BM_greedy_mesh_section(benchmark::State& state) {
+            std::vector<mesher_block_type> block_types(2);
+            block_types[1].is_visible = true;
+            block_types[1].is_opaque = true;
+
+            std::vector<uint16_t> block_ids(PADDED_SECTION_VOLUME, 0);
+            std::vector<uint8_t> light(PADDED_SECTION_VOLUME, 0xF0);
+            for(int y = 1; y <= SECTION_SIZE; y++) {
+                for(int z = 1; z <= SECTION_SIZE; z++) {
+                    for(int x = 1; x <= SECTION_SIZE; x++) {
+                        const bool solid = y <= SECTION_SIZE / 2 || (x + y + z) % 2 == 0;
+                        block_ids[padded_block_index(x, y, z)] = solid ? 1 : 0;
+                    }
+                }
+            }
+
+            greedy_mesher mesher;
+            std::vector<int> vertex_data;
+            std::vector<int> indices;
+            for(auto _ : state) {
+                mesher.load_section(block_ids.data(), light.data(), block_types);
+                mesher.mesh(0, state.range(0) != 0, vertex_data, indices);
+                benchmark::DoNotOptimize(indices.data());
+            }
+            state.counters["quads"] = static_cast<double>(indices.size() / 6);
+        }
+        BENCHMARK(BM_greedy_mesh_section)->Arg(0)->Arg(1);
+
+        /*!
+         * \brief How many chunks each mesh store is given before it's thrown away. Nothing uploads the chunks without a
+         * GL context, so they pile up until the store is remade
+         */
+        static const int CHUNKS_PER_MESH_STORE = 1024;
+
+        static mc_chunk_render_object make_chunk(std::vector<int>& mc_vertex_data, std::vector<int>& indices, int id) {
+            mc_chunk_render_object chunk = {};
+            chunk.format = 2;   // POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT
+            chunk.x = static_cast<float>(id % 16 * 16);
+            chunk.y = 64;
+            chunk.z = static_cast<float>(id / 16 % 16 * 16);
+            chunk.id = id;
+            chunk.vertex_data = mc_vertex_data.data();
+            chunk.vertex_buffer_size = static_cast<int>(mc_vertex_data.size());
+            chunk.indices = indices.data();
+            chunk.index_buffer_size = static_cast<int>(indices.size());
+            return chunk;
+        }
+
+        /*!
+         * \brief What one of Minecraft's chunk builder threads pays for mesh_store#add_chunk_render_object: copying the
+         * section and queueing its conversion. The conversions run on the mesh store's own workers, like they do in
+         * Nova, and throwing the mesh store away waits for them, outside the timing
+         */
+        static void BM_add_chunk_render_object(benchmark::State& state) {
+            std::vector<int> mc_vertex_data;
+            std::vector<int> indices;
+            make_chunk_section(static_cast<int>(state.range(0)), mc_vertex_data, indices);
+
+            auto meshes = std::make_unique<mesh_store>();
+            shader_id shader = meshes->get_shader_id("gbuffers_terrain");
+            int num_added = 0;
+            for(auto _ : state) {
+                auto chunk = make_chunk(mc_vertex_data, indices, num_added);
+                meshes->add_chunk_render_object(shader, chunk);
+
+                if(++num_added == CHUNKS_PER_MESH_STORE) {
+                    state.PauseTiming();
+                    meshes = std::make_unique<mesh_store>();
+                    shader = meshes->get_shader_id("gbuffers_terrain");
+                    num_added = 0;
+                    state.ResumeTiming();
+                }
+            }
+            state.SetBytesProcessed(state.iterations() * mc_vertex_data.size() * sizeof(int));
+
+            state.PauseTiming();
+            meshes.reset();
+            state.ResumeTiming();
+        }
+        BENCHMARK(BM_add_chunk_render_object)->Arg(512)->Arg(2048);
+
+        /*!
+         * \brief Sending a whole column's sections with mesh_store#add_chunk_render_objects, which takes the worker
+         * queue's lock once for the batch
+         */
+        static void BM_add_chunk_render_objects(benchmark::State& state) {
+            const auto num_entries = static_cast<int>(state.range(0));
+            std::vector<int> payload;
+            std::vector<int> indices;
+            make_chunk_section(512, payload, indices);
+            const int num_vertex_ints = static_cast<int>(payload.size());
+            payload.insert(payload.end(), indices.begin(), indices.end());
+
+            auto meshes = std::make_unique<mesh_store>();
+            std::vector<mc_chunk_batch_entry> entries(static_cast<size_t>(num_entries));
+            for(int i = 0; i < num_entries; i++) {
+                auto& entry = entries[i];
+                entry.shader_id = static_cast<int>(meshes->get_shader_id("gbuffers_terrain"));
+                entry.format = 2;
+                entry.x = 0;
+                entry.y = static_cast<float>(i * 16);
+                entry.z = 0;
+                entry.id = i;
+                entry.vertex_buffer_size = num_vertex_ints;
+                entry.index_offset = num_vertex_ints;
+                entry.index_buffer_size = static_cast<int>(indices.size());
+            }
+
+            int num_added = 0;
+            for(auto _ : state) {
+                meshes->add_chunk_render_objects(entries.data(), entries.size(), payload.data(), payload.size());
+
+                num_added += num_entries;
+                if(num_added >= CHUNKS_PER_MESH_STORE) {
+                    state.PauseTiming();
+                    meshes = std::make_unique<mesh_store>();
+                    meshes->get_shader_id("gbuffers_terrain");
+                    num_added = 0;
+                    state.ResumeTiming();
+                }
+            }
+            state.SetItemsProcessed(state.iterations() * num_entries);
+
+            state.PauseTiming();
+            meshes.reset();
+            state.ResumeTiming();
+        }
+        BENCHMARK(BM_add_chunk_render_objects)->Arg(16)->Arg(64);
+
+        /*!
+         * \brief What a chunk builder thread pays for mesh_store#remove_chunk_render_object. Removals are applied on
+         * the render thread, which needs a GL context, so nova-bench --chunk-stress times that side
+         */
+        static void BM_remove_chunk_render_object(benchmark::State& state) {
+            auto meshes = std::make_unique<mesh_store>();
+            shader_id shader = meshes->get_shader_id("gbuffers_terrain");
+            std::vector<int> no_data;
+            int num_removed = 0;
+            for(auto _ : state) {
+                auto chunk = make_chunk(no_data, no_data, num_removed);
+                meshes->remove_chunk_render_object(shader, chunk);
+
+                if(++num_removed == CHUNKS_PER_MESH_STORE * 64) {
+                    state.PauseTiming();
+                    meshes = std::make_unique<mesh_store>();
+                    shader = meshes->get_shader_id("gbuffers_terrain");
+                    num_removed = 0;
+                    state.ResumeTiming();
+                }
+            }
+            state.SetItemsProcessed(state.iterations());
+
+            state.PauseTiming();
+            meshes.reset();
+            state.ResumeTiming();
+        }
+        BENCHMARK(BM_remove_chunk_render_object);
+
+        /*!
+         * \brief Culling with camera#has_object_in_frustum, one box at a time
+         */
+        static void BM_camera_frustum_test(benchmark::State& state) {
+            auto boxes = make_chunk_boxes(static_cast<size_t>(state.range(0)));
+            camera player_camera = make_camera();
+
+            for(auto _ : state) {
+                size_t num_visible = 0;
+                for(auto& box : boxes) {
+                    num_visible += player_camera.has_object_in_frustum(box) ? 1 : 0;
+                }
+                benchmark::DoNotOptimize(num_visible);
+            }
+            state.SetItemsProcessed(state.iterations() * boxes.size());
+        }
+        BENCHMARK(BM_camera_frustum_test)->Arg(10000)->Arg(100000);
+
+        /*!
+         * \brief Culling with the aabb_table that mesh_store#cull_meshes_for_shader uses
+         */
+        static void BM_aabb_table_cull(benchmark::State& state) {
+            const auto boxes = make_chunk_boxes(static_cast<size_t>(state.range(0)));
+            aabb_table table;
+            for(const auto& box : boxes) {
+                table.push_back(box);
+            }
+            camera player_camera = make_camera();
+
+            std::vector<uint32_t> visible;
+            for(auto _ : state) {
+                table.cull(player_camera.get_frustum(), visible);
+                benchmark::DoNotOptimize(visible.data());
+            }
+            state.SetItemsProcessed(state.iterations() * boxes.size());
+        }
+        BENCHMARK(BM_aabb_table_cull)->Arg(10000)->Arg(100000);
+
+        /*!
+         * \brief An RGBA image of smooth gradients with a little noise, like most block textures
+         */
+        static std::vector<uint8_t> make_atlas_pixels(int size) {
+            std::vector<uint8_t> pixels(static_cast<size_t>(size) * size * 4);
+            std::mt19937 rng(1234);
+            for(size_t i = 0; i < pixels.size(); i++) {
+                pixels[i] = static_cast<uint8_t>((i / 4 % size) * 239 / size + rng() % 16);
+            }
+            return pixels;
+        }
+
+        /*!
+         * \brief Compressing a color atlas, which is the CPU side of texture_manager#add_texture when compressTextures
+         * is on
+         */
+        static void BM_compress_bc7(benchmark::State& state) {
+            const auto size = static_cast<int>(state.range(0));
+            const auto pixels = make_atlas_pixels(size);
+
+            for(auto _ : state) {
+                auto compressed = compress_bc7(pixels.data(), size, size);
+                benchmark::DoNotOptimize(compressed.data());
+            }
+            state.SetBytesProcessed(state.iterations() * pixels.size());
+        }
+        BENCHMARK(BM_compress_bc7)->Arg(256)->Arg(1024);
+
+        /*!
+         * \brief Compressing a normal map atlas
+         */
+        static void BM_compress_bc5(benchmark::State& state) {
+            const auto size = static_cast<int>(state.range(0));
+            const auto pixels = make_atlas_pixels(size);
+
+            for(auto _ : state) {
+                auto compressed = compress_bc5(pixels.data(), size, size, 4);
+                benchmark::DoNotOptimize(compressed.data());
+            }
+            state.SetBytesProcessed(state.iterations() * pixels.size());
+        }
+        BENCHMARK(BM_compress_bc5)->Arg(256)->Arg(1024);
+    }
+}
+
+BENCHMARK_MAIN();
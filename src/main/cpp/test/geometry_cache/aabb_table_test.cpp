@@ -0,0 +1,86 @@
+/*!
+ * \brief Tests that the aabb_table culls exactly the same boxes as camera::has_object_in_frustum
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <gtest/gtest.h>
+#include <random>
+#include "../../geometry_cache/aabb_table.h"
+#include "../../render/objects/camera.h"
+
+namespace nova {
+    namespace test {
+        /*!
+         * \brief Makes a bunch of chunk-sized boxes scattered around the camera, and a camera looking at some of them
+         */
+        class aabb_table_test : public ::testing::Test {
+        protected:
+            camera test_camera;
+            std::vector<aabb> boxes;
+            aabb_table table;
+
+            void SetUp() override {
+                test_camera.position = {10, 70, -30};
+                test_camera.rotation = {35, 20};
+                test_camera.far_plane = 256;
+                test_camera.recalculate_frustum();
+
+                // A fixed seed so any failure is reproducible. 1003 boxes means the SIMD paths have a scalar tail
+                std::mt19937 rng(1234);
+                std::uniform_real_distribution<float> position(-300, 300);
+                std::uniform_real_distribution<float> size(0.5f, 16);
+
+                for(int i = 0; i < 1003; i++) {
+                    aabb box = {};
+                    box.center = {position(rng), position(rng) * 0.5f + 64, position(rng)};
+                    box.extents = {size(rng), size(rng), size(rng)};
+
+                    boxes.push_back(box);
+                    table.push_back(box);
+                }
+            }
+
+            std::vector<uint32_t> get_expected_visible_indices() {
+                std::vector<uint32_t> expected;
+                for(uint32_t i = 0; i < boxes.size(); i++) {
+                    if(test_camera.has_object_in_frustum(boxes[i])) {
+                        expected.push_back(i);
+                    }
+                }
+                return expected;
+            }
+        };
+
+        TEST_F(aabb_table_test, cull_matches_camera_test) {
+            auto expected = get_expected_visible_indices();
+            ASSERT_FALSE(expected.empty());
+            ASSERT_LT(expected.size(), boxes.size());
+
+            std::vector<uint32_t> visible;
+            table.cull(test_camera.get_frustum(), visible);
+
+            ASSERT_EQ(expected, visible);
+        }
+
+        TEST_F(aabb_table_test, cull_scalar_matches_camera_test) {
+            auto expected = get_expected_visible_indices();
+
+            std::vector<uint32_t> visible;
+            table.cull_scalar(test_camera.get_frustum(), visible);
+
+            ASSERT_EQ(expected, visible);
+        }
+
+        TEST_F(aabb_table_test, copy_and_resize_test) {
+            table.copy(5, 0);
+            table.resize(1);
+
+            std::vector<uint32_t> visible;
+            table.cull_scalar(test_camera.get_frustum(), visible);
+
+            ASSERT_EQ(test_camera.has_object_in_frustum(boxes[5]) ? 1 : 0, visible.size());
+        }
+    }
+}
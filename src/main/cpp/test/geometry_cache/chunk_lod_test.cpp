@@ -0,0 +1,116 @@
+/*!
+ * \brief Tests for making simplified chunk meshes and picking between them
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstring>
+#include "../../geometry_cache/chunk_lod.h"
+
+namespace nova {
+    namespace test {
+        /*!
+         * \brief Appends a vertex in Minecraft's 7-int block format
+         */
+        static void add_vertex(std::vector<int>& vertex_data, float x, float y, float z) {
+            int vertex[7] = {};
+            const float position[3] = {x, y, z};
+            std::memcpy(vertex, position, sizeof(position));
+            vertex_data.insert(vertex_data.end(), vertex, vertex + 7);
+        }
+
+        /*!
+         * \brief Makes the top faces of a 16x16 flat floor of blocks, two triangles per block
+         */
+        static void make_floor(std::vector<int>& vertex_data, std::vector<int>& indices) {
+            for(int x = 0; x < 16; x++) {
+                for(int z = 0; z < 16; z++) {
+                    const int first = static_cast<int>(vertex_data.size() / 7);
+                    add_vertex(vertex_data, x, 1, z);
+                    add_vertex(vertex_data, x + 1, 1, z);
+                    add_vertex(vertex_data, x + 1, 1, z + 1);
+                    add_vertex(vertex_data, x, 1, z + 1);
+
+                    indices.insert(indices.end(), {first, first + 1, first + 2, first, first + 2, first + 3});
+                }
+            }
+        }
+
+        TEST(chunk_lod_test, simplify_merges_vertices_and_drops_triangles) {
+            std::vector<int> vertex_data;
+            std::vector<int> indices;
+            make_floor(vertex_data, indices);
+
+            std::vector<int> lod_vertex_data;
+            std::vector<int> lod_indices;
+            simplify_chunk_mesh(vertex_data, indices, 4, lod_vertex_data, lod_indices);
+
+            // The floor's corners snap to a 5x5 grid of points, which can hold at most 4x4 quads
+            EXPECT_EQ(lod_vertex_data.size(), 5u * 5u * 7u);
+            EXPECT_LT(lod_indices.size(), indices.size() / 4);
+            EXPECT_EQ(lod_indices.size() % 3, 0u);
+
+            for(size_t i = 0; i < lod_indices.size(); i += 3) {
+                EXPECT_NE(lod_indices[i], lod_indices[i + 1]);
+                EXPECT_NE(lod_indices[i + 1], lod_indices[i + 2]);
+                EXPECT_NE(lod_indices[i], lod_indices[i + 2]);
+                EXPECT_LT(static_cast<size_t>(lod_indices[i]), lod_vertex_data.size() / 7);
+            }
+        }
+
+        TEST(chunk_lod_test, simplify_keeps_vertices_on_the_grid) {
+            std::vector<int> vertex_data;
+            std::vector<int> indices;
+            make_floor(vertex_data, indices);
+
+            std::vector<int> lod_vertex_data;
+            std::vector<int> lod_indices;
+            simplify_chunk_mesh(vertex_data, indices, 2, lod_vertex_data, lod_indices);
+
+            for(size_t i = 0; i < lod_vertex_data.size(); i += 7) {
+                float position[3];
+                std::memcpy(position, &lod_vertex_data[i], sizeof(position));
+                for(float component : position) {
+                    EXPECT_FLOAT_EQ(std::fmod(component, 2.0f), 0);
+                }
+            }
+        }
+
+        TEST(chunk_lod_test, selection_gets_coarser_as_the_section_shrinks) {
+            chunk_lod_settings settings;
+            settings.screen_size_threshold = 0.2f;
+            settings.hysteresis = 0.1f;
+
+            EXPECT_EQ(select_chunk_lod(1.0f, 0, 3, settings), 0u);
+            EXPECT_EQ(select_chunk_lod(0.15f, 0, 3, settings), 1u);
+            EXPECT_EQ(select_chunk_lod(0.01f, 0, 3, settings), 2u);
+            EXPECT_EQ(select_chunk_lod(0.01f, 0, 1, settings), 0u);
+        }
+
+        TEST(chunk_lod_test, selection_has_hysteresis) {
+            chunk_lod_settings settings;
+            settings.screen_size_threshold = 0.2f;
+            settings.hysteresis = 0.1f;
+
+            // Just under the threshold isn't far enough to switch from level 0, and just over it isn't far enough to
+            // switch back from level 1
+            EXPECT_EQ(select_chunk_lod(0.19f, 0, 3, settings), 0u);
+            EXPECT_EQ(select_chunk_lod(0.21f, 1, 3, settings), 1u);
+            EXPECT_EQ(select_chunk_lod(0.23f, 1, 3, settings), 0u);
+        }
+
+        TEST(chunk_lod_test, screen_size_shrinks_with_distance) {
+            aabb box = {};
+            box.center = {0, 0, 0};
+            box.extents = {8, 8, 8};
+
+            const float near_size = get_screen_size(box, {0, 0, 50}, 70);
+            const float far_size = get_screen_size(box, {0, 0, 100}, 70);
+            EXPECT_NEAR(near_size, far_size * 2, 0.0001f);
+            EXPECT_GT(get_screen_size(box, {1, 1, 1}, 70), 1);
+        }
+    }
+}
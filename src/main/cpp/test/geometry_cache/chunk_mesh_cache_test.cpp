@@ -0,0 +1,140 @@
+/*!
+ * \brief Tests for keeping chunk section meshes on disk
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include "../../geometry_cache/chunk_mesh_cache.h"
+
+namespace nova {
+    namespace test {
+        class chunk_mesh_cache_test : public ::testing::Test {
+        protected:
+            const std::string cache_path = "chunk_mesh_cache_test.nmc";
+            const uint64_t max_size = 1024 * 1024;
+
+            static chunk_mesh_cache_key make_key(int x, uint64_t content_hash) {
+                return {0, x, 64, -32, content_hash, 77};
+            }
+
+            static std::vector<cached_section_mesh> make_meshes(int seed) {
+                cached_section_mesh mesh;
+                mesh.shader_name = "gbuffers_terrain";
+                mesh.definition.vertex_format = format::TILED_POS_COLOR_UV_LIGHTMAPUV_NORMAL_TILE;
+                for(int i = 0; i < 14 * 4; i++) {
+                    mesh.definition.vertex_data.push_back(seed * 1000 + i);
+                }
+                mesh.definition.indices = {0, 1, 2, 2, 3, 0};
+                return {mesh};
+            }
+
+            void SetUp() override {
+                std::remove(cache_path.c_str());
+            }
+
+            void TearDown() override {
+                std::remove(cache_path.c_str());
+                std::remove((cache_path + ".tmp").c_str());
+            }
+        };
+
+        TEST_F(chunk_mesh_cache_test, sections_are_read_back_after_reopening) {
+            {
+                chunk_mesh_cache cache(cache_path, max_size);
+                cache.save(make_key(16, 5), make_meshes(1));
+                cache.save(make_key(32, 6), {});
+
+                // Entries saved since the file was opened are read back too
+                std::vector<cached_section_mesh> meshes;
+                ASSERT_TRUE(cache.load(make_key(16, 5), meshes));
+                ASSERT_EQ(meshes.size(), 1u);
+                EXPECT_EQ(meshes[0].definition.vertex_data, make_meshes(1)[0].definition.vertex_data);
+            }
+
+            chunk_mesh_cache cache(cache_path, max_size);
+            EXPECT_EQ(cache.get_num_sections(), 2u);
+
+            std::vector<cached_section_mesh> meshes;
+            ASSERT_TRUE(cache.load(make_key(16, 5), meshes));
+            ASSERT_EQ(meshes.size(), 1u);
+            EXPECT_EQ(meshes[0].shader_name, "gbuffers_terrain");
+            EXPECT_EQ(meshes[0].definition.vertex_format, format::TILED_POS_COLOR_UV_LIGHTMAPUV_NORMAL_TILE);
+            EXPECT_EQ(meshes[0].definition.vertex_data, make_meshes(1)[0].definition.vertex_data);
+            EXPECT_EQ(meshes[0].definition.indices, make_meshes(1)[0].definition.indices);
+            EXPECT_EQ(meshes[0].definition.position, glm::vec3(16, 64, -32));
+
+            // A section with nothing in it is still a hit, so it doesn't get meshed again
+            ASSERT_TRUE(cache.load(make_key(32, 6), meshes));
+            EXPECT_TRUE(meshes.empty());
+        }
+
+        TEST_F(chunk_mesh_cache_test, changed_sections_miss) {
+            chunk_mesh_cache cache(cache_path, max_size);
+            cache.save(make_key(16, 5), make_meshes(1));
+
+            std::vector<cached_section_mesh> meshes;
+            EXPECT_FALSE(cache.load(make_key(16, 6), meshes));
+
+            auto other_resources = make_key(16, 5);
+            other_resources.resource_hash++;
+            EXPECT_FALSE(cache.load(other_resources, meshes));
+
+            auto other_dimension = make_key(16, 5);
+            other_dimension.dimension = -1;
+            EXPECT_FALSE(cache.load(other_dimension, meshes));
+        }
+
+        TEST_F(chunk_mesh_cache_test, newer_entries_replace_older_ones) {
+            {
+                chunk_mesh_cache cache(cache_path, max_size);
+                cache.save(make_key(16, 5), make_meshes(1));
+                cache.save(make_key(16, 8), make_meshes(2));
+            }
+
+            chunk_mesh_cache cache(cache_path, max_size);
+            EXPECT_EQ(cache.get_num_sections(), 1u);
+
+            std::vector<cached_section_mesh> meshes;
+            EXPECT_FALSE(cache.load(make_key(16, 5), meshes));
+            ASSERT_TRUE(cache.load(make_key(16, 8), meshes));
+            EXPECT_EQ(meshes[0].definition.vertex_data, make_meshes(2)[0].definition.vertex_data);
+        }
+
+        TEST_F(chunk_mesh_cache_test, files_that_were_cut_short_keep_their_whole_entries) {
+            {
+                chunk_mesh_cache cache(cache_path, max_size);
+                cache.save(make_key(16, 5), make_meshes(1));
+            }
+            {
+                // Half an entry, like a crash in the middle of a write would leave
+                std::ofstream file(cache_path, std::ios::binary | std::ios::app);
+                const char garbage[20] = {1, 2, 3};
+                file.write(garbage, sizeof(garbage));
+            }
+            {
+                chunk_mesh_cache cache(cache_path, max_size);
+                EXPECT_EQ(cache.get_num_sections(), 1u);
+                cache.save(make_key(32, 9), make_meshes(3));
+            }
+
+            chunk_mesh_cache cache(cache_path, max_size);
+            std::vector<cached_section_mesh> meshes;
+            EXPECT_TRUE(cache.load(make_key(16, 5), meshes));
+            EXPECT_TRUE(cache.load(make_key(32, 9), meshes));
+        }
+
+        TEST_F(chunk_mesh_cache_test, full_caches_stop_saving) {
+            chunk_mesh_cache cache(cache_path, 256);
+            cache.save(make_key(16, 5), make_meshes(1));
+            cache.save(make_key(32, 5), make_meshes(2));
+
+            std::vector<cached_section_mesh> meshes;
+            EXPECT_TRUE(cache.load(make_key(16, 5), meshes));
+            EXPECT_FALSE(cache.load(make_key(32, 5), meshes));
+        }
+    }
+}
@@ -0,0 +1,138 @@
+/*!
+ * \brief Tests for culling and merging faces in the native chunk mesher
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <cstring>
+#include <gtest/gtest.h>
+#include "../../geometry_cache/greedy_mesher.h"
+
+namespace nova {
+    namespace test {
+        const uint16_t AIR_ID = 0;
+        const uint16_t STONE_ID = 1;
+        const uint16_t DIRT_ID = 2;
+        const uint16_t GLASS_ID = 3;
+
+        class greedy_mesher_test : public ::testing::Test {
+        protected:
+            greedy_mesher mesher;
+            std::vector<mesher_block_type> block_types;
+            std::vector<uint16_t> block_ids;
+            std::vector<uint8_t> light;
+
+            std::vector<int> vertex_data;
+            std::vector<int> indices;
+
+            void SetUp() override {
+                block_types.resize(4);
+
+                block_types[STONE_ID].is_visible = true;
+                block_types[STONE_ID].is_opaque = true;
+
+                block_types[DIRT_ID] = block_types[STONE_ID];
+                for(auto& tile : block_types[DIRT_ID].tile_rects) {
+                    tile = glm::vec4(0.5f, 0, 0.0625f, 0.0625f);
+                }
+
+                block_types[GLASS_ID].is_visible = true;
+                block_types[GLASS_ID].shader = 1;
+
+                block_ids.assign(PADDED_SECTION_VOLUME, AIR_ID);
+                light.assign(PADDED_SECTION_VOLUME, 0xF0);
+            }
+
+            /*!
+             * \brief Sets a block, in the section's own coordinates
+             */
+            void set_block(int x, int y, int z, uint16_t id) {
+                block_ids[padded_block_index(x + 1, y + 1, z + 1)] = id;
+            }
+
+            size_t mesh(uint32_t shader = 0, bool merge_faces = true) {
+                mesher.load_section(block_ids.data(), light.data(), block_types);
+                mesher.mesh(shader, merge_faces, vertex_data, indices);
+                EXPECT_EQ(vertex_data.size() / TILED_VERTEX_SIZE * 6, indices.size() * 4);
+                return indices.size() / 6;
+            }
+
+            /*!
+             * \brief The brightness of the vertex at the given position on the top of a face, from its red channel
+             */
+            int get_red_at(const glm::vec3& position, int normal_axis) {
+                for(size_t i = 0; i + TILED_VERTEX_SIZE <= vertex_data.size(); i += TILED_VERTEX_SIZE) {
+                    float vertex_position[3];
+                    float normal[3];
+                    std::memcpy(vertex_position, &vertex_data[i], sizeof(vertex_position));
+                    std::memcpy(normal, &vertex_data[i + 7], sizeof(normal));
+                    if(glm::vec3(vertex_position[0], vertex_position[1], vertex_position[2]) == position && normal[normal_axis] > 0) {
+                        return vertex_data[i + 3] & 0xFF;
+                    }
+                }
+                return -1;
+            }
+        };
+
+        TEST_F(greedy_mesher_test, flat_layer_becomes_six_quads) {
+            for(int x = 0; x < SECTION_SIZE; x++) {
+                for(int z = 0; z < SECTION_SIZE; z++) {
+                    set_block(x, 0, z, STONE_ID);
+                }
+            }
+
+            EXPECT_EQ(mesh(), 6u);
+            EXPECT_EQ(mesh(0, false), static_cast<size_t>(SECTION_SIZE * SECTION_SIZE * 2 + SECTION_SIZE * 4));
+        }
+
+        TEST_F(greedy_mesher_test, faces_between_opaque_blocks_are_culled) {
+            set_block(4, 4, 4, STONE_ID);
+            EXPECT_EQ(mesh(), 6u);
+
+            set_block(4, 5, 4, STONE_ID);
+            EXPECT_EQ(mesh(0, false), 10u);
+        }
+
+        TEST_F(greedy_mesher_test, neighboring_sections_hide_faces_on_the_edge) {
+            set_block(0, 0, 0, STONE_ID);
+            block_ids[padded_block_index(0, 1, 1)] = STONE_ID;
+            block_ids[padded_block_index(1, 0, 1)] = STONE_ID;
+
+            EXPECT_EQ(mesh(), 4u);
+        }
+
+        TEST_F(greedy_mesher_test, different_blocks_are_not_merged) {
+            set_block(0, 0, 0, STONE_ID);
+            set_block(1, 0, 0, DIRT_ID);
+
+            // The blocks hide each other's sides, but nothing else can merge
+            EXPECT_EQ(mesh(), 10u);
+
+            set_block(1, 0, 0, STONE_ID);
+            EXPECT_EQ(mesh(), 6u);
+        }
+
+        TEST_F(greedy_mesher_test, corners_next_to_walls_are_darker) {
+            set_block(4, 0, 4, STONE_ID);
+            set_block(5, 1, 4, STONE_ID);
+
+            mesh();
+
+            // The top of the lower block has the wall on its +x side
+            EXPECT_EQ(get_red_at({4, 1, 4}, 1), 255);
+            EXPECT_LT(get_red_at({5, 1, 4}, 1), 255);
+        }
+
+        TEST_F(greedy_mesher_test, blocks_are_split_by_shader) {
+            set_block(0, 0, 0, STONE_ID);
+            set_block(8, 8, 8, GLASS_ID);
+
+            mesher.load_section(block_ids.data(), light.data(), block_types);
+            EXPECT_EQ(mesher.get_shaders().size(), 2u);
+
+            EXPECT_EQ(mesh(0), 6u);
+            EXPECT_EQ(mesh(1), 6u);
+        }
+    }
+}
@@ -0,0 +1,40 @@
+/*!
+ * \brief Tests for the quad index helpers that let chunks skip uploading indices
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include <gtest/gtest.h>
+#include "../../geometry_cache/mesh_definition.h"
+
+namespace nova {
+    namespace test {
+        TEST(mesh_definition_test, quad_indices_leave_out_partial_quads) {
+            std::vector<int> indices = {7};
+            append_quad_indices(4, 9, indices);
+            EXPECT_EQ(indices, std::vector<int>({7, 4, 5, 6, 4, 6, 7, 8, 9, 10, 8, 10, 11}));
+        }
+
+        TEST(mesh_definition_test, only_the_repeated_pattern_is_a_quad_index_list) {
+            std::vector<int> indices;
+            append_quad_indices(0, 12, indices);
+            EXPECT_TRUE(is_quad_index_list(indices.data(), indices.size()));
+            EXPECT_FALSE(is_quad_index_list(indices.data(), indices.size() - 3));
+            EXPECT_FALSE(is_quad_index_list(indices.data(), 0));
+
+            // The same triangles split along the other diagonal
+            indices[6] = 5;
+            indices[7] = 6;
+            indices[8] = 7;
+            EXPECT_FALSE(is_quad_index_list(indices.data(), indices.size()));
+        }
+
+        TEST(mesh_definition_test, chunk_formats_are_quads) {
+            EXPECT_TRUE(is_quad_format(format::POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT));
+            EXPECT_TRUE(is_quad_format(format::PACKED_POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT));
+            EXPECT_TRUE(is_quad_format(format::TILED_POS_COLOR_UV_LIGHTMAPUV_NORMAL_TILE));
+            EXPECT_FALSE(is_quad_format(format::POS_UV));
+        }
+    }
+}
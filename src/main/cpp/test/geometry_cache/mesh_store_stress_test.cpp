@@ -0,0 +1,294 @@
+/*!
+ * \brief Adds and removes chunks from several threads while the test thread uploads them, like Minecraft's chunk
+ * builder threads do while Nova renders, and changes chunks while the upload thread is still writing them. Build with
+ * NOVA_TSAN to have ThreadSanitizer check every access
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <random>
+#include <set>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include <gtest/gtest.h>
+#include "../../render/nova_renderer.h"
+#include "../../render/objects/vertex_formats.h"
+#include "../test_utils.h"
+
+namespace nova {
+    namespace test {
+        class mesh_store_stress_test : public nova_test {};
+
+        static const int NUM_PRODUCER_THREADS = 4;
+        static const int CHUNKS_PER_THREAD = 64;
+        static const int UPDATES_PER_THREAD = 2000;
+
+        static const int NUM_WRITTEN_SECTIONS = 32;
+        static const int NUM_WRITE_ROUNDS = 50;
+        static const int UPDATES_PER_WRITE_BATCH = 64;
+
+        /*!
+         * \brief One quad of Minecraft's 7-int block vertices
+         */
+        static std::vector<int> make_mc_quad() {
+            const float corners[4][3] = {{0, 0, 0}, {1, 0, 0}, {1, 0, 1}, {0, 0, 1}};
+            std::vector<int> vertex_data(4 * mc_block_layout::ints_per_vertex);
+            for(int i = 0; i < 4; i++) {
+                mc_block_vertex vertex = {};
+                std::memcpy(vertex.position, corners[i], sizeof(vertex.position));
+                std::memset(vertex.color, 255, sizeof(vertex.color));
+                std::memcpy(&vertex_data[i * mc_block_layout::ints_per_vertex], &vertex, sizeof(vertex));
+            }
+            return vertex_data;
+        }
+
+        /*!
+         * \brief The same quad in the 13-int layout that direct uploads take
+         */
+        static std::vector<int> make_block_quad() {
+            std::vector<int> vertex_data;
+            widen_vertices<mc_block_layout, block_layout>(make_mc_quad(), vertex_data);
+            return vertex_data;
+        }
+
+        /*!
+         * \brief Direct upload data that has to stay alive until Nova says it's done reading it
+         */
+        struct direct_chunk_data {
+            std::vector<int> vertex_data;
+            std::vector<int> indices;
+            uint64_t ticket;
+        };
+
+        TEST_F(mesh_store_stress_test, concurrent_adds_and_removes_end_in_the_last_state_sent) {
+            auto& meshes = nova_renderer::instance->get_mesh_store();
+
+            // Merged regions replace their chunks' render objects, which would hide the chunks from the check below
+            nlohmann::json settings = {{"regionMerging", false}};
+            meshes.on_config_change(settings);
+
+            const shader_id shader = meshes.get_shader_id("gbuffers_terrain");
+            const std::vector<int> mc_vertices = make_mc_quad();
+            const std::vector<int> block_vertices = make_block_quad();
+            const std::vector<int> quad_indices = {0, 1, 2, 0, 2, 3};
+
+            // Each thread owns its own chunks, so the last update each thread sends for a chunk is the one that sticks
+            std::vector<std::vector<bool>> expected_present(NUM_PRODUCER_THREADS, std::vector<bool>(CHUNKS_PER_THREAD, false));
+            std::atomic<int> num_finished_threads{0};
+
+            std::vector<std::thread> producers;
+            for(int thread_idx = 0; thread_idx < NUM_PRODUCER_THREADS; thread_idx++) {
+                producers.emplace_back([&, thread_idx]() {
+                    std::mt19937 random(static_cast<uint32_t>(thread_idx));
+                    std::deque<direct_chunk_data> direct_chunks;
+
+                    for(int i = 0; i < UPDATES_PER_THREAD; i++) {
+                        const int chunk_idx = static_cast<int>(random() % CHUNKS_PER_THREAD);
+                        mc_chunk_render_object chunk = {};
+                        chunk.format = 2;    // POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT
+                        chunk.x = static_cast<float>(chunk_idx * 16);
+                        chunk.y = 64;
+                        chunk.z = static_cast<float>(thread_idx * 16);
+                        chunk.id = thread_idx * CHUNKS_PER_THREAD + chunk_idx;
+
+                        // Shader IDs are looked up from any thread too
+                        EXPECT_EQ(meshes.get_shader_id("gbuffers_terrain"), shader);
+
+                        const auto action = random() % 4;
+                        if(action == 0) {
+                            meshes.remove_chunk_render_object(shader, chunk);
+                            expected_present[thread_idx][chunk_idx] = false;
+
+                        } else if(action == 1) {
+                            direct_chunks.push_back({block_vertices, quad_indices, 0});
+                            auto& direct = direct_chunks.back();
+                            chunk.vertex_data = direct.vertex_data.data();
+                            chunk.vertex_buffer_size = static_cast<int>(direct.vertex_data.size());
+                            chunk.indices = direct.indices.data();
+                            chunk.index_buffer_size = static_cast<int>(direct.indices.size());
+                            direct.ticket = meshes.add_chunk_render_object_direct(shader, chunk);
+                            expected_present[thread_idx][chunk_idx] = true;
+
+                        } else {
+                            // Minecraft frees its buffers once the call returns, so these are only borrowed
+                            std::vector<int> vertex_data = mc_vertices;
+                            std::vector<int> indices = quad_indices;
+                            chunk.vertex_data = vertex_data.data();
+                            chunk.vertex_buffer_size = static_cast<int>(vertex_data.size());
+                            chunk.indices = indices.data();
+                            chunk.index_buffer_size = static_cast<int>(indices.size());
+                            meshes.add_chunk_render_object(shader, chunk);
+                            expected_present[thread_idx][chunk_idx] = true;
+                        }
+
+                        while(!direct_chunks.empty() && meshes.is_direct_upload_complete(direct_chunks.front().ticket)) {
+                            direct_chunks.pop_front();
+                        }
+                    }
+
+                    while(!direct_chunks.empty()) {
+                        if(meshes.is_direct_upload_complete(direct_chunks.front().ticket)) {
+                            direct_chunks.pop_front();
+                        } else {
+                            std::this_thread::yield();
+                        }
+                    }
+
+                    num_finished_threads++;
+                });
+            }
+
+            // This is the render thread. It uploads and reads the meshes the whole time the producers are sending them
+            const glm::vec3 camera_position(0, 64, 0);
+            size_t num_meshes_seen = 0;
+            while(num_finished_threads < NUM_PRODUCER_THREADS || meshes.has_pending_chunks()) {
+                meshes.upload_new_geometry(camera_position);
+                for(const auto& mesh : meshes.get_meshes_for_shader(shader)) {
+                    num_meshes_seen += mesh.type == geometry_type::block ? 1 : 0;
+                }
+            }
+
+            for(auto& producer : producers) {
+                producer.join();
+            }
+
+            std::set<std::tuple<float, float, float, int>> expected_chunks;
+            for(int thread_idx = 0; thread_idx < NUM_PRODUCER_THREADS; thread_idx++) {
+                for(int chunk_idx = 0; chunk_idx < CHUNKS_PER_THREAD; chunk_idx++) {
+                    if(expected_present[thread_idx][chunk_idx]) {
+                        expected_chunks.emplace(static_cast<float>(chunk_idx * 16), 64.0f,
+                                                static_cast<float>(thread_idx * 16), thread_idx * CHUNKS_PER_THREAD + chunk_idx);
+                    }
+                }
+            }
+
+            std::set<std::tuple<float, float, float, int>> uploaded_chunks;
+            for(const auto& mesh : meshes.get_meshes_for_shader(shader)) {
+                if(mesh.type == geometry_type::block) {
+                    EXPECT_TRUE(uploaded_chunks.emplace(mesh.position.x, mesh.position.y, mesh.position.z, mesh.parent_id).second)
+                        << "Chunk " << mesh.parent_id << " has more than one render object";
+                }
+            }
+
+            EXPECT_EQ(uploaded_chunks, expected_chunks);
+            EXPECT_GT(num_meshes_seen, 0u);
+        }
+
+        TEST_F(mesh_store_stress_test, chunks_changed_while_being_written_end_in_the_last_state_sent) {
+            auto& meshes = nova_renderer::instance->get_mesh_store();
+            auto& uploads = nova_renderer::instance->get_game_window().get_upload_context();
+            if(!uploads.is_running()) {
+                // Without a shared context chunks are written right away, so none are ever in flight
+                return;
+            }
+
+            nlohmann::json settings = {{"regionMerging", false}};
+            meshes.on_config_change(settings);
+            const shader_id shader = meshes.get_shader_id("gbuffers_terrain");
+            const std::vector<int> quad = make_mc_quad();
+            const glm::vec3 camera_position(0, 64, 2048);
+
+            // How many quads each section was last sent with, or 0 if it was last removed
+            std::vector<int> expected_quads(NUM_WRITTEN_SECTIONS, 0);
+            std::mt19937 random(7);
+            auto send_updates = [&]() {
+                for(int i = 0; i < UPDATES_PER_WRITE_BATCH; i++) {
+                    const int section = static_cast<int>(random() % NUM_WRITTEN_SECTIONS);
+                    mc_chunk_render_object chunk = {};
+                    chunk.format = 2;    // POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT
+                    chunk.x = static_cast<float>(section * 16);
+                    chunk.y = 64;
+                    chunk.z = 2048;
+                    chunk.id = 2000 + section;
+
+                    const int num_quads = static_cast<int>(random() % 4);
+                    if(num_quads == 0) {
+                        meshes.remove_chunk_render_object(shader, chunk);
+                        expected_quads[section] = 0;
+                        continue;
+                    }
+
+                    std::vector<int> vertex_data;
+                    std::vector<int> indices;
+                    for(int q = 0; q < num_quads; q++) {
+                        vertex_data.insert(vertex_data.end(), quad.begin(), quad.end());
+                        for(int index : {0, 1, 2, 0, 2, 3}) {
+                            indices.push_back(q * 4 + index);
+                        }
+                    }
+                    chunk.vertex_data = vertex_data.data();
+                    chunk.vertex_buffer_size = static_cast<int>(vertex_data.size());
+                    chunk.indices = indices.data();
+                    chunk.index_buffer_size = static_cast<int>(indices.size());
+                    meshes.add_chunk_render_object(shader, chunk);
+                    expected_quads[section] = num_quads;
+                }
+            };
+
+            const uint64_t bytes_before = meshes.get_chunk_arena().get_bytes_in_use();
+            uint64_t last_completed_ticket = uploads.get_completed_ticket();
+            for(int round = 0; round < NUM_WRITE_ROUNDS; round++) {
+                // Holds the upload thread, so the first batch is still being written when the second one changes it
+                std::promise<void> release_uploads;
+                std::shared_future<void> released = release_uploads.get_future().share();
+                const uint64_t blocker = uploads.submit([released]() { released.wait(); });
+
+                send_updates();
+                while(meshes.has_chunks_being_converted()) {
+                    meshes.upload_new_geometry(camera_position);
+                }
+                meshes.upload_new_geometry(camera_position);
+
+                // Minecraft's builder threads send the next batch while the render thread keeps placing chunks
+                std::atomic<bool> producer_done{false};
+                std::thread producer([&]() {
+                    send_updates();
+                    release_uploads.set_value();
+                    producer_done = true;
+                });
+
+                while(!producer_done || meshes.has_pending_chunks()) {
+                    meshes.upload_new_geometry(camera_position);
+
+                    const uint64_t completed_ticket = uploads.get_completed_ticket();
+                    EXPECT_GE(completed_ticket, last_completed_ticket) << "Upload tickets completed out of order";
+                    last_completed_ticket = completed_ticket;
+                }
+                producer.join();
+                EXPECT_TRUE(uploads.is_complete(blocker));
+
+                std::vector<int> uploaded_quads(NUM_WRITTEN_SECTIONS, 0);
+                for(const auto& mesh : meshes.get_meshes_for_shader(shader)) {
+                    if(mesh.type != geometry_type::block || mesh.parent_id < 2000 || mesh.parent_id >= 2000 + NUM_WRITTEN_SECTIONS) {
+                        continue;
+                    }
+
+                    const int section = mesh.parent_id - 2000;
+                    EXPECT_EQ(uploaded_quads[section], 0) << "Section " << section << " has more than one render object";
+                    uploaded_quads[section] = static_cast<int>(mesh.arena_handle.num_indices / 6);
+                }
+                ASSERT_EQ(uploaded_quads, expected_quads) << "Round " << round << " didn't end in the last state sent";
+            }
+
+            // Writes that were thrown away when they were placed have to give their space back too
+            for(int section = 0; section < NUM_WRITTEN_SECTIONS; section++) {
+                mc_chunk_render_object chunk = {};
+                chunk.x = static_cast<float>(section * 16);
+                chunk.y = 64;
+                chunk.z = 2048;
+                chunk.id = 2000 + section;
+                meshes.remove_chunk_render_object(shader, chunk);
+            }
+            do {
+                meshes.upload_new_geometry(camera_position);
+            } while(meshes.has_pending_chunks());
+            EXPECT_EQ(meshes.get_chunk_arena().get_bytes_in_use(), bytes_before);
+        }
+    }
+}
@@ -5,8 +5,13 @@
  * \date 17-Jan-17.
  */
 
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <thread>
 #include <gtest/gtest.h>
 #include "../../render/nova_renderer.h"
+#include "../../render/objects/vertex_formats.h"
 #include "../test_utils.h"
 #include "../../data_loading/loaders/loaders.h"
 
@@ -14,6 +19,21 @@ namespace nova {
     namespace test {
         class mesh_store_test : public nova_test {};
 
+        /*!
+         * \brief One quad of Minecraft's 7-int block vertices
+         */
+        static std::vector<int> make_mc_quad() {
+            const float corners[4][3] = {{0, 0, 0}, {1, 0, 0}, {1, 0, 1}, {0, 0, 1}};
+            std::vector<int> vertex_data(4 * mc_block_layout::ints_per_vertex);
+            for(int i = 0; i < 4; i++) {
+                mc_block_vertex vertex = {};
+                std::memcpy(vertex.position, corners[i], sizeof(vertex.position));
+                std::memset(vertex.color, 255, sizeof(vertex.color));
+                std::memcpy(&vertex_data[i * mc_block_layout::ints_per_vertex], &vertex, sizeof(vertex));
+            }
+            return vertex_data;
+        }
+
         TEST_F(mesh_store_test, add_gui_geometry_test) {
             auto shaderpack_name = "default";
             auto loaded_shaderpack = std::make_shared<shaderpack>(nova::load_shaderpack(shaderpack_name));
@@ -43,18 +63,304 @@ namespace nova {
 
             meshes.add_gui_buffers(&send_gui_buffer_command);
 
-            auto& gui_meshes = meshes.get_meshes_for_shader("gui");
+            auto& gui_batches = meshes.get_gui_batcher().get_batches();
+
+            ASSERT_EQ(1, gui_batches.size());
+
+            auto& gui_batch = gui_batches[0];
+
+            ASSERT_EQ("gui", gui_batch.atlas_name);
+            ASSERT_EQ(0, gui_batch.first_index);
+            ASSERT_EQ(10, gui_batch.num_indices);
+        }
+
+        TEST_F(mesh_store_test, gui_geometry_with_the_same_atlas_is_merged_test) {
+            nova::mesh_store meshes;
+
+            float vertices[27] = {};
+            int indices[3] = {0, 1, 2};
+
+            mc_gui_geometry gui_command = {};
+            gui_command.texture_name = "textures/gui/widgets.png";
+            gui_command.vertex_buffer = vertices;
+            gui_command.vertex_buffer_size = 27;
+            gui_command.index_buffer = indices;
+            gui_command.index_buffer_size = 3;
+            gui_command.atlas_name = "gui";
+
+            meshes.add_gui_buffers(&gui_command);
+            meshes.add_gui_buffers(&gui_command);
+
+            gui_command.atlas_name = "font";
+            meshes.add_gui_buffers(&gui_command);
+
+            auto& gui_batches = meshes.get_gui_batcher().get_batches();
+
+            ASSERT_EQ(2, gui_batches.size());
+            ASSERT_EQ("gui", gui_batches[0].atlas_name);
+            ASSERT_EQ(0, gui_batches[0].first_index);
+            ASSERT_EQ(6, gui_batches[0].num_indices);
+            ASSERT_EQ("font", gui_batches[1].atlas_name);
+            ASSERT_EQ(6, gui_batches[1].first_index);
+            ASSERT_EQ(3, gui_batches[1].num_indices);
+
+            meshes.remove_gui_render_objects();
+
+            ASSERT_EQ(0, meshes.get_gui_batcher().get_batches().size());
+        }
+
+        TEST_F(mesh_store_test, batch_entries_must_be_inside_the_payload_test) {
+            mc_chunk_batch_entry entry = {};
+            entry.vertex_offset = 4;
+            entry.vertex_buffer_size = 28;
+            entry.index_offset = 32;
+            entry.index_buffer_size = 6;
+            EXPECT_TRUE(mesh_store::is_batch_entry_in_payload(entry, 38));
+            EXPECT_FALSE(mesh_store::is_batch_entry_in_payload(entry, 37));
+
+            entry.index_buffer_size = 0;
+            EXPECT_TRUE(mesh_store::is_batch_entry_in_payload(entry, 32));
+
+            entry.vertex_offset = -1;
+            EXPECT_FALSE(mesh_store::is_batch_entry_in_payload(entry, 38));
+
+            entry.vertex_offset = 2147483600;
+            EXPECT_FALSE(mesh_store::is_batch_entry_in_payload(entry, 38));
+        }
+
+        TEST_F(mesh_store_test, chunk_shader_ids_and_formats_are_checked_test) {
+            auto& meshes = nova_renderer::instance->get_mesh_store();
+            const shader_id terrain = meshes.get_shader_id("gbuffers_terrain");
+
+            EXPECT_TRUE(meshes.has_shader_id(static_cast<int>(terrain)));
+            EXPECT_FALSE(meshes.has_shader_id(-1));
+            EXPECT_FALSE(meshes.has_shader_id(1 << 20));
+
+            EXPECT_TRUE(mesh_store::is_chunk_format_valid(2));
+            EXPECT_FALSE(mesh_store::is_chunk_format_valid(-1));
+            EXPECT_FALSE(mesh_store::is_chunk_format_valid(static_cast<int>(format::all_values().size())));
+        }
+
+        TEST_F(mesh_store_test, chunk_batch_adds_and_removes_chunks_test) {
+            auto& meshes = nova_renderer::instance->get_mesh_store();
+            nlohmann::json settings = {{"regionMerging", false}};
+            meshes.on_config_change(settings);
+
+            const shader_id terrain = meshes.get_shader_id("gbuffers_terrain");
+            const shader_id water = meshes.get_shader_id("gbuffers_water");
+
+            // One quad, which every chunk in the batch shares, then its indices
+            std::vector<int> payload = make_mc_quad();
+            const int num_vertex_ints = static_cast<int>(payload.size());
+            payload.insert(payload.end(), {0, 1, 2, 0, 2, 3});
+
+            auto make_entry = [&](shader_id shader, int id, bool has_geometry) {
+                mc_chunk_batch_entry entry = {};
+                entry.shader_id = static_cast<int>(shader);
+                entry.format = 2;    // POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT
+                entry.x = static_cast<float>(id * 16);
+                entry.y = 64;
+                entry.id = id;
+                if(has_geometry) {
+                    entry.vertex_buffer_size = num_vertex_ints;
+                    entry.index_offset = num_vertex_ints;
+                    entry.index_buffer_size = 6;
+                }
+                return entry;
+            };
+
+            auto count_chunks = [&](shader_id shader) {
+                size_t num_chunks = 0;
+                for(const auto& mesh : meshes.get_meshes_for_shader(shader)) {
+                    num_chunks += mesh.type == geometry_type::block ? 1 : 0;
+                }
+                return num_chunks;
+            };
+
+            auto upload_everything = [&]() {
+                do {
+                    meshes.upload_new_geometry(glm::vec3(0, 64, 0));
+                } while(meshes.has_pending_chunks());
+            };
+
+            std::vector<mc_chunk_batch_entry> entries = {make_entry(terrain, 1, true), make_entry(terrain, 2, true),
+                                                         make_entry(water, 1, true), make_entry(water, 3, true)};
+            // Points past the end of the payload, so it's skipped
+            entries.back().index_offset = static_cast<int>(payload.size());
+
+            // So are chunks with a shader ID or format Nova never gave out
+            entries.push_back(make_entry(terrain, 4, true));
+            entries.back().shader_id = 1 << 20;
+            entries.push_back(make_entry(terrain, 5, true));
+            entries.back().format = 9999;
+
+            meshes.add_chunk_render_objects(entries.data(), entries.size(), payload.data(), payload.size());
+            upload_everything();
+            EXPECT_EQ(count_chunks(terrain), 2u);
+            EXPECT_EQ(count_chunks(water), 1u);
+
+            entries = {make_entry(terrain, 2, false), make_entry(water, 1, false)};
+            meshes.add_chunk_render_objects(entries.data(), entries.size(), payload.data(), payload.size());
+            upload_everything();
+            EXPECT_EQ(count_chunks(terrain), 1u);
+            EXPECT_EQ(count_chunks(water), 0u);
+        }
+
+        TEST_F(mesh_store_test, chunks_are_asked_for_again_when_their_shader_changes_vertex_format_test) {
+            auto& meshes = nova_renderer::instance->get_mesh_store();
+            nlohmann::json settings = {{"regionMerging", false}};
+            meshes.on_config_change(settings);
+
+            // A shader no shaderpack has, so nothing else says which format it takes
+            const shader_id shader = meshes.get_shader_id("packing_test_shader");
+
+            std::vector<int> vertex_data = make_mc_quad();
+            std::vector<int> indices = {0, 1, 2, 0, 2, 3};
+            mc_chunk_render_object chunk = {};
+            chunk.format = 2;    // POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT
+            chunk.x = 32;
+            chunk.y = 64;
+            chunk.z = 48;
+            chunk.id = 7;
+            chunk.vertex_data = vertex_data.data();
+            chunk.vertex_buffer_size = static_cast<int>(vertex_data.size());
+            chunk.indices = indices.data();
+            chunk.index_buffer_size = static_cast<int>(indices.size());
+            meshes.add_chunk_render_object(shader, chunk);
+            do {
+                meshes.upload_new_geometry(glm::vec3(0, 64, 0));
+            } while(meshes.has_pending_chunks());
+
+            mc_chunk_position rebuilds[4] = {};
+            EXPECT_EQ(meshes.take_chunks_to_rebuild(rebuilds, 4), 0u);
+
+            meshes.set_shader_takes_packed_vertices(shader, true);
+            ASSERT_EQ(meshes.take_chunks_to_rebuild(rebuilds, 4), 1u);
+            EXPECT_EQ(rebuilds[0].x, 32);
+            EXPECT_EQ(rebuilds[0].y, 64);
+            EXPECT_EQ(rebuilds[0].z, 48);
+            EXPECT_EQ(rebuilds[0].id, 7);
+
+            // Saying the same thing again doesn't change the format, so there's nothing to rebuild
+            meshes.set_shader_takes_packed_vertices(shader, true);
+            EXPECT_EQ(meshes.take_chunks_to_rebuild(rebuilds, 4), 0u);
+        }
+
+        TEST_F(mesh_store_test, chunks_removed_while_being_written_stay_removed_test) {
+            auto& meshes = nova_renderer::instance->get_mesh_store();
+            auto& uploads = nova_renderer::instance->get_game_window().get_upload_context();
+            if(!uploads.is_running()) {
+                // Without a shared context chunks are written right away, so none are ever in flight
+                return;
+            }
+
+            nlohmann::json settings = {{"regionMerging", false}};
+            meshes.on_config_change(settings);
+            const shader_id shader = meshes.get_shader_id("gbuffers_terrain");
+
+            // Keeps the upload thread busy, so the chunk is still being written when it's removed
+            std::promise<void> release_uploads;
+            std::shared_future<void> released = release_uploads.get_future().share();
+            uploads.submit([released]() { released.wait(); });
+
+            std::vector<int> vertex_data = make_mc_quad();
+            std::vector<int> indices = {0, 1, 2, 0, 2, 3};
+            mc_chunk_render_object chunk = {};
+            chunk.format = 2;    // POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT
+            chunk.x = 16;
+            chunk.y = 64;
+            chunk.z = 16;
+            chunk.id = 11;
+            chunk.vertex_data = vertex_data.data();
+            chunk.vertex_buffer_size = static_cast<int>(vertex_data.size());
+            chunk.indices = indices.data();
+            chunk.index_buffer_size = static_cast<int>(indices.size());
+
+            // The chunk's space in the arena is taken as soon as it's handed to the upload thread
+            const uint64_t bytes_before = meshes.get_chunk_arena().get_bytes_in_use();
+            meshes.add_chunk_render_object(shader, chunk);
+            const auto give_up_time = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+            while(meshes.get_chunk_arena().get_bytes_in_use() == bytes_before && std::chrono::steady_clock::now() < give_up_time) {
+                meshes.upload_new_geometry(glm::vec3(0, 64, 0));
+            }
+            ASSERT_GT(meshes.get_chunk_arena().get_bytes_in_use(), bytes_before);
+
+            // The removal is applied while the chunk is still being written, and then nothing else is in flight
+            meshes.remove_chunk_render_object(shader, chunk);
+            meshes.upload_new_geometry(glm::vec3(0, 64, 0));
+            meshes.upload_new_geometry(glm::vec3(0, 64, 0));
+
+            release_uploads.set_value();
+            uploads.wait_for(uploads.submit([]() {}));
+            while(meshes.has_pending_chunks()) {
+                meshes.upload_new_geometry(glm::vec3(0, 64, 0));
+            }
+
+            for(const auto& mesh : meshes.get_meshes_for_shader(shader)) {
+                EXPECT_FALSE(mesh.type == geometry_type::block && mesh.parent_id == chunk.id)
+                    << "The chunk was placed after it was removed";
+            }
+        }
+
+        TEST_F(mesh_store_test, only_the_newest_waiting_update_for_a_section_is_uploaded_test) {
+            auto& meshes = nova_renderer::instance->get_mesh_store();
+            nlohmann::json settings = {{"regionMerging", false}};
+            meshes.on_config_change(settings);
+            const shader_id shader = meshes.get_shader_id("gbuffers_terrain");
+
+            // Each version of the section has one more quad than the last, so we can tell which one was uploaded
+            std::vector<int> vertex_data;
+            std::vector<int> indices;
+            const std::vector<int> quad = make_mc_quad();
+            mc_chunk_render_object chunk = {};
+            chunk.format = 2;    // POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT
+            chunk.x = 80;
+            chunk.y = 64;
+            chunk.z = 80;
+            chunk.id = 13;
+            auto send_next_version = [&]() {
+                const int first_vertex = static_cast<int>(vertex_data.size()) / mc_block_layout::ints_per_vertex;
+                vertex_data.insert(vertex_data.end(), quad.begin(), quad.end());
+                for(int index : {0, 1, 2, 0, 2, 3}) {
+                    indices.push_back(first_vertex + index);
+                }
+
+                chunk.vertex_data = vertex_data.data();
+                chunk.vertex_buffer_size = static_cast<int>(vertex_data.size());
+                chunk.indices = indices.data();
+                chunk.index_buffer_size = static_cast<int>(indices.size());
+                meshes.add_chunk_render_object(shader, chunk);
+            };
+
+            // Every update has to be waiting before any of them are uploaded
+            const uint64_t superseded_before = meshes.get_num_superseded_uploads();
+            send_next_version();
+            send_next_version();
+            meshes.remove_chunk_render_object(shader, chunk);
+            send_next_version();
+            const auto give_up_time = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+            while(meshes.has_chunks_being_converted() && std::chrono::steady_clock::now() < give_up_time) {
+                std::this_thread::yield();
+            }
+            ASSERT_FALSE(meshes.has_chunks_being_converted());
 
-            ASSERT_EQ(1, gui_meshes.size());
+            do {
+                meshes.upload_new_geometry(glm::vec3(0, 64, 0));
+            } while(meshes.has_pending_chunks());
 
-            auto& gui_mesh = gui_meshes[0];
+            // The first two additions are replaced while they wait, by each other or by the removal, whichever order
+            // the workers finish them in
+            EXPECT_EQ(meshes.get_num_superseded_uploads() - superseded_before, 2u);
 
-            ASSERT_EQ(0, gui_mesh.parent_id);
-            ASSERT_EQ(nova::geometry_type::gui, gui_mesh.type);
-            ASSERT_EQ("gui", gui_mesh.name);
-            ASSERT_EQ("gui", gui_mesh.color_texture);
-            ASSERT_EQ(false, gui_mesh.normalmap.has_value());
-            ASSERT_EQ(false, gui_mesh.data_texture.has_value());
+            const render_object* uploaded = nullptr;
+            for(const auto& mesh : meshes.get_meshes_for_shader(shader)) {
+                if(mesh.type == geometry_type::block && mesh.parent_id == chunk.id) {
+                    EXPECT_EQ(uploaded, nullptr) << "The section was uploaded more than once";
+                    uploaded = &mesh;
+                }
+            }
+            ASSERT_NE(uploaded, nullptr);
+            EXPECT_EQ(uploaded->arena_handle.num_indices, 18u);
         }
 
         TEST_F(mesh_store_test, test_set_shaderpack) {
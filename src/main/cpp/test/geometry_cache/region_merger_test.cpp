@@ -0,0 +1,144 @@
+/*!
+ * \brief Tests for joining chunk section meshes into region meshes
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include "../../geometry_cache/region_merger.h"
+#include "../../geometry_cache/vertex_packing.h"
+
+namespace nova {
+    namespace test {
+        /*!
+         * \brief Makes a section with one triangle in the 13-int format, with its vertices at the given positions
+         */
+        static mesh_definition make_triangle_section(const glm::vec3& position, const glm::vec3 vertices[3]) {
+            mesh_definition section = {};
+            section.vertex_format = format::POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT;
+            section.position = position;
+            for(int i = 0; i < 3; i++) {
+                int vertex[13] = {};
+                std::memcpy(vertex, &vertices[i], sizeof(glm::vec3));
+                section.vertex_data.insert(section.vertex_data.end(), vertex, vertex + 13);
+            }
+            section.indices = {0, 1, 2};
+            return section;
+        }
+
+        TEST(region_merger_test, regions_are_centered_on_four_sections) {
+            EXPECT_EQ(get_region_position({0, 0, 0}), glm::vec3(32, 32, 32));
+            EXPECT_EQ(get_region_position({48, 16, 32}), glm::vec3(32, 32, 32));
+            EXPECT_EQ(get_region_position({64, 0, -16}), glm::vec3(96, 32, -32));
+        }
+
+        TEST(region_merger_test, sections_are_moved_and_reindexed) {
+            const glm::vec3 vertices[3] = {{0, 0, 0}, {16, 0, 0}, {0, 0, 16}};
+            const glm::vec3 region_position = get_region_position({0, 0, 0});
+
+            mesh_definition region = {};
+            region.vertex_format = format::POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT;
+
+            const auto first = make_triangle_section({0, 0, 0}, vertices);
+            const auto second = make_triangle_section({16, 32, 48}, vertices);
+            append_section_to_region(first, first.position - region_position, region);
+            append_section_to_region(second, second.position - region_position, region);
+
+            ASSERT_EQ(region.vertex_data.size(), 6u * 13);
+            EXPECT_EQ(region.indices, std::vector<int>({0, 1, 2, 3, 4, 5}));
+
+            glm::vec3 moved;
+            std::memcpy(&moved, &region.vertex_data[0], sizeof(moved));
+            EXPECT_EQ(moved, glm::vec3(-32, -32, -32));
+
+            std::memcpy(&moved, &region.vertex_data[4 * 13], sizeof(moved));
+            EXPECT_EQ(moved, glm::vec3(0, 0, 16));
+        }
+
+        TEST(region_merger_test, packed_positions_reach_the_region_edges) {
+            std::vector<int> mc_vertex_data(7 * 2, 0);
+            const float corner[3] = {16, 16, 16};
+            std::memcpy(&mc_vertex_data[7], corner, sizeof(corner));
+
+            mesh_definition section = {};
+            section.vertex_format = format::PACKED_POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT;
+            pack_chunk_vertices(mc_vertex_data, {}, section.vertex_data);
+            section.indices = {0, 1, 1};
+
+            mesh_definition region = {};
+            region.vertex_format = section.vertex_format;
+
+            // The section in the region's lowest corner, then the one in its highest corner
+            append_section_to_region(section, {-32, -32, -32}, region);
+            append_section_to_region(section, {16, 16, 16}, region);
+
+            const auto* vertices = reinterpret_cast<const packed_chunk_vertex*>(region.vertex_data.data());
+            EXPECT_EQ(vertices[0].position[0], -32 * POSITION_SCALE);
+            EXPECT_EQ(vertices[1].position[1], -16 * POSITION_SCALE);
+            EXPECT_EQ(vertices[2].position[2], 16 * POSITION_SCALE);
+            EXPECT_EQ(vertices[3].position[0], 32 * POSITION_SCALE);
+            EXPECT_EQ(region.indices, std::vector<int>({0, 1, 1, 2, 3, 3}));
+        }
+
+        TEST(region_merger_test, neighboring_regions_meet_without_a_crack) {
+            std::vector<int> mc_vertex_data(7 * 2, 0);
+            const float corner[3] = {16, 16, 16};
+            std::memcpy(&mc_vertex_data[7], corner, sizeof(corner));
+
+            mesh_definition section = {};
+            section.vertex_format = format::PACKED_POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT;
+            pack_chunk_vertices(mc_vertex_data, {}, section.vertex_data);
+
+            // The last section of one region and the first section of the next one, which share a face at x = 64
+            const glm::vec3 low_section(48, 0, 0);
+            const glm::vec3 high_section(64, 0, 0);
+            const glm::vec3 low_region = get_region_position(low_section);
+            const glm::vec3 high_region = get_region_position(high_section);
+
+            mesh_definition low = {};
+            low.vertex_format = section.vertex_format;
+            append_section_to_region(section, low_section - low_region, low);
+
+            mesh_definition high = {};
+            high.vertex_format = section.vertex_format;
+            append_section_to_region(section, high_section - high_region, high);
+
+            // Decode the positions like the shaders do
+            const auto* low_vertices = reinterpret_cast<const packed_chunk_vertex*>(low.vertex_data.data());
+            const auto* high_vertices = reinterpret_cast<const packed_chunk_vertex*>(high.vertex_data.data());
+            const float low_edge = low_vertices[1].position[0] / POSITION_SCALE + low_region.x;
+            const float high_edge = high_vertices[0].position[0] / POSITION_SCALE + high_region.x;
+            EXPECT_EQ(low_edge, 64);
+            EXPECT_EQ(high_edge, 64);
+        }
+
+        TEST(region_merger_test, quad_sections_get_indices_only_when_mixed_with_indexed_sections) {
+            mesh_definition quads = {};
+            quads.vertex_format = format::POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT;
+            quads.vertex_data.resize(4 * 13, 0);
+
+            mesh_definition region = {};
+            region.vertex_format = quads.vertex_format;
+            append_section_to_region(quads, {0, 0, 0}, region);
+            append_section_to_region(quads, {0, 0, 0}, region);
+            EXPECT_TRUE(region.indices.empty());
+
+            const glm::vec3 vertices[3] = {{0, 0, 0}, {16, 0, 0}, {0, 0, 16}};
+            append_section_to_region(make_triangle_section({0, 0, 0}, vertices), {0, 0, 0}, region);
+            append_section_to_region(quads, {0, 0, 0}, region);
+            EXPECT_EQ(region.indices, std::vector<int>({0, 1, 2, 0, 2, 3,
+                                                        4, 5, 6, 4, 6, 7,
+                                                        8, 9, 10,
+                                                        11, 12, 13, 11, 13, 14}));
+        }
+
+        TEST(region_merger_test, only_chunk_formats_can_be_merged) {
+            EXPECT_TRUE(can_merge_format(format::POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT));
+            EXPECT_TRUE(can_merge_format(format::PACKED_POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT));
+            EXPECT_TRUE(can_merge_format(format::TILED_POS_COLOR_UV_LIGHTMAPUV_NORMAL_TILE));
+            EXPECT_FALSE(can_merge_format(format::POS_UV));
+        }
+    }
+}
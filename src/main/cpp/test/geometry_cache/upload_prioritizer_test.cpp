@@ -0,0 +1,79 @@
+/*!
+ * \brief Tests for ordering chunk uploads by where the camera is going
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include <gtest/gtest.h>
+#include "../../geometry_cache/upload_prioritizer.h"
+
+namespace nova {
+    namespace test {
+        /*!
+         * \brief Flies the camera along +X at the given speed for half a second, looking the way it flies
+         */
+        static void fly_along_x(upload_prioritizer& prioritizer, float blocks_per_second) {
+            for(int frame = 0; frame <= 30; frame++) {
+                const double time = frame / 60.0;
+                prioritizer.add_camera_sample(glm::vec3(static_cast<float>(time) * blocks_per_second, 64, 0), glm::vec3(1, 0, 0), time);
+            }
+        }
+
+        TEST(upload_prioritizer_test, without_samples_sections_are_closest_first) {
+            upload_prioritizer prioritizer;
+            EXPECT_EQ(prioritizer.get_priority(glm::vec3(160, 0, 0)), 0);
+            EXPECT_EQ(prioritizer.get_priority(glm::vec3(16, 0, 0)), 0);
+
+            // The section's center is 8 blocks in from its corner
+            EXPECT_FLOAT_EQ(prioritizer.get_priority(glm::vec3(92, -8, -8), glm::vec3(0)), 100);
+        }
+
+        TEST(upload_prioritizer_test, flying_puts_sections_ahead_before_closer_ones_behind) {
+            upload_prioritizer prioritizer;
+            prioritizer.set_lookahead(1);
+            fly_along_x(prioritizer, 30);
+
+            EXPECT_NEAR(prioritizer.get_velocity().x, 30, 0.01f);
+            EXPECT_NEAR(prioritizer.get_predicted_position().x, 45, 0.01f);
+
+            const glm::vec3 camera_position(15, 64, 0);
+            const float ahead = prioritizer.get_priority(glm::vec3(200, 56, -8), camera_position);
+            const float behind = prioritizer.get_priority(glm::vec3(-120, 56, -8), camera_position);
+            EXPECT_LT(ahead, behind);
+
+            // Sections on the predicted path are needed right away
+            EXPECT_FLOAT_EQ(prioritizer.get_priority(glm::vec3(32, 56, -8), camera_position), 0);
+        }
+
+        TEST(upload_prioritizer_test, nearby_sections_are_never_pushed_back) {
+            upload_prioritizer prioritizer;
+            fly_along_x(prioritizer, 30);
+
+            const glm::vec3 camera_position(15, 64, 0);
+            EXPECT_FLOAT_EQ(prioritizer.get_priority(glm::vec3(-17, 56, -8), camera_position), 24);
+        }
+
+        TEST(upload_prioritizer_test, a_still_camera_heads_the_way_it_looks) {
+            upload_prioritizer prioritizer;
+            for(int frame = 0; frame <= 30; frame++) {
+                prioritizer.add_camera_sample(glm::vec3(0, 64, 0), glm::vec3(0, 0, -1), frame / 60.0);
+            }
+
+            EXPECT_FLOAT_EQ(prioritizer.get_velocity().z, 0);
+            const float in_view = prioritizer.get_priority(glm::vec3(-8, 56, -108));
+            const float behind = prioritizer.get_priority(glm::vec3(-8, 56, 92));
+            EXPECT_FLOAT_EQ(in_view, 100);
+            EXPECT_FLOAT_EQ(behind, 300);
+        }
+
+        TEST(upload_prioritizer_test, teleports_are_not_velocity) {
+            upload_prioritizer prioritizer;
+            fly_along_x(prioritizer, 30);
+            prioritizer.add_camera_sample(glm::vec3(5000, 64, 0), glm::vec3(1, 0, 0), 31 / 60.0);
+
+            EXPECT_FLOAT_EQ(prioritizer.get_velocity().x, 0);
+            EXPECT_FLOAT_EQ(prioritizer.get_predicted_position().x, 5000);
+        }
+    }
+}
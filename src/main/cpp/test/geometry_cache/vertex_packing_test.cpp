@@ -0,0 +1,79 @@
+/*!
+ * \brief Tests for packing Minecraft's block vertices into the packed chunk vertex format
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include <cstring>
+#include <gtest/gtest.h>
+#include "../../geometry_cache/vertex_packing.h"
+
+namespace nova {
+    namespace test {
+        /*!
+         * \brief Adds a vertex in Minecraft's 7-int block format
+         */
+        static void add_mc_vertex(const glm::vec3& position, const glm::vec2& uv, std::vector<int>& mc_vertex_data) {
+            int vertex[7] = {};
+            std::memcpy(&vertex[0], &position, sizeof(position));
+            std::memcpy(&vertex[4], &uv, sizeof(uv));
+            mc_vertex_data.insert(mc_vertex_data.end(), vertex, vertex + 7);
+        }
+
+        static glm::vec3 decode_normal(const packed_chunk_vertex& vertex) {
+            return octahedral_decode({vertex.normal[0] / 127.0f, vertex.normal[1] / 127.0f});
+        }
+
+        static glm::vec3 decode_tangent(const packed_chunk_vertex& vertex) {
+            return octahedral_decode({vertex.tangent[0] / 127.0f, vertex.tangent[1] / 127.0f});
+        }
+
+        static void expect_near(const glm::vec3& actual, const glm::vec3& expected) {
+            EXPECT_NEAR(actual.x, expected.x, 0.02f);
+            EXPECT_NEAR(actual.y, expected.y, 0.02f);
+            EXPECT_NEAR(actual.z, expected.z, 0.02f);
+        }
+
+        TEST(vertex_packing_test, quads_get_their_face_normal_and_u_tangent) {
+            // The top of a block, wound counterclockwise seen from above, with U going along +X
+            std::vector<int> mc_vertex_data;
+            add_mc_vertex({0, 1, 0}, {0, 0}, mc_vertex_data);
+            add_mc_vertex({0, 1, 1}, {0, 1}, mc_vertex_data);
+            add_mc_vertex({1, 1, 1}, {1, 1}, mc_vertex_data);
+            add_mc_vertex({1, 1, 0}, {1, 0}, mc_vertex_data);
+
+            std::vector<int> packed;
+            pack_chunk_vertices(mc_vertex_data, {}, packed);
+            ASSERT_EQ(packed.size(), 4 * sizeof(packed_chunk_vertex) / sizeof(int));
+
+            const auto* vertices = reinterpret_cast<const packed_chunk_vertex*>(packed.data());
+            for(int i = 0; i < 4; i++) {
+                expect_near(decode_normal(vertices[i]), {0, 1, 0});
+                expect_near(decode_tangent(vertices[i]), {1, 0, 0});
+            }
+        }
+
+        TEST(vertex_packing_test, indexed_triangles_set_the_normals_of_their_vertices) {
+            // A face pointing down -Z. The last vertex isn't in a triangle
+            std::vector<int> mc_vertex_data;
+            add_mc_vertex({0, 0, 0}, {0, 0}, mc_vertex_data);
+            add_mc_vertex({0, 1, 0}, {0, 1}, mc_vertex_data);
+            add_mc_vertex({1, 0, 0}, {1, 0}, mc_vertex_data);
+            add_mc_vertex({5, 5, 5}, {0, 0}, mc_vertex_data);
+
+            std::vector<int> packed;
+            pack_chunk_vertices(mc_vertex_data, {0, 1, 2}, packed);
+
+            const auto* vertices = reinterpret_cast<const packed_chunk_vertex*>(packed.data());
+            for(int i = 0; i < 3; i++) {
+                expect_near(decode_normal(vertices[i]), {0, 0, -1});
+                expect_near(decode_tangent(vertices[i]), {1, 0, 0});
+            }
+
+            // Not the +Z that an encoded zero vector would decode to
+            expect_near(decode_normal(vertices[3]), {0, 1, 0});
+            expect_near(decode_tangent(vertices[3]), {1, 0, 0});
+        }
+    }
+}
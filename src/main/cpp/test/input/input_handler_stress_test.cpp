@@ -0,0 +1,84 @@
+/*!
+ * \brief Queues input events on one thread while another dequeues them and a third changes the settings, like GLFW,
+ * Minecraft, and the render thread do. Build with NOVA_TSAN to have ThreadSanitizer check every access
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include <atomic>
+#include <thread>
+#include <gtest/gtest.h>
+#include "../../input/InputHandler.h"
+
+namespace nova {
+    namespace test {
+        static const int NUM_EVENTS = 200000;
+
+        TEST(input_handler_stress_test, events_arrive_in_order_while_settings_change) {
+            input_handler inputs;
+            std::atomic<bool> done_queueing{false};
+
+            // GLFW's thread. Every event counts up, so the consumer can tell if one came out of order
+            std::thread producer([&]() {
+                for(int i = 1; i <= NUM_EVENTS; i++) {
+                    inputs.queue_key_char_event({static_cast<std::uint64_t>(i), 1});
+                    inputs.queue_mouse_position_event({i, i, 1});
+                    if(i % 16 == 0) {
+                        inputs.end_poll();
+                    }
+                }
+                inputs.end_poll();
+                done_queueing = true;
+            });
+
+            // The render thread, which is where settings changes come from
+            std::thread settings_changer([&]() {
+                bool coalesce = false;
+                while(!done_queueing) {
+                    coalesce = !coalesce;
+                    nlohmann::json settings = {{"coalesceMousePositions", coalesce}};
+                    inputs.on_config_change(settings);
+                    std::this_thread::yield();
+                }
+            });
+
+            // Minecraft's thread
+            uint64_t last_char = 0;
+            int last_position = 0;
+            int num_chars = 0;
+            int num_positions = 0;
+            bool drained = false;
+            while(!drained) {
+                const bool was_done = done_queueing;
+
+                bool got_any = false;
+                for(auto e = inputs.dequeue_key_char_event(); e.filled != 0; e = inputs.dequeue_key_char_event()) {
+                    EXPECT_GT(e.unicode_char, last_char);
+                    last_char = e.unicode_char;
+                    num_chars++;
+                    got_any = true;
+                }
+                for(auto e = inputs.dequeue_mouse_position_event(); e.filled != 0; e = inputs.dequeue_mouse_position_event()) {
+                    EXPECT_GT(e.xpos, last_position);
+                    EXPECT_EQ(e.xpos, e.ypos);
+                    last_position = e.xpos;
+                    num_positions++;
+                    got_any = true;
+                }
+
+                // Everything was queued before we looked, so an empty pass means there's nothing left
+                drained = was_done && !got_any;
+            }
+
+            producer.join();
+            settings_changer.join();
+
+            // Events can be dropped if the rings fill up, and mouse positions can be coalesced, but nothing is made up
+            EXPECT_GT(num_chars, 0);
+            EXPECT_LE(num_chars, NUM_EVENTS);
+            EXPECT_GT(num_positions, 0);
+            EXPECT_LE(num_positions, NUM_EVENTS);
+        }
+    }
+}
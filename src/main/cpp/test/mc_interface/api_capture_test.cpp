@@ -0,0 +1,105 @@
+/*!
+ * \brief Tests that captured calls read back the way they were written
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <gtest/gtest.h>
+#include "../../mc_interface/api_capture.h"
+
+namespace nova {
+    namespace test {
+        class api_capture_test : public ::testing::Test {
+        protected:
+            const std::string capture_path = "api_capture_test.novacap";
+
+            std::vector<uint8_t> read_capture() {
+                std::ifstream file(capture_path, std::ios::binary);
+                return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            }
+
+            void TearDown() override {
+                std::remove(capture_path.c_str());
+            }
+        };
+
+        TEST_F(api_capture_test, chunks_and_frames_round_trip) {
+            int vertex_data[7] = {1, 2, 3, 4, 5, 6, 7};
+            int indices[3] = {0, 0, 0};
+
+            mc_chunk_render_object chunk = {};
+            chunk.format = 2;
+            chunk.x = 16;
+            chunk.y = 32;
+            chunk.z = -48;
+            chunk.id = 9;
+            chunk.vertex_data = vertex_data;
+            chunk.vertex_buffer_size = 7;
+            chunk.indices = indices;
+            chunk.index_buffer_size = 3;
+
+            {
+                api_capture capture(capture_path);
+                ASSERT_TRUE(capture.is_open());
+                capture.record_add_chunk_geometry("gbuffers_terrain", 0, chunk, true);
+                capture.record_set_player_camera_transform(1, 2, 3, 90, -10);
+                capture.record_execute_frame();
+            }
+
+            auto data = read_capture();
+            capture_reader reader(data);
+            ASSERT_TRUE(reader.is_valid());
+
+            capture_record record;
+            ASSERT_TRUE(reader.next(record));
+            EXPECT_EQ(record.command, capture_command::add_chunk_geometry);
+            EXPECT_EQ(record.payload.get<uint8_t>(), CAPTURE_CHUNK_BY_FILTER_NAME | CAPTURE_CHUNK_DIRECT);
+            EXPECT_EQ(record.payload.get_string(), "gbuffers_terrain");
+            EXPECT_EQ(record.payload.get<int>(), 0);
+            EXPECT_EQ(record.payload.get<int>(), 2);
+            EXPECT_EQ(record.payload.get<float>(), 16);
+            EXPECT_EQ(record.payload.get<float>(), 32);
+            EXPECT_EQ(record.payload.get<float>(), -48);
+            EXPECT_EQ(record.payload.get<int>(), 9);
+            EXPECT_EQ(record.payload.get_array<int>(), std::vector<int>(vertex_data, vertex_data + 7));
+            EXPECT_EQ(record.payload.get_array<int>().size(), 3u);
+            EXPECT_FALSE(record.payload.overran);
+
+            ASSERT_TRUE(reader.next(record));
+            EXPECT_EQ(record.command, capture_command::set_player_camera_transform);
+            EXPECT_EQ(record.payload.get<double>(), 1);
+
+            ASSERT_TRUE(reader.next(record));
+            EXPECT_EQ(record.command, capture_command::execute_frame);
+
+            EXPECT_FALSE(reader.next(record));
+        }
+
+        TEST_F(api_capture_test, truncated_files_stop_cleanly) {
+            {
+                api_capture capture(capture_path);
+                capture.record_set_string_setting("presentMode", "uncapped");
+            }
+
+            auto data = read_capture();
+            data.resize(data.size() - 4);
+
+            capture_reader reader(data);
+            ASSERT_TRUE(reader.is_valid());
+            capture_record record;
+            EXPECT_FALSE(reader.next(record));
+        }
+
+        TEST_F(api_capture_test, reading_past_a_payload_gives_zeros) {
+            const uint8_t bytes[2] = {1, 2};
+            capture_payload payload(bytes, sizeof(bytes));
+            EXPECT_EQ(payload.get<uint8_t>(), 1);
+            EXPECT_EQ(payload.get<int>(), 0);
+            EXPECT_TRUE(payload.overran);
+        }
+    }
+}
@@ -5,7 +5,10 @@
  * \date 26-Oct-16.
  */
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
+#include <sstream>
 
 #include <gtest/gtest.h>
 #include "../../../render/nova_renderer.h"
@@ -32,7 +35,7 @@ namespace nova {
             // Do the lines we read in make sense? Let's grab a couple and see what's up
             auto line_5 = shader_file[4];
             EXPECT_EQ(line_5.line_num, 5);
-            EXPECT_EQ(line_5.shader_name, shader_path);
+            EXPECT_EQ(shader_file.get_file_name(line_5), shader_path);
             EXPECT_EQ(line_5.line, "layout(std140) uniform per_frame_uniforms {");
         }
         
@@ -48,12 +51,12 @@ namespace nova {
         
             auto line_5 = shader_file[4];
             EXPECT_EQ(line_5.line_num, 3);
-            EXPECT_EQ(line_5.shader_name, "shaderpacks/default/shaders/gui.frag");
+            EXPECT_EQ(shader_file.get_file_name(line_5), "shaderpacks/default/shaders/gui.frag");
             EXPECT_EQ(line_5.line, "layout(binding = 0) uniform sampler2D colortex;");
         
             auto line_83 = shader_file[82];
             EXPECT_EQ(line_83.line_num, 14);
-            EXPECT_EQ(line_83.shader_name, shader_path);
+            EXPECT_EQ(shader_file.get_file_name(line_83), shader_path);
             EXPECT_EQ(line_83.line, "    color = vec3(1, 0, 1);");
         }
         
@@ -83,7 +86,7 @@ namespace nova {
         
             auto line_5 = shader_file[4];
             EXPECT_EQ(line_5.line_num, 5);
-            EXPECT_EQ(line_5.shader_name, "shaderpacks/default/shaders/gui.frag");
+            EXPECT_EQ(shader_file.get_file_name(line_5), "shaderpacks/default/shaders/gui.frag");
             EXPECT_EQ(line_5.line, "layout(std140) uniform per_frame_uniforms {");
         }
         
@@ -104,7 +107,7 @@ namespace nova {
         
             auto line_5 = shader_file[4];
             EXPECT_EQ(line_5.line_num, 5);
-            EXPECT_EQ(line_5.shader_name, "shaderpacks/default/shaders/gui.frag");
+            EXPECT_EQ(shader_file.get_file_name(line_5), "shaderpacks/default/shaders/gui.frag");
             EXPECT_EQ(line_5.line, "layout(std140) uniform per_frame_uniforms {");
         }
         
@@ -118,7 +121,7 @@ namespace nova {
         
             auto line_5 = shader_file[4];
             EXPECT_EQ(line_5.line_num, 5);
-            EXPECT_EQ(line_5.shader_name, "shaderpacks/default/shaders/gui.frag");
+            EXPECT_EQ(shader_file.get_file_name(line_5), "shaderpacks/default/shaders/gui.frag");
             EXPECT_EQ(line_5.line, "layout(std140) uniform per_frame_uniforms {");
         }
         
@@ -132,15 +135,23 @@ namespace nova {
         
             auto line_5 = shader_file[4];
             EXPECT_EQ(line_5.line_num, 3);
-            EXPECT_EQ(line_5.shader_name, "shaderpacks/default/shaders/gui.frag");
+            EXPECT_EQ(shader_file.get_file_name(line_5), "shaderpacks/default/shaders/gui.frag");
             EXPECT_EQ(line_5.line, "layout(binding = 0) uniform sampler2D colortex;");
         
             auto line_33 = shader_file[82];
             EXPECT_EQ(line_33.line_num, 14);
-            EXPECT_EQ(line_33.shader_name, "shaderpacks/default/shaders/gui_with_include.frag");
+            EXPECT_EQ(shader_file.get_file_name(line_33), "shaderpacks/default/shaders/gui_with_include.frag");
             EXPECT_EQ(line_33.line, "    color = vec3(1, 0, 1);");
         }
         
+        TEST(shader_loading, has_shader_file_checks_every_extension) {
+            nova::shader_include_resolver includes;
+            auto shader_path = "shaderpacks/default/shaders/gui";
+
+            EXPECT_FALSE(includes.has_shader_file(shader_path, {".csh", ".comp"}));
+            EXPECT_TRUE(includes.has_shader_file(shader_path, {".comp", ".frag"}));
+        }
+
         TEST(shader_loading, load_sources_from_folder) {
             auto shaderpack_name = "default";
             auto shader_names = std::vector<std::string>{"gui"};
@@ -183,5 +194,123 @@ namespace nova {
             EXPECT_EQ(gui_def.name, def.name);
             EXPECT_EQ(gui_def.fallback_name, def.fallback_name);
         }
+
+        TEST(shader_loading, get_specialization_constants) {
+            auto json = nlohmann::json{
+                    {"shaders", nlohmann::json::array()},
+                    {"options", {
+                            {"shadows", {{"constant_id", 0}, {"value", true}}},
+                            {"shadowQuality", {{"constant_id", 1}, {"value", -2}}},
+                            {"sunBrightness", {{"constant_id", 2}, {"value", 1.5}}},
+                            {"missingId", {{"value", 3}}}
+                    }}
+            };
+
+            auto constants = nova::get_specialization_constants(json);
+            ASSERT_EQ(constants.size(), 3);
+
+            std::sort(constants.begin(), constants.end(), [](auto& a, auto& b) { return a.id < b.id; });
+            EXPECT_EQ(constants[0].value, 1u);
+            EXPECT_EQ(constants[1].value, static_cast<uint32_t>(-2));
+
+            float sun_brightness = 0;
+            std::memcpy(&sun_brightness, &constants[2].value, sizeof(float));
+            EXPECT_EQ(sun_brightness, 1.5f);
+        }
+
+        TEST(shader_loading, get_shader_defines) {
+            auto json = nlohmann::json{
+                    {"shaders", nlohmann::json::array()},
+                    {"defines", {
+                            {"WAVING_PLANTS", {{"default", true}}},
+                            {"SHADOW_QUALITY", {{"values", {"LOW", "MEDIUM", "HIGH"}}, {"default", "HIGH"}}},
+                            {"BLOOM", nlohmann::json::object()},
+                            {"FOG_MODE", {{"values", {"LINEAR", "EXP"}}, {"default", "NOT_A_VALUE"}}},
+                            {"BAD-NAME", nlohmann::json::object()},
+                            {"BAD_VALUES", {{"values", {"1X", "2X"}}}}
+                    }}
+            };
+
+            auto defines = nova::get_shader_defines(json);
+            ASSERT_EQ(defines.size(), 4);
+
+            EXPECT_EQ(defines[0].name, "BLOOM");
+            EXPECT_TRUE(defines[0].is_bool());
+            EXPECT_EQ(defines[0].default_value, "false");
+
+            EXPECT_EQ(defines[1].name, "FOG_MODE");
+            EXPECT_EQ(defines[1].default_value, "LINEAR");
+
+            EXPECT_EQ(defines[2].name, "SHADOW_QUALITY");
+            EXPECT_FALSE(defines[2].is_bool());
+            EXPECT_EQ(defines[2].default_value, "HIGH");
+            EXPECT_TRUE(defines[2].has_value("MEDIUM"));
+            EXPECT_FALSE(defines[2].has_value("true"));
+
+            EXPECT_EQ(defines[3].name, "WAVING_PLANTS");
+            EXPECT_EQ(defines[3].default_value, "true");
+        }
+
+        TEST(shader_loading, get_define_lines_only_has_the_defines_the_shader_uses) {
+            auto json = nlohmann::json{
+                    {"defines", {
+                            {"WAVING_PLANTS", {{"default", true}}},
+                            {"SHADOW_QUALITY", {{"values", {"LOW", "HIGH"}}, {"default", "HIGH"}}},
+                            {"BLOOM", {{"default", true}}}
+                    }}
+            };
+            const auto defines = nova::get_shader_defines(json);
+
+            auto shader_json = nlohmann::json{{"name", "gbuffers_terrain"}, {"filters", "geometry_type::block"}};
+            shader_definition shader(shader_json);
+            std::istringstream vertex_stream("#version 450\n#ifdef WAVING_PLANTS\n#endif\n");
+            shader.vertex_source = nova::read_shader_stream(vertex_stream, "gbuffers_terrain.vert");
+            std::istringstream fragment_stream("#version 450\n#if SHADOW_QUALITY == SHADOW_QUALITY_LOW\n#endif\n"
+                                               "uniform float BLOOM_STRENGTH;\n");
+            shader.fragment_source = nova::read_shader_stream(fragment_stream, "gbuffers_terrain.frag");
+
+            auto lines = nova::get_define_lines(shader, defines, nlohmann::json::object());
+            const std::vector<std::string> default_lines = {
+                    "#define SHADOW_QUALITY_LOW 0",
+                    "#define SHADOW_QUALITY_HIGH 1",
+                    "#define SHADOW_QUALITY SHADOW_QUALITY_HIGH",
+                    "#define WAVING_PLANTS"
+            };
+            EXPECT_EQ(lines, default_lines);
+
+            lines = nova::get_define_lines(shader, defines, {{"SHADOW_QUALITY", "LOW"}, {"WAVING_PLANTS", false}});
+            const std::vector<std::string> chosen_lines = {
+                    "#define SHADOW_QUALITY_LOW 0",
+                    "#define SHADOW_QUALITY_HIGH 1",
+                    "#define SHADOW_QUALITY SHADOW_QUALITY_LOW"
+            };
+            EXPECT_EQ(lines, chosen_lines);
+
+            // A value the define can't have gets the default instead
+            lines = nova::get_define_lines(shader, defines, {{"SHADOW_QUALITY", "ULTRA"}});
+            EXPECT_EQ(lines, default_lines);
+        }
+
+        TEST(shader_loading, read_spirv) {
+            const uint32_t module[] = {0x07230203, 0x00010000, 0, 1, 0};
+            std::string bytes(reinterpret_cast<const char*>(module), sizeof(module));
+
+            std::vector<uint32_t> words;
+            ASSERT_TRUE(nova::read_spirv(bytes, words));
+            EXPECT_EQ(words.size(), 5);
+            EXPECT_EQ(words[1], 0x00010000u);
+
+            // The same module written with the other byte order
+            std::string swapped_bytes = bytes;
+            for(size_t i = 0; i < swapped_bytes.size(); i += 4) {
+                std::reverse(swapped_bytes.begin() + i, swapped_bytes.begin() + i + 4);
+            }
+            ASSERT_TRUE(nova::read_spirv(swapped_bytes, words));
+            EXPECT_EQ(words[0], 0x07230203u);
+            EXPECT_EQ(words[1], 0x00010000u);
+
+            EXPECT_FALSE(nova::read_spirv("#version 450", words));
+            EXPECT_FALSE(nova::read_spirv(bytes.substr(0, 6), words));
+        }
     }
 }
@@ -0,0 +1,72 @@
+/*!
+ * \brief Tests for reading zipped shaderpacks
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include <cstdio>
+#include <cstring>
+
+#include <gtest/gtest.h>
+
+#define MINIZ_HEADER_FILE_ONLY
+#include "miniz.c"
+
+#include "../../../data_loading/loaders/shaderpack_archive.h"
+#include "../../../data_loading/loaders/shader_loading.h"
+
+namespace nova {
+    namespace test {
+        static void add_to_zip(const char* zip_path, const char* name, const char* contents) {
+            ASSERT_TRUE(mz_zip_add_mem_to_archive_file_in_place(zip_path, name, contents, strlen(contents), nullptr, 0,
+                                                                MZ_DEFAULT_COMPRESSION));
+        }
+
+        TEST(shaderpack_archive_test, finds_the_folder_the_pack_is_in) {
+            EXPECT_EQ(shaderpack_archive::find_pack_folder({"shaders.json", "shaders/final.fsh"}), "");
+            EXPECT_EQ(shaderpack_archive::find_pack_folder({"readme.txt", "Pack/shaders/final.fsh",
+                                                            "Pack/shaders/lib/shaders/common.glsl"}), "Pack/");
+            EXPECT_EQ(shaderpack_archive::find_pack_folder({"Pack/shaders.json", "Pack/myshaders.txt"}), "Pack/");
+        }
+
+        TEST(shaderpack_archive_test, normalizes_relative_paths) {
+            EXPECT_EQ(shaderpack_archive::normalize_path("shaderpacks/pack.zip/shaders/lib/../common.glsl"),
+                      "shaderpacks/pack.zip/shaders/common.glsl");
+            EXPECT_EQ(shaderpack_archive::normalize_path("shaderpacks/./pack.zip//shaders/"),
+                      "shaderpacks/pack.zip/shaders/");
+        }
+
+        TEST(shaderpack_archive_test, reads_files_at_their_unzipped_paths) {
+            const char* zip_path = "shaderpack_archive_test.zip";
+            std::remove(zip_path);
+            add_to_zip(zip_path, "Pack/shaders/gui.vsh", "#version 450\n#include \"lib/common.glsl\"\nvoid main() {}");
+            add_to_zip(zip_path, "Pack/shaders/lib/common.glsl", "#define COMMON 1");
+            add_to_zip(zip_path, "Pack/readme.txt", "Not a shader");
+
+            {
+                shaderpack_archive archive(zip_path, "shaderpacks/pack.zip/");
+                ASSERT_TRUE(archive.is_open());
+                EXPECT_TRUE(archive.has_file("shaderpacks/pack.zip/shaders/gui.vsh"));
+                EXPECT_TRUE(archive.has_file("shaderpacks/pack.zip/shaders/lib/../gui.vsh"));
+                EXPECT_FALSE(archive.has_file("shaderpacks/pack.zip/shaders/gui.fsh"));
+
+                std::string contents;
+                ASSERT_TRUE(archive.read_file("shaderpacks/pack.zip/shaders/lib/common.glsl", contents));
+                EXPECT_EQ(contents, "#define COMMON 1");
+
+                const auto shader_files = archive.read_files("shaderpacks/pack.zip/shaders/");
+                EXPECT_EQ(shader_files.size(), 2u);
+                EXPECT_EQ(shader_files.at("shaderpacks/pack.zip/shaders/lib/common.glsl"), "#define COMMON 1");
+
+                // Includes come out of the zip too
+                shader_include_resolver includes(&archive);
+                const auto source = includes.load_shader_file("shaderpacks/pack.zip/shaders/gui", {".vsh"});
+                ASSERT_EQ(source.lines.size(), 3u);
+                EXPECT_EQ(source.lines[1].line, "#define COMMON 1");
+            }
+
+            std::remove(zip_path);
+        }
+    }
+}
@@ -0,0 +1,265 @@
+/*!
+ * \brief Tests that the frame graph culls, aliases, and clears the way it should
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <gtest/gtest.h>
+#include "../../render/frame_graph.h"
+
+namespace nova {
+    namespace test {
+        class frame_graph_test : public ::testing::Test {
+        protected:
+            frame_graph graph;
+
+            void SetUp() override {
+                for(int i = 0; i < 4; i++) {
+                    attachment_description colortex;
+                    colortex.name = "colortex" + std::to_string(i);
+                    colortex.width = 640;
+                    colortex.height = 480;
+                    graph.add_attachment(colortex);
+                }
+
+                attachment_description depthtex;
+                depthtex.name = "depthtex0";
+                depthtex.width = 640;
+                depthtex.height = 480;
+                depthtex.internal_format = GL_DEPTH_COMPONENT32F;
+                graph.add_attachment(depthtex);
+            }
+
+            void add_pass(const std::string& name, std::vector<std::string> reads, std::vector<std::string> writes,
+                          bool covers_whole_target = true) {
+                render_pass_description pass;
+                pass.name = name;
+                pass.reads = std::move(reads);
+                pass.color_writes = std::move(writes);
+                pass.covers_whole_target = covers_whole_target;
+                graph.add_pass(pass);
+            }
+
+            void add_final_pass(std::vector<std::string> reads) {
+                render_pass_description pass;
+                pass.name = "final";
+                pass.reads = std::move(reads);
+                pass.writes_to_backbuffer = true;
+                pass.covers_whole_target = true;
+                graph.add_pass(pass);
+            }
+        };
+
+        TEST_F(frame_graph_test, culls_passes_nothing_reads) {
+            add_pass("gbuffers", {}, {"colortex0"}, false);
+            add_pass("unused_composite", {"colortex0"}, {"colortex1"});
+            add_final_pass({"colortex0"});
+
+            graph.build_plan();
+
+            const auto& live_passes = graph.get_compiled_passes();
+            ASSERT_EQ(live_passes.size(), 2);
+            EXPECT_EQ(live_passes[0].description_idx, 0);
+            EXPECT_EQ(live_passes[1].description_idx, 2);
+            EXPECT_EQ(graph.get_physical_texture_idx("colortex1"), -1);
+        }
+
+        TEST_F(frame_graph_test, unread_outputs_get_no_texture) {
+            add_pass("gbuffers", {}, {"colortex0", "colortex1", "colortex2"}, false);
+            add_final_pass({"colortex0"});
+
+            graph.build_plan();
+
+            const auto& gbuffers = graph.get_compiled_passes()[0];
+            ASSERT_EQ(gbuffers.color_textures.size(), 3);
+            EXPECT_GE(gbuffers.color_textures[0], 0);
+            EXPECT_EQ(gbuffers.color_textures[1], -1);
+            EXPECT_EQ(gbuffers.color_textures[2], -1);
+            EXPECT_EQ(graph.get_num_physical_textures(), 1);
+        }
+
+        TEST_F(frame_graph_test, attachments_with_disjoint_lifetimes_share_a_texture) {
+            add_pass("gbuffers", {}, {"colortex0"}, false);
+            add_pass("composite", {"colortex0"}, {"colortex1"});
+            add_pass("composite1", {"colortex1"}, {"colortex2"});
+            add_final_pass({"colortex2"});
+
+            graph.build_plan();
+
+            EXPECT_EQ(graph.get_compiled_passes().size(), 4);
+            EXPECT_EQ(graph.get_num_physical_textures(), 2);
+            EXPECT_EQ(graph.get_physical_texture_idx("colortex0"), graph.get_physical_texture_idx("colortex2"));
+            EXPECT_NE(graph.get_physical_texture_idx("colortex0"), graph.get_physical_texture_idx("colortex1"));
+        }
+
+        TEST_F(frame_graph_test, attachments_of_different_formats_are_not_aliased) {
+            render_pass_description gbuffers;
+            gbuffers.name = "gbuffers";
+            gbuffers.color_writes = {"colortex0"};
+            gbuffers.depth_write = "depthtex0";
+            graph.add_pass(gbuffers);
+
+            add_pass("composite", {"depthtex0"}, {"colortex1"});
+            add_final_pass({"colortex0", "colortex1"});
+
+            graph.build_plan();
+
+            EXPECT_EQ(graph.get_num_physical_textures(), 3);
+        }
+
+        TEST_F(frame_graph_test, only_partial_first_writes_are_cleared) {
+            add_pass("gbuffers", {}, {"colortex0"}, false);
+            add_pass("composite", {"colortex0"}, {"colortex1"});
+            add_final_pass({"colortex1"});
+
+            graph.build_plan();
+
+            const auto& live_passes = graph.get_compiled_passes();
+            ASSERT_EQ(live_passes.size(), 3);
+            ASSERT_EQ(live_passes[0].attachments_to_clear.size(), 1);
+            EXPECT_EQ(live_passes[0].attachments_to_clear[0], 0);
+            EXPECT_TRUE(live_passes[1].attachments_to_clear.empty());
+            EXPECT_TRUE(live_passes[2].attachments_to_clear.empty());
+        }
+
+        TEST_F(frame_graph_test, fullscreen_writes_hide_earlier_writes) {
+            add_pass("gbuffers", {}, {"colortex0"}, false);
+            add_pass("composite", {}, {"colortex0"});
+            add_final_pass({"colortex0"});
+
+            graph.build_plan();
+
+            const auto& live_passes = graph.get_compiled_passes();
+            ASSERT_EQ(live_passes.size(), 2);
+            EXPECT_EQ(live_passes[0].description_idx, 1);
+        }
+
+        TEST_F(frame_graph_test, barriers_only_follow_image_stores) {
+            add_pass("composite", {}, {"colortex0"});
+
+            render_pass_description image_store_pass;
+            image_store_pass.name = "composite1";
+            image_store_pass.reads = {"colortex0"};
+            image_store_pass.color_writes = {"colortex1"};
+            image_store_pass.covers_whole_target = true;
+            image_store_pass.writes_with_image_stores = true;
+            graph.add_pass(image_store_pass);
+
+            add_final_pass({"colortex1"});
+
+            graph.build_plan();
+
+            const auto& live_passes = graph.get_compiled_passes();
+            ASSERT_EQ(live_passes.size(), 3);
+            EXPECT_EQ(live_passes[0].barrier_bits, 0);
+            EXPECT_EQ(live_passes[1].barrier_bits, 0);
+            EXPECT_NE(live_passes[2].barrier_bits, 0);
+        }
+
+        TEST_F(frame_graph_test, persistent_attachments_are_not_shared_or_cleared) {
+            attachment_description shadowtex;
+            shadowtex.name = "shadowtex0";
+            shadowtex.width = 640;
+            shadowtex.height = 480;
+            shadowtex.persistent = true;
+            graph.add_attachment(shadowtex);
+
+            add_pass("shadow", {}, {"shadowtex0"}, false);
+            add_pass("composite", {"shadowtex0"}, {"colortex0"});
+            add_pass("composite1", {"colortex0"}, {"colortex1"});
+            add_final_pass({"colortex1"});
+
+            graph.build_plan();
+
+            const auto& live_passes = graph.get_compiled_passes();
+            ASSERT_EQ(live_passes.size(), 4);
+            EXPECT_TRUE(live_passes[0].attachments_to_clear.empty());
+            EXPECT_EQ(graph.get_num_physical_textures(), 3);
+            EXPECT_NE(graph.get_physical_texture_idx("shadowtex0"), graph.get_physical_texture_idx("colortex1"));
+        }
+
+        TEST_F(frame_graph_test, last_writer_is_the_last_pass_whose_output_is_kept) {
+            add_pass("gbuffers", {}, {"colortex0", "colortex2"}, false);
+            add_pass("composite", {"colortex0"}, {"colortex0"});
+            add_pass("composite1", {"colortex0", "colortex2"}, {"colortex1", "colortex3"});
+            add_final_pass({"colortex1"});
+
+            graph.build_plan();
+
+            EXPECT_EQ(graph.get_last_writer("colortex0"), "composite");
+            EXPECT_EQ(graph.get_last_writer("colortex1"), "composite1");
+            EXPECT_EQ(graph.get_last_writer("colortex2"), "gbuffers");
+
+            // Nothing reads colortex3, so it's never kept anywhere
+            EXPECT_EQ(graph.get_last_writer("colortex3"), "");
+            EXPECT_EQ(graph.get_last_writer("depthtex0"), "");
+        }
+
+        TEST_F(frame_graph_test, stencil_masks_attach_what_an_earlier_pass_drew) {
+            attachment_description depthstencil;
+            depthstencil.name = "depthstenciltex";
+            depthstencil.width = 640;
+            depthstencil.height = 480;
+            depthstencil.internal_format = GL_DEPTH32F_STENCIL8;
+            graph.add_attachment(depthstencil);
+
+            render_pass_description sky;
+            sky.name = "sky";
+            sky.color_writes = {"colortex3"};
+            sky.stencil_mask = "depthstenciltex";
+            graph.add_pass(sky);
+
+            render_pass_description gbuffers;
+            gbuffers.name = "gbuffers";
+            gbuffers.color_writes = {"colortex0"};
+            gbuffers.depth_write = "depthstenciltex";
+            gbuffers.stencil_mask = "depthstenciltex";
+            graph.add_pass(gbuffers);
+
+            render_pass_description composite;
+            composite.name = "composite";
+            composite.reads = {"colortex0", "colortex3"};
+            composite.color_writes = {"colortex1"};
+            composite.covers_whole_target = true;
+            composite.stencil_mask = "depthstenciltex";
+            graph.add_pass(composite);
+
+            // depthtex0 has no stencil, so it can't mask anything
+            render_pass_description composite1;
+            composite1.name = "composite1";
+            composite1.reads = {"colortex1"};
+            composite1.color_writes = {"colortex2"};
+            composite1.covers_whole_target = true;
+            composite1.stencil_mask = "depthtex0";
+            graph.add_pass(composite1);
+
+            add_final_pass({"colortex2"});
+
+            graph.build_plan();
+
+            const auto& live_passes = graph.get_compiled_passes();
+            ASSERT_EQ(live_passes.size(), 5);
+            const int depthstencil_idx = graph.get_physical_texture_idx("depthstenciltex");
+            ASSERT_GE(depthstencil_idx, 0);
+
+            // Nothing has drawn the mask before the sky
+            EXPECT_FALSE(live_passes[0].is_stencil_masked);
+            EXPECT_EQ(live_passes[0].depth_texture, -1);
+
+            EXPECT_TRUE(live_passes[1].is_stencil_masked);
+            EXPECT_FALSE(live_passes[1].is_stencil_only);
+            EXPECT_EQ(live_passes[1].depth_texture, depthstencil_idx);
+
+            EXPECT_TRUE(live_passes[2].is_stencil_masked);
+            EXPECT_TRUE(live_passes[2].is_stencil_only);
+            EXPECT_EQ(live_passes[2].depth_texture, depthstencil_idx);
+
+            EXPECT_FALSE(live_passes[3].is_stencil_masked);
+            EXPECT_EQ(live_passes[3].depth_texture, -1);
+
+            // The mask keeps its texture until the composite is done with it
+            EXPECT_NE(graph.get_physical_texture_idx("colortex1"), depthstencil_idx);
+        }
+    }
+}
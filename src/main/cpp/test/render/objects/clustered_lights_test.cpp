@@ -0,0 +1,87 @@
+/*!
+ * \brief Tests for finding block lights and putting them in clusters
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include <gtest/gtest.h>
+#include "../../../render/objects/clustered_lights.h"
+#include "../../../geometry_cache/greedy_mesher.h"
+
+namespace nova {
+    namespace test {
+        TEST(clustered_lights_test, only_emissive_blocks_inside_the_section_are_lights) {
+            std::vector<uint16_t> block_ids(PADDED_SECTION_VOLUME, 1);
+            block_ids[padded_block_index(1, 1, 1)] = 50;
+            block_ids[padded_block_index(16, 2, 3)] = 89;
+            block_ids[padded_block_index(0, 5, 5)] = 50;     // In the border, so it's the neighbor's light
+
+            std::vector<uint8_t> light_values(90);
+            light_values[50] = 14;
+            light_values[89] = 15;
+
+            std::vector<block_light> lights;
+            clustered_lights::find_section_lights(block_ids.data(), light_values, glm::vec3(32, 0, -16), lights);
+
+            ASSERT_EQ(lights.size(), 2u);
+            EXPECT_EQ(lights[0].block_id, 50);
+            EXPECT_EQ(lights[0].light_value, 14);
+            EXPECT_EQ(lights[0].position, glm::vec3(32.5f, 0.5f, -15.5f));
+            EXPECT_EQ(lights[1].block_id, 89);
+            EXPECT_EQ(lights[1].position, glm::vec3(47.5f, 1.5f, -13.5f));
+        }
+
+        TEST(clustered_lights_test, lights_cover_the_clusters_they_reach) {
+            const glm::vec4 depth_slicing = clustered_lights::get_depth_slicing(0.1f, 64);
+            const glm::vec2 projection_scale(1, 1);
+
+            light_cluster_range range;
+            ASSERT_TRUE(clustered_lights::get_cluster_range(glm::vec4(0, 0, -10, 1), projection_scale, depth_slicing, range));
+            EXPECT_LE(range.min.x, clustered_lights::CLUSTER_COLUMNS / 2);
+            EXPECT_GE(range.max.x, clustered_lights::CLUSTER_COLUMNS / 2 - 1);
+            EXPECT_LT(range.max.x - range.min.x, clustered_lights::CLUSTER_COLUMNS / 2);
+            EXPECT_LE(range.min.z, range.max.z);
+            EXPECT_LT(range.max.z, clustered_lights::CLUSTER_SLICES);
+
+            // Behind the camera, off to the side, and past the far plane
+            EXPECT_FALSE(clustered_lights::get_cluster_range(glm::vec4(0, 0, 10, 1), projection_scale, depth_slicing, range));
+            EXPECT_FALSE(clustered_lights::get_cluster_range(glm::vec4(100, 0, -10, 1), projection_scale, depth_slicing, range));
+            EXPECT_FALSE(clustered_lights::get_cluster_range(glm::vec4(0, 0, -80, 1), projection_scale, depth_slicing, range));
+
+            // A light around the camera lights the whole screen
+            ASSERT_TRUE(clustered_lights::get_cluster_range(glm::vec4(0, 0, 0, 4), projection_scale, depth_slicing, range));
+            EXPECT_EQ(range.min, glm::uvec3(0, 0, 0));
+            EXPECT_EQ(range.max.x, clustered_lights::CLUSTER_COLUMNS - 1);
+            EXPECT_EQ(range.max.y, clustered_lights::CLUSTER_ROWS - 1);
+        }
+
+        TEST(clustered_lights_test, clusters_list_their_lights_in_order) {
+            light_cluster_range first = {glm::uvec3(0, 0, 0), glm::uvec3(1, 0, 0)};
+            light_cluster_range second = {glm::uvec3(1, 0, 0), glm::uvec3(1, 0, 0)};
+
+            std::vector<uint32_t> cluster_data;
+            clustered_lights::bin_lights({first, second}, cluster_data);
+
+            ASSERT_EQ(cluster_data.size(), clustered_lights::NUM_CLUSTERS * 2 + 3);
+            EXPECT_EQ(cluster_data[1], 1u);
+            EXPECT_EQ(cluster_data[cluster_data[0]], 0u);
+            EXPECT_EQ(cluster_data[3], 2u);
+            EXPECT_EQ(cluster_data[cluster_data[2]], 0u);
+            EXPECT_EQ(cluster_data[cluster_data[2] + 1], 1u);
+            EXPECT_EQ(cluster_data[5], 0u);
+        }
+
+        TEST(clustered_lights_test, full_clusters_keep_the_first_lights) {
+            const light_cluster_range range = {glm::uvec3(0, 0, 0), glm::uvec3(0, 0, 0)};
+            std::vector<light_cluster_range> ranges(clustered_lights::MAX_LIGHTS_PER_CLUSTER + 10, range);
+
+            std::vector<uint32_t> cluster_data;
+            clustered_lights::bin_lights(ranges, cluster_data);
+
+            EXPECT_EQ(cluster_data[1], clustered_lights::MAX_LIGHTS_PER_CLUSTER);
+            EXPECT_EQ(cluster_data[cluster_data[0] + clustered_lights::MAX_LIGHTS_PER_CLUSTER - 1],
+                      clustered_lights::MAX_LIGHTS_PER_CLUSTER - 1);
+        }
+    }
+}
@@ -0,0 +1,38 @@
+/*!
+ * \brief Tests for picking the resolution scale from the GPU's frame time
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include <gtest/gtest.h>
+#include "../../../render/frame_graph.h"
+#include "../../../render/objects/dynamic_resolution.h"
+
+namespace nova {
+    namespace test {
+        TEST(dynamic_resolution_test, slow_frames_lower_the_scale) {
+            // Twice as long as the target wants half the pixels (about 0.71x scale), but the scale only drops by 25% at a time
+            EXPECT_FLOAT_EQ(dynamic_resolution::pick_scale(1, 33.2f, 16.6f, 0.25f), 0.75f);
+            EXPECT_FLOAT_EQ(dynamic_resolution::pick_scale(1, 17, 16.6f, 0.25f), 1 - RESOLUTION_SCALE_STEP);
+            EXPECT_FLOAT_EQ(dynamic_resolution::pick_scale(0.5f, 100, 16.6f, 0.5f), 0.5f);
+        }
+
+        TEST(dynamic_resolution_test, fast_frames_raise_the_scale_slowly) {
+            // Four times faster than the target could take twice the scale, but the scale only climbs by about 10% at a time
+            EXPECT_FLOAT_EQ(dynamic_resolution::pick_scale(0.5f, 4, 16.6f, 0.25f), 0.5625f);
+            EXPECT_FLOAT_EQ(dynamic_resolution::pick_scale(1, 4, 16.6f, 0.25f), 1);
+        }
+
+        TEST(dynamic_resolution_test, frames_near_the_target_keep_the_scale) {
+            EXPECT_FLOAT_EQ(dynamic_resolution::pick_scale(0.75f, 15, 16.6f, 0.25f), 0.75f);
+            EXPECT_FLOAT_EQ(dynamic_resolution::pick_scale(0.75f, 16.6f, 16.6f, 0.25f), 0.75f);
+        }
+
+        TEST(dynamic_resolution_test, scaled_sizes_round_up) {
+            EXPECT_EQ(get_scaled_size(glm::uvec2(1920, 1080), 0.5f), glm::uvec2(960, 540));
+            EXPECT_EQ(get_scaled_size(glm::uvec2(1001, 3), 0.5f), glm::uvec2(501, 2));
+            EXPECT_EQ(get_scaled_size(glm::uvec2(100, 100), 0), glm::uvec2(1, 1));
+        }
+    }
+}
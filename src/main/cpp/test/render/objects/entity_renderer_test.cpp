@@ -0,0 +1,67 @@
+/*!
+ * \brief Tests for finding the boxes that entity instances are culled with
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <cstring>
+#include <gtest/gtest.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include "../../../render/objects/entity_renderer.h"
+
+namespace nova {
+    namespace test {
+        static void add_vertex(mesh_definition& definition, glm::vec3 position) {
+            int position_ints[3];
+            std::memcpy(position_ints, &position, sizeof(position_ints));
+            definition.vertex_data.insert(definition.vertex_data.end(), position_ints, position_ints + 3);
+
+            // The UV
+            definition.vertex_data.push_back(0);
+            definition.vertex_data.push_back(0);
+        }
+
+        TEST(entity_renderer_test, model_bounds_cover_every_vertex) {
+            mesh_definition definition;
+            definition.vertex_format = format::POS_UV;
+            add_vertex(definition, {-0.5f, 0, -0.25f});
+            add_vertex(definition, {0.5f, 2, 0.25f});
+            add_vertex(definition, {0, 1, 0});
+
+            const auto bounds = entity_renderer::get_model_bounds(definition);
+            EXPECT_EQ(bounds.center, glm::vec3(0, 1, 0));
+            EXPECT_EQ(bounds.extents, glm::vec3(0.5f, 1, 0.25f));
+        }
+
+        TEST(entity_renderer_test, models_without_float_positions_have_empty_bounds) {
+            mesh_definition definition;
+            definition.vertex_format = format::PACKED_POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT;
+            definition.vertex_data = {1, 2, 3, 4, 5, 6};
+
+            const auto bounds = entity_renderer::get_model_bounds(definition);
+            EXPECT_EQ(bounds.center, glm::vec3(0));
+            EXPECT_EQ(bounds.extents, glm::vec3(0));
+        }
+
+        TEST(entity_renderer_test, instance_bounds_follow_translation_and_scale) {
+            const aabb model_bounds = {glm::vec3(0, 1, 0), glm::vec3(0.5f, 1, 0.25f)};
+            auto transform = glm::translate(glm::mat4(1), glm::vec3(10, 64, -3));
+            transform = glm::scale(transform, glm::vec3(2));
+
+            const auto bounds = entity_renderer::get_instance_bounds(model_bounds, transform);
+            EXPECT_EQ(bounds.center, glm::vec3(10, 66, -3));
+            EXPECT_EQ(bounds.extents, glm::vec3(1, 2, 0.5f));
+        }
+
+        TEST(entity_renderer_test, instance_bounds_grow_to_fit_rotated_models) {
+            const aabb model_bounds = {glm::vec3(0), glm::vec3(1, 1, 0)};
+            const auto transform = glm::rotate(glm::mat4(1), glm::radians(45.0f), glm::vec3(0, 1, 0));
+
+            const auto bounds = entity_renderer::get_instance_bounds(model_bounds, transform);
+            EXPECT_NEAR(bounds.extents.x, 0.7071f, 0.001f);
+            EXPECT_NEAR(bounds.extents.y, 1, 0.001f);
+            EXPECT_NEAR(bounds.extents.z, 0.7071f, 0.001f);
+        }
+    }
+}
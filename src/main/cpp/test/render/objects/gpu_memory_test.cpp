@@ -0,0 +1,51 @@
+/*!
+ * \brief Tests for counting how much GPU memory buffers and textures use
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <gtest/gtest.h>
+#include "../../../render/objects/gpu_memory.h"
+
+namespace nova {
+    namespace test {
+        TEST(gpu_memory_test, tracking_again_replaces_the_old_size) {
+            const auto buffers_before = gpu_memory::get_usage().get(gpu_memory_category::buffers);
+            const auto meshes_before = gpu_memory::get_usage().get(gpu_memory_category::meshes);
+
+            gpu_memory::track_buffer(1001, gpu_memory_category::buffers, 4096);
+            gpu_memory::track_buffer(1001, gpu_memory_category::meshes, 1024);
+            EXPECT_EQ(gpu_memory::get_usage().get(gpu_memory_category::buffers), buffers_before);
+            EXPECT_EQ(gpu_memory::get_usage().get(gpu_memory_category::meshes), meshes_before + 1024);
+
+            gpu_memory::untrack_buffer(1001);
+            gpu_memory::untrack_buffer(1001);
+            EXPECT_EQ(gpu_memory::get_usage().get(gpu_memory_category::meshes), meshes_before);
+        }
+
+        TEST(gpu_memory_test, buffers_and_textures_are_tracked_separately) {
+            const auto total_before = gpu_memory::get_usage().get_total();
+
+            gpu_memory::track_buffer(1002, gpu_memory_category::buffers, 100);
+            gpu_memory::track_texture(1002, gpu_memory_category::textures, 200);
+            EXPECT_EQ(gpu_memory::get_usage().get_total(), total_before + 300);
+
+            gpu_memory::untrack_texture(1002);
+            EXPECT_EQ(gpu_memory::get_usage().get_total(), total_before + 100);
+
+            gpu_memory::untrack_buffer(1002);
+            EXPECT_EQ(gpu_memory::get_usage().get_total(), total_before);
+        }
+
+        TEST(gpu_memory_test, texture_sizes_count_every_mip_level) {
+            EXPECT_EQ(gpu_memory::get_texture_size(GL_RGBA8, 256, 256), 256u * 256 * 4);
+            EXPECT_EQ(gpu_memory::get_texture_size(GL_RGBA8, 4, 4, 3), (16u + 4 + 1) * 4);
+            EXPECT_EQ(gpu_memory::get_texture_size(GL_RGBA16F, 8, 2), 8u * 2 * 8);
+
+            // Block compressed levels are rounded up to whole 4x4 blocks
+            EXPECT_EQ(gpu_memory::get_texture_size(GL_COMPRESSED_RGBA_BPTC_UNORM, 16, 16, 3), (16u + 4 + 1) * 16);
+            EXPECT_EQ(gpu_memory::get_texture_size(GL_COMPRESSED_RED_RGTC1, 6, 6), 4u * 8);
+        }
+    }
+}
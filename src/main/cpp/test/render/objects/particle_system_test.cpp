@@ -0,0 +1,76 @@
+/*!
+ * \brief Tests for picking which particle emitters are spawned each frame
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <gtest/gtest.h>
+#include "../../../render/objects/particle_system.h"
+
+namespace nova {
+    namespace test {
+        static mc_particle_emitter make_emitter(int count, int atlas = 0) {
+            mc_particle_emitter emitter = {};
+            emitter.position[1] = 64;
+            emitter.size = 0.1f;
+            emitter.lifetime = 1;
+            emitter.num_frames = 8;
+            emitter.atlas = atlas;
+            emitter.count = count;
+            return emitter;
+        }
+
+        TEST(particle_system_test, emitters_are_numbered_after_the_ones_before_them) {
+            std::deque<mc_particle_emitter> pending = {make_emitter(10), make_emitter(5, 1), make_emitter(7)};
+            std::vector<particle_emitter_data> batch;
+
+            EXPECT_EQ(particle_system::take_emitters(pending, 2, 16, 100, batch), 22u);
+            EXPECT_TRUE(pending.empty());
+            ASSERT_EQ(batch.size(), 3u);
+            EXPECT_EQ(batch[0].info, glm::uvec4(0, 10, 0, 8));
+            EXPECT_EQ(batch[1].info, glm::uvec4(10, 5, 1, 8));
+            EXPECT_EQ(batch[2].info, glm::uvec4(15, 7, 0, 8));
+            EXPECT_EQ(batch[0].position_spread.y, 64);
+        }
+
+        TEST(particle_system_test, emitters_that_dont_fit_wait_for_the_next_frame) {
+            std::deque<mc_particle_emitter> pending = {make_emitter(60), make_emitter(60), make_emitter(1)};
+            std::vector<particle_emitter_data> batch;
+
+            // The third emitter would fit, but emitters stay in order
+            EXPECT_EQ(particle_system::take_emitters(pending, 1, 16, 100, batch), 60u);
+            EXPECT_EQ(pending.size(), 2u);
+
+            EXPECT_EQ(particle_system::take_emitters(pending, 1, 16, 100, batch), 61u);
+            EXPECT_TRUE(pending.empty());
+        }
+
+        TEST(particle_system_test, emitter_limits_are_kept) {
+            std::deque<mc_particle_emitter> pending = {make_emitter(1), make_emitter(1), make_emitter(1)};
+            std::vector<particle_emitter_data> batch;
+
+            EXPECT_EQ(particle_system::take_emitters(pending, 1, 2, 100, batch), 2u);
+            EXPECT_EQ(pending.size(), 1u);
+        }
+
+        TEST(particle_system_test, huge_emitters_are_cut_down) {
+            std::deque<mc_particle_emitter> pending = {make_emitter(1000)};
+            std::vector<particle_emitter_data> batch;
+
+            EXPECT_EQ(particle_system::take_emitters(pending, 1, 16, 100, batch), 100u);
+            ASSERT_EQ(batch.size(), 1u);
+            EXPECT_EQ(batch[0].info.y, 100u);
+        }
+
+        TEST(particle_system_test, emitters_without_an_atlas_are_dropped) {
+            std::deque<mc_particle_emitter> pending = {make_emitter(3, 4), make_emitter(3, -1), make_emitter(0), make_emitter(2)};
+            std::vector<particle_emitter_data> batch;
+
+            EXPECT_EQ(particle_system::take_emitters(pending, 1, 16, 100, batch), 2u);
+            EXPECT_TRUE(pending.empty());
+            ASSERT_EQ(batch.size(), 1u);
+            EXPECT_EQ(batch[0].info.x, 0u);
+        }
+    }
+}
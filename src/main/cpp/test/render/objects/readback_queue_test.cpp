@@ -0,0 +1,36 @@
+/*!
+ * \brief Tests for the parts of reading images back that don't need the GPU
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <gtest/gtest.h>
+#include "../../../render/objects/readback_queue.h"
+
+namespace nova {
+    namespace test {
+        TEST(readback_queue_test, rows_are_flipped) {
+            std::vector<uint8_t> pixels = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+            readback_queue::flip_rows(pixels, 3);
+            EXPECT_EQ(pixels, std::vector<uint8_t>({7, 8, 9, 4, 5, 6, 1, 2, 3}));
+
+            std::vector<uint8_t> even_rows = {1, 2, 3, 4};
+            readback_queue::flip_rows(even_rows, 1);
+            EXPECT_EQ(even_rows, std::vector<uint8_t>({4, 3, 2, 1}));
+        }
+
+        TEST(readback_queue_test, tickets_stay_pending_until_they_finish) {
+            readback_queue readbacks;
+            const auto first = readbacks.reserve_ticket();
+            const auto second = readbacks.reserve_ticket();
+            EXPECT_NE(first, second);
+            EXPECT_FALSE(readbacks.is_complete(first));
+            EXPECT_FALSE(readbacks.is_complete(second));
+
+            readbacks.fail(first);
+            EXPECT_TRUE(readbacks.is_complete(first));
+            EXPECT_FALSE(readbacks.is_complete(second));
+        }
+    }
+}
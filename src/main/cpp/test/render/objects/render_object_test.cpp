@@ -0,0 +1,53 @@
+/*!
+ * \brief Tests for the tables that hold render objects' names and materials
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include <gtest/gtest.h>
+#include "../../../render/objects/render_object.h"
+
+namespace nova {
+    namespace test {
+        TEST(render_object_test, materials_with_the_same_textures_share_an_id) {
+            material_table materials;
+
+            render_material block_color;
+            block_color.color_texture = "block_color";
+            block_color.color_texture_handle = 4;
+
+            render_material with_normals = block_color;
+            with_normals.normalmap = std::experimental::optional<std::string>("block_normals");
+
+            const material_id first = materials.add(block_color);
+            EXPECT_EQ(materials.add(block_color), first);
+            EXPECT_NE(materials.add(with_normals), first);
+            EXPECT_EQ(materials.size(), 2u);
+
+            EXPECT_EQ(materials.get(first).color_texture_handle, 4u);
+            EXPECT_EQ(materials.get(NO_MATERIAL).color_texture_handle, NO_TEXTURE);
+        }
+
+        TEST(render_object_test, names_are_interned) {
+            name_table names;
+
+            const name_id chunk = names.intern("chunk");
+            EXPECT_EQ(names.intern("chunk"), chunk);
+            EXPECT_NE(names.intern("chunk_region"), chunk);
+            EXPECT_EQ(names.get(chunk), "chunk");
+            EXPECT_EQ(names.get(NO_NAME), "");
+        }
+
+        TEST(render_object_test, moving_keeps_the_ids) {
+            render_object obj;
+            obj.material = 3;
+            obj.name = 5;
+
+            render_object moved(std::move(obj));
+            EXPECT_EQ(moved.material, 3u);
+            EXPECT_EQ(moved.name, 5u);
+            EXPECT_EQ(obj.material, NO_MATERIAL);
+        }
+    }
+}
@@ -28,6 +28,22 @@ namespace nova {
             nova::nova_renderer::deinit();
         }
 
+        TEST(gl_shader_program, compilation_error_maps_lines_to_files) {
+            auto source = nova::shader_source{};
+            source.lines.push_back(nova::shader_line{1, source.get_file_index("gui.frag"), "#version 450"});
+            source.lines.push_back(nova::shader_line{1, source.get_file_index("lib/util.glsl"), "vec3 f() {"});
+            source.lines.push_back(nova::shader_line{3, source.get_file_index("gui.frag"), "void main() {"});
+
+            auto nvidia_message = nova::compilation_error::get_original_line_message("0(2) : error C0000: oops", source);
+            EXPECT_EQ(nvidia_message, "\nIn the original files:\nlib/util.glsl:1: 0(2) : error C0000: oops");
+
+            auto mesa_message = nova::compilation_error::get_original_line_message("0:3(5): error: oops\n", source);
+            EXPECT_EQ(mesa_message, "\nIn the original files:\ngui.frag:3: 0:3(5): error: oops");
+
+            auto no_line_message = nova::compilation_error::get_original_line_message("error: oops", source);
+            EXPECT_EQ(no_line_message, "");
+        }
+
         nlohmann::json get_gui_def_json() {
             return {
                     {"name",     "gui"},
@@ -37,11 +53,11 @@ namespace nova {
         };
 
         void add_shader_source_to_definition(nova::shader_definition &def) {
-            auto version_line = nova::shader_line{0, "gbuffers_basic.vert", "#version 450"};
-            auto lines = std::vector<nova::shader_line>{version_line};
+            auto source = nova::shader_source{};
+            source.lines.push_back(nova::shader_line{0, source.get_file_index("gbuffers_basic.vert"), "#version 450"});
 
-            def.vertex_source = lines;
-            def.fragment_source = lines;
+            def.vertex_source = source;
+            def.fragment_source = source;
         }
     }
 }
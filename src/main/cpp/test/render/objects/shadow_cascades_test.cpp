@@ -0,0 +1,130 @@
+/*!
+ * \brief Tests for fitting the shadow cascades and deciding which of them need to be drawn
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <gtest/gtest.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include "../../../render/objects/shadow_cascades.h"
+
+namespace nova {
+    namespace test {
+        class shadow_cascades_test : public ::testing::Test {
+        protected:
+            shadow_cascades cascades;
+
+            /*!
+             * \brief A camera at the given position, looking down -z
+             */
+            static glm::mat4 make_view(const glm::vec3& position) {
+                return glm::translate(glm::mat4(1), -position);
+            }
+
+            void update(const glm::vec3& camera_position) {
+                cascades.update(make_view(camera_position), 70, 16.0f / 9.0f, 0.1f);
+            }
+
+            void mark_all_rendered() {
+                for(uint32_t i = 0; i < NUM_SHADOW_CASCADES; i++) {
+                    cascades.mark_rendered(i);
+                }
+            }
+
+            void SetUp() override {
+                cascades.set_resolution(2048);
+                cascades.set_shadow_distance(128);
+                cascades.set_light_direction(glm::normalize(glm::vec3(0.3f, 1, 0)));
+            }
+        };
+
+        TEST_F(shadow_cascades_test, each_cascade_covers_its_slice) {
+            update({0, 64, 0});
+
+            float last_split = 0;
+            for(uint32_t i = 0; i < NUM_SHADOW_CASCADES; i++) {
+                const auto& cascade = cascades.get_cascade(i);
+                EXPECT_GT(cascade.split_distance, last_split);
+
+                // A point in the middle of the slice should land inside the cascade's clip space
+                const float depth = (last_split + cascade.split_distance) * 0.5f;
+                const glm::vec4 clip = cascade.view_projection * glm::vec4(0, 64, -depth, 1);
+                EXPECT_LT(std::abs(clip.x / clip.w), 1);
+                EXPECT_LT(std::abs(clip.y / clip.w), 1);
+                EXPECT_LT(std::abs(clip.z / clip.w), 1);
+
+                last_split = cascade.split_distance;
+            }
+
+            EXPECT_NEAR(last_split, 128, 0.01f);
+        }
+
+        TEST_F(shadow_cascades_test, cascades_get_their_own_quarter_of_the_shadow_map) {
+            update({0, 64, 0});
+
+            for(uint32_t i = 0; i < NUM_SHADOW_CASCADES; i++) {
+                const auto& cascade = cascades.get_cascade(i);
+                EXPECT_EQ(cascade.viewport, glm::ivec4((i % 2) * 1024, (i / 2) * 1024, 1024, 1024));
+
+                // The middle of the cascade's clip space is the middle of its tile
+                const glm::vec4 center_of_clip = glm::inverse(cascade.view_projection) * glm::vec4(0, 0, 0, 1);
+                const glm::vec4 texture_coord = cascade.texture_matrix * center_of_clip;
+                EXPECT_NEAR(texture_coord.x / texture_coord.w, (i % 2) * 0.5f + 0.25f, 0.0001f);
+                EXPECT_NEAR(texture_coord.y / texture_coord.w, (i / 2) * 0.5f + 0.25f, 0.0001f);
+            }
+        }
+
+        TEST_F(shadow_cascades_test, far_cascades_stay_cached_when_the_camera_moves_a_little) {
+            update({0, 64, 0});
+            mark_all_rendered();
+
+            update({0.5f, 64, 0.25f});
+            EXPECT_TRUE(cascades.get_cascade(0).needs_render);
+            for(uint32_t i = 1; i < NUM_SHADOW_CASCADES; i++) {
+                EXPECT_FALSE(cascades.get_cascade(i).needs_render);
+            }
+
+            mark_all_rendered();
+            update({200, 64, 0});
+            for(uint32_t i = 1; i < NUM_SHADOW_CASCADES; i++) {
+                EXPECT_TRUE(cascades.get_cascade(i).needs_render);
+            }
+        }
+
+        TEST_F(shadow_cascades_test, only_big_light_changes_redraw_the_cascades) {
+            update({0, 64, 0});
+            mark_all_rendered();
+
+            const glm::vec3 light_direction = cascades.get_light_direction();
+            cascades.set_light_direction(light_direction + glm::vec3(0.001f, 0, 0));
+            update({0, 64, 0});
+            EXPECT_FALSE(cascades.get_cascade(NUM_SHADOW_CASCADES - 1).needs_render);
+
+            cascades.set_light_direction(glm::vec3(-0.3f, 1, 0));
+            update({0, 64, 0});
+            for(uint32_t i = 0; i < NUM_SHADOW_CASCADES; i++) {
+                EXPECT_TRUE(cascades.get_cascade(i).needs_render);
+            }
+        }
+
+        TEST_F(shadow_cascades_test, changed_chunks_only_redraw_the_cascades_that_see_them) {
+            update({0, 64, 0});
+            mark_all_rendered();
+
+            aabb far_away = {};
+            far_away.center = {5000, 64, 5000};
+            far_away.extents = {8, 8, 8};
+            cascades.mark_changed(far_away);
+            for(uint32_t i = 1; i < NUM_SHADOW_CASCADES; i++) {
+                EXPECT_FALSE(cascades.get_cascade(i).needs_render);
+            }
+
+            aabb in_last_slice = {};
+            in_last_slice.center = {0, 64, -100};
+            in_last_slice.extents = {8, 8, 8};
+            cascades.mark_changed(in_last_slice);
+            EXPECT_TRUE(cascades.get_cascade(NUM_SHADOW_CASCADES - 1).needs_render);
+        }
+    }
+}
@@ -0,0 +1,53 @@
+/*!
+ * \brief Tests for the parameters the sky, cloud, and weather shaders build their geometry from
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include <gtest/gtest.h>
+#include "../../../render/objects/sky_renderer.h"
+
+namespace nova {
+    namespace test {
+        TEST(sky_renderer_test, clouds_drift_and_wrap_around_the_pattern) {
+            sky_renderer sky;
+            sky.set_state(100, 0, false);
+            EXPECT_FLOAT_EQ(sky.get_uniforms().cloudOffset.x, 3.0f);
+
+            // A world that's been running for years still gives a small offset
+            const double pattern_ticks = sky_renderer::CLOUD_PATTERN_CELLS * sky_renderer::CLOUD_CELL_SIZE / 0.03;
+            sky.set_state(pattern_ticks * 10000 + 100, 0, false);
+            EXPECT_NEAR(sky.get_uniforms().cloudOffset.x, 3.0f, 0.01f);
+            EXPECT_LT(sky.get_uniforms().skyTime, 24000.0f);
+        }
+
+        TEST(sky_renderer_test, cloud_grid_is_centered_and_capped) {
+            sky_renderer sky;
+            sky.set_cloud_distance(30);
+            EXPECT_EQ(sky.get_uniforms().cloudGridSize, 7);
+
+            const int max_grid_size = sky_renderer::MAX_CLOUD_GRID_SIZE;
+            sky.set_cloud_distance(100000);
+            EXPECT_EQ(sky.get_uniforms().cloudGridSize, max_grid_size);
+
+            sky.set_cloud_distance(0);
+            EXPECT_EQ(sky.get_uniforms().cloudGridSize, 0);
+        }
+
+        TEST(sky_renderer_test, weather_particles_follow_the_rain) {
+            sky_renderer sky;
+            sky.set_max_weather_particles(1000);
+            EXPECT_EQ(sky.get_uniforms().weatherParticleCount, 0);
+
+            sky.set_state(0, 0.5f, true);
+            EXPECT_EQ(sky.get_uniforms().weatherParticleCount, 500);
+            EXPECT_EQ(sky.get_uniforms().snowStrength, 1.0f);
+
+            sky.set_state(0, 3, false);
+            EXPECT_EQ(sky.get_uniforms().weatherParticleCount, 1000);
+            EXPECT_EQ(sky.get_uniforms().weatherStrength, 1.0f);
+            EXPECT_GT(sky.get_uniforms().cloudCoverage, 0.5f);
+        }
+    }
+}
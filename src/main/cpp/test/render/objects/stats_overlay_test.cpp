@@ -0,0 +1,76 @@
+/*!
+ * \brief Tests for the text the stats overlay shows and the font it's drawn with
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <gtest/gtest.h>
+#include "../../../render/objects/stats_overlay.h"
+
+namespace nova {
+    namespace test {
+        TEST(stats_overlay_test, counts_are_shortened) {
+            EXPECT_EQ(format_count(0), "0");
+            EXPECT_EQ(format_count(999), "999");
+            EXPECT_EQ(format_count(12345), "12.3K");
+            EXPECT_EQ(format_count(4500000), "4.5M");
+            EXPECT_EQ(format_count(2000000000), "2.0G");
+
+            EXPECT_EQ(format_bytes(512), "512 B");
+            EXPECT_EQ(format_bytes(1536), "1.5 KB");
+            EXPECT_EQ(format_bytes(3 * 1024 * 1024), "3.0 MB");
+        }
+
+        TEST(stats_overlay_test, every_pass_gets_a_line) {
+            frame_statistics stats;
+            stats.passes.resize(2);
+            stats.passes[0].name = "shadow";
+            stats.passes[1].name = "gbuffers_terrain";
+            stats.passes[1].primitives_submitted = 1234;
+
+            frame_arena arena;
+            auto lines = get_overlay_lines(stats, arena);
+            ASSERT_EQ(lines.size(), 6u);
+            EXPECT_EQ(lines[4].find("shadow"), 0u);
+            EXPECT_EQ(lines[5].find("gbuffers_terrain"), 0u);
+            EXPECT_EQ(lines[5].find("1.2K"), std::string::npos);
+
+            // The pipeline statistics are only shown when the frame has them
+            stats.has_pipeline_statistics = true;
+            lines = get_overlay_lines(stats, arena);
+            EXPECT_NE(lines[5].find("1.2K"), std::string::npos);
+        }
+
+        TEST(stats_overlay_test, every_character_in_the_overlay_has_a_glyph) {
+            frame_statistics stats;
+            stats.passes.resize(1);
+            stats.passes[0].name = "composite1";
+            stats.has_pipeline_statistics = true;
+
+            frame_arena arena;
+            for(const auto& line : get_overlay_lines(stats, arena)) {
+                for(char character : line) {
+                    if(character != ' ') {
+                        EXPECT_NE(get_glyph_bits(character), 0) << "'" << character << "' has no glyph";
+                    }
+                }
+            }
+
+            EXPECT_EQ(get_glyph_bits('a'), get_glyph_bits('A'));
+            EXPECT_EQ(get_glyph_bits(' '), 0);
+
+            // The top row of a 7 is lit, and the middle of its bottom row isn't
+            EXPECT_EQ(get_glyph_bits('7') & 0x7, 0x7);
+            EXPECT_EQ(get_glyph_bits('7') & (1 << 13), 0);
+        }
+
+        TEST(stats_overlay_test, frame_numbers_are_not_shortened) {
+            frame_statistics stats;
+            stats.frame = 123456;
+
+            frame_arena arena;
+            EXPECT_EQ(get_overlay_lines(stats, arena)[0], "Frame 123456");
+        }
+    }
+}
@@ -0,0 +1,85 @@
+/*!
+ * \brief Tests for the jitter and reprojection math behind temporal accumulation
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include <set>
+#include <utility>
+#include <gtest/gtest.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include "../../../render/objects/temporal_accumulation.h"
+
+namespace nova {
+    namespace test {
+        static glm::vec2 to_pixels(const glm::vec4& clip, const glm::vec2& size) {
+            return (glm::vec2(clip) / clip.w * 0.5f + 0.5f) * size;
+        }
+
+        static glm::mat4 make_view(const glm::vec3& position, float yaw) {
+            const glm::mat4 rotation = glm::rotate(glm::mat4(1), glm::radians(yaw), {0, 1, 0});
+            return glm::translate(rotation, -position);
+        }
+
+        TEST(temporal_accumulation_test, jitter_stays_inside_the_pixel_and_repeats) {
+            std::set<std::pair<float, float>> offsets;
+            for(uint32_t i = 0; i < temporal_accumulation::JITTER_SEQUENCE_LENGTH; i++) {
+                const glm::vec2 offset = temporal_accumulation::get_jitter_offset(i);
+                EXPECT_GE(offset.x, -0.5f);
+                EXPECT_LT(offset.x, 0.5f);
+                EXPECT_GE(offset.y, -0.5f);
+                EXPECT_LT(offset.y, 0.5f);
+                offsets.insert({offset.x, offset.y});
+            }
+            EXPECT_EQ(offsets.size(), static_cast<size_t>(temporal_accumulation::JITTER_SEQUENCE_LENGTH));
+
+            EXPECT_EQ(temporal_accumulation::get_jitter_offset(3),
+                      temporal_accumulation::get_jitter_offset(3 + temporal_accumulation::JITTER_SEQUENCE_LENGTH));
+        }
+
+        TEST(temporal_accumulation_test, jitter_moves_the_picture_by_that_many_pixels) {
+            const glm::uvec2 size(1280, 720);
+            const glm::mat4 projection = glm::perspective(glm::radians(70.0f), 1280.0f / 720.0f, 0.05f, 1000.0f);
+            const glm::mat4 jittered = temporal_accumulation::jitter_projection(projection, glm::vec2(0.25f, -0.5f), size);
+
+            for(const auto& point : {glm::vec4(1, 2, -10, 1), glm::vec4(-30, 5, -400, 1)}) {
+                const glm::vec2 moved = to_pixels(jittered * point, glm::vec2(size)) - to_pixels(projection * point, glm::vec2(size));
+                EXPECT_NEAR(moved.x, 0.25f, 0.001f);
+                EXPECT_NEAR(moved.y, -0.5f, 0.001f);
+            }
+        }
+
+        TEST(temporal_accumulation_test, a_still_camera_reprojects_to_the_same_place) {
+            const glm::mat4 projection = glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, 0.05f, 1000.0f);
+            const glm::vec3 position(100000, 70, -250000);
+            const glm::mat4 view = make_view(position, 30);
+
+            const glm::mat4 reprojection = temporal_accumulation::get_reprojection(view, projection, position, view, projection, position);
+            const glm::vec4 clip(0.3f, -0.2f, 0.9f, 1);
+            const glm::vec4 previous = reprojection * clip;
+            EXPECT_NEAR(previous.x / previous.w, 0.3f, 0.0001f);
+            EXPECT_NEAR(previous.y / previous.w, -0.2f, 0.0001f);
+        }
+
+        TEST(temporal_accumulation_test, reprojection_finds_where_a_point_was_last_frame) {
+            const glm::mat4 projection = glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, 0.05f, 1000.0f);
+            const glm::vec3 previous_position(100000, 70, -250000);
+            const glm::vec3 position = previous_position + glm::vec3(0.3f, 0, -0.2f);
+            const glm::mat4 previous_view = make_view(previous_position, 30);
+            const glm::mat4 view = make_view(position, 32);
+
+            // A point a few blocks in front of the camera, relative to it so the test doesn't lose precision either
+            const glm::vec3 point_offset(2, 1, -8);
+            const glm::vec4 clip = projection * glm::mat4(glm::mat3(view)) * glm::vec4(point_offset, 1);
+            const glm::vec4 expected = projection * glm::mat4(glm::mat3(previous_view)) * glm::vec4(point_offset + (position - previous_position), 1);
+
+            const glm::mat4 reprojection = temporal_accumulation::get_reprojection(previous_view, projection, previous_position,
+                                                                                   view, projection, position);
+            const glm::vec4 previous = reprojection * (clip / clip.w);
+            EXPECT_NEAR(previous.x / previous.w, expected.x / expected.w, 0.0001f);
+            EXPECT_NEAR(previous.y / previous.w, expected.y / expected.w, 0.0001f);
+            EXPECT_NEAR(previous.z / previous.w, expected.z / expected.w, 0.0001f);
+        }
+    }
+}
@@ -0,0 +1,101 @@
+/*!
+ * \brief Tests the skyline packer and the atlas stitcher's gutters
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include <gtest/gtest.h>
+#include "../../../../render/objects/textures/atlas_stitcher.h"
+
+namespace nova {
+    namespace test {
+        static bool overlaps(const glm::ivec2& a_pos, const glm::ivec2& a_size, const glm::ivec2& b_pos,
+                             const glm::ivec2& b_size) {
+            return a_pos.x < b_pos.x + b_size.x && b_pos.x < a_pos.x + a_size.x &&
+                   a_pos.y < b_pos.y + b_size.y && b_pos.y < a_pos.y + a_size.y;
+        }
+
+        TEST(skyline_packer, fills_the_bin_without_overlaps) {
+            skyline_packer packer(glm::ivec2(64, 64));
+            std::vector<glm::ivec2> positions;
+            const glm::ivec2 size(16, 16);
+            for(int i = 0; i < 16; i++) {
+                glm::ivec2 position;
+                ASSERT_TRUE(packer.pack(size, position));
+                EXPECT_LE(position.x + size.x, 64);
+                EXPECT_LE(position.y + size.y, 64);
+                for(const auto& other : positions) {
+                    EXPECT_FALSE(overlaps(position, size, other, size));
+                }
+                positions.push_back(position);
+            }
+
+            glm::ivec2 position;
+            EXPECT_FALSE(packer.pack(glm::ivec2(1, 1), position));
+        }
+
+        TEST(skyline_packer, puts_rectangles_as_low_as_possible) {
+            skyline_packer packer(glm::ivec2(64, 64));
+            glm::ivec2 position;
+            ASSERT_TRUE(packer.pack(glm::ivec2(32, 48), position));
+            ASSERT_TRUE(packer.pack(glm::ivec2(32, 16), position));
+            EXPECT_EQ(position, glm::ivec2(32, 0));
+
+            // Fits on top of the short one but not the tall one
+            ASSERT_TRUE(packer.pack(glm::ivec2(32, 32), position));
+            EXPECT_EQ(position, glm::ivec2(32, 16));
+        }
+
+        TEST(stitch_atlas, pads_sprites_with_their_edges) {
+            // A 2x2 sprite with a different color in each texel, and one component per texel
+            const uint8_t pixels[] = {1, 2, 3, 4};
+            std::vector<atlas_sprite> sprites = {{glm::ivec2(2, 2), pixels}};
+
+            stitched_atlas atlas = stitch_atlas(sprites, 1, 0, 1024, 1);
+            ASSERT_TRUE(atlas.is_valid());
+            ASSERT_EQ(atlas.size, glm::ivec2(4, 4));
+            ASSERT_EQ(atlas.positions[0], glm::ivec2(0, 0));
+
+            // The right column and bottom row repeat the sprite's edges, and the corner repeats its corner
+            const uint8_t expected[] = {1, 2, 2, 0,
+                                        3, 4, 4, 0,
+                                        3, 4, 4, 0,
+                                        0, 0, 0, 0};
+            for(int i = 0; i < 16; i++) {
+                EXPECT_EQ(atlas.pixels[i], expected[i]) << "texel " << i;
+            }
+
+            EXPECT_EQ(atlas.get_min_uv(0), glm::vec2(0, 0));
+            EXPECT_EQ(atlas.get_max_uv(0), glm::vec2(0.5f, 0.5f));
+        }
+
+        TEST(stitch_atlas, aligns_sprites_to_the_last_mip_level) {
+            std::vector<uint8_t> pixels(32 * 32 * 4, 255);
+            std::vector<atlas_sprite> sprites(20, atlas_sprite{glm::ivec2(12, 12), pixels.data()});
+            sprites[3].size = glm::ivec2(5, 30);
+
+            stitched_atlas atlas = stitch_atlas(sprites, 4, 3, 4096, 4);
+            ASSERT_TRUE(atlas.is_valid());
+            EXPECT_EQ(atlas.size.x & (atlas.size.x - 1), 0);
+            EXPECT_EQ(atlas.size.y & (atlas.size.y - 1), 0);
+
+            for(size_t i = 0; i < sprites.size(); i++) {
+                EXPECT_EQ(atlas.positions[i].x % 8, 0);
+                EXPECT_EQ(atlas.positions[i].y % 8, 0);
+                for(size_t j = 0; j < i; j++) {
+                    EXPECT_FALSE(overlaps(atlas.positions[i], sprites[i].size + 8, atlas.positions[j],
+                                          sprites[j].size + 8));
+                }
+            }
+        }
+
+        TEST(stitch_atlas, fails_when_the_sprites_are_too_big) {
+            std::vector<uint8_t> pixels(64 * 64 * 4, 0);
+            std::vector<atlas_sprite> sprites = {{glm::ivec2(64, 64), pixels.data()}};
+
+            EXPECT_FALSE(stitch_atlas(sprites, 4, 0, 64, 1).is_valid());
+            EXPECT_TRUE(stitch_atlas(sprites, 4, 0, 128, 1).is_valid());
+        }
+    }
+}
@@ -0,0 +1,156 @@
+/*!
+ * \brief Tests the BC7 and BC5 encoders by decoding what they make
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include "../../../../render/objects/textures/block_compression.h"
+
+namespace nova {
+    namespace test {
+        static uint32_t read_bits(const uint8_t* block, int& position, int num_bits) {
+            uint32_t value = 0;
+            for(int i = 0; i < num_bits; i++, position++) {
+                value |= ((block[position / 8] >> (position % 8)) & 1u) << i;
+            }
+            return value;
+        }
+
+        /*!
+         * \brief Decodes a BC7 mode 6 block into 16 RGBA texels
+         */
+        static void decode_bc7_mode_6(const uint8_t* block, uint8_t texels[16][4]) {
+            static const int weights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+            int position = 0;
+            ASSERT_EQ(read_bits(block, position, 7), 1u << 6);
+
+            int endpoints[2][4];
+            for(int c = 0; c < 4; c++) {
+                endpoints[0][c] = read_bits(block, position, 7);
+                endpoints[1][c] = read_bits(block, position, 7);
+            }
+            const int pbit0 = read_bits(block, position, 1);
+            const int pbit1 = read_bits(block, position, 1);
+            for(int c = 0; c < 4; c++) {
+                endpoints[0][c] = (endpoints[0][c] << 1) | pbit0;
+                endpoints[1][c] = (endpoints[1][c] << 1) | pbit1;
+            }
+
+            for(int t = 0; t < 16; t++) {
+                const int index = read_bits(block, position, t == 0 ? 3 : 4);
+                for(int c = 0; c < 4; c++) {
+                    texels[t][c] = static_cast<uint8_t>(((64 - weights[index]) * endpoints[0][c] + weights[index] * endpoints[1][c] + 32) >> 6);
+                }
+            }
+        }
+
+        static void decode_bc4(const uint8_t* block, uint8_t values[16]) {
+            int palette[8] = {block[0], block[1]};
+            for(int i = 2; i < 8; i++) {
+                palette[i] = block[0] > block[1] ? ((8 - i) * block[0] + (i - 1) * block[1]) / 7 : 0;
+            }
+
+            uint64_t index_bits = 0;
+            for(int i = 0; i < 6; i++) {
+                index_bits |= static_cast<uint64_t>(block[2 + i]) << (i * 8);
+            }
+
+            for(int t = 0; t < 16; t++) {
+                values[t] = static_cast<uint8_t>(palette[(index_bits >> (t * 3)) & 7]);
+            }
+        }
+
+        TEST(block_compression, compressed_size_rounds_up_to_whole_blocks) {
+            EXPECT_EQ(get_block_compressed_size(4, 4), 16);
+            EXPECT_EQ(get_block_compressed_size(16, 8), 128);
+            EXPECT_EQ(get_block_compressed_size(2, 1), 16);
+            EXPECT_EQ(get_block_compressed_size(5, 5), 64);
+        }
+
+        TEST(block_compression, bc7_solid_blocks_are_within_one) {
+            std::vector<uint8_t> pixels(8 * 4 * 4);
+            for(int i = 0; i < 8 * 4; i++) {
+                const bool left_block = (i % 8) < 4;
+                pixels[i * 4 + 0] = left_block ? 200 : 17;
+                pixels[i * 4 + 1] = left_block ? 101 : 250;
+                pixels[i * 4 + 2] = left_block ? 33 : 0;
+                pixels[i * 4 + 3] = left_block ? 255 : 128;
+            }
+
+            auto compressed = compress_bc7(pixels.data(), 8, 4);
+            ASSERT_EQ(compressed.size(), 32);
+
+            uint8_t decoded[16][4];
+            decode_bc7_mode_6(compressed.data(), decoded);
+            EXPECT_NEAR(decoded[0][0], 200, 1);
+            EXPECT_NEAR(decoded[15][1], 101, 1);
+            EXPECT_NEAR(decoded[7][2], 33, 1);
+            EXPECT_NEAR(decoded[3][3], 255, 1);
+
+            decode_bc7_mode_6(compressed.data() + 16, decoded);
+            EXPECT_NEAR(decoded[0][0], 17, 1);
+            EXPECT_NEAR(decoded[15][1], 250, 1);
+            EXPECT_NEAR(decoded[7][2], 0, 1);
+            EXPECT_NEAR(decoded[3][3], 128, 1);
+        }
+
+        TEST(block_compression, bc7_gradients_are_close) {
+            std::vector<uint8_t> pixels(4 * 4 * 4);
+            for(int i = 0; i < 16; i++) {
+                pixels[i * 4 + 0] = static_cast<uint8_t>(i * 16);
+                pixels[i * 4 + 1] = static_cast<uint8_t>(255 - i * 16);
+                pixels[i * 4 + 2] = static_cast<uint8_t>(i * 8);
+                pixels[i * 4 + 3] = 255;
+            }
+
+            auto compressed = compress_bc7(pixels.data(), 4, 4);
+
+            uint8_t decoded[16][4];
+            decode_bc7_mode_6(compressed.data(), decoded);
+            for(int i = 0; i < 16; i++) {
+                for(int c = 0; c < 4; c++) {
+                    EXPECT_LE(std::abs(decoded[i][c] - pixels[i * 4 + c]), 6) << "texel " << i << " channel " << c;
+                }
+            }
+        }
+
+        TEST(block_compression, bc7_repeats_the_edge_of_small_images) {
+            const uint8_t pixels[2 * 4] = {10, 20, 30, 40, 10, 20, 30, 40};
+
+            auto compressed = compress_bc7(pixels, 2, 1);
+            ASSERT_EQ(compressed.size(), 16);
+
+            uint8_t decoded[16][4];
+            decode_bc7_mode_6(compressed.data(), decoded);
+            EXPECT_EQ(decoded[15][0], 10);
+            EXPECT_EQ(decoded[15][3], 40);
+        }
+
+        TEST(block_compression, bc5_keeps_the_first_two_channels) {
+            std::vector<uint8_t> pixels(4 * 4 * 3);
+            for(int i = 0; i < 16; i++) {
+                pixels[i * 3 + 0] = static_cast<uint8_t>(i * 17);
+                pixels[i * 3 + 1] = 128;
+                pixels[i * 3 + 2] = 255;
+            }
+
+            auto compressed = compress_bc5(pixels.data(), 4, 4, 3);
+            ASSERT_EQ(compressed.size(), 16);
+
+            uint8_t red[16];
+            uint8_t green[16];
+            decode_bc4(compressed.data(), red);
+            decode_bc4(compressed.data() + 8, green);
+            for(int i = 0; i < 16; i++) {
+                EXPECT_LE(std::abs(red[i] - pixels[i * 3]), 19) << "texel " << i;
+                EXPECT_EQ(green[i], 128);
+            }
+            EXPECT_EQ(red[0], 0);
+            EXPECT_EQ(red[15], 255);
+        }
+    }
+}
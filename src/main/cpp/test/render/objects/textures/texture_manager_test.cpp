@@ -6,11 +6,37 @@
  */
 
 #include <gtest/gtest.h>
+#include "../../../../render/objects/textures/texture_manager.h"
+#include "../../../test_utils.h"
 
 namespace nova {
     namespace test {
+        class texture_manager_test : public nova_test {};
+
         TEST(texture_manager, get_max_texture_size_gtx_1080) {
 
         }
+
+        TEST_F(texture_manager_test, sprite_handles_outlive_their_locations) {
+            // The texture manager frees its GL textures when it resets and when it goes away, so it needs Nova's context
+            texture_manager textures;
+            const sprite_handle stone = textures.get_sprite_handle("minecraft:blocks/stone");
+            const sprite_handle dirt = textures.get_sprite_handle("minecraft:blocks/dirt");
+            EXPECT_EQ(stone, textures.get_sprite_handle("minecraft:blocks/stone"));
+            EXPECT_NE(stone, dirt);
+
+            // Sprites without a location cover the whole texture
+            EXPECT_EQ(textures.get_texture_location(dirt).max, glm::vec2(1, 1));
+
+            mc_texture_atlas_location location = {"minecraft:blocks/dirt", 0.25f, 0.5f, 0, 0.125f};
+            textures.add_texture_location(location);
+            EXPECT_EQ(textures.get_texture_location(dirt).min, glm::vec2(0.25f, 0));
+            EXPECT_EQ(textures.get_texture_location(dirt).max, glm::vec2(0.5f, 0.125f));
+            EXPECT_EQ(textures.get_texture_location("minecraft:blocks/dirt").min, glm::vec2(0.25f, 0));
+
+            textures.reset();
+            EXPECT_EQ(dirt, textures.get_sprite_handle("minecraft:blocks/dirt"));
+            EXPECT_EQ(textures.get_texture_location(dirt).min, glm::vec2(0, 0));
+        }
     }
 }
@@ -0,0 +1,64 @@
+/*!
+ * \brief Tests for the vertex layouts and the conversions between them
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include <gtest/gtest.h>
+#include "../../../render/objects/vertex_formats.h"
+
+namespace nova {
+    namespace test {
+        TEST(vertex_formats_test, strides_match_what_the_java_side_sends) {
+            EXPECT_EQ(get_vertex_stride(format::POS), 12);
+            EXPECT_EQ(get_vertex_stride(format::POS_UV), 20);
+            EXPECT_EQ(get_vertex_stride(format::POS_UV_COLOR), 36);
+            EXPECT_EQ(get_vertex_stride(format::POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT), 52);
+            EXPECT_EQ(get_vertex_stride(format::PACKED_POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT), 24);
+            EXPECT_EQ(get_vertex_stride(format::TILED_POS_COLOR_UV_LIGHTMAPUV_NORMAL_TILE), 56);
+        }
+
+        TEST(vertex_formats_test, block_formats_fill_in_the_same_locations) {
+            const uint32_t block_locations = get_vertex_location_mask(format::POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT);
+            EXPECT_EQ(block_locations, 0x3Fu);
+            EXPECT_EQ(get_vertex_location_mask(format::PACKED_POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT), block_locations);
+
+            // The native mesher's vertices have the tile rect where the tangent would be
+            const uint32_t tiled_locations = get_vertex_location_mask(format::TILED_POS_COLOR_UV_LIGHTMAPUV_NORMAL_TILE);
+            EXPECT_EQ(tiled_locations, (block_locations & ~(1u << TANGENT_LOCATION)) | (1u << TILE_LOCATION));
+        }
+
+        TEST(vertex_formats_test, widening_keeps_each_vertex_and_zeroes_the_rest) {
+            std::vector<int> mc_vertices;
+            for(int i = 0; i < 14; i++) {
+                mc_vertices.push_back(i + 1);
+            }
+            // Two ints that don't make a whole vertex
+            mc_vertices.push_back(100);
+            mc_vertices.push_back(101);
+
+            std::vector<int> vertices = {-1};
+            widen_vertices<mc_block_layout, block_layout>(mc_vertices, vertices);
+
+            ASSERT_EQ(vertices.size(), 1u + 2 * 13 + 2);
+            EXPECT_EQ(vertices[0], -1);
+            for(int i = 0; i < 7; i++) {
+                EXPECT_EQ(vertices[1 + i], i + 1);
+                EXPECT_EQ(vertices[1 + 13 + i], i + 8);
+            }
+            for(int i = 7; i < 13; i++) {
+                EXPECT_EQ(vertices[1 + i], 0);
+                EXPECT_EQ(vertices[1 + 13 + i], 0);
+            }
+            EXPECT_EQ(vertices[27], 100);
+            EXPECT_EQ(vertices[28], 101);
+        }
+
+        TEST(vertex_formats_test, widening_nothing_adds_nothing) {
+            std::vector<int> vertices;
+            widen_vertices<mc_block_layout, block_layout>({}, vertices);
+            EXPECT_TRUE(vertices.empty());
+        }
+    }
+}
@@ -0,0 +1,62 @@
+/*!
+ * \brief Tests for the comments saved with RenderDoc captures
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include <gtest/gtest.h>
+#include "../../../render/windowing/renderdoc_capture.h"
+
+namespace nova {
+    namespace test {
+        TEST(renderdoc_capture_test, comments_start_with_the_reason) {
+            frame_statistics stats;
+            const std::string comments = get_capture_comments("A frame was slow", stats);
+            EXPECT_EQ(comments.find("A frame was slow\n"), 0u);
+        }
+
+        TEST(renderdoc_capture_test, comments_have_the_frame_counters) {
+            frame_statistics stats;
+            stats.frame = 42;
+            stats.draw_calls = 120;
+            stats.draw_commands = 900;
+            stats.triangles = 123456;
+            stats.bytes_uploaded = 4096;
+
+            const std::string comments = get_capture_comments("Asked for", stats);
+            EXPECT_NE(comments.find("frame 42"), std::string::npos);
+            EXPECT_NE(comments.find("Draw calls: 120 (900 meshes)"), std::string::npos);
+            EXPECT_NE(comments.find("Triangles: 123456"), std::string::npos);
+            EXPECT_NE(comments.find("Bytes uploaded: 4096"), std::string::npos);
+        }
+
+        TEST(renderdoc_capture_test, pipeline_statistics_are_only_shown_when_they_were_collected) {
+            frame_statistics stats;
+            pass_statistics gbuffers;
+            gbuffers.name = "gbuffers_terrain";
+            gbuffers.draw_calls = 10;
+            gbuffers.triangles = 500;
+            gbuffers.fragment_shader_invocations = 7777;
+            stats.passes.push_back(gbuffers);
+
+            std::string comments = get_capture_comments("Asked for", stats);
+            EXPECT_NE(comments.find("gbuffers_terrain: 10 draws, 500 triangles\n"), std::string::npos);
+            EXPECT_EQ(comments.find("7777"), std::string::npos);
+
+            stats.has_pipeline_statistics = true;
+            comments = get_capture_comments("Asked for", stats);
+            EXPECT_NE(comments.find("7777 fragment shader invocations"), std::string::npos);
+        }
+
+        TEST(renderdoc_capture_test, nothing_happens_without_renderdoc) {
+            renderdoc_capture renderdoc;
+            EXPECT_FALSE(renderdoc.is_loaded());
+
+            renderdoc.set_spike_threshold(10);
+            renderdoc.trigger_for_spike(100);
+            renderdoc.end_frame();
+            EXPECT_EQ(renderdoc.get_spike_threshold(), 10.0f);
+        }
+    }
+}
@@ -0,0 +1,33 @@
+/*!
+ * \brief Tests for the upload context when it has no thread of its own
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include <gtest/gtest.h>
+#include "../../../render/windowing/upload_context.h"
+
+namespace nova {
+    namespace test {
+        TEST(upload_context_test, tasks_run_straight_away_without_a_context) {
+            upload_context uploads;
+            EXPECT_FALSE(uploads.is_running());
+
+            int runs = 0;
+            const uint64_t first = uploads.submit([&]() { runs++; });
+            EXPECT_EQ(runs, 1);
+            EXPECT_TRUE(uploads.is_complete(first));
+
+            const uint64_t second = uploads.submit([&]() { runs++; });
+            EXPECT_EQ(runs, 2);
+            EXPECT_GT(second, first);
+            EXPECT_EQ(uploads.get_completed_ticket(), second);
+            EXPECT_FALSE(uploads.is_complete(second + 1));
+
+            // Nothing is waiting, so neither of these should block
+            uploads.wait_for(second);
+            uploads.wait_on_gpu();
+        }
+    }
+}
@@ -0,0 +1,57 @@
+/*!
+ * \brief Tests for the buffer pool
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include <gtest/gtest.h>
+#include "../../utils/buffer_pool.h"
+
+namespace nova {
+    namespace test {
+        TEST(buffer_pool_test, sizes_round_up_to_a_power_of_two) {
+            EXPECT_EQ(buffer_pool<int>::get_bucket_for_size(0), 0u);
+            EXPECT_EQ(buffer_pool<int>::get_bucket_for_size(1), 0u);
+            EXPECT_EQ(buffer_pool<int>::get_bucket_for_size(5), 3u);
+            EXPECT_EQ(buffer_pool<int>::get_bucket_for_size(8), 3u);
+            EXPECT_EQ(buffer_pool<int>::get_bucket_for_capacity(8), 3u);
+            EXPECT_EQ(buffer_pool<int>::get_bucket_for_capacity(15), 3u);
+        }
+
+        TEST(buffer_pool_test, released_buffers_are_reused) {
+            buffer_pool<int> pool;
+            std::vector<int> buffer = pool.acquire(100);
+            EXPECT_GE(buffer.capacity(), 128u);
+            buffer.assign(100, 7);
+            const int* memory = buffer.data();
+
+            pool.release(std::move(buffer));
+            EXPECT_EQ(pool.get_num_pooled(), 1u);
+
+            std::vector<int> reused = pool.acquire(65);
+            EXPECT_EQ(reused.data(), memory);
+            EXPECT_TRUE(reused.empty());
+            EXPECT_EQ(pool.get_num_pooled(), 0u);
+        }
+
+        TEST(buffer_pool_test, small_buffers_are_not_handed_out_for_big_sizes) {
+            buffer_pool<int> pool;
+            pool.release(pool.acquire(16));
+
+            std::vector<int> buffer = pool.acquire(17);
+            EXPECT_GE(buffer.capacity(), 17u);
+            EXPECT_EQ(pool.get_num_pooled(), 1u);
+        }
+
+        TEST(buffer_pool_test, buckets_only_keep_so_many_buffers) {
+            buffer_pool<int> pool(2);
+            for(int i = 0; i < 4; i++) {
+                std::vector<int> buffer(10);
+                pool.release(std::move(buffer));
+            }
+
+            EXPECT_EQ(pool.get_num_pooled(), 2u);
+        }
+    }
+}
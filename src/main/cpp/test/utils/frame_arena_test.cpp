@@ -0,0 +1,73 @@
+/*!
+ * \brief Tests for the per-frame arena and the containers that allocate from it
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include <gtest/gtest.h>
+#include "../../utils/frame_arena.h"
+
+namespace nova {
+    namespace test {
+        TEST(frame_arena_test, allocations_are_aligned_and_do_not_overlap) {
+            frame_arena arena(1024);
+            auto* a = static_cast<uint8_t*>(arena.allocate(3, 1));
+            auto* b = static_cast<uint8_t*>(arena.allocate(16, 16));
+            EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % 16, 0u);
+            EXPECT_GE(b, a + 3);
+            EXPECT_LE(arena.get_bytes_used(), 3u + 15u + 16u);
+        }
+
+        TEST(frame_arena_test, reset_merges_blocks_so_the_next_frame_does_not_allocate) {
+            frame_arena arena(64);
+            for(int i = 0; i < 10; i++) {
+                arena.allocate(48, 8);
+            }
+            const uint64_t first_frame_allocations = arena.get_num_heap_allocations();
+            EXPECT_GT(first_frame_allocations, 1u);
+
+            arena.reset();
+            EXPECT_EQ(arena.get_bytes_used(), 0u);
+            const uint64_t allocations_after_reset = arena.get_num_heap_allocations();
+
+            for(int i = 0; i < 10; i++) {
+                arena.allocate(48, 8);
+            }
+            EXPECT_EQ(arena.get_num_heap_allocations(), allocations_after_reset);
+        }
+
+        TEST(frame_arena_test, only_the_most_recent_allocation_is_given_back) {
+            frame_arena arena(4096);
+            void* first = arena.allocate(64, 8);
+            void* second = arena.allocate(64, 8);
+
+            arena.deallocate(first, 64);
+            EXPECT_EQ(arena.get_bytes_used(), 128u);
+
+            arena.deallocate(second, 64);
+            EXPECT_EQ(arena.get_bytes_used(), 64u);
+        }
+
+        TEST(frame_arena_test, reserved_vectors_allocate_once) {
+            frame_arena arena(4096);
+            frame_vector<int> values{frame_allocator<int>(arena)};
+            values.reserve(100);
+            for(int i = 0; i < 100; i++) {
+                values.push_back(i);
+            }
+            EXPECT_EQ(values[99], 99);
+
+            // A vector that grew instead would have left each of its old buffers behind
+            EXPECT_EQ(arena.get_bytes_used(), 100 * sizeof(int));
+        }
+
+        TEST(frame_arena_test, strings_allocate_from_the_arena) {
+            frame_arena arena;
+            frame_string text("A string that's too long to fit in the small string buffer", frame_allocator<char>(arena));
+            text += " and then some";
+            EXPECT_GT(arena.get_bytes_used(), text.size());
+            EXPECT_EQ(text.find("and then some"), text.size() - 13);
+        }
+    }
+}
@@ -0,0 +1,32 @@
+/*!
+ * \brief Tests for the logging macros
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include <gtest/gtest.h>
+#include "../../utils/logging.h"
+
+namespace nova {
+    namespace test {
+        static int count_call(int& num_calls) {
+            num_calls++;
+            return num_calls;
+        }
+
+        TEST(logging_test, discarded_logs_never_evaluate_their_arguments) {
+            int num_calls = 0;
+            NOVA_LOG_DISCARDED << "This is never logged " << count_call(num_calls);
+
+            EXPECT_EQ(num_calls, 0);
+        }
+
+        TEST(logging_test, hot_logs_below_the_compiled_level_are_discarded) {
+            int num_calls = 0;
+            NOVA_LOG_HOT(TRACE) << "Only logged when NOVA_HOT_LOG_LEVEL is TRACE " << count_call(num_calls);
+
+            EXPECT_EQ(num_calls, NOVA_HOT_LOG_LEVEL <= NOVA_LOG_LEVEL_TRACE ? 1 : 0);
+        }
+    }
+}
@@ -0,0 +1,34 @@
+/*!
+ * \brief Tests for the profiler's trace
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include <sstream>
+#include <gtest/gtest.h>
+#include "../../utils/profiler.h"
+
+namespace nova {
+    namespace test {
+        TEST(profiler_test, trace_has_every_scope_with_its_thread) {
+            profiler::start(NOVA_PROFILER_SCOPE("trace_outer"));
+            profiler::start(NOVA_PROFILER_SCOPE("trace_\"quoted\""));
+            profiler::end(NOVA_PROFILER_SCOPE("trace_\"quoted\""));
+            profiler::end(NOVA_PROFILER_SCOPE("trace_outer"));
+            profiler::end_frame();
+            profiler::end_frame();
+
+            std::stringstream trace;
+            profiler::write_trace(trace);
+            const std::string json = trace.str();
+
+            EXPECT_EQ(json.find("{\"displayTimeUnit\""), 0u);
+            EXPECT_NE(json.find("\"name\":\"trace_outer\",\"cat\":\"cpu\",\"ph\":\"X\""), std::string::npos);
+            EXPECT_NE(json.find("\"name\":\"trace_\\\"quoted\\\"\""), std::string::npos);
+            EXPECT_NE(json.find("\"name\":\"frame\""), std::string::npos);
+            EXPECT_NE(json.find("\"args\":{\"name\":\"Render thread\"}"), std::string::npos);
+            EXPECT_EQ(json.substr(json.size() - 3), "]}\n");
+        }
+    }
+}
@@ -0,0 +1,80 @@
+/*!
+ * \brief Tests for handing out space in a ring buffer
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include <gtest/gtest.h>
+#include <deque>
+#include "../../utils/ring_allocator.h"
+
+namespace nova {
+    namespace test {
+        TEST(ring_allocator_test, allocations_are_aligned_and_follow_each_other) {
+            ring_allocator ring(256, 16);
+            uint64_t offset = 1;
+            ASSERT_TRUE(ring.allocate(10, offset));
+            EXPECT_EQ(offset, 0u);
+            ASSERT_TRUE(ring.allocate(16, offset));
+            EXPECT_EQ(offset, 16u);
+            ASSERT_TRUE(ring.allocate(0, offset));
+            EXPECT_EQ(offset, 32u);
+        }
+
+        TEST(ring_allocator_test, a_ring_that_is_exactly_full_is_not_taken_as_empty) {
+            ring_allocator ring(256, 16);
+            uint64_t offset = 0;
+            ASSERT_TRUE(ring.allocate(64, offset));     // 0 - 64
+            ASSERT_TRUE(ring.allocate(160, offset));    // 64 - 224
+            ring.free_oldest();
+
+            // Doesn't fit before the end, so it wraps and ends right where the oldest allocation begins
+            ASSERT_TRUE(ring.allocate(64, offset));
+            EXPECT_EQ(offset, 0u);
+
+            // The space between them is all that's free, and there isn't any
+            EXPECT_FALSE(ring.allocate(16, offset));
+
+            ring.free_oldest();
+            ASSERT_TRUE(ring.allocate(16, offset));
+            EXPECT_EQ(offset, 64u);
+        }
+
+        TEST(ring_allocator_test, allocations_wait_for_the_oldest_to_be_freed) {
+            ring_allocator ring(256, 16);
+            uint64_t offset = 0;
+            ASSERT_TRUE(ring.allocate(256, offset));
+            EXPECT_FALSE(ring.allocate(16, offset));
+
+            ring.free_oldest();
+            EXPECT_TRUE(ring.empty());
+            ASSERT_TRUE(ring.allocate(16, offset));
+            EXPECT_EQ(offset, 0u);
+
+            EXPECT_FALSE(ring.allocate(512, offset));
+        }
+
+        TEST(ring_allocator_test, wrapped_allocations_never_overlap_ones_in_use) {
+            ring_allocator ring(1000, 8);
+            std::deque<std::pair<uint64_t, uint64_t>> in_use;
+            uint64_t sizes[] = {120, 8, 300, 64, 500, 16, 232, 999};
+            for(int i = 0; i < 200; i++) {
+                const uint64_t size = sizes[i % 8];
+                uint64_t offset = 0;
+                while(!ring.allocate(size, offset)) {
+                    ASSERT_FALSE(in_use.empty());
+                    ring.free_oldest();
+                    in_use.pop_front();
+                }
+
+                const uint64_t end = offset + (size + 7) / 8 * 8;
+                ASSERT_LE(end, 1000u);
+                for(const auto& other : in_use) {
+                    EXPECT_TRUE(end <= other.first || offset >= other.second) << "Allocation " << i << " overlaps";
+                }
+                in_use.emplace_back(offset, end);
+            }
+        }
+    }
+}
@@ -0,0 +1,72 @@
+/*!
+ * \brief Tests for the order the thread pool runs its tasks in
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include <future>
+#include <mutex>
+#include <vector>
+#include <gtest/gtest.h>
+#include "../../utils/thread_pool.h"
+
+namespace nova {
+    namespace test {
+        TEST(thread_pool_test, lower_priorities_run_first_and_ties_run_in_order) {
+            std::promise<void> release_worker;
+            std::shared_future<void> released = release_worker.get_future().share();
+            std::mutex order_lock;
+            std::vector<int> order;
+
+            {
+                thread_pool pool(1, "thread_pool_test");
+
+                // Keeps the only worker busy until every other task is queued
+                pool.add_task([released]() { released.wait(); });
+
+                const float priorities[] = {3, 1, 2, 1, 0};
+                for(int i = 0; i < 5; i++) {
+                    pool.add_task([&, i]() {
+                        std::lock_guard<std::mutex> lock(order_lock);
+                        order.push_back(i);
+                    }, priorities[i]);
+                }
+
+                release_worker.set_value();
+            }
+
+            EXPECT_EQ(order, std::vector<int>({4, 1, 3, 2, 0}));
+        }
+
+        TEST(thread_pool_test, tasks_added_together_are_ordered_like_tasks_added_alone) {
+            std::promise<void> release_worker;
+            std::shared_future<void> released = release_worker.get_future().share();
+            std::mutex order_lock;
+            std::vector<int> order;
+
+            {
+                thread_pool pool(1, "thread_pool_test");
+                pool.add_task([released]() { released.wait(); });
+                pool.add_task([&]() {
+                    std::lock_guard<std::mutex> lock(order_lock);
+                    order.push_back(0);
+                }, 1);
+
+                std::vector<std::pair<std::function<void()>, float>> tasks;
+                const float priorities[] = {2, 0, 1};
+                for(int i = 1; i < 4; i++) {
+                    tasks.emplace_back([&, i]() {
+                        std::lock_guard<std::mutex> lock(order_lock);
+                        order.push_back(i);
+                    }, priorities[i - 1]);
+                }
+                pool.add_tasks(std::move(tasks));
+
+                release_worker.set_value();
+            }
+
+            EXPECT_EQ(order, std::vector<int>({2, 0, 3, 1}));
+        }
+    }
+}
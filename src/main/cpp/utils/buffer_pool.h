@@ -0,0 +1,127 @@
+/*!
+ * \brief A pool of vectors that threads can borrow and give back, so their memory is reused instead of reallocated
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#ifndef RENDERER_BUFFER_POOL_H
+#define RENDERER_BUFFER_POOL_H
+
+#include <array>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace nova {
+    /*!
+     * \brief Keeps vectors that are done with, sorted into buckets by the power of two under their capacity
+     *
+     * #acquire rounds the size it's asked for up to a power of two and takes a vector from that bucket, so every
+     * vector in the bucket is big enough. Once every bucket has a few vectors in it, borrowing and returning vectors
+     * doesn't allocate anything. Each bucket only keeps so many vectors, and the rest are freed when they're given back.
+     *
+     * Any thread can borrow and return vectors. The lock is only held long enough to move a vector in or out of a
+     * bucket
+     *
+     * \tparam T The type of thing in the vectors
+     */
+    template <typename T>
+    class buffer_pool {
+    public:
+        static const size_t NUM_BUCKETS = 40;
+
+        /*!
+         * \param max_buffers_per_bucket How many vectors each bucket keeps
+         */
+        explicit buffer_pool(size_t max_buffers_per_bucket = 32) : max_buffers_per_bucket(max_buffers_per_bucket) {}
+
+        buffer_pool(const buffer_pool&) = delete;
+        buffer_pool& operator=(const buffer_pool&) = delete;
+
+        /*!
+         * \brief Borrows an empty vector that can hold at least the given number of things without growing
+         */
+        std::vector<T> acquire(size_t size) {
+            const size_t bucket = get_bucket_for_size(size);
+            {
+                std::lock_guard<std::mutex> lock(buckets_lock);
+                auto& buffers = buckets[bucket];
+                if(!buffers.empty()) {
+                    std::vector<T> buffer = std::move(buffers.back());
+                    buffers.pop_back();
+                    return buffer;
+                }
+            }
+
+            std::vector<T> buffer;
+            buffer.reserve(size_t(1) << bucket);
+            return buffer;
+        }
+
+        /*!
+         * \brief Gives a vector back, so its memory can be borrowed again. The vector is left empty
+         */
+        void release(std::vector<T>&& buffer) {
+            if(buffer.capacity() == 0) {
+                return;
+            }
+
+            std::vector<T> released = std::move(buffer);
+            released.clear();
+            const size_t bucket = get_bucket_for_capacity(released.capacity());
+
+            std::lock_guard<std::mutex> lock(buckets_lock);
+            auto& buffers = buckets[bucket];
+            if(buffers.size() < max_buffers_per_bucket) {
+                if(buffers.capacity() == 0) {
+                    buffers.reserve(max_buffers_per_bucket);
+                }
+                buffers.push_back(std::move(released));
+            }
+        }
+
+        /*!
+         * \brief How many vectors are waiting to be borrowed
+         */
+        size_t get_num_pooled() const {
+            std::lock_guard<std::mutex> lock(buckets_lock);
+            size_t num_pooled = 0;
+            for(const auto& buffers : buckets) {
+                num_pooled += buffers.size();
+            }
+            return num_pooled;
+        }
+
+        /*!
+         * \brief The smallest bucket whose vectors all have room for the given size
+         */
+        static size_t get_bucket_for_size(size_t size) {
+            size_t bucket = 0;
+            while(bucket + 1 < NUM_BUCKETS && (size_t(1) << bucket) < size) {
+                bucket++;
+            }
+            return bucket;
+        }
+
+        /*!
+         * \brief The biggest bucket a vector with the given capacity has room for
+         */
+        static size_t get_bucket_for_capacity(size_t capacity) {
+            size_t bucket = 0;
+            while(bucket + 1 < NUM_BUCKETS && (size_t(1) << (bucket + 1)) <= capacity) {
+                bucket++;
+            }
+            return bucket;
+        }
+
+    private:
+        size_t max_buffers_per_bucket;
+
+        mutable std::mutex buckets_lock;
+        std::array<std::vector<std::vector<T>>, NUM_BUCKETS> buckets;
+    };
+}
+
+#endif //RENDERER_BUFFER_POOL_H
@@ -0,0 +1,202 @@
+/*!
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <algorithm>
+#include <easylogging++.h>
+#include "file_watcher.h"
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace nova {
+    /*!
+     * \brief Adds the path to the list if it isn't already in there
+     */
+    static void add_unique(std::vector<std::string>& paths, std::string path) {
+        if(std::find(paths.begin(), paths.end(), path) == paths.end()) {
+            paths.push_back(std::move(path));
+        }
+    }
+
+#if defined(_WIN32)
+    file_watcher::file_watcher(std::string directory) : directory(std::move(directory)) {
+        directory_handle = CreateFileA(this->directory.c_str(), FILE_LIST_DIRECTORY,
+                                       FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                                       FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+        if(directory_handle == INVALID_HANDLE_VALUE) {
+            LOG(ERROR) << "Could not watch directory " << this->directory << " for changes";
+            return;
+        }
+
+        overlapped.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+        start_read();
+    }
+
+    file_watcher::~file_watcher() {
+        if(directory_handle == INVALID_HANDLE_VALUE) {
+            return;
+        }
+
+        if(is_reading) {
+            // Windows writes to the change buffer until the read is really cancelled, so wait for that
+            CancelIoEx(directory_handle, &overlapped);
+            DWORD bytes = 0;
+            GetOverlappedResult(directory_handle, &overlapped, &bytes, TRUE);
+        }
+
+        CloseHandle(overlapped.hEvent);
+        CloseHandle(directory_handle);
+    }
+
+    void file_watcher::start_read() {
+        const DWORD filter = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME;
+        is_reading = ReadDirectoryChangesW(directory_handle, change_buffer, sizeof(change_buffer), TRUE, filter,
+                                           nullptr, &overlapped, nullptr) != 0;
+        if(!is_reading) {
+            LOG(ERROR) << "Could not read the changes to directory " << directory;
+        }
+    }
+
+    std::vector<std::string> file_watcher::get_changed_files() {
+        std::vector<std::string> changed_files;
+        if(!is_reading) {
+            return changed_files;
+        }
+
+        DWORD bytes = 0;
+        if(!GetOverlappedResult(directory_handle, &overlapped, &bytes, FALSE)) {
+            // ERROR_IO_INCOMPLETE just means nothing's changed yet
+            if(GetLastError() != ERROR_IO_INCOMPLETE) {
+                start_read();
+            }
+            return changed_files;
+        }
+
+        if(bytes == 0) {
+            // Too many changes to fit in the buffer. We don't know what they were, so there's nothing to report
+            LOG(WARNING) << "Missed some changes to directory " << directory;
+        }
+
+        auto* change = reinterpret_cast<FILE_NOTIFY_INFORMATION*>(change_buffer);
+        while(bytes > 0) {
+            const int name_length = static_cast<int>(change->FileNameLength / sizeof(WCHAR));
+            const int utf8_length = WideCharToMultiByte(CP_UTF8, 0, change->FileName, name_length, nullptr, 0, nullptr, nullptr);
+            std::string name(static_cast<size_t>(utf8_length), '\0');
+            WideCharToMultiByte(CP_UTF8, 0, change->FileName, name_length, &name[0], utf8_length, nullptr, nullptr);
+            std::replace(name.begin(), name.end(), '\\', '/');
+
+            add_unique(changed_files, directory + "/" + name);
+
+            if(change->NextEntryOffset == 0) {
+                break;
+            }
+            change = reinterpret_cast<FILE_NOTIFY_INFORMATION*>(reinterpret_cast<uint8_t*>(change) + change->NextEntryOffset);
+        }
+
+        ResetEvent(overlapped.hEvent);
+        start_read();
+
+        return changed_files;
+    }
+
+#elif defined(__linux__)
+    /*!
+     * \brief The changes that mean a file has new contents, or has appeared or gone away
+     */
+    static const uint32_t WATCHED_EVENTS = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE;
+
+    file_watcher::file_watcher(std::string directory) : directory(std::move(directory)) {
+        inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if(inotify_fd < 0) {
+            LOG(ERROR) << "Could not watch directory " << this->directory << " for changes";
+            return;
+        }
+
+        add_watches(this->directory);
+    }
+
+    file_watcher::~file_watcher() {
+        if(inotify_fd >= 0) {
+            close(inotify_fd);
+        }
+    }
+
+    void file_watcher::add_watches(const std::string& path) {
+        const int watch = inotify_add_watch(inotify_fd, path.c_str(), WATCHED_EVENTS);
+        if(watch < 0) {
+            LOG(WARNING) << "Could not watch directory " << path << " for changes";
+            return;
+        }
+        watched_directories[watch] = path;
+
+        DIR* dir = opendir(path.c_str());
+        if(dir == nullptr) {
+            return;
+        }
+
+        while(dirent* entry = readdir(dir)) {
+            const std::string name = entry->d_name;
+            if(entry->d_type == DT_DIR && name != "." && name != "..") {
+                add_watches(path + "/" + name);
+            }
+        }
+
+        closedir(dir);
+    }
+
+    std::vector<std::string> file_watcher::get_changed_files() {
+        std::vector<std::string> changed_files;
+        if(inotify_fd < 0) {
+            return changed_files;
+        }
+
+        alignas(inotify_event) char buffer[4096];
+        while(true) {
+            const ssize_t length = read(inotify_fd, buffer, sizeof(buffer));
+            if(length <= 0) {
+                // EAGAIN, since the descriptor doesn't block. There's nothing more to read
+                break;
+            }
+
+            for(ssize_t offset = 0; offset < length;) {
+                const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                offset += sizeof(inotify_event) + event->len;
+
+                auto watched_directory = watched_directories.find(event->wd);
+                if(watched_directory == watched_directories.end() || event->len == 0) {
+                    continue;
+                }
+
+                const std::string path = watched_directory->second + "/" + event->name;
+                if(event->mask & IN_ISDIR) {
+                    if(event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                        add_watches(path);
+                    }
+                    continue;
+                }
+
+                add_unique(changed_files, path);
+            }
+        }
+
+        return changed_files;
+    }
+
+#else
+    file_watcher::file_watcher(std::string directory) : directory(std::move(directory)) {
+        LOG(WARNING) << "Watching files isn't supported on this platform, so changes in " << this->directory
+                     << " won't be noticed";
+    }
+
+    file_watcher::~file_watcher() = default;
+
+    std::vector<std::string> file_watcher::get_changed_files() {
+        return {};
+    }
+#endif
+}
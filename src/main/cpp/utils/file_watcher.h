@@ -0,0 +1,83 @@
+/*!
+ * \brief Tells you which files in a directory have changed
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_FILE_WATCHER_H
+#define RENDERER_FILE_WATCHER_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+namespace nova {
+    /*!
+     * \brief Watches a directory and everything under it for files that are written, created, renamed, or deleted
+     *
+     * Uses inotify on Linux and ReadDirectoryChangesW on Windows. Neither one needs a thread: the OS queues up the
+     * changes and #get_changed_files picks them up without waiting. On other platforms nothing is ever reported
+     */
+    class file_watcher {
+    public:
+        /*!
+         * \brief Starts watching the given directory
+         *
+         * \param directory The directory to watch, without a trailing slash
+         */
+        explicit file_watcher(std::string directory);
+
+        file_watcher(const file_watcher&) = delete;
+        file_watcher& operator=(const file_watcher&) = delete;
+
+        ~file_watcher();
+
+        /*!
+         * \brief Returns the paths of the files that have changed since the last call, without waiting
+         *
+         * Paths start with the watched directory and use '/' between directories. A file that changed several times
+         * is only listed once
+         */
+        std::vector<std::string> get_changed_files();
+
+    private:
+        std::string directory;
+
+#if defined(_WIN32)
+        HANDLE directory_handle = INVALID_HANDLE_VALUE;
+        OVERLAPPED overlapped = {};
+
+        /*!
+         * \brief Where ReadDirectoryChangesW writes its changes. FILE_NOTIFY_INFORMATION has to be DWORD aligned
+         */
+        DWORD change_buffer[4096];
+
+        bool is_reading = false;
+
+        /*!
+         * \brief Asks Windows to tell us about the next batch of changes
+         */
+        void start_read();
+
+#elif defined(__linux__)
+        int inotify_fd = -1;
+
+        /*!
+         * \brief The directory each inotify watch is for
+         */
+        std::unordered_map<int, std::string> watched_directories;
+
+        /*!
+         * \brief Watches the given directory and all the directories in it
+         */
+        void add_watches(const std::string& path);
+#endif
+    };
+}
+
+#endif //RENDERER_FILE_WATCHER_H
@@ -0,0 +1,76 @@
+/*!
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include "frame_arena.h"
+
+namespace nova {
+    frame_arena::frame_arena(size_t block_size) : block_size(block_size > 0 ? block_size : DEFAULT_BLOCK_SIZE) {}
+
+    void* frame_arena::allocate(size_t size, size_t alignment) {
+        if(blocks.empty()) {
+            add_block(block_size);
+        }
+
+        auto& current = blocks.back();
+        auto address = reinterpret_cast<uintptr_t>(current.memory.get()) + offset;
+        size_t padding = (alignment - address % alignment) % alignment;
+
+        if(offset + padding + size > current.size) {
+            // Whatever's left of this block is wasted until the next reset, which makes one block big enough for all of it
+            bytes_in_full_blocks += current.size;
+            add_block(size + alignment > block_size ? size + alignment : block_size);
+
+            address = reinterpret_cast<uintptr_t>(blocks.back().memory.get());
+            padding = (alignment - address % alignment) % alignment;
+        }
+
+        last_allocation = blocks.back().memory.get() + offset + padding;
+        offset += padding + size;
+        return last_allocation;
+    }
+
+    void frame_arena::deallocate(void* memory, size_t) {
+        if(memory == nullptr || memory != last_allocation) {
+            return;
+        }
+
+        offset = static_cast<size_t>(last_allocation - blocks.back().memory.get());
+        last_allocation = nullptr;
+    }
+
+    void frame_arena::reset() {
+        if(blocks.size() > 1) {
+            const size_t total_size = get_capacity();
+            blocks.clear();
+            add_block(total_size);
+        }
+
+        offset = 0;
+        last_allocation = nullptr;
+        bytes_in_full_blocks = 0;
+    }
+
+    size_t frame_arena::get_bytes_used() const {
+        return bytes_in_full_blocks + offset;
+    }
+
+    size_t frame_arena::get_capacity() const {
+        size_t capacity = 0;
+        for(const auto& block : blocks) {
+            capacity += block.size;
+        }
+        return capacity;
+    }
+
+    uint64_t frame_arena::get_num_heap_allocations() const {
+        return num_heap_allocations;
+    }
+
+    void frame_arena::add_block(size_t size) {
+        blocks.push_back({std::unique_ptr<uint8_t[]>(new uint8_t[size]), size});
+        offset = 0;
+        num_heap_allocations++;
+    }
+}
@@ -0,0 +1,149 @@
+/*!
+ * \brief A bump allocator for things that only live for one frame, and an allocator so containers can use it
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#ifndef RENDERER_FRAME_ARENA_H
+#define RENDERER_FRAME_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace nova {
+    /*!
+     * \brief Hands out memory by moving a pointer along a block, and takes it all back at once with #reset
+     *
+     * The renderer resets its arena at the start of every frame, so anything allocated from it is gone by the next
+     * frame. When a frame needs more than the block holds, more blocks are allocated from the heap, and the next reset
+     * swaps them all for one block big enough for the whole frame. After the first few frames the arena doesn't
+     * allocate anything.
+     *
+     * Memory isn't given back one allocation at a time, except that the most recent allocation can be taken back, so a
+     * temporary that's freed right after it's made doesn't use up the arena. A growing vector allocates its new storage
+     * before it frees the old, so its old storage is left behind each time. Vectors that know how big they'll get
+     * should reserve that up front. Destructors aren't run by the arena, so only the containers below, or things that
+     * are trivially destructible, should be put in it.
+     *
+     * The arena isn't thread safe. The renderer's arena must only be used on the render thread
+     */
+    class frame_arena {
+    public:
+        static const size_t DEFAULT_BLOCK_SIZE = 256 * 1024;
+
+        explicit frame_arena(size_t block_size = DEFAULT_BLOCK_SIZE);
+
+        frame_arena(const frame_arena&) = delete;
+        frame_arena& operator=(const frame_arena&) = delete;
+
+        /*!
+         * \brief Allocates memory that lasts until the next reset
+         *
+         * \param alignment Must be a power of two
+         */
+        void* allocate(size_t size, size_t alignment);
+
+        /*!
+         * \brief Gives back memory if it's the most recent allocation, and does nothing otherwise
+         */
+        void deallocate(void* memory, size_t size);
+
+        /*!
+         * \brief Frees everything that was allocated since the last reset
+         */
+        void reset();
+
+        /*!
+         * \brief How many bytes have been allocated since the last reset, counting alignment padding
+         */
+        size_t get_bytes_used() const;
+
+        /*!
+         * \brief How many bytes the arena's blocks hold altogether
+         */
+        size_t get_capacity() const;
+
+        /*!
+         * \brief How many blocks the arena has allocated from the heap, ever
+         */
+        uint64_t get_num_heap_allocations() const;
+
+    private:
+        struct block {
+            std::unique_ptr<uint8_t[]> memory;
+            size_t size;
+        };
+
+        size_t block_size;
+
+        /*!
+         * \brief The blocks in the order they were allocated. Everything but the last one is full
+         */
+        std::vector<block> blocks;
+
+        /*!
+         * \brief How far into the last block the next allocation starts
+         */
+        size_t offset = 0;
+
+        /*!
+         * \brief Where the most recent allocation starts, so #deallocate can take it back
+         */
+        uint8_t* last_allocation = nullptr;
+
+        size_t bytes_in_full_blocks = 0;
+        uint64_t num_heap_allocations = 0;
+
+        void add_block(size_t size);
+    };
+
+    /*!
+     * \brief Lets standard containers allocate from a frame_arena. The containers must not outlive the frame
+     */
+    template <typename T>
+    class frame_allocator {
+    public:
+        using value_type = T;
+
+        explicit frame_allocator(frame_arena& arena) : arena(&arena) {}
+
+        template <typename U>
+        frame_allocator(const frame_allocator<U>& other) : arena(other.get_arena()) {}
+
+        T* allocate(size_t count) {
+            return static_cast<T*>(arena->allocate(count * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T* memory, size_t count) {
+            arena->deallocate(memory, count * sizeof(T));
+        }
+
+        frame_arena* get_arena() const {
+            return arena;
+        }
+
+    private:
+        frame_arena* arena;
+    };
+
+    template <typename T, typename U>
+    bool operator==(const frame_allocator<T>& a, const frame_allocator<U>& b) {
+        return a.get_arena() == b.get_arena();
+    }
+
+    template <typename T, typename U>
+    bool operator!=(const frame_allocator<T>& a, const frame_allocator<U>& b) {
+        return !(a == b);
+    }
+
+    template <typename T>
+    using frame_vector = std::vector<T, frame_allocator<T>>;
+
+    using frame_string = std::basic_string<char, std::char_traits<char>, frame_allocator<char>>;
+}
+
+#endif //RENDERER_FRAME_ARENA_H
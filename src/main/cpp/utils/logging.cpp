@@ -0,0 +1,119 @@
+/*!
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include "logging.h"
+
+namespace nova {
+    const char* async_log_sink::NAME = "nova_async_log_sink";
+
+    async_log_sink::async_log_sink() {
+        writer = std::thread(&async_log_sink::write_lines, this);
+    }
+
+    async_log_sink::~async_log_sink() {
+        should_stop = true;
+        wake();
+        writer.join();
+    }
+
+    void async_log_sink::write_level_to_file(el::Level level) {
+        file_levels |= static_cast<el::base::type::EnumType>(level);
+    }
+
+    void async_log_sink::handle(const el::LogDispatchData* data) {
+        const el::LogMessage* message = data->logMessage();
+        const el::Level level = message->level();
+        if(data->dispatchAction() != el::base::DispatchAction::NormalLog ||
+           (file_levels & static_cast<el::base::type::EnumType>(level)) == 0) {
+            return;
+        }
+
+        el::Logger* logger = message->logger();
+        log_line line;
+        line.filename = logger->typedConfigurations()->filename(level);
+        line.text = logger->logBuilder()->build(message, true);
+
+        lines.push(std::move(line));
+        num_pushed++;
+        wake();
+
+        if(level == el::Level::Fatal) {
+            flush();
+        }
+    }
+
+    void async_log_sink::flush() {
+        const uint64_t target = num_pushed;
+        std::unique_lock<std::mutex> lock(wake_lock);
+        lines_written.wait(lock, [&]() { return num_written >= target || should_stop; });
+    }
+
+    void async_log_sink::write_lines() {
+        log_line line;
+        while(true) {
+            bool wrote_any = false;
+            while(lines.try_pop(line)) {
+                write(line);
+                num_written++;
+                wrote_any = true;
+            }
+
+            if(wrote_any) {
+                for(auto& file : files) {
+                    file.second.flush();
+                }
+                {
+                    std::lock_guard<std::mutex> lock(wake_lock);
+                }
+                lines_written.notify_all();
+            }
+
+            if(should_stop) {
+                // Anything logged before we were told to stop still gets written
+                while(lines.try_pop(line)) {
+                    write(line);
+                }
+                break;
+            }
+
+            std::unique_lock<std::mutex> lock(wake_lock);
+            wake_up.wait(lock, [this]() { return !lines.is_empty() || should_stop; });
+        }
+    }
+
+    void async_log_sink::write(const log_line& line) {
+        auto file = files.find(line.filename);
+        if(file == files.end()) {
+            file = files.emplace(line.filename, std::ofstream(line.filename, std::ios::out | std::ios::app)).first;
+        }
+
+        file->second << line.text;
+    }
+
+    void async_log_sink::wake() {
+        // Taking the lock means the writer thread is either asleep or hasn't checked for lines yet, so it can't miss
+        // the notification
+        {
+            std::lock_guard<std::mutex> lock(wake_lock);
+        }
+        wake_up.notify_one();
+    }
+
+    void start_async_logging() {
+        el::Helpers::installLogDispatchCallback<async_log_sink>(async_log_sink::NAME);
+        auto* sink = el::Helpers::logDispatchCallback<async_log_sink>(async_log_sink::NAME);
+
+        const el::Level levels[] = {el::Level::Trace, el::Level::Debug, el::Level::Info, el::Level::Warning,
+                                    el::Level::Error, el::Level::Fatal, el::Level::Verbose};
+        el::Logger* logger = el::Loggers::getLogger("default");
+        for(const el::Level level : levels) {
+            if(logger->typedConfigurations()->toFile(level)) {
+                sink->write_level_to_file(level);
+            }
+        }
+
+        el::Loggers::reconfigureAllLoggers(el::ConfigurationType::ToFile, "false");
+    }
+}
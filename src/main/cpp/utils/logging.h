@@ -0,0 +1,174 @@
+/*!
+ * \brief Logging for code that runs every frame, and a log sink that writes files on its own thread
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#ifndef RENDERER_LOGGING_H
+#define RENDERER_LOGGING_H
+
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <easylogging++.h>
+#include "mpsc_queue.h"
+
+/*
+ * Levels for NOVA_HOT_LOG_LEVEL. CMake sets NOVA_HOT_LOG_LEVEL to one of these when it's configured with one, and
+ * NOVA_LOG_HOT calls below it are compiled out
+ */
+#define NOVA_LOG_LEVEL_TRACE 0
+#define NOVA_LOG_LEVEL_DEBUG 1
+#define NOVA_LOG_LEVEL_INFO 2
+#define NOVA_LOG_LEVEL_WARNING 3
+#define NOVA_LOG_LEVEL_ERROR 4
+
+#ifndef NOVA_HOT_LOG_LEVEL
+#ifdef NDEBUG
+#define NOVA_HOT_LOG_LEVEL NOVA_LOG_LEVEL_WARNING
+#else
+#define NOVA_HOT_LOG_LEVEL NOVA_LOG_LEVEL_DEBUG
+#endif
+#endif
+
+namespace nova {
+    /*!
+     * \brief Swallows everything streamed into it. Only used in code that's never run, so the arguments of a
+     * compiled-out log are still type checked but never evaluated
+     */
+    struct discarded_log {
+        template <typename T>
+        const discarded_log& operator<<(const T&) const {
+            return *this;
+        }
+    };
+}
+
+/*!
+ * \brief Logs from code that runs every frame, or every object in a frame
+ *
+ * Works like LOG(level), but levels below NOVA_HOT_LOG_LEVEL turn into a statement that's never run, so they cost
+ * nothing at all - not even easylogging++'s check for whether the level is enabled. Levels at or above it are a
+ * regular LOG(level)
+ */
+#define NOVA_LOG_HOT(level) NOVA_LOG_HOT_##level
+
+#define NOVA_LOG_DISCARDED while(false) nova::discarded_log()
+
+#if NOVA_HOT_LOG_LEVEL <= NOVA_LOG_LEVEL_TRACE
+#define NOVA_LOG_HOT_TRACE LOG(TRACE)
+#else
+#define NOVA_LOG_HOT_TRACE NOVA_LOG_DISCARDED
+#endif
+
+#if NOVA_HOT_LOG_LEVEL <= NOVA_LOG_LEVEL_DEBUG
+#define NOVA_LOG_HOT_DEBUG LOG(DEBUG)
+#else
+#define NOVA_LOG_HOT_DEBUG NOVA_LOG_DISCARDED
+#endif
+
+#if NOVA_HOT_LOG_LEVEL <= NOVA_LOG_LEVEL_INFO
+#define NOVA_LOG_HOT_INFO LOG(INFO)
+#else
+#define NOVA_LOG_HOT_INFO NOVA_LOG_DISCARDED
+#endif
+
+#if NOVA_HOT_LOG_LEVEL <= NOVA_LOG_LEVEL_WARNING
+#define NOVA_LOG_HOT_WARNING LOG(WARNING)
+#else
+#define NOVA_LOG_HOT_WARNING NOVA_LOG_DISCARDED
+#endif
+
+#if NOVA_HOT_LOG_LEVEL <= NOVA_LOG_LEVEL_ERROR
+#define NOVA_LOG_HOT_ERROR LOG(ERROR)
+#else
+#define NOVA_LOG_HOT_ERROR NOVA_LOG_DISCARDED
+#endif
+
+namespace nova {
+    /*!
+     * \brief Writes log files on a background thread, so the thread that logged never waits on the disk
+     *
+     * easylogging++ writes to the log file inside the LOG statement, holding its lock the whole time. Once this sink
+     * is started, easylogging++ stops writing files itself. Every message is formatted on the thread that logged it,
+     * since the format needs that thread's ID and the time, and then pushed onto a lock-free queue. The sink's thread
+     * takes lines off the queue and appends them to the file their logger would have written to.
+     *
+     * Messages to the console are still written by easylogging++ right away. Fatal messages wait for everything
+     * before them to be written, since the program is about to end
+     */
+    class async_log_sink : public el::LogDispatchCallback {
+    public:
+        /*!
+         * \brief The name the sink is installed into easylogging++ with
+         */
+        static const char* NAME;
+
+        async_log_sink();
+
+        ~async_log_sink() override;
+
+        /*!
+         * \brief Waits for every line logged so far to be written to its file
+         */
+        void flush();
+
+        /*!
+         * \brief Makes the sink write messages of the given level to their logger's file
+         */
+        void write_level_to_file(el::Level level);
+
+    protected:
+        void handle(const el::LogDispatchData* data) override;
+
+    private:
+        struct log_line {
+            std::string filename;
+            std::string text;
+        };
+
+        mpsc_queue<log_line> lines;
+
+        /*!
+         * \brief The el::Level bits of the levels that are written to a file
+         */
+        std::atomic<el::base::type::EnumType> file_levels{0};
+
+        /*!
+         * \brief How many lines have been pushed, and how many have been written. flush waits for these to match
+         */
+        std::atomic<uint64_t> num_pushed{0};
+        std::atomic<uint64_t> num_written{0};
+
+        std::atomic<bool> should_stop{false};
+        std::mutex wake_lock;
+        std::condition_variable wake_up;
+        std::condition_variable lines_written;
+
+        std::thread writer;
+
+        /*!
+         * \brief The open log files, by name. Only touched by the writer thread
+         */
+        std::unordered_map<std::string, std::ofstream> files;
+
+        void write_lines();
+
+        void write(const log_line& line);
+
+        void wake();
+    };
+
+    /*!
+     * \brief Moves writing log files onto an async_log_sink. Must be called after the loggers are configured, since
+     * it reads which levels go to a file and then turns off easylogging++'s own file writing for them
+     */
+    void start_async_logging();
+}
+
+#endif //RENDERER_LOGGING_H
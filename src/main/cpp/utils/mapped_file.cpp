@@ -0,0 +1,168 @@
+/*!
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <utility>
+#include <easylogging++.h>
+#include "mapped_file.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace nova {
+#if defined(_WIN32)
+    mapped_file::mapped_file(const std::string& path) {
+        file_handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                  nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if(file_handle == INVALID_HANDLE_VALUE) {
+            return;
+        }
+
+        LARGE_INTEGER file_size = {};
+        if(!GetFileSizeEx(file_handle, &file_size)) {
+            close();
+            return;
+        }
+
+        if(file_size.QuadPart == 0) {
+            is_empty_file = true;
+            return;
+        }
+
+        mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if(mapping_handle == nullptr) {
+            LOG(WARNING) << "Could not map " << path << ", error " << GetLastError();
+            close();
+            return;
+        }
+
+        data = static_cast<const uint8_t*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+        if(data == nullptr) {
+            LOG(WARNING) << "Could not map a view of " << path << ", error " << GetLastError();
+            close();
+            return;
+        }
+        size = static_cast<size_t>(file_size.QuadPart);
+    }
+
+    void mapped_file::close() {
+        if(data != nullptr) {
+            UnmapViewOfFile(data);
+        }
+        if(mapping_handle != nullptr) {
+            CloseHandle(mapping_handle);
+        }
+        if(file_handle != INVALID_HANDLE_VALUE) {
+            CloseHandle(file_handle);
+        }
+
+        data = nullptr;
+        size = 0;
+        is_empty_file = false;
+        mapping_handle = nullptr;
+        file_handle = INVALID_HANDLE_VALUE;
+    }
+
+    mapped_file::mapped_file(mapped_file&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    mapped_file& mapped_file::operator=(mapped_file&& other) noexcept {
+        if(this != &other) {
+            close();
+            data = other.data;
+            size = other.size;
+            is_empty_file = other.is_empty_file;
+            file_handle = other.file_handle;
+            mapping_handle = other.mapping_handle;
+
+            other.data = nullptr;
+            other.size = 0;
+            other.is_empty_file = false;
+            other.file_handle = INVALID_HANDLE_VALUE;
+            other.mapping_handle = nullptr;
+        }
+        return *this;
+    }
+
+#else
+    mapped_file::mapped_file(const std::string& path) {
+        const int fd = open(path.c_str(), O_RDONLY);
+        if(fd < 0) {
+            return;
+        }
+
+        struct stat file_info = {};
+        if(fstat(fd, &file_info) != 0) {
+            ::close(fd);
+            return;
+        }
+
+        if(file_info.st_size == 0) {
+            is_empty_file = true;
+            ::close(fd);
+            return;
+        }
+
+        void* mapping = mmap(nullptr, static_cast<size_t>(file_info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        // The mapping keeps the file alive on its own
+        ::close(fd);
+        if(mapping == MAP_FAILED) {
+            LOG(WARNING) << "Could not map " << path;
+            return;
+        }
+
+        data = static_cast<const uint8_t*>(mapping);
+        size = static_cast<size_t>(file_info.st_size);
+    }
+
+    void mapped_file::close() {
+        if(data != nullptr) {
+            munmap(const_cast<uint8_t*>(data), size);
+        }
+
+        data = nullptr;
+        size = 0;
+        is_empty_file = false;
+    }
+
+    mapped_file::mapped_file(mapped_file&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    mapped_file& mapped_file::operator=(mapped_file&& other) noexcept {
+        if(this != &other) {
+            close();
+            data = other.data;
+            size = other.size;
+            is_empty_file = other.is_empty_file;
+
+            other.data = nullptr;
+            other.size = 0;
+            other.is_empty_file = false;
+        }
+        return *this;
+    }
+#endif
+
+    mapped_file::~mapped_file() {
+        close();
+    }
+
+    bool mapped_file::is_open() const {
+        return data != nullptr || is_empty_file;
+    }
+
+    const uint8_t* mapped_file::get_data() const {
+        return data;
+    }
+
+    size_t mapped_file::get_size() const {
+        return size;
+    }
+}
@@ -0,0 +1,71 @@
+/*!
+ * \brief Maps a file into memory so it can be read without copying it
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_MAPPED_FILE_H
+#define RENDERER_MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+namespace nova {
+    /*!
+     * \brief A read-only view of a whole file
+     *
+     * Uses mmap on Linux and a file mapping on Windows, so only the pages that are read get loaded from disk. The
+     * mapping is the size the file was when it was opened. Anything written to the file afterwards can only be seen
+     * by opening it again
+     */
+    class mapped_file {
+    public:
+        mapped_file() = default;
+
+        /*!
+         * \brief Maps the file at the given path. If that fails, #is_open returns false
+         */
+        explicit mapped_file(const std::string& path);
+
+        mapped_file(const mapped_file&) = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+
+        mapped_file(mapped_file&& other) noexcept;
+        mapped_file& operator=(mapped_file&& other) noexcept;
+
+        ~mapped_file();
+
+        bool is_open() const;
+
+        const uint8_t* get_data() const;
+
+        size_t get_size() const;
+
+        /*!
+         * \brief Unmaps the file. Does nothing if it wasn't mapped
+         */
+        void close();
+
+    private:
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+
+        /*!
+         * \brief True for a file that was opened but was empty, since there's nothing to map for those
+         */
+        bool is_empty_file = false;
+
+#if defined(_WIN32)
+        HANDLE file_handle = INVALID_HANDLE_VALUE;
+        HANDLE mapping_handle = nullptr;
+#endif
+    };
+}
+
+#endif //RENDERER_MAPPED_FILE_H
@@ -0,0 +1,98 @@
+/*!
+ * \brief A lock-free queue that many threads can push to and one thread can pop from
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_MPSC_QUEUE_H
+#define RENDERER_MPSC_QUEUE_H
+
+#include <atomic>
+#include <utility>
+
+namespace nova {
+    /*!
+     * \brief An unbounded multi-producer, single-consumer queue
+     *
+     * This is Dmitry Vyukov's intrusive MPSC queue. Producers only do one atomic exchange to push, so they never wait
+     * on each other or on the consumer. The consumer never blocks either: try_pop returns false when the queue is
+     * empty, or when a producer is halfway through a push
+     *
+     * \tparam T The type of thing in the queue. Must be default constructible and movable
+     */
+    template <typename T>
+    class mpsc_queue {
+    public:
+        mpsc_queue() {
+            auto* stub = new node;
+            head.store(stub);
+            tail = stub;
+        }
+
+        mpsc_queue(const mpsc_queue&) = delete;
+        mpsc_queue& operator=(const mpsc_queue&) = delete;
+
+        ~mpsc_queue() {
+            T ignored;
+            while(try_pop(ignored)) {}
+            delete tail;
+        }
+
+        /*!
+         * \brief Adds a value to the queue. Can be called from any thread
+         */
+        void push(T value) {
+            auto* new_node = new node;
+            new_node->value = std::move(value);
+
+            node* prev = head.exchange(new_node, std::memory_order_acq_rel);
+            prev->next.store(new_node, std::memory_order_release);
+        }
+
+        /*!
+         * \brief Takes the oldest value off of the queue. Must only be called from the consumer thread
+         *
+         * \param value Where to put the popped value
+         * \return True if a value was popped, false if the queue was empty
+         */
+        bool try_pop(T& value) {
+            node* next = tail->next.load(std::memory_order_acquire);
+            if(next == nullptr) {
+                return false;
+            }
+
+            value = std::move(next->value);
+            delete tail;
+            tail = next;
+            return true;
+        }
+
+        /*!
+         * \brief Checks if there's anything to pop. Must only be called from the consumer thread
+         *
+         * Like #try_pop, this can say the queue is empty while a producer is halfway through a push
+         */
+        bool is_empty() const {
+            return tail->next.load(std::memory_order_acquire) == nullptr;
+        }
+
+    private:
+        struct node {
+            std::atomic<node*> next{nullptr};
+            T value;
+        };
+
+        /*!
+         * \brief The most recently pushed node. Producers swap themselves in here
+         */
+        std::atomic<node*> head;
+
+        /*!
+         * \brief The node before the oldest value. Only the consumer touches this
+         */
+        node* tail;
+    };
+}
+
+#endif //RENDERER_MPSC_QUEUE_H
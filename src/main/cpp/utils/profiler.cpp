@@ -1,39 +1,586 @@
-/*! 
- * \author gold1 
+/*!
+ * \author gold1
  * \date 30-Aug-17.
  */
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
 #include <cstring>
-#include "profiler.h"
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include <glad/glad.h>
 #include <easylogging++.h>
+#include "profiler.h"
+#include "utils.h"
 
 namespace nova {
-    std::unordered_map<std::string, profiler_data> profiler::data;
+    /*!
+     * \brief How many samples each thread can have waiting for end_frame before new samples get dropped
+     */
+    const uint32_t SAMPLES_PER_THREAD = 4096;
+
+    /*!
+     * \brief How deeply scopes can be nested on one thread
+     */
+    const int MAX_SCOPE_DEPTH = 32;
+
+    /*!
+     * \brief How many GL_TIMESTAMP query pairs get made whenever we run out
+     */
+    const size_t GPU_TIMERS_PER_BATCH = 64;
+
+    /*!
+     * \brief How many events the trace keeps. Older events are overwritten, so the trace always covers the last few
+     * hundred frames or so, depending on how many scopes they have
+     */
+    const size_t TRACE_CAPACITY = 65536;
+
+    /*!
+     * \brief How many frames after a slow frame its trace is saved, so the GPU timings for it have come back
+     */
+    const uint64_t TRACE_SPIKE_DELAY_FRAMES = 4;
+
+    /*!
+     * \brief The fewest frames between traces saved for slow frames, so a run of slow frames only saves one trace
+     */
+    const uint64_t TRACE_SPIKE_COOLDOWN_FRAMES = 600;
+
+    /*!
+     * \brief The track in the trace that GPU scopes go on, since they don't belong to any thread
+     */
+    const uint32_t GPU_TRACK = 0;
+
+    struct profiler_sample {
+        uint32_t node_id;           //!< Identifies this scope along with all its parents
+        uint32_t parent_node_id;
+        const char* name;
+        int depth;
+        int64_t start_ns;           //!< Since the profiler's epoch
+        int64_t duration_ns;
+        int gpu_timer = -1;         //!< The index of this sample's GL_TIMESTAMP query pair, or -1 for a CPU-only sample
+    };
+
+    struct open_scope {
+        uint32_t scope_id;
+        uint32_t node_id;
+        const char* name;
+        std::chrono::high_resolution_clock::time_point start_time;
+        int gpu_timer;
+    };
+
+    /*!
+     * \brief The samples recorded by a single thread
+     *
+     * Only the owning thread writes to the ring and only end_frame reads from it, so the two indices are all the
+     * synchronization it needs
+     */
+    struct thread_samples {
+        std::array<profiler_sample, SAMPLES_PER_THREAD> ring;
+        std::atomic<uint32_t> write_idx{0};
+        std::atomic<uint32_t> read_idx{0};
+        std::atomic<uint32_t> num_dropped{0};
+
+        /*!
+         * \brief Which track of the trace this thread's scopes go on. Threads are numbered from 1 in the order they
+         * first profile something
+         */
+        uint32_t track = 0;
+
+        // Only ever touched by the owning thread
+        std::array<open_scope, MAX_SCOPE_DEPTH> open_scopes;
+        int depth = 0;
+        int overflowed_depth = 0;
+    };
+
+    /*!
+     * \brief The per-frame totals for one scope
+     */
+    struct scope_timings {
+        const char* name;
+        uint32_t parent_node_id;
+        int depth;
+        bool has_gpu_time = false;
+
+        std::array<int64_t, NUM_SAMPLES> cpu_ns = {};
+        std::array<int64_t, NUM_SAMPLES> gpu_ns = {};
+        int64_t cpu_ns_this_frame = 0;
+        int64_t gpu_ns_this_frame = 0;
+    };
+
+    struct pending_gpu_sample {
+        uint32_t node_id;
+        const char* name;
+        int gpu_timer;
+        uint64_t frame;
+    };
+
+    /*!
+     * \brief One scope in the trace. Times are in nanoseconds since the profiler's epoch
+     */
+    struct trace_event {
+        const char* name;
+        uint32_t track;
+        int64_t start_ns;
+        int64_t duration_ns;
+        uint64_t frame;
+    };
+
+    static std::mutex all_threads_lock;
+    static std::vector<std::shared_ptr<thread_samples>> all_threads;
+
+    static std::mutex interned_names_lock;
+    static std::unordered_map<uint32_t, std::unique_ptr<std::string>> interned_names;
+
+    // Only touched by the thread that calls end_frame, which is the GL thread
+    static std::unordered_map<uint32_t, scope_timings> timings;
+    static std::vector<GLuint> gpu_timer_queries;
+    static std::vector<int> free_gpu_timers;
+    static std::vector<pending_gpu_sample> pending_gpu_samples;
+    static uint64_t frame_count = 0;
+
+    /*!
+     * \brief Every scope's time is measured from here, so times fit in an int64_t and line up across threads
+     */
+    static const auto epoch = std::chrono::high_resolution_clock::now();
+
+    // The trace is also only touched by the thread that calls end_frame
+    static std::vector<trace_event> trace;
+    static size_t trace_write_idx = 0;
+    static uint32_t render_thread_track = 0;
+    static int64_t last_frame_end_ns = -1;
+    static double trace_spike_threshold_ms = 0;
+    static std::string trace_directory = "traces";
+    static uint64_t trace_spike_save_frame = 0;
+    static uint64_t last_trace_spike_frame = 0;
+    static bool has_saved_spike_trace = false;
+
+    static int64_t get_time_ns(std::chrono::high_resolution_clock::time_point time) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(time - epoch).count();
+    }
+
+    static void add_trace_event(const char* name, uint32_t track, int64_t start_ns, int64_t duration_ns, uint64_t frame) {
+        if(trace.size() < TRACE_CAPACITY) {
+            trace.push_back({name, track, start_ns, duration_ns, frame});
+        } else {
+            trace[trace_write_idx] = {name, track, start_ns, duration_ns, frame};
+        }
+        trace_write_idx = (trace_write_idx + 1) % TRACE_CAPACITY;
+    }
+
+    static thread_samples& get_thread_samples() {
+        thread_local std::shared_ptr<thread_samples> samples;
+        if(!samples) {
+            samples = std::make_shared<thread_samples>();
+
+            std::lock_guard<std::mutex> lock(all_threads_lock);
+            all_threads.push_back(samples);
+            samples->track = static_cast<uint32_t>(all_threads.size());
+        }
+
+        return *samples;
+    }
+
+    static int allocate_gpu_timer() {
+        if(free_gpu_timers.empty()) {
+            size_t first_new_query = gpu_timer_queries.size();
+            gpu_timer_queries.resize(first_new_query + GPU_TIMERS_PER_BATCH * 2);
+            glGenQueries(GPU_TIMERS_PER_BATCH * 2, &gpu_timer_queries[first_new_query]);
+
+            for(size_t i = 0; i < GPU_TIMERS_PER_BATCH; i++) {
+                free_gpu_timers.push_back(static_cast<int>(first_new_query / 2 + i));
+            }
+        }
+
+        int timer = free_gpu_timers.back();
+        free_gpu_timers.pop_back();
+        return timer;
+    }
+
+    profiler_scope profiler::intern_scope(const std::string& name) {
+        uint32_t id = hash_scope_name(name.c_str());
+
+        std::lock_guard<std::mutex> lock(interned_names_lock);
+        auto& interned_name = interned_names[id];
+        if(!interned_name) {
+            interned_name = std::make_unique<std::string>(name);
+        }
+
+        return {id, interned_name->c_str()};
+    }
+
+    void profiler::start(const profiler_scope& scope) {
+        start(scope, false);
+    }
+
+    void profiler::start(const std::string& name) {
+        start(intern_scope(name), false);
+    }
+
+    void profiler::start_gpu(const profiler_scope& scope) {
+        start(scope, true);
+    }
+
+    void profiler::start_gpu(const std::string& name) {
+        start(intern_scope(name), true);
+    }
+
+    void profiler::start(const profiler_scope& scope, bool time_gpu) {
+        auto& samples = get_thread_samples();
+        if(samples.depth == MAX_SCOPE_DEPTH) {
+            samples.overflowed_depth++;
+            return;
+        }
+
+        uint32_t parent_node_id = samples.depth > 0 ? samples.open_scopes[samples.depth - 1].node_id : 0;
+
+        auto& new_scope = samples.open_scopes[samples.depth];
+        new_scope.scope_id = scope.id;
+        new_scope.node_id = (parent_node_id ^ scope.id) * 16777619u;
+        new_scope.name = scope.name;
+        new_scope.gpu_timer = -1;
+        if(time_gpu) {
+            new_scope.gpu_timer = allocate_gpu_timer();
+            glQueryCounter(gpu_timer_queries[new_scope.gpu_timer * 2], GL_TIMESTAMP);
+        }
+        samples.depth++;
+
+        // Read the clock last so none of the work above counts against the scope
+        new_scope.start_time = std::chrono::high_resolution_clock::now();
+    }
+
+    void profiler::end(const profiler_scope& scope) {
+        auto end_time = std::chrono::high_resolution_clock::now();
+
+        auto& samples = get_thread_samples();
+        if(samples.overflowed_depth > 0) {
+            samples.overflowed_depth--;
+            return;
+        }
+
+        if(samples.depth == 0) {
+            LOG(WARNING) << "Profiler scope " << scope.name << " ended, but it was never started";
+            return;
+        }
+
+        samples.depth--;
+        const auto& ended_scope = samples.open_scopes[samples.depth];
+        if(ended_scope.scope_id != scope.id) {
+            LOG(WARNING) << "Profiler scope " << scope.name << " ended, but the most recently started scope is " << ended_scope.name;
+        }
+
+        if(ended_scope.gpu_timer >= 0) {
+            glQueryCounter(gpu_timer_queries[ended_scope.gpu_timer * 2 + 1], GL_TIMESTAMP);
+        }
 
-    void profiler::start(std::string name) {
-        auto section_itr = data.find(name);
-        if(section_itr == data.end()) {
-            data[name] = profiler_data();
+        uint32_t write_idx = samples.write_idx.load(std::memory_order_relaxed);
+        if(write_idx - samples.read_idx.load(std::memory_order_acquire) >= SAMPLES_PER_THREAD) {
+            samples.num_dropped.fetch_add(1, std::memory_order_relaxed);
+            if(ended_scope.gpu_timer >= 0) {
+                free_gpu_timers.push_back(ended_scope.gpu_timer);
+            }
+            return;
         }
 
-        auto &cur_profiler_data = data[name];
-        cur_profiler_data.start_time = std::chrono::high_resolution_clock::now();
+        auto& sample = samples.ring[write_idx % SAMPLES_PER_THREAD];
+        sample.node_id = ended_scope.node_id;
+        sample.parent_node_id = samples.depth > 0 ? samples.open_scopes[samples.depth - 1].node_id : 0;
+        sample.name = ended_scope.name;
+        sample.depth = samples.depth;
+        sample.start_ns = get_time_ns(ended_scope.start_time);
+        sample.duration_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - ended_scope.start_time).count();
+        sample.gpu_timer = ended_scope.gpu_timer;
+
+        samples.write_idx.store(write_idx + 1, std::memory_order_release);
+    }
+
+    void profiler::end(const std::string& name) {
+        end(profiler_scope{hash_scope_name(name.c_str()), name.c_str()});
+    }
+
+    void profiler::end_frame() {
+        const int64_t frame_end_ns = get_time_ns(std::chrono::high_resolution_clock::now());
+        render_thread_track = get_thread_samples().track;
+
+        {
+            std::lock_guard<std::mutex> lock(all_threads_lock);
+            for(auto& samples : all_threads) {
+                uint32_t write_idx = samples->write_idx.load(std::memory_order_acquire);
+                uint32_t read_idx = samples->read_idx.load(std::memory_order_relaxed);
+
+                for(; read_idx != write_idx; read_idx++) {
+                    const auto& sample = samples->ring[read_idx % SAMPLES_PER_THREAD];
+
+                    auto timings_itr = timings.find(sample.node_id);
+                    if(timings_itr == timings.end()) {
+                        scope_timings new_timings;
+                        new_timings.name = sample.name;
+                        new_timings.parent_node_id = sample.parent_node_id;
+                        new_timings.depth = sample.depth;
+                        timings_itr = timings.emplace(sample.node_id, new_timings).first;
+                    }
+                    timings_itr->second.cpu_ns_this_frame += sample.duration_ns;
+                    add_trace_event(sample.name, samples->track, sample.start_ns, sample.duration_ns, frame_count);
+
+                    if(sample.gpu_timer >= 0) {
+                        timings_itr->second.has_gpu_time = true;
+                        pending_gpu_samples.push_back({sample.node_id, sample.name, sample.gpu_timer, frame_count});
+                    }
+                }
+
+                samples->read_idx.store(read_idx, std::memory_order_release);
+
+                uint32_t num_dropped = samples->num_dropped.exchange(0, std::memory_order_relaxed);
+                if(num_dropped > 0) {
+                    LOG(WARNING) << "Dropped " << num_dropped << " profiler samples because a thread's ring buffer was full";
+                }
+            }
+        }
+
+        // GPU results come back a few frames late. Read the ones that are ready and leave the rest for next frame.
+        // Timestamps finish in order, so the first one that's not ready means none of the later ones are either
+        size_t num_resolved = 0;
+        int64_t gpu_to_cpu_ns = 0;
+        if(!pending_gpu_samples.empty()) {
+            // GL timestamps count from whenever the driver likes, so they're moved onto the CPU's clock for the trace.
+            // Reading the GPU's time right now doesn't wait for anything
+            GLint64 gpu_now = 0;
+            glGetInteger64v(GL_TIMESTAMP, &gpu_now);
+            gpu_to_cpu_ns = get_time_ns(std::chrono::high_resolution_clock::now()) - gpu_now;
+        }
+        for(const auto& pending : pending_gpu_samples) {
+            GLuint end_query = gpu_timer_queries[pending.gpu_timer * 2 + 1];
+            GLint available = 0;
+            glGetQueryObjectiv(end_query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if(!available) {
+                break;
+            }
+
+            GLuint64 start_time = 0;
+            GLuint64 end_time = 0;
+            glGetQueryObjectui64v(gpu_timer_queries[pending.gpu_timer * 2], GL_QUERY_RESULT, &start_time);
+            glGetQueryObjectui64v(end_query, GL_QUERY_RESULT, &end_time);
+
+            timings[pending.node_id].gpu_ns_this_frame += static_cast<int64_t>(end_time - start_time);
+            add_trace_event(pending.name, GPU_TRACK, static_cast<int64_t>(start_time) + gpu_to_cpu_ns,
+                            static_cast<int64_t>(end_time - start_time), pending.frame);
+            free_gpu_timers.push_back(pending.gpu_timer);
+            num_resolved++;
+        }
+        pending_gpu_samples.erase(pending_gpu_samples.begin(), pending_gpu_samples.begin() + num_resolved);
+
+        const auto sample_idx = frame_count % NUM_SAMPLES;
+        for(auto& item : timings) {
+            auto& scope = item.second;
+            scope.cpu_ns[sample_idx] = scope.cpu_ns_this_frame;
+            scope.gpu_ns[sample_idx] = scope.gpu_ns_this_frame;
+            scope.cpu_ns_this_frame = 0;
+            scope.gpu_ns_this_frame = 0;
+        }
+
+        // The whole frame gets an event too, so frames are easy to pick out in the trace
+        if(last_frame_end_ns >= 0) {
+            const int64_t frame_ns = frame_end_ns - last_frame_end_ns;
+            add_trace_event("frame", render_thread_track, last_frame_end_ns, frame_ns, frame_count);
+
+            const bool is_spike = trace_spike_threshold_ms > 0 && frame_ns / 1000000.0 > trace_spike_threshold_ms;
+            const bool is_cooling_down = has_saved_spike_trace &&
+                                         frame_count < last_trace_spike_frame + TRACE_SPIKE_COOLDOWN_FRAMES;
+            if(is_spike && !is_cooling_down && trace_spike_save_frame == 0) {
+                LOG(INFO) << "Frame " << frame_count << " took " << frame_ns / 1000000.0 << " ms, so its trace will be saved";
+                trace_spike_save_frame = frame_count + TRACE_SPIKE_DELAY_FRAMES;
+                last_trace_spike_frame = frame_count;
+                has_saved_spike_trace = true;
+            }
+        }
+        last_frame_end_ns = frame_end_ns;
+
+        if(trace_spike_save_frame != 0 && frame_count >= trace_spike_save_frame) {
+            const uint64_t spike_frame = trace_spike_save_frame - TRACE_SPIKE_DELAY_FRAMES;
+            trace_spike_save_frame = 0;
+            make_directory(trace_directory);
+            save_trace(trace_directory + "/nova-trace-frame" + std::to_string(spike_frame) + ".json");
+        }
+
+        frame_count++;
+        if(frame_count % NUM_SAMPLES == 0) {
+            log_all_profiler_data();
+        }
+    }
+
+    /*!
+     * \brief Writes the string as a JSON string, quotes and all
+     */
+    static void write_json_string(std::ostream& out, const char* text) {
+        out << '"';
+        for(const char* c = text; *c != '\0'; c++) {
+            if(*c == '"' || *c == '\\') {
+                out << '\\' << *c;
+            } else if(static_cast<unsigned char>(*c) < 0x20) {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", *c);
+                out << escaped;
+            } else {
+                out << *c;
+            }
+        }
+        out << '"';
+    }
+
+    void profiler::write_trace(std::ostream& out) {
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+        // Name the tracks first, so they're labeled even if the ring has lost their events
+        size_t num_tracks;
+        {
+            std::lock_guard<std::mutex> lock(all_threads_lock);
+            num_tracks = all_threads.size();
+        }
+        for(uint32_t track = 0; track <= num_tracks; track++) {
+            std::string name;
+            if(track == GPU_TRACK) {
+                name = "GPU";
+            } else if(track == render_thread_track) {
+                name = "Render thread";
+            } else {
+                name = "Thread " + std::to_string(track);
+            }
+            out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << track << ",\"args\":{\"name\":";
+            write_json_string(out, name.c_str());
+            out << "}},\n";
+            out << "{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":" << track
+                << ",\"args\":{\"sort_index\":" << (track == GPU_TRACK ? num_tracks + 1 : track) << "}},\n";
+        }
+
+        // Oldest first. Chrome's viewer wants microseconds, and keeps the fraction
+        out << std::fixed << std::setprecision(3);
+        const size_t first_event = trace.size() < TRACE_CAPACITY ? 0 : trace_write_idx;
+        for(size_t i = 0; i < trace.size(); i++) {
+            const auto& event = trace[(first_event + i) % trace.size()];
+            out << "{\"name\":";
+            write_json_string(out, event.name);
+            out << ",\"cat\":\"" << (event.track == GPU_TRACK ? "gpu" : "cpu") << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                << event.track << ",\"ts\":" << event.start_ns / 1000.0 << ",\"dur\":" << event.duration_ns / 1000.0
+                << ",\"args\":{\"frame\":" << event.frame << "}}" << (i + 1 < trace.size() ? ",\n" : "\n");
+        }
+
+        out << "]}\n";
     }
 
-    void profiler::end(std::string name) {
-        auto &cur_profiler_data = data[name];
-        auto duration = std::chrono::high_resolution_clock::now() - cur_profiler_data.start_time;
-        cur_profiler_data.total_duration += duration;
+    bool profiler::save_trace(const std::string& path) {
+        std::ofstream file(path, std::ios::binary);
+        if(!file.is_open()) {
+            LOG(ERROR) << "Could not open " << path << " to save the profiler trace to";
+            return false;
+        }
+
+        write_trace(file);
+        if(!file.good()) {
+            LOG(ERROR) << "Could not write the profiler trace to " << path;
+            return false;
+        }
+
+        LOG(INFO) << "Saved the profiler trace to " << path;
+        return true;
+    }
+
+    void profiler::set_trace_spike_threshold(double threshold_ms) {
+        trace_spike_threshold_ms = threshold_ms;
+    }
+
+    void profiler::set_trace_directory(const std::string& directory) {
+        trace_directory = directory;
+    }
+
+    std::string profiler::get_trace_directory() {
+        return trace_directory;
+    }
+
+    /*!
+     * \brief Calculates the min, average, and 99th percentile of the first num_frames samples, in milliseconds
+     */
+    static void calculate_statistics(const std::array<int64_t, NUM_SAMPLES>& samples, size_t num_frames,
+                                     double& min_ms, double& avg_ms, double& p99_ms) {
+        min_ms = avg_ms = p99_ms = 0;
+        if(num_frames == 0) {
+            return;
+        }
+
+        std::array<int64_t, NUM_SAMPLES> sorted = samples;
+        std::sort(sorted.begin(), sorted.begin() + num_frames);
+
+        int64_t total = 0;
+        for(size_t i = 0; i < num_frames; i++) {
+            total += sorted[i];
+        }
+
+        const size_t p99_idx = std::min(num_frames - 1, (num_frames * 99) / 100);
+
+        min_ms = sorted[0] / 1000000.0;
+        avg_ms = (total / static_cast<double>(num_frames)) / 1000000.0;
+        p99_ms = sorted[p99_idx] / 1000000.0;
+    }
+
+    std::vector<profiler_statistics> profiler::get_statistics() {
+        const auto num_frames = static_cast<size_t>(std::min<uint64_t>(frame_count, NUM_SAMPLES));
+
+        std::unordered_map<uint32_t, std::vector<uint32_t>> children;
+        for(const auto& item : timings) {
+            children[item.second.parent_node_id].push_back(item.first);
+        }
+        for(auto& item : children) {
+            std::sort(item.second.begin(), item.second.end(), [](uint32_t a, uint32_t b) {
+                return std::strcmp(timings[a].name, timings[b].name) < 0;
+            });
+        }
+
+        std::vector<profiler_statistics> statistics;
+        statistics.reserve(timings.size());
+
+        // Depth-first from the root scopes, so every scope comes right after its parent
+        std::vector<uint32_t> nodes_to_visit(children[0].rbegin(), children[0].rend());
+        while(!nodes_to_visit.empty()) {
+            uint32_t node_id = nodes_to_visit.back();
+            nodes_to_visit.pop_back();
+
+            const auto& scope = timings[node_id];
+            profiler_statistics stats = {};
+            stats.name = scope.name;
+            stats.depth = scope.depth;
+            stats.has_gpu_time = scope.has_gpu_time;
+            calculate_statistics(scope.cpu_ns, num_frames, stats.cpu_min_ms, stats.cpu_avg_ms, stats.cpu_p99_ms);
+            calculate_statistics(scope.gpu_ns, num_frames, stats.gpu_min_ms, stats.gpu_avg_ms, stats.gpu_p99_ms);
+            statistics.push_back(stats);
+
+            auto children_itr = children.find(node_id);
+            if(children_itr != children.end()) {
+                nodes_to_visit.insert(nodes_to_visit.end(), children_itr->second.rbegin(), children_itr->second.rend());
+            }
+        }
+
+        return statistics;
     }
 
     void profiler::log_all_profiler_data() {
         std::stringstream ss;
-        for(const auto& item : data) {
-            const auto& cur_profiler_data = item.second;
+        ss << "Timings for the last " << std::min<uint64_t>(frame_count, NUM_SAMPLES) << " frames, in ms (min / avg / p99):\n";
+        ss << std::fixed << std::setprecision(3);
 
-            ss << "Profiled section " << item.first << " has taken an total of " << double(std::chrono::duration_cast<std::chrono::nanoseconds>(cur_profiler_data.total_duration).count()) / 1000000.0f << "ms to execute since the game began\n";
+        for(const auto& stats : get_statistics()) {
+            ss << std::string(stats.depth * 2, ' ') << stats.name << ": CPU " << stats.cpu_min_ms << " / "
+               << stats.cpu_avg_ms << " / " << stats.cpu_p99_ms;
+            if(stats.has_gpu_time) {
+                ss << ", GPU " << stats.gpu_min_ms << " / " << stats.gpu_avg_ms << " / " << stats.gpu_p99_ms;
+            }
+            ss << "\n";
         }
 
-        //LOG_EVERY_N(100, DEBUG) << ss.str();
+        LOG(DEBUG) << ss.str();
     }
 }
@@ -1,37 +1,179 @@
-/*! 
- * \author gold1 
+/*!
+ * \author gold1
  * \date 30-Aug-17.
  */
 
 #ifndef RENDERER_PROFILER_H
 #define RENDERER_PROFILER_H
 
-#include <unordered_map>
+#include <cstdint>
+#include <ostream>
 #include <string>
-#include <chrono>
-#include <easylogging++.h>
+#include <type_traits>
+#include <vector>
 
 namespace nova {
+    /*!
+     * \brief How many frames of timings are kept for each scope
+     */
     const int NUM_SAMPLES = 120;
 
-    struct profiler_data {
-        std::chrono::high_resolution_clock::time_point start_time;
+    /*!
+     * \brief Hashes a scope name with FNV-1a. It's constexpr so scope names known at compile time can be hashed at
+     * compile time
+     */
+    constexpr uint32_t hash_scope_name(const char* name, uint32_t hash = 2166136261u) {
+        return *name == '\0' ? hash : hash_scope_name(name + 1, (hash ^ static_cast<uint8_t>(*name)) * 16777619u);
+    }
+
+    /*!
+     * \brief Identifies a profiled section of code
+     *
+     * The name must outlive the profiler. String literals do, and profiler::intern_scope gives names that are only
+     * known at runtime a permanent home
+     */
+    struct profiler_scope {
+        uint32_t id;
+        const char* name;
+    };
+
+    /*!
+     * \brief Makes a profiler_scope from a string literal, with the scope's ID computed at compile time
+     */
+    #define NOVA_PROFILER_SCOPE(name) (nova::profiler_scope{std::integral_constant<uint32_t, nova::hash_scope_name(name)>::value, name})
+
+    /*!
+     * \brief The timings of one scope over the last NUM_SAMPLES frames
+     */
+    struct profiler_statistics {
+        std::string name;
+
+        /*!
+         * \brief How many scopes this scope is nested inside of
+         */
+        int depth;
 
-        // Using a ring buffer because it's fast
-        std::chrono::high_resolution_clock::duration total_duration;
+        double cpu_min_ms;
+        double cpu_avg_ms;
+        double cpu_p99_ms;
+
+        /*!
+         * \brief True if this scope was started with profiler::start_gpu, so the GPU timings mean something
+         */
+        bool has_gpu_time;
+        double gpu_min_ms;
+        double gpu_avg_ms;
+        double gpu_p99_ms;
     };
 
     /*!
-     * \brief A simple namespace to hold profiling functions
+     * \brief Times nested sections of code on any thread, and optionally on the GPU
+     *
+     * Each thread records its samples into its own ring buffer, so starting and ending a scope never takes a lock or
+     * looks anything up in a map. Scopes started while another scope is open on the same thread are recorded as its
+     * children, and the same scope under different parents gets its own timings.
+     *
+     * Once per frame, end_frame collects the samples from every thread and adds them to each scope's total for that
+     * frame. Per-frame totals are kept for the last NUM_SAMPLES frames, which is where the min/avg/p99 numbers come
+     * from.
+     *
+     * GPU scopes put a pair of GL_TIMESTAMP queries around their commands. The results are read a few frames later,
+     * once they're available, so reading them never stalls the pipeline
+     *
+     * Totals hide the odd slow frame, so end_frame also keeps every scope it collects in a trace: a ring of the few
+     * hundred frames' worth of scopes, each with its thread, start time, and frame. GPU scopes go on their own track, moved onto
+     * the CPU's clock. #save_trace writes the trace in Chrome's trace event format, which chrome://tracing and
+     * Perfetto can open. When a frame takes longer than the spike threshold, the trace is saved a few frames later on
+     * its own, once the frame's GPU timings are in
      */
     class profiler {
     public:
-        static void start(std::string name);
-        static void end(std::string name);
+        /*!
+         * \brief Starts timing the given scope on this thread
+         */
+        static void start(const profiler_scope& scope);
+
+        /*!
+         * \brief Starts timing a scope whose name is only known at runtime
+         *
+         * This has to intern the name, so it takes a lock. Prefer NOVA_PROFILER_SCOPE for names known at compile time
+         */
+        static void start(const std::string& name);
+
+        /*!
+         * \brief Starts timing the given scope on both the CPU and the GPU
+         *
+         * Must be called from the thread that owns the OpenGL context
+         */
+        static void start_gpu(const profiler_scope& scope);
+
+        static void start_gpu(const std::string& name);
+
+        /*!
+         * \brief Ends the scope most recently started on this thread
+         *
+         * \param scope The scope that's expected to end. A warning is logged if it's not the most recently started
+         * scope, since that means a start and end don't match up
+         */
+        static void end(const profiler_scope& scope);
+
+        static void end(const std::string& name);
+
+        /*!
+         * \brief Collects the samples from all threads, reads back any GPU timings that are ready, and moves on to
+         * the next frame
+         *
+         * Should be called once per frame, from the thread that owns the OpenGL context. Logs a table of all the
+         * scopes every NUM_SAMPLES frames
+         */
+        static void end_frame();
+
+        /*!
+         * \brief Logs the min, average, and 99th percentile time of every scope
+         */
         static void log_all_profiler_data();
 
+        /*!
+         * \brief Gets the statistics for all the scopes, with children listed right after their parents
+         */
+        static std::vector<profiler_statistics> get_statistics();
+
+        /*!
+         * \brief Gives the name a permanent home so it can be used in a profiler_scope
+         */
+        static profiler_scope intern_scope(const std::string& name);
+
+        /*!
+         * \brief Writes the trace as Chrome trace event JSON, oldest scope first
+         *
+         * Must be called from the thread that calls end_frame
+         */
+        static void write_trace(std::ostream& out);
+
+        /*!
+         * \brief Writes the trace to a file that chrome://tracing or Perfetto can open
+         *
+         * Must be called from the thread that calls end_frame
+         *
+         * \return True if the trace was written
+         */
+        static bool save_trace(const std::string& path);
+
+        /*!
+         * \brief Frames that take longer than this many milliseconds have their trace saved to the trace directory.
+         * 0 turns that off
+         */
+        static void set_trace_spike_threshold(double threshold_ms);
+
+        /*!
+         * \brief Where traces of slow frames, and traces asked for with the hotkey, are saved
+         */
+        static void set_trace_directory(const std::string& directory);
+
+        static std::string get_trace_directory();
+
     private:
-        static std::unordered_map<std::string, profiler_data> data;
+        static void start(const profiler_scope& scope, bool time_gpu);
     };
 }
 
@@ -0,0 +1,64 @@
+/*!
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#include "ring_allocator.h"
+
+namespace nova {
+    ring_allocator::ring_allocator(uint64_t size, uint64_t alignment) : size(size), alignment(alignment) {}
+
+    bool ring_allocator::allocate(uint64_t num_bytes, uint64_t& offset) {
+        // Round up so every allocation takes some space, and the next one starts aligned
+        const uint64_t aligned_size = num_bytes == 0 ? alignment : (num_bytes + alignment - 1) / alignment * alignment;
+
+        if(allocations.empty()) {
+            // Nothing's using the ring, so start from the beginning to keep allocations from wrapping
+            if(aligned_size > size) {
+                return false;
+            }
+            offset = 0;
+
+        } else {
+            const uint64_t oldest_begin = allocations.front().begin;
+            const uint64_t newest_begin = allocations.back().begin;
+            const uint64_t newest_end = allocations.back().end;
+
+            if(newest_begin >= oldest_begin) {
+                // Not wrapped. The free space is from the newest allocation to the end of the ring, then from the
+                // start of the ring to the oldest allocation
+                if(newest_end + aligned_size <= size) {
+                    offset = newest_end;
+                } else if(aligned_size <= oldest_begin) {
+                    offset = 0;
+                } else {
+                    return false;
+                }
+
+            } else if(newest_end + aligned_size <= oldest_begin) {
+                // Wrapped. The only free space is between the newest allocation and the oldest one
+                offset = newest_end;
+
+            } else {
+                return false;
+            }
+        }
+
+        allocations.push_back({offset, offset + aligned_size});
+        return true;
+    }
+
+    void ring_allocator::free_oldest() {
+        if(!allocations.empty()) {
+            allocations.pop_front();
+        }
+    }
+
+    bool ring_allocator::empty() const {
+        return allocations.empty();
+    }
+
+    uint64_t ring_allocator::get_size() const {
+        return size;
+    }
+}
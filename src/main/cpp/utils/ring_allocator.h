@@ -0,0 +1,69 @@
+/*!
+ * \brief Hands out space in a ring buffer that's freed in the same order it was handed out
+ *
+ * \author ddubois
+ * \date 15-Oct-26.
+ */
+
+#ifndef RENDERER_RING_ALLOCATOR_H
+#define RENDERER_RING_ALLOCATOR_H
+
+#include <cstdint>
+#include <deque>
+
+namespace nova {
+    /*!
+     * \brief Keeps track of which parts of a ring buffer are in use, without touching the buffer itself
+     *
+     * New allocations go right after the newest one, and wrap around to the start of the ring when they don't fit
+     * before its end. Allocations are freed oldest first, which is the order the GPU finishes with them. Every
+     * allocation is remembered, so a ring that's exactly full is never mistaken for an empty one: whether the ring has
+     * wrapped comes from where the oldest and newest allocations begin, and those are never the same place unless
+     * they're the same allocation.
+     *
+     * The owner keeps its fences in the same order, and calls #free_oldest when the oldest one has passed
+     */
+    class ring_allocator {
+    public:
+        /*!
+         * \param size How many bytes the ring holds
+         * \param alignment Every allocation starts at a multiple of this
+         */
+        ring_allocator(uint64_t size, uint64_t alignment);
+
+        /*!
+         * \brief Tries to find space for the given number of bytes
+         *
+         * \param num_bytes How many bytes are needed
+         * \param offset Where the space starts, if there's room
+         * \return True if the space was found, and is now the newest allocation. False if older allocations are in
+         * the way, in which case the oldest one has to be freed before trying again
+         */
+        bool allocate(uint64_t num_bytes, uint64_t& offset);
+
+        /*!
+         * \brief Frees the oldest allocation
+         */
+        void free_oldest();
+
+        bool empty() const;
+
+        uint64_t get_size() const;
+
+    private:
+        struct allocation {
+            uint64_t begin;
+            uint64_t end;
+        };
+
+        uint64_t size;
+        uint64_t alignment;
+
+        /*!
+         * \brief Every allocation that hasn't been freed, oldest first
+         */
+        std::deque<allocation> allocations;
+    };
+}
+
+#endif //RENDERER_RING_ALLOCATOR_H
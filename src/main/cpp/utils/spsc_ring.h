@@ -0,0 +1,85 @@
+/*!
+ * \brief A lock-free ring buffer for one thread to push to and one thread to pop from
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_SPSC_RING_H
+#define RENDERER_SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+
+namespace nova {
+    /*!
+     * \brief A fixed-capacity single-producer, single-consumer queue
+     *
+     * The producer only writes the write index and the consumer only writes the read index, so neither side ever
+     * waits on the other. Pushing to a full ring fails instead of growing, and popping from an empty ring costs two
+     * atomic loads
+     *
+     * \tparam T The type of thing in the ring. Must be copyable
+     * \tparam Capacity How many things fit in the ring. Must be a power of two
+     */
+    template <typename T, size_t Capacity>
+    class spsc_ring {
+        static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "The capacity of a spsc_ring must be a power of two");
+
+    public:
+        spsc_ring() = default;
+        spsc_ring(const spsc_ring&) = delete;
+        spsc_ring& operator=(const spsc_ring&) = delete;
+
+        /*!
+         * \brief Adds a value to the ring. Must only be called from the producer thread
+         *
+         * \return False if the ring is full, in which case the value isn't added
+         */
+        bool try_push(const T& value) {
+            const size_t write = write_index.load(std::memory_order_relaxed);
+            if(write - read_index.load(std::memory_order_acquire) == Capacity) {
+                return false;
+            }
+
+            values[write & (Capacity - 1)] = value;
+            write_index.store(write + 1, std::memory_order_release);
+            return true;
+        }
+
+        /*!
+         * \brief Takes the oldest value out of the ring. Must only be called from the consumer thread
+         *
+         * \return False if the ring is empty
+         */
+        bool try_pop(T& value) {
+            const size_t read = read_index.load(std::memory_order_relaxed);
+            if(read == write_index.load(std::memory_order_acquire)) {
+                return false;
+            }
+
+            value = values[read & (Capacity - 1)];
+            read_index.store(read + 1, std::memory_order_release);
+            return true;
+        }
+
+        /*!
+         * \brief Checks if there's anything to pop. Must only be called from the consumer thread
+         */
+        bool is_empty() const {
+            return read_index.load(std::memory_order_relaxed) == write_index.load(std::memory_order_acquire);
+        }
+
+    private:
+        T values[Capacity];
+
+        /*!
+         * \brief The indices only ever go up, and are wrapped when they're used. They're on separate cache lines so
+         * the two threads don't fight over them
+         */
+        alignas(64) std::atomic<size_t> write_index{0};
+        alignas(64) std::atomic<size_t> read_index{0};
+    };
+}
+
+#endif //RENDERER_SPSC_RING_H
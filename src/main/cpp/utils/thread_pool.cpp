@@ -0,0 +1,99 @@
+/*!
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#include <algorithm>
+#include <easylogging++.h>
+#include "thread_pool.h"
+
+namespace nova {
+    thread_pool::thread_pool(unsigned int num_threads, const std::string& name) : name(name) {
+        if(num_threads == 0) {
+            num_threads = 1;
+        }
+
+        for(unsigned int i = 0; i < num_threads; i++) {
+            workers.emplace_back(&thread_pool::run_tasks, this);
+        }
+
+        LOG(INFO) << "Started thread pool " << name << " with " << num_threads << " threads";
+    }
+
+    thread_pool::~thread_pool() {
+        {
+            std::lock_guard<std::mutex> lock(tasks_lock);
+            should_stop = true;
+        }
+        tasks_available.notify_all();
+
+        for(auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    void thread_pool::add_task(std::function<void()> task, float priority) {
+        {
+            std::lock_guard<std::mutex> lock(tasks_lock);
+            tasks.push_back({priority, next_task_order++, std::move(task)});
+            std::push_heap(tasks.begin(), tasks.end(), runs_after);
+        }
+        tasks_available.notify_one();
+    }
+
+    void thread_pool::add_tasks(std::vector<std::pair<std::function<void()>, float>>&& new_tasks) {
+        if(new_tasks.empty()) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(tasks_lock);
+            for(auto& task : new_tasks) {
+                tasks.push_back({task.second, next_task_order++, std::move(task.first)});
+                std::push_heap(tasks.begin(), tasks.end(), runs_after);
+            }
+        }
+
+        if(new_tasks.size() == 1) {
+            tasks_available.notify_one();
+        } else {
+            tasks_available.notify_all();
+        }
+    }
+
+    bool thread_pool::runs_after(const queued_task& a, const queued_task& b) {
+        if(a.priority != b.priority) {
+            return a.priority > b.priority;
+        }
+        return a.order > b.order;
+    }
+
+    unsigned int thread_pool::get_num_threads() const {
+        return static_cast<unsigned int>(workers.size());
+    }
+
+    void thread_pool::run_tasks() {
+        while(true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(tasks_lock);
+                tasks_available.wait(lock, [&] { return should_stop || !tasks.empty(); });
+
+                if(tasks.empty()) {
+                    // should_stop is set and there's nothing left to do
+                    return;
+                }
+
+                std::pop_heap(tasks.begin(), tasks.end(), runs_after);
+                task = std::move(tasks.back().task);
+                tasks.pop_back();
+            }
+
+            try {
+                task();
+            } catch(std::exception& e) {
+                LOG(ERROR) << "Task in thread pool " << name << " threw an exception: " << e.what();
+            }
+        }
+    }
+}
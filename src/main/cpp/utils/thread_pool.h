@@ -0,0 +1,91 @@
+/*!
+ * \brief A fixed-size pool of threads that run tasks in the background
+ *
+ * \author ddubois
+ * \date 14-Oct-26.
+ */
+
+#ifndef RENDERER_THREAD_POOL_H
+#define RENDERER_THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace nova {
+    /*!
+     * \brief Runs tasks on a set of worker threads
+     *
+     * Tasks with a lower priority are run first, and tasks with the same priority are run in the order they're added.
+     * Since there are several workers, tasks may finish in any order. The destructor finishes all the tasks that are
+     * already queued before it joins the workers
+     */
+    class thread_pool {
+    public:
+        /*!
+         * \brief Starts the worker threads
+         *
+         * \param num_threads How many worker threads to start. At least one thread is always started
+         * \param name What to call the pool in log messages
+         */
+        thread_pool(unsigned int num_threads, const std::string& name);
+
+        thread_pool(const thread_pool&) = delete;
+        thread_pool& operator=(const thread_pool&) = delete;
+
+        ~thread_pool();
+
+        /*!
+         * \brief Queues up a task to be run by the next free worker
+         *
+         * \param task The task to run
+         * \param priority Tasks with a lower priority are run before this one, and tasks with a higher priority after
+         * it
+         */
+        void add_task(std::function<void()> task, float priority = 0);
+
+        /*!
+         * \brief Queues up several tasks at once, taking the queue's lock once for all of them
+         *
+         * \param new_tasks Each task, with its priority like add_task takes
+         */
+        void add_tasks(std::vector<std::pair<std::function<void()>, float>>&& new_tasks);
+
+        unsigned int get_num_threads() const;
+
+    private:
+        std::string name;
+        std::vector<std::thread> workers;
+
+        struct queued_task {
+            float priority;
+            uint64_t order;
+            std::function<void()> task;
+        };
+
+        std::mutex tasks_lock;
+        std::condition_variable tasks_available;
+
+        /*!
+         * \brief A heap with the task that should run next at the front
+         */
+        std::vector<queued_task> tasks;
+        uint64_t next_task_order = 0;
+        bool should_stop = false;
+
+        void run_tasks();
+
+        /*!
+         * \brief Orders the heap, so the task with the lowest priority is at its front, and the oldest of those if
+         * there's a tie
+         */
+        static bool runs_after(const queued_task& a, const queued_task& b);
+    };
+}
+
+#endif //RENDERER_THREAD_POOL_H
@@ -6,6 +6,13 @@
 #include <easylogging++.h>
 
 #include "utils.h"
+#include "logging.h"
+
+#if defined(_WIN32)
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
 
 void initialize_logging() {
     // Configure the logger
@@ -20,6 +27,10 @@ void initialize_logging() {
 #endif
 
     el::Loggers::reconfigureAllLoggers(conf);
+
+#ifdef NOVA_ASYNC_LOGGING
+    nova::start_async_logging();
+#endif
 }
 
 namespace nova {
@@ -42,6 +53,14 @@ namespace nova {
         return nlohmann::json::parse(accum.c_str());
     }
 
+    void make_directory(const std::string& path) {
+#if defined(_WIN32)
+        _mkdir(path.c_str());
+#else
+        mkdir(path.c_str(), 0755);
+#endif
+    }
+
     std::vector<std::string> split(const std::string &s, char delim) {
         std::vector<std::string> elems;
         split(s, delim, std::back_inserter(elems));
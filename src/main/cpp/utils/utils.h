@@ -32,7 +32,7 @@ namespace nova {
      * \param thingToDo The action to perform for each element in the collection
      */
     template <typename Cont, typename Func>
-    void foreach(Cont container, Func thingToDo) {
+    void foreach(const Cont& container, Func thingToDo) {
         std::for_each(std::cbegin(container), std::cend(container), thingToDo);
     };
 
@@ -73,6 +73,11 @@ namespace nova {
      */
     nlohmann::json load_json_from_stream(std::istream& stream);
 
+    /*!
+     * \brief Makes the directory with the given path, if it doesn't exist yet. Its parent directory must exist
+     */
+    void make_directory(const std::string& path);
+
     /*!
      * \brief Stream insertion for glm::ivec3
      *
@@ -67,6 +67,8 @@ public interface NovaNative extends Library {
         public float min_v;
         public float max_v;
 
+        public mc_texture_atlas_location() {}
+
         public mc_texture_atlas_location(String name, float min_u, float min_v, float max_u, float max_v) {
             this.name = name;
             this.min_u = min_u;
@@ -92,6 +94,32 @@ public interface NovaNative extends Library {
         }
     }
 
+    class mc_atlas_sprite extends Structure {
+        public String name;
+        public int width;
+        public int height;
+        public Pointer texture_data;
+
+        public mc_atlas_sprite() {}
+
+        /**
+         * @param texture_data RGBA, four bytes per texel, top row first
+         */
+        public void set(String name, int width, int height, byte[] texture_data) {
+            this.name = name;
+            this.width = width;
+            this.height = height;
+
+            this.texture_data = new Memory(width * height * 4);
+            this.texture_data.write(0, texture_data, 0, width * height * 4);
+        }
+
+        @Override
+        public List<String> getFieldOrder() {
+            return Arrays.asList("name", "width", "height", "texture_data");
+        }
+    }
+
     class mc_chunk_render_object extends Structure {
         public int format;
         public float x;
@@ -117,7 +145,17 @@ public interface NovaNative extends Library {
             vertex_buffer_size = s;
         }
 
+        /**
+         * Block geometry that's all quads split 0, 1, 2, 0, 2, 3 can leave its indices empty, and Nova uses a shared
+         * copy of that pattern instead
+         */
         public void setIndices(List<Integer> indices) {
+            if(indices.isEmpty()) {
+                this.indices = null;
+                index_buffer_size = 0;
+                return;
+            }
+
             this.indices = new Memory(indices.size() * Native.getNativeSize(Integer.class));
             for(int i = 0; i < indices.size(); i++) {
                 Integer data = indices.get(i);
@@ -127,12 +165,136 @@ public interface NovaNative extends Library {
             index_buffer_size = indices.size();
         }
 
+        /**
+         * Points this chunk at direct buffers instead of copying the data into native memory. Use with
+         * add_chunk_geometry_for_filter_direct, and don't touch the buffers until is_chunk_geometry_upload_complete
+         * returns true for the returned ticket
+         *
+         * @param vertexData Vertex data in Nova's 13-int chunk layout
+         * @param indexData The chunk's indices, as ints, or null if the chunk is all quads
+         */
+        public void setDirectData(IntBuffer vertexData, IntBuffer indexData) {
+            vertex_data = Native.getDirectBufferPointer(vertexData);
+            vertex_buffer_size = vertexData.limit();
+
+            if(indexData == null) {
+                indices = null;
+                index_buffer_size = 0;
+            } else {
+                indices = Native.getDirectBufferPointer(indexData);
+                index_buffer_size = indexData.limit();
+            }
+        }
+
         @Override
         public List<String> getFieldOrder() {
             return Arrays.asList("format", "x", "y", "z", "id", "vertex_data", "indices", "vertex_buffer_size", "index_buffer_size");
         }
     }
 
+    /**
+     * One chunk in a batch for add_chunk_geometry_batch. Its data is in the batch's payload, and the offsets and sizes
+     * count ints. A chunk with no vertices is removed from its shader
+     */
+    class mc_chunk_batch_entry extends Structure {
+        public int shader_id;
+        public int format;
+        public float x;
+        public float y;
+        public float z;
+        public int id;
+        public int vertex_offset;
+        public int vertex_buffer_size;
+        public int index_offset;
+        public int index_buffer_size;
+
+        @Override
+        public List<String> getFieldOrder() {
+            return Arrays.asList("shader_id", "format", "x", "y", "z", "id", "vertex_offset", "vertex_buffer_size",
+                    "index_offset", "index_buffer_size");
+        }
+    }
+
+    class mc_mesher_block_type extends Structure {
+        public int block_id;
+        public int is_visible;
+        public int is_opaque;
+        public int shader_id;
+        public float[] face_uvs = new float[24];    // min u, max u, min v, max v for each face: -x, +x, -y, +y, -z, +z
+        public int[] face_tints = new int[6];
+
+        @Override
+        public List<String> getFieldOrder() {
+            return Arrays.asList("block_id", "is_visible", "is_opaque", "shader_id", "face_uvs", "face_tints");
+        }
+    }
+
+    class mc_chunk_section_blocks extends Structure {
+        public float x;
+        public float y;
+        public float z;
+        public int id;
+        public Pointer block_ids;   // short[18 * 18 * 18], indexed by (y * 18 + z) * 18 + x
+        public Pointer light;       // byte[18 * 18 * 18], block light in the low four bits, sky light in the high four
+
+        @Override
+        public List<String> getFieldOrder() {
+            return Arrays.asList("x", "y", "z", "id", "block_ids", "light");
+        }
+    }
+
+    class mc_entity_model extends Structure {
+        public int format;
+        public Pointer vertex_data;     // int[]
+        public Pointer indices;         // int[]
+        public int vertex_buffer_size;
+        public int index_buffer_size;
+        public String texture_name;
+
+        @Override
+        protected List<String> getFieldOrder() {
+            return Arrays.asList("format", "vertex_data", "indices", "vertex_buffer_size", "index_buffer_size", "texture_name");
+        }
+    }
+
+    class mc_entity_instance extends Structure {
+        public int model_id;
+        public int entity_id;
+        public int animation_frame;
+        public int lightmap_coord;                  // Entity.getBrightnessForRender
+        public float[] transform = new float[16];   // Column major, from the model's space to world space
+        public float[] tint = new float[4];
+
+        @Override
+        protected List<String> getFieldOrder() {
+            return Arrays.asList("model_id", "entity_id", "animation_frame", "lightmap_coord", "transform", "tint");
+        }
+    }
+
+    class mc_particle_emitter extends Structure {
+        public float[] position = new float[3];
+        public float position_spread;
+        public float[] velocity = new float[3];     // Blocks per second
+        public float velocity_spread;
+        public float[] color = new float[4];
+        public float[] uv_min = new float[2];
+        public float[] uv_max = new float[2];       // Animation frames are laid out left to right between uv_min and uv_max
+        public float size;
+        public float gravity;
+        public float drag;                          // The part of its velocity each particle keeps after a second
+        public float lifetime;                      // Seconds
+        public float lifetime_spread;
+        public int num_frames;
+        public int atlas;                           // From add_particle_atlas
+        public int count;
+
+        @Override
+        protected List<String> getFieldOrder() {
+            return Arrays.asList("position", "position_spread", "velocity", "velocity_spread", "color", "uv_min", "uv_max",
+                    "size", "gravity", "drag", "lifetime", "lifetime_spread", "num_frames", "atlas", "count");
+        }
+    }
+
     class mc_settings extends Structure {
         public boolean render_menu;
 
@@ -238,6 +400,79 @@ public interface NovaNative extends Library {
         }
     }
 
+    /**
+     * Matches MAX_MC_PASS_STATISTICS in mc_objects.h
+     */
+    int MAX_PASS_STATISTICS = 16;
+
+    class mc_pass_statistics extends Structure {
+        public byte[] name = new byte[32];
+        public long draw_calls;
+        public long draw_commands;
+        public long triangles;
+        public long primitives_submitted;
+        public long vertex_shader_invocations;
+        public long clipping_output_primitives;
+        public long fragment_shader_invocations;
+
+        @Override
+        protected List<String> getFieldOrder() {
+            return Arrays.asList("name", "draw_calls", "draw_commands", "triangles", "primitives_submitted",
+                    "vertex_shader_invocations", "clipping_output_primitives", "fragment_shader_invocations");
+        }
+    }
+
+    class mc_frame_statistics extends Structure {
+        public long frame;
+        public long draw_calls;
+        public long draw_commands;
+        public long triangles;
+        public long state_changes;
+        public long state_changes_saved;
+        public long texture_binds;
+        public long bytes_uploaded;
+        public long performance_warnings;
+        public int has_pipeline_statistics;
+        public int num_passes;
+        public mc_pass_statistics[] passes = (mc_pass_statistics[]) new mc_pass_statistics().toArray(MAX_PASS_STATISTICS);
+
+        @Override
+        protected List<String> getFieldOrder() {
+            return Arrays.asList("frame", "draw_calls", "draw_commands", "triangles", "state_changes",
+                    "state_changes_saved", "texture_binds", "bytes_uploaded", "performance_warnings",
+                    "has_pipeline_statistics", "num_passes", "passes");
+        }
+    }
+
+    class mc_gpu_memory_usage extends Structure {
+        public long chunk_geometry;
+        public long chunk_arena_reserved;
+        public long meshes;
+        public long textures;
+        public long framebuffers;
+        public long buffers;
+        public long total;
+        public long budget;
+
+        @Override
+        protected List<String> getFieldOrder() {
+            return Arrays.asList("chunk_geometry", "chunk_arena_reserved", "meshes", "textures", "framebuffers",
+                    "buffers", "total", "budget");
+        }
+    }
+
+    class mc_chunk_position extends Structure {
+        public int x;
+        public int y;
+        public int z;
+        public int id;
+
+        @Override
+        protected List<String> getFieldOrder() {
+            return Arrays.asList("x", "y", "z", "id");
+        }
+    }
+
     enum GeometryType {
         BLOCK,
         ENTITY,
@@ -266,10 +501,27 @@ public interface NovaNative extends Library {
 
     void send_lightmap_texture(int[] data, int length, int width, int height);
 
-    void add_texture(mc_atlas_texture texture);
+    /**
+     * Uploads the texture in the background. The texture's memory can be freed as soon as this returns
+     *
+     * @return A ticket to check with is_texture_upload_complete
+     */
+    long add_texture(mc_atlas_texture texture);
+
+    boolean is_texture_upload_complete(long ticket);
 
     void add_texture_location(mc_texture_atlas_location location);
 
+    /**
+     * Stitches the sprites into a new atlas and adds it along with every sprite's location, in one call
+     *
+     * @param sprites The first element of a contiguous array of sprites, made with Structure.toArray
+     * @param locations The first element of a contiguous array of num_sprites locations, made with Structure.toArray.
+     *                  Filled with where each sprite went, in the same order as the sprites
+     * @return A ticket to check with is_texture_upload_complete, or 0 if the sprites didn't fit
+     */
+    long add_texture_atlas(String atlas_name, mc_atlas_sprite sprites, int num_sprites, mc_texture_atlas_location locations);
+
     int get_max_texture_size();
 
     void reset_texture_manager();
@@ -278,6 +530,62 @@ public interface NovaNative extends Library {
 
     void remove_chunk_geometry_for_filter(String filter_name, mc_chunk_render_object render_object);
 
+    long add_chunk_geometry_for_filter_direct(String filter_name, mc_chunk_render_object render_object);
+
+    boolean is_chunk_geometry_upload_complete(long ticket);
+
+    int get_shader_id(String shader_name);
+
+    void add_chunk_geometry_for_shader(int shader_id, mc_chunk_render_object render_object);
+
+    void remove_chunk_geometry_for_shader(int shader_id, mc_chunk_render_object render_object);
+
+    long add_chunk_geometry_for_shader_direct(int shader_id, mc_chunk_render_object render_object);
+
+    /**
+     * Adds or removes a whole rebuild's worth of chunks in one call. The entries have to come from Structure.toArray
+     * so they're contiguous, and the payload can be reused as soon as this returns
+     *
+     * @param payload Every chunk's vertices and indices, packed together
+     */
+    void add_chunk_geometry_batch(mc_chunk_batch_entry[] entries, int num_entries, int[] payload, int payload_size);
+
+    void set_mesher_block_type(mc_mesher_block_type block_type);
+
+    void set_block_light_value(int block_id, int light_value);
+
+    void add_chunk_section_blocks(mc_chunk_section_blocks section);
+
+    void set_chunk_mesh_cache_world(String world_name, int dimension);
+
+    int add_entity_model(String filter_name, mc_entity_model model);
+
+    void remove_entity_model(int model_id);
+
+    /**
+     * @param instances The first element of a contiguous array of instances, made with Structure.toArray
+     */
+    void set_entity_instances(mc_entity_instance instances, int num_instances);
+
+    int add_particle_atlas(String filter_name, String texture_name);
+
+    /**
+     * @param emitters The first element of a contiguous array of emitters, made with Structure.toArray
+     */
+    void spawn_particles(mc_particle_emitter emitters, int num_emitters);
+
+    void clear_particles();
+
+    long save_screenshot(String path);
+
+    long save_framebuffer_attachment(String attachment_name, String path);
+
+    boolean is_readback_complete(long ticket);
+
+    void save_profiler_trace(String path);
+
+    void trigger_renderdoc_capture();
+
     boolean should_close();
 
     void add_gui_geometry(mc_gui_buffer buffer);
@@ -296,6 +604,17 @@ public interface NovaNative extends Library {
 
     key_char_event get_next_key_char_event();
 
+    /**
+     * Copies every waiting input event into the buffer in one call. The buffer starts with six ints: the number of
+     * mouse scroll, key char, mouse button, key press, and mouse position events, and one int of padding. Then come
+     * the events themselves, in that order, laid out like the native structs
+     *
+     * @param buffer A direct buffer in native byte order
+     * @param buffer_size The size of the buffer, in bytes
+     * @return How many bytes were written
+     */
+    int get_input_events(ByteBuffer buffer, int buffer_size);
+
     window_size get_window_size();
 
     void set_fullscreen(int fullscreen);
@@ -308,5 +627,43 @@ public interface NovaNative extends Library {
 
     void set_player_camera_transform(double x, double y, double z, float yaw, float pitch);
 
+    void set_celestial_angle(float celestial_angle);
+
+    /**
+     * Sets the time and weather that Nova draws the sky, clouds, and rain or snow from. Call it once a frame
+     *
+     * @param world_time The world's total time in ticks, plus the partial tick
+     * @param rain_strength How hard it's raining, from World#getRainStrength
+     * @param is_snowing 1 if the rain falls as snow where the player is
+     */
+    void set_sky_state(double world_time, float rain_strength, int is_snowing);
+
+    /**
+     * Fills in the counters from the newest finished frame. Waits for the render thread, so don't call it every frame
+     */
+    void get_frame_statistics(mc_frame_statistics statistics);
+
+    /**
+     * Fills in how much GPU memory Nova is using, so the render distance can be lowered before the driver starts
+     * paging. Waits for the render thread
+     */
+    void get_gpu_memory_usage(mc_gpu_memory_usage usage);
+
+    /**
+     * Gets the chunks that were evicted to stay under vramBudgetMegabytes and need to be sent again with
+     * add_chunk_render_object before they're drawn. The array has to come from Structure.toArray so it's contiguous
+     *
+     * @return How many chunks were written to the array
+     */
+    int get_chunks_to_rebuild(mc_chunk_position[] chunks, int max_chunks);
+
+    /**
+     * Scores chunks by how soon Nova will need them, from where the camera is and where it's heading. Lower is sooner.
+     * The array of chunks has to come from Structure.toArray so it's contiguous
+     *
+     * @param priorities Gets one score for each chunk
+     */
+    void get_chunk_build_priorities(mc_chunk_position[] chunks, float[] priorities, int num_chunks);
+
     String get_shaders_and_filters();
 }
@@ -1,18 +1,20 @@
 package com.continuum.nova;
 
 import com.continuum.nova.NovaNative.window_size;
+import com.continuum.nova.chunks.CapturingVertexBuffer;
 import com.continuum.nova.chunks.ChunkBuilder;
 import com.continuum.nova.chunks.ChunkUpdateListener;
 import com.continuum.nova.chunks.IGeometryFilter;
+import com.continuum.nova.entities.EntityModels;
 import com.continuum.nova.gui.NovaDraw;
+import com.continuum.nova.particles.ParticleEmitters;
 import com.continuum.nova.utils.Profiler;
 import com.continuum.nova.utils.Utils;
-import glm.Glm;
-import glm.vec._2.Vec2;
-import glm.vec._3.i.Vec3i;
+import net.minecraft.block.state.IBlockState;
 import net.minecraft.client.Minecraft;
 import net.minecraft.client.entity.EntityPlayerSP;
 import net.minecraft.client.gui.ScaledResolution;
+import net.minecraft.client.multiplayer.ServerData;
 import net.minecraft.client.renderer.BlockModelShapes;
 import net.minecraft.client.renderer.EntityRenderer;
 import net.minecraft.client.renderer.color.BlockColors;
@@ -22,8 +24,8 @@ import net.minecraft.client.renderer.texture.TextureMap;
 import net.minecraft.client.resources.IResource;
 import net.minecraft.client.resources.IResourceManager;
 import net.minecraft.client.resources.IResourceManagerReloadListener;
-import net.minecraft.entity.Entity;
 import net.minecraft.util.ResourceLocation;
+import net.minecraft.util.math.BlockPos;
 import net.minecraft.world.World;
 import org.apache.logging.log4j.LogManager;
 import org.apache.logging.log4j.Logger;
@@ -81,8 +83,28 @@ public class NovaRenderer implements IResourceManagerReloadListener {
     final private Executor chunkUpdateThreadPool = Executors.newFixedThreadPool(10);
 
     private ChunkBuilder chunkBuilder;
+
+    /**
+     * Asking Nova which evicted chunks it needs again waits for its render thread, so it's only done this often
+     */
+    private static final long REBUILD_POLL_INTERVAL_NANOS = 250_000_000L;
+    private static final int MAX_CHUNKS_TO_REBUILD = 64;
+
+    private final NovaNative.mc_chunk_position[] chunksToRebuild =
+            (NovaNative.mc_chunk_position[]) new NovaNative.mc_chunk_position().toArray(MAX_CHUNKS_TO_REBUILD);
+    private long lastRebuildPoll = 0;
     private HashMap<String, IGeometryFilter> filterMap;
 
+    /**
+     * Set when the block atlas or the shaderpack changes, so the native mesher gets new block types once Minecraft's
+     * block models are baked
+     */
+    private boolean mesherBlockTypesOutdated = true;
+
+    private EntityModels entityModels = new EntityModels(this);
+
+    private ParticleEmitters particleEmitters = new ParticleEmitters();
+
     public NovaRenderer() {
         // I put these in Utils to make this class smaller
         Utils.initBlockTextureLocations(BLOCK_COLOR_TEXTURES_LOCATIONS);
@@ -95,6 +117,22 @@ public class NovaRenderer implements IResourceManagerReloadListener {
       return this.filterMap;
     }
 
+    /**
+     * Sends the geometry that RenderChunk built for each filter. See ChunkBuilder#sendChunkGeometry
+     */
+    public void sendChunkGeometry(BlockPos position, int id, Map<String, CapturingVertexBuffer> buffers) {
+        if(chunkBuilder != null) {
+            chunkBuilder.sendChunkGeometry(position, id, buffers);
+        }
+    }
+
+    /**
+     * @return True if Nova's native mesher draws the block, so RenderChunk should leave it out
+     */
+    public boolean isNativelyMeshed(IBlockState state) {
+        return chunkBuilder != null && chunkBuilder.isNativelyMeshed(state);
+    }
+
     @Override
     public void onResourceManagerReload(@Nonnull IResourceManager resourceManager) {
         this.resourceManager = resourceManager;
@@ -104,11 +142,13 @@ public class NovaRenderer implements IResourceManagerReloadListener {
         }
 
         NovaNative.INSTANCE.reset_texture_manager();
+        entityModels.reset();
 
         addGuiAtlas(resourceManager);
         addFontAtlas(resourceManager);
         addFreeTextures(resourceManager);
         addLightmap(resourceManager);
+        particleEmitters.addAtlas();
     }
 
     private void addLightmap(IResourceManager resourceManager) {
@@ -168,6 +208,8 @@ public class NovaRenderer implements IResourceManagerReloadListener {
 
             NovaNative.INSTANCE.add_texture_location(location);
         }
+
+        mesherBlockTypesOutdated = true;
     }
 
     private void addAtlas(@Nonnull IResourceManager resourceManager, TextureMap atlas, List<ResourceLocation> resources,
@@ -246,21 +288,64 @@ public class NovaRenderer implements IResourceManagerReloadListener {
         updateWindowSize();
 
         // Moved here so that it's initialized after the native code is loaded
-        chunksToUpdate = new PriorityQueue<>((range1, range2) -> {
-            Vec3i range1Center = new Vec3i();
-            Vec3i range2Center = new Vec3i();
+        // Nova knows where the camera is heading, so it scores the chunks. See prioritizeChunkUpdates
+        chunksToUpdate = new PriorityQueue<>((range1, range2) -> Float.compare(range1.priority, range2.priority));
+        chunkUpdateListener  = new ChunkUpdateListener(chunksToUpdate);
+    }
+
+    /**
+     * Asks Nova how soon it needs each chunk that's waiting to be built, and puts them back in that order. The
+     * player moves between frames, so the scores are only good for the frame they're made in
+     */
+    private void prioritizeChunkUpdates() {
+        if(chunksToUpdate.isEmpty()) {
+            return;
+        }
 
-            Glm.add(range1Center, range1.min, new Vec3i(8, 128, 8));
-            Glm.add(range2Center, range2.min, new Vec3i(8, 128, 8));
+        List<ChunkUpdateListener.BlockUpdateRange> ranges = new ArrayList<>(chunksToUpdate);
+        NovaNative.mc_chunk_position[] positions = (NovaNative.mc_chunk_position[]) new NovaNative.mc_chunk_position().toArray(ranges.size());
+        for(int i = 0; i < ranges.size(); i++) {
+            // Halfway up the column, like the ranges used to be sorted by
+            positions[i].x = ranges.get(i).min.x;
+            positions[i].y = ranges.get(i).min.y + 120;
+            positions[i].z = ranges.get(i).min.z;
+        }
 
-            Entity player = Minecraft.getMinecraft().thePlayer;
-            Vec2 playerPos = new Vec2(player.posX, player.posZ);
-            float range1DistToPlayer = new Vec2().distance(new Vec2(range1Center.x, range1Center.z), playerPos);
-            float range2DistToPlayer = new Vec2().distance(new Vec2(range2Center.x, range2Center.z), playerPos);
+        float[] priorities = new float[ranges.size()];
+        NovaNative.INSTANCE.get_chunk_build_priorities(positions, priorities, ranges.size());
 
-            return Float.compare(range1DistToPlayer, range2DistToPlayer);
-        });
-        chunkUpdateListener  = new ChunkUpdateListener(chunksToUpdate);
+        chunksToUpdate.clear();
+        for(int i = 0; i < ranges.size(); i++) {
+            ranges.get(i).priority = priorities[i];
+        }
+        chunksToUpdate.addAll(ranges);
+    }
+
+    /**
+     * Has Minecraft rebuild the chunks that Nova evicted to stay under its memory budget and now needs again.
+     * Rebuilding the RenderChunk sends its geometry again, and the ChunkRenderDispatcher hook queues the section for
+     * the native mesher, so one rebuild covers every ID Nova asks for at that position
+     */
+    private void rebuildEvictedChunks(Minecraft mc) {
+        long now = System.nanoTime();
+        if(mc.theWorld == null || mc.renderGlobal == null || now - lastRebuildPoll < REBUILD_POLL_INTERVAL_NANOS) {
+            return;
+        }
+
+        int numChunks = NovaNative.INSTANCE.get_chunks_to_rebuild(chunksToRebuild, MAX_CHUNKS_TO_REBUILD);
+
+        // A full array means there are probably more waiting, so Nova is asked again next frame
+        if(numChunks < MAX_CHUNKS_TO_REBUILD) {
+            lastRebuildPoll = now;
+        }
+
+        Set<BlockPos> rebuiltSections = new HashSet<>();
+        for(int i = 0; i < numChunks; i++) {
+            NovaNative.mc_chunk_position chunk = chunksToRebuild[i];
+            if(rebuiltSections.add(new BlockPos(chunk.x, chunk.y, chunk.z))) {
+                mc.renderGlobal.markBlockRangeForRenderUpdate(chunk.x, chunk.y, chunk.z, chunk.x + 15, chunk.y + 15, chunk.z + 15);
+            }
+        }
     }
 
     private void updateWindowSize() {
@@ -312,6 +397,13 @@ public class NovaRenderer implements IResourceManagerReloadListener {
         Profiler.end("render_gui");
 
         Profiler.start("update_chunks");
+        if(mesherBlockTypesOutdated && chunkBuilder != null) {
+            chunkBuilder.sendMesherBlockTypes();
+            mesherBlockTypesOutdated = false;
+        }
+
+        rebuildEvictedChunks(mc);
+        prioritizeChunkUpdates();
         int numChunksUpdated = 0;
         while(!chunksToUpdate.isEmpty()) {
             ChunkUpdateListener.BlockUpdateRange range = chunksToUpdate.remove();
@@ -337,6 +429,27 @@ public class NovaRenderer implements IResourceManagerReloadListener {
         }
         Profiler.end("update_player");
 
+        Profiler.start("update_sky");
+        if(mc.theWorld != null && viewEntity != null) {
+            // The sun's direction, which the shadow cascades are fit to
+            NovaNative.INSTANCE.set_celestial_angle(mc.theWorld.getCelestialAngle(renderPartialTicks));
+
+            // Minecraft draws snow instead of rain where it's cold enough, like up mountains
+            BlockPos playerPos = new BlockPos(viewEntity);
+            boolean isSnowing = mc.theWorld.getBiome(playerPos).getFloatTemperature(playerPos) < 0.15F;
+            NovaNative.INSTANCE.set_sky_state(mc.theWorld.getTotalWorldTime() + renderPartialTicks,
+                    mc.theWorld.getRainStrength(renderPartialTicks), isSnowing ? 1 : 0);
+        }
+        Profiler.end("update_sky");
+
+        Profiler.start("update_entities");
+        entityModels.update(mc.theWorld, renderPartialTicks);
+        Profiler.end("update_entities");
+
+        Profiler.start("update_particles");
+        particleEmitters.update();
+        Profiler.end("update_particles");
+
         Profiler.start("execute_frame");
         NovaNative.INSTANCE.execute_frame();
         Profiler.end("execute_frame");
@@ -363,17 +476,39 @@ public class NovaRenderer implements IResourceManagerReloadListener {
     }
 
     public void setWorld(World world) {
+        // Particles from the last world shouldn't linger in this one
+        particleEmitters.clear();
+
         if(world != null) {
             world.addEventListener(chunkUpdateListener);
+            world.addEventListener(particleEmitters);
             this.world = world;
             chunksToUpdate.clear();
 
             if(chunkBuilder != null) {
                 chunkBuilder.setWorld(world);
             }
+
+            // Minecraft makes a new world when the player changes dimension, so this covers that too
+            NovaNative.INSTANCE.set_chunk_mesh_cache_world(getWorldName(), world.provider.getDimension());
+        } else {
+            NovaNative.INSTANCE.set_chunk_mesh_cache_world("", 0);
         }
     }
 
+    /**
+     * The client's world is always called MpServer, so the save's folder or the server's address is used instead
+     */
+    private static String getWorldName() {
+        Minecraft mc = Minecraft.getMinecraft();
+        if(mc.getIntegratedServer() != null) {
+            return mc.getIntegratedServer().getFolderName();
+        }
+
+        ServerData serverData = mc.getCurrentServerData();
+        return serverData == null ? "" : serverData.serverIP;
+    }
+
     /**
      * Loads the specified texture, adding it to Minecraft as a texture outside of an atlas
      *
@@ -432,6 +567,7 @@ public class NovaRenderer implements IResourceManagerReloadListener {
 
         Profiler.start("new_chunk_builder");
         chunkBuilder = new ChunkBuilder(filterMap, world, blockColors);
+        mesherBlockTypesOutdated = true;
 
         chunksToUpdate.addAll(updatedChunks);
         updatedChunks.clear();
@@ -161,6 +161,13 @@ public class CapturingVertexBuffer extends VertexBuffer {
         return this.rawIntBuffer;
     }
 
+    /**
+     * @return How many ints of vertex data have been written. The raw data's buffer is usually bigger than that
+     */
+    public int getIntCount() {
+        return getBufferSize();
+    }
+
     public boolean isEmpty(){
       return this.vertexCount<1;
     }
@@ -1,6 +1,7 @@
 package com.continuum.nova.chunks;
 
 import com.continuum.nova.NovaNative;
+import com.sun.jna.Memory;
 import net.minecraft.block.Block;
 import net.minecraft.block.state.IBlockState;
 import net.minecraft.client.Minecraft;
@@ -12,11 +13,13 @@ import net.minecraft.client.renderer.color.BlockColors;
 import net.minecraft.util.EnumBlockRenderType;
 import net.minecraft.util.EnumFacing;
 import net.minecraft.util.math.BlockPos;
+import net.minecraft.world.EnumSkyBlock;
 import net.minecraft.world.World;
 import org.apache.logging.log4j.LogManager;
 import org.apache.logging.log4j.Logger;
 import net.minecraft.client.renderer.VertexBuffer;
 import net.minecraft.client.renderer.vertex.DefaultVertexFormats;
+import java.nio.IntBuffer;
 import java.util.*;
 import java.util.concurrent.atomic.AtomicInteger;
 import java.util.concurrent.atomic.AtomicLong;
@@ -31,6 +34,24 @@ public class ChunkBuilder {
     private static final Logger LOG = LogManager.getLogger(ChunkBuilder.class);
     private static final int VERTEX_COLOR_OFFSET = 3;
     private static final int LIGHTMAP_COORD_OFFSET = 6;
+
+    /**
+     * The chunk ID that sections sent to the native mesher use. RenderChunk sends the blocks that aren't full cubes
+     * under its own index, which is never negative
+     */
+    public static final int NATIVE_MESHER_SECTION_ID = -1;
+
+    private static final int SECTION_SIZE = 16;
+    private static final int PADDED_SECTION_SIZE = SECTION_SIZE + 2;
+    private static final int PADDED_SECTION_VOLUME = PADDED_SECTION_SIZE * PADDED_SECTION_SIZE * PADDED_SECTION_SIZE;
+
+    /**
+     * The faces in the order that the native mesher wants them: -x, +x, -y, +y, -z, +z
+     */
+    private static final EnumFacing[] MESHER_FACES = {
+            EnumFacing.WEST, EnumFacing.EAST, EnumFacing.DOWN, EnumFacing.UP, EnumFacing.NORTH, EnumFacing.SOUTH
+    };
+
     private World world;
 
     private final Map<String, IGeometryFilter> filters;
@@ -39,14 +60,242 @@ public class ChunkBuilder {
 
     private BlockRendererDispatcher blockRendererDispatcher;
 
+    /**
+     * The IDs of the block states that the native mesher draws, so that RenderChunk can leave them out. Replaced
+     * instead of changed, since RenderChunk reads it from Minecraft's chunk threads
+     */
+    private volatile BitSet nativelyMeshedStates = new BitSet();
+
+    /**
+     * The ID of each filter's shader, from get_shader_id. Looked up once, so building chunks never sends a name
+     */
+    private final Map<String, Integer> shaderIds = new HashMap<>();
+
     public ChunkBuilder(Map<String, IGeometryFilter> filters, World world, BlockColors blockColors) {
         this.filters = filters;
         this.world = world;
         this.blockColors = blockColors;
+
+        for(String shaderName : filters.keySet()) {
+            shaderIds.put(shaderName, NovaNative.INSTANCE.get_shader_id(shaderName));
+        }
+    }
+
+    /**
+     * Sends the geometry RenderChunk built for each filter to Nova, all in one call. Filters whose buffer is empty have
+     * the chunk removed, so blocks that were broken don't stay behind
+     *
+     * @param position Where the chunk starts. The buffers' vertices are relative to it
+     * @param id The chunk's ID, which together with its position says which chunk it is
+     * @param buffers Each filter's vertices, in Minecraft's block vertex layout
+     */
+    public void sendChunkGeometry(BlockPos position, int id, Map<String, CapturingVertexBuffer> buffers) {
+        if(buffers.isEmpty()) {
+            return;
+        }
+
+        int payloadSize = 0;
+        for(CapturingVertexBuffer buffer : buffers.values()) {
+            payloadSize += buffer.getIntCount();
+        }
+
+        int[] payload = new int[Math.max(payloadSize, 1)];
+        // The entries have to be contiguous, which only Structure.toArray makes
+        NovaNative.mc_chunk_batch_entry[] entries =
+                (NovaNative.mc_chunk_batch_entry[]) new NovaNative.mc_chunk_batch_entry().toArray(buffers.size());
+
+        int offset = 0;
+        int i = 0;
+        for(Map.Entry<String, CapturingVertexBuffer> buffer : buffers.entrySet()) {
+            int intCount = buffer.getValue().getIntCount();
+            IntBuffer vertexData = buffer.getValue().getRawData().duplicate();
+            vertexData.position(0);
+            vertexData.get(payload, offset, intCount);
+
+            NovaNative.mc_chunk_batch_entry entry = entries[i];
+            entry.shader_id = shaderIds.get(buffer.getKey());
+            entry.format = NovaNative.NovaVertexFormat.POS_UV_LIGHTMAPUV_NORMAL_TANGENT.ordinal();
+            entry.x = position.getX();
+            entry.y = position.getY();
+            entry.z = position.getZ();
+            entry.id = id;
+            entry.vertex_offset = offset;
+            entry.vertex_buffer_size = intCount;
+            // Block geometry is all quads, so Nova fills in the indices itself
+            entry.index_offset = offset;
+            entry.index_buffer_size = 0;
+
+            offset += intCount;
+            i++;
+        }
+
+        NovaNative.INSTANCE.add_chunk_geometry_batch(entries, entries.length, payload, payloadSize);
     }
 
+    /**
+     * Sends the full cubes in every section that the range touches to the native mesher. RenderChunk sends the rest of
+     * the blocks
+     */
     public void createMeshesForChunk(ChunkUpdateListener.BlockUpdateRange range) {
+        if(world == null) {
+            return;
+        }
+
+        int minSectionX = Math.floorDiv(range.min.x, SECTION_SIZE);
+        int minSectionY = Math.max(Math.floorDiv(range.min.y, SECTION_SIZE), 0);
+        int minSectionZ = Math.floorDiv(range.min.z, SECTION_SIZE);
+        int maxSectionX = Math.floorDiv(range.max.x - 1, SECTION_SIZE);
+        int maxSectionY = Math.min(Math.floorDiv(range.max.y - 1, SECTION_SIZE), 15);
+        int maxSectionZ = Math.floorDiv(range.max.z - 1, SECTION_SIZE);
+
+        for(int sectionY = minSectionY; sectionY <= maxSectionY; sectionY++) {
+            for(int sectionZ = minSectionZ; sectionZ <= maxSectionZ; sectionZ++) {
+                for(int sectionX = minSectionX; sectionX <= maxSectionX; sectionX++) {
+                    sendSectionBlocks(new BlockPos(sectionX * SECTION_SIZE, sectionY * SECTION_SIZE, sectionZ * SECTION_SIZE));
+                }
+            }
+        }
+    }
+
+    private void sendSectionBlocks(BlockPos sectionPos) {
+        short[] blockIds = new short[PADDED_SECTION_VOLUME];
+        byte[] light = new byte[PADDED_SECTION_VOLUME];
+
+        // The arrays have a one block border from the neighboring sections, so the mesher can cull faces against them
+        BlockPos.MutableBlockPos pos = new BlockPos.MutableBlockPos();
+        int i = 0;
+        for(int y = -1; y <= SECTION_SIZE; y++) {
+            for(int z = -1; z <= SECTION_SIZE; z++) {
+                for(int x = -1; x <= SECTION_SIZE; x++) {
+                    pos.setPos(sectionPos.getX() + x, sectionPos.getY() + y, sectionPos.getZ() + z);
+                    blockIds[i] = (short) Block.getStateId(world.getBlockState(pos));
+                    int blockLight = world.getLightFor(EnumSkyBlock.BLOCK, pos);
+                    int skyLight = world.getLightFor(EnumSkyBlock.SKY, pos);
+                    light[i] = (byte) ((skyLight << 4) | blockLight);
+                    i++;
+                }
+            }
+        }
+
+        Memory blockIdsMemory = new Memory(blockIds.length * 2);
+        blockIdsMemory.write(0, blockIds, 0, blockIds.length);
+        Memory lightMemory = new Memory(light.length);
+        lightMemory.write(0, light, 0, light.length);
+
+        NovaNative.mc_chunk_section_blocks section = new NovaNative.mc_chunk_section_blocks();
+        section.x = sectionPos.getX();
+        section.y = sectionPos.getY();
+        section.z = sectionPos.getZ();
+        section.id = NATIVE_MESHER_SECTION_ID;
+        section.block_ids = blockIdsMemory;
+        section.light = lightMemory;
+        NovaNative.INSTANCE.add_chunk_section_blocks(section);
+    }
+
+    /**
+     * Tells the native mesher how to draw every block state, and Nova which block states give off light. Has to wait
+     * until Minecraft's block models are baked, and has to be sent again whenever the block atlas or the shaderpack
+     * changes
+     */
+    public void sendMesherBlockTypes() {
+        if(blockRendererDispatcher == null) {
+            blockRendererDispatcher = Minecraft.getMinecraft().getBlockRenderDispatcher();
+        }
+
+        BitSet sentIds = new BitSet();
+        BitSet meshedIds = new BitSet();
+
+        for(Block block : Block.REGISTRY) {
+            for(int meta = 0; meta < 16; meta++) {
+                IBlockState state = block.getStateFromMeta(meta);
+                int blockId = Block.getStateId(state);
+                if(sentIds.get(blockId)) {
+                    continue;
+                }
+                sentIds.set(blockId);
+
+                NovaNative.mc_mesher_block_type blockType = new NovaNative.mc_mesher_block_type();
+                blockType.block_id = blockId;
+                blockType.is_opaque = state.isOpaqueCube() ? 1 : 0;
+
+                String shaderName = getShaderForBlock(state);
+                if(shaderName != null && fillMesherFaces(state, blockType)) {
+                    blockType.is_visible = 1;
+                    blockType.shader_id = shaderIds.get(shaderName);
+                    meshedIds.set(blockId);
+                }
+
+                NovaNative.INSTANCE.set_mesher_block_type(blockType);
+
+                // Torches and the like aren't full cubes, so this doesn't depend on whether the mesher draws them
+                int lightValue = state.getLightValue();
+                if(lightValue > 0) {
+                    NovaNative.INSTANCE.set_block_light_value(blockId, lightValue);
+                }
+            }
+        }
+
+        nativelyMeshedStates = meshedIds;
+        LOG.info("Sent {} block states to the native mesher, {} of which it draws", sentIds.cardinality(), meshedIds.cardinality());
+    }
+
+    /**
+     * @return True if the native mesher draws this block, so Minecraft shouldn't
+     */
+    public boolean isNativelyMeshed(IBlockState state) {
+        return nativelyMeshedStates.get(Block.getStateId(state));
+    }
+
+    private String getShaderForBlock(IBlockState state) {
+        for(Map.Entry<String, IGeometryFilter> entry : filters.entrySet()) {
+            if(entry.getValue().matches(state)) {
+                return entry.getKey();
+            }
+        }
+
+        return null;
+    }
+
+    /**
+     * Fills in the block's texture and tint for each face, if it's a plain cube that the native mesher can draw
+     *
+     * @return False if the block has to be drawn by Minecraft
+     */
+    private boolean fillMesherFaces(IBlockState state, NovaNative.mc_mesher_block_type blockType) {
+        if(state.getRenderType() != EnumBlockRenderType.MODEL || !state.isFullCube()) {
+            return false;
+        }
+
+        IBakedModel model = blockRendererDispatcher.getModelForState(state);
+        // Quads that aren't on a face, like the cross on a sapling, or a second layer like grass's sides, can't be
+        // merged
+        if(!model.getQuads(state, null, 0).isEmpty()) {
+            return false;
+        }
+
+        for(int face = 0; face < MESHER_FACES.length; face++) {
+            List<BakedQuad> quads = model.getQuads(state, MESHER_FACES[face], 0);
+            if(quads.size() != 1) {
+                return false;
+            }
+
+            BakedQuad quad = quads.get(0);
+            blockType.face_uvs[face * 4 + 0] = quad.getSprite().getMinU();
+            blockType.face_uvs[face * 4 + 1] = quad.getSprite().getMaxU();
+            blockType.face_uvs[face * 4 + 2] = quad.getSprite().getMinV();
+            blockType.face_uvs[face * 4 + 3] = quad.getSprite().getMaxV();
+
+            int tint = 0xFFFFFFFF;
+            if(quad.hasTintIndex()) {
+                // Without a world there's no biome, so this is each block's default color
+                int color = blockColors.colorMultiplier(state, null, null, quad.getTintIndex());
+                // Minecraft's vertex colors are stored as ABGR
+                tint = 0xFF000000 | ((color & 0xFF) << 16) | (color & 0xFF00) | ((color >> 16) & 0xFF);
+            }
+            blockType.face_tints[face] = tint;
+        }
 
+        return true;
     }
 
     /**
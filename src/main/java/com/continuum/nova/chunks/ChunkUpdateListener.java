@@ -22,6 +22,11 @@ public class ChunkUpdateListener implements IWorldEventListener {
         public Vec3i min;
         public Vec3i max;
 
+        /**
+         * How soon Nova needs this range built. Lower is sooner
+         */
+        public float priority;
+
         BlockUpdateRange(Vec3i min, Vec3i max) {
             this.min = min;
             this.max = max;
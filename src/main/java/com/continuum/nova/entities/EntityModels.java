@@ -0,0 +1,448 @@
+package com.continuum.nova.entities;
+
+import com.continuum.nova.NovaNative;
+import com.continuum.nova.NovaRenderer;
+import com.sun.jna.Memory;
+import com.sun.jna.Native;
+import net.minecraft.client.Minecraft;
+import net.minecraft.client.model.ModelBase;
+import net.minecraft.client.model.ModelBox;
+import net.minecraft.client.model.ModelRenderer;
+import net.minecraft.client.model.PositionTextureVertex;
+import net.minecraft.client.model.TexturedQuad;
+import net.minecraft.client.renderer.entity.Render;
+import net.minecraft.client.renderer.entity.RenderLivingBase;
+import net.minecraft.client.resources.IResource;
+import net.minecraft.entity.Entity;
+import net.minecraft.entity.EntityLivingBase;
+import net.minecraft.util.ResourceLocation;
+import net.minecraft.util.math.Vec3d;
+import net.minecraft.world.World;
+import org.apache.logging.log4j.LogManager;
+import org.apache.logging.log4j.Logger;
+
+import javax.imageio.ImageIO;
+import java.awt.image.BufferedImage;
+import java.io.BufferedInputStream;
+import java.io.IOException;
+import java.lang.reflect.Field;
+import java.lang.reflect.Method;
+import java.util.*;
+
+/**
+ * Uploads the parts of Minecraft's living entity models to Nova once, and sends Nova where each part of each entity
+ * is every frame
+ *
+ * <p>Every ModelRenderer is one Nova entity model for each texture it's drawn with, in the model's own space. Each
+ * frame the models are posed like RenderLivingBase would pose them, and every visible part becomes one instance with
+ * the part's full transform. Nova draws all the instances of a part with one instanced draw</p>
+ *
+ * @author ddubois
+ * @since 15-Oct-26
+ */
+public class EntityModels {
+    private static final Logger LOG = LogManager.getLogger(EntityModels.class);
+
+    /**
+     * The shader entity models are drawn with
+     */
+    private static final String ENTITIES_SHADER = "gbuffers_entities";
+
+    /**
+     * Minecraft's models are sixteen units to a block
+     */
+    private static final float MODEL_SCALE = 0.0625F;
+
+    private static final int INTS_PER_VERTEX = 13;
+
+    private static final float[] NO_TINT = {1, 1, 1, 1};
+    private static final float[] HURT_TINT = {1, 0.6F, 0.6F, 1};
+
+    /**
+     * ModelBox keeps its quads to itself, and Render only lets subclasses ask which texture an entity has
+     */
+    private static final Field QUAD_LIST = findField(ModelBox.class, "quadList");
+    private static final Method GET_ENTITY_TEXTURE = findMethod(Render.class, "getEntityTexture", Entity.class);
+
+    private final NovaRenderer nova;
+
+    /**
+     * The Nova model ID of each model part, for each texture it's been drawn with
+     */
+    private final Map<ModelRenderer, Map<ResourceLocation, Integer>> modelIds = new IdentityHashMap<>();
+
+    /**
+     * The entity textures that have been sent to Nova since its textures were last reset
+     */
+    private final Set<ResourceLocation> loadedTextures = new HashSet<>();
+
+    /**
+     * This frame's instances, kept between frames so they don't have to be made again
+     */
+    private final List<NovaNative.mc_entity_instance> instances = new ArrayList<>();
+    private int numInstances = 0;
+
+    /**
+     * The part transforms of the model that's being posed, one for each level of parts
+     */
+    private final Deque<float[]> transformStack = new ArrayDeque<>();
+
+    public EntityModels(NovaRenderer nova) {
+        this.nova = nova;
+    }
+
+    /**
+     * Forgets every model and texture, since Nova's textures are about to be reset. They're sent again as entities
+     * use them
+     */
+    public void reset() {
+        for(Map<ResourceLocation, Integer> ids : modelIds.values()) {
+            for(int modelId : ids.values()) {
+                NovaNative.INSTANCE.remove_entity_model(modelId);
+            }
+        }
+        modelIds.clear();
+        loadedTextures.clear();
+    }
+
+    /**
+     * Poses every living entity in the world and sends Nova where their parts are this frame
+     *
+     * @param world The world to draw the entities of, or null if there isn't one
+     * @param partialTicks How far between the last tick and the next one this frame is
+     */
+    public void update(World world, float partialTicks) {
+        numInstances = 0;
+
+        if(world != null) {
+            Minecraft mc = Minecraft.getMinecraft();
+            Entity viewEntity = mc.getRenderViewEntity();
+            for(Entity entity : world.loadedEntityList) {
+                if(!(entity instanceof EntityLivingBase) || entity.isInvisible()) {
+                    continue;
+                }
+                if(entity == viewEntity && mc.gameSettings.thirdPersonView == 0) {
+                    continue;
+                }
+
+                Render<?> render = mc.getRenderManager().getEntityRenderObject(entity);
+                if(!(render instanceof RenderLivingBase)) {
+                    continue;
+                }
+
+                ModelBase model = ((RenderLivingBase<?>) render).getMainModel();
+                ResourceLocation texture = getEntityTexture(render, entity);
+                if(model != null && texture != null && loadTexture(texture)) {
+                    addInstances((EntityLivingBase) entity, model, texture, partialTicks);
+                }
+            }
+        }
+
+        if(numInstances == 0) {
+            NovaNative.INSTANCE.set_entity_instances(null, 0);
+            return;
+        }
+
+        NovaNative.mc_entity_instance[] array = (NovaNative.mc_entity_instance[]) new NovaNative.mc_entity_instance().toArray(numInstances);
+        for(int i = 0; i < numInstances; i++) {
+            NovaNative.mc_entity_instance instance = instances.get(i);
+            array[i].model_id = instance.model_id;
+            array[i].entity_id = instance.entity_id;
+            array[i].animation_frame = instance.animation_frame;
+            array[i].lightmap_coord = instance.lightmap_coord;
+            System.arraycopy(instance.transform, 0, array[i].transform, 0, 16);
+            System.arraycopy(instance.tint, 0, array[i].tint, 0, 4);
+        }
+        NovaNative.INSTANCE.set_entity_instances(array[0], numInstances);
+    }
+
+    private void addInstances(EntityLivingBase entity, ModelBase model, ResourceLocation texture, float partialTicks) {
+        // The same math RenderLivingBase.doRender does before it draws the model
+        float bodyYaw = interpolateRotation(entity.prevRenderYawOffset, entity.renderYawOffset, partialTicks);
+        float headYaw = interpolateRotation(entity.prevRotationYawHead, entity.rotationYawHead, partialTicks);
+        float headPitch = entity.prevRotationPitch + (entity.rotationPitch - entity.prevRotationPitch) * partialTicks;
+        float ageInTicks = entity.ticksExisted + partialTicks;
+        float limbSwingAmount = Math.min(entity.prevLimbSwingAmount + (entity.limbSwingAmount - entity.prevLimbSwingAmount) * partialTicks, 1.0F);
+        float limbSwing = entity.limbSwing - entity.limbSwingAmount * (1.0F - partialTicks);
+        if(entity.isChild()) {
+            limbSwing *= 3.0F;
+        }
+
+        model.swingProgress = entity.getSwingProgress(partialTicks);
+        model.isRiding = entity.isRiding();
+        model.isChild = entity.isChild();
+        model.setLivingAnimations(entity, limbSwing, limbSwingAmount, partialTicks);
+        model.setRotationAngles(limbSwing, limbSwingAmount, ageInTicks, headYaw - bodyYaw, headPitch, MODEL_SCALE, entity);
+
+        float[] transform = Matrix.identity();
+        Matrix.translate(transform,
+                (float) (entity.lastTickPosX + (entity.posX - entity.lastTickPosX) * partialTicks),
+                (float) (entity.lastTickPosY + (entity.posY - entity.lastTickPosY) * partialTicks),
+                (float) (entity.lastTickPosZ + (entity.posZ - entity.lastTickPosZ) * partialTicks));
+        Matrix.rotateY(transform, (float) Math.toRadians(180.0F - bodyYaw));
+        Matrix.scale(transform, -1, -1, 1);
+        Matrix.translate(transform, 0, -1.501F, 0);
+
+        int lightmapCoord = entity.getBrightnessForRender(partialTicks);
+        float[] tint = entity.hurtTime > 0 || entity.deathTime > 0 ? HURT_TINT : NO_TINT;
+
+        // Child parts are drawn by their parents, with their parents' transforms
+        Set<ModelRenderer> children = Collections.newSetFromMap(new IdentityHashMap<>());
+        for(ModelRenderer part : model.boxList) {
+            if(part.childModels != null) {
+                children.addAll(part.childModels);
+            }
+        }
+
+        transformStack.clear();
+        transformStack.push(transform);
+        for(ModelRenderer part : model.boxList) {
+            if(!children.contains(part)) {
+                addPart(part, entity.getEntityId(), lightmapCoord, tint, texture);
+            }
+        }
+    }
+
+    /**
+     * Adds an instance for the part and each of its children, under the transform on top of the stack
+     */
+    private void addPart(ModelRenderer part, int entityId, int lightmapCoord, float[] tint, ResourceLocation texture) {
+        if(part.isHidden || !part.showModel) {
+            return;
+        }
+
+        // The same transforms ModelRenderer.render makes
+        float[] transform = Arrays.copyOf(transformStack.peek(), 16);
+        Matrix.translate(transform, part.offsetX, part.offsetY, part.offsetZ);
+        Matrix.translate(transform, part.rotationPointX * MODEL_SCALE, part.rotationPointY * MODEL_SCALE, part.rotationPointZ * MODEL_SCALE);
+        if(part.rotateAngleZ != 0) {
+            Matrix.rotateZ(transform, part.rotateAngleZ);
+        }
+        if(part.rotateAngleY != 0) {
+            Matrix.rotateY(transform, part.rotateAngleY);
+        }
+        if(part.rotateAngleX != 0) {
+            Matrix.rotateX(transform, part.rotateAngleX);
+        }
+
+        int modelId = getModelId(part, texture);
+        if(modelId > 0) {
+            if(numInstances == instances.size()) {
+                instances.add(new NovaNative.mc_entity_instance());
+            }
+            NovaNative.mc_entity_instance instance = instances.get(numInstances);
+            instance.model_id = modelId;
+            instance.entity_id = entityId;
+            instance.animation_frame = 0;
+            instance.lightmap_coord = lightmapCoord;
+            System.arraycopy(transform, 0, instance.transform, 0, 16);
+            System.arraycopy(tint, 0, instance.tint, 0, 4);
+            numInstances++;
+        }
+
+        if(part.childModels != null) {
+            transformStack.push(transform);
+            for(ModelRenderer child : part.childModels) {
+                addPart(child, entityId, lightmapCoord, tint, texture);
+            }
+            transformStack.pop();
+        }
+    }
+
+    /**
+     * Finds the Nova model for the part with the given texture, uploading it if it hasn't been yet
+     *
+     * @return The model's ID, or 0 if the part has no geometry
+     */
+    private int getModelId(ModelRenderer part, ResourceLocation texture) {
+        Map<ResourceLocation, Integer> ids = modelIds.computeIfAbsent(part, p -> new HashMap<>());
+        Integer id = ids.get(texture);
+        if(id == null) {
+            id = uploadModel(part, texture);
+            ids.put(texture, id);
+        }
+        return id;
+    }
+
+    private int uploadModel(ModelRenderer part, ResourceLocation texture) {
+        List<TexturedQuad> quads = new ArrayList<>();
+        for(ModelBox box : part.cubeList) {
+            try {
+                Collections.addAll(quads, (TexturedQuad[]) QUAD_LIST.get(box));
+            } catch(IllegalAccessException e) {
+                LOG.error("Could not read the quads of a model box", e);
+            }
+        }
+
+        if(quads.isEmpty()) {
+            return 0;
+        }
+
+        int intSize = Native.getNativeSize(Integer.TYPE);
+        Memory vertexData = new Memory(quads.size() * 4 * INTS_PER_VERTEX * intSize);
+        Memory indices = new Memory(quads.size() * 6 * intSize);
+        int vertexInt = 0;
+        int index = 0;
+        for(int quad = 0; quad < quads.size(); quad++) {
+            PositionTextureVertex[] vertices = quads.get(quad).vertexPositions;
+
+            // Like TexturedQuad.draw, the normal comes from the quad's first three corners
+            Vec3d edge1 = vertices[1].vector3D.subtractReverse(vertices[0].vector3D);
+            Vec3d edge2 = vertices[1].vector3D.subtractReverse(vertices[2].vector3D);
+            Vec3d normal = edge2.crossProduct(edge1).normalize();
+
+            for(PositionTextureVertex vertex : vertices) {
+                int[] ints = {
+                        Float.floatToIntBits((float) vertex.vector3D.xCoord * MODEL_SCALE),
+                        Float.floatToIntBits((float) vertex.vector3D.yCoord * MODEL_SCALE),
+                        Float.floatToIntBits((float) vertex.vector3D.zCoord * MODEL_SCALE),
+                        0xFFFFFFFF,     // White, the tint and texture do the rest
+                        Float.floatToIntBits(vertex.texturePositionX),
+                        Float.floatToIntBits(vertex.texturePositionY),
+                        0,              // The lightmap coordinate is per instance
+                        Float.floatToIntBits((float) normal.xCoord),
+                        Float.floatToIntBits((float) normal.yCoord),
+                        Float.floatToIntBits((float) normal.zCoord),
+                        0, 0, 0         // No tangent
+                };
+                vertexData.write(vertexInt * intSize, ints, 0, ints.length);
+                vertexInt += ints.length;
+            }
+
+            int first = quad * 4;
+            for(int offset : new int[] {0, 1, 2, 0, 2, 3}) {
+                indices.setInt(index * intSize, first + offset);
+                index++;
+            }
+        }
+
+        NovaNative.mc_entity_model model = new NovaNative.mc_entity_model();
+        model.format = NovaNative.NovaVertexFormat.POS_UV_LIGHTMAPUV_NORMAL_TANGENT.ordinal();
+        model.vertex_data = vertexData;
+        model.indices = indices;
+        model.vertex_buffer_size = vertexInt;
+        model.index_buffer_size = index;
+        model.texture_name = texture.toString();
+        return NovaNative.INSTANCE.add_entity_model(ENTITIES_SHADER, model);
+    }
+
+    /**
+     * Sends the texture to Nova if it isn't there already
+     *
+     * @return True if Nova has the texture
+     */
+    private boolean loadTexture(ResourceLocation texture) {
+        if(loadedTextures.contains(texture)) {
+            return true;
+        }
+
+        try {
+            IResource resource = Minecraft.getMinecraft().getResourceManager().getResource(texture);
+            BufferedImage image = ImageIO.read(new BufferedInputStream(resource.getInputStream()));
+            if(image == null) {
+                LOG.error("Entity texture " + texture + " has no data!");
+                return false;
+            }
+            nova.loadTexture(texture, image);
+            loadedTextures.add(texture);
+            return true;
+
+        } catch(IOException e) {
+            LOG.error("Could not load entity texture " + texture, e);
+            // Don't try again every frame
+            loadedTextures.add(texture);
+            return false;
+        }
+    }
+
+    private static ResourceLocation getEntityTexture(Render<?> render, Entity entity) {
+        try {
+            return (ResourceLocation) GET_ENTITY_TEXTURE.invoke(render, entity);
+        } catch(ReflectiveOperationException e) {
+            LOG.error("Could not get the texture of " + entity, e);
+            return null;
+        }
+    }
+
+    private static float interpolateRotation(float previous, float current, float partialTicks) {
+        float difference = current - previous;
+        while(difference < -180.0F) {
+            difference += 360.0F;
+        }
+        while(difference >= 180.0F) {
+            difference -= 360.0F;
+        }
+        return previous + partialTicks * difference;
+    }
+
+    private static Field findField(Class<?> owner, String name) {
+        try {
+            Field field = owner.getDeclaredField(name);
+            field.setAccessible(true);
+            return field;
+        } catch(NoSuchFieldException e) {
+            throw new IllegalStateException("Could not find " + owner.getSimpleName() + "." + name, e);
+        }
+    }
+
+    private static Method findMethod(Class<?> owner, String name, Class<?>... parameters) {
+        try {
+            Method method = owner.getDeclaredMethod(name, parameters);
+            method.setAccessible(true);
+            return method;
+        } catch(NoSuchMethodException e) {
+            throw new IllegalStateException("Could not find " + owner.getSimpleName() + "." + name, e);
+        }
+    }
+
+    /**
+     * Column major 4x4 matrices in float arrays. Every operation multiplies on the right, like OpenGL's matrix stack
+     */
+    private static class Matrix {
+        static float[] identity() {
+            float[] matrix = new float[16];
+            matrix[0] = matrix[5] = matrix[10] = matrix[15] = 1;
+            return matrix;
+        }
+
+        static void translate(float[] m, float x, float y, float z) {
+            for(int row = 0; row < 4; row++) {
+                m[12 + row] += m[row] * x + m[4 + row] * y + m[8 + row] * z;
+            }
+        }
+
+        static void scale(float[] m, float x, float y, float z) {
+            for(int row = 0; row < 4; row++) {
+                m[row] *= x;
+                m[4 + row] *= y;
+                m[8 + row] *= z;
+            }
+        }
+
+        static void rotateX(float[] m, float radians) {
+            rotate(m, 1, 2, radians);
+        }
+
+        static void rotateY(float[] m, float radians) {
+            rotate(m, 2, 0, radians);
+        }
+
+        static void rotateZ(float[] m, float radians) {
+            rotate(m, 0, 1, radians);
+        }
+
+        /**
+         * Rotates the matrix by the given angle, turning axis a towards axis b
+         */
+        private static void rotate(float[] m, int a, int b, float radians) {
+            float cos = (float) Math.cos(radians);
+            float sin = (float) Math.sin(radians);
+            for(int row = 0; row < 4; row++) {
+                float columnA = m[a * 4 + row];
+                float columnB = m[b * 4 + row];
+                m[a * 4 + row] = columnA * cos + columnB * sin;
+                m[b * 4 + row] = columnB * cos - columnA * sin;
+            }
+        }
+    }
+}
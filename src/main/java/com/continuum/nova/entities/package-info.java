@@ -0,0 +1,6 @@
+/**
+ * Sends Minecraft's entity models to Nova, and where every part of them is each frame
+ *
+ * @author ddubois
+ */
+package com.continuum.nova.entities;
@@ -0,0 +1,306 @@
+package com.continuum.nova.particles;
+
+import com.continuum.nova.NovaNative;
+import net.minecraft.block.state.IBlockState;
+import net.minecraft.client.Minecraft;
+import net.minecraft.entity.Entity;
+import net.minecraft.entity.player.EntityPlayer;
+import net.minecraft.util.EnumParticleTypes;
+import net.minecraft.util.ResourceLocation;
+import net.minecraft.util.SoundCategory;
+import net.minecraft.util.SoundEvent;
+import net.minecraft.util.math.BlockPos;
+import net.minecraft.world.IWorldEventListener;
+import net.minecraft.world.World;
+import org.apache.logging.log4j.LogManager;
+import org.apache.logging.log4j.Logger;
+
+import java.util.ArrayList;
+import java.util.EnumMap;
+import java.util.List;
+import java.util.Map;
+
+/**
+ * Listens for the particles the world spawns, and sends them to Nova as emitters once per frame
+ *
+ * <p>Minecraft's particle manager never draws anything under Nova, so this is the only way particles get on screen.
+ * Each particle Minecraft spawns becomes an emitter of one particle, with the texture, motion, and lifetime that
+ * Minecraft's own particle class would give it. Particles that don't come from particles.png, like block cracks and
+ * footsteps, aren't sent</p>
+ *
+ * @author ddubois
+ * @since 15-Oct-26
+ */
+public class ParticleEmitters implements IWorldEventListener {
+    private static final Logger LOG = LogManager.getLogger(ParticleEmitters.class);
+
+    /**
+     * The shader particles are drawn with
+     */
+    private static final String PARTICLES_SHADER = "gbuffers_textured";
+
+    /**
+     * Loaded as a free texture by NovaRenderer
+     */
+    private static final ResourceLocation PARTICLE_TEXTURE = new ResourceLocation("textures/particle/particles.png");
+
+    /**
+     * particles.png is a grid of sixteen by sixteen cells
+     */
+    private static final float CELL_SIZE = 1.0F / 16.0F;
+
+    /**
+     * Minecraft's particles move in blocks per tick
+     */
+    private static final float TICKS_PER_SECOND = 20;
+
+    /**
+     * Minecraft doesn't spawn particles further than this from the camera, unless it's told to ignore the range
+     */
+    private static final double MAX_DISTANCE_SQUARED = 32 * 32;
+
+    /**
+     * What the three speeds Minecraft spawns a particle with mean, which depends on the particle
+     */
+    private enum SpeedMeaning {
+        VELOCITY,
+        COLOR,
+        NOTE_PITCH
+    }
+
+    /**
+     * How one kind of particle looks and moves, in Nova's units
+     */
+    private static class ParticleKind {
+        final int firstCell;
+        final int numFrames;
+        final float size;
+        final float gravity;
+        final float drag;
+        final float lifetime;
+        final float[] color;
+        final SpeedMeaning speedMeaning;
+
+        ParticleKind(int firstCell, int numFrames, float size, float gravity, float drag, float lifetime, float[] color,
+                     SpeedMeaning speedMeaning) {
+            this.firstCell = firstCell;
+            this.numFrames = numFrames;
+            this.size = size;
+            this.gravity = gravity;
+            this.drag = drag;
+            this.lifetime = lifetime;
+            this.color = color;
+            this.speedMeaning = speedMeaning;
+        }
+    }
+
+    private static final float[] WHITE = {1, 1, 1, 1};
+
+    private static final Map<EnumParticleTypes, ParticleKind> KINDS = new EnumMap<>(EnumParticleTypes.class);
+
+    static {
+        // Gravity is Minecraft's per-tick change in motion times 400, and drag is its per-tick damping to the 20th
+        KINDS.put(EnumParticleTypes.EXPLOSION_NORMAL, new ParticleKind(0, 8, 0.4F, -1.6F, 0.44F, 1.0F, new float[]{0.8F, 0.8F, 0.8F, 1}, SpeedMeaning.VELOCITY));
+        KINDS.put(EnumParticleTypes.SMOKE_NORMAL, new ParticleKind(0, 8, 0.2F, -1.6F, 0.44F, 1.0F, new float[]{0.15F, 0.15F, 0.15F, 1}, SpeedMeaning.VELOCITY));
+        KINDS.put(EnumParticleTypes.SMOKE_LARGE, new ParticleKind(0, 8, 0.5F, -1.6F, 0.44F, 1.0F, new float[]{0.15F, 0.15F, 0.15F, 1}, SpeedMeaning.VELOCITY));
+        KINDS.put(EnumParticleTypes.CLOUD, new ParticleKind(0, 8, 0.5F, -1.6F, 0.44F, 0.6F, WHITE, SpeedMeaning.VELOCITY));
+        KINDS.put(EnumParticleTypes.REDSTONE, new ParticleKind(0, 8, 0.15F, 0, 0.44F, 0.6F, WHITE, SpeedMeaning.COLOR));
+        KINDS.put(EnumParticleTypes.PORTAL, new ParticleKind(0, 8, 0.2F, 0, 0.67F, 2.0F, new float[]{0.8F, 0.4F, 0.9F, 1}, SpeedMeaning.VELOCITY));
+        KINDS.put(EnumParticleTypes.WATER_SPLASH, new ParticleKind(19, 4, 0.1F, 24, 0.67F, 0.4F, WHITE, SpeedMeaning.VELOCITY));
+        KINDS.put(EnumParticleTypes.WATER_DROP, new ParticleKind(19, 4, 0.1F, 24, 0.67F, 0.4F, WHITE, SpeedMeaning.VELOCITY));
+        KINDS.put(EnumParticleTypes.WATER_BUBBLE, new ParticleKind(32, 1, 0.1F, -0.8F, 0.04F, 0.5F, WHITE, SpeedMeaning.VELOCITY));
+        KINDS.put(EnumParticleTypes.FLAME, new ParticleKind(48, 1, 0.2F, 0, 0.44F, 0.6F, WHITE, SpeedMeaning.VELOCITY));
+        KINDS.put(EnumParticleTypes.LAVA, new ParticleKind(49, 1, 0.2F, 12, 0.67F, 1.5F, WHITE, SpeedMeaning.VELOCITY));
+        KINDS.put(EnumParticleTypes.NOTE, new ParticleKind(64, 1, 0.3F, 0, 0.44F, 0.3F, WHITE, SpeedMeaning.NOTE_PITCH));
+        KINDS.put(EnumParticleTypes.CRIT, new ParticleKind(65, 1, 0.2F, 8, 0.01F, 0.5F, new float[]{0.75F, 0.75F, 0.75F, 1}, SpeedMeaning.VELOCITY));
+        KINDS.put(EnumParticleTypes.CRIT_MAGIC, new ParticleKind(65, 1, 0.2F, 8, 0.01F, 0.5F, new float[]{0.23F, 0.6F, 0.75F, 1}, SpeedMeaning.VELOCITY));
+        KINDS.put(EnumParticleTypes.HEART, new ParticleKind(80, 1, 0.3F, 0, 0.44F, 0.8F, WHITE, SpeedMeaning.VELOCITY));
+        KINDS.put(EnumParticleTypes.VILLAGER_ANGRY, new ParticleKind(81, 1, 0.3F, 0, 0.44F, 0.8F, WHITE, SpeedMeaning.VELOCITY));
+        KINDS.put(EnumParticleTypes.VILLAGER_HAPPY, new ParticleKind(82, 1, 0.2F, 0, 0.44F, 0.8F, WHITE, SpeedMeaning.VELOCITY));
+        KINDS.put(EnumParticleTypes.DRIP_WATER, new ParticleKind(113, 1, 0.1F, 24, 0.67F, 1.0F, new float[]{0.2F, 0.3F, 1, 1}, SpeedMeaning.VELOCITY));
+        KINDS.put(EnumParticleTypes.DRIP_LAVA, new ParticleKind(113, 1, 0.1F, 24, 0.67F, 1.0F, new float[]{1, 0.3F, 0, 1}, SpeedMeaning.VELOCITY));
+        KINDS.put(EnumParticleTypes.SPELL, new ParticleKind(128, 8, 0.2F, -1.6F, 0.44F, 0.6F, WHITE, SpeedMeaning.VELOCITY));
+        KINDS.put(EnumParticleTypes.SPELL_WITCH, new ParticleKind(128, 8, 0.2F, -1.6F, 0.44F, 0.6F, new float[]{0.6F, 0.2F, 0.7F, 1}, SpeedMeaning.VELOCITY));
+        KINDS.put(EnumParticleTypes.SPELL_MOB, new ParticleKind(128, 8, 0.2F, -1.6F, 0.44F, 0.6F, WHITE, SpeedMeaning.COLOR));
+        KINDS.put(EnumParticleTypes.SPELL_MOB_AMBIENT, new ParticleKind(128, 8, 0.2F, -1.6F, 0.44F, 0.6F, WHITE, SpeedMeaning.COLOR));
+        KINDS.put(EnumParticleTypes.SPELL_INSTANT, new ParticleKind(144, 8, 0.2F, -1.6F, 0.44F, 0.6F, WHITE, SpeedMeaning.VELOCITY));
+        KINDS.put(EnumParticleTypes.END_ROD, new ParticleKind(176, 8, 0.2F, 0, 0.91F, 3.0F, WHITE, SpeedMeaning.VELOCITY));
+    }
+
+    /**
+     * Nova's index for particles.png, or -1 if it hasn't been added
+     */
+    private int atlas = -1;
+
+    /**
+     * This frame's emitters, kept between frames so they don't have to be made again
+     */
+    private final List<NovaNative.mc_particle_emitter> emitters = new ArrayList<>();
+    private int numEmitters = 0;
+
+    /**
+     * Tells Nova which texture and shader particles use. Should be called whenever the textures or shaderpack are
+     * loaded, since Nova looks both up when this is called
+     */
+    public void addAtlas() {
+        atlas = NovaNative.INSTANCE.add_particle_atlas(PARTICLES_SHADER, PARTICLE_TEXTURE.toString());
+        if(atlas < 0) {
+            LOG.error("Nova has no room for the particle atlas, so particles won't be drawn");
+        }
+    }
+
+    /**
+     * Sends the particles spawned since the last frame
+     */
+    public void update() {
+        if(numEmitters == 0) {
+            return;
+        }
+
+        NovaNative.mc_particle_emitter[] array = (NovaNative.mc_particle_emitter[]) new NovaNative.mc_particle_emitter().toArray(numEmitters);
+        for(int i = 0; i < numEmitters; i++) {
+            NovaNative.mc_particle_emitter emitter = emitters.get(i);
+            System.arraycopy(emitter.position, 0, array[i].position, 0, 3);
+            System.arraycopy(emitter.velocity, 0, array[i].velocity, 0, 3);
+            System.arraycopy(emitter.color, 0, array[i].color, 0, 4);
+            System.arraycopy(emitter.uv_min, 0, array[i].uv_min, 0, 2);
+            System.arraycopy(emitter.uv_max, 0, array[i].uv_max, 0, 2);
+            array[i].position_spread = emitter.position_spread;
+            array[i].velocity_spread = emitter.velocity_spread;
+            array[i].size = emitter.size;
+            array[i].gravity = emitter.gravity;
+            array[i].drag = emitter.drag;
+            array[i].lifetime = emitter.lifetime;
+            array[i].lifetime_spread = emitter.lifetime_spread;
+            array[i].num_frames = emitter.num_frames;
+            array[i].atlas = emitter.atlas;
+            array[i].count = emitter.count;
+        }
+        NovaNative.INSTANCE.spawn_particles(array[0], numEmitters);
+        numEmitters = 0;
+    }
+
+    /**
+     * Kills every particle, and forgets the ones that haven't been sent yet
+     */
+    public void clear() {
+        numEmitters = 0;
+        NovaNative.INSTANCE.clear_particles();
+    }
+
+    @Override
+    public void spawnParticle(int particleID, boolean ignoreRange, double xCoord, double yCoord, double zCoord, double xSpeed, double ySpeed, double zSpeed, int... parameters) {
+        ParticleKind kind = KINDS.get(EnumParticleTypes.getParticleFromId(particleID));
+        if(kind == null || atlas < 0) {
+            return;
+        }
+
+        // The same culling RenderGlobal does before it spawns a particle
+        Minecraft mc = Minecraft.getMinecraft();
+        Entity camera = mc.getRenderViewEntity();
+        if(camera == null || mc.gameSettings.particleSetting == 2) {
+            return;
+        }
+        if(!ignoreRange && camera.getDistanceSq(xCoord, yCoord, zCoord) > MAX_DISTANCE_SQUARED) {
+            return;
+        }
+
+        if(numEmitters == emitters.size()) {
+            emitters.add(new NovaNative.mc_particle_emitter());
+        }
+        NovaNative.mc_particle_emitter emitter = emitters.get(numEmitters);
+        numEmitters++;
+
+        emitter.position[0] = (float) xCoord;
+        emitter.position[1] = (float) yCoord;
+        emitter.position[2] = (float) zCoord;
+        emitter.position_spread = 0;
+
+        System.arraycopy(kind.color, 0, emitter.color, 0, 4);
+        emitter.velocity[0] = 0;
+        emitter.velocity[1] = 0;
+        emitter.velocity[2] = 0;
+        emitter.velocity_spread = 0.4F;
+
+        switch(kind.speedMeaning) {
+            case VELOCITY:
+                emitter.velocity[0] = (float) xSpeed * TICKS_PER_SECOND;
+                emitter.velocity[1] = (float) ySpeed * TICKS_PER_SECOND;
+                emitter.velocity[2] = (float) zSpeed * TICKS_PER_SECOND;
+                break;
+
+            case COLOR:
+                // Redstone dust with no red would be black, so Minecraft makes it red instead
+                emitter.color[0] = xSpeed == 0 ? 1 : (float) xSpeed;
+                emitter.color[1] = (float) ySpeed;
+                emitter.color[2] = (float) zSpeed;
+                break;
+
+            case NOTE_PITCH:
+                // Notes go around the color wheel as their pitch goes up, like ParticleNote
+                float hue = (float) xSpeed * (float) Math.PI * 2;
+                emitter.color[0] = Math.max(0, (float) Math.sin(hue) * 0.65F + 0.35F);
+                emitter.color[1] = Math.max(0, (float) Math.sin(hue + Math.PI * 2 / 3) * 0.65F + 0.35F);
+                emitter.color[2] = Math.max(0, (float) Math.sin(hue + Math.PI * 4 / 3) * 0.65F + 0.35F);
+                emitter.velocity[1] = 0.4F;
+                emitter.velocity_spread = 0;
+                break;
+        }
+
+        int column = kind.firstCell % 16;
+        int row = kind.firstCell / 16;
+        emitter.uv_min[0] = column * CELL_SIZE;
+        emitter.uv_min[1] = row * CELL_SIZE;
+        emitter.uv_max[0] = (column + kind.numFrames) * CELL_SIZE;
+        emitter.uv_max[1] = (row + 1) * CELL_SIZE;
+        emitter.num_frames = kind.numFrames;
+
+        emitter.size = kind.size;
+        emitter.gravity = kind.gravity;
+        emitter.drag = kind.drag;
+        emitter.lifetime = kind.lifetime;
+        emitter.lifetime_spread = kind.lifetime * 0.5F;
+        emitter.atlas = atlas;
+        emitter.count = 1;
+    }
+
+    @Override
+    public void notifyBlockUpdate(World worldIn, BlockPos pos, IBlockState oldState, IBlockState newState, int flags) {
+    }
+
+    @Override
+    public void notifyLightSet(BlockPos pos) {
+    }
+
+    @Override
+    public void markBlockRangeForRenderUpdate(int x1, int y1, int z1, int x2, int y2, int z2) {
+    }
+
+    @Override
+    public void playSoundToAllNearExcept(EntityPlayer player, SoundEvent soundIn, SoundCategory category, double x, double y, double z, float volume, float pitch) {
+    }
+
+    @Override
+    public void playRecord(SoundEvent soundIn, BlockPos pos) {
+    }
+
+    @Override
+    public void onEntityAdded(Entity entityIn) {
+    }
+
+    @Override
+    public void onEntityRemoved(Entity entityIn) {
+    }
+
+    @Override
+    public void broadcastSound(int soundID, BlockPos pos, int data) {
+    }
+
+    @Override
+    public void playEvent(EntityPlayer player, int type, BlockPos blockPosIn, int data) {
+    }
+
+    @Override
+    public void sendBlockBreakProgress(int breakerId, BlockPos pos, int progress) {
+    }
+}
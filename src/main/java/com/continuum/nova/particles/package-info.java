@@ -0,0 +1,6 @@
+/**
+ * Turns the particles Minecraft spawns into emitters for Nova's GPU particle system
+ *
+ * @author ddubois
+ */
+package com.continuum.nova.particles;
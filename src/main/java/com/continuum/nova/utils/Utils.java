@@ -683,6 +683,7 @@ public class Utils {
     public static void initFreeTextures(List<ResourceLocation> locations) {
         locations.add(new ResourceLocation("textures/misc/unknown_server.png"));
         locations.add(new ResourceLocation("textures/gui/options_background.png"));
+        locations.add(new ResourceLocation("textures/particle/particles.png"));
     }
 
     public static byte[] getImageData(BufferedImage image) {